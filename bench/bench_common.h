@@ -0,0 +1,126 @@
+// bench_common.h
+//
+// Shared helpers for the benchmark programs: a monotonic clock, percentiles
+// and the JSON report every benchmark writes.
+
+#ifndef BENCH_COMMON_H
+#define BENCH_COMMON_H
+
+#include <stdio.h>      // For FILE, fprintf
+#include <stdlib.h>     // For qsort, atof
+#include <stdarg.h>     // For va_list
+#include <stdint.h>     // For uint64_t
+#include <string.h>     // For strcmp
+#include <time.h>       // For clock_gettime, time
+
+// Default time spent measuring one case; --time overrides it
+#define BENCH_DEFAULT_SECONDS 0.25
+
+/**
+ * @brief A benchmark's JSON report: one document of the form
+ *        {"benchmark": ..., "timestamp": ..., "results": [{...}, ...]}.
+ */
+typedef struct {
+    FILE* out;              // Report file
+    const char* path;       // Where the report is written
+    int results;            // Results written so far
+    double seconds;         // Time budget per measured case
+} BenchReport;
+
+/**
+ * @brief Returns CLOCK_MONOTONIC in nanoseconds.
+ */
+static inline uint64_t bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int bench_compare_u64(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Sorts samples in place so bench_percentile can read them.
+ */
+static inline void bench_sort(uint64_t* samples, size_t count) {
+    qsort(samples, count, sizeof(uint64_t), bench_compare_u64);
+}
+
+/**
+ * @brief Returns the q-quantile (0..1) of sorted samples, nearest rank.
+ */
+static inline uint64_t bench_percentile(const uint64_t* sorted, size_t count, double q) {
+    if (count == 0) {
+        return 0;
+    }
+    size_t rank = (size_t)(q * (double)count);
+    return sorted[rank < count ? rank : count - 1];
+}
+
+/**
+ * @brief Opens the report named by --json (default <name>.json) and reads --time.
+ *
+ * Unrecognized arguments are left for the benchmark to parse.
+ *
+ * @return 0 on success, -1 if the report cannot be created.
+ */
+static inline int bench_report_open(BenchReport* report, const char* name, int argc, char** argv) {
+    static char default_path[256];
+    snprintf(default_path, sizeof(default_path), "%s.json", name);
+    report->path = default_path;
+    report->results = 0;
+    report->seconds = BENCH_DEFAULT_SECONDS;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            report->path = argv[++i];
+        } else if (strcmp(argv[i], "--time") == 0 && i + 1 < argc) {
+            report->seconds = atof(argv[++i]);
+        }
+    }
+
+    report->out = fopen(report->path, "w");
+    if (report->out == NULL) {
+        perror(report->path);
+        return -1;
+    }
+    fprintf(report->out, "{\n  \"benchmark\": \"%s\",\n  \"timestamp\": %lld,\n  \"results\": [",
+            name, (long long)time(NULL));
+    return 0;
+}
+
+/**
+ * @brief Appends one result object; format lists its members without the braces.
+ */
+__attribute__((format(printf, 2, 3)))
+static inline void bench_report_result(BenchReport* report, const char* format, ...) {
+    fprintf(report->out, "%s\n    {", report->results++ ? "," : "");
+    va_list args;
+    va_start(args, format);
+    vfprintf(report->out, format, args);
+    va_end(args);
+    fputc('}', report->out);
+}
+
+/**
+ * @brief Closes the report.
+ *
+ * @return 0 on success, -1 if writing failed.
+ */
+static inline int bench_report_close(BenchReport* report) {
+    fprintf(report->out, "\n  ]\n}\n");
+    int failed = ferror(report->out);
+    if (fclose(report->out) != 0 || failed) {
+        fprintf(stderr, "Failed to write %s\n", report->path);
+        return -1;
+    }
+    printf("Results written to %s\n", report->path);
+    return 0;
+}
+
+// Converts bytes processed in elapsed nanoseconds to MB/s
+#define BENCH_MB_PER_S(bytes, ns) ((double)(bytes) * 1000.0 / (double)(ns))
+
+#endif // BENCH_COMMON_H
@@ -0,0 +1,142 @@
+// bench_compression.c
+//
+// compress_data / decompress_data speed and ratio at each zlib level for
+// payloads that compress very differently: prose, JSON records, random bytes and zeros.
+
+#include "secure_comm.h"
+#include "bench_common.h"
+
+#include <openssl/rand.h>   // For the incompressible payload
+
+#define PAYLOAD_SIZE (64 * 1024)
+#define OUTPUT_SIZE (PAYLOAD_SIZE + PAYLOAD_SIZE / 1000 + 64)
+
+static const char* const words[] = {
+    "secure", "channel", "message", "session", "the", "of", "and", "server", "client",
+    "record", "a", "to", "key", "stream", "is", "latency", "with", "frame", "cipher", "data"
+};
+
+/**
+ * @brief Fills buf with pseudo-random words separated by spaces and newlines.
+ */
+static void fill_text(unsigned char* buf, size_t len) {
+    uint32_t state = 12345;
+    size_t used = 0;
+    while (used < len) {
+        state = state * 1103515245u + 12345u;
+        const char* word = words[(state >> 16) % (sizeof(words) / sizeof(words[0]))];
+        size_t word_len = strlen(word);
+        for (size_t i = 0; i < word_len && used < len; i++) {
+            buf[used++] = (unsigned char)word[i];
+        }
+        if (used < len) {
+            buf[used++] = (state & 0xF00) == 0 ? '\n' : ' ';
+        }
+    }
+}
+
+/**
+ * @brief Fills buf with JSON records like the ones the client application sends.
+ */
+static void fill_json(unsigned char* buf, size_t len) {
+    size_t used = 0;
+    for (unsigned int id = 0; used < len; id++) {
+        char record[160];
+        int n = snprintf(record, sizeof(record),
+                         "{\"id\":%u,\"user\":\"user%u\",\"type\":\"message\",\"ts\":%u,\"body\":\"status %u ok\"},\n",
+                         id, id % 97, 1700000000u + id * 7, id % 13);
+        for (int i = 0; i < n && used < len; i++) {
+            buf[used++] = (unsigned char)record[i];
+        }
+    }
+}
+
+/**
+ * @brief Times compress_data and decompress_data for one payload and level.
+ */
+static int run_case(BenchReport* report, const char* payload_name, const unsigned char* payload,
+                    unsigned char* compressed, unsigned char* restored, int level) {
+    uint64_t budget = (uint64_t)(report->seconds * 1e9);
+    CompressionStats before, after;
+    compression_get_stats(&before);
+
+    size_t compressed_len = 0;
+    uint64_t compress_ops = 0;
+    uint64_t start = bench_now_ns(), compress_ns;
+    do {
+        compressed_len = OUTPUT_SIZE;
+        if (compress_data(payload, PAYLOAD_SIZE, compressed, &compressed_len, level) != SECURE_COMM_SUCCESS) {
+            fprintf(stderr, "compress_data failed for %s at level %d\n", payload_name, level);
+            return -1;
+        }
+        compress_ops++;
+        compress_ns = bench_now_ns() - start;
+    } while (compress_ns < budget);
+
+    uint64_t decompress_ops = 0;
+    start = bench_now_ns();
+    uint64_t decompress_ns;
+    do {
+        size_t restored_len = PAYLOAD_SIZE;
+        if (decompress_data(compressed, compressed_len, restored, &restored_len) != SECURE_COMM_SUCCESS ||
+            restored_len != PAYLOAD_SIZE) {
+            fprintf(stderr, "decompress_data failed for %s at level %d\n", payload_name, level);
+            return -1;
+        }
+        decompress_ops++;
+        decompress_ns = bench_now_ns() - start;
+    } while (decompress_ns < budget);
+    if (memcmp(payload, restored, PAYLOAD_SIZE) != 0) {
+        fprintf(stderr, "Round trip mismatch for %s at level %d\n", payload_name, level);
+        return -1;
+    }
+    compression_get_stats(&after);
+
+    double ratio = (double)PAYLOAD_SIZE / (double)compressed_len;
+    double compress_mb = BENCH_MB_PER_S(PAYLOAD_SIZE * compress_ops, compress_ns);
+    double decompress_mb = BENCH_MB_PER_S(PAYLOAD_SIZE * decompress_ops, decompress_ns);
+    uint64_t calls = compress_ops + decompress_ops;
+    double allocs_per_call = (double)(after.zlib_allocs - before.zlib_allocs) / (double)calls;
+    printf("%-7s level %d  ratio %6.2f  compress %8.1f MB/s  decompress %8.1f MB/s  %.3f allocs/call\n",
+           payload_name, level, ratio, compress_mb, decompress_mb, allocs_per_call);
+    bench_report_result(report,
+                        "\"payload\": \"%s\", \"level\": %d, \"size\": %d, \"compressed_size\": %zu, "
+                        "\"ratio\": %.3f, \"compress_mb_per_s\": %.2f, \"decompress_mb_per_s\": %.2f, "
+                        "\"zlib_allocs_per_call\": %.4f",
+                        payload_name, level, PAYLOAD_SIZE, compressed_len, ratio, compress_mb, decompress_mb,
+                        allocs_per_call);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    BenchReport report;
+    if (bench_report_open(&report, "bench_compression", argc, argv) != 0) {
+        return 1;
+    }
+
+    static unsigned char text[PAYLOAD_SIZE], json[PAYLOAD_SIZE], random[PAYLOAD_SIZE], zeros[PAYLOAD_SIZE];
+    static unsigned char compressed[OUTPUT_SIZE], restored[PAYLOAD_SIZE];
+    fill_text(text, sizeof(text));
+    fill_json(json, sizeof(json));
+    if (!RAND_bytes(random, sizeof(random))) {
+        fprintf(stderr, "RAND_bytes failed\n");
+        return 1;
+    }
+
+    const struct {
+        const char* name;
+        const unsigned char* data;
+    } payloads[] = {
+        { "text", text }, { "json", json }, { "random", random }, { "zeros", zeros }
+    };
+
+    printf("---- Compression levels (%d KB payloads) ----\n", PAYLOAD_SIZE / 1024);
+    int failed = 0;
+    for (size_t p = 0; p < sizeof(payloads) / sizeof(payloads[0]) && !failed; p++) {
+        for (int level = 0; level <= 9 && !failed; level++) {
+            failed = run_case(&report, payloads[p].name, payloads[p].data, compressed, restored, level) != 0;
+        }
+    }
+
+    return bench_report_close(&report) != 0 || failed;
+}
@@ -0,0 +1,141 @@
+// bench_crypto.c
+//
+// Throughput of encrypt_data / decrypt_data (one-shot, key schedule per call)
+// and of a keyed SecureCipher handle for each suite, from 64 B to 1 MB.
+
+#include "secure_comm.h"
+#include "bench_common.h"
+
+#include <openssl/rand.h>   // For the random key and payload
+
+#define MIN_SIZE 64
+#define MAX_SIZE (1024 * 1024)
+
+static unsigned char key[32];
+static unsigned char iv[12];
+static unsigned char tag[16];
+
+/**
+ * @brief Repeats one operation until the time budget is spent.
+ *
+ * @return Nanoseconds per operation, or 0 if an operation failed.
+ */
+static double time_encrypt_data(const unsigned char* plaintext, int len, unsigned char* ciphertext,
+                                double seconds, uint64_t* ops) {
+    uint64_t budget = (uint64_t)(seconds * 1e9);
+    uint64_t start = bench_now_ns(), elapsed;
+    *ops = 0;
+    do {
+        int out_len = 0;
+        if (encrypt_data(plaintext, len, key, iv, ciphertext, &out_len, tag) != SECURE_COMM_SUCCESS) {
+            return 0;
+        }
+        (*ops)++;
+        elapsed = bench_now_ns() - start;
+    } while (elapsed < budget);
+    return (double)elapsed / (double)*ops;
+}
+
+static double time_decrypt_data(const unsigned char* ciphertext, int len, unsigned char* plaintext,
+                                double seconds, uint64_t* ops) {
+    uint64_t budget = (uint64_t)(seconds * 1e9);
+    uint64_t start = bench_now_ns(), elapsed;
+    *ops = 0;
+    do {
+        int out_len = 0;
+        if (decrypt_data(ciphertext, len, key, iv, plaintext, &out_len, tag) != SECURE_COMM_SUCCESS) {
+            return 0;
+        }
+        (*ops)++;
+        elapsed = bench_now_ns() - start;
+    } while (elapsed < budget);
+    return (double)elapsed / (double)*ops;
+}
+
+static double time_cipher(SecureCipher* cipher, int decrypt, unsigned char* in, int len, unsigned char* out,
+                          double seconds, uint64_t* ops) {
+    uint64_t budget = (uint64_t)(seconds * 1e9);
+    uint64_t start = bench_now_ns(), elapsed;
+    *ops = 0;
+    do {
+        int out_len = 0;
+        SecureCommError ret = decrypt ? cipher_decrypt(cipher, in, len, iv, out, &out_len, tag)
+                                      : cipher_encrypt(cipher, in, len, iv, out, &out_len, tag);
+        if (ret != SECURE_COMM_SUCCESS) {
+            return 0;
+        }
+        (*ops)++;
+        elapsed = bench_now_ns() - start;
+    } while (elapsed < budget);
+    return (double)elapsed / (double)*ops;
+}
+
+static void report_case(BenchReport* report, const char* op, const char* suite, int size,
+                        double ns_per_op, uint64_t ops) {
+    double mb_per_s = BENCH_MB_PER_S(size, ns_per_op);
+    printf("%-14s %-18s %8d B %12.0f ns/op %10.1f MB/s\n", op, suite, size, ns_per_op, mb_per_s);
+    bench_report_result(report,
+                        "\"op\": \"%s\", \"suite\": \"%s\", \"size\": %d, \"ops\": %llu, "
+                        "\"ns_per_op\": %.1f, \"mb_per_s\": %.2f",
+                        op, suite, size, (unsigned long long)ops, ns_per_op, mb_per_s);
+}
+
+int main(int argc, char* argv[]) {
+    BenchReport report;
+    if (bench_report_open(&report, "bench_crypto", argc, argv) != 0) {
+        return 1;
+    }
+
+    unsigned char* plaintext = (unsigned char*)malloc(MAX_SIZE);
+    unsigned char* ciphertext = (unsigned char*)malloc(MAX_SIZE);
+    unsigned char* decrypted = (unsigned char*)malloc(MAX_SIZE);
+    if (plaintext == NULL || ciphertext == NULL || decrypted == NULL ||
+        !RAND_bytes(key, sizeof(key)) || !RAND_bytes(plaintext, MAX_SIZE)) {
+        fprintf(stderr, "Failed to prepare the benchmark buffers\n");
+        return 1;
+    }
+
+    SecureCipher* ciphers[CIPHER_SUITE_COUNT] = { NULL };
+    for (int suite = 0; suite < CIPHER_SUITE_COUNT; suite++) {
+        if (cipher_create_suite((CipherSuite)suite, key, sizeof(key), &ciphers[suite]) != SECURE_COMM_SUCCESS) {
+            fprintf(stderr, "cipher_create_suite(%s) failed\n", cipher_suite_name((CipherSuite)suite));
+            return 1;
+        }
+    }
+
+    printf("---- AEAD throughput ----\n");
+    int failed = 0;
+    for (int size = MIN_SIZE; size <= MAX_SIZE && !failed; size *= 4) {
+        uint64_t ops = 0;
+        double ns = time_encrypt_data(plaintext, size, ciphertext, report.seconds, &ops);
+        failed |= ns == 0;
+        report_case(&report, "encrypt_data", cipher_suite_name(CIPHER_SUITE_AES_GCM), size, ns, ops);
+
+        ns = time_decrypt_data(ciphertext, size, decrypted, report.seconds, &ops);
+        failed |= ns == 0;
+        report_case(&report, "decrypt_data", cipher_suite_name(CIPHER_SUITE_AES_GCM), size, ns, ops);
+
+        for (int suite = 0; suite < CIPHER_SUITE_COUNT; suite++) {
+            const char* name = cipher_suite_name((CipherSuite)suite);
+            ns = time_cipher(ciphers[suite], 0, plaintext, size, ciphertext, report.seconds, &ops);
+            failed |= ns == 0;
+            report_case(&report, "cipher_encrypt", name, size, ns, ops);
+
+            ns = time_cipher(ciphers[suite], 1, ciphertext, size, decrypted, report.seconds, &ops);
+            failed |= ns == 0;
+            report_case(&report, "cipher_decrypt", name, size, ns, ops);
+        }
+        failed |= memcmp(plaintext, decrypted, (size_t)size) != 0;
+    }
+    if (failed) {
+        fprintf(stderr, "An encryption round trip failed\n");
+    }
+
+    for (int suite = 0; suite < CIPHER_SUITE_COUNT; suite++) {
+        cipher_destroy(ciphers[suite]);
+    }
+    free(plaintext);
+    free(ciphertext);
+    free(decrypted);
+    return bench_report_close(&report) != 0 || failed;
+}
@@ -0,0 +1,480 @@
+// bench_load.c
+//
+// End-to-end load generator. Opens thousands of simulated clients against a
+// running server, each negotiating a cipher suite and then sending encrypted
+// messages one at a time and waiting for the echo. Reports round-trip latency
+// percentiles and messages per second.
+//
+// Only the reactor server echoes, so start it in that mode first
+// (e.g. ./server --reactor 4 > /dev/null), then:
+//     ./bench_load --clients 2000 --messages 20 --threads 4
+
+#include "secure_comm.h"
+#include "bench_common.h"
+
+#include <pthread.h>        // For the driver threads
+#include <errno.h>          // For errno
+#include <unistd.h>         // For close
+#include <sys/epoll.h>      // For epoll
+#include <sys/resource.h>   // For setrlimit
+#include <netinet/tcp.h>    // For TCP_NODELAY
+#include <openssl/rand.h>   // For the nonce salt
+#include <openssl/crypto.h> // For OPENSSL_cleanse
+
+#define MAX_MESSAGE_SIZE 4096   // The server's per-message buffer
+#define MAX_EVENTS 256
+#define OUT_CAPACITY (SECURE_FRAME_HEADER_SIZE + SECURE_RECORD_OVERHEAD + MAX_MESSAGE_SIZE)
+
+// Key the demo server uses for every connection
+static const unsigned char predefined_session_key[32] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+    0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F,
+    0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17,
+    0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F
+};
+
+typedef enum {
+    CLIENT_CONNECTING = 0,  // connect() in progress
+    CLIENT_HELLO,           // HELLO sent, waiting for the server's answer
+    CLIENT_WAITING,         // Message sent, waiting for its echo
+    CLIENT_DONE,            // Every message echoed
+    CLIENT_FAILED           // Connection error, bad record or timeout
+} ClientState;
+
+typedef struct {
+    int fd;
+    ClientState state;
+    SecureCipher* cipher;
+    FrameDecoder* decoder;
+    int echoed;                 // Messages echoed so far
+    uint64_t connect_ns;        // When connect() was issued
+    uint64_t sent_ns;           // When the outstanding message was queued
+    unsigned char salt[SECURE_CONNECTION_SALT_SIZE]; // HELLO randoms: ours || the server's
+    unsigned char out[OUT_CAPACITY];
+    size_t out_len;             // Bytes queued in out
+    size_t out_off;             // Bytes of out already sent
+} LoadClient;
+
+typedef struct {
+    int id;
+    int clients;
+    LoadClient* client;
+    uint64_t* latencies;        // Round trips, clients * messages at most
+    size_t latency_count;
+    uint64_t* handshakes;       // connect() to HELLO answer, one per client
+    size_t handshake_count;
+    int failed;
+} LoadThread;
+
+// Parameters shared by every driver thread
+static struct sockaddr_in server_addr;
+static int messages_per_client = 10;
+static int message_size = 64;
+static CipherSuite preferred_suite;
+static uint64_t deadline_ns;
+static unsigned char message[MAX_MESSAGE_SIZE];
+
+static void client_fail(LoadThread* thread, LoadClient* client) {
+    if (client->state != CLIENT_DONE && client->state != CLIENT_FAILED) {
+        client->state = CLIENT_FAILED;
+        thread->failed++;
+    }
+    if (client->fd >= 0) {
+        close(client->fd);
+        client->fd = -1;
+    }
+}
+
+/**
+ * @brief Sends as much queued output as the socket takes and sets the epoll interest.
+ */
+static int client_flush(int epfd, LoadClient* client) {
+    while (client->out_off < client->out_len) {
+        ssize_t n = send(client->fd, client->out + client->out_off, client->out_len - client->out_off, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            return -1;
+        }
+        client->out_off += (size_t)n;
+    }
+    if (client->out_off == client->out_len) {
+        client->out_off = client->out_len = 0;
+    }
+
+    struct epoll_event ev;
+    ev.events = EPOLLIN | (client->out_len > 0 ? EPOLLOUT : 0);
+    ev.data.ptr = client;
+    return epoll_ctl(epfd, EPOLL_CTL_MOD, client->fd, &ev);
+}
+
+/**
+ * @brief Seals the benchmark message into the output buffer.
+ */
+static int client_queue_message(LoadClient* client) {
+    unsigned char* record = client->out + SECURE_FRAME_HEADER_SIZE;
+    memcpy(record + SECURE_RECORD_OVERHEAD, message, (size_t)message_size);
+    size_t record_len = 0;
+    if (cipher_seal_record(client->cipher, record, (size_t)message_size, &record_len) != SECURE_COMM_SUCCESS) {
+        return -1;
+    }
+    FrameHeader header = { (uint32_t)record_len, FRAME_TYPE_DATA, 0, COMPRESSION_CODEC_NONE,
+                           (uint8_t)cipher_get_suite(client->cipher) };
+    frame_encode_header(&header, client->out);
+    client->out_len = SECURE_FRAME_HEADER_SIZE + record_len;
+    client->out_off = 0;
+    client->state = CLIENT_WAITING;
+    client->sent_ns = bench_now_ns();
+    return 0;
+}
+
+/**
+ * @brief Keys the client's cipher with the suite from the server's HELLO.
+ */
+static int client_handle_hello(LoadThread* thread, LoadClient* client, const unsigned char* payload, size_t len) {
+    unsigned int mask = 0;
+    CipherSuite suite;
+    if (client->state != CLIENT_HELLO ||
+        cipher_hello_decode(payload, len, &mask, &suite, client->salt + SECURE_HELLO_RANDOM_SIZE) != SECURE_COMM_SUCCESS) {
+        return -1;
+    }
+
+    // Client-to-server nonces keep the salt's top bit clear, as client.c does
+    unsigned char key[sizeof(predefined_session_key)];
+    unsigned char salt[SECURE_NONCE_SALT_SIZE];
+    if (!RAND_bytes(salt, sizeof(salt))) {
+        return -1;
+    }
+    salt[0] &= 0x7F;
+    int ok = cipher_derive_key(predefined_session_key, sizeof(predefined_session_key), client->salt,
+                               sizeof(client->salt), SECURE_SESSION_KEY_LABEL, key, sizeof(key)) ==
+                 SECURE_COMM_SUCCESS &&
+             cipher_derive_key(key, sizeof(key), client->salt, sizeof(client->salt),
+                               SECURE_CONNECTION_KEY_LABEL, key, sizeof(key)) == SECURE_COMM_SUCCESS &&
+             cipher_create_suite(suite, key, sizeof(key), &client->cipher) == SECURE_COMM_SUCCESS &&
+             cipher_use_counter_nonces(client->cipher, salt) == SECURE_COMM_SUCCESS;
+    OPENSSL_cleanse(key, sizeof(key));
+    if (!ok) {
+        return -1;
+    }
+    thread->handshakes[thread->handshake_count++] = bench_now_ns() - client->connect_ns;
+    return client_queue_message(client);
+}
+
+/**
+ * @brief Checks an echoed record and sends the next message or finishes the client.
+ */
+static int client_handle_echo(LoadThread* thread, LoadClient* client, unsigned char* record, size_t len) {
+    unsigned char* payload = NULL;
+    size_t payload_len = 0;
+    if (client->state != CLIENT_WAITING ||
+        cipher_open_record(client->cipher, record, len, &payload, &payload_len) != SECURE_COMM_SUCCESS ||
+        payload_len != (size_t)message_size || memcmp(payload, message, payload_len) != 0) {
+        return -1;
+    }
+    thread->latencies[thread->latency_count++] = bench_now_ns() - client->sent_ns;
+
+    if (++client->echoed == messages_per_client) {
+        client->state = CLIENT_DONE;
+        close(client->fd);
+        client->fd = -1;
+        return 0;
+    }
+    return client_queue_message(client);
+}
+
+/**
+ * @brief Reads everything available and handles each complete frame.
+ */
+static int client_read(LoadThread* thread, LoadClient* client) {
+    unsigned char record[SECURE_RECORD_OVERHEAD + MAX_MESSAGE_SIZE];
+    for (;;) {
+        unsigned char* space = NULL;
+        size_t space_len = 0;
+        frame_decoder_write_space(client->decoder, &space, &space_len);
+        if (space_len == 0) {
+            return -1;
+        }
+        ssize_t n = recv(client->fd, space, space_len, 0);
+        if (n == 0) {
+            return -1;
+        }
+        if (n < 0) {
+            return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+        }
+        frame_decoder_commit(client->decoder, (size_t)n);
+
+        FrameHeader header;
+        SecureCommError ret;
+        while ((ret = frame_decoder_next(client->decoder, &header, record, sizeof(record))) == SECURE_COMM_SUCCESS) {
+            // Every connection starts afresh, so resumption tickets are not needed
+            if (header.type == FRAME_TYPE_TICKET) {
+                continue;
+            }
+            int handled = header.type == FRAME_TYPE_HELLO ? client_handle_hello(thread, client, record, header.length)
+                                                          : client_handle_echo(thread, client, record, header.length);
+            if (handled != 0) {
+                return -1;
+            }
+            if (client->state == CLIENT_DONE) {
+                return 0;
+            }
+        }
+        if (ret != SECURE_COMM_ERR_AGAIN) {
+            return -1;
+        }
+    }
+}
+
+/**
+ * @brief Starts a non-blocking connect and registers the client.
+ */
+static int client_start(int epfd, LoadClient* client) {
+    client->fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (client->fd < 0) {
+        return -1;
+    }
+    int one = 1;
+    setsockopt(client->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    client->connect_ns = bench_now_ns();
+    if (connect(client->fd, (struct sockaddr*)&server_addr, sizeof(server_addr)) != 0 && errno != EINPROGRESS) {
+        return -1;
+    }
+
+    // The HELLO waits in the output buffer until the connection is up
+    if (!RAND_bytes(client->salt, SECURE_HELLO_RANDOM_SIZE)) {
+        return -1;
+    }
+    FrameHeader header = { SECURE_HELLO_SIZE, FRAME_TYPE_HELLO, 0, 0, 0 };
+    frame_encode_header(&header, client->out);
+    cipher_hello_encode(cipher_suite_supported_mask(), preferred_suite, client->salt,
+                        client->out + SECURE_FRAME_HEADER_SIZE);
+    client->out_len = SECURE_FRAME_HEADER_SIZE + SECURE_HELLO_SIZE;
+    client->state = CLIENT_CONNECTING;
+
+    struct epoll_event ev;
+    ev.events = EPOLLOUT;
+    ev.data.ptr = client;
+    return epoll_ctl(epfd, EPOLL_CTL_ADD, client->fd, &ev);
+}
+
+static void* load_thread_main(void* arg) {
+    LoadThread* thread = (LoadThread*)arg;
+    int epfd = epoll_create1(0);
+    if (epfd < 0) {
+        perror("epoll_create1");
+        thread->failed = thread->clients;
+        return NULL;
+    }
+
+    int active = 0;
+    for (int i = 0; i < thread->clients; i++) {
+        LoadClient* client = &thread->client[i];
+        client->fd = -1;
+        if (frame_decoder_create(0, SECURE_RECORD_OVERHEAD + MAX_MESSAGE_SIZE, &client->decoder) != SECURE_COMM_SUCCESS ||
+            client_start(epfd, client) != 0) {
+            client_fail(thread, client);
+            continue;
+        }
+        active++;
+    }
+
+    struct epoll_event events[MAX_EVENTS];
+    while (active > 0 && bench_now_ns() < deadline_ns) {
+        int n = epoll_wait(epfd, events, MAX_EVENTS, 100);
+        for (int e = 0; e < n; e++) {
+            LoadClient* client = (LoadClient*)events[e].data.ptr;
+            if (client->fd < 0) {
+                continue;
+            }
+            int ok = !(events[e].events & EPOLLERR);
+            if (ok && client->state == CLIENT_CONNECTING) {
+                int err = 0;
+                socklen_t err_len = sizeof(err);
+                ok = getsockopt(client->fd, SOL_SOCKET, SO_ERROR, &err, &err_len) == 0 && err == 0;
+                client->state = CLIENT_HELLO;
+            }
+            if (ok && (events[e].events & (EPOLLIN | EPOLLHUP))) {
+                ok = client_read(thread, client) == 0;
+            }
+            if (ok && client->state == CLIENT_DONE) {
+                active--;
+                continue;
+            }
+            if (ok) {
+                ok = client_flush(epfd, client) == 0;
+            }
+            if (!ok) {
+                client_fail(thread, client);
+                active--;
+            }
+        }
+    }
+
+    // Whatever is still open ran out of time
+    for (int i = 0; i < thread->clients; i++) {
+        LoadClient* client = &thread->client[i];
+        if (client->state != CLIENT_DONE) {
+            client_fail(thread, client);
+        }
+        cipher_destroy(client->cipher);
+        frame_decoder_destroy(client->decoder);
+    }
+    close(epfd);
+    return NULL;
+}
+
+static void usage(const char* program) {
+    fprintf(stderr,
+            "Usage: %s [--host <ip>] [--port <port>] [--clients <n>] [--messages <per client>]\n"
+            "       [--size <bytes>] [--threads <n>] [--suite <name>] [--timeout <seconds>] [--json <path>]\n",
+            program);
+}
+
+int main(int argc, char* argv[]) {
+    const char* host = "127.0.0.1";
+    int port = 8080;
+    int clients = 1000;
+    int threads = 4;
+    double timeout = 60.0;
+    preferred_suite = cipher_suite_preferred();
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 >= argc) {
+            break;
+        }
+        if (strcmp(argv[i], "--host") == 0) {
+            host = argv[++i];
+        } else if (strcmp(argv[i], "--port") == 0) {
+            port = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--clients") == 0) {
+            clients = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--messages") == 0) {
+            messages_per_client = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--size") == 0) {
+            message_size = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--timeout") == 0) {
+            timeout = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--suite") == 0) {
+            if (cipher_suite_from_name(argv[++i], &preferred_suite) != SECURE_COMM_SUCCESS) {
+                usage(argv[0]);
+                return 1;
+            }
+        }
+    }
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons((uint16_t)port);
+    if (clients <= 0 || messages_per_client <= 0 || threads <= 0 || message_size <= 0 ||
+        message_size > MAX_MESSAGE_SIZE || inet_pton(AF_INET, host, &server_addr.sin_addr) != 1) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (threads > clients) {
+        threads = clients;
+    }
+
+    BenchReport report;
+    if (bench_report_open(&report, "bench_load", argc, argv) != 0) {
+        return 1;
+    }
+
+    // Every client needs a descriptor
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < (rlim_t)clients + 64) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    for (int i = 0; i < message_size; i++) {
+        message[i] = (unsigned char)('a' + i % 26);
+    }
+
+    LoadClient* client = (LoadClient*)calloc((size_t)clients, sizeof(LoadClient));
+    LoadThread* thread = (LoadThread*)calloc((size_t)threads, sizeof(LoadThread));
+    pthread_t* ids = (pthread_t*)calloc((size_t)threads, sizeof(pthread_t));
+    if (client == NULL || thread == NULL || ids == NULL) {
+        fprintf(stderr, "Failed to allocate %d clients\n", clients);
+        return 1;
+    }
+
+    printf("---- %d clients x %d messages of %d B against %s:%d (%d threads) ----\n",
+           clients, messages_per_client, message_size, host, port, threads);
+    uint64_t start = bench_now_ns();
+    deadline_ns = start + (uint64_t)(timeout * 1e9);
+    int assigned = 0;
+    for (int t = 0; t < threads; t++) {
+        LoadThread* th = &thread[t];
+        th->id = t;
+        th->clients = clients / threads + (t < clients % threads);
+        th->client = client + assigned;
+        th->latencies = (uint64_t*)malloc((size_t)th->clients * (size_t)messages_per_client * sizeof(uint64_t));
+        th->handshakes = (uint64_t*)malloc((size_t)th->clients * sizeof(uint64_t));
+        if (th->latencies == NULL || th->handshakes == NULL) {
+            fprintf(stderr, "Failed to allocate the sample buffers\n");
+            return 1;
+        }
+        assigned += th->clients;
+        pthread_create(&ids[t], NULL, load_thread_main, th);
+    }
+
+    size_t total_latencies = 0, total_handshakes = 0;
+    int failed = 0;
+    for (int t = 0; t < threads; t++) {
+        pthread_join(ids[t], NULL);
+        total_latencies += thread[t].latency_count;
+        total_handshakes += thread[t].handshake_count;
+        failed += thread[t].failed;
+    }
+    uint64_t elapsed_ns = bench_now_ns() - start;
+
+    // Merge the per-thread samples
+    uint64_t* latencies = (uint64_t*)malloc((total_latencies + 1) * sizeof(uint64_t));
+    uint64_t* handshakes = (uint64_t*)malloc((total_handshakes + 1) * sizeof(uint64_t));
+    if (latencies == NULL || handshakes == NULL) {
+        fprintf(stderr, "Failed to allocate the sample buffers\n");
+        return 1;
+    }
+    size_t l = 0, h = 0;
+    for (int t = 0; t < threads; t++) {
+        memcpy(latencies + l, thread[t].latencies, thread[t].latency_count * sizeof(uint64_t));
+        memcpy(handshakes + h, thread[t].handshakes, thread[t].handshake_count * sizeof(uint64_t));
+        l += thread[t].latency_count;
+        h += thread[t].handshake_count;
+        free(thread[t].latencies);
+        free(thread[t].handshakes);
+    }
+    bench_sort(latencies, total_latencies);
+    bench_sort(handshakes, total_handshakes);
+
+    double messages_per_s = (double)total_latencies * 1e9 / (double)elapsed_ns;
+    double p50_us = (double)bench_percentile(latencies, total_latencies, 0.50) / 1000.0;
+    double p99_us = (double)bench_percentile(latencies, total_latencies, 0.99) / 1000.0;
+    double p999_us = (double)bench_percentile(latencies, total_latencies, 0.999) / 1000.0;
+    double max_us = total_latencies ? (double)latencies[total_latencies - 1] / 1000.0 : 0.0;
+    double hs_p50_us = (double)bench_percentile(handshakes, total_handshakes, 0.50) / 1000.0;
+    double hs_p99_us = (double)bench_percentile(handshakes, total_handshakes, 0.99) / 1000.0;
+
+    printf("%zu messages in %.2f s: %.0f messages/s, %d of %d clients failed\n",
+           total_latencies, (double)elapsed_ns / 1e9, messages_per_s, failed, clients);
+    printf("round trip  p50 %.1f us  p99 %.1f us  p99.9 %.1f us  max %.1f us\n", p50_us, p99_us, p999_us, max_us);
+    printf("handshake   p50 %.1f us  p99 %.1f us\n", hs_p50_us, hs_p99_us);
+    bench_report_result(&report,
+                        "\"clients\": %d, \"messages_per_client\": %d, \"size\": %d, \"threads\": %d, "
+                        "\"suite\": \"%s\", \"failed_clients\": %d, \"messages\": %zu, \"elapsed_s\": %.3f, "
+                        "\"messages_per_s\": %.1f, \"latency_p50_us\": %.2f, \"latency_p99_us\": %.2f, "
+                        "\"latency_p999_us\": %.2f, \"latency_max_us\": %.2f, \"handshake_p50_us\": %.2f, "
+                        "\"handshake_p99_us\": %.2f",
+                        clients, messages_per_client, message_size, threads, cipher_suite_name(preferred_suite),
+                        failed, total_latencies, (double)elapsed_ns / 1e9, messages_per_s, p50_us, p99_us,
+                        p999_us, max_us, hs_p50_us, hs_p99_us);
+
+    free(latencies);
+    free(handshakes);
+    free(client);
+    free(thread);
+    free(ids);
+    return bench_report_close(&report) != 0 || failed > 0;
+}
@@ -0,0 +1,154 @@
+// bench_logging.c
+//
+// log_message under contention: N threads log at once through the synchronous,
+// asynchronous and binary sinks. Reports lines per second and per-call latency.
+
+#include "secure_comm.h"
+#include "bench_common.h"
+
+#include <pthread.h>    // For the logging threads
+#include <unistd.h>     // For unlink
+
+#define DEFAULT_LINES_PER_THREAD 20000
+#define DEFAULT_MAX_THREADS 8
+
+typedef enum {
+    SINK_SYNC = 0,
+    SINK_ASYNC,
+    SINK_BINARY,
+    SINK_COUNT
+} Sink;
+
+static const char* const sink_names[SINK_COUNT] = { "sync", "async", "binary" };
+
+typedef struct {
+    pthread_barrier_t* start;
+    int thread_id;
+    int lines;
+    uint64_t* latencies;        // One sample per call
+    int errors;
+} LogWorker;
+
+static void* log_worker(void* arg) {
+    LogWorker* worker = (LogWorker*)arg;
+    pthread_barrier_wait(worker->start);
+    for (int i = 0; i < worker->lines; i++) {
+        uint64_t t0 = bench_now_ns();
+        if (log_message(LOG_LEVEL_INFO, "Client 127.0.0.1:%d sent %d bytes (record %d)",
+                        40000 + worker->thread_id, 64 + (i & 255), i) != SECURE_COMM_SUCCESS) {
+            worker->errors++;
+        }
+        worker->latencies[i] = bench_now_ns() - t0;
+    }
+    return NULL;
+}
+
+static SecureCommError open_sink(Sink sink, const char* path) {
+    unlink(path);
+    if (sink == SINK_ASYNC) {
+        AsyncLogConfig config;
+        async_log_config_defaults(&config);
+        config.on_full = LOG_FULL_BLOCK;
+        return init_logging_async(LOG_LEVEL_INFO, path, &config);
+    }
+    if (sink == SINK_BINARY) {
+        return init_logging_binary(LOG_LEVEL_INFO, path);
+    }
+    return init_logging(LOG_LEVEL_INFO, path);
+}
+
+/**
+ * @brief Logs lines_per_thread lines from each of threads threads into one sink.
+ */
+static int run_case(BenchReport* report, Sink sink, int threads, int lines_per_thread, const char* path,
+                    uint64_t* samples) {
+    if (open_sink(sink, path) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "Failed to open the %s sink\n", sink_names[sink]);
+        return -1;
+    }
+
+    pthread_barrier_t start;
+    pthread_barrier_init(&start, NULL, (unsigned int)threads + 1);
+    LogWorker workers[threads];
+    pthread_t ids[threads];
+    for (int t = 0; t < threads; t++) {
+        workers[t] = (LogWorker){ &start, t, lines_per_thread, samples + (size_t)t * lines_per_thread, 0 };
+        pthread_create(&ids[t], NULL, log_worker, &workers[t]);
+    }
+
+    pthread_barrier_wait(&start);
+    uint64_t t0 = bench_now_ns();
+    int errors = 0;
+    for (int t = 0; t < threads; t++) {
+        pthread_join(ids[t], NULL);
+        errors += workers[t].errors;
+    }
+    uint64_t produced_ns = bench_now_ns() - t0;
+    LogStats stats;
+    logging_stats(&stats);
+    cleanup_logging();
+    uint64_t drained_ns = bench_now_ns() - t0;
+    pthread_barrier_destroy(&start);
+
+    size_t total = (size_t)threads * (size_t)lines_per_thread;
+    bench_sort(samples, total);
+    double lines_per_s = (double)total * 1e9 / (double)produced_ns;
+    double drained_per_s = (double)total * 1e9 / (double)drained_ns;
+    uint64_t p50 = bench_percentile(samples, total, 0.50);
+    uint64_t p99 = bench_percentile(samples, total, 0.99);
+    uint64_t p999 = bench_percentile(samples, total, 0.999);
+    printf("%-6s %2d threads  %10.0f lines/s (%10.0f written)  p50 %6llu ns  p99 %7llu ns  p99.9 %8llu ns\n",
+           sink_names[sink], threads, lines_per_s, drained_per_s, (unsigned long long)p50,
+           (unsigned long long)p99, (unsigned long long)p999);
+    bench_report_result(report,
+                        "\"sink\": \"%s\", \"threads\": %d, \"lines\": %zu, \"lines_per_s\": %.0f, "
+                        "\"written_lines_per_s\": %.0f, \"p50_ns\": %llu, \"p99_ns\": %llu, \"p999_ns\": %llu, "
+                        "\"max_ns\": %llu, \"blocked\": %llu, \"errors\": %d",
+                        sink_names[sink], threads, total, lines_per_s, drained_per_s, (unsigned long long)p50,
+                        (unsigned long long)p99, (unsigned long long)p999,
+                        (unsigned long long)samples[total - 1], (unsigned long long)stats.blocked, errors);
+    return errors ? -1 : 0;
+}
+
+int main(int argc, char* argv[]) {
+    BenchReport report;
+    if (bench_report_open(&report, "bench_logging", argc, argv) != 0) {
+        return 1;
+    }
+
+    int lines_per_thread = DEFAULT_LINES_PER_THREAD;
+    int max_threads = DEFAULT_MAX_THREADS;
+    const char* path = "bench_logging.log";
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--lines") == 0 && i + 1 < argc) {
+            lines_per_thread = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            max_threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--log") == 0 && i + 1 < argc) {
+            path = argv[++i];
+        }
+    }
+    if (lines_per_thread <= 0 || max_threads <= 0) {
+        fprintf(stderr, "Usage: %s [--lines <per thread>] [--threads <max>] [--log <path>] [--json <path>]\n",
+                argv[0]);
+        return 1;
+    }
+
+    uint64_t* samples = (uint64_t*)malloc((size_t)max_threads * (size_t)lines_per_thread * sizeof(uint64_t));
+    if (samples == NULL) {
+        fprintf(stderr, "Failed to allocate the sample buffer\n");
+        return 1;
+    }
+
+    printf("---- log_message contention (%d lines per thread) ----\n", lines_per_thread);
+    int failed = 0;
+    for (int sink = 0; sink < SINK_COUNT && !failed; sink++) {
+        for (int threads = 1; threads <= max_threads && !failed; threads *= 2) {
+            failed = run_case(&report, (Sink)sink, threads, lines_per_thread, path, samples) != 0;
+        }
+    }
+    unlink(path);
+
+    free(samples);
+    return bench_report_close(&report) != 0 || failed;
+}
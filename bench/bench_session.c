@@ -0,0 +1,143 @@
+// bench_session.c
+//
+// Setup latency of initialize_session for each key exchange, with keypairs
+// generated inline and served from a KeypairPool.
+
+#include "secure_comm.h"
+#include "bench_common.h"
+
+#include <unistd.h>     // For dup, dup2
+#include <fcntl.h>      // For open
+
+#define MIN_SAMPLES 20
+#define MAX_SAMPLES 100000
+
+/**
+ * @brief Points stdout at /dev/null while sessions are created (initialize_session
+ *        prints a line for each one).
+ *
+ * @return The saved stdout descriptor, or -1.
+ */
+static int quiet_stdout(void) {
+    fflush(stdout);
+    int saved = dup(STDOUT_FILENO);
+    int null_fd = open("/dev/null", O_WRONLY);
+    if (saved >= 0 && null_fd >= 0) {
+        dup2(null_fd, STDOUT_FILENO);
+    }
+    if (null_fd >= 0) {
+        close(null_fd);
+    }
+    return saved;
+}
+
+static void restore_stdout(int saved) {
+    fflush(stdout);
+    if (saved >= 0) {
+        dup2(saved, STDOUT_FILENO);
+        close(saved);
+    }
+}
+
+/**
+ * @brief Creates and terminates sessions until the time budget and MIN_SAMPLES are both met.
+ */
+static int run_case(BenchReport* report, SessionKeyExchange kex, const char* kex_name, int pooled,
+                    uint64_t* samples) {
+    KeypairPool* pool = NULL;
+    if (session_set_key_exchange(kex) != SECURE_COMM_SUCCESS) {
+        return -1;
+    }
+    if (pooled) {
+        KeypairPoolConfig config;
+        keypair_pool_config_defaults(&config);
+        config.kex = kex;
+        if (keypair_pool_create(&config, &pool) != SECURE_COMM_SUCCESS) {
+            return -1;
+        }
+        session_set_keypair_pool(pool);
+    }
+
+    uint64_t budget = (uint64_t)(report->seconds * 1e9);
+    size_t count = 0;
+    int saved = quiet_stdout();
+    uint64_t start = bench_now_ns();
+    do {
+        UserSession* session = NULL;
+        uint64_t t0 = bench_now_ns();
+        if (initialize_session("user", "pass", &session) != SECURE_COMM_SUCCESS) {
+            restore_stdout(saved);
+            fprintf(stderr, "initialize_session failed for %s\n", kex_name);
+            return -1;
+        }
+        samples[count++] = bench_now_ns() - t0;
+        terminate_session(session);
+    } while (count < MAX_SAMPLES && (count < MIN_SAMPLES || bench_now_ns() - start < budget));
+    restore_stdout(saved);
+
+    KeypairPoolStats stats;
+    memset(&stats, 0, sizeof(stats));
+    if (pool != NULL) {
+        keypair_pool_stats(pool, &stats);
+        session_set_keypair_pool(NULL);
+        keypair_pool_destroy(pool);
+    }
+
+    uint64_t sum = 0;
+    for (size_t i = 0; i < count; i++) {
+        sum += samples[i];
+    }
+    bench_sort(samples, count);
+    double mean_us = (double)sum / (double)count / 1000.0;
+    double p50_us = (double)bench_percentile(samples, count, 0.50) / 1000.0;
+    double p99_us = (double)bench_percentile(samples, count, 0.99) / 1000.0;
+    double max_us = (double)samples[count - 1] / 1000.0;
+    printf("%-10s %-7s %6zu sessions  mean %9.1f us  p50 %9.1f us  p99 %9.1f us  max %9.1f us",
+           kex_name, pooled ? "pool" : "inline", count, mean_us, p50_us, p99_us, max_us);
+    if (pooled) {
+        printf("  (%llu pool hits, %llu empty)", (unsigned long long)stats.hits,
+               (unsigned long long)stats.empty_hits);
+    }
+    printf("\n");
+    bench_report_result(report,
+                        "\"kex\": \"%s\", \"keypair_pool\": %s, \"sessions\": %zu, \"mean_us\": %.2f, "
+                        "\"p50_us\": %.2f, \"p99_us\": %.2f, \"max_us\": %.2f, \"pool_hits\": %llu, "
+                        "\"pool_empty_hits\": %llu",
+                        kex_name, pooled ? "true" : "false", count, mean_us, p50_us, p99_us, max_us,
+                        (unsigned long long)stats.hits, (unsigned long long)stats.empty_hits);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    BenchReport report;
+    if (bench_report_open(&report, "bench_session", argc, argv) != 0) {
+        return 1;
+    }
+
+    uint64_t* samples = (uint64_t*)malloc(MAX_SAMPLES * sizeof(uint64_t));
+    if (samples == NULL) {
+        fprintf(stderr, "Failed to allocate the sample buffer\n");
+        return 1;
+    }
+
+    const struct {
+        SessionKeyExchange kex;
+        const char* name;
+    } exchanges[] = {
+        { SESSION_KEX_FFDHE2048, "ffdhe2048" },
+        { SESSION_KEX_FFDHE3072, "ffdhe3072" },
+        { SESSION_KEX_X25519, "x25519" }
+    };
+
+    printf("---- initialize_session latency ----\n");
+    int failed = 0;
+    for (size_t i = 0; i < sizeof(exchanges) / sizeof(exchanges[0]) && !failed; i++) {
+        for (int pooled = 0; pooled <= 1 && !failed; pooled++) {
+            failed = run_case(&report, exchanges[i].kex, exchanges[i].name, pooled, samples) != 0;
+        }
+    }
+    session_set_key_exchange(SESSION_KEX_FFDHE2048);
+
+    free(samples);
+    return bench_report_close(&report) != 0 || failed;
+}
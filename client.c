@@ -5,19 +5,27 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <unistd.h>         // For close()
-#include <arpa/inet.h>      // For sockaddr_in, inet_ntoa()
-#include <errno.h>          // For errno and strerror
 #include <pthread.h>        // For threading
+#include <signal.h>         // For ignoring SIGPIPE
+
+#include <openssl/rand.h>   // For the nonce salt
+#include <openssl/crypto.h> // For OPENSSL_cleanse
 
 #define BUFFER_SIZE 4096
 #define IV_SIZE 12          // 12 bytes IV for AES-GCM
 #define TAG_SIZE 16         // 16 bytes authentication tag
+#define RECORD_OVERHEAD (IV_SIZE + TAG_SIZE)
 
 // Structure to pass data to threads
 typedef struct {
-    int sock;
+    SecureConnection* conn;     // Plain TCP or TLS transport shared by both threads
     unsigned char session_key[32];
+    SecureCipher* cipher;       // Keyed AEAD handle (negotiated suite) shared by the sender and receiver threads
+    ReplayWindow replay;        // Sequence numbers already received from the server
+    SecureCipher* group_cipher; // Opens group-key broadcasts once the server sends the key (receiver thread)
+    ReplayWindow group_replay;  // Sequence numbers already received under the group key
+    uint32_t group_epoch;       // Epoch of the current group key, carried in each group frame's nonce salt
+    AdaptiveCompressor* compressor; // Per-connection compress/store decisions (sender thread)
 } client_thread_data_t;
 
 // Function prototypes
@@ -30,6 +38,22 @@ pthread_mutex_t console_mutex = PTHREAD_MUTEX_INITIALIZER;
 int main(int argc, char* argv[]) {
     printf("Client starting...\n");
 
+    // Parse command line: --tls wraps the framed records in TLS, --cipher overrides
+    // the suite picked from the CPU's features
+    int use_tls = 0;
+    CipherSuite preferred_suite = cipher_suite_preferred();
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--tls") == 0) {
+            use_tls = 1;
+        } else if (strcmp(argv[i], "--cipher") == 0 && i + 1 < argc &&
+                   cipher_suite_from_name(argv[i + 1], &preferred_suite) == SECURE_COMM_SUCCESS) {
+            i++;
+        } else {
+            fprintf(stderr, "Usage: %s [--tls] [--cipher aes-256-gcm|chacha20-poly1305]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
     // Load configuration
     Configuration config;
     SecureCommError config_ret = load_configuration("../client_config.json", &config);
@@ -39,11 +63,20 @@ int main(int argc, char* argv[]) {
     }
 
     // Initialize logging
+    // An empty log_file_path logs to the console; log_async moves the writes to a background
+    // thread and log_format "binary" writes the compact format read by secure_log_decode
     SecureCommError log_ret;
-    if (strlen(config.log_file_path) > 0) {
-        log_ret = init_logging(config.log_level, config.log_file_path);
+    const char* log_path = strlen(config.log_file_path) > 0 ? config.log_file_path : NULL;
+    if (config.log_binary) {
+        log_ret = init_logging_binary(config.log_level, log_path);
+    } else if (config.log_async) {
+        AsyncLogConfig async_config;
+        async_log_config_defaults(&async_config);
+        async_config.on_full = config.log_full_policy;
+        async_config.capacity = config.log_queue_capacity;
+        log_ret = init_logging_async(config.log_level, log_path, &async_config);
     } else {
-        log_ret = init_logging(config.log_level, NULL); // Log to console
+        log_ret = init_logging(config.log_level, log_path);
     }
 
     if (log_ret != SECURE_COMM_SUCCESS) {
@@ -51,37 +84,46 @@ int main(int argc, char* argv[]) {
         return EXIT_FAILURE;
     }
 
-    log_message(LOG_LEVEL_INFO, "Client starting...");
+    LOG_INFO("Client starting...");
 
-    // Create socket
-    int sock = socket(AF_INET, SOCK_STREAM, 0);
-    if (sock < 0) {
-        log_message(LOG_LEVEL_ERROR, "Failed to create socket: %s", strerror(errno));
+    if (init_networking() != SECURE_COMM_SUCCESS) {
+        LOG_ERROR("Failed to initialize networking");
         cleanup_logging();
         return EXIT_FAILURE;
     }
 
-    // Server address setup
-    struct sockaddr_in server_addr;
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_port = htons(config.server_port);
-    if (inet_pton(AF_INET, config.server_address, &server_addr.sin_addr) <= 0) {
-        log_message(LOG_LEVEL_ERROR, "Invalid server address: %s", config.server_address);
-        close(sock);
+    // A server closing mid-write must fail the send, not kill the process
+    signal(SIGPIPE, SIG_IGN);
+
+    // Connect to server, giving up after connect_timeout_ms
+    networking_set_connect_timeout(config.connect_timeout_ms);
+    networking_set_socket_buffers(config.socket_rcvbuf, config.socket_sndbuf);
+    SecureCommError conn_ret;
+    SecureConnection* conn = use_tls
+        ? create_connection(config.server_address, config.server_port, &conn_ret)
+        : create_plain_connection(config.server_address, config.server_port, &conn_ret);
+    if (conn == NULL) {
+        LOG_ERROR("Failed to connect to server %s:%d. Error code: %d",
+                  config.server_address, config.server_port, conn_ret);
+        cleanup_networking();
         cleanup_logging();
         return EXIT_FAILURE;
     }
 
-    // Connect to server
-    if (connect(sock, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
-        log_message(LOG_LEVEL_ERROR, "Failed to connect to server %s:%d: %s",
-                    config.server_address, config.server_port, strerror(errno));
-        close(sock);
+    LOG_INFO("Connected to server %s:%d", config.server_address, config.server_port);
+
+    // Agree on the AEAD suite before any record is sent
+    CipherSuite suite = CIPHER_SUITE_AES_GCM;
+    unsigned char connection_salt[SECURE_CONNECTION_SALT_SIZE];
+    SecureCommError suite_ret = cipher_negotiate_client(conn, preferred_suite, &suite, connection_salt);
+    if (suite_ret != SECURE_COMM_SUCCESS) {
+        LOG_ERROR("Failed to negotiate a cipher suite. Error code: %d", suite_ret);
+        close_connection(conn);
+        cleanup_networking();
         cleanup_logging();
         return EXIT_FAILURE;
     }
-
-    log_message(LOG_LEVEL_INFO, "Connected to server %s:%d", config.server_address, config.server_port);
+    LOG_INFO("Using cipher suite %s", cipher_suite_name(suite));
 
     // Predefined session key (must be the same on both client and server)
     unsigned char session_key[32] = {
@@ -97,22 +139,83 @@ int main(int argc, char* argv[]) {
 
     // Set up thread data
     client_thread_data_t thread_data;
-    thread_data.sock = sock;
-    memcpy(thread_data.session_key, session_key, 32);
+    thread_data.conn = conn;
+    thread_data.cipher = NULL;
+    thread_data.group_cipher = NULL;
+    thread_data.compressor = NULL;
+
+    replay_window_init(&thread_data.replay);
+    replay_window_init(&thread_data.group_replay);
+    thread_data.group_epoch = 0;
+
+    // Counter nonces need a key of this connection alone. Like the server, derive the
+    // session key from the shared key and both HELLO randoms, then the connection key from it.
+    if (cipher_derive_key(session_key, sizeof(session_key), connection_salt, sizeof(connection_salt),
+                          SECURE_SESSION_KEY_LABEL, session_key, sizeof(session_key)) != SECURE_COMM_SUCCESS ||
+        cipher_derive_key(session_key, sizeof(session_key), connection_salt, sizeof(connection_salt),
+                          SECURE_CONNECTION_KEY_LABEL, thread_data.session_key,
+                          sizeof(thread_data.session_key)) != SECURE_COMM_SUCCESS) {
+        LOG_ERROR("Failed to derive the connection key");
+        close_connection(conn);
+        cleanup_networking();
+        cleanup_logging();
+        return EXIT_FAILURE;
+    }
+
+    // Expand the connection key once for the whole connection. The salt's top bit is
+    // cleared for client-to-server nonces (the server sets it for its direction).
+    unsigned char salt[SECURE_NONCE_SALT_SIZE];
+    if (!RAND_bytes(salt, sizeof(salt))) {
+        LOG_ERROR("Failed to generate nonce salt");
+        close_connection(conn);
+        cleanup_networking();
+        cleanup_logging();
+        return EXIT_FAILURE;
+    }
+    salt[0] &= 0x7F;
+
+    if (cipher_create_suite(suite, thread_data.session_key, sizeof(thread_data.session_key), &thread_data.cipher) != SECURE_COMM_SUCCESS ||
+        cipher_use_counter_nonces(thread_data.cipher, salt) != SECURE_COMM_SUCCESS) {
+        LOG_ERROR("Failed to create cipher");
+        cipher_destroy(thread_data.cipher);
+        close_connection(conn);
+        cleanup_networking();
+        cleanup_logging();
+        return EXIT_FAILURE;
+    }
+
+    AdaptiveCompressionConfig adaptive_config;
+    adaptive_config_defaults(&adaptive_config);
+    adaptive_config.strong_codec = config.compression_codec;
+    adaptive_config.strong_level = config.compression_level;
+    if (adaptive_compressor_create(&adaptive_config, &thread_data.compressor) != SECURE_COMM_SUCCESS) {
+        LOG_ERROR("Failed to create adaptive compressor");
+        cipher_destroy(thread_data.cipher);
+        close_connection(conn);
+        cleanup_networking();
+        cleanup_logging();
+        return EXIT_FAILURE;
+    }
 
     // Create sender and receiver threads
     pthread_t sender_thread, receiver_thread;
 
     if (pthread_create(&sender_thread, NULL, sender_thread_func, (void*)&thread_data) != 0) {
-        log_message(LOG_LEVEL_ERROR, "Failed to create sender thread");
-        close(sock);
+        LOG_ERROR("Failed to create sender thread");
+        close_connection(conn);
+        cipher_destroy(thread_data.cipher);
+        adaptive_compressor_destroy(thread_data.compressor);
+        cleanup_networking();
         cleanup_logging();
         return EXIT_FAILURE;
     }
 
     if (pthread_create(&receiver_thread, NULL, receiver_thread_func, (void*)&thread_data) != 0) {
-        log_message(LOG_LEVEL_ERROR, "Failed to create receiver thread");
-        close(sock);
+        LOG_ERROR("Failed to create receiver thread");
+        close_connection(conn);
+        cipher_destroy(thread_data.cipher);
+        adaptive_compressor_destroy(thread_data.compressor);
+        cleanup_networking();
         cleanup_logging();
         return EXIT_FAILURE;
     }
@@ -120,12 +223,17 @@ int main(int argc, char* argv[]) {
     // Wait for the sender thread to finish (i.e., when the user types 'exit')
     pthread_join(sender_thread, NULL);
 
-    // Close the socket to signal the receiver thread to exit
-    close(sock);
+    // Shut the connection down to wake the receiver thread blocked in secure_recv
+    connection_shutdown(conn);
 
     // Wait for the receiver thread to finish
     pthread_join(receiver_thread, NULL);
 
+    close_connection(conn);
+    cipher_destroy(thread_data.cipher);
+    cipher_destroy(thread_data.group_cipher);
+    adaptive_compressor_destroy(thread_data.compressor);
+    cleanup_networking();
     cleanup_logging();
 
     return EXIT_SUCCESS;
@@ -136,8 +244,6 @@ int main(int argc, char* argv[]) {
  */
 void* sender_thread_func(void* arg) {
     client_thread_data_t* data = (client_thread_data_t*)arg;
-    int sock = data->sock;
-    unsigned char* session_key = data->session_key;
 
     while (1) {
         // Lock console to print prompt
@@ -150,9 +256,12 @@ void* sender_thread_func(void* arg) {
         // Unlock console before blocking on fgets
         pthread_mutex_unlock(&console_mutex);
 
-        // Get user input
-        char message[BUFFER_SIZE];
-        if (fgets(message, sizeof(message), stdin) == NULL) {
+        // Read the message straight into the payload slot of the frame:
+        // header || IV || tag || payload, sealed in place below
+        unsigned char frame[SECURE_FRAME_HEADER_SIZE + RECORD_OVERHEAD + BUFFER_SIZE];
+        unsigned char* record = frame + SECURE_FRAME_HEADER_SIZE;
+        char* message = (char*)(record + RECORD_OVERHEAD);
+        if (fgets(message, BUFFER_SIZE, stdin) == NULL) {
             break;
         }
 
@@ -168,29 +277,32 @@ void* sender_thread_func(void* arg) {
             break;
         }
 
-        unsigned char encrypted_msg[BUFFER_SIZE];
-        int encrypted_len = 0;
-        unsigned char iv[IV_SIZE];
-        unsigned char tag[TAG_SIZE];
+        // Compress only when it pays off; the frame header records the codec used
+        unsigned char packed[2 * BUFFER_SIZE];
+        size_t packed_len = sizeof(packed);
+        CompressionCodecId codec = COMPRESSION_CODEC_NONE;
+        if (adaptive_compress(data->compressor, (const unsigned char*)message, msg_len,
+                              packed, &packed_len, &codec) == SECURE_COMM_SUCCESS &&
+            codec != COMPRESSION_CODEC_NONE) {
+            // Always shorter than the message it replaces in the slot
+            memcpy(message, packed, packed_len);
+            msg_len = packed_len;
+        }
 
-        // Encrypt the message
-        SecureCommError encrypt_ret = encrypt_data((unsigned char*)message, msg_len,
-                                                   session_key, iv,
-                                                   encrypted_msg, &encrypted_len, tag);
+        size_t record_len = 0;
+        SecureCommError encrypt_ret = cipher_seal_record(data->cipher, record, msg_len, &record_len);
         if (encrypt_ret != SECURE_COMM_SUCCESS) {
-            log_message(LOG_LEVEL_ERROR, "Failed to encrypt message. Error code: %d", encrypt_ret);
+            LOG_ERROR("Failed to encrypt message. Error code: %d", encrypt_ret);
             continue;
         }
 
-        // Send the IV + tag + encrypted message
-        unsigned char final_output[IV_SIZE + TAG_SIZE + encrypted_len];
-        memcpy(final_output, iv, IV_SIZE);                             // Copy IV
-        memcpy(final_output + IV_SIZE, tag, TAG_SIZE);                 // Copy authentication tag
-        memcpy(final_output + IV_SIZE + TAG_SIZE, encrypted_msg, encrypted_len); // Copy encrypted data
+        FrameHeader header = { (uint32_t)record_len, FRAME_TYPE_DATA, 0, (uint8_t)codec,
+                               (uint8_t)cipher_get_suite(data->cipher) };
+        frame_encode_header(&header, frame);
 
-        ssize_t bytes_sent = send(sock, final_output, IV_SIZE + TAG_SIZE + encrypted_len, 0);
-        if (bytes_sent < 0) {
-            log_message(LOG_LEVEL_ERROR, "Failed to send message: %s", strerror(errno));
+        ssize_t bytes_sent = 0;
+        if (secure_send(data->conn, frame, SECURE_FRAME_HEADER_SIZE + record_len, &bytes_sent) != SECURE_COMM_SUCCESS) {
+            LOG_ERROR("Failed to send message to server");
             break;
         }
     }
@@ -198,67 +310,179 @@ void* sender_thread_func(void* arg) {
     pthread_exit(NULL);
 }
 
+/**
+ * @brief Decrypts one IV || tag || ciphertext record in place and checks it against a replay window.
+ *
+ * @return SECURE_COMM_SUCCESS with the plaintext in *plaintext, or an error once logged.
+ */
+static SecureCommError open_record(SecureCipher* cipher, ReplayWindow* replay, unsigned char* record,
+                                   size_t record_len, unsigned char** plaintext, size_t* plaintext_len) {
+    if (record_len < RECORD_OVERHEAD) {
+        LOG_ERROR("Received record is too short to contain IV and tag");
+        return SECURE_COMM_ERR_FRAME;
+    }
+
+    // Decrypt in place: the plaintext replaces the ciphertext inside the record buffer
+    const unsigned char* iv = record;
+    SecureCommError decrypt_ret = cipher_open_record(cipher, record, record_len, plaintext, plaintext_len);
+    if (decrypt_ret != SECURE_COMM_SUCCESS) {
+        LOG_ERROR("Failed to decrypt message. Error code: %d", decrypt_ret);
+        return decrypt_ret;
+    }
+
+    // Drop authenticated messages whose sequence number was already seen
+    SecureCommError replay_ret = replay_window_accept(replay, nonce_sequence(iv));
+    if (replay_ret != SECURE_COMM_SUCCESS) {
+        LOG_WARN("Dropping replayed message from server");
+    }
+    return replay_ret;
+}
+
+/**
+ * @brief Keys the group cipher from a GROUP_KEY frame: key(32) || epoch(4) || suite(1) || topic name,
+ *        sealed under the session cipher. The server sends a new one whenever a subscriber leaves
+ *        or the topic changes suite.
+ */
+static void process_group_key(client_thread_data_t* data, unsigned char* record, size_t record_len) {
+    unsigned char* payload = NULL;
+    size_t payload_len = 0;
+    if (open_record(data->cipher, &data->replay, record, record_len, &payload, &payload_len) != SECURE_COMM_SUCCESS) {
+        return;
+    }
+    if (payload_len < 32 + 4 + 1 || payload[36] >= CIPHER_SUITE_COUNT) {
+        LOG_ERROR("Malformed group key frame");
+        return;
+    }
+
+    // A new key restarts the group's nonce sequence
+    SecureCipher* group_cipher = NULL;
+    if (cipher_create_suite((CipherSuite)payload[36], payload, 32, &group_cipher) != SECURE_COMM_SUCCESS) {
+        LOG_ERROR("Failed to create group cipher");
+        OPENSSL_cleanse(payload, payload_len);
+        return;
+    }
+    uint32_t epoch = ((uint32_t)payload[32] << 24) | ((uint32_t)payload[33] << 16) |
+                     ((uint32_t)payload[34] << 8) | payload[35];
+    OPENSSL_cleanse(payload, payload_len);
+    cipher_destroy(data->group_cipher);
+    data->group_epoch = epoch;
+    data->group_cipher = group_cipher;
+    replay_window_init(&data->group_replay);
+    LOG_INFO("Received group key for broadcasts (epoch %u)", data->group_epoch);
+}
+
+/**
+ * @brief Decrypts in place, expands and prints one IV || tag || ciphertext record from the server.
+ */
+static void process_record(SecureCipher* cipher, ReplayWindow* replay, uint8_t codec,
+                           unsigned char* record, size_t record_len) {
+    unsigned char* decrypted_msg = NULL;
+    size_t decrypted_len = 0;
+    if (open_record(cipher, replay, record, record_len, &decrypted_msg, &decrypted_len) != SECURE_COMM_SUCCESS) {
+        return;
+    }
+
+    // Expand compressed payloads with the codec named in the frame header
+    unsigned char expanded[BUFFER_SIZE + 1];
+    unsigned char* message = decrypted_msg;
+    size_t message_len = decrypted_len;
+    if (codec != COMPRESSION_CODEC_NONE) {
+        size_t expanded_len = BUFFER_SIZE;
+        if (codec_decompress((CompressionCodecId)codec, decrypted_msg, message_len,
+                             expanded, &expanded_len) != SECURE_COMM_SUCCESS) {
+            LOG_ERROR("Failed to decompress message from server");
+            return;
+        }
+        message = expanded;
+        message_len = expanded_len;
+    }
+    message[message_len] = '\0'; // Null-terminate the message (the record buffer keeps a spare byte)
+
+    // Lock console before printing received message
+    pthread_mutex_lock(&console_mutex);
+
+    // Move cursor to a new line if the sender prompt is active
+    printf("\nServer: %s\n", message);
+
+    // Re-print the sender prompt
+    printf("You: ");
+    fflush(stdout);
+
+    // Unlock console
+    pthread_mutex_unlock(&console_mutex);
+}
+
 /**
  * @brief Thread function to handle receiving messages from the server.
+ *
+ * Reads straight into a frame decoder, so records split or merged by TCP are
+ * reassembled before decryption.
  */
 void* receiver_thread_func(void* arg) {
     client_thread_data_t* data = (client_thread_data_t*)arg;
-    int sock = data->sock;
-    unsigned char* session_key = data->session_key;
 
-    unsigned char buffer[BUFFER_SIZE];
+    FrameDecoder* decoder = NULL;
+    if (frame_decoder_create(4 * BUFFER_SIZE, RECORD_OVERHEAD + BUFFER_SIZE, &decoder) != SECURE_COMM_SUCCESS) {
+        LOG_ERROR("Failed to create frame decoder");
+        pthread_exit(NULL);
+    }
+
+    // One spare byte lets process_record terminate the decrypted message in place
+    unsigned char record[RECORD_OVERHEAD + BUFFER_SIZE + 1];
 
     while (1) {
-        ssize_t bytes_received = recv(sock, buffer, sizeof(buffer), 0);
-        if (bytes_received <= 0) {
-            if (bytes_received == 0) {
-                log_message(LOG_LEVEL_WARN, "Server closed the connection");
-            } else {
-                log_message(LOG_LEVEL_ERROR, "Failed to receive data: %s", strerror(errno));
-            }
+        unsigned char* space;
+        size_t space_len;
+        frame_decoder_write_space(decoder, &space, &space_len);
+
+        ssize_t bytes_received = 0;
+        if (secure_recv(data->conn, space, space_len, &bytes_received) != SECURE_COMM_SUCCESS) {
+            LOG_WARN("Connection to server closed");
             break;
         }
+        frame_decoder_commit(decoder, (size_t)bytes_received);
+
+        // One read may complete several frames, or none at all
+        FrameHeader header;
+        SecureCommError frame_ret;
+        while ((frame_ret = frame_decoder_next(decoder, &header, record, sizeof(record) - 1)) == SECURE_COMM_SUCCESS) {
+            if (header.type != FRAME_TYPE_DATA && header.type != FRAME_TYPE_GROUP_KEY) {
+                continue;
+            }
 
-        // Decrypt the received message
-        unsigned char iv[IV_SIZE];
-        unsigned char tag[TAG_SIZE];
-        unsigned char decrypted_msg[BUFFER_SIZE];
-        int decrypted_len = 0;
-
-        if (bytes_received < IV_SIZE + TAG_SIZE) {
-            log_message(LOG_LEVEL_ERROR, "Received data is too short to contain IV and tag");
-            continue;
+            // Group broadcasts are sealed once under the group key instead of the session key
+            int group = header.type == FRAME_TYPE_DATA && (header.flags & FRAME_FLAG_GROUP);
+            if (group && data->group_cipher == NULL) {
+                LOG_WARN("Dropping group broadcast received before its key");
+                continue;
+            }
+            if (group && header.length >= SECURE_NONCE_SALT_SIZE) {
+                uint32_t epoch = (((uint32_t)record[0] << 24) | ((uint32_t)record[1] << 16) |
+                                  ((uint32_t)record[2] << 8) | record[3]) & 0x7FFFFFFFu;
+                if (epoch != (data->group_epoch & 0x7FFFFFFFu)) {
+                    LOG_WARN("Dropping group broadcast sealed under group key epoch %u", epoch);
+                    continue;
+                }
+            }
+            SecureCipher* cipher = group ? data->group_cipher : data->cipher;
+            if (header.suite != cipher_get_suite(cipher)) {
+                LOG_ERROR("Dropping record sealed with unexpected cipher suite %u", header.suite);
+                continue;
+            }
+            if (header.type == FRAME_TYPE_GROUP_KEY) {
+                process_group_key(data, record, header.length);
+            } else {
+                process_record(cipher, group ? &data->group_replay : &data->replay, header.codec,
+                               record, header.length);
+            }
         }
 
-        // Extract IV and tag from the received buffer
-        memcpy(iv, buffer, IV_SIZE);
-        memcpy(tag, buffer + IV_SIZE, TAG_SIZE);
-        unsigned char* ciphertext = buffer + IV_SIZE + TAG_SIZE;
-        int ciphertext_len = bytes_received - IV_SIZE - TAG_SIZE;
-
-        SecureCommError decrypt_ret = decrypt_data(ciphertext, ciphertext_len,
-                                                   session_key, iv,
-                                                   decrypted_msg, &decrypted_len, tag);
-        if (decrypt_ret != SECURE_COMM_SUCCESS) {
-            log_message(LOG_LEVEL_ERROR, "Failed to decrypt message. Error code: %d", decrypt_ret);
-            continue;
+        if (frame_ret != SECURE_COMM_ERR_AGAIN) {
+            LOG_ERROR("Malformed frame stream from server, closing connection");
+            break;
         }
-
-        decrypted_msg[decrypted_len] = '\0'; // Null-terminate the decrypted message
-
-        // Lock console before printing received message
-        pthread_mutex_lock(&console_mutex);
-
-        // Move cursor to a new line if the sender prompt is active
-        printf("\nServer: %s\n", decrypted_msg);
-
-        // Re-print the sender prompt
-        printf("You: ");
-        fflush(stdout);
-
-        // Unlock console
-        pthread_mutex_unlock(&console_mutex);
     }
 
+    frame_decoder_destroy(decoder);
     pthread_exit(NULL);
 }
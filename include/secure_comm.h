@@ -2,6 +2,10 @@
 #define SECURE_COMM_H
 
 #include <stddef.h>  // for size_t
+#include <stdint.h>  // for uint32_t, uint64_t
+#include <stdarg.h>  // for va_list
+#include <stdio.h>   // for FILE
+#include <stdatomic.h> // for the runtime log level
 #include <openssl/evp.h>
 
 // Platform-specific includes and definitions
@@ -20,6 +24,7 @@
     #include <netdb.h>      // for getaddrinfo
     #include <sys/types.h>
     #include <sys/socket.h>
+    #include <sys/uio.h>    // for struct iovec
 #endif
 
 // Enum for standardized error codes
@@ -40,7 +45,10 @@ typedef enum {
     SECURE_COMM_ERR_DECOMPRESS = -13,// Decompression failed
     SECURE_COMM_ERR_SESSION = -14,    // Session management failed
     SECURE_COMM_ERR_CONFIG = -15,    // Configuration parsing failed
-    SECURE_COMM_ERR_LOG = -16        //logging failed
+    SECURE_COMM_ERR_LOG = -16,       //logging failed
+    SECURE_COMM_ERR_FRAME = -17,     // Malformed or oversized frame
+    SECURE_COMM_ERR_AGAIN = -18,     // Not enough data yet / operation would block
+    SECURE_COMM_ERR_TIMEOUT = -19    // A connect or handshake deadline passed
 } SecureCommError;
 
 // Opaque structure for secure connections
@@ -55,174 +63,3091 @@ typedef struct UserSession {
     EVP_PKEY* peer_dh_public;      // Peer public key (EVP_PKEY)
 } UserSession;
 
+// -----------------------------------
+// Buffer Pool Module Function Declarations
+// -----------------------------------
+
+// Opaque size-classed pool of message buffers
+typedef struct BufferPool BufferPool;
+
+// Opaque, reference-counted buffer taken from a BufferPool
+typedef struct SecureBuffer SecureBuffer;
+
+// Number of power-of-two size classes a pool can have
+#define BUFFER_POOL_MAX_CLASSES 24
+
+/**
+ * @brief Buffer pool parameters.
+ *
+ * Requests are rounded up to a power of two between min_size and max_size. Each
+ * class is carved out of slabs of slab_size bytes (or one buffer, if larger) that
+ * are kept until the pool is destroyed. Larger requests get a one-off allocation
+ * that is freed on release.
+ */
+typedef struct {
+    size_t min_size;            // Smallest class in bytes
+    size_t max_size;            // Largest pooled class in bytes
+    size_t slab_size;           // Bytes allocated at once when a class runs dry
+    size_t thread_cache;        // Free buffers each thread keeps per class (at most one slab's worth)
+} BufferPoolConfig;
+
+/**
+ * @brief Buffer pool counters.
+ */
+typedef struct {
+    uint64_t gets;              // Buffers handed out
+    uint64_t cache_hits;        // Gets served from the calling thread's cache
+    uint64_t central_hits;      // Gets served from the shared free lists
+    uint64_t slabs;             // Slabs allocated
+    uint64_t slab_bytes;        // Bytes held by those slabs
+    uint64_t oversize;          // Gets above max_size served by malloc
+    uint64_t outstanding;       // Buffers not yet released
+} BufferPoolStats;
+
+/**
+ * @brief Fills a BufferPoolConfig with the defaults (256 B to 1 MB, 256 KB slabs, 32 cached).
+ *
+ * @param config The configuration to fill.
+ */
+void buffer_pool_config_defaults(BufferPoolConfig* config);
+
+/**
+ * @brief Creates a buffer pool.
+ *
+ * @param config Pool parameters, or NULL for the defaults.
+ * @param pool Pointer to store the created BufferPool.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError buffer_pool_create(const BufferPoolConfig* config, BufferPool** pool);
+
+/**
+ * @brief Returns the library-wide pool (default configuration), creating it on first use.
+ *
+ * It lives until the process exits. Returns NULL only if it could not be created.
+ */
+BufferPool* buffer_pool_default(void);
+
+/**
+ * @brief Sets the configuration of the library-wide pool before its first use.
+ *
+ * @param config Pool parameters.
+ *
+ * @return SECURE_COMM_SUCCESS, or SECURE_COMM_ERR_INIT if the default pool already exists.
+ */
+SecureCommError buffer_pool_configure_default(const BufferPoolConfig* config);
+
+/**
+ * @brief Takes a buffer of at least size bytes. It starts with one reference and length 0.
+ *
+ * A free buffer of the right class in the calling thread's cache is reused without
+ * any lock; otherwise the class's shared free list is refilled from, and only when
+ * that is empty is a new slab allocated.
+ *
+ * @param pool The pool, or NULL for buffer_pool_default().
+ * @param size Bytes needed.
+ * @param buffer Pointer to store the buffer.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or SECURE_COMM_ERR_MEMORY on failure.
+ */
+SecureCommError buffer_pool_get(BufferPool* pool, size_t size, SecureBuffer** buffer);
+
+/**
+ * @brief Copies the pool counters.
+ *
+ * @param pool The pool, or NULL for buffer_pool_default().
+ * @param stats Pointer to store the counters.
+ */
+void buffer_pool_stats(BufferPool* pool, BufferPoolStats* stats);
+
+/**
+ * @brief Destroys a pool and every slab it allocated.
+ *
+ * Every buffer must have been released and no other thread may still use the pool.
+ */
+void buffer_pool_destroy(BufferPool* pool);
+
+/**
+ * @brief Adds a reference, e.g. before handing the buffer to another stage or thread.
+ */
+void secure_buffer_retain(SecureBuffer* buffer);
+
+/**
+ * @brief Drops a reference; the last one returns the buffer to its pool.
+ */
+void secure_buffer_release(SecureBuffer* buffer);
+
+/**
+ * @brief Returns the first valid byte (after any bytes dropped with secure_buffer_advance).
+ */
+unsigned char* secure_buffer_data(const SecureBuffer* buffer);
+
+/**
+ * @brief Returns the number of valid bytes at secure_buffer_data.
+ */
+size_t secure_buffer_len(const SecureBuffer* buffer);
+
+/**
+ * @brief Returns how many bytes fit at secure_buffer_data.
+ */
+size_t secure_buffer_capacity(const SecureBuffer* buffer);
+
+/**
+ * @brief Sets the number of valid bytes after writing into the buffer.
+ *
+ * @return SECURE_COMM_SUCCESS, or SECURE_COMM_ERR_MEMORY if len exceeds the capacity.
+ */
+SecureCommError secure_buffer_set_len(SecureBuffer* buffer, size_t len);
+
+/**
+ * @brief Drops len bytes from the front without copying (for example a header or IV || tag).
+ *
+ * @return SECURE_COMM_SUCCESS, or SECURE_COMM_ERR_MEMORY if fewer than len bytes are valid.
+ */
+SecureCommError secure_buffer_advance(SecureBuffer* buffer, size_t len);
+
+// -----------------------------------
+// Worker Pool Module Function Declarations
+// -----------------------------------
+
+// Opaque pool of CPU worker threads, each with its own task queue
+typedef struct WorkerPool WorkerPool;
+
+// Opaque stream of tasks (one per connection) whose results complete in submission order
+typedef struct WorkerSequence WorkerSequence;
+
+/**
+ * @brief A unit of work run on a pool thread.
+ */
+typedef void (*worker_task_fn)(void* arg);
+
+/**
+ * @brief Runs one index of a worker_pool_parallel_for call.
+ */
+typedef void (*worker_index_fn)(void* ctx, size_t index);
+
+/**
+ * @brief Receives a WorkerSequence task once it and every earlier task have finished.
+ */
+typedef void (*worker_complete_fn)(void* arg, void* user_data);
+
+/**
+ * @brief Parameters for worker_pool_create. Initialize with worker_pool_config_defaults.
+ */
+typedef struct {
+    size_t threads;             // Worker threads; 0 starts one per online CPU
+    int pin_threads;            // Non-zero pins worker i to CPU i (modulo the online CPUs)
+    size_t queue_capacity;      // Initial tasks per worker queue; a full queue grows
+} WorkerPoolConfig;
+
+/**
+ * @brief Worker pool counters.
+ */
+typedef struct {
+    size_t threads;             // Worker threads
+    uint64_t executed;          // Tasks run by worker threads
+    uint64_t stolen;            // ... of which were taken from another worker's queue
+    uint64_t helped;            // Tasks run by threads waiting in worker_pool_parallel_for
+    uint64_t pending;           // Tasks queued and not yet started
+} WorkerPoolStats;
+
+/**
+ * @brief Fills a WorkerPoolConfig with the defaults (one thread per CPU, unpinned).
+ *
+ * @param config The configuration to fill.
+ */
+void worker_pool_config_defaults(WorkerPoolConfig* config);
+
+/**
+ * @brief Starts a worker pool.
+ *
+ * Each worker runs the oldest task of its own queue and, when that is empty,
+ * steals the newest task of another worker's queue. Tasks submitted from a
+ * worker go to its own queue; others are spread round-robin.
+ *
+ * @param config Pool parameters, or NULL for the defaults.
+ * @param pool Pointer to store the created WorkerPool.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError worker_pool_create(const WorkerPoolConfig* config, WorkerPool** pool);
+
+/**
+ * @brief Sets the configuration of the library-wide pool before its first use.
+ *
+ * @param config Pool parameters.
+ *
+ * @return SECURE_COMM_SUCCESS, or SECURE_COMM_ERR_INIT if the default pool already exists.
+ */
+SecureCommError worker_pool_configure_default(const WorkerPoolConfig* config);
+
+/**
+ * @brief Returns the library-wide pool, creating it on first use.
+ *
+ * The batch AEAD calls run on it. It lives until the process exits. Returns
+ * NULL only if it could not be created.
+ */
+WorkerPool* worker_pool_default(void);
+
+/**
+ * @brief Queues a task.
+ *
+ * @param pool The pool, or NULL for worker_pool_default().
+ * @param task Function to run on a worker thread.
+ * @param arg Argument passed to task.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError worker_pool_submit(WorkerPool* pool, worker_task_fn task, void* arg);
+
+/**
+ * @brief Runs fn(ctx, i) for every i below count and waits for all of them.
+ *
+ * The calling thread runs index 0 itself and then runs queued tasks until the
+ * rest are done, so it may be called from a worker thread.
+ *
+ * @param pool The pool, or NULL for worker_pool_default().
+ * @param count Number of indices.
+ * @param fn Function to run for each index.
+ * @param ctx Argument passed to fn.
+ */
+void worker_pool_parallel_for(WorkerPool* pool, size_t count, worker_index_fn fn, void* ctx);
+
+/**
+ * @brief Returns the index of the calling worker thread in pool, or -1 for other threads.
+ */
+int worker_pool_current_worker(const WorkerPool* pool);
+
+/**
+ * @brief Returns the number of worker threads.
+ */
+size_t worker_pool_threads(const WorkerPool* pool);
+
+/**
+ * @brief Copies a pool's counters.
+ */
+void worker_pool_stats(WorkerPool* pool, WorkerPoolStats* stats);
+
+/**
+ * @brief Runs the tasks still queued, stops the threads and frees the pool.
+ */
+void worker_pool_destroy(WorkerPool* pool);
+
+/**
+ * @brief Creates a sequence of tasks whose results complete in submission order.
+ *
+ * The work of consecutive tasks may run on several workers at once; complete
+ * is then called for each task in the order it was submitted, never by two
+ * threads at the same time.
+ *
+ * @param pool The pool, or NULL for worker_pool_default().
+ * @param max_in_flight Tasks that may be submitted but not completed; further submits wait.
+ * @param complete Called in order with each task's argument.
+ * @param user_data Passed to complete.
+ * @param sequence Pointer to store the created WorkerSequence.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError worker_sequence_create(WorkerPool* pool, size_t max_in_flight, worker_complete_fn complete,
+                                       void* user_data, WorkerSequence** sequence);
+
+/**
+ * @brief Queues a task on the sequence's pool.
+ *
+ * Blocks while max_in_flight tasks are outstanding, which bounds how far the
+ * submitting (I/O) thread can run ahead of the workers.
+ *
+ * @param sequence The sequence.
+ * @param work Function run on a worker thread; NULL skips straight to completion.
+ * @param arg Argument passed to work and then to complete.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError worker_sequence_submit(WorkerSequence* sequence, worker_task_fn work, void* arg);
+
+/**
+ * @brief Waits until every submitted task has completed.
+ */
+void worker_sequence_drain(WorkerSequence* sequence);
+
+/**
+ * @brief Drains and frees a sequence.
+ */
+void worker_sequence_destroy(WorkerSequence* sequence);
+
 /**
  * @brief Initializes the networking module.
  *
  * This function sets up any necessary networking resources, such as
- * initializing networking libraries required by the underlying platform.
+ * initializing networking libraries required by the underlying platform,
+ * and creates the client SSL context shared by every connection.
  *
  * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
  */
 SecureCommError init_networking();
 
+// Limit on establishing the TCP connection in create_connection and create_plain_connection
+#define SECURE_CONNECT_DEFAULT_TIMEOUT_MS 10000
+
+/**
+ * @brief Creates a secure connection to the specified address and port.
+ *
+ * The address is resolved with getaddrinfo. When it yields both IPv6 and IPv4
+ * addresses, connection attempts alternate between the families and start
+ * 250 ms apart; the first to connect is kept (RFC 8305, "happy eyeballs").
+ *
+ * This function establishes a TCP connection to the given address and port and
+ * performs the TLS handshake using the context shared by all connections. A session
+ * cached from an earlier connection to the same address and port is offered for
+ * resumption.
+ *
+ * @param address The IP address or hostname to connect to.
+ * @param port The port number to connect on.
+ * @param error Pointer to store the error code if connection fails.
+ *
+ * @return Pointer to a SecureConnection on success, or NULL on failure.
+ *         The specific error code is stored in *error.
+ */
+SecureConnection* create_connection(const char* address, int port, SecureCommError* error);
+
+/**
+ * @brief Creates a plain TCP connection to the specified address and port.
+ *
+ * No TLS is used; the caller's record layer (cipher_encrypt) protects the payloads.
+ * The address is resolved and raced as in create_connection.
+ *
+ * @param address The IP address or hostname to connect to.
+ * @param port The port number to connect on.
+ * @param error Pointer to store the error code if connection fails.
+ *
+ * @return Pointer to a SecureConnection on success, or NULL on failure.
+ */
+SecureConnection* create_plain_connection(const char* address, int port, SecureCommError* error);
+
+/**
+ * @brief Wraps an already connected socket without TLS.
+ *
+ * @param socket_fd Connected socket; owned by the connection on success.
+ * @param error Pointer to store the error code on failure.
+ *
+ * @return Pointer to a SecureConnection on success, or NULL on failure.
+ */
+SecureConnection* connection_wrap_socket(int socket_fd, SecureCommError* error);
+
+/**
+ * @brief Creates the shared server-side SSL context used by secure_accept.
+ *
+ * Session tickets are enabled so that returning clients resume without a full handshake.
+ *
+ * @param cert_path PEM certificate chain file.
+ * @param key_path PEM private key file.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or SECURE_COMM_ERR_SSL_CTX on failure.
+ */
+SecureCommError init_server_tls(const char* cert_path, const char* key_path);
+
+/**
+ * @brief Performs the server side of the TLS handshake on an accepted socket.
+ *
+ * @param socket_fd Socket returned by accept(); owned by the connection on success.
+ * @param error Pointer to store the error code if the handshake fails.
+ *
+ * @return Pointer to a SecureConnection on success, or NULL on failure.
+ */
+SecureConnection* secure_accept(int socket_fd, SecureCommError* error);
+
+/**
+ * @brief Reports whether the connection resumed a previous TLS session.
+ *
+ * @param conn Pointer to an established SecureConnection.
+ *
+ * @return 1 if the abbreviated handshake was used, 0 otherwise.
+ */
+int connection_session_reused(const SecureConnection* conn);
+
+/**
+ * @brief Asks OpenSSL to move the TLS record layer of new connections into the kernel (kTLS).
+ *
+ * Applies to connections created afterwards. OpenSSL falls back to userspace records
+ * when the kernel or the negotiated cipher does not support kTLS.
+ *
+ * @param enable Non-zero to request kTLS, 0 to keep record encryption in userspace.
+ */
+void networking_set_ktls(int enable);
+
+/**
+ * @brief Reports whether the kernel encrypts the TLS records this connection sends.
+ *
+ * @param conn Pointer to an established SecureConnection.
+ *
+ * @return 1 if kTLS is active for sending, 0 otherwise (including plain connections).
+ */
+int connection_ktls_send(const SecureConnection* conn);
+
+/**
+ * @brief Sets how long create_connection and create_plain_connection may spend
+ *        establishing the connection.
+ *
+ * For create_connection the limit covers the TCP connect and the TLS handshake
+ * together. Either one running out returns SECURE_COMM_ERR_TIMEOUT.
+ *
+ * @param timeout_ms Limit in milliseconds (SECURE_CONNECT_DEFAULT_TIMEOUT_MS initially),
+ *                   or 0 to wait as long as the kernel does.
+ */
+void networking_set_connect_timeout(int timeout_ms);
+
+/**
+ * @brief Sets the socket buffer sizes of connections made afterwards by create_connection,
+ *        create_plain_connection and connection pools.
+ *
+ * They are applied before connect(), so the TCP window scale can cover them.
+ *
+ * @param rcvbuf SO_RCVBUF in bytes, or 0 to keep the kernel's default.
+ * @param sndbuf SO_SNDBUF in bytes, or 0 to keep the kernel's default.
+ */
+void networking_set_socket_buffers(int rcvbuf, int sndbuf);
+
+/**
+ * @brief Checks, without blocking, whether the peer is still connected.
+ *
+ * Reads nothing the caller could miss: pending bytes are only peeked at, so a
+ * connection with unread data counts as alive.
+ *
+ * @param conn Pointer to an established SecureConnection.
+ *
+ * @return 1 if the connection is open, 0 if the peer closed it or it failed.
+ */
+int connection_is_alive(SecureConnection* conn);
+
+/**
+ * @brief Byte and call counters of a single connection.
+ */
+typedef struct {
+    uint64_t bytes_sent;
+    uint64_t bytes_received;
+    uint64_t send_calls;
+    uint64_t recv_calls;
+} ConnectionStats;
+
+/**
+ * @brief Copies the byte and call counters of a connection.
+ *
+ * @param conn Pointer to a SecureConnection.
+ * @param stats Pointer to store the counters.
+ */
+void connection_get_stats(const SecureConnection* conn, ConnectionStats* stats);
+
+/**
+ * @brief Sends data over the secure connection.
+ *
+ * This function encrypts and sends the specified data over the connection,
+ * retrying until every byte has been written.
+ *
+ * @param conn Pointer to an established SecureConnection.
+ * @param data Pointer to the data buffer to send.
+ * @param len Length of the data in bytes.
+ * @param bytes_sent Pointer to store the number of bytes actually sent.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError secure_send(SecureConnection* conn, const void* data, size_t len, ssize_t* bytes_sent);
+
+/**
+ * @brief Receives data from the secure connection.
+ *
+ * This function receives and decrypts data from the connection.
+ *
+ * @param conn Pointer to an established SecureConnection.
+ * @param buffer Pointer to the buffer where received data will be stored.
+ * @param len Maximum number of bytes to receive.
+ * @param bytes_received Pointer to store the number of bytes actually received.
+ *
+ * @return SECURE_COMM_SUCCESS on success, SECURE_COMM_ERR_RECV if connection is closed,
+ *         or a negative error code on failure.
+ */
+SecureCommError secure_recv(SecureConnection* conn, void* buffer, size_t len, ssize_t* bytes_received);
+
+/**
+ * @brief Sends the valid bytes of a pool buffer (see secure_send).
+ *
+ * @param conn Pointer to an established SecureConnection.
+ * @param buffer The buffer; the caller keeps its reference.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError secure_send_buffer(SecureConnection* conn, const SecureBuffer* buffer);
+
+/**
+ * @brief Receives into the free space after a pool buffer's valid bytes and extends them.
+ *
+ * @param conn Pointer to an established SecureConnection.
+ * @param buffer The buffer to append to.
+ * @param bytes_received Optional pointer to store the number of bytes appended.
+ *
+ * @return SECURE_COMM_SUCCESS on success, SECURE_COMM_ERR_MEMORY if the buffer is full,
+ *         SECURE_COMM_ERR_RECV if the connection is closed, or another negative error code.
+ */
+SecureCommError secure_recv_buffer(SecureConnection* conn, SecureBuffer* buffer, size_t* bytes_received);
+
+// Largest number of buffers accepted by secure_sendv
+#define SECURE_SENDV_MAX_IOV 16
+
+/**
+ * @brief Sends several buffers as one contiguous byte stream.
+ *
+ * Plain connections hand the vector to sendmsg() directly. TLS has no gather write,
+ * so vectors up to one record are coalesced and sent as a single TLS record; larger
+ * ones are written buffer by buffer.
+ *
+ * @param conn Pointer to an established SecureConnection.
+ * @param iov Buffers to send, in order (at most SECURE_SENDV_MAX_IOV).
+ * @param iovcnt Number of buffers.
+ * @param bytes_sent Pointer to store the total number of bytes sent.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or SECURE_COMM_ERR_SEND on failure.
+ */
+SecureCommError secure_sendv(SecureConnection* conn, const struct iovec* iov, int iovcnt, size_t* bytes_sent);
+
+/**
+ * @brief Receives into several buffers, filling them in order.
+ *
+ * Waits until at least one byte is available, then returns whatever is already
+ * buffered without blocking again, like recv().
+ *
+ * @param conn Pointer to an established SecureConnection.
+ * @param iov Buffers to fill, in order.
+ * @param iovcnt Number of buffers.
+ * @param bytes_received Pointer to store the total number of bytes received.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or SECURE_COMM_ERR_RECV on failure or close.
+ */
+SecureCommError secure_recvv(SecureConnection* conn, const struct iovec* iov, int iovcnt, size_t* bytes_received);
+
+/**
+ * @brief Shuts down both directions of the connection without freeing it.
+ *
+ * Wakes a thread blocked in secure_recv, which then returns SECURE_COMM_ERR_RECV.
+ * Call close_connection once that thread has finished.
+ *
+ * @param conn Pointer to the SecureConnection.
+ */
+void connection_shutdown(SecureConnection* conn);
+
+/**
+ * @brief Closes the secure connection and frees resources.
+ *
+ * This function gracefully shuts down the SSL connection, closes the socket,
+ * and frees any allocated memory associated with the connection.
+ *
+ * @param conn Pointer to the SecureConnection to close.
+ */
+void close_connection(SecureConnection* conn);
+
+/**
+ * @brief Cleans up networking resources.
+ *
+ * This function should be called once all networking operations are complete.
+ * It performs necessary cleanup tasks, such as freeing global resources.
+ */
+void cleanup_networking();
+
+// -----------------------------------
+// Reactor Module Function Declarations
+// -----------------------------------
+
+/**
+ * @brief Event notification backends available to the reactor.
+ */
+typedef enum {
+    REACTOR_BACKEND_EPOLL = 0,      // Linux epoll (always available)
+    REACTOR_BACKEND_IO_URING = 1    // io_uring poll requests (requires SECURE_COMM_WITH_IO_URING)
+} ReactorBackend;
+
+// Opaque structure for the event-driven server core
+typedef struct SecureReactor SecureReactor;
+
+// Opaque structure for a connection owned by a reactor event loop
+typedef struct ReactorConnection ReactorConnection;
+
+/**
+ * @brief Called on the owning loop thread after a connection is accepted.
+ *
+ * Returning anything other than SECURE_COMM_SUCCESS closes the connection.
+ */
+typedef SecureCommError (*reactor_open_cb)(ReactorConnection* conn, void* user_data);
+
+/**
+ * @brief Called on the owning loop thread for every chunk read from a connection.
+ *
+ * The data pointer is only valid for the duration of the call. Returning anything
+ * other than SECURE_COMM_SUCCESS closes the connection.
+ */
+typedef SecureCommError (*reactor_data_cb)(ReactorConnection* conn, const unsigned char* data,
+                                           size_t len, void* user_data);
+
+/**
+ * @brief Called on the owning loop thread once a connection has been closed.
+ */
+typedef void (*reactor_close_cb)(ReactorConnection* conn, void* user_data);
+
+/**
+ * @brief Parameters for reactor_create. Initialize with reactor_config_defaults.
+ */
+typedef struct {
+    int num_threads;            // Number of event-loop threads
+    ReactorBackend backend;     // Event notification backend
+    int max_events;             // Events handled per wait call
+    size_t read_buffer_size;    // Per-loop scratch buffer used for recv
+    size_t max_output_buffer;   // Bytes a connection may have queued for sending (0 for 4 MB)
+    reactor_open_cb on_open;    // Optional: connection accepted
+    reactor_data_cb on_data;    // Optional: bytes received
+    reactor_close_cb on_close;  // Optional: connection closed
+    void* user_data;            // Passed to every callback
+} ReactorConfig;
+
+/**
+ * @brief Fills a ReactorConfig with default values (one epoll loop, 64 KB reads).
+ *
+ * @param config Pointer to the configuration to initialize.
+ */
+void reactor_config_defaults(ReactorConfig* config);
+
+/**
+ * @brief Creates a reactor with a fixed pool of event-loop threads.
+ *
+ * Each loop multiplexes many non-blocking sockets, so the number of threads no
+ * longer grows with the number of clients.
+ *
+ * @param config Callbacks and tunables. Copied into the reactor.
+ * @param reactor Pointer to store the created SecureReactor.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError reactor_create(const ReactorConfig* config, SecureReactor** reactor);
+
+/**
+ * @brief Attaches a bound, listening socket to every event loop.
+ *
+ * @param reactor The reactor.
+ * @param listen_fd A socket on which listen() has already been called.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError reactor_listen(SecureReactor* reactor, int listen_fd);
+
+/**
+ * @brief Runs the event loops until reactor_stop is called.
+ *
+ * @param reactor The reactor.
+ *
+ * @return SECURE_COMM_SUCCESS after a clean stop, or a negative error code on failure.
+ */
+SecureCommError reactor_run(SecureReactor* reactor);
+
+/**
+ * @brief Asks every event loop to exit. Safe to call from any thread or a signal handler.
+ *
+ * @param reactor The reactor.
+ */
+void reactor_stop(SecureReactor* reactor);
+
+/**
+ * @brief Frees a reactor after reactor_run has returned.
+ *
+ * @param reactor The reactor to destroy.
+ */
+void reactor_destroy(SecureReactor* reactor);
+
+/**
+ * @brief Queues data for sending on a reactor connection. Safe to call from any thread.
+ *
+ * A peer that stops reading cannot make the queue grow without bound: once bytes are
+ * queued, a send that would take the queue past ReactorConfig.max_output_buffer is
+ * refused as a whole, so frames are never cut short.
+ *
+ * @param conn The connection.
+ * @param data Pointer to the bytes to send.
+ * @param len Number of bytes to send.
+ *
+ * @return SECURE_COMM_SUCCESS on success, SECURE_COMM_ERR_AGAIN if the queue is full
+ *         (nothing was sent), or another negative error code on failure.
+ */
+SecureCommError reactor_conn_send(ReactorConnection* conn, const void* data, size_t len);
+
+/**
+ * @brief Queues the valid bytes of a pool buffer (see reactor_conn_send). The caller keeps its reference.
+ */
+SecureCommError reactor_conn_send_buffer(ReactorConnection* conn, const SecureBuffer* buffer);
+
+/**
+ * @brief Requests that a connection be closed. Safe to call from any thread.
+ *
+ * @param conn The connection.
+ */
+void reactor_conn_close(ReactorConnection* conn);
+
+/**
+ * @brief Takes an extra reference so the connection can be used after on_close.
+ *
+ * @param conn The connection.
+ */
+void reactor_conn_retain(ReactorConnection* conn);
+
+/**
+ * @brief Drops a reference taken with reactor_conn_retain.
+ *
+ * @param conn The connection.
+ */
+void reactor_conn_release(ReactorConnection* conn);
+
+/**
+ * @brief Returns the socket descriptor of a connection.
+ */
+int reactor_conn_fd(const ReactorConnection* conn);
+
+/**
+ * @brief Returns the remote address of a connection.
+ *
+ * @param conn The connection.
+ * @param len Optional pointer to store the address length.
+ */
+const struct sockaddr* reactor_conn_peer(const ReactorConnection* conn, socklen_t* len);
+
+/**
+ * @brief Copies the byte and call counters of a connection.
+ *
+ * @param conn The connection.
+ * @param stats Pointer to store the counters.
+ */
+void reactor_conn_get_stats(const ReactorConnection* conn, ConnectionStats* stats);
+
+/**
+ * @brief Attaches application state to a connection.
+ */
+void reactor_conn_set_user_data(ReactorConnection* conn, void* user_data);
+
+/**
+ * @brief Returns the application state attached with reactor_conn_set_user_data.
+ */
+void* reactor_conn_get_user_data(const ReactorConnection* conn);
+
+// -----------------------------------
+// Framing Module Function Declarations
+// -----------------------------------
+
+// Size of the serialized frame header on the wire
+#define SECURE_FRAME_HEADER_SIZE 8
+
+// Default upper bound on a single frame payload
+#define SECURE_FRAME_DEFAULT_MAX_PAYLOAD (16u * 1024u * 1024u)
+
+/**
+ * @brief Frame types carried in FrameHeader.type.
+ */
+typedef enum {
+    FRAME_TYPE_DATA = 1,    // Encrypted application message: IV || tag || ciphertext
+    FRAME_TYPE_STREAM = 2,  // Chunk of a compressed, encrypted stream (see PipelineWriter)
+    FRAME_TYPE_HELLO = 3,   // Cipher suite negotiation, sent once before any record (see cipher_hello_encode)
+    FRAME_TYPE_TICKET = 4,  // Session resumption ticket (see session_table_issue_ticket)
+    FRAME_TYPE_GROUP_KEY = 5, // Record sealed under the session key carrying a broadcast group key
+    FRAME_TYPE_MUX = 6      // Record carrying one frame of a multiplexed stream (see MuxConnection)
+} FrameType;
+
+// FRAME_TYPE_STREAM flag: last record of the stream
+#define FRAME_FLAG_END 0x01
+
+// FRAME_TYPE_DATA flag: sealed under the broadcast group key instead of the session key
+#define FRAME_FLAG_GROUP 0x02
+
+/**
+ * @brief Frame header. Serialized as length (4) | type (1) | flags (1) | codec (1) | suite (1),
+ *        with the length in network byte order.
+ */
+typedef struct {
+    uint32_t length;    // Payload length in bytes (header not included)
+    uint8_t type;       // One of FrameType
+    uint8_t flags;      // Type-specific flags
+    uint8_t codec;      // CompressionCodecId of the payload (0 = not compressed)
+    uint8_t suite;      // CipherSuite the record is sealed with (0 = AES-256-GCM)
+} FrameHeader;
+
+// Opaque structure for reassembling frames from a byte stream
+typedef struct FrameDecoder FrameDecoder;
+
+/**
+ * @brief Serializes a frame header into its 8-byte wire form.
+ *
+ * @param header The header to encode.
+ * @param out Buffer of at least SECURE_FRAME_HEADER_SIZE bytes.
+ */
+void frame_encode_header(const FrameHeader* header, unsigned char* out);
+
+/**
+ * @brief Parses an 8-byte wire header.
+ *
+ * @param in Buffer of at least SECURE_FRAME_HEADER_SIZE bytes.
+ * @param header Pointer to store the decoded header.
+ */
+void frame_decode_header(const unsigned char* in, FrameHeader* header);
+
+/**
+ * @brief Appends one complete frame (header + payload) to a batch buffer.
+ *
+ * @param buffer Destination buffer.
+ * @param capacity Size of the destination buffer.
+ * @param used In: bytes already in the buffer. Out: bytes after appending.
+ * @param type Frame type (FRAME_TYPE_*).
+ * @param flags Frame flags.
+ * @param payload Payload bytes (may be NULL when len is 0).
+ * @param len Payload length in bytes.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or SECURE_COMM_ERR_MEMORY if the frame does not fit.
+ */
+SecureCommError frame_append(unsigned char* buffer, size_t capacity, size_t* used,
+                             uint8_t type, uint8_t flags,
+                             const void* payload, size_t len);
+
+/**
+ * @brief Sends an entire buffer on a blocking socket, retrying short writes.
+ *
+ * @param fd Connected socket.
+ * @param data Bytes to send.
+ * @param len Number of bytes to send.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or SECURE_COMM_ERR_SEND on failure.
+ */
+SecureCommError frame_send_all(int fd, const void* data, size_t len);
+
+/**
+ * @brief Creates a frame decoder backed by a ring buffer.
+ *
+ * @param capacity Ring size in bytes (rounded up to a power of two and to one maximum frame).
+ * @param max_payload Largest payload accepted before the stream is declared malformed.
+ * @param decoder Pointer to store the created FrameDecoder.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError frame_decoder_create(size_t capacity, size_t max_payload, FrameDecoder** decoder);
+
+/**
+ * @brief Returns the contiguous free region at the ring's write position, for recv().
+ *
+ * @param decoder The decoder.
+ * @param ptr Pointer to store the start of the free region.
+ * @param len Pointer to store its length (0 when the ring is full).
+ */
+void frame_decoder_write_space(FrameDecoder* decoder, unsigned char** ptr, size_t* len);
+
+/**
+ * @brief Marks bytes written into the region from frame_decoder_write_space as valid.
+ *
+ * @param decoder The decoder.
+ * @param len Number of bytes written.
+ */
+void frame_decoder_commit(FrameDecoder* decoder, size_t len);
+
+/**
+ * @brief Copies received bytes into the decoder.
+ *
+ * @param decoder The decoder.
+ * @param data Bytes read from the socket.
+ * @param len Number of bytes.
+ * @param consumed Pointer to store how many bytes fit (less than len if the ring is full).
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError frame_decoder_feed(FrameDecoder* decoder, const void* data, size_t len, size_t* consumed);
+
+/**
+ * @brief Extracts the next complete frame, if one is buffered.
+ *
+ * @param decoder The decoder.
+ * @param header Pointer to store the frame header.
+ * @param payload Buffer receiving the payload.
+ * @param payload_cap Size of the payload buffer.
+ *
+ * @return SECURE_COMM_SUCCESS when a frame was extracted, SECURE_COMM_ERR_AGAIN when more
+ *         bytes are needed, or SECURE_COMM_ERR_FRAME if the stream is malformed.
+ */
+SecureCommError frame_decoder_next(FrameDecoder* decoder, FrameHeader* header,
+                                   unsigned char* payload, size_t payload_cap);
+
+/**
+ * @brief Extracts the next complete frame into a buffer sized to its payload.
+ *
+ * @param decoder The decoder.
+ * @param pool Pool to take the payload buffer from, or NULL for the default pool.
+ * @param header Pointer to store the frame header.
+ * @param payload Pointer to store the payload buffer (one reference, owned by the caller).
+ *
+ * @return SECURE_COMM_SUCCESS when a frame was extracted, SECURE_COMM_ERR_AGAIN when more
+ *         bytes are needed, SECURE_COMM_ERR_FRAME if the stream is malformed, or
+ *         SECURE_COMM_ERR_MEMORY if no buffer could be taken.
+ */
+SecureCommError frame_decoder_next_buffer(FrameDecoder* decoder, BufferPool* pool, FrameHeader* header,
+                                          SecureBuffer** payload);
+
+/**
+ * @brief Returns the number of buffered, not yet extracted bytes.
+ */
+size_t frame_decoder_buffered(const FrameDecoder* decoder);
+
+/**
+ * @brief Destroys a frame decoder.
+ *
+ * @param decoder The decoder to destroy.
+ */
+void frame_decoder_destroy(FrameDecoder* decoder);
+
+/**
+ * @brief Encrypts data using AES-GCM (Authenticated Encryption).
+ *
+ * This function encrypts the input data using AES-GCM encryption.
+ *
+ * @param plaintext Pointer to the data to encrypt.
+ * @param plaintext_len Length of the plaintext in bytes.
+ * @param key Pointer to the encryption key (16, 24, or 32 bytes for AES-128, AES-192, AES-256).
+ * @param iv Pointer to the 12-byte Initialization Vector (randomly generated).
+ * @param ciphertext Pointer to the buffer where encrypted data will be stored.
+ * @param ciphertext_len Pointer to store the length of the ciphertext.
+ * @param tag Pointer to store the authentication tag (16 bytes).
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError encrypt_data(const unsigned char* plaintext, int plaintext_len,
+                             const unsigned char* key, unsigned char* iv,
+                             unsigned char* ciphertext, int* ciphertext_len,
+                             unsigned char* tag);
+
+/**
+ * @brief Decrypts data using AES-GCM (Authenticated Encryption).
+ *
+ * This function decrypts the input data using AES-GCM decryption.
+ *
+ * @param ciphertext Pointer to the data to decrypt.
+ * @param ciphertext_len Length of the ciphertext in bytes.
+ * @param key Pointer to the decryption key (must be the same as encryption key).
+ * @param iv Pointer to the 12-byte Initialization Vector (must be the same as used in encryption).
+ * @param plaintext Pointer to the buffer where decrypted data will be stored.
+ * @param plaintext_len Pointer to store the length of the plaintext.
+ * @param tag Pointer to the authentication tag (16 bytes, same as used during encryption).
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError decrypt_data(const unsigned char* ciphertext, int ciphertext_len,
+                             const unsigned char* key, const unsigned char* iv,
+                             unsigned char* plaintext, int* plaintext_len,
+                             const unsigned char* tag);
+
+// Opaque structure for a keyed, reusable AEAD cipher (AES-GCM or ChaCha20-Poly1305)
+typedef struct SecureCipher SecureCipher;
+
+/**
+ * @brief AEAD cipher suites. The value is carried in FrameHeader.suite.
+ *
+ * Both suites use a 12-byte nonce and a 16-byte tag, so records have the same
+ * layout (IV || tag || ciphertext) whichever suite sealed them.
+ */
+typedef enum {
+    CIPHER_SUITE_AES_GCM = 0,           // AES-GCM (AES-256-GCM for session keys); fast with AES instructions
+    CIPHER_SUITE_CHACHA20_POLY1305 = 1, // ChaCha20-Poly1305 (RFC 8439); fast on CPUs without AES instructions
+    CIPHER_SUITE_COUNT
+} CipherSuite;
+
+// Bit for a suite in a supported-suites mask
+#define CIPHER_SUITE_MASK(suite) (1u << (suite))
+
+// Version byte of the FRAME_TYPE_HELLO payload
+#define SECURE_HELLO_VERSION 2
+
+// Size of the random value each side puts in its HELLO
+#define SECURE_HELLO_RANDOM_SIZE 16
+
+// Size of the FRAME_TYPE_HELLO payload: version (1) | supported mask (1) | suite (1) | random (16)
+#define SECURE_HELLO_SIZE (3 + SECURE_HELLO_RANDOM_SIZE)
+
+// Size of the per-connection salt: client random || server random
+#define SECURE_CONNECTION_SALT_SIZE (2 * SECURE_HELLO_RANDOM_SIZE)
+
+// cipher_derive_key label of the key a connection's records are sealed with
+#define SECURE_CONNECTION_KEY_LABEL "cipherlink connection key"
+
+// cipher_derive_key label of the session key set up by a full handshake and kept in
+// resumption tickets; connection keys of resumed connections are derived from it
+#define SECURE_SESSION_KEY_LABEL "cipherlink session key"
+
+/**
+ * @brief Creates a keyed AES-GCM cipher handle for a session.
+ *
+ * The key schedule and EVP contexts are set up once; each message only resets the IV.
+ * One thread may encrypt while another decrypts with the same handle.
+ *
+ * @param key Pointer to the key (16, 24, or 32 bytes for AES-128, AES-192, AES-256).
+ * @param key_len Length of the key in bytes.
+ * @param cipher Pointer to store the created SecureCipher.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError cipher_create(const unsigned char* key, size_t key_len, SecureCipher** cipher);
+
+/**
+ * @brief Creates a keyed cipher handle for a given suite.
+ *
+ * cipher_create is cipher_create_suite with CIPHER_SUITE_AES_GCM.
+ *
+ * @param suite The AEAD suite to use.
+ * @param key Pointer to the key (32 bytes for ChaCha20-Poly1305; 16, 24 or 32 for AES-GCM).
+ * @param key_len Length of the key in bytes.
+ * @param cipher Pointer to store the created SecureCipher.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError cipher_create_suite(CipherSuite suite, const unsigned char* key, size_t key_len,
+                                    SecureCipher** cipher);
+
+/**
+ * @brief Returns the suite a cipher handle was created with.
+ */
+CipherSuite cipher_get_suite(const SecureCipher* cipher);
+
+/**
+ * @brief Returns a printable name for a suite ("aes-256-gcm", "chacha20-poly1305").
+ */
+const char* cipher_suite_name(CipherSuite suite);
+
+/**
+ * @brief Parses a suite name as printed by cipher_suite_name ("aes" and "chacha20" also work).
+ *
+ * @param name The name to parse.
+ * @param suite Pointer to store the suite.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or SECURE_COMM_ERR_INIT for an unknown name.
+ */
+SecureCommError cipher_suite_from_name(const char* name, CipherSuite* suite);
+
+/**
+ * @brief Returns the CIPHER_SUITE_MASK bits of every suite the linked OpenSSL provides.
+ */
+unsigned int cipher_suite_supported_mask(void);
+
+/**
+ * @brief Picks the fastest suite for this CPU.
+ *
+ * AES-GCM when the CPU has AES instructions (AES-NI on x86, the ARMv8 crypto
+ * extension on aarch64), otherwise ChaCha20-Poly1305. Detected once per process.
+ *
+ * @return The preferred suite.
+ */
+CipherSuite cipher_suite_preferred(void);
+
+/**
+ * @brief Chooses the suite for a connection from the peer's HELLO.
+ *
+ * The client's preferred suite wins when both sides support it, since the
+ * client is the side that may lack AES instructions. Otherwise the first suite
+ * both support is used.
+ *
+ * @param peer_mask Suites the peer supports (CIPHER_SUITE_MASK bits).
+ * @param peer_preferred Suite the peer asked for.
+ *
+ * @return The chosen suite, or CIPHER_SUITE_COUNT if the two sides share none.
+ */
+CipherSuite cipher_suite_negotiate(unsigned int peer_mask, CipherSuite peer_preferred);
+
+/**
+ * @brief Serializes a FRAME_TYPE_HELLO payload.
+ *
+ * The client sends its supported mask and preferred suite; the server answers
+ * with its own mask and the chosen suite. Both add a fresh random value, and the
+ * two randoms form the salt of the connection key (see cipher_derive_key).
+ *
+ * @param mask Supported suites (CIPHER_SUITE_MASK bits).
+ * @param suite Preferred (client) or chosen (server) suite.
+ * @param random SECURE_HELLO_RANDOM_SIZE random bytes chosen by the sender.
+ * @param out Buffer of at least SECURE_HELLO_SIZE bytes.
+ */
+void cipher_hello_encode(unsigned int mask, CipherSuite suite, const unsigned char* random, unsigned char* out);
+
+/**
+ * @brief Parses a FRAME_TYPE_HELLO payload.
+ *
+ * @param in The payload.
+ * @param len Payload length in bytes.
+ * @param mask Pointer to store the supported suites.
+ * @param suite Pointer to store the preferred or chosen suite.
+ * @param random Optional buffer of SECURE_HELLO_RANDOM_SIZE bytes for the sender's random.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or SECURE_COMM_ERR_FRAME for a malformed payload.
+ */
+SecureCommError cipher_hello_decode(const unsigned char* in, size_t len, unsigned int* mask, CipherSuite* suite,
+                                    unsigned char* random);
+
+/**
+ * @brief Client side of suite negotiation on a blocking connection.
+ *
+ * Sends a HELLO with this process's supported suites and a preferred suite, then
+ * waits for the server's answer. Call right after connecting, before any record.
+ *
+ * @param conn The connection.
+ * @param preferred Suite to ask for (usually cipher_suite_preferred()).
+ * @param suite Pointer to store the suite chosen by the server.
+ * @param salt Buffer of SECURE_CONNECTION_SALT_SIZE bytes for the connection salt.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError cipher_negotiate_client(SecureConnection* conn, CipherSuite preferred, CipherSuite* suite,
+                                        unsigned char* salt);
+
+/**
+ * @brief Server side of suite negotiation on a blocking connection.
+ *
+ * Waits for the client's HELLO, picks the suite with cipher_suite_negotiate and
+ * answers with it.
+ *
+ * @param conn The connection.
+ * @param suite Pointer to store the chosen suite.
+ * @param salt Buffer of SECURE_CONNECTION_SALT_SIZE bytes for the connection salt.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError cipher_negotiate_server(SecureConnection* conn, CipherSuite* suite, unsigned char* salt);
+
+/**
+ * @brief Encrypts one message with a keyed cipher handle (same contract as encrypt_data).
+ *
+ * @param cipher The cipher handle created with cipher_create.
+ * @param plaintext Pointer to the data to encrypt.
+ * @param plaintext_len Length of the plaintext in bytes.
+ * @param iv Pointer to the 12-byte buffer that receives the IV.
+ * @param ciphertext Pointer to the buffer where encrypted data will be stored.
+ * @param ciphertext_len Pointer to store the length of the ciphertext.
+ * @param tag Pointer to store the authentication tag (16 bytes).
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError cipher_encrypt(SecureCipher* cipher,
+                               const unsigned char* plaintext, int plaintext_len,
+                               unsigned char* iv,
+                               unsigned char* ciphertext, int* ciphertext_len,
+                               unsigned char* tag);
+
+/**
+ * @brief Decrypts one message with a keyed cipher handle (same contract as decrypt_data).
+ *
+ * @param cipher The cipher handle created with cipher_create.
+ * @param ciphertext Pointer to the data to decrypt.
+ * @param ciphertext_len Length of the ciphertext in bytes.
+ * @param iv Pointer to the 12-byte IV used during encryption.
+ * @param plaintext Pointer to the buffer where decrypted data will be stored.
+ * @param plaintext_len Pointer to store the length of the plaintext.
+ * @param tag Pointer to the authentication tag (16 bytes).
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError cipher_decrypt(SecureCipher* cipher,
+                               const unsigned char* ciphertext, int ciphertext_len,
+                               const unsigned char* iv,
+                               unsigned char* plaintext, int* plaintext_len,
+                               const unsigned char* tag);
+
+/**
+ * @brief Destroys a cipher handle and wipes its key material.
+ *
+ * @param cipher The cipher handle to destroy.
+ */
+void cipher_destroy(SecureCipher* cipher);
+
+// Size of the fixed (salt) field at the start of a counter-based nonce
+#define SECURE_NONCE_SALT_SIZE 4
+
+// Opaque structure for a counter-based GCM nonce generator
+typedef struct NonceGenerator NonceGenerator;
+
+/**
+ * @brief Sliding window used by receivers to reject replayed sequence numbers.
+ */
+typedef struct {
+    uint64_t highest;   // Highest sequence number accepted so far
+    uint64_t bitmap;    // Bit i set if (highest - i) was accepted
+    int initialized;    // Whether any sequence number has been accepted
+} ReplayWindow;
+
+/**
+ * @brief Creates a counter-based GCM nonce generator (RFC 5116, section 3.2).
+ *
+ * Nonces are salt (4 bytes) || counter (8 bytes, big-endian) and are handed out
+ * without a syscall or DRBG lock.
+ *
+ * @param salt Optional 4-byte fixed field. If NULL, a random salt is generated.
+ * @param gen Pointer to store the created NonceGenerator.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError nonce_generator_create(const unsigned char* salt, NonceGenerator** gen);
+
+/**
+ * @brief Produces the next unique 12-byte nonce. Safe to call from any thread.
+ *
+ * @param gen The nonce generator.
+ * @param iv Pointer to the 12-byte buffer that receives the nonce.
+ * @param sequence Optional pointer to store the counter value used.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or SECURE_COMM_ERR_ENCRYPT once the counter
+ *         would wrap around.
+ */
+SecureCommError nonce_generator_next(NonceGenerator* gen, unsigned char* iv, uint64_t* sequence);
+
+/**
+ * @brief Destroys a nonce generator.
+ *
+ * @param gen The nonce generator to destroy.
+ */
+void nonce_generator_destroy(NonceGenerator* gen);
+
+/**
+ * @brief Extracts the counter from a nonce produced by a NonceGenerator.
+ *
+ * @param iv Pointer to the 12-byte nonce.
+ *
+ * @return The 64-bit message sequence number.
+ */
+uint64_t nonce_sequence(const unsigned char* iv);
+
+/**
+ * @brief Resets a replay window so that any first sequence number is accepted.
+ *
+ * @param window The window to initialize.
+ */
+void replay_window_init(ReplayWindow* window);
+
+/**
+ * @brief Accepts or rejects an authenticated sequence number.
+ *
+ * Call only after the message has been decrypted successfully.
+ *
+ * @param window The receiver's replay window.
+ * @param sequence Sequence number taken from the message nonce.
+ *
+ * @return SECURE_COMM_SUCCESS if the message is new, or SECURE_COMM_ERR_DECRYPT for a replay.
+ */
+SecureCommError replay_window_accept(ReplayWindow* window, uint64_t sequence);
+
+/**
+ * @brief Derives a key from another with HKDF-SHA256 (RFC 5869).
+ *
+ * Used to give every connection its own key: counter nonces only stay unique
+ * under one key, so they must never be used directly with a key shared by
+ * several connections.
+ *
+ * @param key Input key material.
+ * @param key_len Length of the input key in bytes.
+ * @param salt Salt, e.g. the connection salt from the HELLO exchange.
+ * @param salt_len Length of the salt in bytes.
+ * @param label Context string that separates keys derived for different purposes.
+ * @param out Buffer that receives the derived key. May be the same buffer as key.
+ * @param out_len Number of bytes to derive.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or SECURE_COMM_ERR_ENCRYPT on failure.
+ */
+SecureCommError cipher_derive_key(const unsigned char* key, size_t key_len, const unsigned char* salt, size_t salt_len,
+                                  const char* label, unsigned char* out, size_t out_len);
+
+/**
+ * @brief Switches a cipher handle from random IVs to counter-based nonces.
+ *
+ * Each direction that shares a key must use a distinct salt, and the key itself
+ * must belong to one connection (see cipher_derive_key).
+ *
+ * @param cipher The cipher handle.
+ * @param salt Optional 4-byte fixed field. If NULL, a random salt is generated.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError cipher_use_counter_nonces(SecureCipher* cipher, const unsigned char* salt);
+
+// Bytes added to every record by either suite: IV (12) || tag (16)
+#define SECURE_RECORD_OVERHEAD (12 + 16)
+
+/**
+ * @brief Encrypts a record in place: IV || tag || payload inside one buffer.
+ *
+ * The caller writes the plaintext at record + SECURE_RECORD_OVERHEAD. It is
+ * encrypted where it lies, and the IV and tag are written into the headroom in
+ * front of it, so a frame buffer goes out with no further copies.
+ *
+ * @param cipher The cipher handle.
+ * @param record Buffer of at least SECURE_RECORD_OVERHEAD + payload_len bytes.
+ * @param payload_len Plaintext length at record + SECURE_RECORD_OVERHEAD.
+ * @param record_len Pointer to store the sealed record length.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or SECURE_COMM_ERR_ENCRYPT on failure.
+ */
+SecureCommError cipher_seal_record(SecureCipher* cipher, unsigned char* record, size_t payload_len,
+                                   size_t* record_len);
+
+/**
+ * @brief Authenticates and decrypts an IV || tag || ciphertext record in place.
+ *
+ * On success the plaintext replaces the ciphertext at record + SECURE_RECORD_OVERHEAD.
+ * On failure the payload bytes are unspecified and must be discarded.
+ *
+ * @param cipher The cipher handle.
+ * @param record The received record.
+ * @param record_len Record length in bytes.
+ * @param payload Pointer to store the start of the plaintext inside record.
+ * @param payload_len Pointer to store the plaintext length.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or SECURE_COMM_ERR_DECRYPT if the record is
+ *         too short or fails authentication.
+ */
+SecureCommError cipher_open_record(SecureCipher* cipher, unsigned char* record, size_t record_len,
+                                   unsigned char** payload, size_t* payload_len);
+
+/**
+ * @brief Seals a pool buffer in place (see cipher_seal_record).
+ *
+ * The buffer's valid bytes are SECURE_RECORD_OVERHEAD bytes of headroom followed by
+ * the plaintext; afterwards they are the IV || tag || ciphertext record.
+ *
+ * @param cipher The cipher handle.
+ * @param buffer The buffer to seal.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or SECURE_COMM_ERR_ENCRYPT on failure.
+ */
+SecureCommError cipher_seal_buffer(SecureCipher* cipher, SecureBuffer* buffer);
+
+/**
+ * @brief Opens an IV || tag || ciphertext pool buffer in place (see cipher_open_record).
+ *
+ * On success the buffer is advanced past IV || tag, so its valid bytes are the
+ * plaintext; the IV stays readable just before secure_buffer_data.
+ *
+ * @param cipher The cipher handle.
+ * @param buffer The received record.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or SECURE_COMM_ERR_DECRYPT if the record is
+ *         too short or fails authentication.
+ */
+SecureCommError cipher_open_buffer(SecureCipher* cipher, SecureBuffer* buffer);
+
+/**
+ * @brief One message in an encrypt_data_batch / decrypt_data_batch call.
+ *
+ * Output has the same length as input (neither suite adds padding).
+ */
+typedef struct {
+    SecureCipher* cipher;       // Keyed handle of the recipient / sender
+    const unsigned char* input; // Plaintext (encrypt) or ciphertext (decrypt); may be shared by many items
+    size_t input_len;           // Length of input in bytes
+    unsigned char* output;      // Ciphertext (encrypt) or plaintext (decrypt), input_len bytes
+    unsigned char* iv;          // 12-byte IV: written when encrypting, read when decrypting
+    unsigned char* tag;         // 16-byte tag: written when encrypting, read when decrypting
+    SecureCommError status;     // Per-item result
+} AeadBatchItem;
+
+// Batches carrying at least this many bytes are split across threads
+#define SECURE_AEAD_BATCH_PARALLEL_BYTES (1024 * 1024)
+
+// Upper bound on the threads used for one batch
+#define SECURE_AEAD_BATCH_MAX_THREADS 8
+
+/**
+ * @brief Encrypts many messages, each under its own cipher handle, in one call.
+ *
+ * Meant for fan-out: the same broadcast sealed for many recipients. Items that
+ * share a handle are processed in order on the same thread, so counter nonces
+ * stay monotonic per handle. Large batches are spread over up to
+ * SECURE_AEAD_BATCH_MAX_THREADS threads.
+ *
+ * @param items Messages to encrypt; each item's status is set.
+ * @param count Number of items.
+ * @param failures Optional pointer to store how many items failed.
+ *
+ * @return SECURE_COMM_SUCCESS if every item succeeded, or SECURE_COMM_ERR_ENCRYPT otherwise.
+ */
+SecureCommError encrypt_data_batch(AeadBatchItem* items, size_t count, size_t* failures);
+
+/**
+ * @brief Authenticates and decrypts many messages in one call.
+ *
+ * Same scheduling as encrypt_data_batch. Items that fail authentication get
+ * SECURE_COMM_ERR_DECRYPT in their status; the others are still decrypted.
+ *
+ * @param items Messages to decrypt; each item's status is set.
+ * @param count Number of items.
+ * @param failures Optional pointer to store how many items failed.
+ *
+ * @return SECURE_COMM_SUCCESS if every item succeeded, or SECURE_COMM_ERR_DECRYPT otherwise.
+ */
+SecureCommError decrypt_data_batch(AeadBatchItem* items, size_t count, size_t* failures);
+
+/**
+ * @brief Compresses data using zlib (deflate) into a caller-provided buffer.
+ *
+ * @param input Pointer to the data to compress.
+ * @param input_len Length of the input data in bytes.
+ * @param compressed Buffer for the compressed data.
+ * @param compressed_len In: size of the buffer. Out: length of the compressed data.
+ * @param level Compression level (0-9).
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError compress_data(const unsigned char* input, size_t input_len,
+                              unsigned char* compressed, size_t* compressed_len,
+                              int level);
+
+/**
+ * @brief Decompresses data using zlib (inflate) into a caller-provided buffer.
+ *
+ * @param compressed Pointer to the data to decompress.
+ * @param compressed_len Length of the compressed data in bytes.
+ * @param output Buffer for the decompressed data.
+ * @param output_len In: size of the buffer. Out: length of the decompressed data.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError decompress_data(const unsigned char* compressed, size_t compressed_len,
+                                unsigned char* output, size_t* output_len);
+
+/**
+ * @brief Compresses data using zlib (deflate) with dynamic buffer allocation.
+ *
+ * This function compresses the input data using the deflate algorithm provided by zlib.
+ * It dynamically allocates memory for the compressed data, which must be freed by the caller.
+ *
+ * @param input Pointer to the data to compress.
+ * @param input_len Length of the input data in bytes.
+ * @param compressed_ptr Pointer to store the pointer to the compressed data buffer.
+ * @param compressed_len Pointer to store the length of the compressed data.
+ * @param level Compression level (0-9), or Z_DEFAULT_COMPRESSION (-1) for zlib's default.
+ *              0 = no compression, 9 = maximum compression.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError compress_data_dynamic(const unsigned char* input, size_t input_len,
+                                      unsigned char** compressed_ptr, size_t* compressed_len,
+                                      int level);
+
+/**
+ * @brief Decompresses data using zlib (inflate) with dynamic buffer allocation.
+ *
+ * This function decompresses the input data using the inflate algorithm provided by zlib.
+ * It dynamically allocates memory for the decompressed data, which must be freed by the caller.
+ *
+ * @param compressed Pointer to the data to decompress.
+ * @param compressed_len Length of the compressed data in bytes.
+ * @param output_ptr Pointer to store the pointer to the decompressed data buffer.
+ * @param output_len Pointer to store the length of the decompressed data.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError decompress_data_dynamic(const unsigned char* compressed, size_t compressed_len,
+                                        unsigned char** output_ptr, size_t* output_len);
+
+/**
+ * @brief zlib stream pool counters.
+ *
+ * compress_data, decompress_data and their _dynamic variants borrow a per-thread z_stream
+ * that is reset between calls instead of being initialized and torn down every time.
+ */
+typedef struct {
+    uint64_t stream_inits;      // Streams initialized (at most one per level and thread)
+    uint64_t stream_reuses;     // Calls served by an already initialized stream
+    uint64_t zlib_allocs;       // Allocations made by zlib itself
+    uint64_t zlib_alloc_bytes;  // Bytes requested by those allocations
+} CompressionStats;
+
+/**
+ * @brief Reports the zlib stream pool counters.
+ *
+ * @param stats Pointer to store the counters.
+ */
+void compression_get_stats(CompressionStats* stats);
+
+/**
+ * @brief Frees the calling thread's pooled zlib streams now instead of at thread exit.
+ */
+void compression_release_thread_pool(void);
+
+// Default upper bound on decompressed output (decompression bomb guard)
+#define SECURE_DECOMPRESS_DEFAULT_MAX_OUTPUT (64u * 1024u * 1024u)
+
+/**
+ * @brief Decompresses data into a buffer that grows as needed, up to a limit.
+ *
+ * The buffer starts at size_hint when the original length is known (e.g. carried in a
+ * frame header) and otherwise grows geometrically while inflate runs.
+ *
+ * @param compressed Pointer to the data to decompress.
+ * @param compressed_len Length of the compressed data in bytes.
+ * @param size_hint Expected decompressed length, or 0 if unknown.
+ * @param max_output Largest decompressed size accepted, or 0 for SECURE_DECOMPRESS_DEFAULT_MAX_OUTPUT.
+ * @param output_ptr Pointer to store the pointer to the decompressed data buffer (caller frees).
+ * @param output_len Pointer to store the length of the decompressed data.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure
+ *         (SECURE_COMM_ERR_DECOMPRESS if the output would exceed max_output).
+ */
+SecureCommError decompress_data_dynamic_ex(const unsigned char* compressed, size_t compressed_len,
+                                           size_t size_hint, size_t max_output,
+                                           unsigned char** output_ptr, size_t* output_len);
+
+/**
+ * @brief Compresses data into a buffer taken from a pool.
+ *
+ * @param pool Pool to take the output from, or NULL for the default pool.
+ * @param input Pointer to the data to compress.
+ * @param input_len Length of the input data in bytes.
+ * @param level Compression level (0-9).
+ * @param output Pointer to store the compressed buffer (one reference, owned by the caller).
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError compress_data_pooled(BufferPool* pool, const unsigned char* input, size_t input_len,
+                                     int level, SecureBuffer** output);
+
+/**
+ * @brief Decompresses data into a buffer taken from a pool (same limits as decompress_data_dynamic_ex).
+ *
+ * @param pool Pool to take the output from, or NULL for the default pool.
+ * @param compressed Pointer to the data to decompress.
+ * @param compressed_len Length of the compressed data in bytes.
+ * @param size_hint Expected decompressed length, or 0 if unknown.
+ * @param max_output Largest decompressed size accepted, or 0 for SECURE_DECOMPRESS_DEFAULT_MAX_OUTPUT.
+ * @param output Pointer to store the decompressed buffer (one reference, owned by the caller).
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError decompress_data_pooled(BufferPool* pool, const unsigned char* compressed, size_t compressed_len,
+                                       size_t size_hint, size_t max_output, SecureBuffer** output);
+
+// compress_data_dynamic switches to compress_data_parallel from this input size on
+#define SECURE_PARALLEL_COMPRESS_MIN_BYTES (4u * 1024u * 1024u)
+
+// Largest block compress_data_parallel uses; its index stores 32-bit lengths
+#define SECURE_PARALLEL_COMPRESS_MAX_BLOCK (16u * 1024u * 1024u)
+
+/**
+ * @brief Parameters for compress_data_parallel. Initialize with parallel_compression_config_defaults.
+ */
+typedef struct {
+    int level;                  // Compression level (0-9, or -1 for zlib's default)
+    size_t block_size;          // Input bytes per block (32 KB to SECURE_PARALLEL_COMPRESS_MAX_BLOCK)
+    int prime_dictionary;       // Non-zero primes each block with the previous 32 KB for a better ratio
+    WorkerPool* pool;           // Pool the blocks run on, or NULL for worker_pool_default()
+} ParallelCompressionConfig;
+
+/**
+ * @brief Fills a ParallelCompressionConfig with the defaults (level 6, 128 KB blocks, primed).
+ *
+ * @param config The configuration to fill.
+ */
+void parallel_compression_config_defaults(ParallelCompressionConfig* config);
+
+/**
+ * @brief Compresses large data in blocks on the worker pool, as pigz does.
+ *
+ * Each block is deflated on its own and ended on a byte boundary. The blocks are
+ * joined behind one zlib header and Adler-32 trailer, so any inflater, including
+ * decompress_data_dynamic, reads the result as a single stream.
+ *
+ * When index_ptr is given, the blocks are not primed, so none refers back into
+ * another, and a block index is returned for decompress_data_parallel.
+ *
+ * @param input Pointer to the data to compress.
+ * @param input_len Length of the input data in bytes.
+ * @param config Block size, level and pool, or NULL for the defaults.
+ * @param compressed_ptr Pointer to store the compressed data (caller frees).
+ * @param compressed_len Pointer to store the length of the compressed data.
+ * @param index_ptr Optional pointer to store the block index (caller frees), or NULL.
+ * @param index_len Pointer to store the index length; NULL exactly when index_ptr is.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError compress_data_parallel(const unsigned char* input, size_t input_len,
+                                       const ParallelCompressionConfig* config,
+                                       unsigned char** compressed_ptr, size_t* compressed_len,
+                                       unsigned char** index_ptr, size_t* index_len);
+
+/**
+ * @brief Decompresses a compress_data_parallel stream, inflating its blocks in parallel.
+ *
+ * Needs the index from an unprimed compression. Without an index (index NULL)
+ * the stream is inflated serially, like decompress_data_dynamic_ex. The Adler-32
+ * trailer is checked either way.
+ *
+ * @param compressed Pointer to the zlib stream.
+ * @param compressed_len Length of the stream in bytes.
+ * @param index Block index from compress_data_parallel, or NULL.
+ * @param index_len Length of the index.
+ * @param max_output Largest decompressed size accepted, or 0 for SECURE_DECOMPRESS_DEFAULT_MAX_OUTPUT.
+ * @param pool Pool the blocks run on, or NULL for worker_pool_default().
+ * @param output_ptr Pointer to store the decompressed data (caller frees).
+ * @param output_len Pointer to store the length of the decompressed data.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError decompress_data_parallel(const unsigned char* compressed, size_t compressed_len,
+                                         const unsigned char* index, size_t index_len,
+                                         size_t max_output, WorkerPool* pool,
+                                         unsigned char** output_ptr, size_t* output_len);
+
+// -----------------------------------
+// Codec Module Function Declarations
+// -----------------------------------
+
+/**
+ * @brief Compression codec identifiers, carried in FrameHeader.codec.
+ *
+ * Values are part of the wire format and must never be renumbered.
+ */
+typedef enum {
+    COMPRESSION_CODEC_NONE = 0,     // Stored uncompressed
+    COMPRESSION_CODEC_ZLIB = 1,     // zlib deflate (always available)
+    COMPRESSION_CODEC_LZ4 = 2,      // Length-prefixed LZ4 block (SECURE_COMM_WITH_LZ4)
+    COMPRESSION_CODEC_ZSTD = 3,     // Zstandard (SECURE_COMM_WITH_ZSTD)
+    COMPRESSION_CODEC_MAX = 16      // Size of the codec registry
+} CompressionCodecId;
+
+/**
+ * @brief A compression backend registered with the codec registry.
+ *
+ * compress must succeed whenever the output buffer holds at least bound(input_len) bytes.
+ * decompress fails with SECURE_COMM_ERR_MEMORY if the output buffer is too small, so
+ * callers can retry with a larger one. A codec that knows the decompressed size also
+ * stores it in *output_len, and the retry is then made at exactly that size.
+ */
+typedef struct {
+    CompressionCodecId id;          // Wire identifier
+    const char* name;               // Name used in configuration files
+    int min_level;                  // Lowest accepted level
+    int max_level;                  // Highest accepted level
+    int default_level;              // Level used when the caller passes -1
+    size_t (*bound)(size_t input_len);
+    SecureCommError (*compress)(const unsigned char* input, size_t input_len,
+                                unsigned char* output, size_t* output_len, int level);
+    SecureCommError (*decompress)(const unsigned char* input, size_t input_len,
+                                  unsigned char* output, size_t* output_len);
+} CompressionCodec;
+
+/**
+ * @brief Registers a codec. Built-in codecs are registered automatically.
+ *
+ * @param codec Codec description (must stay valid for the life of the process).
+ *
+ * @return SECURE_COMM_SUCCESS on success, or SECURE_COMM_ERR_INIT if the id is invalid or taken.
+ */
+SecureCommError codec_register(const CompressionCodec* codec);
+
+/**
+ * @brief Looks up a codec by wire identifier.
+ *
+ * @return The codec, or NULL if it is not compiled in or registered.
+ */
+const CompressionCodec* codec_find(CompressionCodecId id);
+
+/**
+ * @brief Looks up a codec by name ("none", "zlib", "lz4", "zstd").
+ *
+ * @return The codec, or NULL if unknown.
+ */
+const CompressionCodec* codec_find_by_name(const char* name);
+
+/**
+ * @brief Returns a bitmask with bit N set for every available codec id N, to advertise to peers.
+ */
+uint32_t codec_supported_mask(void);
+
+/**
+ * @brief Picks the preferred codec available on both sides (Zstd, then LZ4, then zlib).
+ *
+ * @param local_mask Mask from codec_supported_mask on this side.
+ * @param peer_mask Mask advertised by the peer.
+ *
+ * @return The chosen codec id, or COMPRESSION_CODEC_NONE if nothing is shared.
+ */
+CompressionCodecId codec_negotiate(uint32_t local_mask, uint32_t peer_mask);
+
+/**
+ * @brief Compresses with the given codec into a newly allocated buffer.
+ *
+ * @param id Codec to use.
+ * @param input Pointer to the data to compress.
+ * @param input_len Length of the input data in bytes.
+ * @param output_ptr Pointer to store the compressed buffer (caller frees).
+ * @param output_len Pointer to store the compressed length.
+ * @param level Codec-specific level, or -1 for the codec default.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError codec_compress_dynamic(CompressionCodecId id,
+                                       const unsigned char* input, size_t input_len,
+                                       unsigned char** output_ptr, size_t* output_len,
+                                       int level);
+
+/**
+ * @brief Decompresses with the given codec into a newly allocated buffer.
+ *
+ * @param id Codec the data was compressed with (e.g. FrameHeader.codec).
+ * @param input Pointer to the compressed data.
+ * @param input_len Length of the compressed data.
+ * @param size_hint Expected decompressed length, or 0 if unknown.
+ * @param max_output Largest decompressed size accepted, or 0 for SECURE_DECOMPRESS_DEFAULT_MAX_OUTPUT.
+ * @param output_ptr Pointer to store the decompressed buffer (caller frees).
+ * @param output_len Pointer to store the decompressed length.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError codec_decompress_dynamic(CompressionCodecId id,
+                                         const unsigned char* input, size_t input_len,
+                                         size_t size_hint, size_t max_output,
+                                         unsigned char** output_ptr, size_t* output_len);
+
+/**
+ * @brief Compresses with the given codec into a buffer taken from a pool.
+ *
+ * @param id Codec to use.
+ * @param pool Pool to take the output from, or NULL for the default pool.
+ * @param input Pointer to the data to compress.
+ * @param input_len Length of the input data in bytes.
+ * @param level Codec-specific level, or -1 for the codec default.
+ * @param output Pointer to store the compressed buffer (one reference, owned by the caller).
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError codec_compress_pooled(CompressionCodecId id, BufferPool* pool,
+                                      const unsigned char* input, size_t input_len,
+                                      int level, SecureBuffer** output);
+
+/**
+ * @brief Decompresses with the given codec into a buffer taken from a pool.
+ *
+ * @param id Codec the data was compressed with.
+ * @param pool Pool to take the output from, or NULL for the default pool.
+ * @param input Pointer to the compressed data.
+ * @param input_len Length of the compressed data.
+ * @param size_hint Expected decompressed length, or 0 if unknown.
+ * @param max_output Largest decompressed size accepted, or 0 for the default limit.
+ * @param output Pointer to store the decompressed buffer (one reference, owned by the caller).
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError codec_decompress_pooled(CompressionCodecId id, BufferPool* pool,
+                                        const unsigned char* input, size_t input_len,
+                                        size_t size_hint, size_t max_output, SecureBuffer** output);
+
+/**
+ * @brief Decompresses with the given codec into a caller-provided buffer.
+ *
+ * @param id Codec the data was compressed with (e.g. FrameHeader.codec).
+ * @param input Pointer to the compressed data.
+ * @param input_len Length of the compressed data.
+ * @param output Buffer for the decompressed data.
+ * @param output_len In: size of output. Out: decompressed length.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError codec_decompress(CompressionCodecId id,
+                                 const unsigned char* input, size_t input_len,
+                                 unsigned char* output, size_t* output_len);
+
+/**
+ * @brief Loads a trained Zstd dictionary used by every later Zstd call (NULL clears it).
+ *
+ * Only available in builds configured with SECURE_COMM_WITH_ZSTD.
+ *
+ * @param dict Dictionary produced by `zstd --train`.
+ * @param dict_len Dictionary length.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError codec_zstd_set_dictionary(const void* dict, size_t dict_len);
+
+// -----------------------------------
+// Adaptive Compression Module Function Declarations
+// -----------------------------------
+
+/**
+ * @brief Strategy chosen for one payload.
+ */
+typedef enum {
+    COMPRESSION_DECISION_STORE = 0,     // Send uncompressed
+    COMPRESSION_DECISION_FAST,          // Cheap codec / level
+    COMPRESSION_DECISION_STRONG         // Slower, better ratio
+} CompressionDecision;
+
+/**
+ * @brief Tuning parameters for adaptive compression.
+ */
+typedef struct {
+    size_t min_size;                    // Payloads shorter than this are always stored
+    size_t sample_size;                 // Leading bytes sampled for the entropy estimate
+    double store_entropy;               // Bits/byte at or above which the payload is stored
+    double strong_entropy;              // Bits/byte at or below which the strong setting is used
+    CompressionCodecId fast_codec;      // Codec for COMPRESSION_DECISION_FAST
+    int fast_level;                     // Level for COMPRESSION_DECISION_FAST
+    CompressionCodecId strong_codec;    // Codec for COMPRESSION_DECISION_STRONG
+    int strong_level;                   // Level for COMPRESSION_DECISION_STRONG
+    double backoff_ratio;               // Average compressed/original ratio that triggers back-off
+    double ewma_alpha;                  // Weight of the newest ratio in the average (0-1]
+    unsigned int probe_interval;        // Messages stored during back-off before probing again
+} AdaptiveCompressionConfig;
+
+/**
+ * @brief Counters kept by an AdaptiveCompressor.
+ */
+typedef struct {
+    uint64_t messages;      // Payloads seen
+    uint64_t stored;        // Sent uncompressed
+    uint64_t fast;          // Compressed with the fast setting
+    uint64_t strong;        // Compressed with the strong setting
+    uint64_t bytes_in;      // Payload bytes seen
+    uint64_t bytes_out;     // Bytes after compression (stored payloads count in full)
+    double ratio_ewma;      // Current average compressed/original ratio
+} AdaptiveCompressionStats;
+
+// Opaque per-connection adaptive compression state
+typedef struct AdaptiveCompressor AdaptiveCompressor;
+
+/**
+ * @brief Fills an AdaptiveCompressionConfig with the defaults.
+ *
+ * @param config The configuration to fill.
+ */
+void adaptive_config_defaults(AdaptiveCompressionConfig* config);
+
+/**
+ * @brief Creates the per-connection state for adaptive compression.
+ *
+ * @param config Tuning parameters, or NULL for the defaults.
+ * @param compressor Pointer to store the created AdaptiveCompressor.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError adaptive_compressor_create(const AdaptiveCompressionConfig* config,
+                                           AdaptiveCompressor** compressor);
+
+/**
+ * @brief Estimates the Shannon entropy of a buffer in bits per byte (0-8).
+ */
+double estimate_entropy(const unsigned char* data, size_t len);
+
+/**
+ * @brief Decides how the next payload should be compressed.
+ *
+ * @param compressor The per-connection state.
+ * @param data Payload to send.
+ * @param len Payload length.
+ *
+ * @return The chosen strategy.
+ */
+CompressionDecision adaptive_choose(AdaptiveCompressor* compressor, const unsigned char* data, size_t len);
+
+/**
+ * @brief Compresses a payload with the strategy picked by adaptive_choose.
+ *
+ * When the payload is better sent as-is, *codec is COMPRESSION_CODEC_NONE, *output_len
+ * is 0 and the caller must send the input unchanged. The contents of output are then
+ * unspecified, since a compression attempt may already have written to it.
+ *
+ * @param compressor The per-connection state.
+ * @param input Payload to send.
+ * @param input_len Payload length.
+ * @param output Buffer for the compressed payload.
+ * @param output_len In: size of output. Out: compressed length (0 when stored).
+ * @param codec Pointer to store the codec to put in the frame header.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError adaptive_compress(AdaptiveCompressor* compressor,
+                                  const unsigned char* input, size_t input_len,
+                                  unsigned char* output, size_t* output_len,
+                                  CompressionCodecId* codec);
+
+/**
+ * @brief Returns the counters and the current ratio average.
+ */
+void adaptive_compressor_stats(const AdaptiveCompressor* compressor, AdaptiveCompressionStats* stats);
+
+/**
+ * @brief Destroys adaptive compression state.
+ */
+void adaptive_compressor_destroy(AdaptiveCompressor* compressor);
+
+// -----------------------------------
+// Pipeline Module Function Declarations
+// -----------------------------------
+
+// Default amount of compressed data sealed into one stream record
+#define SECURE_PIPELINE_DEFAULT_RECORD_SIZE (16u * 1024u)
+
+// Opaque structures for compress-then-encrypt streams
+typedef struct PipelineWriter PipelineWriter;
+typedef struct PipelineReader PipelineReader;
+
+/**
+ * @brief Receives each finished frame (header || IV || tag || ciphertext) from a PipelineWriter.
+ *
+ * The frame buffer is reused as soon as the callback returns.
+ */
+typedef SecureCommError (*pipeline_emit_cb)(const unsigned char* frame, size_t len, void* user_data);
+
+/**
+ * @brief Receives decompressed plaintext from a PipelineReader.
+ *
+ * Called with end_of_stream set (and len 0) once the whole stream has been verified.
+ */
+typedef SecureCommError (*pipeline_output_cb)(const unsigned char* data, size_t len,
+                                              int end_of_stream, void* user_data);
+
+/**
+ * @brief Creates a streaming compress-then-encrypt writer.
+ *
+ * Input fed with pipeline_writer_write is deflated through one long-lived z_stream and
+ * sealed into FRAME_TYPE_STREAM records holding at most record_size compressed bytes,
+ * so memory use is constant regardless of the stream length.
+ *
+ * @param cipher Keyed cipher used to seal records (not owned, must outlive the writer).
+ * @param level Compression level (0-9).
+ * @param record_size Maximum compressed bytes per record (0 for the default).
+ * @param emit Callback receiving each finished frame.
+ * @param user_data Passed to emit.
+ * @param writer Pointer to store the created PipelineWriter.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError pipeline_writer_create(SecureCipher* cipher, int level, size_t record_size,
+                                       pipeline_emit_cb emit, void* user_data,
+                                       PipelineWriter** writer);
+
+/**
+ * @brief Feeds a chunk of plaintext into the stream.
+ *
+ * Records are emitted whenever a full record of compressed output is available.
+ *
+ * @param writer The writer.
+ * @param data Plaintext bytes.
+ * @param len Number of bytes.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError pipeline_writer_write(PipelineWriter* writer, const void* data, size_t len);
+
+/**
+ * @brief Emits everything written so far without ending the stream (Z_SYNC_FLUSH).
+ *
+ * @param writer The writer.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError pipeline_writer_flush(PipelineWriter* writer);
+
+/**
+ * @brief Ends the stream and emits the final record, flagged FRAME_FLAG_END.
+ *
+ * The writer is reset afterwards and may be used for another stream.
+ *
+ * @param writer The writer.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError pipeline_writer_finish(PipelineWriter* writer);
+
+/**
+ * @brief Returns plaintext bytes consumed and frame bytes emitted by the writer.
+ */
+void pipeline_writer_stats(const PipelineWriter* writer, uint64_t* bytes_in, uint64_t* bytes_out);
+
+/**
+ * @brief Destroys a pipeline writer. Unfinished data is discarded.
+ */
+void pipeline_writer_destroy(PipelineWriter* writer);
+
+/**
+ * @brief Emit callback that sends frames on a blocking socket.
+ *
+ * @param user_data Pointer to the socket descriptor (int).
+ */
+SecureCommError pipeline_emit_socket(const unsigned char* frame, size_t len, void* user_data);
+
+/**
+ * @brief Creates the receiving side of a compress-then-encrypt stream.
+ *
+ * @param cipher Keyed cipher used to open records (not owned, must outlive the reader).
+ * @param replay Optional replay window checked for every record (NULL to skip).
+ * @param max_record Largest compressed record accepted (0 for the default).
+ * @param output Callback receiving decompressed plaintext.
+ * @param user_data Passed to output.
+ * @param reader Pointer to store the created PipelineReader.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError pipeline_reader_create(SecureCipher* cipher, ReplayWindow* replay, size_t max_record,
+                                       pipeline_output_cb output, void* user_data,
+                                       PipelineReader** reader);
+
+/**
+ * @brief Opens one FRAME_TYPE_STREAM record and delivers its plaintext.
+ *
+ * @param reader The reader.
+ * @param header Frame header returned by frame_decoder_next.
+ * @param record Frame payload (IV || tag || ciphertext).
+ * @param record_len Payload length.
+ *
+ * @return SECURE_COMM_SUCCESS on success, SECURE_COMM_ERR_FRAME for an unexpected record,
+ *         SECURE_COMM_ERR_DECRYPT if authentication or the replay check fails, or
+ *         SECURE_COMM_ERR_DECOMPRESS for a corrupt stream.
+ */
+SecureCommError pipeline_reader_push(PipelineReader* reader, const FrameHeader* header,
+                                     const unsigned char* record, size_t record_len);
+
+/**
+ * @brief Destroys a pipeline reader.
+ */
+void pipeline_reader_destroy(PipelineReader* reader);
+
+// -----------------------------------
+// File Transfer Function Declarations
+// -----------------------------------
+
+// Bytes of a file read, and flushed through the pipeline, at a time by secure_send_file
+#define SECURE_SEND_FILE_DEFAULT_WINDOW (4u * 1024u * 1024u)
+
+/**
+ * @brief Options for secure_send_file. Initialize with secure_file_send_options_defaults.
+ */
+typedef struct {
+    uint64_t offset;            // First byte of the file to send; resume point of an interrupted transfer
+    uint64_t length;            // Bytes to send from offset, or 0 for the rest of the file
+    SecureCipher* cipher;       // Seals the file as a FRAME_TYPE_STREAM pipeline stream; NULL sends raw bytes
+    int level;                  // Compression level of the pipeline stream (0-9)
+    size_t record_size;         // Compressed bytes per pipeline record (0 for the default)
+    size_t window_size;         // Bytes read at a time (0 for SECURE_SEND_FILE_DEFAULT_WINDOW)
+    int zero_copy;              // Non-zero lets raw sends use sendfile(2) or kTLS SSL_sendfile
+} SecureFileSendOptions;
+
+/**
+ * @brief Fills SecureFileSendOptions with the defaults: the whole file, sent raw, zero-copy allowed.
+ *
+ * @param options The options to fill.
+ */
+void secure_file_send_options_defaults(SecureFileSendOptions* options);
+
+/**
+ * @brief Sends a range of a file over the connection.
+ *
+ * With a cipher, the file is read window by window and streamed through a
+ * PipelineWriter (compressed, then sealed), read on the other side with a
+ * PipelineReader. Each window but the last is flushed, so *bytes_sent only counts
+ * bytes the peer can fully decode.
+ *
+ * Without a cipher the bytes are sent as they are, relying on the connection's TLS.
+ * Plain connections use sendfile(2). TLS connections use SSL_sendfile when kTLS is
+ * active (see networking_set_ktls), otherwise the file is read window by window and
+ * written with SSL_write.
+ *
+ * A file that shrinks while it is being sent ends the transfer with SECURE_COMM_ERR_SEND;
+ * bytes_sent says how far it got.
+ *
+ * @param conn Pointer to an established SecureConnection.
+ * @param path File to send.
+ * @param options Range, sealing and window settings, or NULL for the defaults.
+ * @param bytes_sent Optional pointer to store how many file bytes, from options->offset, were sent.
+ *                   Also set on failure, so a transfer can resume at offset + *bytes_sent.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError secure_send_file(SecureConnection* conn, const char* path, const SecureFileSendOptions* options,
+                                 uint64_t* bytes_sent);
+
+// -----------------------------------
+// Connection Pool Function Declarations
+// -----------------------------------
+
+/**
+ * @brief Opaque pool of idle client connections, keyed by address and port.
+ */
+typedef struct ConnectionPool ConnectionPool;
+
+/**
+ * @brief Application-level keepalive sent over an idle pooled connection.
+ *
+ * @param conn The idle connection; the ping must leave it ready for reuse.
+ * @param user_data ConnectionPoolConfig.ping_user_data.
+ *
+ * @return SECURE_COMM_SUCCESS if the peer answered; any other value evicts the connection.
+ */
+typedef SecureCommError (*connection_ping_fn)(SecureConnection* conn, void* user_data);
+
+/**
+ * @brief Settings of a connection pool. Initialize with connection_pool_config_defaults.
+ */
+typedef struct {
+    size_t max_idle_per_host;   // Idle connections kept per address and port; extra releases are closed
+    int idle_timeout_ms;        // Idle connections older than this are closed (0 keeps them)
+    int keepalive_interval_ms;  // Idle connections are checked this often by a maintenance thread (0: none)
+    int connect_timeout_ms;     // Limit on establishing new connections (0 waits as long as the kernel does)
+    int use_tls;                // Non-zero opens connections with create_connection, else create_plain_connection
+    connection_ping_fn ping;    // Optional keepalive exchanged on every check; NULL only checks the socket
+    void* ping_user_data;       // Passed to ping
+} ConnectionPoolConfig;
+
+/**
+ * @brief Counters of a connection pool.
+ */
+typedef struct {
+    uint64_t connects;          // New connections opened by connection_pool_acquire
+    uint64_t reuses;            // Acquires served from an idle connection
+    uint64_t pings;             // Keepalive checks of idle connections
+    uint64_t evicted_idle;      // Idle connections closed by idle_timeout_ms or max_idle_per_host
+    uint64_t evicted_dead;      // Idle connections closed because their peer had gone or a ping failed
+    size_t idle;                // Connections currently waiting in the pool
+} ConnectionPoolStats;
+
+/**
+ * @brief Fills ConnectionPoolConfig with the defaults: 4 idle connections per host,
+ *        a 60 s idle timeout, checks every 15 s and TLS connections.
+ *
+ * @param config The configuration to fill.
+ */
+void connection_pool_config_defaults(ConnectionPoolConfig* config);
+
+/**
+ * @brief Creates a connection pool, starting its maintenance thread if keepalive_interval_ms is set.
+ *
+ * @param config Pool settings, or NULL for the defaults.
+ * @param pool Pointer to store the new pool.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError connection_pool_create(const ConnectionPoolConfig* config, ConnectionPool** pool);
+
+/**
+ * @brief Hands out a connection to address:port.
+ *
+ * The most recently released idle connection to that address is reused once a
+ * non-blocking check finds it still open and without stray data; otherwise a new
+ * connection is made. Pooled sockets have TCP keepalive enabled.
+ *
+ * @param pool The pool.
+ * @param address The IP address or hostname to connect to.
+ * @param port The port number to connect on.
+ * @param conn Pointer to store the connection; it belongs to the caller until released.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or the error of the failed connect.
+ */
+SecureCommError connection_pool_acquire(ConnectionPool* pool, const char* address, int port, SecureConnection** conn);
+
+/**
+ * @brief Returns a connection obtained from connection_pool_acquire.
+ *
+ * Only release a connection as reusable when no reply is outstanding on it, so
+ * the next owner starts at a message boundary.
+ *
+ * @param pool The pool the connection came from.
+ * @param conn The connection.
+ * @param reusable Non-zero to keep it for a later acquire, 0 to close it.
+ */
+void connection_pool_release(ConnectionPool* pool, SecureConnection* conn, int reusable);
+
+/**
+ * @brief Checks idle connections now: closes expired or dead ones and pings the rest
+ *        whose keepalive interval has passed. The maintenance thread calls this.
+ *
+ * @param pool The pool.
+ */
+void connection_pool_maintain(ConnectionPool* pool);
+
+/**
+ * @brief Copies the pool counters.
+ *
+ * @param pool The pool.
+ * @param stats Pointer to store the counters.
+ */
+void connection_pool_stats(ConnectionPool* pool, ConnectionPoolStats* stats);
+
+/**
+ * @brief Stops the maintenance thread and closes every idle connection.
+ *
+ * Connections still acquired stay open and must be closed with close_connection.
+ */
+void connection_pool_destroy(ConnectionPool* pool);
+
+// -----------------------------------
+// Session Module Function Declarations
+// -----------------------------------
+
+/**
+ * @brief Key exchange used to establish session keys.
+ */
+typedef enum {
+    SESSION_KEX_FFDHE2048 = 0,  // RFC 7919 2048-bit finite-field group (default)
+    SESSION_KEX_FFDHE3072,      // RFC 7919 3072-bit finite-field group
+    SESSION_KEX_X25519,         // X25519 elliptic-curve Diffie-Hellman
+    SESSION_KEX_DH_CUSTOM,      // DH parameters loaded with session_load_dh_params
+    SESSION_KEX_COUNT
+} SessionKeyExchange;
+
+/**
+ * @brief Selects the key exchange used by initialize_session.
+ *
+ * @param kex One of SessionKeyExchange.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or SECURE_COMM_ERR_SESSION for an unknown value.
+ */
+SecureCommError session_set_key_exchange(SessionKeyExchange kex);
+
+/**
+ * @brief Loads precomputed DH parameters (PEM) for SESSION_KEX_DH_CUSTOM.
+ *
+ * @param pem_path Path to the PEM file, e.g. produced by `openssl dhparam`.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or SECURE_COMM_ERR_SESSION on failure.
+ */
+SecureCommError session_load_dh_params(const char* pem_path);
+
+/**
+ * @brief Generates an ephemeral key pair for the given key exchange.
+ *
+ * Group parameters are built once per process; no prime is generated per call.
+ *
+ * @param kex One of SessionKeyExchange.
+ * @param keypair Pointer to store the generated EVP_PKEY key pair.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or SECURE_COMM_ERR_SESSION on failure.
+ */
+SecureCommError generate_session_keypair(SessionKeyExchange kex, EVP_PKEY** keypair);
+
+/**
+ * @brief Background pool of ready ephemeral keypairs (opaque).
+ */
+typedef struct KeypairPool KeypairPool;
+
+/**
+ * @brief Keypair pool parameters.
+ *
+ * The refill thread sleeps while more than low_watermark keypairs are ready and,
+ * once woken, generates keypairs until high_watermark are ready again.
+ */
+typedef struct {
+    SessionKeyExchange kex;     // Key exchange to generate keypairs for
+    size_t low_watermark;       // Refill when the ready count drops to this
+    size_t high_watermark;      // Pool capacity
+} KeypairPoolConfig;
+
+/**
+ * @brief Keypair pool counters.
+ */
+typedef struct {
+    uint64_t hits;              // Takes served from the pool
+    uint64_t empty_hits;        // Takes that found the pool empty and generated inline
+    uint64_t generated;         // Keypairs generated by the refill thread
+    uint64_t refills;           // Times the refill thread woke up to top the pool up
+    uint64_t failures;          // Background generation failures
+    size_t available;           // Keypairs currently ready
+} KeypairPoolStats;
+
+/**
+ * @brief Fills a KeypairPoolConfig with the defaults (ffdhe2048, 16/64).
+ *
+ * @param config The configuration to fill.
+ */
+void keypair_pool_config_defaults(KeypairPoolConfig* config);
+
+/**
+ * @brief Creates a keypair pool and starts its refill thread.
+ *
+ * @param config Pool parameters, or NULL for the defaults.
+ * @param pool Pointer to store the created KeypairPool.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError keypair_pool_create(const KeypairPoolConfig* config, KeypairPool** pool);
+
+/**
+ * @brief Takes a ready keypair, or generates one inline if the pool is empty.
+ *
+ * @param pool The pool.
+ * @param keypair Pointer to store the keypair (caller frees with EVP_PKEY_free).
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError keypair_pool_take(KeypairPool* pool, EVP_PKEY** keypair);
+
+/**
+ * @brief Returns the key exchange the pool generates keypairs for.
+ */
+SessionKeyExchange keypair_pool_kex(const KeypairPool* pool);
+
+/**
+ * @brief Copies the pool counters.
+ *
+ * @param pool The pool.
+ * @param stats Pointer to store the counters.
+ */
+void keypair_pool_stats(KeypairPool* pool, KeypairPoolStats* stats);
+
+/**
+ * @brief Stops the refill thread and frees every pooled keypair.
+ *
+ * @param pool The pool to destroy.
+ */
+void keypair_pool_destroy(KeypairPool* pool);
+
+/**
+ * @brief Makes initialize_session take keypairs from a pool.
+ *
+ * The pool is used while its key exchange matches the one selected with
+ * session_set_key_exchange. Safe to call while sessions are being created;
+ * detach (NULL) before destroying the pool. Detaching waits for threads still
+ * taking a keypair from it.
+ *
+ * @param pool The pool, or NULL to detach.
+ */
+void session_set_keypair_pool(KeypairPool* pool);
+
+/**
+ * @brief Initializes a user session.
+ *
+ * This function initializes a new user session, performing necessary authentication
+ * and establishing secure key exchanges.
+ *
+ * @param username The username of the user initiating the session.
+ * @param password The password of the user (for authentication).
+ * @param session Pointer to store the created UserSession.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError initialize_session(const char* username, const char* password, UserSession** session);
+
+/**
+ * @brief Terminates a user session.
+ *
+ * This function terminates an existing user session, freeing all associated resources.
+ *
+ * @param session Pointer to the UserSession to terminate.
+ */
+void terminate_session(UserSession* session);
+
+// -----------------------------------
+// Session Table Module Function Declarations
+// -----------------------------------
+
+#define SESSION_ID_SIZE 16
+#define SESSION_KEY_SIZE 32
+// IV || tag || sealed (session ID || key || issue time)
+#define SESSION_TICKET_SIZE (SECURE_RECORD_OVERHEAD + SESSION_ID_SIZE + SESSION_KEY_SIZE + 8)
+
+// Opaque structure indexing live sessions by ID
+typedef struct SessionTable SessionTable;
+
+/**
+ * @brief Session table settings. Start from session_table_config_defaults.
+ */
+typedef struct {
+    size_t shards;                  // Independently locked partitions, rounded up to a power of two (default 64)
+    size_t max_sessions;            // Live sessions kept at most; the next idle one is evicted beyond (default 262144)
+    uint32_t idle_timeout_ms;       // Sessions unused for this long are dropped (default 300000)
+    uint32_t tick_ms;               // Resolution of the expiry timer wheel (default 1000)
+    uint32_t ticket_lifetime_ms;    // Tickets older than this are refused (default 86400000)
+    const unsigned char* ticket_key; // SESSION_KEY_SIZE bytes sealing tickets; NULL picks a random key
+} SessionTableConfig;
+
+/**
+ * @brief Session table counters, summed over all shards.
+ */
+typedef struct {
+    uint64_t sessions;          // Live sessions
+    uint64_t inserted;          // Sessions added by session_table_insert or session_table_resume
+    uint64_t lookups;           // session_table_lookup calls
+    uint64_t hits;              // ... that found a live session
+    uint64_t expired;           // Sessions dropped by the timer wheel
+    uint64_t evicted;           // Sessions dropped to make room in a full shard
+    uint64_t resumed;           // Tickets accepted
+    uint64_t tickets_rejected;  // Tickets that failed authentication or were too old
+    size_t memory_bytes;        // Memory held by entries and hash buckets
+} SessionTableStats;
+
+/**
+ * @brief Fills a SessionTableConfig with the defaults.
+ *
+ * @param config The configuration to fill.
+ */
+void session_table_config_defaults(SessionTableConfig* config);
+
+/**
+ * @brief Creates a session table.
+ *
+ * Sessions are spread over shards by ID, each with its own lock, hash buckets
+ * and timer wheel. An entry takes one cache line; entry storage grows in chunks
+ * as sessions are added.
+ *
+ * @param config Settings, or NULL for the defaults.
+ * @param table Pointer to store the new table.
+ *
+ * @return SECURE_COMM_SUCCESS on success, SECURE_COMM_ERR_SESSION for invalid settings,
+ *         or SECURE_COMM_ERR_MEMORY on allocation failure.
+ */
+SecureCommError session_table_create(const SessionTableConfig* config, SessionTable** table);
+
+/**
+ * @brief Adds a session and assigns it a random ID.
+ *
+ * @param table The session table.
+ * @param key The session key (SESSION_KEY_SIZE bytes).
+ * @param id Buffer of SESSION_ID_SIZE bytes to store the new session's ID.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError session_table_insert(SessionTable* table, const unsigned char* key, unsigned char* id);
+
+/**
+ * @brief Finds a live session and restarts its idle timer.
+ *
+ * @param table The session table.
+ * @param id The session ID (SESSION_ID_SIZE bytes).
+ * @param key Optional buffer of SESSION_KEY_SIZE bytes to store the session key.
+ *
+ * @return SECURE_COMM_SUCCESS if found, or SECURE_COMM_ERR_SESSION if unknown or expired.
+ */
+SecureCommError session_table_lookup(SessionTable* table, const unsigned char* id, unsigned char* key);
+
+/**
+ * @brief Drops a session and erases its key.
+ *
+ * @param table The session table.
+ * @param id The session ID (SESSION_ID_SIZE bytes).
+ *
+ * @return SECURE_COMM_SUCCESS if removed, or SECURE_COMM_ERR_SESSION if unknown.
+ */
+SecureCommError session_table_remove(SessionTable* table, const unsigned char* id);
+
+/**
+ * @brief Drops every session whose idle timeout has passed.
+ *
+ * Each shard also expires its own sessions whenever it is used, so calling this
+ * is only needed to release memory from shards that see no traffic.
+ *
+ * @param table The session table.
+ *
+ * @return The number of sessions dropped.
+ */
+size_t session_table_expire(SessionTable* table);
+
+/**
+ * @brief Seals a live session into a resumption ticket for its client.
+ *
+ * The ticket carries the session ID and key under the table's ticket key, so
+ * the server can restore the session even after it left the table.
+ *
+ * @param table The session table.
+ * @param id The session ID (SESSION_ID_SIZE bytes).
+ * @param ticket Buffer of SESSION_TICKET_SIZE bytes to store the ticket.
+ *
+ * @return SECURE_COMM_SUCCESS on success, SECURE_COMM_ERR_SESSION if the session is unknown,
+ *         or SECURE_COMM_ERR_ENCRYPT on failure.
+ */
+SecureCommError session_table_issue_ticket(SessionTable* table, const unsigned char* id, unsigned char* ticket);
+
+/**
+ * @brief Restores a session from a ticket, skipping authentication and key exchange.
+ *
+ * A session that already left the table is added back under its old ID.
+ *
+ * @param table The session table.
+ * @param ticket The ticket received from the client.
+ * @param ticket_len Length of the ticket in bytes.
+ * @param id Optional buffer of SESSION_ID_SIZE bytes to store the session ID.
+ * @param key Buffer of SESSION_KEY_SIZE bytes to store the session key.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or SECURE_COMM_ERR_SESSION if the ticket
+ *         is malformed, forged or expired.
+ */
+SecureCommError session_table_resume(SessionTable* table, const unsigned char* ticket, size_t ticket_len,
+                                     unsigned char* id, unsigned char* key);
+
+/**
+ * @brief Copies the table counters.
+ *
+ * @param table The session table.
+ * @param stats Pointer to store the counters.
+ */
+void session_table_stats(SessionTable* table, SessionTableStats* stats);
+
+/**
+ * @brief Destroys a session table, erasing every key.
+ *
+ * @param table The table to destroy.
+ */
+void session_table_destroy(SessionTable* table);
+
+// -----------------------------------
+// Broadcast Module Function Declarations
+// -----------------------------------
+
+// Opaque structure fanning messages out to the subscribers of named topics
+typedef struct BroadcastHub BroadcastHub;
+
+// Opaque structure for one recipient's bounded send queue
+typedef struct BroadcastSubscriber BroadcastSubscriber;
+
+/**
+ * @brief How a topic encrypts its messages.
+ */
+typedef enum {
+    BROADCAST_PER_RECIPIENT = 0,    // Sealed under each subscriber's own cipher, in one batch
+    BROADCAST_GROUP_KEY             // Sealed once under the topic's group key; every subscriber gets the same frame
+} BroadcastMode;
+
+/**
+ * @brief What broadcast_publish does for a subscriber whose queue is full.
+ */
+typedef enum {
+    BROADCAST_FULL_DROP = 0,        // Skip the message for that subscriber and count it as dropped
+    BROADCAST_FULL_DISCONNECT       // Close the subscriber; broadcast_subscriber_next then fails
+} BroadcastFullPolicy;
+
+/**
+ * @brief Parameters for broadcast_hub_create. Initialize with broadcast_hub_config_defaults.
+ */
+typedef struct {
+    size_t max_queued;              // Frames waiting per subscriber (default 256)
+    size_t max_queued_bytes;        // Bytes waiting per subscriber (default 1 MB)
+    BroadcastFullPolicy on_full;    // Slow subscriber handling (default drop)
+    BufferPool* pool;               // Pool for the frames, or NULL for buffer_pool_default
+} BroadcastHubConfig;
+
+/**
+ * @brief Outcome of one broadcast_publish call.
+ */
+typedef struct {
+    size_t subscribers;     // Subscribers of the topic
+    size_t queued;          // ... that received the frame
+    size_t dropped;         // ... whose queue was full
+    size_t disconnected;    // ... closed by BROADCAST_FULL_DISCONNECT
+    size_t failed;          // ... whose frame could not be sealed
+} BroadcastResult;
+
+/**
+ * @brief Counters of one subscriber.
+ */
+typedef struct {
+    size_t queued;          // Frames waiting
+    size_t queued_bytes;    // Bytes waiting
+    uint64_t delivered;     // Frames taken with broadcast_subscriber_next
+    uint64_t dropped;       // Frames skipped because the queue was full
+    int closed;             // Whether the subscriber was closed
+} BroadcastSubscriberStats;
+
+/**
+ * @brief Fills a BroadcastHubConfig with the defaults.
+ *
+ * @param config The configuration to fill.
+ */
+void broadcast_hub_config_defaults(BroadcastHubConfig* config);
+
+/**
+ * @brief Creates a broadcast hub.
+ *
+ * Publishes are serialized per hub, so a subscriber's cipher is only ever used
+ * by one publishing thread at a time. Subscribers drain their own queues, so a
+ * stalled recipient only fills its own queue.
+ *
+ * @param config Settings, or NULL for the defaults.
+ * @param hub Pointer to store the new hub.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError broadcast_hub_create(const BroadcastHubConfig* config, BroadcastHub** hub);
+
+/**
+ * @brief Creates a topic (room).
+ *
+ * Group-key topics get a random key. It uses the session suite all subscribers share, or
+ * AES-256-GCM, which every client supports, when they differ.
+ *
+ * @param hub The hub.
+ * @param name Topic name.
+ * @param mode How messages to the topic are encrypted.
+ *
+ * @return SECURE_COMM_SUCCESS on success, SECURE_COMM_ERR_SESSION if the topic exists,
+ *         or another negative error code on failure.
+ */
+SecureCommError broadcast_topic_create(BroadcastHub* hub, const char* name, BroadcastMode mode);
+
+/**
+ * @brief Creates a subscriber with an empty queue.
+ *
+ * @param hub The hub.
+ * @param cipher The recipient's session cipher. Per-recipient topics seal with it and
+ *               group-key topics deliver their key under it. The caller must not encrypt
+ *               with it while the subscriber exists.
+ * @param subscriber Pointer to store the new subscriber.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError broadcast_subscriber_create(BroadcastHub* hub, SecureCipher* cipher, BroadcastSubscriber** subscriber);
+
+/**
+ * @brief Adds a subscriber to a topic.
+ *
+ * For a group-key topic, a FRAME_TYPE_GROUP_KEY frame is queued first: a record
+ * sealed under the subscriber's cipher holding the 32-byte group key, its 4-byte
+ * big-endian epoch, its CipherSuite byte and the topic name. Group frames carry the
+ * epoch, with the top bit set, as their nonce salt. A subscriber that changes the
+ * members' common suite rekeys the topic, and the current members get that key first.
+ *
+ * @param subscriber The subscriber.
+ * @param topic Topic name.
+ *
+ * @return SECURE_COMM_SUCCESS on success, SECURE_COMM_ERR_SESSION for an unknown topic,
+ *         or another negative error code on failure.
+ */
+SecureCommError broadcast_subscribe(BroadcastSubscriber* subscriber, const char* topic);
+
+/**
+ * @brief Removes a subscriber from a topic. Frames already queued stay queued.
+ *
+ * Leaving a group-key topic, here or through broadcast_subscriber_destroy, replaces the
+ * topic's key and bumps its epoch. The new key is queued to every remaining subscriber
+ * behind the frames sealed with the old one. A subscriber whose queue cannot take it is closed.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or SECURE_COMM_ERR_SESSION if not subscribed.
+ */
+SecureCommError broadcast_unsubscribe(BroadcastSubscriber* subscriber, const char* topic);
+
+/**
+ * @brief Seals a message for every subscriber of a topic and queues the frames.
+ *
+ * Each frame is a complete header || IV || tag || ciphertext, ready for the socket.
+ * Subscribers with full queues are handled by the hub's BroadcastFullPolicy before
+ * anything is encrypted for them.
+ *
+ * @param hub The hub.
+ * @param topic Topic name.
+ * @param codec CompressionCodecId the payload was compressed with, recorded in the frame header.
+ * @param payload The message.
+ * @param len Length of the message in bytes.
+ * @param result Optional pointer to store the outcome.
+ *
+ * @return SECURE_COMM_SUCCESS if the topic exists (even if some subscribers were skipped),
+ *         SECURE_COMM_ERR_SESSION for an unknown topic, or another negative error code.
+ */
+SecureCommError broadcast_publish(BroadcastHub* hub, const char* topic, CompressionCodecId codec,
+                                  const unsigned char* payload, size_t len, BroadcastResult* result);
+
+/**
+ * @brief Takes the next queued frame.
+ *
+ * @param subscriber The subscriber.
+ * @param timeout_ms Milliseconds to wait; 0 returns at once, negative waits indefinitely.
+ * @param frame Pointer to store the frame. Release it with secure_buffer_release once sent.
+ *
+ * @return SECURE_COMM_SUCCESS on success, SECURE_COMM_ERR_AGAIN on timeout, or
+ *         SECURE_COMM_ERR_SESSION once the subscriber is closed.
+ */
+SecureCommError broadcast_subscriber_next(BroadcastSubscriber* subscriber, int timeout_ms, SecureBuffer** frame);
+
+/**
+ * @brief Closes a subscriber: queued frames are discarded and waiting calls return.
+ *
+ * Safe to call from any thread. The subscriber stays valid until destroyed.
+ */
+void broadcast_subscriber_close(BroadcastSubscriber* subscriber);
+
+/**
+ * @brief Copies a subscriber's counters.
+ */
+void broadcast_subscriber_stats(BroadcastSubscriber* subscriber, BroadcastSubscriberStats* stats);
+
+/**
+ * @brief Leaves every topic and frees a subscriber. No thread may still be waiting on it.
+ */
+void broadcast_subscriber_destroy(BroadcastSubscriber* subscriber);
+
+/**
+ * @brief Frees a hub and its topics. Destroy its subscribers first.
+ */
+void broadcast_hub_destroy(BroadcastHub* hub);
+
+// -----------------------------------
+// Multiplexing Module Function Declarations
+// -----------------------------------
+
+// Opaque structure running many logical streams over one SecureConnection
+typedef struct MuxConnection MuxConnection;
+
+// Opaque structure for one bidirectional stream of a MuxConnection
+typedef struct MuxStream MuxStream;
+
+// Priority of new streams; lower values are sent first
+#define MUX_PRIORITY_DEFAULT 128
+
+/**
+ * @brief Parameters for mux_create. Initialize with mux_config_defaults.
+ *
+ * initial_window and max_frame_payload must be the same on both peers.
+ */
+typedef struct {
+    uint32_t initial_window;    // Bytes a peer may send on a stream before the reader grants more (default 256 KB)
+    size_t max_frame_payload;   // Largest DATA frame body (default 16 KB); bounds how long one stream holds the link
+    size_t max_streams;         // Peer-opened streams not yet released; further ones are reset (default 128)
+} MuxConfig;
+
+/**
+ * @brief Counters of one MuxConnection.
+ */
+typedef struct {
+    uint64_t streams_opened;    // Streams opened locally with mux_stream_open
+    uint64_t streams_accepted;  // Streams opened by the peer
+    uint64_t streams_refused;   // Peer streams reset because max_streams were open
+    size_t active_streams;      // Streams not yet released
+    uint64_t frames_sent;
+    uint64_t frames_received;
+    uint64_t bytes_sent;        // Stream bytes, without framing
+    uint64_t bytes_received;
+    uint64_t window_updates;    // Window grants sent to the peer
+    uint64_t resets_sent;
+    uint64_t resets_received;
+} MuxStats;
+
+/**
+ * @brief Fills a MuxConfig with the defaults.
+ *
+ * @param config The configuration to fill.
+ */
+void mux_config_defaults(MuxConfig* config);
+
+/**
+ * @brief Starts multiplexing streams over an established connection.
+ *
+ * Every frame is a FRAME_TYPE_MUX record. Its plaintext starts with a header
+ * (stream id, kind, flags and priority), so the stream id is authenticated with
+ * the data. One writer thread sends queued frames, the lowest priority value
+ * first and round-robin among equal priorities, one frame of at most
+ * max_frame_payload bytes at a time. One reader thread buffers incoming data per
+ * stream. A stream whose reader falls behind exhausts only its own window, so it
+ * never holds up the other streams.
+ *
+ * The connection and ciphers belong to the MuxConnection until mux_destroy; the
+ * caller must not send, receive, seal or open with them meanwhile.
+ *
+ * @param conn Established connection (not owned).
+ * @param seal Cipher sealing outgoing frames (not owned).
+ * @param open Cipher opening incoming frames (not owned).
+ * @param replay Optional replay window checked for every incoming frame (NULL to skip).
+ * @param initiator Non-zero on the side that opened the connection; it numbers its streams
+ *                  odd and the peer even, so both can open streams without colliding.
+ * @param config Settings, or NULL for the defaults.
+ * @param mux Pointer to store the new MuxConnection.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError mux_create(SecureConnection* conn, SecureCipher* seal, SecureCipher* open, ReplayWindow* replay,
+                           int initiator, const MuxConfig* config, MuxConnection** mux);
+
+/**
+ * @brief Opens a new stream. Nothing is sent until the first write or close.
+ *
+ * The stream's id is assigned when its first frame goes out, so the peer always
+ * sees new ids in rising order.
+ *
+ * @param mux The MuxConnection.
+ * @param priority Send priority; lower values go first (MUX_PRIORITY_DEFAULT for normal traffic).
+ * @param stream Pointer to store the new stream.
+ *
+ * @return SECURE_COMM_SUCCESS on success, SECURE_COMM_ERR_SESSION if the connection has
+ *         failed or is closing, or another negative error code.
+ */
+SecureCommError mux_stream_open(MuxConnection* mux, uint8_t priority, MuxStream** stream);
+
+/**
+ * @brief Takes the next stream opened by the peer.
+ *
+ * Accepted streams are sent with the priority the peer opened them with.
+ *
+ * @param mux The MuxConnection.
+ * @param timeout_ms Milliseconds to wait; 0 returns at once, negative waits indefinitely.
+ * @param stream Pointer to store the stream.
+ *
+ * @return SECURE_COMM_SUCCESS on success, SECURE_COMM_ERR_AGAIN on timeout, or
+ *         SECURE_COMM_ERR_RECV once the connection has ended.
+ */
+SecureCommError mux_accept(MuxConnection* mux, int timeout_ms, MuxStream** stream);
+
+/**
+ * @brief Queues data on a stream.
+ *
+ * The data is copied into frames. Blocks while the peer's window for the stream
+ * is used up, and returns once every byte is queued.
+ *
+ * @param stream The stream.
+ * @param data Bytes to send.
+ * @param len Number of bytes.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or SECURE_COMM_ERR_SEND if the stream was
+ *         closed for writing or reset, or the connection failed.
+ */
+SecureCommError mux_stream_write(MuxStream* stream, const void* data, size_t len);
+
+/**
+ * @brief Ends the sending half of a stream; the peer reads to the end and then sees it close.
+ *
+ * @param stream The stream.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or SECURE_COMM_ERR_SEND if the stream was reset.
+ */
+SecureCommError mux_stream_close(MuxStream* stream);
+
+/**
+ * @brief Reads buffered stream data, waiting for some to arrive.
+ *
+ * Data that has been read is granted back to the peer as window.
+ *
+ * @param stream The stream.
+ * @param buffer Destination buffer.
+ * @param len Size of the buffer.
+ * @param timeout_ms Milliseconds to wait; 0 returns at once, negative waits indefinitely.
+ * @param bytes_read Pointer to store the number of bytes read.
+ *
+ * @return SECURE_COMM_SUCCESS if data was read, SECURE_COMM_ERR_AGAIN on timeout,
+ *         SECURE_COMM_ERR_RECV at the end of the stream or once the connection has ended,
+ *         or SECURE_COMM_ERR_SESSION if the stream was reset.
+ */
+SecureCommError mux_stream_read(MuxStream* stream, void* buffer, size_t len, int timeout_ms, size_t* bytes_read);
+
+/**
+ * @brief Aborts a stream in both directions. Queued data is dropped and the peer is told.
+ *
+ * @param stream The stream.
+ */
+void mux_stream_reset(MuxStream* stream);
+
+/**
+ * @brief Changes the send priority of a stream.
+ */
+void mux_stream_set_priority(MuxStream* stream, uint8_t priority);
+
+/**
+ * @brief Returns the stream's id, or 0 until its first frame has been sent.
+ */
+uint32_t mux_stream_id(const MuxStream* stream);
+
 /**
- * @brief Creates a secure connection to the specified address and port.
- *
- * This function establishes a TCP connection to the given address and port,
- * and initializes the SSL context for secure communication.
+ * @brief Releases a stream handle.
  *
- * @param address The IP address or hostname to connect to.
- * @param port The port number to connect on.
- * @param error Pointer to store the error code if connection fails.
+ * Data already queued is still sent. Closing a stream and reading it to its end
+ * before releasing it finishes it cleanly. A stream still open in either direction
+ * is reset once its queued data is sent.
  *
- * @return Pointer to a SecureConnection on success, or NULL on failure.
- *         The specific error code is stored in *error.
+ * @param stream The stream; invalid afterwards.
  */
-SecureConnection* create_connection(const char* address, int port, SecureCommError* error);
+void mux_stream_release(MuxStream* stream);
 
 /**
- * @brief Sends data over the secure connection.
- *
- * This function encrypts and sends the specified data over the connection.
- *
- * @param conn Pointer to an established SecureConnection.
- * @param data Pointer to the data buffer to send.
- * @param len Length of the data in bytes.
- * @param bytes_sent Pointer to store the number of bytes actually sent.
- *
- * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ * @brief Copies the counters of a MuxConnection.
  */
-SecureCommError secure_send(SecureConnection* conn, const void* data, size_t len, ssize_t* bytes_sent);
+void mux_get_stats(MuxConnection* mux, MuxStats* stats);
 
 /**
- * @brief Receives data from the secure connection.
- *
- * This function receives and decrypts data from the connection.
+ * @brief Sends every queued frame, stops both threads and frees the MuxConnection.
  *
- * @param conn Pointer to an established SecureConnection.
- * @param buffer Pointer to the buffer where received data will be stored.
- * @param len Maximum number of bytes to receive.
- * @param bytes_received Pointer to store the number of bytes actually received.
+ * The connection is shut down (see connection_shutdown) to stop the reader; close it
+ * afterwards with close_connection. Streams not yet released are freed too; no
+ * thread may still be using them.
  *
- * @return SECURE_COMM_SUCCESS on success, SECURE_COMM_ERR_RECV if connection is closed,
- *         or a negative error code on failure.
+ * @param mux The MuxConnection.
  */
-SecureCommError secure_recv(SecureConnection* conn, void* buffer, size_t len, ssize_t* bytes_received);
+void mux_destroy(MuxConnection* mux);
+
+// -----------------------------------
+// Metrics Module Function Declarations
+// -----------------------------------
 
 /**
- * @brief Closes the secure connection and frees resources.
+ * @brief Process-wide event counters.
+ */
+typedef enum {
+    METRIC_CONNECTIONS_OPENED = 0,  // SecureConnection and reactor connections created
+    METRIC_CONNECTIONS_CLOSED,      // ... and released
+    METRIC_BYTES_SENT,              // Bytes handed to the socket or TLS layer
+    METRIC_BYTES_RECEIVED,          // Bytes read from the socket or TLS layer
+    METRIC_SEND_CALLS,              // Successful send calls (secure_send, secure_sendv, reactor_conn_send)
+    METRIC_RECV_CALLS,              // Successful receive calls (secure_recv, secure_recvv, reactor reads)
+    METRIC_TLS_SESSIONS_RESUMED,    // Client handshakes that resumed a cached session
+    METRIC_REPLAYS_REJECTED,        // Sequence numbers refused by replay_window_accept
+    METRIC_SESSIONS_STARTED,        // Successful initialize_session calls
+    METRIC_SESSIONS_RESUMED,        // Tickets accepted by session_table_resume
+    METRIC_AUTH_FAILURES,           // Rejected credentials
+    METRIC_COUNTER_COUNT
+} MetricCounter;
+
+/**
+ * @brief Timed processing stages. Each keeps operations, failures, bytes in and out
+ *        and a latency histogram.
+ */
+typedef enum {
+    METRIC_STAGE_ENCRYPT = 0,       // cipher_encrypt / encrypt_data (plaintext in, ciphertext out)
+    METRIC_STAGE_DECRYPT,           // cipher_decrypt / decrypt_data; failures are rejected records
+    METRIC_STAGE_COMPRESS,          // zlib compress_data and compress_data_dynamic
+    METRIC_STAGE_DECOMPRESS,        // zlib decompress_data and decompress_data_dynamic(_ex)
+    METRIC_STAGE_TLS_HANDSHAKE,     // SSL_connect / SSL_accept
+    METRIC_STAGE_KEYGEN,            // generate_session_keypair
+    METRIC_STAGE_KEY_DERIVE,        // derive_shared_secret
+    METRIC_STAGE_COUNT
+} MetricStage;
+
+// Latency buckets per stage: 8 linear sub-buckets per power of two (at most 12.5%
+// relative error), from 0 ns up to 2^36 ns (about 68 s); longer values land in the last one
+#define METRICS_HISTOGRAM_SUB_BITS 3
+#define METRICS_HISTOGRAM_MAX_EXPONENT 36
+#define METRICS_HISTOGRAM_BUCKETS \
+    ((METRICS_HISTOGRAM_MAX_EXPONENT - METRICS_HISTOGRAM_SUB_BITS + 1) << METRICS_HISTOGRAM_SUB_BITS)
+
+/**
+ * @brief Totals of one stage, summed over every thread.
+ */
+typedef struct {
+    uint64_t operations;        // Calls timed (successful or not)
+    uint64_t failures;          // Calls that returned an error
+    uint64_t bytes_in;          // Input bytes of successful calls
+    uint64_t bytes_out;         // Output bytes of successful calls
+    uint64_t latency_sum_ns;    // Sum of all call durations
+    uint64_t latency_max_ns;    // Longest call
+    uint64_t latency_buckets[METRICS_HISTOGRAM_BUCKETS]; // Calls per duration bucket
+} MetricsStageSnapshot;
+
+/**
+ * @brief Point-in-time copy of every counter and stage.
+ */
+typedef struct {
+    uint64_t counters[METRIC_COUNTER_COUNT];
+    MetricsStageSnapshot stages[METRIC_STAGE_COUNT];
+} MetricsSnapshot;
+
+/**
+ * @brief Turns metric collection on or off (on by default).
  *
- * This function gracefully shuts down the SSL connection, closes the socket,
- * and frees any allocated memory associated with the connection.
+ * While disabled, metrics_now_ns returns 0 and every update returns at once, so the
+ * hooks cost one relaxed load.
  *
- * @param conn Pointer to the SecureConnection to close.
+ * @param enabled Non-zero to collect metrics.
  */
-void close_connection(SecureConnection* conn);
+void metrics_set_enabled(int enabled);
 
 /**
- * @brief Cleans up networking resources.
- *
- * This function should be called once all networking operations are complete.
- * It performs necessary cleanup tasks, such as freeing global resources.
+ * @brief Reports whether metrics are being collected.
  */
-void cleanup_networking();
+int metrics_enabled(void);
 
 /**
- * @brief Encrypts data using AES-GCM (Authenticated Encryption).
- *
- * This function encrypts the input data using AES-GCM encryption.
+ * @brief Monotonic start time for metrics_stage_done, or 0 while metrics are disabled.
+ */
+uint64_t metrics_now_ns(void);
+
+/**
+ * @brief Adds to a counter in the calling thread's shard.
  *
- * @param plaintext Pointer to the data to encrypt.
- * @param plaintext_len Length of the plaintext in bytes.
- * @param key Pointer to the encryption key (16, 24, or 32 bytes for AES-128, AES-192, AES-256).
- * @param iv Pointer to the 12-byte Initialization Vector (randomly generated).
- * @param ciphertext Pointer to the buffer where encrypted data will be stored.
- * @param ciphertext_len Pointer to store the length of the ciphertext.
- * @param tag Pointer to store the authentication tag (16 bytes).
+ * Threads are spread over a fixed set of cache-line aligned shards, so concurrent
+ * updates rarely touch the same line. Snapshots add the shards up.
  *
- * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ * @param counter The counter.
+ * @param value Amount to add.
  */
-SecureCommError encrypt_data(const unsigned char* plaintext, int plaintext_len,
-                             const unsigned char* key, unsigned char* iv,
-                             unsigned char* ciphertext, int* ciphertext_len,
-                             unsigned char* tag);
+void metrics_count(MetricCounter counter, uint64_t value);
 
 /**
- * @brief Decrypts data using AES-GCM (Authenticated Encryption).
+ * @brief Records one finished call of a stage.
  *
- * This function decrypts the input data using AES-GCM decryption.
+ * @param stage The stage.
+ * @param start_ns Value of metrics_now_ns taken when the call started.
+ * @param bytes_in Input size, counted only if result is SECURE_COMM_SUCCESS.
+ * @param bytes_out Output size, counted only if result is SECURE_COMM_SUCCESS.
+ * @param result What the call returned; any error counts as a failure.
+ */
+void metrics_stage_done(MetricStage stage, uint64_t start_ns, size_t bytes_in, size_t bytes_out,
+                        SecureCommError result);
+
+/**
+ * @brief Sums every shard into a snapshot.
  *
- * @param ciphertext Pointer to the data to decrypt.
- * @param ciphertext_len Length of the ciphertext in bytes.
- * @param key Pointer to the decryption key (must be the same as encryption key).
- * @param iv Pointer to the 12-byte Initialization Vector (must be the same as used in encryption).
- * @param plaintext Pointer to the buffer where decrypted data will be stored.
- * @param plaintext_len Pointer to store the length of the plaintext.
- * @param tag Pointer to the authentication tag (16 bytes, same as used during encryption).
+ * Updates made while the snapshot is taken may or may not be included.
  *
- * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ * @param snapshot Pointer to store the totals.
  */
-SecureCommError decrypt_data(const unsigned char* ciphertext, int ciphertext_len,
-                             const unsigned char* key, const unsigned char* iv,
-                             unsigned char* plaintext, int* plaintext_len,
-                             const unsigned char* tag);
+void metrics_snapshot(MetricsSnapshot* snapshot);
 
 /**
- * @brief Compresses data using zlib (deflate) with dynamic buffer allocation.
- *
- * This function compresses the input data using the deflate algorithm provided by zlib.
- * It dynamically allocates memory for the compressed data, which must be freed by the caller.
+ * @brief Zeroes every counter and stage.
+ */
+void metrics_reset(void);
+
+/**
+ * @brief Estimates a latency quantile of a stage from its histogram.
  *
- * @param input Pointer to the data to compress.
- * @param input_len Length of the input data in bytes.
- * @param compressed_ptr Pointer to store the pointer to the compressed data buffer.
- * @param compressed_len Pointer to store the length of the compressed data.
- * @param level Compression level (0-9). 0 = no compression, 9 = maximum compression.
+ * @param stage Stage totals from metrics_snapshot.
+ * @param quantile Quantile between 0 and 1 (for example 0.99).
  *
- * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ * @return Upper bound of the bucket holding the quantile in ns (capped at the
+ *         maximum seen), or 0 if the stage has no samples.
  */
-SecureCommError compress_data_dynamic(const unsigned char* input, size_t input_len,
-                                      unsigned char** compressed_ptr, size_t* compressed_len,
-                                      int level);
+uint64_t metrics_stage_quantile_ns(const MetricsStageSnapshot* stage, double quantile);
 
 /**
- * @brief Decompresses data using zlib (inflate) with dynamic buffer allocation.
+ * @brief Returns the exclusive upper bound, in ns, of a latency bucket.
+ */
+uint64_t metrics_bucket_upper_ns(size_t bucket);
+
+/**
+ * @brief Returns the name of a counter as used in the Prometheus output.
+ */
+const char* metrics_counter_name(MetricCounter counter);
+
+/**
+ * @brief Returns the name of a stage as used in the Prometheus output.
+ */
+const char* metrics_stage_name(MetricStage stage);
+
+/**
+ * @brief Renders the current metrics in the Prometheus text exposition format.
  *
- * This function decompresses the input data using the inflate algorithm provided by zlib.
- * It dynamically allocates memory for the decompressed data, which must be freed by the caller.
+ * Latency histograms are exported with power-of-two bucket bounds in seconds.
  *
- * @param compressed Pointer to the data to decompress.
- * @param compressed_len Length of the compressed data in bytes.
- * @param output_ptr Pointer to store the pointer to the decompressed data buffer.
- * @param output_len Pointer to store the length of the decompressed data.
+ * @param text Pointer to store the NUL-terminated text (caller frees).
+ * @param len Optional pointer to store the text length.
  *
- * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ * @return SECURE_COMM_SUCCESS on success, or SECURE_COMM_ERR_MEMORY.
  */
-SecureCommError decompress_data_dynamic(const unsigned char* compressed, size_t compressed_len,
-                                        unsigned char** output_ptr, size_t* output_len);
+SecureCommError metrics_format_prometheus(char** text, size_t* len);
+
+// Opaque structure for the HTTP endpoint serving metrics_format_prometheus
+typedef struct MetricsEndpoint MetricsEndpoint;
 
 /**
- * @brief Initializes a user session.
+ * @brief Serves GET /metrics from a background thread.
  *
- * This function initializes a new user session, performing necessary authentication
- * and establishing secure key exchanges.
+ * Every request gets its own short-lived connection; anything other than
+ * GET /metrics receives 404.
  *
- * @param username The username of the user initiating the session.
- * @param password The password of the user (for authentication).
- * @param session Pointer to store the created UserSession.
+ * @param address IPv4 address to listen on, or NULL for 127.0.0.1.
+ * @param port Port to listen on, or 0 to pick a free one (see metrics_endpoint_port).
+ * @param endpoint Pointer to store the created MetricsEndpoint.
  *
  * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
  */
-SecureCommError initialize_session(const char* username, const char* password, UserSession** session);
+SecureCommError metrics_endpoint_start(const char* address, int port, MetricsEndpoint** endpoint);
 
 /**
- * @brief Terminates a user session.
- *
- * This function terminates an existing user session, freeing all associated resources.
+ * @brief Returns the port the endpoint is listening on.
+ */
+int metrics_endpoint_port(const MetricsEndpoint* endpoint);
+
+/**
+ * @brief Stops the endpoint thread and closes its socket.
  *
- * @param session Pointer to the UserSession to terminate.
+ * @param endpoint The endpoint to stop.
  */
-void terminate_session(UserSession* session);
+void metrics_endpoint_stop(MetricsEndpoint* endpoint);
 
 // -----------------------------------
 // Utilities Module Function Declarations
@@ -238,6 +3163,35 @@ typedef enum {
     LOG_LEVEL_DEBUG         // Debugging messages
 } LogLevel;
 
+// Least severe level compiled into calls made through the LOG_* macros. Set by the
+// SECURE_COMM_MIN_LOG_LEVEL CMake option; macros above it expand to nothing.
+#ifndef SECURE_COMM_MIN_LOG_LEVEL
+#define SECURE_COMM_MIN_LOG_LEVEL 3 // LOG_LEVEL_DEBUG: keep everything
+#endif
+
+// Runtime level set by init_logging and logging_set_level (a SIGHUP reload may change it
+// while other threads log). Read by the LOG_* macros before they evaluate any argument.
+extern _Atomic LogLevel secure_comm_log_level;
+
+/**
+ * @brief Logs through log_message only if the level is enabled.
+ *
+ * The level is checked before the arguments are evaluated, so a disabled call
+ * costs one comparison. Calls above SECURE_COMM_MIN_LOG_LEVEL fold to nothing.
+ */
+#define LOG_AT(level, ...)                                                                   \
+    do {                                                                                     \
+        if ((level) <= SECURE_COMM_MIN_LOG_LEVEL &&                                          \
+            (level) <= atomic_load_explicit(&secure_comm_log_level, memory_order_relaxed)) { \
+            log_message((level), __VA_ARGS__);                                               \
+        }                                                                                    \
+    } while (0)
+
+#define LOG_ERROR(...) LOG_AT(LOG_LEVEL_ERROR, __VA_ARGS__)
+#define LOG_WARN(...) LOG_AT(LOG_LEVEL_WARN, __VA_ARGS__)
+#define LOG_INFO(...) LOG_AT(LOG_LEVEL_INFO, __VA_ARGS__)
+#define LOG_DEBUG(...) LOG_AT(LOG_LEVEL_DEBUG, __VA_ARGS__)
+
 /**
  * @brief Initializes the logging system.
  *
@@ -251,6 +3205,117 @@ typedef enum {
  */
 SecureCommError init_logging(LogLevel level, const char* log_file_path);
 
+// Longest formatted message kept per log line; longer messages are truncated
+#define SECURE_LOG_MESSAGE_MAX 1024
+
+/**
+ * @brief What an async log producer does when the ring is full.
+ */
+typedef enum {
+    LOG_FULL_DROP = 0,  // Discard the line and count it in LogStats.dropped (never blocks)
+    LOG_FULL_BLOCK      // Wait for the writer thread to free a slot
+} LogFullPolicy;
+
+/**
+ * @brief Parameters for init_logging_async.
+ */
+typedef struct {
+    size_t capacity;                // Ring slots, rounded up to a power of two
+    LogFullPolicy on_full;          // Drop or block when every slot is taken
+    unsigned int flush_interval_ms; // Longest a queued line waits before it is written
+} AsyncLogConfig;
+
+/**
+ * @brief Counters of the async logger.
+ */
+typedef struct {
+    uint64_t written;   // Lines written by the writer thread
+    uint64_t dropped;   // Lines discarded because the ring was full (LOG_FULL_DROP)
+    uint64_t blocked;   // Times a producer had to wait for a slot (LOG_FULL_BLOCK)
+} LogStats;
+
+/**
+ * @brief Fills an AsyncLogConfig with the defaults (1024 slots, drop, 100 ms).
+ *
+ * @param config The configuration to fill.
+ */
+void async_log_config_defaults(AsyncLogConfig* config);
+
+/**
+ * @brief Initializes logging with a background writer thread.
+ *
+ * log_message formats the line into a slot of a lock-free multi-producer ring and
+ * returns; it never takes a lock or touches the file. The writer thread adds the
+ * timestamp, writes whole batches and flushes once per batch. cleanup_logging
+ * writes every queued line before it returns.
+ *
+ * @param level The minimum log level to output.
+ * @param log_file_path The file path for logging output. If NULL, logs will be output to the console.
+ * @param config Ring parameters, or NULL for the defaults.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError init_logging_async(LogLevel level, const char* log_file_path, const AsyncLogConfig* config);
+
+/**
+ * @brief Copies the async logger counters (all zero in synchronous mode).
+ *
+ * @param stats Pointer to store the counters.
+ */
+void logging_stats(LogStats* stats);
+
+// First bytes of a binary log file
+#define SECURE_BINLOG_MAGIC "SCBLOG01"
+
+/**
+ * @brief Initializes logging into a compact binary file instead of text lines.
+ *
+ * Each format string is written once, the first time it is logged, together with
+ * an ID. Every later line stores only that ID, the level, a monotonic timestamp
+ * and the raw argument values; nothing is formatted at run time. Formats that
+ * cannot be parsed (such as %n) are formatted and stored as text. Use
+ * binary_log_decode (or the secure_log_decode tool) to read the file back.
+ *
+ * @param level The minimum log level to output.
+ * @param log_file_path The binary log file to create (truncated if it exists).
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError init_logging_binary(LogLevel level, const char* log_file_path);
+
+/**
+ * @brief Converts a binary log back into "[time] [LEVEL] message" text lines.
+ *
+ * @param in The binary log, positioned at its start.
+ * @param out Destination for the text lines.
+ * @param records Optional pointer to store the number of lines decoded.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or SECURE_COMM_ERR_LOG for a damaged or
+ *         truncated file (lines before the damage are still written).
+ */
+SecureCommError binary_log_decode(FILE* in, FILE* out, size_t* records);
+
+/**
+ * @brief Reports whether log_message currently writes to the binary sink.
+ */
+int binary_log_active(void);
+
+/**
+ * @brief Writes one line to the binary sink (called by log_message).
+ *
+ * @param level The log level of the message.
+ * @param format The format string (printf-style); its address identifies it.
+ * @param args Arguments for the format string.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError binary_log_vwrite(LogLevel level, const char* format, va_list args);
+
+/**
+ * @brief Flushes and closes the binary sink (called by cleanup_logging).
+ */
+void binary_log_close(void);
+
 /**
  * @brief Logs a message with the specified log level.
  *
@@ -270,6 +3335,13 @@ SecureCommError log_message(LogLevel level, const char* format, ...);
  */
 void cleanup_logging();
 
+/**
+ * @brief Changes the minimum log level at run time (used when the configuration is reloaded).
+ *
+ * @param level The new minimum level.
+ */
+void logging_set_level(LogLevel level);
+
 /**
  * @brief Structure to hold configuration parameters.
  *
@@ -281,6 +3353,24 @@ typedef struct {
     int server_port;
     LogLevel log_level;
     char log_file_path[512];
+    int log_async;                  // "log_async": write logs from a background thread
+    LogFullPolicy log_full_policy;  // "log_queue_full": "drop" (default) or "block"
+    int log_binary;                 // "log_format": "binary" writes through init_logging_binary
+    int worker_threads;             // "worker_threads": CPU workers (worker_pool_default), 0 for one per CPU
+    int worker_pin_cpus;            // "worker_pin_cpus": pin each worker to one CPU
+    int tls_ktls;                   // "tls_ktls": let the kernel encrypt TLS records (networking_set_ktls)
+    int connect_timeout_ms;         // "connect_timeout_ms": limit on connecting to the server (networking_set_connect_timeout)
+    int reactor_threads;            // "reactor_threads": event loops of --reactor when no count is given (default 1)
+    int listen_backlog;             // "listen_backlog": queue length passed to listen(), 0 for the mode's default
+    int socket_rcvbuf;              // "socket_rcvbuf": SO_RCVBUF of connection sockets in bytes, 0 keeps the kernel's
+    int socket_sndbuf;              // "socket_sndbuf": SO_SNDBUF of connection sockets in bytes, 0 keeps the kernel's
+    CompressionCodecId compression_codec; // "compression_codec": codec of well-compressible messages (default "zlib")
+    int compression_level;          // "compression_level": level for compression_codec, -1 for the codec's default
+    int max_in_flight;              // "max_in_flight": records per connection being opened on the workers (default 64)
+    size_t buffer_pool_slab_size;   // "buffer_pool_slab_size": bytes buffer_pool_default allocates at once
+    size_t buffer_pool_thread_cache; // "buffer_pool_thread_cache": free buffers each thread keeps per size class
+    size_t log_queue_capacity;      // "log_queue_capacity": slots of the log_async ring
+    size_t reactor_max_output;      // "reactor_max_output": bytes queued for a reactor client before it is dropped (0: 4 MB)
     // Add additional configuration fields as needed
 } Configuration;
 
@@ -298,5 +3388,91 @@ typedef struct {
  */
 SecureCommError load_configuration(const char* config_path, Configuration* config);
 
+/**
+ * @brief Reports whether going from one configuration to another needs a restart.
+ *
+ * Log level, socket buffer sizes, compression codec and level, max_in_flight and
+ * connect_timeout_ms take effect at run time; every other field is read once at startup.
+ *
+ * @return 1 if a field that is only read at startup differs, 0 otherwise.
+ */
+int config_restart_required(const Configuration* previous, const Configuration* current);
+
+// -----------------------------------
+// Configuration Reload Function Declarations
+// -----------------------------------
+
+/**
+ * @brief Called on the reload thread after a new configuration has been published.
+ *
+ * @param previous The configuration that was replaced (still valid until config_cleanup).
+ * @param current The configuration now returned by config_current.
+ * @param user_data Value passed to config_watch_sighup.
+ */
+typedef void (*config_reload_fn)(const Configuration* previous, const Configuration* current, void* user_data);
+
+/**
+ * @brief Publishes a configuration for config_current.
+ *
+ * The configuration is copied into a new snapshot and swapped in with one atomic
+ * store, so readers never lock. Replaced snapshots are kept until config_cleanup,
+ * so a pointer a reader already holds stays valid.
+ *
+ * @param config The configuration to publish.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or SECURE_COMM_ERR_MEMORY on failure.
+ */
+SecureCommError config_publish(const Configuration* config);
+
+/**
+ * @brief Returns the configuration published last, or NULL if none has been.
+ */
+const Configuration* config_current(void);
+
+/**
+ * @brief Counts published configurations, so a reader can tell cheaply whether its
+ *        settings are stale.
+ */
+uint64_t config_generation(void);
+
+/**
+ * @brief Loads a configuration file and publishes it.
+ *
+ * An invalid file leaves the current configuration in place.
+ *
+ * @param config_path The file path to the JSON configuration file.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or the error of load_configuration.
+ */
+SecureCommError config_reload(const char* config_path);
+
+/**
+ * @brief Reloads the configuration file whenever the process receives SIGHUP.
+ *
+ * The signal handler only wakes a dedicated thread, which runs config_reload and
+ * then on_reload. The handler is installed with SA_RESTART, so blocking calls
+ * elsewhere are not interrupted and no connection is dropped.
+ *
+ * @param config_path The file path to reload.
+ * @param on_reload Optional function applying the settings that take effect at run time.
+ * @param user_data Passed to on_reload.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or SECURE_COMM_ERR_INIT if a watch is
+ *         already running or the thread cannot be started.
+ */
+SecureCommError config_watch_sighup(const char* config_path, config_reload_fn on_reload, void* user_data);
+
+/**
+ * @brief Stops the SIGHUP watch and restores the previous SIGHUP handler.
+ */
+void config_unwatch_sighup(void);
+
+/**
+ * @brief Stops the SIGHUP watch and frees every published snapshot.
+ *
+ * No pointer returned by config_current may be used afterwards.
+ */
+void config_cleanup(void);
+
 
 #endif // SECURE_COMM_H
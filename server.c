@@ -9,43 +9,201 @@
 #include <arpa/inet.h>      // For sockaddr_in, inet_ntoa()
 #include <pthread.h>        // For threading
 #include <errno.h>          // For errno and strerror
+#include <signal.h>         // For SIGINT/SIGTERM in reactor mode
+
+#include <openssl/rand.h>   // For the per-connection nonce salt
+#include <openssl/crypto.h> // For OPENSSL_cleanse
 
 #define BUFFER_SIZE 4096
 #define IV_SIZE 12          // 12 bytes IV for AES-GCM
 #define TAG_SIZE 16         // 16 bytes authentication tag
+#define RECORD_OVERHEAD (IV_SIZE + TAG_SIZE)
+
+// Loaded at startup and again on every SIGHUP
+#define SERVER_CONFIG_PATH "../server_config.json"
 
 // Function prototypes
 void* handle_client(void* arg);
+void* console_thread_func(void* arg);
 void* sender_thread_func(void* arg);
 void* receiver_thread_func(void* arg);
+int run_reactor_server(int server_sock, int num_threads, ReactorBackend backend);
 
 // Structure to pass data to client handler threads
 typedef struct {
     int client_sock;
+    SecureConnection* conn;     // Transport created on the handler thread (plain TCP or TLS)
     struct sockaddr_in client_addr;
-    unsigned char session_key[32];
+    unsigned char session_key[32]; // Connection key derived from the shared key and the HELLO salt
+    SecureCipher* cipher;       // Keyed AEAD handle (negotiated suite) shared by the sender and receiver threads
+    ReplayWindow replay;        // Sequence numbers already received from the client
+    BroadcastSubscriber* subscriber; // Queue of frames for this client, filled by the console thread
+    WorkerSequence* inbound;    // Received records, opened on the worker pool and printed in order
+    SecureCipher** open_ciphers; // One decryption handle per pool worker, made on first use
+    size_t open_cipher_count;
+    uint64_t records_rejected;  // Records that failed authentication or were replays (completion order)
 } server_thread_data_t;
 
+// One received record on its way through the worker pool
+typedef struct {
+    server_thread_data_t* data;
+    SecureBuffer* record;       // IV || tag || ciphertext, opened in place
+    SecureBuffer* expanded;     // Decompressed message, if the frame was compressed
+    uint8_t codec;
+    uint64_t sequence;          // Nonce sequence number, checked against the replay window in order
+    SecureCommError status;
+} inbound_record_t;
+
 // Mutex for console access
 pthread_mutex_t console_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+// Set by --tls: threaded connections are wrapped in TLS using the shared server context
+static int use_tls = 0;
+
+// Threaded mode: the console broadcasts every line to all connected clients
+#define BROADCAST_TOPIC "all"
+static BroadcastHub* broadcast_hub = NULL;
+
+/**
+ * @brief Creates the per-connection cipher with counter-based nonces.
+ *
+ * The key must be the connection key from cipher_derive_key, never the shared
+ * session key itself: with one key across connections, two connections would
+ * repeat each other's nonces once their random salts collide. Client and server
+ * share the connection key, so the top bit of the salt marks the direction: set
+ * for server-to-client, clear for client-to-server. The two sides can therefore
+ * never produce the same nonce.
+ */
+static SecureCommError create_connection_cipher(CipherSuite suite, const unsigned char* key, size_t key_len,
+                                                SecureCipher** cipher) {
+    unsigned char salt[SECURE_NONCE_SALT_SIZE];
+    if (!RAND_bytes(salt, sizeof(salt))) {
+        return SECURE_COMM_ERR_ENCRYPT;
+    }
+    salt[0] |= 0x80;
+
+    SecureCommError ret = cipher_create_suite(suite, key, key_len, cipher);
+    if (ret != SECURE_COMM_SUCCESS) {
+        return ret;
+    }
+
+    ret = cipher_use_counter_nonces(*cipher, salt);
+    if (ret != SECURE_COMM_SUCCESS) {
+        cipher_destroy(*cipher);
+        *cipher = NULL;
+    }
+    return ret;
+}
+
+/**
+ * @brief Sets the socket buffer sizes of the listening socket; accepted sockets inherit them.
+ */
+static void apply_socket_buffers(int listen_fd, const Configuration* config) {
+    if (config->socket_rcvbuf > 0 &&
+        setsockopt(listen_fd, SOL_SOCKET, SO_RCVBUF, &config->socket_rcvbuf, sizeof(config->socket_rcvbuf)) < 0) {
+        LOG_WARN("setsockopt(SO_RCVBUF) failed: %s", strerror(errno));
+    }
+    if (config->socket_sndbuf > 0 &&
+        setsockopt(listen_fd, SOL_SOCKET, SO_SNDBUF, &config->socket_sndbuf, sizeof(config->socket_sndbuf)) < 0) {
+        LOG_WARN("setsockopt(SO_SNDBUF) failed: %s", strerror(errno));
+    }
+}
+
+/**
+ * @brief Applies a reloaded configuration. Everything else reads config_current when it needs a setting.
+ */
+static void on_config_reload(const Configuration* previous, const Configuration* current, void* user_data) {
+    int listen_fd = *(int*)user_data;
+    logging_set_level(current->log_level);
+    apply_socket_buffers(listen_fd, current);
+    if (config_restart_required(previous, current)) {
+        LOG_WARN("%s changed settings that only take effect after a restart", SERVER_CONFIG_PATH);
+    }
+}
+
+// Predefined session key (must be the same on both client and server)
+static const unsigned char predefined_session_key[32] = {
+    0x00, 0x01, 0x02, 0x03,
+    0x04, 0x05, 0x06, 0x07,
+    0x08, 0x09, 0x0A, 0x0B,
+    0x0C, 0x0D, 0x0E, 0x0F,
+    0x10, 0x11, 0x12, 0x13,
+    0x14, 0x15, 0x16, 0x17,
+    0x18, 0x19, 0x1A, 0x1B,
+    0x1C, 0x1D, 0x1E, 0x1F
+};
+
 int main(int argc, char* argv[]) {
     printf("Server starting...\n");
 
+    // Parse command line: --reactor [threads] selects the event-driven core,
+    // --tls <cert> <key> wraps threaded-mode connections in TLS,
+    // --metrics <port> serves Prometheus metrics on that port,
+    // --group-key seals threaded-mode broadcasts once under a shared group key
+    int use_reactor = 0;
+    BroadcastMode broadcast_mode = BROADCAST_PER_RECIPIENT;
+    const char* tls_cert = NULL;
+    const char* tls_key = NULL;
+    int metrics_port = -1;
+    int reactor_threads = 0;    // 0 takes "reactor_threads" from the configuration
+    ReactorBackend reactor_backend = REACTOR_BACKEND_EPOLL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--reactor") == 0) {
+            use_reactor = 1;
+            if (i + 1 < argc && atoi(argv[i + 1]) > 0) {
+                reactor_threads = atoi(argv[++i]);
+            }
+        } else if (strcmp(argv[i], "--io-uring") == 0) {
+            reactor_backend = REACTOR_BACKEND_IO_URING;
+        } else if (strcmp(argv[i], "--tls") == 0 && i + 2 < argc) {
+            use_tls = 1;
+            tls_cert = argv[++i];
+            tls_key = argv[++i];
+        } else if (strcmp(argv[i], "--metrics") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0) {
+            metrics_port = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--group-key") == 0) {
+            broadcast_mode = BROADCAST_GROUP_KEY;
+        } else {
+            fprintf(stderr, "Usage: %s [--reactor [threads]] [--io-uring] [--tls <cert> <key>] [--metrics <port>] "
+                    "[--group-key]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (use_tls && use_reactor) {
+        fprintf(stderr, "server: --tls is only supported in threaded mode\n");
+        return EXIT_FAILURE;
+    }
+
     // Load configuration
     Configuration config;
-    SecureCommError config_ret = load_configuration("../server_config.json", &config);
+    SecureCommError config_ret = load_configuration(SERVER_CONFIG_PATH, &config);
+    if (config_ret == SECURE_COMM_SUCCESS) {
+        config_ret = config_publish(&config);
+    }
     if (config_ret != SECURE_COMM_SUCCESS) {
         fprintf(stderr, "server: Failed to load configuration. Error code: %d\n", config_ret);
         return EXIT_FAILURE;
     }
+    if (reactor_threads == 0) {
+        reactor_threads = config.reactor_threads;
+    }
 
     // Initialize logging
+    // An empty log_file_path logs to the console; log_async moves the writes to a background
+    // thread and log_format "binary" writes the compact format read by secure_log_decode
     SecureCommError log_ret;
-    if (strlen(config.log_file_path) > 0) {
-        log_ret = init_logging(config.log_level, config.log_file_path);
+    const char* log_path = strlen(config.log_file_path) > 0 ? config.log_file_path : NULL;
+    if (config.log_binary) {
+        log_ret = init_logging_binary(config.log_level, log_path);
+    } else if (config.log_async) {
+        AsyncLogConfig async_config;
+        async_log_config_defaults(&async_config);
+        async_config.on_full = config.log_full_policy;
+        async_config.capacity = config.log_queue_capacity;
+        log_ret = init_logging_async(config.log_level, log_path, &async_config);
     } else {
-        log_ret = init_logging(config.log_level, NULL); // Log to console
+        log_ret = init_logging(config.log_level, log_path);
     }
 
     if (log_ret != SECURE_COMM_SUCCESS) {
@@ -53,12 +211,37 @@ int main(int argc, char* argv[]) {
         return EXIT_FAILURE;
     }
 
-    log_message(LOG_LEVEL_INFO, "Server starting...");
+    LOG_INFO("Server starting...");
+
+    // Decryption, decompression and the batch AEAD calls run on the shared worker pool
+    WorkerPoolConfig pool_config;
+    worker_pool_config_defaults(&pool_config);
+    pool_config.threads = (size_t)config.worker_threads;
+    pool_config.pin_threads = config.worker_pin_cpus;
+    worker_pool_configure_default(&pool_config);
+
+    // Records and frames are carved from the shared buffer pool
+    BufferPoolConfig buffer_config;
+    buffer_pool_config_defaults(&buffer_config);
+    buffer_config.slab_size = config.buffer_pool_slab_size;
+    buffer_config.thread_cache = config.buffer_pool_thread_cache;
+    buffer_pool_configure_default(&buffer_config);
+
+    // kTLS only takes effect for contexts and connections created after this
+    networking_set_ktls(config.tls_ktls);
+    if (init_networking() != SECURE_COMM_SUCCESS ||
+        (use_tls && init_server_tls(tls_cert, tls_key) != SECURE_COMM_SUCCESS)) {
+        LOG_ERROR("Failed to initialize networking");
+        cleanup_networking();
+        cleanup_logging();
+        return EXIT_FAILURE;
+    }
 
     // Initialize server socket
     int server_sock = socket(AF_INET, SOCK_STREAM, 0);
     if (server_sock < 0) {
-        log_message(LOG_LEVEL_ERROR, "Failed to create socket: %s", strerror(errno));
+        LOG_ERROR("Failed to create socket: %s", strerror(errno));
+        cleanup_networking();
         cleanup_logging();
         return EXIT_FAILURE;
     }
@@ -66,8 +249,10 @@ int main(int argc, char* argv[]) {
     // Allow socket reuse
     int opt = 1;
     if (setsockopt(server_sock, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0) {
-        log_message(LOG_LEVEL_WARN, "setsockopt(SO_REUSEADDR) failed: %s", strerror(errno));
+        LOG_WARN("setsockopt(SO_REUSEADDR) failed: %s", strerror(errno));
     }
+    // Set before listen() so the window scale of accepted connections covers the buffers
+    apply_socket_buffers(server_sock, &config);
 
     // Bind socket to the specified address and port
     struct sockaddr_in server_addr;
@@ -76,62 +261,105 @@ int main(int argc, char* argv[]) {
     server_addr.sin_addr.s_addr = inet_addr(config.server_address);
 
     if (bind(server_sock, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
-        log_message(LOG_LEVEL_ERROR, "Failed to bind socket: %s", strerror(errno));
+        LOG_ERROR("Failed to bind socket: %s", strerror(errno));
         close(server_sock);
+        cleanup_networking();
         cleanup_logging();
         return EXIT_FAILURE;
     }
 
-    log_message(LOG_LEVEL_INFO, "Server listening on %s:%d", config.server_address, config.server_port);
+    LOG_INFO("Server listening on %s:%d", config.server_address, config.server_port);
+
+    // Metrics are served from their own thread on the same address
+    MetricsEndpoint* metrics_endpoint = NULL;
+    if (metrics_port > 0) {
+        if (metrics_endpoint_start(config.server_address, metrics_port, &metrics_endpoint) == SECURE_COMM_SUCCESS) {
+            LOG_INFO("Serving metrics on http://%s:%d/metrics", config.server_address, metrics_port);
+        } else {
+            LOG_WARN("Failed to start the metrics endpoint on port %d", metrics_port);
+        }
+    }
 
     // Listen for incoming connections
-    if (listen(server_sock, 5) < 0) {
-        log_message(LOG_LEVEL_ERROR, "Failed to listen on socket: %s", strerror(errno));
+    int backlog = config.listen_backlog > 0 ? config.listen_backlog : (use_reactor ? SOMAXCONN : 5);
+    if (listen(server_sock, backlog) < 0) {
+        LOG_ERROR("Failed to listen on socket: %s", strerror(errno));
+        metrics_endpoint_stop(metrics_endpoint);
         close(server_sock);
+        cleanup_networking();
         cleanup_logging();
         return EXIT_FAILURE;
     }
 
+    // SIGHUP re-reads the configuration file; connections stay up
+    if (config_watch_sighup(SERVER_CONFIG_PATH, on_config_reload, &server_sock) != SECURE_COMM_SUCCESS) {
+        LOG_WARN("Configuration reload on SIGHUP is unavailable");
+    }
+
+    if (use_reactor) {
+        int reactor_ret = run_reactor_server(server_sock, reactor_threads, reactor_backend);
+        config_cleanup();
+        metrics_endpoint_stop(metrics_endpoint);
+        close(server_sock);
+        cleanup_networking();
+        cleanup_logging();
+        return reactor_ret;
+    }
+
+    // A peer closing mid-write must fail the send, not kill the process
+    signal(SIGPIPE, SIG_IGN);
+
+    // Console input is encrypted for every client by one hub; each client's sender
+    // thread only drains its own queue
+    pthread_t console_thread;
+    if (broadcast_hub_create(NULL, &broadcast_hub) != SECURE_COMM_SUCCESS ||
+        broadcast_topic_create(broadcast_hub, BROADCAST_TOPIC, broadcast_mode) != SECURE_COMM_SUCCESS ||
+        pthread_create(&console_thread, NULL, console_thread_func, NULL) != 0) {
+        LOG_ERROR("Failed to set up broadcasting");
+        broadcast_hub_destroy(broadcast_hub);
+        config_cleanup();
+        metrics_endpoint_stop(metrics_endpoint);
+        close(server_sock);
+        cleanup_networking();
+        cleanup_logging();
+        return EXIT_FAILURE;
+    }
+    pthread_detach(console_thread);
+    LOG_INFO("Broadcasting console input with %s",
+             broadcast_mode == BROADCAST_GROUP_KEY ? "a shared group key" : "per-client keys");
+
     while (1) {
         struct sockaddr_in client_addr;
         socklen_t client_len = sizeof(client_addr);
         int client_sock = accept(server_sock, (struct sockaddr*)&client_addr, &client_len);
         if (client_sock < 0) {
-            log_message(LOG_LEVEL_WARN, "Failed to accept connection: %s", strerror(errno));
+            LOG_WARN("Failed to accept connection: %s", strerror(errno));
             continue;
         }
 
-        log_message(LOG_LEVEL_INFO, "Accepted connection from %s:%d",
-                    inet_ntoa(client_addr.sin_addr), ntohs(client_addr.sin_port));
+        LOG_INFO("Accepted connection from %s:%d",
+                 inet_ntoa(client_addr.sin_addr), ntohs(client_addr.sin_port));
 
         // Allocate memory for client info
         server_thread_data_t* thread_data = (server_thread_data_t*)malloc(sizeof(server_thread_data_t));
         if (!thread_data) {
-            log_message(LOG_LEVEL_ERROR, "Failed to allocate memory for client info");
+            LOG_ERROR("Failed to allocate memory for client info");
             close(client_sock);
             continue;
         }
         thread_data->client_sock = client_sock;
+        thread_data->conn = NULL;
+        thread_data->records_rejected = 0;
+        thread_data->inbound = NULL;
+        thread_data->open_ciphers = NULL;
+        thread_data->open_cipher_count = 0;
         thread_data->client_addr = client_addr;
 
-        // Predefined session key (must be the same on both client and server)
-        unsigned char session_key[32] = {
-            0x00, 0x01, 0x02, 0x03,
-            0x04, 0x05, 0x06, 0x07,
-            0x08, 0x09, 0x0A, 0x0B,
-            0x0C, 0x0D, 0x0E, 0x0F,
-            0x10, 0x11, 0x12, 0x13,
-            0x14, 0x15, 0x16, 0x17,
-            0x18, 0x19, 0x1A, 0x1B,
-            0x1C, 0x1D, 0x1E, 0x1F
-        };
-        memcpy(thread_data->session_key, session_key, 32);
-
         // Create a thread to handle the client
         pthread_t thread_id;
         if (pthread_create(&thread_id, NULL, handle_client, (void*)thread_data) != 0) {
-            log_message(LOG_LEVEL_ERROR, "Failed to create thread for client %s:%d",
-                        inet_ntoa(client_addr.sin_addr), ntohs(client_addr.sin_port));
+            LOG_ERROR("Failed to create thread for client %s:%d",
+                      inet_ntoa(client_addr.sin_addr), ntohs(client_addr.sin_port));
             close(client_sock);
             free(thread_data);
             continue;
@@ -142,7 +370,11 @@ int main(int argc, char* argv[]) {
     }
 
     // Cleanup (unreachable in this example)
+    broadcast_hub_destroy(broadcast_hub);
+    config_cleanup();
+    metrics_endpoint_stop(metrics_endpoint);
     close(server_sock);
+    cleanup_networking();
     cleanup_logging();
     return EXIT_SUCCESS;
 }
@@ -152,25 +384,90 @@ int main(int argc, char* argv[]) {
  */
 void* handle_client(void* arg) {
     server_thread_data_t* data = (server_thread_data_t*)arg;
-    int client_sock = data->client_sock;
     struct sockaddr_in client_addr = data->client_addr;
-    unsigned char* session_key = data->session_key;
+
+    // The TLS handshake runs here so a slow client never stalls the accept loop
+    SecureCommError conn_ret;
+    data->conn = use_tls ? secure_accept(data->client_sock, &conn_ret)
+                         : connection_wrap_socket(data->client_sock, &conn_ret);
+    if (data->conn == NULL) {
+        LOG_ERROR("Failed to set up connection with client %s:%d. Error code: %d",
+                  inet_ntoa(client_addr.sin_addr), ntohs(client_addr.sin_port), conn_ret);
+        close(data->client_sock);
+        free(data);
+        pthread_exit(NULL);
+    }
+    SecureConnection* conn = data->conn;
+
+    // The client names the suites it supports before sending any record
+    CipherSuite suite = CIPHER_SUITE_AES_GCM;
+    unsigned char connection_salt[SECURE_CONNECTION_SALT_SIZE];
+    SecureCommError suite_ret = cipher_negotiate_server(conn, &suite, connection_salt);
+    if (suite_ret != SECURE_COMM_SUCCESS) {
+        LOG_ERROR("Failed to negotiate a cipher suite with client %s:%d. Error code: %d",
+                  inet_ntoa(client_addr.sin_addr), ntohs(client_addr.sin_port), suite_ret);
+        close_connection(conn);
+        free(data);
+        pthread_exit(NULL);
+    }
+    LOG_INFO("Client %s:%d uses cipher suite %s",
+             inet_ntoa(client_addr.sin_addr), ntohs(client_addr.sin_port), cipher_suite_name(suite));
+
+    // Key this connection on its own (session key, then connection key, as in reactor mode),
+    // then expand that key once for the whole connection
+    replay_window_init(&data->replay);
+    unsigned char session_key[sizeof(data->session_key)];
+    int keyed = cipher_derive_key(predefined_session_key, sizeof(predefined_session_key), connection_salt,
+                                  sizeof(connection_salt), SECURE_SESSION_KEY_LABEL,
+                                  session_key, sizeof(session_key)) == SECURE_COMM_SUCCESS &&
+                cipher_derive_key(session_key, sizeof(session_key), connection_salt, sizeof(connection_salt),
+                                  SECURE_CONNECTION_KEY_LABEL, data->session_key,
+                                  sizeof(data->session_key)) == SECURE_COMM_SUCCESS;
+    OPENSSL_cleanse(session_key, sizeof(session_key));
+    if (!keyed ||
+        create_connection_cipher(suite, data->session_key, sizeof(data->session_key), &data->cipher) != SECURE_COMM_SUCCESS) {
+        LOG_ERROR("Failed to create cipher for client %s:%d",
+                  inet_ntoa(client_addr.sin_addr), ntohs(client_addr.sin_port));
+        close_connection(conn);
+        free(data);
+        pthread_exit(NULL);
+    }
+
+    // Subscribe before the threads start; group topics queue their key first
+    data->subscriber = NULL;
+    if (broadcast_subscriber_create(broadcast_hub, data->cipher, &data->subscriber) != SECURE_COMM_SUCCESS ||
+        broadcast_subscribe(data->subscriber, BROADCAST_TOPIC) != SECURE_COMM_SUCCESS) {
+        LOG_ERROR("Failed to subscribe client %s:%d to broadcasts",
+                  inet_ntoa(client_addr.sin_addr), ntohs(client_addr.sin_port));
+        broadcast_subscriber_destroy(data->subscriber);
+        close_connection(conn);
+        cipher_destroy(data->cipher);
+        free(data);
+        pthread_exit(NULL);
+    }
 
     // Create sender and receiver threads
     pthread_t sender_thread, receiver_thread;
 
     if (pthread_create(&sender_thread, NULL, sender_thread_func, (void*)data) != 0) {
-        log_message(LOG_LEVEL_ERROR, "Failed to create sender thread for client %s:%d",
-                    inet_ntoa(client_addr.sin_addr), ntohs(client_addr.sin_port));
-        close(client_sock);
+        LOG_ERROR("Failed to create sender thread for client %s:%d",
+                  inet_ntoa(client_addr.sin_addr), ntohs(client_addr.sin_port));
+        broadcast_subscriber_destroy(data->subscriber);
+        close_connection(conn);
+        cipher_destroy(data->cipher);
         free(data);
         pthread_exit(NULL);
     }
 
     if (pthread_create(&receiver_thread, NULL, receiver_thread_func, (void*)data) != 0) {
-        log_message(LOG_LEVEL_ERROR, "Failed to create receiver thread for client %s:%d",
-                    inet_ntoa(client_addr.sin_addr), ntohs(client_addr.sin_port));
-        close(client_sock);
+        LOG_ERROR("Failed to create receiver thread for client %s:%d",
+                  inet_ntoa(client_addr.sin_addr), ntohs(client_addr.sin_port));
+        // The sender is already draining the queue; closing it lets the thread finish
+        broadcast_subscriber_close(data->subscriber);
+        pthread_join(sender_thread, NULL);
+        broadcast_subscriber_destroy(data->subscriber);
+        close_connection(conn);
+        cipher_destroy(data->cipher);
         free(data);
         pthread_exit(NULL);
     }
@@ -178,38 +475,54 @@ void* handle_client(void* arg) {
     // Wait for the sender thread to finish
     pthread_join(sender_thread, NULL);
 
-    // Close the socket to signal the receiver thread to exit
-    close(client_sock);
+    // Shut the connection down to wake the receiver thread blocked in secure_recv
+    connection_shutdown(conn);
 
     // Wait for the receiver thread to finish
     pthread_join(receiver_thread, NULL);
 
+    ConnectionStats stats;
+    BroadcastSubscriberStats queue_stats;
+    connection_get_stats(conn, &stats);
+    broadcast_subscriber_stats(data->subscriber, &queue_stats);
+    LOG_INFO("Client %s:%d closed: %llu bytes received, %llu bytes sent, %llu records rejected, "
+             "%llu broadcasts dropped",
+             inet_ntoa(client_addr.sin_addr), ntohs(client_addr.sin_port),
+             (unsigned long long)stats.bytes_received, (unsigned long long)stats.bytes_sent,
+             (unsigned long long)data->records_rejected, (unsigned long long)queue_stats.dropped);
+
     // Cleanup
+    broadcast_subscriber_destroy(data->subscriber);
+    close_connection(conn);
+    cipher_destroy(data->cipher);
     free(data);
 
     pthread_exit(NULL);
 }
 
 /**
- * @brief Thread function to handle sending messages to the client.
+ * @brief Reads console lines and broadcasts each one to every connected client.
+ *
+ * The line is compressed once; the hub then seals it for each subscriber, or once
+ * for all of them on a group-key topic.
  */
-void* sender_thread_func(void* arg) {
-    server_thread_data_t* data = (server_thread_data_t*)arg;
-    int client_sock = data->client_sock;
-    unsigned char* session_key = data->session_key;
+void* console_thread_func(void* arg) {
+    (void)arg;
+
+    AdaptiveCompressor* compressor = NULL;
+    uint64_t compressor_generation = 0;
 
     while (1) {
         // Lock console to print prompt
         pthread_mutex_lock(&console_mutex);
 
         // Print prompt
-        printf("To client %s:%d: ", inet_ntoa(data->client_addr.sin_addr), ntohs(data->client_addr.sin_port));
+        printf("To all clients: ");
         fflush(stdout); // Ensure prompt is displayed
 
         // Unlock console before blocking on fgets
         pthread_mutex_unlock(&console_mutex);
 
-        // Get user input
         char message[BUFFER_SIZE];
         if (fgets(message, sizeof(message), stdin) == NULL) {
             break;
@@ -222,36 +535,75 @@ void* sender_thread_func(void* arg) {
             msg_len--;
         }
 
-        // Check for exit command
+        // Check for exit command: clients stay connected, the console just stops broadcasting
         if (strcmp(message, "exit") == 0) {
             break;
         }
 
-        unsigned char encrypted_msg[BUFFER_SIZE];
-        int encrypted_len = 0;
-        unsigned char iv[IV_SIZE];
-        unsigned char tag[TAG_SIZE];
-
-        // Encrypt the message
-        SecureCommError encrypt_ret = encrypt_data((unsigned char*)message, msg_len,
-                                                   session_key, iv,
-                                                   encrypted_msg, &encrypted_len, tag);
-        if (encrypt_ret != SECURE_COMM_SUCCESS) {
-            log_message(LOG_LEVEL_ERROR, "Failed to encrypt message to %s:%d. Error code: %d",
-                        inet_ntoa(data->client_addr.sin_addr), ntohs(data->client_addr.sin_port), encrypt_ret);
-            continue;
+        // The compressor follows the codec and level of the current configuration
+        uint64_t generation = config_generation();
+        if (compressor == NULL || generation != compressor_generation) {
+            const Configuration* current = config_current();
+            AdaptiveCompressionConfig adaptive_config;
+            adaptive_config_defaults(&adaptive_config);
+            adaptive_config.strong_codec = current->compression_codec;
+            adaptive_config.strong_level = current->compression_level;
+            AdaptiveCompressor* updated = NULL;
+            if (adaptive_compressor_create(&adaptive_config, &updated) != SECURE_COMM_SUCCESS) {
+                LOG_ERROR("Failed to create adaptive compressor for broadcasts");
+                break;
+            }
+            adaptive_compressor_destroy(compressor);
+            compressor = updated;
+            compressor_generation = generation;
+        }
+
+        // Compress only when it pays off; the frame header records the codec used
+        unsigned char packed[2 * BUFFER_SIZE];
+        size_t packed_len = sizeof(packed);
+        CompressionCodecId codec = COMPRESSION_CODEC_NONE;
+        const unsigned char* payload = (const unsigned char*)message;
+        if (adaptive_compress(compressor, payload, msg_len, packed, &packed_len, &codec) == SECURE_COMM_SUCCESS &&
+            codec != COMPRESSION_CODEC_NONE) {
+            payload = packed;
+            msg_len = packed_len;
+        } else {
+            codec = COMPRESSION_CODEC_NONE;
+        }
+
+        BroadcastResult result;
+        SecureCommError publish_ret = broadcast_publish(broadcast_hub, BROADCAST_TOPIC, codec, payload, msg_len, &result);
+        if (publish_ret != SECURE_COMM_SUCCESS) {
+            LOG_ERROR("Failed to broadcast message. Error code: %d", publish_ret);
+        } else if (result.dropped > 0 || result.disconnected > 0 || result.failed > 0) {
+            LOG_WARN("Broadcast reached %zu of %zu clients (%zu dropped, %zu disconnected, %zu failed)",
+                     result.queued, result.subscribers, result.dropped, result.disconnected, result.failed);
         }
+    }
 
-        // Send the IV + tag + encrypted message
-        unsigned char final_output[IV_SIZE + TAG_SIZE + encrypted_len];
-        memcpy(final_output, iv, IV_SIZE);                             // Copy IV
-        memcpy(final_output + IV_SIZE, tag, TAG_SIZE);                 // Copy authentication tag
-        memcpy(final_output + IV_SIZE + TAG_SIZE, encrypted_msg, encrypted_len); // Copy encrypted data
+    LOG_INFO("Console closed; no further broadcasts");
+    adaptive_compressor_destroy(compressor);
+    pthread_exit(NULL);
+}
+
+/**
+ * @brief Thread function to handle sending messages to the client.
+ *
+ * Sends the frames the console thread queued for this client, in order, until the
+ * subscriber is closed or the connection fails.
+ */
+void* sender_thread_func(void* arg) {
+    server_thread_data_t* data = (server_thread_data_t*)arg;
 
-        ssize_t bytes_sent = send(client_sock, final_output, IV_SIZE + TAG_SIZE + encrypted_len, 0);
-        if (bytes_sent < 0) {
-            log_message(LOG_LEVEL_WARN, "Failed to send message to %s:%d: %s",
-                        inet_ntoa(data->client_addr.sin_addr), ntohs(data->client_addr.sin_port), strerror(errno));
+    SecureBuffer* frame = NULL;
+    while (broadcast_subscriber_next(data->subscriber, -1, &frame) == SECURE_COMM_SUCCESS) {
+        ssize_t bytes_sent = 0;
+        SecureCommError send_ret = secure_send(data->conn, secure_buffer_data(frame), secure_buffer_len(frame),
+                                               &bytes_sent);
+        secure_buffer_release(frame);
+        if (send_ret != SECURE_COMM_SUCCESS) {
+            LOG_WARN("Failed to send message to %s:%d",
+                     inet_ntoa(data->client_addr.sin_addr), ntohs(data->client_addr.sin_port));
             break;
         }
     }
@@ -259,71 +611,586 @@ void* sender_thread_func(void* arg) {
     pthread_exit(NULL);
 }
 
+/**
+ * @brief Returns a pool worker's decryption handle for a connection, creating it on first use.
+ *
+ * cipher_decrypt is not safe to call concurrently on one handle, so every pool
+ * worker opens a connection's records with its own copy of the key schedule.
+ * Other threads (one helping in worker_pool_parallel_for, or the receiver when
+ * the pool is unavailable) get a handle of their own in *temporary.
+ */
+static SecureCipher* open_cipher_for_thread(server_thread_data_t* data, SecureCipher** temporary) {
+    int worker = worker_pool_current_worker(worker_pool_default());
+    SecureCipher** slot = worker >= 0 && (size_t)worker < data->open_cipher_count ? &data->open_ciphers[worker]
+                                                                                 : temporary;
+    if (*slot == NULL &&
+        cipher_create_suite(cipher_get_suite(data->cipher), data->session_key, sizeof(data->session_key),
+                            slot) != SECURE_COMM_SUCCESS) {
+        *slot = NULL;
+    }
+    return *slot;
+}
+
+/**
+ * @brief Worker stage: decrypts and expands one record. Runs on any pool worker, possibly
+ *        alongside later records of the same client.
+ */
+static void inbound_open(void* arg) {
+    inbound_record_t* in = (inbound_record_t*)arg;
+    server_thread_data_t* data = in->data;
+
+    SecureCipher* temporary = NULL;
+    SecureCipher* cipher = open_cipher_for_thread(data, &temporary);
+    if (cipher == NULL || secure_buffer_len(in->record) < RECORD_OVERHEAD) {
+        in->status = SECURE_COMM_ERR_DECRYPT;
+        cipher_destroy(temporary);
+        return;
+    }
+
+    // Decrypt in place: the buffer is advanced past IV || tag to the plaintext
+    in->sequence = nonce_sequence(secure_buffer_data(in->record));
+    in->status = cipher_open_buffer(cipher, in->record);
+    cipher_destroy(temporary);
+    if (in->status != SECURE_COMM_SUCCESS || in->codec == COMPRESSION_CODEC_NONE) {
+        return;
+    }
+
+    // Expand compressed payloads with the codec named in the frame header
+    in->status = codec_decompress_pooled((CompressionCodecId)in->codec, NULL, secure_buffer_data(in->record),
+                                         secure_buffer_len(in->record), 0, BUFFER_SIZE, &in->expanded);
+    if (in->status != SECURE_COMM_SUCCESS) {
+        in->status = SECURE_COMM_ERR_DECOMPRESS;
+    }
+}
+
+/**
+ * @brief Completion stage: replay check and printing, called in the order the records arrived.
+ */
+static void inbound_complete(void* arg, void* user_data) {
+    inbound_record_t* in = (inbound_record_t*)arg;
+    server_thread_data_t* data = (server_thread_data_t*)user_data;
+
+    if (in->status == SECURE_COMM_ERR_DECOMPRESS) {
+        LOG_ERROR("Failed to decompress message from %s:%d",
+                  inet_ntoa(data->client_addr.sin_addr), ntohs(data->client_addr.sin_port));
+    } else if (in->status != SECURE_COMM_SUCCESS) {
+        LOG_ERROR("Failed to decrypt message from %s:%d. Error code: %d",
+                  inet_ntoa(data->client_addr.sin_addr), ntohs(data->client_addr.sin_port), in->status);
+        data->records_rejected++;
+    } else if (replay_window_accept(&data->replay, in->sequence) != SECURE_COMM_SUCCESS) {
+        // Drop authenticated messages whose sequence number was already seen
+        data->records_rejected++;
+        LOG_WARN("Dropping replayed message from %s:%d",
+                 inet_ntoa(data->client_addr.sin_addr), ntohs(data->client_addr.sin_port));
+    } else {
+        SecureBuffer* message = in->expanded != NULL ? in->expanded : in->record;
+
+        // Lock console before printing received message
+        pthread_mutex_lock(&console_mutex);
+
+        // Move cursor to a new line if the console prompt is active
+        printf("\nClient %s:%d: %.*s\n",
+               inet_ntoa(data->client_addr.sin_addr), ntohs(data->client_addr.sin_port),
+               (int)secure_buffer_len(message), (const char*)secure_buffer_data(message));
+
+        // Re-print the console prompt
+        printf("To all clients: ");
+        fflush(stdout);
+
+        // Unlock console
+        pthread_mutex_unlock(&console_mutex);
+    }
+
+    secure_buffer_release(in->record);
+    if (in->expanded != NULL) {
+        secure_buffer_release(in->expanded);
+    }
+    free(in);
+}
+
 /**
  * @brief Thread function to handle receiving messages from the client.
+ *
+ * Reads straight into a frame decoder, so records split or merged by TCP are
+ * reassembled before decryption. The thread only does I/O: each record is handed
+ * to the worker pool and printed, in order, once it has been opened.
  */
 void* receiver_thread_func(void* arg) {
     server_thread_data_t* data = (server_thread_data_t*)arg;
-    int client_sock = data->client_sock;
-    unsigned char* session_key = data->session_key;
 
-    unsigned char buffer[BUFFER_SIZE];
+    FrameDecoder* decoder = NULL;
+    data->open_cipher_count = worker_pool_threads(worker_pool_default());
+    data->open_ciphers = (SecureCipher**)calloc(data->open_cipher_count, sizeof(SecureCipher*));
+    if ((data->open_ciphers == NULL && data->open_cipher_count > 0) ||
+        worker_sequence_create(NULL, (size_t)config_current()->max_in_flight, inbound_complete, data,
+                               &data->inbound) != SECURE_COMM_SUCCESS ||
+        frame_decoder_create(4 * BUFFER_SIZE, RECORD_OVERHEAD + BUFFER_SIZE, &decoder) != SECURE_COMM_SUCCESS) {
+        LOG_ERROR("Failed to set up the receive path for %s:%d",
+                  inet_ntoa(data->client_addr.sin_addr), ntohs(data->client_addr.sin_port));
+        worker_sequence_destroy(data->inbound);
+        free(data->open_ciphers);
+        data->open_ciphers = NULL;
+        broadcast_subscriber_close(data->subscriber);
+        pthread_exit(NULL);
+    }
 
     while (1) {
-        ssize_t bytes_received = recv(client_sock, buffer, sizeof(buffer), 0);
-        if (bytes_received <= 0) {
-            if (bytes_received == 0) {
-                log_message(LOG_LEVEL_INFO, "Client %s:%d disconnected",
-                            inet_ntoa(data->client_addr.sin_addr), ntohs(data->client_addr.sin_port));
-            } else {
-                log_message(LOG_LEVEL_WARN, "Recv failed from %s:%d: %s",
-                            inet_ntoa(data->client_addr.sin_addr), ntohs(data->client_addr.sin_port), strerror(errno));
-            }
+        unsigned char* space;
+        size_t space_len;
+        frame_decoder_write_space(decoder, &space, &space_len);
+
+        ssize_t bytes_received = 0;
+        if (secure_recv(data->conn, space, space_len, &bytes_received) != SECURE_COMM_SUCCESS) {
+            LOG_INFO("Client %s:%d disconnected",
+                     inet_ntoa(data->client_addr.sin_addr), ntohs(data->client_addr.sin_port));
             break; // Exit the loop to close the connection
         }
+        frame_decoder_commit(decoder, (size_t)bytes_received);
 
-        // Decrypt the received message
-        unsigned char iv[IV_SIZE];
-        unsigned char tag[TAG_SIZE];
-        unsigned char decrypted_msg[BUFFER_SIZE];
-        int decrypted_len = 0;
+        // One read may complete several frames, or none at all
+        FrameHeader header;
+        SecureBuffer* record = NULL;
+        SecureCommError frame_ret;
+        while ((frame_ret = frame_decoder_next_buffer(decoder, NULL, &header, &record)) == SECURE_COMM_SUCCESS) {
+            if (header.type != FRAME_TYPE_DATA) {
+                secure_buffer_release(record);
+                continue;
+            }
+            if (header.suite != cipher_get_suite(data->cipher)) {
+                LOG_ERROR("Dropping record sealed with unexpected cipher suite %u from %s:%d",
+                          header.suite, inet_ntoa(data->client_addr.sin_addr), ntohs(data->client_addr.sin_port));
+                secure_buffer_release(record);
+                continue;
+            }
 
-        if (bytes_received < IV_SIZE + TAG_SIZE) {
-            log_message(LOG_LEVEL_ERROR, "Received data is too short to contain IV and tag");
-            continue;
+            inbound_record_t* in = (inbound_record_t*)calloc(1, sizeof(inbound_record_t));
+            if (in == NULL) {
+                LOG_ERROR("Failed to allocate memory for a record from %s:%d",
+                          inet_ntoa(data->client_addr.sin_addr), ntohs(data->client_addr.sin_port));
+                secure_buffer_release(record);
+                continue;
+            }
+            in->data = data;
+            in->record = record;
+            in->codec = header.codec;
+            worker_sequence_submit(data->inbound, inbound_open, in);
         }
 
-        // Extract IV and tag from the received buffer
-        memcpy(iv, buffer, IV_SIZE);
-        memcpy(tag, buffer + IV_SIZE, TAG_SIZE);
-        unsigned char* ciphertext = buffer + IV_SIZE + TAG_SIZE;
-        int ciphertext_len = bytes_received - IV_SIZE - TAG_SIZE;
-
-        SecureCommError decrypt_ret = decrypt_data(ciphertext, ciphertext_len,
-                                                   session_key, iv,
-                                                   decrypted_msg, &decrypted_len, tag);
-        if (decrypt_ret != SECURE_COMM_SUCCESS) {
-            log_message(LOG_LEVEL_ERROR, "Failed to decrypt message from %s:%d. Error code: %d",
-                        inet_ntoa(data->client_addr.sin_addr), ntohs(data->client_addr.sin_port), decrypt_ret);
-            continue;
+        if (frame_ret != SECURE_COMM_ERR_AGAIN) {
+            LOG_ERROR("Malformed frame stream from %s:%d, closing connection",
+                      inet_ntoa(data->client_addr.sin_addr), ntohs(data->client_addr.sin_port));
+            break;
         }
+    }
 
-        decrypted_msg[decrypted_len] = '\0'; // Null-terminate the decrypted message
+    // Let the records still in flight finish before the handles they use go away
+    worker_sequence_destroy(data->inbound);
+    data->inbound = NULL;
+    for (size_t i = 0; i < data->open_cipher_count; i++) {
+        cipher_destroy(data->open_ciphers[i]);
+    }
+    free(data->open_ciphers);
+    data->open_ciphers = NULL;
 
-        // Lock console before printing received message
-        pthread_mutex_lock(&console_mutex);
+    // Stop queueing broadcasts for this client and wake its sender thread
+    broadcast_subscriber_close(data->subscriber);
 
-        // Move cursor to a new line if the sender prompt is active
-        printf("\nClient %s:%d: %s\n",
-               inet_ntoa(data->client_addr.sin_addr), ntohs(data->client_addr.sin_port), decrypted_msg);
+    frame_decoder_destroy(decoder);
+    pthread_exit(NULL);
+}
 
-        // Re-print the sender prompt
-        printf("To client %s:%d: ", inet_ntoa(data->client_addr.sin_addr), ntohs(data->client_addr.sin_port));
-        fflush(stdout);
+// -------------------------------------------------------
+// Reactor mode: a fixed pool of event loops serves all clients
+// -------------------------------------------------------
 
-        // Unlock console
-        pthread_mutex_unlock(&console_mutex);
+static SecureReactor* active_reactor = NULL;
+
+// Sessions of reactor clients; a client presenting a ticket skips straight to its old key
+static SessionTable* reactor_sessions = NULL;
+
+// Per-connection state in reactor mode
+typedef struct {
+    SecureCipher* cipher;       // Keyed AEAD handle for this client, NULL until its HELLO arrives
+    unsigned char session_id[SESSION_ID_SIZE];
+    unsigned char session_key[SESSION_KEY_SIZE];
+    int resumed;                // Set when a ticket arrived before the HELLO
+    ReplayWindow replay;        // Sequence numbers already received from the client
+    FrameDecoder* decoder;      // Reassembles frames split or merged by TCP
+    uint64_t records_rejected;  // Records that failed authentication or were replays
+} reactor_client_t;
+
+// Echo replies produced by one read are batched into a single send
+#define REACTOR_BATCH_SIZE (16 * 1024)
+
+/**
+ * @brief Stops the reactor on SIGINT/SIGTERM.
+ */
+static void reactor_signal_handler(int signum) {
+    (void)signum;
+    reactor_stop(active_reactor);
+}
+
+/**
+ * @brief Formats the peer address of a reactor connection as "ip:port".
+ */
+static void format_peer(ReactorConnection* conn, char* out, size_t out_len) {
+    const struct sockaddr_in* addr = (const struct sockaddr_in*)reactor_conn_peer(conn, NULL);
+    char ip[INET_ADDRSTRLEN] = "?";
+    inet_ntop(AF_INET, &addr->sin_addr, ip, sizeof(ip));
+    snprintf(out, out_len, "%s:%d", ip, ntohs(addr->sin_port));
+}
+
+static SecureCommError reactor_on_open(ReactorConnection* conn, void* user_data) {
+    (void)user_data;
+    char peer[64];
+    format_peer(conn, peer, sizeof(peer));
+    LOG_INFO("Accepted connection from %s", peer);
+
+    reactor_client_t* client = (reactor_client_t*)malloc(sizeof(reactor_client_t));
+    if (client == NULL) {
+        LOG_ERROR("Failed to allocate memory for client %s", peer);
+        return SECURE_COMM_ERR_MEMORY;
     }
+    replay_window_init(&client->replay);
+    client->cipher = NULL;
+    client->resumed = 0;
+    client->records_rejected = 0;
 
-    pthread_exit(NULL);
+    SecureCommError ret = frame_decoder_create(4 * BUFFER_SIZE, RECORD_OVERHEAD + BUFFER_SIZE, &client->decoder);
+    if (ret != SECURE_COMM_SUCCESS) {
+        LOG_ERROR("Failed to create frame decoder for %s. Error code: %d", peer, ret);
+        free(client);
+        return ret;
+    }
+
+    // The cipher is keyed once the client's HELLO names the suite
+    reactor_conn_set_user_data(conn, client);
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Restores the session named by a resumption ticket sent ahead of the HELLO.
+ *
+ * A ticket that is forged or too old is ignored, and the client gets a new session.
+ */
+static SecureCommError reactor_handle_ticket(reactor_client_t* client, const char* peer,
+                                             const unsigned char* payload, size_t len) {
+    if (client->cipher != NULL || client->resumed) {
+        LOG_ERROR("Unexpected ticket from %s, closing connection", peer);
+        return SECURE_COMM_ERR_SESSION;
+    }
+    if (session_table_resume(reactor_sessions, payload, len, client->session_id, client->session_key) !=
+        SECURE_COMM_SUCCESS) {
+        LOG_WARN("Ignoring invalid ticket from %s", peer);
+        return SECURE_COMM_SUCCESS;
+    }
+    client->resumed = 1;
+    LOG_INFO("Client %s resumed its session", peer);
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Answers the client's HELLO and keys the connection's cipher with the chosen suite.
+ *
+ * The reply is queued in the batch ahead of any echo produced by the same read,
+ * followed by a fresh resumption ticket for the session.
+ */
+static SecureCommError reactor_handle_hello(reactor_client_t* client, const char* peer,
+                                            const unsigned char* payload, size_t len,
+                                            unsigned char* batch, size_t* batch_used) {
+    unsigned int client_mask = 0;
+    CipherSuite preferred = CIPHER_SUITE_COUNT;
+    unsigned char connection_salt[SECURE_CONNECTION_SALT_SIZE];
+    if (client->cipher != NULL || cipher_hello_decode(payload, len, &client_mask, &preferred, connection_salt) != SECURE_COMM_SUCCESS) {
+        LOG_ERROR("Unexpected HELLO from %s, closing connection", peer);
+        return SECURE_COMM_ERR_SESSION;
+    }
+    if (!RAND_bytes(connection_salt + SECURE_HELLO_RANDOM_SIZE, SECURE_HELLO_RANDOM_SIZE)) {
+        LOG_ERROR("Failed to generate the HELLO random for %s", peer);
+        return SECURE_COMM_ERR_SESSION;
+    }
+
+    CipherSuite suite = cipher_suite_negotiate(client_mask, preferred);
+    if (suite == CIPHER_SUITE_COUNT) {
+        LOG_ERROR("No cipher suite in common with %s, closing connection", peer);
+        return SECURE_COMM_ERR_SESSION;
+    }
+
+    // New clients get a session key of their own, derived from the predefined key and this
+    // handshake's randoms, so a ticket never carries the predefined key; resumed ones already hold theirs
+    SecureCommError ret;
+    if (!client->resumed) {
+        ret = cipher_derive_key(predefined_session_key, sizeof(predefined_session_key), connection_salt,
+                                sizeof(connection_salt), SECURE_SESSION_KEY_LABEL,
+                                client->session_key, sizeof(client->session_key));
+        if (ret != SECURE_COMM_SUCCESS) {
+            LOG_ERROR("Failed to derive a session key for %s. Error code: %d", peer, ret);
+            return ret;
+        }
+        ret = session_table_insert(reactor_sessions, client->session_key, client->session_id);
+        if (ret != SECURE_COMM_SUCCESS) {
+            LOG_ERROR("Failed to create a session for %s. Error code: %d", peer, ret);
+            return ret;
+        }
+    }
+
+    // Each connection keeps its own keyed cipher for its whole lifetime, under a key of its own
+    unsigned char connection_key[SESSION_KEY_SIZE];
+    ret = cipher_derive_key(client->session_key, sizeof(client->session_key), connection_salt, sizeof(connection_salt),
+                            SECURE_CONNECTION_KEY_LABEL, connection_key, sizeof(connection_key));
+    if (ret == SECURE_COMM_SUCCESS) {
+        ret = create_connection_cipher(suite, connection_key, sizeof(connection_key), &client->cipher);
+    }
+    OPENSSL_cleanse(connection_key, sizeof(connection_key));
+    if (ret != SECURE_COMM_SUCCESS) {
+        LOG_ERROR("Failed to create cipher for %s. Error code: %d", peer, ret);
+        return ret;
+    }
+    LOG_INFO("Client %s uses cipher suite %s", peer, cipher_suite_name(suite));
+
+    unsigned char reply[SECURE_HELLO_SIZE];
+    cipher_hello_encode(cipher_suite_supported_mask(), suite, connection_salt + SECURE_HELLO_RANDOM_SIZE, reply);
+    ret = frame_append(batch, REACTOR_BATCH_SIZE, batch_used, FRAME_TYPE_HELLO, 0, reply, sizeof(reply));
+    if (ret != SECURE_COMM_SUCCESS) {
+        return ret;
+    }
+
+    // Clients that do not resume simply ignore the ticket frame
+    unsigned char ticket[SESSION_TICKET_SIZE];
+    if (session_table_issue_ticket(reactor_sessions, client->session_id, ticket) != SECURE_COMM_SUCCESS) {
+        LOG_WARN("Failed to issue a ticket to %s", peer);
+        return SECURE_COMM_SUCCESS;
+    }
+    return frame_append(batch, REACTOR_BATCH_SIZE, batch_used, FRAME_TYPE_TICKET, 0, ticket, sizeof(ticket));
+}
+
+/**
+ * @brief Queues a batch of reply frames, dropping clients that stopped reading.
+ */
+static SecureCommError reactor_send_batch(ReactorConnection* conn, const char* peer,
+                                          const unsigned char* batch, size_t batch_used) {
+    SecureCommError ret = reactor_conn_send(conn, batch, batch_used);
+    if (ret == SECURE_COMM_ERR_AGAIN) {
+        LOG_WARN("Client %s is not reading its replies, closing connection", peer);
+    }
+    return ret;
+}
+
+/**
+ * @brief Decrypts one IV || tag || ciphertext record, prints it and queues the echo.
+ *
+ * The encrypted reply is written straight into the batch buffer, which is only
+ * handed to the socket when full or once the whole read has been processed.
+ */
+static SecureCommError reactor_handle_record(ReactorConnection* conn, reactor_client_t* client, const char* peer,
+                                             uint8_t codec, unsigned char* record, size_t record_len,
+                                             unsigned char* batch, size_t* batch_used) {
+    if (record_len < RECORD_OVERHEAD) {
+        LOG_ERROR("Received record is too short to contain IV and tag from %s", peer);
+        return SECURE_COMM_SUCCESS;
+    }
+
+    // Decrypt in place; the echo below is encrypted straight from the record into the batch
+    unsigned char* decrypted_msg = NULL;
+    size_t decrypted_len = 0;
+    SecureCommError decrypt_ret = cipher_open_record(client->cipher, record, record_len,
+                                                     &decrypted_msg, &decrypted_len);
+    if (decrypt_ret != SECURE_COMM_SUCCESS) {
+        LOG_ERROR("Failed to decrypt message from %s. Error code: %d", peer, decrypt_ret);
+        client->records_rejected++;
+        return SECURE_COMM_SUCCESS;
+    }
+    if (replay_window_accept(&client->replay, nonce_sequence(record)) != SECURE_COMM_SUCCESS) {
+        client->records_rejected++;
+        LOG_WARN("Dropping replayed message from %s", peer);
+        return SECURE_COMM_SUCCESS;
+    }
+
+    // Expand compressed payloads for display; the echo reuses the compressed bytes
+    unsigned char expanded[BUFFER_SIZE + 1];
+    unsigned char* message = decrypted_msg;
+    size_t message_len = decrypted_len;
+    if (codec != COMPRESSION_CODEC_NONE) {
+        size_t expanded_len = BUFFER_SIZE;
+        if (codec_decompress((CompressionCodecId)codec, decrypted_msg, message_len,
+                             expanded, &expanded_len) != SECURE_COMM_SUCCESS) {
+            LOG_ERROR("Failed to decompress message from %s", peer);
+            return SECURE_COMM_SUCCESS;
+        }
+        message = expanded;
+        message_len = expanded_len;
+    }
+    message[message_len] = '\0';
+
+    pthread_mutex_lock(&console_mutex);
+    printf("Client %s: %s\n", peer, message);
+    fflush(stdout);
+    pthread_mutex_unlock(&console_mutex);
+
+    // Make room for header || IV || tag || ciphertext in the batch
+    size_t frame_len = SECURE_FRAME_HEADER_SIZE + RECORD_OVERHEAD + decrypted_len;
+    if (*batch_used + frame_len > REACTOR_BATCH_SIZE) {
+        SecureCommError send_ret = reactor_send_batch(conn, peer, batch, *batch_used);
+        *batch_used = 0;
+        if (send_ret != SECURE_COMM_SUCCESS) {
+            return send_ret;
+        }
+    }
+
+    // Echo the message back under the next nonce
+    unsigned char* frame = batch + *batch_used;
+    unsigned char* reply = frame + SECURE_FRAME_HEADER_SIZE;
+    int encrypted_len = 0;
+    SecureCommError encrypt_ret = cipher_encrypt(client->cipher, decrypted_msg, (int)decrypted_len, reply,
+                                                 reply + RECORD_OVERHEAD, &encrypted_len, reply + IV_SIZE);
+    if (encrypt_ret != SECURE_COMM_SUCCESS) {
+        LOG_ERROR("Failed to encrypt message to %s. Error code: %d", peer, encrypt_ret);
+        return SECURE_COMM_SUCCESS;
+    }
+
+    FrameHeader header = { (uint32_t)(RECORD_OVERHEAD + encrypted_len), FRAME_TYPE_DATA, 0, codec,
+                           (uint8_t)cipher_get_suite(client->cipher) };
+    frame_encode_header(&header, frame);
+    *batch_used += SECURE_FRAME_HEADER_SIZE + header.length;
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Reassembles frames from a read and handles every complete record.
+ */
+static SecureCommError reactor_on_data(ReactorConnection* conn, const unsigned char* data,
+                                       size_t len, void* user_data) {
+    (void)user_data;
+    reactor_client_t* client = (reactor_client_t*)reactor_conn_get_user_data(conn);
+    char peer[64];
+    format_peer(conn, peer, sizeof(peer));
+
+    // One spare byte lets reactor_handle_record terminate the decrypted message in place
+    unsigned char record[RECORD_OVERHEAD + BUFFER_SIZE + 1];
+    unsigned char batch[REACTOR_BATCH_SIZE];
+    size_t batch_used = 0;
+    size_t offset = 0;
+
+    while (offset < len) {
+        size_t consumed = 0;
+        frame_decoder_feed(client->decoder, data + offset, len - offset, &consumed);
+        offset += consumed;
+
+        FrameHeader header;
+        SecureCommError frame_ret;
+        while ((frame_ret = frame_decoder_next(client->decoder, &header, record, sizeof(record) - 1)) == SECURE_COMM_SUCCESS) {
+            if (header.type == FRAME_TYPE_HELLO || header.type == FRAME_TYPE_TICKET) {
+                SecureCommError ret = header.type == FRAME_TYPE_HELLO
+                                          ? reactor_handle_hello(client, peer, record, header.length, batch, &batch_used)
+                                          : reactor_handle_ticket(client, peer, record, header.length);
+                if (ret != SECURE_COMM_SUCCESS) {
+                    return ret;
+                }
+                continue;
+            }
+            if (header.type != FRAME_TYPE_DATA) {
+                continue;
+            }
+            if (client->cipher == NULL) {
+                LOG_ERROR("Record from %s before HELLO, closing connection", peer);
+                return SECURE_COMM_ERR_SESSION;
+            }
+            if (header.suite != cipher_get_suite(client->cipher)) {
+                LOG_ERROR("Dropping record sealed with unexpected cipher suite %u from %s",
+                          header.suite, peer);
+                continue;
+            }
+            SecureCommError ret = reactor_handle_record(conn, client, peer, header.codec, record, header.length,
+                                                        batch, &batch_used);
+            if (ret != SECURE_COMM_SUCCESS) {
+                return ret;
+            }
+        }
+
+        if (frame_ret != SECURE_COMM_ERR_AGAIN) {
+            LOG_ERROR("Malformed frame stream from %s, closing connection", peer);
+            return frame_ret;
+        }
+    }
+
+    // All replies for this read go out in one send
+    if (batch_used > 0) {
+        return reactor_send_batch(conn, peer, batch, batch_used);
+    }
+    return SECURE_COMM_SUCCESS;
+}
+
+static void reactor_on_close(ReactorConnection* conn, void* user_data) {
+    (void)user_data;
+    char peer[64];
+    format_peer(conn, peer, sizeof(peer));
+    reactor_client_t* client = (reactor_client_t*)reactor_conn_get_user_data(conn);
+    ConnectionStats stats;
+    reactor_conn_get_stats(conn, &stats);
+    LOG_INFO("Client %s disconnected: %llu bytes received, %llu bytes sent, %llu records rejected",
+             peer, (unsigned long long)stats.bytes_received, (unsigned long long)stats.bytes_sent,
+             (unsigned long long)(client ? client->records_rejected : 0));
+    if (client) {
+        // The session itself stays in the table until it idles out
+        OPENSSL_cleanse(client->session_key, sizeof(client->session_key));
+        cipher_destroy(client->cipher);
+        frame_decoder_destroy(client->decoder);
+        free(client);
+    }
+    reactor_conn_set_user_data(conn, NULL);
+}
+
+/**
+ * @brief Serves all clients from a fixed pool of event-loop threads.
+ *
+ * Uses the same framed IV || tag || ciphertext records as the threaded mode.
+ * Received messages are printed and echoed back.
+ *
+ * @return EXIT_SUCCESS after SIGINT/SIGTERM, EXIT_FAILURE on setup errors.
+ */
+int run_reactor_server(int server_sock, int num_threads, ReactorBackend backend) {
+    ReactorConfig reactor_config;
+    reactor_config_defaults(&reactor_config);
+    reactor_config.num_threads = num_threads;
+    reactor_config.backend = backend;
+    reactor_config.on_open = reactor_on_open;
+    reactor_config.on_data = reactor_on_data;
+    reactor_config.on_close = reactor_on_close;
+    reactor_config.max_output_buffer = config_current()->reactor_max_output;
+
+    SecureCommError ret = session_table_create(NULL, &reactor_sessions);
+    if (ret != SECURE_COMM_SUCCESS) {
+        LOG_ERROR("Failed to create the session table. Error code: %d", ret);
+        return EXIT_FAILURE;
+    }
+
+    SecureReactor* reactor = NULL;
+    ret = reactor_create(&reactor_config, &reactor);
+    if (ret != SECURE_COMM_SUCCESS) {
+        LOG_ERROR("Failed to create reactor. Error code: %d", ret);
+        session_table_destroy(reactor_sessions);
+        return EXIT_FAILURE;
+    }
+
+    ret = reactor_listen(reactor, server_sock);
+    if (ret != SECURE_COMM_SUCCESS) {
+        LOG_ERROR("Failed to attach listening socket. Error code: %d", ret);
+        reactor_destroy(reactor);
+        session_table_destroy(reactor_sessions);
+        return EXIT_FAILURE;
+    }
+
+    active_reactor = reactor;
+    signal(SIGINT, reactor_signal_handler);
+    signal(SIGTERM, reactor_signal_handler);
+    signal(SIGPIPE, SIG_IGN);
+
+    LOG_INFO("Reactor mode with %d event loop thread(s)", num_threads);
+    ret = reactor_run(reactor);
+
+    active_reactor = NULL;
+    reactor_destroy(reactor);
+    session_table_destroy(reactor_sessions);
+    reactor_sessions = NULL;
+    return ret == SECURE_COMM_SUCCESS ? EXIT_SUCCESS : EXIT_FAILURE;
 }
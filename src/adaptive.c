@@ -0,0 +1,253 @@
+// adaptive.c
+
+#include "secure_comm.h"
+
+#include <stdio.h>      // For fprintf
+#include <stdlib.h>     // For malloc, free
+#include <string.h>     // For memset
+#include <math.h>       // For log2
+
+// Definition of the opaque AdaptiveCompressor structure
+struct AdaptiveCompressor {
+    AdaptiveCompressionConfig config;
+    double ratio_ewma;          // Recent compressed/original size, 1.0 = no gain
+    int ratio_known;            // Set once a compressed message has been measured
+    unsigned int backoff_left;  // Messages to store before probing again
+    AdaptiveCompressionStats stats;
+};
+
+/**
+ * @brief Fills an AdaptiveCompressionConfig with the defaults.
+ *
+ * @param config The configuration to fill.
+ */
+void adaptive_config_defaults(AdaptiveCompressionConfig* config) {
+    if (config == NULL) {
+        return;
+    }
+    memset(config, 0, sizeof(AdaptiveCompressionConfig));
+    config->min_size = 256;
+    config->sample_size = 4096;
+    config->store_entropy = 7.5;
+    config->strong_entropy = 5.0;
+    config->fast_codec = COMPRESSION_CODEC_ZLIB;
+    config->fast_level = 1;
+    config->strong_codec = COMPRESSION_CODEC_ZLIB;
+    config->strong_level = 6;
+    config->backoff_ratio = 0.9;
+    config->ewma_alpha = 0.2;
+    config->probe_interval = 16;
+}
+
+/**
+ * @brief Creates the per-connection state for adaptive compression.
+ *
+ * @param config Tuning parameters, or NULL for the defaults.
+ * @param compressor Pointer to store the created AdaptiveCompressor.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError adaptive_compressor_create(const AdaptiveCompressionConfig* config,
+                                           AdaptiveCompressor** compressor) {
+    if (compressor == NULL) {
+        fprintf(stderr, "adaptive_compressor_create: Invalid arguments\n");
+        return SECURE_COMM_ERR_INIT;
+    }
+
+    AdaptiveCompressionConfig cfg;
+    if (config) {
+        cfg = *config;
+    } else {
+        adaptive_config_defaults(&cfg);
+    }
+
+    if (codec_find(cfg.fast_codec) == NULL || codec_find(cfg.strong_codec) == NULL ||
+        cfg.ewma_alpha <= 0.0 || cfg.ewma_alpha > 1.0) {
+        fprintf(stderr, "adaptive_compressor_create: Invalid configuration\n");
+        return SECURE_COMM_ERR_INIT;
+    }
+
+    AdaptiveCompressor* ac = (AdaptiveCompressor*)malloc(sizeof(AdaptiveCompressor));
+    if (ac == NULL) {
+        fprintf(stderr, "adaptive_compressor_create: Failed to allocate memory\n");
+        return SECURE_COMM_ERR_MEMORY;
+    }
+    memset(ac, 0, sizeof(AdaptiveCompressor));
+    ac->config = cfg;
+    ac->ratio_ewma = 1.0;
+
+    *compressor = ac;
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Estimates the Shannon entropy of a buffer in bits per byte (0-8).
+ *
+ * @param data Bytes to examine.
+ * @param len Number of bytes.
+ *
+ * @return The entropy estimate, or 0 for an empty buffer.
+ */
+double estimate_entropy(const unsigned char* data, size_t len) {
+    if (data == NULL || len == 0) {
+        return 0.0;
+    }
+
+    size_t counts[256];
+    memset(counts, 0, sizeof(counts));
+    for (size_t i = 0; i < len; i++) {
+        counts[data[i]]++;
+    }
+
+    double entropy = 0.0;
+    for (int b = 0; b < 256; b++) {
+        if (counts[b]) {
+            double p = (double)counts[b] / (double)len;
+            entropy -= p * log2(p);
+        }
+    }
+    return entropy;
+}
+
+/**
+ * @brief Decides how the next payload should be compressed.
+ *
+ * Tiny payloads are stored. While recent messages have not compressed below
+ * backoff_ratio, payloads are stored too, except for one probe every probe_interval
+ * messages. Otherwise the entropy of the first sample_size bytes picks store, fast
+ * or strong.
+ *
+ * @param compressor The per-connection state.
+ * @param data Payload to send.
+ * @param len Payload length.
+ *
+ * @return The chosen strategy.
+ */
+CompressionDecision adaptive_choose(AdaptiveCompressor* compressor, const unsigned char* data, size_t len) {
+    const AdaptiveCompressionConfig* cfg = &compressor->config;
+
+    if (len < cfg->min_size) {
+        return COMPRESSION_DECISION_STORE;
+    }
+
+    // Recent payloads did not shrink: store until the next probe
+    if (compressor->backoff_left > 0) {
+        compressor->backoff_left--;
+        return COMPRESSION_DECISION_STORE;
+    }
+
+    size_t sample = len < cfg->sample_size ? len : cfg->sample_size;
+    double entropy = estimate_entropy(data, sample);
+    if (entropy >= cfg->store_entropy) {
+        return COMPRESSION_DECISION_STORE;
+    }
+    if (entropy <= cfg->strong_entropy) {
+        return COMPRESSION_DECISION_STRONG;
+    }
+    return COMPRESSION_DECISION_FAST;
+}
+
+/**
+ * @brief Folds one measured compression ratio into the running average.
+ */
+static void adaptive_record_ratio(AdaptiveCompressor* compressor, double ratio) {
+    const AdaptiveCompressionConfig* cfg = &compressor->config;
+
+    if (!compressor->ratio_known) {
+        compressor->ratio_ewma = ratio;
+        compressor->ratio_known = 1;
+    } else {
+        compressor->ratio_ewma += cfg->ewma_alpha * (ratio - compressor->ratio_ewma);
+    }
+
+    if (compressor->ratio_ewma >= cfg->backoff_ratio) {
+        compressor->backoff_left = cfg->probe_interval;
+    }
+}
+
+/**
+ * @brief Compresses a payload with the strategy picked by adaptive_choose.
+ *
+ * When the payload should be sent as-is (tiny, high entropy, backing off, or
+ * compression did not help), *codec is set to COMPRESSION_CODEC_NONE and the caller
+ * must send the input. The output contents are then unspecified: a compression that
+ * did not help has already written to it.
+ *
+ * @param compressor The per-connection state.
+ * @param input Payload to send.
+ * @param input_len Payload length.
+ * @param output Buffer for the compressed payload.
+ * @param output_len In: size of output. Out: compressed length (0 when stored).
+ * @param codec Pointer to store the codec to put in the frame header.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError adaptive_compress(AdaptiveCompressor* compressor,
+                                  const unsigned char* input, size_t input_len,
+                                  unsigned char* output, size_t* output_len,
+                                  CompressionCodecId* codec) {
+    if (compressor == NULL || input == NULL || output == NULL || output_len == NULL || codec == NULL) {
+        fprintf(stderr, "adaptive_compress: Invalid arguments\n");
+        return SECURE_COMM_ERR_COMPRESS;
+    }
+
+    AdaptiveCompressionStats* stats = &compressor->stats;
+    stats->messages++;
+    stats->bytes_in += input_len;
+
+    CompressionDecision decision = adaptive_choose(compressor, input, input_len);
+    if (decision != COMPRESSION_DECISION_STORE) {
+        const AdaptiveCompressionConfig* cfg = &compressor->config;
+        CompressionCodecId id = decision == COMPRESSION_DECISION_STRONG ? cfg->strong_codec : cfg->fast_codec;
+        int level = decision == COMPRESSION_DECISION_STRONG ? cfg->strong_level : cfg->fast_level;
+        const CompressionCodec* impl = codec_find(id);
+
+        // Only compress when the worst case fits: falling back to store is always safe
+        size_t compressed_len = *output_len;
+        if (impl && impl->bound(input_len) <= compressed_len &&
+            impl->compress(input, input_len, output, &compressed_len, level) == SECURE_COMM_SUCCESS) {
+            adaptive_record_ratio(compressor, (double)compressed_len / (double)input_len);
+
+            if (compressed_len < input_len) {
+                if (decision == COMPRESSION_DECISION_STRONG) {
+                    stats->strong++;
+                } else {
+                    stats->fast++;
+                }
+                stats->bytes_out += compressed_len;
+                *output_len = compressed_len;
+                *codec = id;
+                return SECURE_COMM_SUCCESS;
+            }
+        }
+    }
+
+    stats->stored++;
+    stats->bytes_out += input_len;
+    *output_len = 0;
+    *codec = COMPRESSION_CODEC_NONE;
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Returns the counters and the current ratio average.
+ *
+ * @param compressor The per-connection state.
+ * @param stats Pointer to store the counters.
+ */
+void adaptive_compressor_stats(const AdaptiveCompressor* compressor, AdaptiveCompressionStats* stats) {
+    if (compressor == NULL || stats == NULL) {
+        return;
+    }
+    *stats = compressor->stats;
+    stats->ratio_ewma = compressor->ratio_ewma;
+}
+
+/**
+ * @brief Destroys adaptive compression state.
+ *
+ * @param compressor The state to destroy.
+ */
+void adaptive_compressor_destroy(AdaptiveCompressor* compressor) {
+    free(compressor);
+}
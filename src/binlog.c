@@ -0,0 +1,715 @@
+// binlog.c
+
+#include "secure_comm.h"
+
+#include <stdio.h>      // For FILE, fwrite, snprintf
+#include <stdlib.h>     // For malloc, realloc, free
+#include <string.h>     // For memcpy, strlen
+#include <stdarg.h>     // For va_list
+#include <stdint.h>     // For intmax_t, uintptr_t
+#include <stddef.h>     // For ptrdiff_t
+#include <time.h>       // For clock_gettime, localtime_r, strftime
+#include <pthread.h>    // For the sink mutex
+#include <stdatomic.h>  // For the active flag
+
+// File layout (all integers little-endian):
+//   header:  magic (8) | version (4) | realtime ns at open (8) | monotonic ns at open (8)
+//   'F':     id (4) | format length (2) | format bytes       -- first use of a format
+//   'L':     id (4) | level (1) | monotonic ns (8) | args length (2) | args
+// Integer and pointer arguments take 8 bytes, doubles 8 bytes (IEEE 754 bits),
+// strings a 2-byte length followed by the bytes.
+#define BINLOG_VERSION 1
+#define BINLOG_RECORD_FORMAT 'F'
+#define BINLOG_RECORD_LINE 'L'
+
+#define BINLOG_MAX_SPECS 16         // Conversions per format; more falls back to text
+#define BINLOG_INTERN_SLOTS 1024    // Open-addressing table of formats seen (power of two)
+#define BINLOG_RECORD_MAX (2 * SECURE_LOG_MESSAGE_MAX)
+
+// Fallback format for lines stored as already-formatted text
+static const char binlog_text_format[] = "%s";
+
+// Argument kinds of a conversion
+typedef enum {
+    BINLOG_ARG_SIGNED,      // d i c
+    BINLOG_ARG_UNSIGNED,    // u o x X
+    BINLOG_ARG_DOUBLE,      // f F e E g G a A
+    BINLOG_ARG_STRING,      // s
+    BINLOG_ARG_POINTER      // p
+} binlog_arg_kind_t;
+
+// C length modifier of an integer conversion
+typedef enum {
+    BINLOG_LEN_INT,
+    BINLOG_LEN_LONG,
+    BINLOG_LEN_LONG_LONG,
+    BINLOG_LEN_INTMAX,
+    BINLOG_LEN_SIZE,
+    BINLOG_LEN_PTRDIFF,
+    BINLOG_LEN_LONG_DOUBLE
+} binlog_length_t;
+
+// One parsed conversion of a format string
+typedef struct {
+    const char* start;      // The '%'
+    const char* end;        // One past the conversion character
+    binlog_arg_kind_t kind;
+    binlog_length_t length;
+    int width_star;         // Width taken from an int argument
+    int precision_star;     // Precision taken from an int argument
+} binlog_spec_t;
+
+// An interned format string
+typedef struct {
+    const char* format;     // Key: address of the caller's format string
+    uint32_t id;
+    int spec_count;         // -1 if the format is stored as text
+    binlog_spec_t specs[BINLOG_MAX_SPECS];
+} binlog_intern_t;
+
+static pthread_mutex_t binlog_mutex = PTHREAD_MUTEX_INITIALIZER;
+static FILE* binlog_file = NULL;
+static atomic_int binlog_enabled = 0;
+static binlog_intern_t* binlog_interned = NULL;  // BINLOG_INTERN_SLOTS entries
+static uint32_t binlog_next_id = 0;
+
+/**
+ * @brief Parses the conversions of a printf format.
+ *
+ * @param format The format string.
+ * @param specs Array of BINLOG_MAX_SPECS conversions to fill.
+ *
+ * @return The number of conversions, or -1 if the format uses something the binary
+ *         sink does not store (%n, positional arguments, too many conversions).
+ */
+static int binlog_parse_format(const char* format, binlog_spec_t* specs) {
+    int count = 0;
+    for (const char* p = format; *p; p++) {
+        if (*p != '%') {
+            continue;
+        }
+        if (p[1] == '%') {
+            p++;
+            continue;
+        }
+
+        binlog_spec_t spec;
+        memset(&spec, 0, sizeof(spec));
+        spec.start = p++;
+        while (*p && strchr("-+ #0'", *p)) {
+            p++;
+        }
+        if (*p == '*') {
+            spec.width_star = 1;
+            p++;
+        }
+        while (*p >= '0' && *p <= '9') {
+            p++;
+        }
+        if (*p == '$') {
+            return -1; // Positional arguments
+        }
+        if (*p == '.') {
+            p++;
+            if (*p == '*') {
+                spec.precision_star = 1;
+                p++;
+            }
+            while (*p >= '0' && *p <= '9') {
+                p++;
+            }
+        }
+
+        spec.length = BINLOG_LEN_INT;
+        if (*p == 'h') {
+            p += p[1] == 'h' ? 2 : 1;
+        } else if (*p == 'l') {
+            spec.length = p[1] == 'l' ? BINLOG_LEN_LONG_LONG : BINLOG_LEN_LONG;
+            p += p[1] == 'l' ? 2 : 1;
+        } else if (*p == 'j') {
+            spec.length = BINLOG_LEN_INTMAX;
+            p++;
+        } else if (*p == 'z') {
+            spec.length = BINLOG_LEN_SIZE;
+            p++;
+        } else if (*p == 't') {
+            spec.length = BINLOG_LEN_PTRDIFF;
+            p++;
+        } else if (*p == 'L') {
+            spec.length = BINLOG_LEN_LONG_DOUBLE;
+            p++;
+        }
+
+        switch (*p) {
+            case 'd': case 'i': case 'c':
+                spec.kind = BINLOG_ARG_SIGNED;
+                break;
+            case 'u': case 'o': case 'x': case 'X':
+                spec.kind = BINLOG_ARG_UNSIGNED;
+                break;
+            case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+                spec.kind = BINLOG_ARG_DOUBLE;
+                break;
+            case 's':
+                spec.kind = BINLOG_ARG_STRING;
+                break;
+            case 'p':
+                spec.kind = BINLOG_ARG_POINTER;
+                break;
+            default:
+                return -1; // %n, wide characters and anything unknown
+        }
+        if (spec.length == BINLOG_LEN_LONG && (spec.kind == BINLOG_ARG_STRING || *p == 'c')) {
+            return -1; // %ls and %lc take wide characters
+        }
+        spec.end = p + 1;
+
+        if (count == BINLOG_MAX_SPECS) {
+            return -1;
+        }
+        specs[count++] = spec;
+    }
+    return count;
+}
+
+static void put_u16(unsigned char* out, uint16_t v) {
+    out[0] = (unsigned char)v;
+    out[1] = (unsigned char)(v >> 8);
+}
+
+static void put_u32(unsigned char* out, uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+        out[i] = (unsigned char)(v >> (8 * i));
+    }
+}
+
+static void put_u64(unsigned char* out, uint64_t v) {
+    for (int i = 0; i < 8; i++) {
+        out[i] = (unsigned char)(v >> (8 * i));
+    }
+}
+
+static uint16_t get_u16(const unsigned char* in) {
+    return (uint16_t)(in[0] | (in[1] << 8));
+}
+
+static uint32_t get_u32(const unsigned char* in) {
+    uint32_t v = 0;
+    for (int i = 3; i >= 0; i--) {
+        v = (v << 8) | in[i];
+    }
+    return v;
+}
+
+static uint64_t get_u64(const unsigned char* in) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; i--) {
+        v = (v << 8) | in[i];
+    }
+    return v;
+}
+
+static uint64_t clock_ns(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Looks a format up by address, interning it (and writing its 'F' record) on first use.
+ *
+ * Called with binlog_mutex held.
+ *
+ * @return The entry, or NULL if the intern table is full.
+ */
+static binlog_intern_t* binlog_intern(const char* format) {
+    // Fibonacci hashing spreads neighbouring string literals over the table
+    size_t slot = (size_t)(((uint64_t)(uintptr_t)format * 0x9E3779B97F4A7C15ull) >> 54) & (BINLOG_INTERN_SLOTS - 1);
+    for (size_t probe = 0; probe < BINLOG_INTERN_SLOTS; probe++) {
+        binlog_intern_t* entry = &binlog_interned[(slot + probe) & (BINLOG_INTERN_SLOTS - 1)];
+        if (entry->format == format) {
+            return entry;
+        }
+        if (entry->format != NULL) {
+            continue;
+        }
+
+        entry->format = format;
+        entry->id = binlog_next_id++;
+        entry->spec_count = binlog_parse_format(format, entry->specs);
+
+        // Formats stored as text are defined as "%s" so the decoder needs no special case
+        const char* definition = entry->spec_count < 0 ? binlog_text_format : format;
+        size_t len = strlen(definition);
+        if (len > UINT16_MAX) {
+            len = UINT16_MAX;
+        }
+        unsigned char header[7];
+        header[0] = BINLOG_RECORD_FORMAT;
+        put_u32(header + 1, entry->id);
+        put_u16(header + 5, (uint16_t)len);
+        fwrite(header, 1, sizeof(header), binlog_file);
+        fwrite(definition, 1, len, binlog_file);
+        return entry;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Appends a string argument (2-byte length + bytes), truncated to the space left.
+ */
+static size_t binlog_put_string(unsigned char* out, size_t space, const char* str, size_t len) {
+    if (space < 2) {
+        return 0;
+    }
+    if (len > space - 2) {
+        len = space - 2;
+    }
+    put_u16(out, (uint16_t)len);
+    memcpy(out + 2, str, len);
+    return 2 + len;
+}
+
+/**
+ * @brief Serializes the raw arguments of one line.
+ *
+ * @return The number of argument bytes written to out.
+ */
+static size_t binlog_encode_args(const binlog_intern_t* entry, va_list args, unsigned char* out, size_t space) {
+    size_t used = 0;
+    for (int i = 0; i < entry->spec_count; i++) {
+        const binlog_spec_t* spec = &entry->specs[i];
+        int stars = spec->width_star + spec->precision_star;
+        for (int s = 0; s < stars && used + 8 <= space; s++) {
+            put_u64(out + used, (uint64_t)(int64_t)va_arg(args, int));
+            used += 8;
+        }
+        if (used + 8 > space) {
+            break;
+        }
+
+        uint64_t value = 0;
+        switch (spec->kind) {
+            case BINLOG_ARG_SIGNED:
+                switch (spec->length) {
+                    case BINLOG_LEN_LONG: value = (uint64_t)(int64_t)va_arg(args, long); break;
+                    case BINLOG_LEN_LONG_LONG: value = (uint64_t)(int64_t)va_arg(args, long long); break;
+                    case BINLOG_LEN_INTMAX: value = (uint64_t)(int64_t)va_arg(args, intmax_t); break;
+                    case BINLOG_LEN_SIZE: value = (uint64_t)(int64_t)va_arg(args, ssize_t); break;
+                    case BINLOG_LEN_PTRDIFF: value = (uint64_t)(int64_t)va_arg(args, ptrdiff_t); break;
+                    default: value = (uint64_t)(int64_t)va_arg(args, int); break;
+                }
+                break;
+            case BINLOG_ARG_UNSIGNED:
+                switch (spec->length) {
+                    case BINLOG_LEN_LONG: value = va_arg(args, unsigned long); break;
+                    case BINLOG_LEN_LONG_LONG: value = va_arg(args, unsigned long long); break;
+                    case BINLOG_LEN_INTMAX: value = va_arg(args, uintmax_t); break;
+                    case BINLOG_LEN_SIZE: value = va_arg(args, size_t); break;
+                    case BINLOG_LEN_PTRDIFF: value = (uint64_t)va_arg(args, ptrdiff_t); break;
+                    default: value = va_arg(args, unsigned int); break;
+                }
+                break;
+            case BINLOG_ARG_DOUBLE: {
+                double d = spec->length == BINLOG_LEN_LONG_DOUBLE ? (double)va_arg(args, long double)
+                                                                  : va_arg(args, double);
+                memcpy(&value, &d, sizeof(value));
+                break;
+            }
+            case BINLOG_ARG_POINTER:
+                value = (uint64_t)(uintptr_t)va_arg(args, void*);
+                break;
+            case BINLOG_ARG_STRING: {
+                const char* str = va_arg(args, const char*);
+                if (str == NULL) {
+                    str = "(null)";
+                }
+                used += binlog_put_string(out + used, space - used, str, strlen(str));
+                continue;
+            }
+        }
+        put_u64(out + used, value);
+        used += 8;
+    }
+    return used;
+}
+
+/**
+ * @brief Initializes logging into a compact binary file instead of text lines.
+ *
+ * @param level The minimum log level to output.
+ * @param log_file_path The binary log file to create (truncated if it exists).
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError init_logging_binary(LogLevel level, const char* log_file_path) {
+    if (log_file_path == NULL || log_file_path[0] == '\0') {
+        fprintf(stderr, "init_logging_binary: A log file path is required\n");
+        return SECURE_COMM_ERR_LOG;
+    }
+
+    pthread_mutex_lock(&binlog_mutex);
+    if (binlog_file != NULL) {
+        fprintf(stderr, "init_logging_binary: Binary logging is already running\n");
+        pthread_mutex_unlock(&binlog_mutex);
+        return SECURE_COMM_ERR_LOG;
+    }
+
+    binlog_interned = (binlog_intern_t*)calloc(BINLOG_INTERN_SLOTS, sizeof(binlog_intern_t));
+    binlog_file = binlog_interned ? fopen(log_file_path, "wb") : NULL;
+    if (binlog_file == NULL) {
+        fprintf(stderr, "init_logging_binary: Failed to open log file '%s'\n", log_file_path);
+        free(binlog_interned);
+        binlog_interned = NULL;
+        pthread_mutex_unlock(&binlog_mutex);
+        return SECURE_COMM_ERR_LOG;
+    }
+    binlog_next_id = 0;
+
+    // Records are small; let stdio batch them into large writes
+    setvbuf(binlog_file, NULL, _IOFBF, 64 * 1024);
+
+    unsigned char header[28];
+    memcpy(header, SECURE_BINLOG_MAGIC, 8);
+    put_u32(header + 8, BINLOG_VERSION);
+    put_u64(header + 12, clock_ns(CLOCK_REALTIME));
+    put_u64(header + 20, clock_ns(CLOCK_MONOTONIC));
+    fwrite(header, 1, sizeof(header), binlog_file);
+
+    // Interned first so lines can always fall back to text, even with a full table
+    binlog_intern(binlog_text_format);
+    pthread_mutex_unlock(&binlog_mutex);
+
+    // Sets the level and keeps the text sink on the console for anything logged after cleanup
+    SecureCommError ret = init_logging(level, NULL);
+    if (ret != SECURE_COMM_SUCCESS) {
+        binary_log_close();
+        return ret;
+    }
+    atomic_store(&binlog_enabled, 1);
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Reports whether log_message currently writes to the binary sink.
+ */
+int binary_log_active(void) {
+    return atomic_load_explicit(&binlog_enabled, memory_order_relaxed);
+}
+
+/**
+ * @brief Writes one line to the binary sink (called by log_message).
+ *
+ * Errors are flushed to the file at once; other levels go out when the stdio
+ * buffer fills or the sink is closed.
+ *
+ * @param level The log level of the message.
+ * @param format The format string (printf-style); its address identifies it.
+ * @param args Arguments for the format string.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError binary_log_vwrite(LogLevel level, const char* format, va_list args) {
+    uint64_t now = clock_ns(CLOCK_MONOTONIC);
+    unsigned char record[BINLOG_RECORD_MAX];
+
+    pthread_mutex_lock(&binlog_mutex);
+    if (binlog_file == NULL) {
+        pthread_mutex_unlock(&binlog_mutex);
+        return SECURE_COMM_ERR_LOG;
+    }
+
+    // A full table stores the formatted text under the "%s" entry interned at open
+    binlog_intern_t* entry = binlog_intern(format);
+    if (entry == NULL) {
+        entry = binlog_intern(binlog_text_format);
+    }
+
+    const size_t header_len = 16;
+    size_t args_len;
+    if (entry->spec_count < 0 || entry->format != format) {
+        char text[SECURE_LOG_MESSAGE_MAX];
+        int text_len = vsnprintf(text, sizeof(text), format, args);
+        if (text_len < 0) {
+            pthread_mutex_unlock(&binlog_mutex);
+            return SECURE_COMM_ERR_LOG;
+        }
+        if ((size_t)text_len >= sizeof(text)) {
+            text_len = (int)sizeof(text) - 1;
+        }
+        args_len = binlog_put_string(record + header_len, sizeof(record) - header_len, text, (size_t)text_len);
+    } else {
+        args_len = binlog_encode_args(entry, args, record + header_len, sizeof(record) - header_len);
+    }
+
+    record[0] = BINLOG_RECORD_LINE;
+    put_u32(record + 1, entry->id);
+    record[5] = (unsigned char)level;
+    put_u64(record + 6, now);
+    put_u16(record + 14, (uint16_t)args_len);
+
+    SecureCommError ret = SECURE_COMM_SUCCESS;
+    if (fwrite(record, 1, header_len + args_len, binlog_file) != header_len + args_len) {
+        ret = SECURE_COMM_ERR_LOG;
+    }
+    if (level == LOG_LEVEL_ERROR) {
+        fflush(binlog_file);
+    }
+    pthread_mutex_unlock(&binlog_mutex);
+    return ret;
+}
+
+/**
+ * @brief Flushes and closes the binary sink (called by cleanup_logging).
+ */
+void binary_log_close(void) {
+    atomic_store(&binlog_enabled, 0);
+    pthread_mutex_lock(&binlog_mutex);
+    if (binlog_file) {
+        fclose(binlog_file);
+        binlog_file = NULL;
+    }
+    free(binlog_interned);
+    binlog_interned = NULL;
+    pthread_mutex_unlock(&binlog_mutex);
+}
+
+/**
+ * @brief Formats one line of a decoded record into text.
+ *
+ * Walks the format again, re-creating each conversion with a normalized length
+ * modifier so the stored 64-bit values can be passed to snprintf.
+ *
+ * @return 0 on success, -1 if the arguments do not match the format.
+ */
+static int binlog_format_line(const char* format, const unsigned char* args, size_t args_len,
+                              char* out, size_t out_len) {
+    binlog_spec_t specs[BINLOG_MAX_SPECS];
+    int count = binlog_parse_format(format, specs);
+    if (count < 0) {
+        return -1;
+    }
+
+    size_t used = 0;
+    size_t pos = 0;
+    const char* literal = format;
+#define BINLOG_APPEND(...)                                                             \
+    do {                                                                               \
+        int n = snprintf(out + used, out_len - used, __VA_ARGS__);                     \
+        used = (n < 0 || (size_t)n >= out_len - used) ? out_len - 1 : used + (size_t)n; \
+    } while (0)
+
+    for (int i = 0; i < count; i++) {
+        const binlog_spec_t* spec = &specs[i];
+
+        // Literal text before the conversion, with %% collapsed
+        for (const char* p = literal; p < spec->start; p++) {
+            if (p[0] == '%' && p[1] == '%') {
+                p++;
+            }
+            if (used + 1 < out_len) {
+                out[used++] = *p;
+            }
+        }
+        literal = spec->end;
+
+        // Rebuild the conversion: flags, then width/precision with '*' replaced by the stored values
+        char conversion[64];
+        size_t c = 0;
+        char conv_char = spec->end[-1];
+        for (const char* p = spec->start; p < spec->end - 1 && c < sizeof(conversion) - 24; p++) {
+            if (*p == '*') {
+                if (pos + 8 > args_len) {
+                    return -1;
+                }
+                c += (size_t)snprintf(conversion + c, sizeof(conversion) - c, "%d", (int)(int64_t)get_u64(args + pos));
+                pos += 8;
+            } else if (strchr("hljztL", *p) == NULL) {
+                conversion[c++] = *p;
+            }
+        }
+
+        if (spec->kind == BINLOG_ARG_STRING) {
+            if (pos + 2 > args_len || pos + 2 + get_u16(args + pos) > args_len) {
+                return -1;
+            }
+            uint16_t len = get_u16(args + pos);
+            c += (size_t)snprintf(conversion + c, sizeof(conversion) - c, "s");
+            conversion[c] = '\0';
+            char str[SECURE_LOG_MESSAGE_MAX + 1];
+            size_t copy = len < sizeof(str) - 1 ? len : sizeof(str) - 1;
+            memcpy(str, args + pos + 2, copy);
+            str[copy] = '\0';
+            pos += 2 + (size_t)len;
+            BINLOG_APPEND(conversion, str);
+            continue;
+        }
+
+        if (pos + 8 > args_len) {
+            return -1;
+        }
+        uint64_t value = get_u64(args + pos);
+        pos += 8;
+        switch (spec->kind) {
+            case BINLOG_ARG_SIGNED:
+                if (conv_char == 'c') {
+                    conversion[c++] = 'c';
+                    conversion[c] = '\0';
+                    BINLOG_APPEND(conversion, (int)(int64_t)value);
+                } else {
+                    c += (size_t)snprintf(conversion + c, sizeof(conversion) - c, "ll%c", conv_char);
+                    BINLOG_APPEND(conversion, (long long)(int64_t)value);
+                }
+                break;
+            case BINLOG_ARG_UNSIGNED:
+                c += (size_t)snprintf(conversion + c, sizeof(conversion) - c, "ll%c", conv_char);
+                BINLOG_APPEND(conversion, (unsigned long long)value);
+                break;
+            case BINLOG_ARG_DOUBLE: {
+                double d;
+                memcpy(&d, &value, sizeof(d));
+                conversion[c++] = conv_char;
+                conversion[c] = '\0';
+                BINLOG_APPEND(conversion, d);
+                break;
+            }
+            case BINLOG_ARG_POINTER:
+                conversion[c++] = 'p';
+                conversion[c] = '\0';
+                BINLOG_APPEND(conversion, (void*)(uintptr_t)value);
+                break;
+            default:
+                return -1;
+        }
+    }
+#undef BINLOG_APPEND
+
+    for (const char* p = literal; *p; p++) {
+        if (p[0] == '%' && p[1] == '%') {
+            p++;
+        }
+        if (used + 1 < out_len) {
+            out[used++] = *p;
+        }
+    }
+    out[used] = '\0';
+    return 0;
+}
+
+/**
+ * @brief Converts a binary log back into "[time] [LEVEL] message" text lines.
+ *
+ * @param in The binary log, positioned at its start.
+ * @param out Destination for the text lines.
+ * @param records Optional pointer to store the number of lines decoded.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or SECURE_COMM_ERR_LOG for a damaged or
+ *         truncated file (lines before the damage are still written).
+ */
+SecureCommError binary_log_decode(FILE* in, FILE* out, size_t* records) {
+    static const char* level_strings[] = {"ERROR", "WARN", "INFO", "DEBUG"};
+    if (records) {
+        *records = 0;
+    }
+    if (in == NULL || out == NULL) {
+        fprintf(stderr, "binary_log_decode: Invalid arguments\n");
+        return SECURE_COMM_ERR_LOG;
+    }
+
+    unsigned char header[28];
+    if (fread(header, 1, sizeof(header), in) != sizeof(header) ||
+        memcmp(header, SECURE_BINLOG_MAGIC, 8) != 0 || get_u32(header + 8) != BINLOG_VERSION) {
+        fprintf(stderr, "binary_log_decode: Not a binary log (or an unsupported version)\n");
+        return SECURE_COMM_ERR_LOG;
+    }
+    uint64_t realtime_base = get_u64(header + 12);
+    uint64_t monotonic_base = get_u64(header + 20);
+
+    char** formats = NULL;
+    size_t format_count = 0;
+    SecureCommError ret = SECURE_COMM_SUCCESS;
+    unsigned char buffer[BINLOG_RECORD_MAX];
+    char line[SECURE_LOG_MESSAGE_MAX * 2];
+    char time_buffer[20] = "";
+    time_t cached_second = (time_t)-1;
+
+    int kind;
+    while ((kind = fgetc(in)) != EOF) {
+        if (kind == BINLOG_RECORD_FORMAT) {
+            unsigned char def[6];
+            if (fread(def, 1, sizeof(def), in) != sizeof(def)) {
+                ret = SECURE_COMM_ERR_LOG;
+                break;
+            }
+            uint32_t id = get_u32(def);
+            uint16_t len = get_u16(def + 4);
+            char* format = (char*)malloc((size_t)len + 1);
+            if (format == NULL || fread(format, 1, len, in) != len) {
+                free(format);
+                ret = format ? SECURE_COMM_ERR_LOG : SECURE_COMM_ERR_MEMORY;
+                break;
+            }
+            format[len] = '\0';
+
+            // IDs are handed out in order, so the table only ever grows by one
+            if (id != format_count) {
+                free(format);
+                ret = SECURE_COMM_ERR_LOG;
+                break;
+            }
+            char** grown = (char**)realloc(formats, (format_count + 1) * sizeof(char*));
+            if (grown == NULL) {
+                free(format);
+                ret = SECURE_COMM_ERR_MEMORY;
+                break;
+            }
+            formats = grown;
+            formats[format_count++] = format;
+        } else if (kind == BINLOG_RECORD_LINE) {
+            unsigned char head[15];
+            if (fread(head, 1, sizeof(head), in) != sizeof(head)) {
+                ret = SECURE_COMM_ERR_LOG;
+                break;
+            }
+            uint32_t id = get_u32(head);
+            unsigned int level = head[4];
+            uint64_t timestamp = get_u64(head + 5);
+            uint16_t args_len = get_u16(head + 13);
+            if (id >= format_count || args_len > sizeof(buffer) ||
+                fread(buffer, 1, args_len, in) != args_len ||
+                binlog_format_line(formats[id], buffer, args_len, line, sizeof(line)) != 0) {
+                ret = SECURE_COMM_ERR_LOG;
+                break;
+            }
+
+            // Wall-clock time = time at open + monotonic time elapsed since
+            uint64_t wall_ns = realtime_base + (timestamp - monotonic_base);
+            time_t second = (time_t)(wall_ns / 1000000000ull);
+            if (second != cached_second) {
+                struct tm timeinfo;
+                if (localtime_r(&second, &timeinfo) == NULL ||
+                    strftime(time_buffer, sizeof(time_buffer), "%Y-%m-%d %H:%M:%S", &timeinfo) == 0) {
+                    strcpy(time_buffer, "?");
+                }
+                cached_second = second;
+            }
+            fprintf(out, "[%s] [%s] %s\n", time_buffer,
+                    level <= LOG_LEVEL_DEBUG ? level_strings[level] : "UNKNOWN", line);
+            if (records) {
+                (*records)++;
+            }
+        } else {
+            ret = SECURE_COMM_ERR_LOG;
+            break;
+        }
+    }
+
+    if (ret != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "binary_log_decode: Damaged or truncated record\n");
+    }
+    for (size_t i = 0; i < format_count; i++) {
+        free(formats[i]);
+    }
+    free(formats);
+    return ret;
+}
@@ -0,0 +1,722 @@
+// broadcast.c
+
+#include "secure_comm.h"
+
+#include <stdio.h>      // For fprintf
+#include <stdlib.h>     // For malloc, calloc, realloc, free
+#include <string.h>     // For memcpy, strcmp, strlen
+#include <pthread.h>    // For the hub and queue locks
+#include <errno.h>      // For ETIMEDOUT
+#include <time.h>       // For clock_gettime
+
+#include <openssl/rand.h>     // For group keys and their nonce salts
+#include <openssl/crypto.h>   // For OPENSSL_cleanse
+
+#define GROUP_KEY_SIZE 32
+
+// Definition of the opaque BroadcastSubscriber structure
+struct BroadcastSubscriber {
+    BroadcastHub* hub;
+    SecureCipher* cipher;       // Recipient's session cipher
+    pthread_mutex_t lock;       // Protects the queue and counters
+    pthread_cond_t ready;       // Signalled when a frame is queued or the subscriber closes
+    SecureBuffer** ring;        // max_queued slots
+    size_t head;                // Oldest queued frame
+    size_t count;
+    size_t queued_bytes;
+    uint64_t delivered;
+    uint64_t dropped;
+    int closed;
+};
+
+/**
+ * @brief A named topic and its subscribers.
+ */
+typedef struct broadcast_topic {
+    char* name;
+    BroadcastMode mode;
+    SecureCipher* group_cipher;             // Group-key topics only
+    unsigned char group_key[GROUP_KEY_SIZE];
+    uint32_t key_epoch;                     // Bumped each time a subscriber leaves and the key is replaced
+    BroadcastSubscriber** subscribers;
+    size_t subscriber_count;
+    size_t subscriber_capacity;
+    struct broadcast_topic* next;
+} broadcast_topic_t;
+
+// Definition of the opaque BroadcastHub structure
+struct BroadcastHub {
+    BroadcastHubConfig config;
+    pthread_mutex_t lock;       // Protects topics and membership; held for a whole publish
+    broadcast_topic_t* topics;
+};
+
+static broadcast_topic_t* find_topic(BroadcastHub* hub, const char* name) {
+    for (broadcast_topic_t* topic = hub->topics; topic != NULL; topic = topic->next) {
+        if (strcmp(topic->name, name) == 0) {
+            return topic;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Whether another frame of len bytes fits in the subscriber's queue. Caller holds its lock.
+ */
+static int queue_has_room(const BroadcastSubscriber* subscriber, size_t len) {
+    const BroadcastHubConfig* config = &subscriber->hub->config;
+    return subscriber->count < config->max_queued &&
+           (subscriber->count == 0 || subscriber->queued_bytes + len <= config->max_queued_bytes);
+}
+
+/**
+ * @brief Checks for room before any work is done for a subscriber, applying the full policy.
+ *
+ * @return 1 if a frame of len bytes can be queued, 0 if the subscriber is skipped.
+ */
+static int reserve_room(BroadcastSubscriber* subscriber, size_t len, BroadcastResult* result) {
+    pthread_mutex_lock(&subscriber->lock);
+    int room = !subscriber->closed && queue_has_room(subscriber, len);
+    if (!room && !subscriber->closed) {
+        if (subscriber->hub->config.on_full == BROADCAST_FULL_DISCONNECT) {
+            subscriber->closed = 1;
+            pthread_cond_broadcast(&subscriber->ready);
+            result->disconnected++;
+        } else {
+            subscriber->dropped++;
+            result->dropped++;
+        }
+    }
+    pthread_mutex_unlock(&subscriber->lock);
+    return room;
+}
+
+/**
+ * @brief Appends a frame to a subscriber's queue, taking a reference to it.
+ *
+ * Publishes are serialized, so the room found by reserve_room is still there.
+ */
+static void enqueue(BroadcastSubscriber* subscriber, SecureBuffer* frame, BroadcastResult* result) {
+    pthread_mutex_lock(&subscriber->lock);
+    if (subscriber->closed) {
+        pthread_mutex_unlock(&subscriber->lock);
+        return;
+    }
+    secure_buffer_retain(frame);
+    size_t slot = (subscriber->head + subscriber->count) % subscriber->hub->config.max_queued;
+    subscriber->ring[slot] = frame;
+    subscriber->count++;
+    subscriber->queued_bytes += secure_buffer_len(frame);
+    pthread_cond_signal(&subscriber->ready);
+    pthread_mutex_unlock(&subscriber->lock);
+    result->queued++;
+}
+
+/**
+ * @brief Releases every queued frame. Caller holds the subscriber's lock.
+ */
+static void discard_queue(BroadcastSubscriber* subscriber) {
+    while (subscriber->count > 0) {
+        secure_buffer_release(subscriber->ring[subscriber->head]);
+        subscriber->head = (subscriber->head + 1) % subscriber->hub->config.max_queued;
+        subscriber->count--;
+    }
+    subscriber->queued_bytes = 0;
+}
+
+/**
+ * @brief Builds header || IV || tag || ciphertext for a payload sealed under one cipher.
+ */
+static SecureCommError seal_frame(BufferPool* pool, SecureCipher* cipher, uint8_t type, uint8_t flags, uint8_t codec,
+                                  const unsigned char* payload, size_t len, const unsigned char* extra,
+                                  size_t extra_len, SecureBuffer** frame) {
+    SecureCommError ret = buffer_pool_get(pool, SECURE_FRAME_HEADER_SIZE + SECURE_RECORD_OVERHEAD + len + extra_len, frame);
+    if (ret != SECURE_COMM_SUCCESS) {
+        return ret;
+    }
+
+    unsigned char* record = secure_buffer_data(*frame) + SECURE_FRAME_HEADER_SIZE;
+    memcpy(record + SECURE_RECORD_OVERHEAD, payload, len);
+    if (extra_len > 0) {
+        memcpy(record + SECURE_RECORD_OVERHEAD + len, extra, extra_len);
+    }
+    size_t record_len = 0;
+    ret = cipher_seal_record(cipher, record, len + extra_len, &record_len);
+    if (ret != SECURE_COMM_SUCCESS) {
+        secure_buffer_release(*frame);
+        *frame = NULL;
+        return ret;
+    }
+
+    FrameHeader header = { (uint32_t)record_len, type, flags, codec, (uint8_t)cipher_get_suite(cipher) };
+    frame_encode_header(&header, secure_buffer_data(*frame));
+    secure_buffer_set_len(*frame, SECURE_FRAME_HEADER_SIZE + record_len);
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Replaces a group-key topic's key and cipher with fresh ones for its current epoch.
+ *
+ * The suite travels in the GROUP_KEY payload, and in the header of every group frame.
+ *
+ * The nonce salt is the epoch with the top bit set (group frames travel server to client),
+ * so every group frame names the key it was sealed under. On failure the old key stays.
+ */
+static SecureCommError key_group_cipher(broadcast_topic_t* topic, CipherSuite suite) {
+    unsigned char key[GROUP_KEY_SIZE];
+    unsigned char salt[SECURE_NONCE_SALT_SIZE];
+    uint32_t epoch_salt = topic->key_epoch | 0x80000000u;
+    salt[0] = (unsigned char)(epoch_salt >> 24);
+    salt[1] = (unsigned char)(epoch_salt >> 16);
+    salt[2] = (unsigned char)(epoch_salt >> 8);
+    salt[3] = (unsigned char)epoch_salt;
+
+    SecureCipher* cipher = NULL;
+    if (!RAND_bytes(key, sizeof(key)) ||
+        cipher_create_suite(suite, key, sizeof(key), &cipher) != SECURE_COMM_SUCCESS ||
+        cipher_use_counter_nonces(cipher, salt) != SECURE_COMM_SUCCESS) {
+        cipher_destroy(cipher);
+        OPENSSL_cleanse(key, sizeof(key));
+        return SECURE_COMM_ERR_ENCRYPT;
+    }
+    cipher_destroy(topic->group_cipher);
+    topic->group_cipher = cipher;
+    memcpy(topic->group_key, key, sizeof(key));
+    OPENSSL_cleanse(key, sizeof(key));
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Queues a GROUP_KEY frame, key || epoch || suite || topic name, sealed under the
+ *        subscriber's cipher.
+ *        Caller holds the hub lock.
+ *
+ * @return SECURE_COMM_SUCCESS once queued, or SECURE_COMM_ERR_MEMORY if the queue is full or closed.
+ */
+static SecureCommError queue_group_key(BroadcastHub* hub, broadcast_topic_t* topic, BroadcastSubscriber* subscriber) {
+    size_t name_len = strlen(topic->name);
+    size_t payload_len = GROUP_KEY_SIZE + 4 + 1 + name_len;
+    unsigned char* payload = (unsigned char*)malloc(payload_len);
+    if (payload == NULL) {
+        return SECURE_COMM_ERR_MEMORY;
+    }
+    memcpy(payload, topic->group_key, GROUP_KEY_SIZE);
+    payload[GROUP_KEY_SIZE] = (unsigned char)(topic->key_epoch >> 24);
+    payload[GROUP_KEY_SIZE + 1] = (unsigned char)(topic->key_epoch >> 16);
+    payload[GROUP_KEY_SIZE + 2] = (unsigned char)(topic->key_epoch >> 8);
+    payload[GROUP_KEY_SIZE + 3] = (unsigned char)topic->key_epoch;
+    payload[GROUP_KEY_SIZE + 4] = (unsigned char)cipher_get_suite(topic->group_cipher);
+    memcpy(payload + GROUP_KEY_SIZE + 5, topic->name, name_len);
+
+    SecureBuffer* frame = NULL;
+    SecureCommError ret = seal_frame(hub->config.pool, subscriber->cipher, FRAME_TYPE_GROUP_KEY, 0, 0,
+                                     payload, payload_len, NULL, 0, &frame);
+    OPENSSL_cleanse(payload, GROUP_KEY_SIZE + 4);
+    free(payload);
+    if (ret != SECURE_COMM_SUCCESS) {
+        return ret;
+    }
+
+    // No drop policy here: a subscriber without the key could not read the topic at all
+    BroadcastResult result = { 0 };
+    pthread_mutex_lock(&subscriber->lock);
+    int room = !subscriber->closed && queue_has_room(subscriber, secure_buffer_len(frame));
+    pthread_mutex_unlock(&subscriber->lock);
+    if (room) {
+        enqueue(subscriber, frame, &result);
+    }
+    secure_buffer_release(frame);
+    return result.queued ? SECURE_COMM_SUCCESS : SECURE_COMM_ERR_MEMORY;
+}
+
+/**
+ * @brief Picks the suite for a group-key topic's key from its members' session suites.
+ *
+ * Members that all negotiated one suite get it, so ChaCha20-Poly1305 clients without AES
+ * instructions are not made to open every broadcast with software AES. A mixed topic uses
+ * AES-GCM, which every client supports. An empty topic keeps its current suite.
+ *
+ * @param joining A subscriber about to be added, or NULL.
+ */
+static CipherSuite common_suite(const broadcast_topic_t* topic, const BroadcastSubscriber* joining) {
+    CipherSuite current = cipher_get_suite(topic->group_cipher);
+    CipherSuite suite = joining != NULL ? cipher_get_suite(joining->cipher) : CIPHER_SUITE_COUNT;
+    for (size_t i = 0; i < topic->subscriber_count; i++) {
+        CipherSuite member = cipher_get_suite(topic->subscribers[i]->cipher);
+        if (suite == CIPHER_SUITE_COUNT) {
+            suite = member;
+        } else if (member != suite) {
+            return CIPHER_SUITE_AES_GCM;
+        }
+    }
+    return suite == CIPHER_SUITE_COUNT ? current : suite;
+}
+
+/**
+ * @brief Gives a group-key topic a new key under the given suite. Caller holds the hub lock.
+ *
+ * Used when a subscriber leaves, since it still knows the old key, and when a joining
+ * subscriber changes the members' common suite. The new key is sealed to each current
+ * subscriber under its own cipher. The key frame queues behind frames sealed with the old key,
+ * so each subscriber switches keys at the right point. A subscriber that cannot take the frame
+ * is closed rather than left on a key it can no longer use. If no new key can be made, every
+ * subscriber is closed so that nothing more goes out under the old one.
+ */
+static void rotate_group_key(BroadcastHub* hub, broadcast_topic_t* topic, CipherSuite suite) {
+    topic->key_epoch++;
+    int keyed = key_group_cipher(topic, suite) == SECURE_COMM_SUCCESS;
+    if (!keyed) {
+        topic->key_epoch--;
+        fprintf(stderr, "rotate_group_key: Failed to replace the key of topic '%s'\n", topic->name);
+    }
+    for (size_t i = 0; i < topic->subscriber_count; i++) {
+        if (!keyed || queue_group_key(hub, topic, topic->subscribers[i]) != SECURE_COMM_SUCCESS) {
+            broadcast_subscriber_close(topic->subscribers[i]);
+        }
+    }
+}
+
+/**
+ * @brief Fills a BroadcastHubConfig with the defaults.
+ */
+void broadcast_hub_config_defaults(BroadcastHubConfig* config) {
+    if (config == NULL) {
+        return;
+    }
+    config->max_queued = 256;
+    config->max_queued_bytes = 1024 * 1024;
+    config->on_full = BROADCAST_FULL_DROP;
+    config->pool = NULL;
+}
+
+/**
+ * @brief Creates a broadcast hub.
+ */
+SecureCommError broadcast_hub_create(const BroadcastHubConfig* config, BroadcastHub** hub) {
+    BroadcastHubConfig defaults;
+    if (config == NULL) {
+        broadcast_hub_config_defaults(&defaults);
+        config = &defaults;
+    }
+    if (hub == NULL || config->max_queued == 0 || config->max_queued_bytes == 0) {
+        fprintf(stderr, "broadcast_hub_create: Invalid arguments\n");
+        return SECURE_COMM_ERR_SESSION;
+    }
+
+    BroadcastHub* new_hub = (BroadcastHub*)calloc(1, sizeof(BroadcastHub));
+    if (new_hub == NULL) {
+        fprintf(stderr, "broadcast_hub_create: Failed to allocate memory for hub\n");
+        return SECURE_COMM_ERR_MEMORY;
+    }
+    new_hub->config = *config;
+    pthread_mutex_init(&new_hub->lock, NULL);
+    *hub = new_hub;
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Creates a topic (room).
+ */
+SecureCommError broadcast_topic_create(BroadcastHub* hub, const char* name, BroadcastMode mode) {
+    if (hub == NULL || name == NULL || (mode != BROADCAST_PER_RECIPIENT && mode != BROADCAST_GROUP_KEY)) {
+        fprintf(stderr, "broadcast_topic_create: Invalid arguments\n");
+        return SECURE_COMM_ERR_SESSION;
+    }
+
+    broadcast_topic_t* topic = (broadcast_topic_t*)calloc(1, sizeof(broadcast_topic_t));
+    if (topic == NULL || (topic->name = strdup(name)) == NULL) {
+        fprintf(stderr, "broadcast_topic_create: Failed to allocate memory for topic\n");
+        free(topic);
+        return SECURE_COMM_ERR_MEMORY;
+    }
+    topic->mode = mode;
+
+    if (mode == BROADCAST_GROUP_KEY) {
+        if (key_group_cipher(topic, CIPHER_SUITE_AES_GCM) != SECURE_COMM_SUCCESS) {
+            fprintf(stderr, "broadcast_topic_create: Failed to key the group cipher\n");
+            free(topic->name);
+            free(topic);
+            return SECURE_COMM_ERR_ENCRYPT;
+        }
+    }
+
+    pthread_mutex_lock(&hub->lock);
+    if (find_topic(hub, name) != NULL) {
+        pthread_mutex_unlock(&hub->lock);
+        fprintf(stderr, "broadcast_topic_create: Topic '%s' already exists\n", name);
+        cipher_destroy(topic->group_cipher);
+        OPENSSL_cleanse(topic->group_key, sizeof(topic->group_key));
+        free(topic->name);
+        free(topic);
+        return SECURE_COMM_ERR_SESSION;
+    }
+    topic->next = hub->topics;
+    hub->topics = topic;
+    pthread_mutex_unlock(&hub->lock);
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Creates a subscriber with an empty queue.
+ */
+SecureCommError broadcast_subscriber_create(BroadcastHub* hub, SecureCipher* cipher, BroadcastSubscriber** subscriber) {
+    if (hub == NULL || subscriber == NULL) {
+        fprintf(stderr, "broadcast_subscriber_create: Invalid arguments\n");
+        return SECURE_COMM_ERR_SESSION;
+    }
+
+    BroadcastSubscriber* new_subscriber = (BroadcastSubscriber*)calloc(1, sizeof(BroadcastSubscriber));
+    if (new_subscriber == NULL ||
+        (new_subscriber->ring = (SecureBuffer**)calloc(hub->config.max_queued, sizeof(SecureBuffer*))) == NULL) {
+        fprintf(stderr, "broadcast_subscriber_create: Failed to allocate memory for subscriber\n");
+        free(new_subscriber);
+        return SECURE_COMM_ERR_MEMORY;
+    }
+    new_subscriber->hub = hub;
+    new_subscriber->cipher = cipher;
+    pthread_mutex_init(&new_subscriber->lock, NULL);
+    pthread_cond_init(&new_subscriber->ready, NULL);
+    *subscriber = new_subscriber;
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Adds a subscriber to a topic.
+ */
+SecureCommError broadcast_subscribe(BroadcastSubscriber* subscriber, const char* topic_name) {
+    if (subscriber == NULL || topic_name == NULL) {
+        fprintf(stderr, "broadcast_subscribe: Invalid arguments\n");
+        return SECURE_COMM_ERR_SESSION;
+    }
+
+    BroadcastHub* hub = subscriber->hub;
+    pthread_mutex_lock(&hub->lock);
+    broadcast_topic_t* topic = find_topic(hub, topic_name);
+    if (topic == NULL || subscriber->cipher == NULL) {
+        pthread_mutex_unlock(&hub->lock);
+        fprintf(stderr, "broadcast_subscribe: %s\n", topic == NULL ? "Unknown topic" : "Subscriber has no cipher");
+        return SECURE_COMM_ERR_SESSION;
+    }
+    for (size_t i = 0; i < topic->subscriber_count; i++) {
+        if (topic->subscribers[i] == subscriber) {
+            pthread_mutex_unlock(&hub->lock);
+            return SECURE_COMM_SUCCESS;
+        }
+    }
+
+    if (topic->subscriber_count == topic->subscriber_capacity) {
+        size_t capacity = topic->subscriber_capacity ? topic->subscriber_capacity * 2 : 16;
+        BroadcastSubscriber** grown = (BroadcastSubscriber**)realloc(topic->subscribers,
+                                                                     capacity * sizeof(BroadcastSubscriber*));
+        if (grown == NULL) {
+            pthread_mutex_unlock(&hub->lock);
+            fprintf(stderr, "broadcast_subscribe: Failed to allocate memory for subscriber list\n");
+            return SECURE_COMM_ERR_MEMORY;
+        }
+        topic->subscribers = grown;
+        topic->subscriber_capacity = capacity;
+    }
+
+    // The group key goes out ahead of any frame sealed with it. A newcomer on another suite
+    // moves the topic to the suite everyone shares, and the current members get that key first.
+    if (topic->mode == BROADCAST_GROUP_KEY) {
+        CipherSuite suite = common_suite(topic, subscriber);
+        if (suite != cipher_get_suite(topic->group_cipher)) {
+            rotate_group_key(hub, topic, suite);
+        }
+        SecureCommError ret = queue_group_key(hub, topic, subscriber);
+        if (ret != SECURE_COMM_SUCCESS) {
+            pthread_mutex_unlock(&hub->lock);
+            fprintf(stderr, "broadcast_subscribe: Failed to queue the group key\n");
+            return ret;
+        }
+    }
+
+    topic->subscribers[topic->subscriber_count++] = subscriber;
+    pthread_mutex_unlock(&hub->lock);
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Removes a subscriber from one topic. Caller holds the hub lock.
+ */
+static int topic_remove(broadcast_topic_t* topic, BroadcastSubscriber* subscriber) {
+    for (size_t i = 0; i < topic->subscriber_count; i++) {
+        if (topic->subscribers[i] == subscriber) {
+            topic->subscribers[i] = topic->subscribers[--topic->subscriber_count];
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Removes a subscriber from a topic.
+ */
+SecureCommError broadcast_unsubscribe(BroadcastSubscriber* subscriber, const char* topic_name) {
+    if (subscriber == NULL || topic_name == NULL) {
+        fprintf(stderr, "broadcast_unsubscribe: Invalid arguments\n");
+        return SECURE_COMM_ERR_SESSION;
+    }
+
+    pthread_mutex_lock(&subscriber->hub->lock);
+    broadcast_topic_t* topic = find_topic(subscriber->hub, topic_name);
+    int removed = topic != NULL && topic_remove(topic, subscriber);
+    if (removed && topic->mode == BROADCAST_GROUP_KEY) {
+        rotate_group_key(subscriber->hub, topic, common_suite(topic, NULL));
+    }
+    pthread_mutex_unlock(&subscriber->hub->lock);
+    return removed ? SECURE_COMM_SUCCESS : SECURE_COMM_ERR_SESSION;
+}
+
+/**
+ * @brief Seals the payload once per subscriber through the batch AEAD path. Caller holds the hub lock.
+ */
+static SecureCommError publish_per_recipient(BroadcastHub* hub, broadcast_topic_t* topic, CompressionCodecId codec,
+                                             const unsigned char* payload, size_t len, BroadcastResult* result) {
+    size_t frame_len = SECURE_FRAME_HEADER_SIZE + SECURE_RECORD_OVERHEAD + len;
+    AeadBatchItem* items = (AeadBatchItem*)calloc(topic->subscriber_count, sizeof(AeadBatchItem));
+    SecureBuffer** frames = (SecureBuffer**)calloc(topic->subscriber_count, sizeof(SecureBuffer*));
+    BroadcastSubscriber** recipients = (BroadcastSubscriber**)calloc(topic->subscriber_count,
+                                                                    sizeof(BroadcastSubscriber*));
+    if (items == NULL || frames == NULL || recipients == NULL) {
+        free(items);
+        free(frames);
+        free(recipients);
+        fprintf(stderr, "broadcast_publish: Failed to allocate memory for the batch\n");
+        return SECURE_COMM_ERR_MEMORY;
+    }
+
+    // Skip full queues before spending any encryption on them
+    size_t count = 0;
+    for (size_t i = 0; i < topic->subscriber_count; i++) {
+        BroadcastSubscriber* subscriber = topic->subscribers[i];
+        if (!reserve_room(subscriber, frame_len, result)) {
+            continue;
+        }
+        if (buffer_pool_get(hub->config.pool, frame_len, &frames[count]) != SECURE_COMM_SUCCESS) {
+            result->failed++;
+            continue;
+        }
+        unsigned char* record = secure_buffer_data(frames[count]) + SECURE_FRAME_HEADER_SIZE;
+        items[count].cipher = subscriber->cipher;
+        items[count].input = payload;
+        items[count].input_len = len;
+        items[count].iv = record;
+        items[count].tag = record + 12;
+        items[count].output = record + SECURE_RECORD_OVERHEAD;
+        recipients[count] = subscriber;
+        count++;
+    }
+
+    // Large fan-outs are spread over several threads
+    if (count > 0) {
+        encrypt_data_batch(items, count, NULL);
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (items[i].status == SECURE_COMM_SUCCESS) {
+            FrameHeader header = { (uint32_t)(SECURE_RECORD_OVERHEAD + len), FRAME_TYPE_DATA, 0, (uint8_t)codec,
+                                   (uint8_t)cipher_get_suite(items[i].cipher) };
+            frame_encode_header(&header, secure_buffer_data(frames[i]));
+            secure_buffer_set_len(frames[i], frame_len);
+            enqueue(recipients[i], frames[i], result);
+        } else {
+            result->failed++;
+        }
+        secure_buffer_release(frames[i]);
+    }
+
+    free(items);
+    free(frames);
+    free(recipients);
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Seals the payload once under the group key and queues the same frame everywhere.
+ *        Caller holds the hub lock.
+ */
+static SecureCommError publish_group(BroadcastHub* hub, broadcast_topic_t* topic, CompressionCodecId codec,
+                                     const unsigned char* payload, size_t len, BroadcastResult* result) {
+    SecureBuffer* frame = NULL;
+    SecureCommError ret = seal_frame(hub->config.pool, topic->group_cipher, FRAME_TYPE_DATA, FRAME_FLAG_GROUP,
+                                     (uint8_t)codec, payload, len, NULL, 0, &frame);
+    if (ret != SECURE_COMM_SUCCESS) {
+        result->failed = topic->subscriber_count;
+        return ret;
+    }
+
+    for (size_t i = 0; i < topic->subscriber_count; i++) {
+        if (reserve_room(topic->subscribers[i], secure_buffer_len(frame), result)) {
+            enqueue(topic->subscribers[i], frame, result);
+        }
+    }
+    secure_buffer_release(frame);
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Seals a message for every subscriber of a topic and queues the frames.
+ */
+SecureCommError broadcast_publish(BroadcastHub* hub, const char* topic_name, CompressionCodecId codec,
+                                  const unsigned char* payload, size_t len, BroadcastResult* result) {
+    BroadcastResult local;
+    if (result == NULL) {
+        result = &local;
+    }
+    memset(result, 0, sizeof(*result));
+    if (hub == NULL || topic_name == NULL || (payload == NULL && len > 0) || len > UINT32_MAX - SECURE_RECORD_OVERHEAD) {
+        fprintf(stderr, "broadcast_publish: Invalid arguments\n");
+        return SECURE_COMM_ERR_SESSION;
+    }
+
+    pthread_mutex_lock(&hub->lock);
+    broadcast_topic_t* topic = find_topic(hub, topic_name);
+    if (topic == NULL) {
+        pthread_mutex_unlock(&hub->lock);
+        fprintf(stderr, "broadcast_publish: Unknown topic '%s'\n", topic_name);
+        return SECURE_COMM_ERR_SESSION;
+    }
+    result->subscribers = topic->subscriber_count;
+    SecureCommError ret = SECURE_COMM_SUCCESS;
+    if (topic->subscriber_count > 0) {
+        ret = topic->mode == BROADCAST_GROUP_KEY ? publish_group(hub, topic, codec, payload, len, result)
+                                                 : publish_per_recipient(hub, topic, codec, payload, len, result);
+    }
+    pthread_mutex_unlock(&hub->lock);
+    return ret;
+}
+
+/**
+ * @brief Takes the next queued frame.
+ */
+SecureCommError broadcast_subscriber_next(BroadcastSubscriber* subscriber, int timeout_ms, SecureBuffer** frame) {
+    if (subscriber == NULL || frame == NULL) {
+        fprintf(stderr, "broadcast_subscriber_next: Invalid arguments\n");
+        return SECURE_COMM_ERR_SESSION;
+    }
+
+    struct timespec deadline;
+    if (timeout_ms > 0) {
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += timeout_ms / 1000;
+        deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+    }
+
+    pthread_mutex_lock(&subscriber->lock);
+    while (!subscriber->closed && subscriber->count == 0) {
+        if (timeout_ms == 0) {
+            break;
+        }
+        if (timeout_ms < 0) {
+            pthread_cond_wait(&subscriber->ready, &subscriber->lock);
+        } else if (pthread_cond_timedwait(&subscriber->ready, &subscriber->lock, &deadline) == ETIMEDOUT) {
+            break;
+        }
+    }
+
+    SecureCommError ret;
+    if (subscriber->closed) {
+        ret = SECURE_COMM_ERR_SESSION;
+    } else if (subscriber->count == 0) {
+        ret = SECURE_COMM_ERR_AGAIN;
+    } else {
+        // The queue's reference passes to the caller
+        *frame = subscriber->ring[subscriber->head];
+        subscriber->head = (subscriber->head + 1) % subscriber->hub->config.max_queued;
+        subscriber->count--;
+        subscriber->queued_bytes -= secure_buffer_len(*frame);
+        subscriber->delivered++;
+        ret = SECURE_COMM_SUCCESS;
+    }
+    pthread_mutex_unlock(&subscriber->lock);
+    return ret;
+}
+
+/**
+ * @brief Closes a subscriber: queued frames are discarded and waiting calls return.
+ */
+void broadcast_subscriber_close(BroadcastSubscriber* subscriber) {
+    if (subscriber == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&subscriber->lock);
+    subscriber->closed = 1;
+    discard_queue(subscriber);
+    pthread_cond_broadcast(&subscriber->ready);
+    pthread_mutex_unlock(&subscriber->lock);
+}
+
+/**
+ * @brief Copies a subscriber's counters.
+ */
+void broadcast_subscriber_stats(BroadcastSubscriber* subscriber, BroadcastSubscriberStats* stats) {
+    if (stats == NULL) {
+        return;
+    }
+    memset(stats, 0, sizeof(*stats));
+    if (subscriber == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&subscriber->lock);
+    stats->queued = subscriber->count;
+    stats->queued_bytes = subscriber->queued_bytes;
+    stats->delivered = subscriber->delivered;
+    stats->dropped = subscriber->dropped;
+    stats->closed = subscriber->closed;
+    pthread_mutex_unlock(&subscriber->lock);
+}
+
+/**
+ * @brief Leaves every topic and frees a subscriber.
+ */
+void broadcast_subscriber_destroy(BroadcastSubscriber* subscriber) {
+    if (subscriber == NULL) {
+        return;
+    }
+
+    // Once out of every topic, no publish can reach the subscriber
+    BroadcastHub* hub = subscriber->hub;
+    pthread_mutex_lock(&hub->lock);
+    for (broadcast_topic_t* topic = hub->topics; topic != NULL; topic = topic->next) {
+        if (topic_remove(topic, subscriber) && topic->mode == BROADCAST_GROUP_KEY) {
+            rotate_group_key(hub, topic, common_suite(topic, NULL));
+        }
+    }
+    pthread_mutex_unlock(&hub->lock);
+
+    pthread_mutex_lock(&subscriber->lock);
+    discard_queue(subscriber);
+    pthread_mutex_unlock(&subscriber->lock);
+    pthread_cond_destroy(&subscriber->ready);
+    pthread_mutex_destroy(&subscriber->lock);
+    free(subscriber->ring);
+    free(subscriber);
+}
+
+/**
+ * @brief Frees a hub and its topics.
+ */
+void broadcast_hub_destroy(BroadcastHub* hub) {
+    if (hub == NULL) {
+        return;
+    }
+
+    broadcast_topic_t* topic = hub->topics;
+    while (topic != NULL) {
+        broadcast_topic_t* next = topic->next;
+        cipher_destroy(topic->group_cipher);
+        OPENSSL_cleanse(topic->group_key, sizeof(topic->group_key));
+        free(topic->subscribers);
+        free(topic->name);
+        free(topic);
+        topic = next;
+    }
+    pthread_mutex_destroy(&hub->lock);
+    free(hub);
+}
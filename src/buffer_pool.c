@@ -0,0 +1,619 @@
+// buffer_pool.c
+
+#include "secure_comm.h"
+
+#include <stdio.h>      // For fprintf
+#include <stdlib.h>     // For malloc, calloc, free, posix_memalign
+#include <string.h>     // For memset
+#include <pthread.h>    // For the per-thread caches
+#include <stdatomic.h>  // For the reference counts
+
+// Buffers start on a cache line, and so does the data after their header
+#define BUFFER_ALIGN 64
+
+// Definition of the opaque SecureBuffer structure; the data follows the header
+struct SecureBuffer {
+    BufferPool* pool;
+    SecureBuffer* next;         // Free-list link while the buffer is not in use
+    atomic_uint refs;
+    int size_class;             // -1 for oversize buffers that go back to free()
+    size_t capacity;            // Bytes after the header
+    size_t offset;              // Bytes dropped from the front by secure_buffer_advance
+    size_t len;                 // Valid bytes from offset
+};
+
+#define BUFFER_HEADER_SIZE ((sizeof(SecureBuffer) + BUFFER_ALIGN - 1) & ~(size_t)(BUFFER_ALIGN - 1))
+
+/**
+ * @brief Free buffers kept by one thread for one pool. Only the owning thread
+ *        touches the lists; the counters are atomics so buffer_pool_stats can read them.
+ */
+typedef struct thread_cache {
+    BufferPool* pool;
+    struct thread_cache* prev;  // In pool->caches
+    struct thread_cache* next;
+    SecureBuffer* free[BUFFER_POOL_MAX_CLASSES];
+    size_t count[BUFFER_POOL_MAX_CLASSES];
+    _Atomic uint64_t gets;
+    _Atomic uint64_t releases;
+    _Atomic uint64_t cache_hits;
+} thread_cache_t;
+
+/**
+ * @brief Shared free list of one size class.
+ */
+typedef struct {
+    pthread_mutex_t lock;
+    SecureBuffer* free;
+    size_t count;
+} size_class_t;
+
+// Definition of the opaque BufferPool structure
+struct BufferPool {
+    BufferPoolConfig config;
+    int classes;
+    int min_shift;                          // log2 of the smallest class
+    size_t cache_limit[BUFFER_POOL_MAX_CLASSES];
+    size_class_t cls[BUFFER_POOL_MAX_CLASSES];
+    pthread_key_t cache_key;
+
+    pthread_mutex_t lock;                   // Protects slabs, caches and the folded totals
+    void* slabs;                            // Singly linked through each slab's first word
+    thread_cache_t* caches;
+
+    // Totals of exited threads, plus counters not tied to a thread cache
+    uint64_t gets;
+    uint64_t releases;
+    uint64_t cache_hits;
+    _Atomic uint64_t central_hits;
+    _Atomic uint64_t slab_count;
+    _Atomic uint64_t slab_bytes;
+    _Atomic uint64_t oversize;
+};
+
+static BufferPool* default_pool = NULL;
+static pthread_once_t default_pool_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t default_config_lock = PTHREAD_MUTEX_INITIALIZER;
+static BufferPoolConfig default_config;        // Set by buffer_pool_configure_default
+static int default_config_set = 0;
+static int default_pool_started = 0;
+
+/**
+ * @brief Fills a BufferPoolConfig with the defaults.
+ *
+ * @param config The configuration to fill.
+ */
+void buffer_pool_config_defaults(BufferPoolConfig* config) {
+    if (config == NULL) {
+        return;
+    }
+    memset(config, 0, sizeof(BufferPoolConfig));
+    config->min_size = 256;
+    config->max_size = 1024 * 1024;
+    config->slab_size = 256 * 1024;
+    config->thread_cache = 32;
+}
+
+/**
+ * @brief Hands a thread's cached buffers back to the shared lists.
+ */
+static void cache_drain(thread_cache_t* cache) {
+    BufferPool* pool = cache->pool;
+    for (int c = 0; c < pool->classes; c++) {
+        if (cache->free[c] == NULL) {
+            continue;
+        }
+        SecureBuffer* tail = cache->free[c];
+        while (tail->next != NULL) {
+            tail = tail->next;
+        }
+        pthread_mutex_lock(&pool->cls[c].lock);
+        tail->next = pool->cls[c].free;
+        pool->cls[c].free = cache->free[c];
+        pool->cls[c].count += cache->count[c];
+        pthread_mutex_unlock(&pool->cls[c].lock);
+        cache->free[c] = NULL;
+        cache->count[c] = 0;
+    }
+}
+
+/**
+ * @brief Thread-exit destructor: returns the cache's buffers and folds its counters.
+ */
+static void cache_destroy(void* ptr) {
+    thread_cache_t* cache = (thread_cache_t*)ptr;
+    BufferPool* pool = cache->pool;
+    cache_drain(cache);
+
+    pthread_mutex_lock(&pool->lock);
+    if (cache->prev) {
+        cache->prev->next = cache->next;
+    } else {
+        pool->caches = cache->next;
+    }
+    if (cache->next) {
+        cache->next->prev = cache->prev;
+    }
+    pool->gets += atomic_load(&cache->gets);
+    pool->releases += atomic_load(&cache->releases);
+    pool->cache_hits += atomic_load(&cache->cache_hits);
+    pthread_mutex_unlock(&pool->lock);
+    free(cache);
+}
+
+/**
+ * @brief Returns the calling thread's cache for a pool, creating it on first use.
+ */
+static thread_cache_t* cache_get(BufferPool* pool) {
+    thread_cache_t* cache = (thread_cache_t*)pthread_getspecific(pool->cache_key);
+    if (cache != NULL) {
+        return cache;
+    }
+
+    cache = (thread_cache_t*)calloc(1, sizeof(thread_cache_t));
+    if (cache == NULL) {
+        return NULL;
+    }
+    cache->pool = pool;
+    if (pthread_setspecific(pool->cache_key, cache) != 0) {
+        free(cache);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    cache->next = pool->caches;
+    if (pool->caches) {
+        pool->caches->prev = cache;
+    }
+    pool->caches = cache;
+    pthread_mutex_unlock(&pool->lock);
+    return cache;
+}
+
+/**
+ * @brief Creates a buffer pool.
+ *
+ * @param config Pool parameters, or NULL for the defaults.
+ * @param pool Pointer to store the created BufferPool.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError buffer_pool_create(const BufferPoolConfig* config, BufferPool** pool) {
+    if (pool == NULL) {
+        fprintf(stderr, "buffer_pool_create: Invalid arguments\n");
+        return SECURE_COMM_ERR_MEMORY;
+    }
+
+    BufferPoolConfig cfg;
+    if (config) {
+        cfg = *config;
+    } else {
+        buffer_pool_config_defaults(&cfg);
+    }
+
+    int min_shift = 0;
+    while (((size_t)1 << min_shift) < cfg.min_size) {
+        min_shift++;
+    }
+    int classes = 0;
+    while (classes < BUFFER_POOL_MAX_CLASSES && ((size_t)1 << (min_shift + classes)) < cfg.max_size) {
+        classes++;
+    }
+    classes++;
+    if (cfg.min_size == 0 || cfg.max_size < cfg.min_size || classes > BUFFER_POOL_MAX_CLASSES ||
+        cfg.slab_size == 0) {
+        fprintf(stderr, "buffer_pool_create: Invalid configuration\n");
+        return SECURE_COMM_ERR_MEMORY;
+    }
+
+    BufferPool* p = (BufferPool*)calloc(1, sizeof(BufferPool));
+    if (p == NULL) {
+        fprintf(stderr, "buffer_pool_create: Failed to allocate memory for pool\n");
+        return SECURE_COMM_ERR_MEMORY;
+    }
+    if (pthread_key_create(&p->cache_key, cache_destroy) != 0) {
+        fprintf(stderr, "buffer_pool_create: Failed to create the thread cache key\n");
+        free(p);
+        return SECURE_COMM_ERR_MEMORY;
+    }
+
+    p->config = cfg;
+    p->classes = classes;
+    p->min_shift = min_shift;
+    p->config.max_size = (size_t)1 << (min_shift + classes - 1);
+    for (int c = 0; c < classes; c++) {
+        // Large classes keep fewer buffers per thread: at most one slab's worth
+        size_t class_size = (size_t)1 << (min_shift + c);
+        size_t limit = cfg.slab_size / class_size;
+        p->cache_limit[c] = limit < cfg.thread_cache ? limit : cfg.thread_cache;
+        if (p->cache_limit[c] == 0 && cfg.thread_cache > 0) {
+            p->cache_limit[c] = 1;
+        }
+        pthread_mutex_init(&p->cls[c].lock, NULL);
+    }
+    pthread_mutex_init(&p->lock, NULL);
+
+    *pool = p;
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Sets the configuration of the library-wide pool before its first use.
+ *
+ * @param config Pool parameters.
+ *
+ * @return SECURE_COMM_SUCCESS, or SECURE_COMM_ERR_INIT if the default pool already exists.
+ */
+SecureCommError buffer_pool_configure_default(const BufferPoolConfig* config) {
+    if (config == NULL) {
+        fprintf(stderr, "buffer_pool_configure_default: Invalid arguments\n");
+        return SECURE_COMM_ERR_INIT;
+    }
+    pthread_mutex_lock(&default_config_lock);
+    if (default_pool_started) {
+        pthread_mutex_unlock(&default_config_lock);
+        fprintf(stderr, "buffer_pool_configure_default: The default pool is already in use\n");
+        return SECURE_COMM_ERR_INIT;
+    }
+    default_config = *config;
+    default_config_set = 1;
+    pthread_mutex_unlock(&default_config_lock);
+    return SECURE_COMM_SUCCESS;
+}
+
+static void default_pool_create(void) {
+    pthread_mutex_lock(&default_config_lock);
+    default_pool_started = 1;
+    if (buffer_pool_create(default_config_set ? &default_config : NULL, &default_pool) != SECURE_COMM_SUCCESS) {
+        default_pool = NULL;
+    }
+    pthread_mutex_unlock(&default_config_lock);
+}
+
+/**
+ * @brief Returns the library-wide pool, creating it on first use.
+ */
+BufferPool* buffer_pool_default(void) {
+    pthread_once(&default_pool_once, default_pool_create);
+    return default_pool;
+}
+
+/**
+ * @brief Allocates a slab for a class and links its buffers into a chain.
+ *
+ * @param count Pointer to store the number of buffers in the chain.
+ *
+ * @return The first buffer of the chain, or NULL if out of memory.
+ */
+static SecureBuffer* slab_carve(BufferPool* pool, int size_class, size_t* count) {
+    size_t class_size = (size_t)1 << (pool->min_shift + size_class);
+    size_t stride = BUFFER_HEADER_SIZE + class_size;
+    size_t buffers = pool->config.slab_size / stride;
+    if (buffers == 0) {
+        buffers = 1;
+    }
+
+    // The first cache line links the slab into pool->slabs
+    size_t bytes = BUFFER_ALIGN + buffers * stride;
+    void* slab = NULL;
+    if (posix_memalign(&slab, BUFFER_ALIGN, bytes) != 0) {
+        return NULL;
+    }
+    pthread_mutex_lock(&pool->lock);
+    *(void**)slab = pool->slabs;
+    pool->slabs = slab;
+    pthread_mutex_unlock(&pool->lock);
+    atomic_fetch_add_explicit(&pool->slab_count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&pool->slab_bytes, bytes, memory_order_relaxed);
+
+    SecureBuffer* head = NULL;
+    for (size_t i = buffers; i-- > 0;) {
+        SecureBuffer* buf = (SecureBuffer*)((unsigned char*)slab + BUFFER_ALIGN + i * stride);
+        buf->pool = pool;
+        buf->size_class = size_class;
+        buf->capacity = class_size;
+        buf->next = head;
+        head = buf;
+    }
+    *count = buffers;
+    return head;
+}
+
+/**
+ * @brief Refills a thread cache's class from the shared list, or from a new slab.
+ */
+static SecureCommError cache_refill(BufferPool* pool, thread_cache_t* cache, int c) {
+    size_t want = pool->cache_limit[c] / 2;
+    if (want == 0) {
+        want = 1;
+    }
+
+    size_class_t* cls = &pool->cls[c];
+    pthread_mutex_lock(&cls->lock);
+    if (cls->free != NULL) {
+        size_t moved = 0;
+        while (cls->free != NULL && moved < want) {
+            SecureBuffer* buf = cls->free;
+            cls->free = buf->next;
+            buf->next = cache->free[c];
+            cache->free[c] = buf;
+            moved++;
+        }
+        cls->count -= moved;
+        cache->count[c] += moved;
+        pthread_mutex_unlock(&cls->lock);
+        atomic_fetch_add_explicit(&pool->central_hits, 1, memory_order_relaxed);
+        return SECURE_COMM_SUCCESS;
+    }
+    pthread_mutex_unlock(&cls->lock);
+
+    size_t count = 0;
+    SecureBuffer* chain = slab_carve(pool, c, &count);
+    if (chain == NULL) {
+        fprintf(stderr, "buffer_pool_get: Failed to allocate a slab\n");
+        return SECURE_COMM_ERR_MEMORY;
+    }
+
+    // Keep what the cache holds and share the rest
+    size_t keep = 0;
+    while (chain != NULL && keep < want) {
+        SecureBuffer* buf = chain;
+        chain = buf->next;
+        buf->next = cache->free[c];
+        cache->free[c] = buf;
+        keep++;
+    }
+    cache->count[c] += keep;
+    if (chain != NULL) {
+        SecureBuffer* tail = chain;
+        while (tail->next != NULL) {
+            tail = tail->next;
+        }
+        pthread_mutex_lock(&cls->lock);
+        tail->next = cls->free;
+        cls->free = chain;
+        cls->count += count - keep;
+        pthread_mutex_unlock(&cls->lock);
+    }
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Takes a buffer of at least size bytes with one reference and length 0.
+ *
+ * @param pool The pool, or NULL for buffer_pool_default().
+ * @param size Bytes needed.
+ * @param buffer Pointer to store the buffer.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or SECURE_COMM_ERR_MEMORY on failure.
+ */
+SecureCommError buffer_pool_get(BufferPool* pool, size_t size, SecureBuffer** buffer) {
+    if (pool == NULL) {
+        pool = buffer_pool_default();
+    }
+    if (pool == NULL || buffer == NULL) {
+        fprintf(stderr, "buffer_pool_get: Invalid arguments\n");
+        return SECURE_COMM_ERR_MEMORY;
+    }
+
+    thread_cache_t* cache = cache_get(pool);
+    if (cache == NULL) {
+        fprintf(stderr, "buffer_pool_get: Failed to allocate the thread cache\n");
+        return SECURE_COMM_ERR_MEMORY;
+    }
+
+    SecureBuffer* buf;
+    if (size > pool->config.max_size) {
+        void* mem = NULL;
+        if (posix_memalign(&mem, BUFFER_ALIGN, BUFFER_HEADER_SIZE + size) != 0) {
+            fprintf(stderr, "buffer_pool_get: Failed to allocate %zu bytes\n", size);
+            return SECURE_COMM_ERR_MEMORY;
+        }
+        buf = (SecureBuffer*)mem;
+        buf->pool = pool;
+        buf->size_class = -1;
+        buf->capacity = size;
+        atomic_fetch_add_explicit(&pool->oversize, 1, memory_order_relaxed);
+    } else {
+        int c = 0;
+        while (((size_t)1 << (pool->min_shift + c)) < size) {
+            c++;
+        }
+        if (cache->free[c] != NULL) {
+            atomic_fetch_add_explicit(&cache->cache_hits, 1, memory_order_relaxed);
+        } else {
+            SecureCommError ret = cache_refill(pool, cache, c);
+            if (ret != SECURE_COMM_SUCCESS) {
+                return ret;
+            }
+        }
+        buf = cache->free[c];
+        cache->free[c] = buf->next;
+        cache->count[c]--;
+    }
+
+    buf->next = NULL;
+    buf->offset = 0;
+    buf->len = 0;
+    atomic_init(&buf->refs, 1);
+    atomic_fetch_add_explicit(&cache->gets, 1, memory_order_relaxed);
+    *buffer = buf;
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Adds a reference to a buffer.
+ */
+void secure_buffer_retain(SecureBuffer* buffer) {
+    if (buffer != NULL) {
+        atomic_fetch_add_explicit(&buffer->refs, 1, memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Drops a reference; the last one returns the buffer to the releasing thread's cache.
+ */
+void secure_buffer_release(SecureBuffer* buffer) {
+    if (buffer == NULL || atomic_fetch_sub_explicit(&buffer->refs, 1, memory_order_acq_rel) != 1) {
+        return;
+    }
+
+    BufferPool* pool = buffer->pool;
+    thread_cache_t* cache = cache_get(pool);
+    if (buffer->size_class < 0) {
+        free(buffer);
+    } else if (cache == NULL) {
+        // No cache for this thread: go straight to the shared list
+        size_class_t* cls = &pool->cls[buffer->size_class];
+        pthread_mutex_lock(&cls->lock);
+        buffer->next = cls->free;
+        cls->free = buffer;
+        cls->count++;
+        pthread_mutex_unlock(&cls->lock);
+    } else {
+        int c = buffer->size_class;
+        buffer->next = cache->free[c];
+        cache->free[c] = buffer;
+        cache->count[c]++;
+
+        // Over the limit: hand half of the class back so other threads can use it
+        if (cache->count[c] > pool->cache_limit[c]) {
+            size_t give = cache->count[c] - pool->cache_limit[c] / 2;
+            SecureBuffer* head = cache->free[c];
+            SecureBuffer* tail = head;
+            for (size_t i = 1; i < give; i++) {
+                tail = tail->next;
+            }
+            cache->free[c] = tail->next;
+            cache->count[c] -= give;
+
+            size_class_t* cls = &pool->cls[c];
+            pthread_mutex_lock(&cls->lock);
+            tail->next = cls->free;
+            cls->free = head;
+            cls->count += give;
+            pthread_mutex_unlock(&cls->lock);
+        }
+    }
+
+    if (cache != NULL) {
+        atomic_fetch_add_explicit(&cache->releases, 1, memory_order_relaxed);
+    } else {
+        pthread_mutex_lock(&pool->lock);
+        pool->releases++;
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+/**
+ * @brief Returns the first valid byte of a buffer.
+ */
+unsigned char* secure_buffer_data(const SecureBuffer* buffer) {
+    return (unsigned char*)buffer + BUFFER_HEADER_SIZE + buffer->offset;
+}
+
+/**
+ * @brief Returns the number of valid bytes.
+ */
+size_t secure_buffer_len(const SecureBuffer* buffer) {
+    return buffer->len;
+}
+
+/**
+ * @brief Returns how many bytes fit at secure_buffer_data.
+ */
+size_t secure_buffer_capacity(const SecureBuffer* buffer) {
+    return buffer->capacity - buffer->offset;
+}
+
+/**
+ * @brief Sets the number of valid bytes.
+ */
+SecureCommError secure_buffer_set_len(SecureBuffer* buffer, size_t len) {
+    if (len > buffer->capacity - buffer->offset) {
+        fprintf(stderr, "secure_buffer_set_len: %zu bytes exceed the capacity\n", len);
+        return SECURE_COMM_ERR_MEMORY;
+    }
+    buffer->len = len;
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Drops len bytes from the front of the valid range.
+ */
+SecureCommError secure_buffer_advance(SecureBuffer* buffer, size_t len) {
+    if (len > buffer->len) {
+        fprintf(stderr, "secure_buffer_advance: Only %zu bytes are valid\n", buffer->len);
+        return SECURE_COMM_ERR_MEMORY;
+    }
+    buffer->offset += len;
+    buffer->len -= len;
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Copies the pool counters.
+ *
+ * @param pool The pool, or NULL for buffer_pool_default().
+ * @param stats Pointer to store the counters.
+ */
+void buffer_pool_stats(BufferPool* pool, BufferPoolStats* stats) {
+    if (stats == NULL) {
+        return;
+    }
+    memset(stats, 0, sizeof(BufferPoolStats));
+    if (pool == NULL) {
+        pool = buffer_pool_default();
+    }
+    if (pool == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    uint64_t releases = pool->releases;
+    stats->gets = pool->gets;
+    stats->cache_hits = pool->cache_hits;
+    for (thread_cache_t* cache = pool->caches; cache != NULL; cache = cache->next) {
+        stats->gets += atomic_load_explicit(&cache->gets, memory_order_relaxed);
+        stats->cache_hits += atomic_load_explicit(&cache->cache_hits, memory_order_relaxed);
+        releases += atomic_load_explicit(&cache->releases, memory_order_relaxed);
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    stats->central_hits = atomic_load_explicit(&pool->central_hits, memory_order_relaxed);
+    stats->slabs = atomic_load_explicit(&pool->slab_count, memory_order_relaxed);
+    stats->slab_bytes = atomic_load_explicit(&pool->slab_bytes, memory_order_relaxed);
+    stats->oversize = atomic_load_explicit(&pool->oversize, memory_order_relaxed);
+    stats->outstanding = stats->gets > releases ? stats->gets - releases : 0;
+}
+
+/**
+ * @brief Destroys a pool, its thread caches and every slab.
+ */
+void buffer_pool_destroy(BufferPool* pool) {
+    if (pool == NULL) {
+        return;
+    }
+
+    // Thread caches of threads still alive are freed here; their destructor no longer runs
+    pthread_key_delete(pool->cache_key);
+    thread_cache_t* cache = pool->caches;
+    while (cache != NULL) {
+        thread_cache_t* next = cache->next;
+        free(cache);
+        cache = next;
+    }
+
+    void* slab = pool->slabs;
+    while (slab != NULL) {
+        void* next = *(void**)slab;
+        free(slab);
+        slab = next;
+    }
+
+    for (int c = 0; c < pool->classes; c++) {
+        pthread_mutex_destroy(&pool->cls[c].lock);
+    }
+    pthread_mutex_destroy(&pool->lock);
+    free(pool);
+}
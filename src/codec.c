@@ -0,0 +1,498 @@
+// codec.c
+
+#include "secure_comm.h"
+
+#include <stdio.h>      // For fprintf
+#include <stdlib.h>     // For malloc, realloc, free
+#include <string.h>     // For memcpy, strcmp
+#include <pthread.h>    // For the registry lock
+
+#include <zlib.h>       // For compressBound
+
+#ifdef SECURE_COMM_HAVE_LZ4
+extern const CompressionCodec secure_codec_lz4;
+#endif
+#ifdef SECURE_COMM_HAVE_ZSTD
+extern const CompressionCodec secure_codec_zstd;
+#endif
+
+// Registry indexed by CompressionCodecId
+static const CompressionCodec* registry[COMPRESSION_CODEC_MAX];
+static pthread_mutex_t registry_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t registry_once = PTHREAD_ONCE_INIT;
+
+// Preference order used by codec_negotiate
+static const CompressionCodecId negotiation_order[] = {
+    COMPRESSION_CODEC_ZSTD,
+    COMPRESSION_CODEC_LZ4,
+    COMPRESSION_CODEC_ZLIB
+};
+
+// ----- Stored (no compression) codec -----
+
+static size_t none_bound(size_t input_len) {
+    return input_len;
+}
+
+static SecureCommError none_compress(const unsigned char* input, size_t input_len,
+                                     unsigned char* output, size_t* output_len, int level) {
+    (void)level;
+    if (*output_len < input_len) {
+        return SECURE_COMM_ERR_MEMORY;
+    }
+    memcpy(output, input, input_len);
+    *output_len = input_len;
+    return SECURE_COMM_SUCCESS;
+}
+
+static SecureCommError none_decompress(const unsigned char* input, size_t input_len,
+                                       unsigned char* output, size_t* output_len) {
+    return none_compress(input, input_len, output, output_len, 0);
+}
+
+static const CompressionCodec codec_none = {
+    COMPRESSION_CODEC_NONE, "none", 0, 0, 0,
+    none_bound, none_compress, none_decompress
+};
+
+// ----- zlib codec, backed by the pooled streams in compression.c -----
+
+static size_t zlib_bound(size_t input_len) {
+    return compressBound((uLong)input_len);
+}
+
+static SecureCommError zlib_compress(const unsigned char* input, size_t input_len,
+                                     unsigned char* output, size_t* output_len, int level) {
+    return compress_data(input, input_len, output, output_len, level);
+}
+
+static SecureCommError zlib_decompress(const unsigned char* input, size_t input_len,
+                                       unsigned char* output, size_t* output_len) {
+    return decompress_data(input, input_len, output, output_len);
+}
+
+static const CompressionCodec codec_zlib = {
+    COMPRESSION_CODEC_ZLIB, "zlib", 0, 9, 6,
+    zlib_bound, zlib_compress, zlib_decompress
+};
+
+/**
+ * @brief Registers the codecs compiled into this build.
+ */
+static void register_builtin_codecs(void) {
+    registry[COMPRESSION_CODEC_NONE] = &codec_none;
+    registry[COMPRESSION_CODEC_ZLIB] = &codec_zlib;
+#ifdef SECURE_COMM_HAVE_LZ4
+    registry[COMPRESSION_CODEC_LZ4] = &secure_codec_lz4;
+#endif
+#ifdef SECURE_COMM_HAVE_ZSTD
+    registry[COMPRESSION_CODEC_ZSTD] = &secure_codec_zstd;
+#endif
+}
+
+/**
+ * @brief Registers a codec. Built-in codecs are registered automatically.
+ *
+ * @param codec Codec description (must stay valid for the life of the process).
+ *
+ * @return SECURE_COMM_SUCCESS on success, or SECURE_COMM_ERR_INIT if the id is invalid or taken.
+ */
+SecureCommError codec_register(const CompressionCodec* codec) {
+    if (codec == NULL || codec->id <= COMPRESSION_CODEC_NONE || codec->id >= COMPRESSION_CODEC_MAX ||
+        codec->name == NULL || codec->bound == NULL || codec->compress == NULL || codec->decompress == NULL) {
+        fprintf(stderr, "codec_register: Invalid codec\n");
+        return SECURE_COMM_ERR_INIT;
+    }
+
+    pthread_once(&registry_once, register_builtin_codecs);
+
+    pthread_mutex_lock(&registry_lock);
+    if (registry[codec->id] != NULL) {
+        pthread_mutex_unlock(&registry_lock);
+        fprintf(stderr, "codec_register: Codec id %d is already registered\n", codec->id);
+        return SECURE_COMM_ERR_INIT;
+    }
+    registry[codec->id] = codec;
+    pthread_mutex_unlock(&registry_lock);
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Looks up a codec by wire identifier.
+ *
+ * @return The codec, or NULL if it is not compiled in or registered.
+ */
+const CompressionCodec* codec_find(CompressionCodecId id) {
+    if (id < COMPRESSION_CODEC_NONE || id >= COMPRESSION_CODEC_MAX) {
+        return NULL;
+    }
+    pthread_once(&registry_once, register_builtin_codecs);
+
+    pthread_mutex_lock(&registry_lock);
+    const CompressionCodec* codec = registry[id];
+    pthread_mutex_unlock(&registry_lock);
+    return codec;
+}
+
+/**
+ * @brief Looks up a codec by name.
+ *
+ * @return The codec, or NULL if unknown.
+ */
+const CompressionCodec* codec_find_by_name(const char* name) {
+    if (name == NULL) {
+        return NULL;
+    }
+    for (int id = 0; id < COMPRESSION_CODEC_MAX; id++) {
+        const CompressionCodec* codec = codec_find((CompressionCodecId)id);
+        if (codec && strcmp(codec->name, name) == 0) {
+            return codec;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Returns a bitmask with bit N set for every available codec id N.
+ */
+uint32_t codec_supported_mask(void) {
+    uint32_t mask = 0;
+    for (int id = 0; id < COMPRESSION_CODEC_MAX; id++) {
+        if (codec_find((CompressionCodecId)id)) {
+            mask |= 1u << id;
+        }
+    }
+    return mask;
+}
+
+/**
+ * @brief Picks the preferred codec available on both sides.
+ *
+ * @param local_mask Mask from codec_supported_mask on this side.
+ * @param peer_mask Mask advertised by the peer.
+ *
+ * @return The chosen codec id, or COMPRESSION_CODEC_NONE if nothing is shared.
+ */
+CompressionCodecId codec_negotiate(uint32_t local_mask, uint32_t peer_mask) {
+    uint32_t shared = local_mask & peer_mask;
+    for (size_t i = 0; i < sizeof(negotiation_order) / sizeof(negotiation_order[0]); i++) {
+        if (shared & (1u << negotiation_order[i])) {
+            return negotiation_order[i];
+        }
+    }
+    return COMPRESSION_CODEC_NONE;
+}
+
+/**
+ * @brief Compresses with the given codec into a newly allocated buffer.
+ *
+ * @param id Codec to use.
+ * @param input Pointer to the data to compress.
+ * @param input_len Length of the input data in bytes.
+ * @param output_ptr Pointer to store the compressed buffer (caller frees).
+ * @param output_len Pointer to store the compressed length.
+ * @param level Codec-specific level, or -1 for the codec default.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError codec_compress_dynamic(CompressionCodecId id,
+                                       const unsigned char* input, size_t input_len,
+                                       unsigned char** output_ptr, size_t* output_len,
+                                       int level) {
+    if (input == NULL || output_ptr == NULL || output_len == NULL) {
+        fprintf(stderr, "codec_compress_dynamic: Invalid arguments\n");
+        return SECURE_COMM_ERR_COMPRESS;
+    }
+
+    const CompressionCodec* codec = codec_find(id);
+    if (codec == NULL) {
+        fprintf(stderr, "codec_compress_dynamic: Codec %d is not available\n", id);
+        return SECURE_COMM_ERR_COMPRESS;
+    }
+
+    if (level == -1) {
+        level = codec->default_level;
+    }
+    if (level < codec->min_level || level > codec->max_level) {
+        fprintf(stderr, "codec_compress_dynamic: Invalid %s level %d\n", codec->name, level);
+        return SECURE_COMM_ERR_COMPRESS;
+    }
+
+    size_t capacity = codec->bound(input_len);
+    unsigned char* compressed = (unsigned char*)malloc(capacity > 0 ? capacity : 1);
+    if (compressed == NULL) {
+        fprintf(stderr, "codec_compress_dynamic: Failed to allocate memory for compressed data.\n");
+        return SECURE_COMM_ERR_MEMORY;
+    }
+
+    size_t compressed_len = capacity;
+    SecureCommError ret = codec->compress(input, input_len, compressed, &compressed_len, level);
+    if (ret != SECURE_COMM_SUCCESS) {
+        free(compressed);
+        return ret;
+    }
+
+    *output_ptr = compressed;
+    *output_len = compressed_len;
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Size of the next decompression attempt after SECURE_COMM_ERR_MEMORY.
+ *
+ * Jumps straight to the size a codec reported in produced, and doubles otherwise.
+ */
+static size_t next_capacity(size_t capacity, size_t produced, size_t max_output) {
+    if (produced > capacity) {
+        return produced;
+    }
+    return capacity <= max_output / 2 ? capacity * 2 : max_output;
+}
+
+/**
+ * @brief Decompresses with the given codec into a newly allocated buffer.
+ *
+ * zlib goes through decompress_data_dynamic_ex. Other codecs decode into a buffer that
+ * starts at size_hint (or four times the input) and doubles on each SECURE_COMM_ERR_MEMORY
+ * until max_output is reached.
+ *
+ * @param id Codec the data was compressed with.
+ * @param input Pointer to the compressed data.
+ * @param input_len Length of the compressed data.
+ * @param size_hint Expected decompressed length, or 0 if unknown.
+ * @param max_output Largest decompressed size accepted, or 0 for the default limit.
+ * @param output_ptr Pointer to store the decompressed buffer (caller frees).
+ * @param output_len Pointer to store the decompressed length.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError codec_decompress_dynamic(CompressionCodecId id,
+                                         const unsigned char* input, size_t input_len,
+                                         size_t size_hint, size_t max_output,
+                                         unsigned char** output_ptr, size_t* output_len) {
+    if (input == NULL || output_ptr == NULL || output_len == NULL) {
+        fprintf(stderr, "codec_decompress_dynamic: Invalid arguments\n");
+        return SECURE_COMM_ERR_DECOMPRESS;
+    }
+
+    if (id == COMPRESSION_CODEC_ZLIB) {
+        return decompress_data_dynamic_ex(input, input_len, size_hint, max_output, output_ptr, output_len);
+    }
+
+    const CompressionCodec* codec = codec_find(id);
+    if (codec == NULL) {
+        fprintf(stderr, "codec_decompress_dynamic: Codec %d is not available\n", id);
+        return SECURE_COMM_ERR_DECOMPRESS;
+    }
+
+    if (max_output == 0) {
+        max_output = SECURE_DECOMPRESS_DEFAULT_MAX_OUTPUT;
+    }
+    if (size_hint > max_output) {
+        fprintf(stderr, "codec_decompress_dynamic: Size hint %zu exceeds limit %zu\n", size_hint, max_output);
+        return SECURE_COMM_ERR_DECOMPRESS;
+    }
+
+    size_t capacity = size_hint;
+    if (capacity == 0) {
+        capacity = input_len <= max_output / 4 ? input_len * 4 : max_output;
+        if (capacity < 4096) {
+            capacity = max_output < 4096 ? max_output : 4096;
+        }
+    }
+
+    unsigned char* output = NULL;
+    for (;;) {
+        unsigned char* grown = (unsigned char*)realloc(output, capacity);
+        if (grown == NULL) {
+            fprintf(stderr, "codec_decompress_dynamic: Failed to allocate memory for decompressed data.\n");
+            free(output);
+            return SECURE_COMM_ERR_MEMORY;
+        }
+        output = grown;
+
+        size_t produced = capacity;
+        SecureCommError ret = codec->decompress(input, input_len, output, &produced);
+        if (ret == SECURE_COMM_SUCCESS) {
+            *output_ptr = output;
+            *output_len = produced;
+            return SECURE_COMM_SUCCESS;
+        }
+        if (ret != SECURE_COMM_ERR_MEMORY || capacity >= max_output || produced > max_output) {
+            if (ret == SECURE_COMM_ERR_MEMORY) {
+                fprintf(stderr, "codec_decompress_dynamic: Decompressed size exceeds limit %zu\n", max_output);
+            }
+            free(output);
+            return SECURE_COMM_ERR_DECOMPRESS;
+        }
+        capacity = next_capacity(capacity, produced, max_output);
+    }
+}
+
+/**
+ * @brief Compresses with the given codec into a buffer taken from a pool.
+ *
+ * @param id Codec to use.
+ * @param pool Pool to take the output from, or NULL for the default pool.
+ * @param input Pointer to the data to compress.
+ * @param input_len Length of the input data in bytes.
+ * @param level Codec-specific level, or -1 for the codec default.
+ * @param output Pointer to store the compressed buffer (one reference, owned by the caller).
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError codec_compress_pooled(CompressionCodecId id, BufferPool* pool,
+                                      const unsigned char* input, size_t input_len,
+                                      int level, SecureBuffer** output) {
+    if (input == NULL || output == NULL) {
+        fprintf(stderr, "codec_compress_pooled: Invalid arguments\n");
+        return SECURE_COMM_ERR_COMPRESS;
+    }
+
+    const CompressionCodec* codec = codec_find(id);
+    if (codec == NULL) {
+        fprintf(stderr, "codec_compress_pooled: Codec %d is not available\n", id);
+        return SECURE_COMM_ERR_COMPRESS;
+    }
+
+    if (level == -1) {
+        level = codec->default_level;
+    }
+    if (level < codec->min_level || level > codec->max_level) {
+        fprintf(stderr, "codec_compress_pooled: Invalid %s level %d\n", codec->name, level);
+        return SECURE_COMM_ERR_COMPRESS;
+    }
+
+    SecureBuffer* buffer = NULL;
+    SecureCommError ret = buffer_pool_get(pool, codec->bound(input_len), &buffer);
+    if (ret != SECURE_COMM_SUCCESS) {
+        return ret;
+    }
+
+    size_t compressed_len = secure_buffer_capacity(buffer);
+    ret = codec->compress(input, input_len, secure_buffer_data(buffer), &compressed_len, level);
+    if (ret != SECURE_COMM_SUCCESS) {
+        secure_buffer_release(buffer);
+        return ret;
+    }
+    secure_buffer_set_len(buffer, compressed_len);
+    *output = buffer;
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Decompresses with the given codec into a buffer taken from a pool.
+ *
+ * zlib goes through decompress_data_pooled. Other codecs retry with a buffer of the
+ * size they report, or of the next size class, on each SECURE_COMM_ERR_MEMORY until
+ * max_output is reached.
+ *
+ * @param id Codec the data was compressed with.
+ * @param pool Pool to take the output from, or NULL for the default pool.
+ * @param input Pointer to the compressed data.
+ * @param input_len Length of the compressed data.
+ * @param size_hint Expected decompressed length, or 0 if unknown.
+ * @param max_output Largest decompressed size accepted, or 0 for the default limit.
+ * @param output Pointer to store the decompressed buffer (one reference, owned by the caller).
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError codec_decompress_pooled(CompressionCodecId id, BufferPool* pool,
+                                        const unsigned char* input, size_t input_len,
+                                        size_t size_hint, size_t max_output, SecureBuffer** output) {
+    if (input == NULL || output == NULL) {
+        fprintf(stderr, "codec_decompress_pooled: Invalid arguments\n");
+        return SECURE_COMM_ERR_DECOMPRESS;
+    }
+
+    if (id == COMPRESSION_CODEC_ZLIB) {
+        return decompress_data_pooled(pool, input, input_len, size_hint, max_output, output);
+    }
+
+    const CompressionCodec* codec = codec_find(id);
+    if (codec == NULL) {
+        fprintf(stderr, "codec_decompress_pooled: Codec %d is not available\n", id);
+        return SECURE_COMM_ERR_DECOMPRESS;
+    }
+
+    if (max_output == 0) {
+        max_output = SECURE_DECOMPRESS_DEFAULT_MAX_OUTPUT;
+    }
+    if (size_hint > max_output) {
+        fprintf(stderr, "codec_decompress_pooled: Size hint %zu exceeds limit %zu\n", size_hint, max_output);
+        return SECURE_COMM_ERR_DECOMPRESS;
+    }
+
+    size_t capacity = size_hint;
+    if (capacity == 0) {
+        capacity = input_len <= max_output / 4 ? input_len * 4 : max_output;
+        if (capacity < 4096) {
+            capacity = max_output < 4096 ? max_output : 4096;
+        }
+    }
+
+    for (;;) {
+        SecureBuffer* buffer = NULL;
+        SecureCommError ret = buffer_pool_get(pool, capacity, &buffer);
+        if (ret != SECURE_COMM_SUCCESS) {
+            return ret;
+        }
+
+        // Use the whole size class, but never more than the limit
+        capacity = secure_buffer_capacity(buffer) < max_output ? secure_buffer_capacity(buffer) : max_output;
+        size_t produced = capacity;
+        ret = codec->decompress(input, input_len, secure_buffer_data(buffer), &produced);
+        if (ret == SECURE_COMM_SUCCESS) {
+            secure_buffer_set_len(buffer, produced);
+            *output = buffer;
+            return SECURE_COMM_SUCCESS;
+        }
+        secure_buffer_release(buffer);
+        if (ret != SECURE_COMM_ERR_MEMORY || capacity >= max_output || produced > max_output) {
+            if (ret == SECURE_COMM_ERR_MEMORY) {
+                fprintf(stderr, "codec_decompress_pooled: Decompressed size exceeds limit %zu\n", max_output);
+            }
+            return SECURE_COMM_ERR_DECOMPRESS;
+        }
+        capacity = next_capacity(capacity, produced, max_output);
+    }
+}
+
+/**
+ * @brief Decompresses with the given codec into a caller-provided buffer.
+ *
+ * @param id Codec the data was compressed with.
+ * @param input Pointer to the compressed data.
+ * @param input_len Length of the compressed data.
+ * @param output Buffer for the decompressed data.
+ * @param output_len In: size of output. Out: decompressed length.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError codec_decompress(CompressionCodecId id,
+                                 const unsigned char* input, size_t input_len,
+                                 unsigned char* output, size_t* output_len) {
+    if (input == NULL || output == NULL || output_len == NULL) {
+        fprintf(stderr, "codec_decompress: Invalid arguments\n");
+        return SECURE_COMM_ERR_DECOMPRESS;
+    }
+
+    const CompressionCodec* codec = codec_find(id);
+    if (codec == NULL) {
+        fprintf(stderr, "codec_decompress: Codec %d is not available\n", id);
+        return SECURE_COMM_ERR_DECOMPRESS;
+    }
+    return codec->decompress(input, input_len, output, output_len);
+}
+
+#ifndef SECURE_COMM_HAVE_ZSTD
+/**
+ * @brief Zstd dictionaries need the Zstd codec; report that it is missing.
+ */
+SecureCommError codec_zstd_set_dictionary(const void* dict, size_t dict_len) {
+    (void)dict;
+    (void)dict_len;
+    fprintf(stderr, "codec_zstd_set_dictionary: Built without SECURE_COMM_WITH_ZSTD\n");
+    return SECURE_COMM_ERR_INIT;
+}
+#endif
@@ -0,0 +1,108 @@
+// codec_lz4.c
+
+#include "secure_comm.h"
+
+#include <stdio.h>      // For fprintf
+#include <stdint.h>     // For uint32_t
+#include <limits.h>     // For INT_MAX
+
+#include <lz4.h>        // For the LZ4 block API
+#include <lz4hc.h>      // For the high-compression levels
+
+// Payload: original length (4 bytes, big-endian) || LZ4 block. The block format does
+// not carry the length itself, so without it the receiver could only guess a size.
+#define LZ4_LENGTH_PREFIX 4
+
+// An LZ4 block never expands by more than this factor
+#define LZ4_MAX_RATIO 255
+
+/**
+ * @brief Worst-case LZ4 output size for input_len bytes.
+ */
+static size_t lz4_bound(size_t input_len) {
+    if (input_len > LZ4_MAX_INPUT_SIZE) {
+        return 0;
+    }
+    return LZ4_LENGTH_PREFIX + (size_t)LZ4_compressBound((int)input_len);
+}
+
+/**
+ * @brief Compresses with LZ4. Level 1 is the fast compressor, 2-12 use LZ4HC.
+ */
+static SecureCommError lz4_compress(const unsigned char* input, size_t input_len,
+                                    unsigned char* output, size_t* output_len, int level) {
+    if (input_len > LZ4_MAX_INPUT_SIZE) {
+        fprintf(stderr, "lz4_compress: Input of %zu bytes is too large\n", input_len);
+        return SECURE_COMM_ERR_COMPRESS;
+    }
+
+    if (*output_len <= LZ4_LENGTH_PREFIX) {
+        fprintf(stderr, "lz4_compress: Output buffer is too small\n");
+        return SECURE_COMM_ERR_COMPRESS;
+    }
+
+    size_t block_capacity = *output_len - LZ4_LENGTH_PREFIX;
+    int capacity = block_capacity > INT_MAX ? INT_MAX : (int)block_capacity;
+    char* block = (char*)output + LZ4_LENGTH_PREFIX;
+    int written;
+    if (level <= 1) {
+        written = LZ4_compress_default((const char*)input, block, (int)input_len, capacity);
+    } else {
+        written = LZ4_compress_HC((const char*)input, block, (int)input_len, capacity, level);
+    }
+    if (written <= 0) {
+        fprintf(stderr, "lz4_compress: Compression failed\n");
+        return SECURE_COMM_ERR_COMPRESS;
+    }
+
+    uint32_t original = (uint32_t)input_len;
+    output[0] = (unsigned char)(original >> 24);
+    output[1] = (unsigned char)(original >> 16);
+    output[2] = (unsigned char)(original >> 8);
+    output[3] = (unsigned char)original;
+    *output_len = LZ4_LENGTH_PREFIX + (size_t)written;
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Decompresses a length-prefixed LZ4 block in a single pass.
+ *
+ * A buffer smaller than the recorded length fails with SECURE_COMM_ERR_MEMORY and
+ * *output_len set to the length needed, so the caller can retry once at the right
+ * size. Every other failure means corrupt input.
+ */
+static SecureCommError lz4_decompress(const unsigned char* input, size_t input_len,
+                                      unsigned char* output, size_t* output_len) {
+    if (input_len < LZ4_LENGTH_PREFIX ||
+        input_len - LZ4_LENGTH_PREFIX > (size_t)LZ4_compressBound(LZ4_MAX_INPUT_SIZE)) {
+        fprintf(stderr, "lz4_decompress: Invalid input of %zu bytes\n", input_len);
+        return SECURE_COMM_ERR_DECOMPRESS;
+    }
+
+    size_t block_len = input_len - LZ4_LENGTH_PREFIX;
+    size_t original = ((size_t)input[0] << 24) | ((size_t)input[1] << 16) | ((size_t)input[2] << 8) | input[3];
+    if (original > LZ4_MAX_INPUT_SIZE || original > block_len * LZ4_MAX_RATIO) {
+        fprintf(stderr, "lz4_decompress: Recorded length %zu does not match a %zu byte block\n",
+                original, block_len);
+        return SECURE_COMM_ERR_DECOMPRESS;
+    }
+    if (original > *output_len) {
+        *output_len = original;
+        return SECURE_COMM_ERR_MEMORY;
+    }
+
+    int produced = LZ4_decompress_safe((const char*)input + LZ4_LENGTH_PREFIX, (char*)output,
+                                       (int)block_len, (int)original);
+    if (produced < 0 || (size_t)produced != original) {
+        fprintf(stderr, "lz4_decompress: Corrupt LZ4 block\n");
+        return SECURE_COMM_ERR_DECOMPRESS;
+    }
+
+    *output_len = original;
+    return SECURE_COMM_SUCCESS;
+}
+
+const CompressionCodec secure_codec_lz4 = {
+    COMPRESSION_CODEC_LZ4, "lz4", 1, LZ4HC_CLEVEL_MAX, 1,
+    lz4_bound, lz4_compress, lz4_decompress
+};
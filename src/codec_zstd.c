@@ -0,0 +1,219 @@
+// codec_zstd.c
+
+#include "secure_comm.h"
+
+#include <stdio.h>      // For fprintf
+#include <stdlib.h>     // For malloc, calloc, free
+#include <string.h>     // For memcpy
+#include <stdint.h>     // For SIZE_MAX
+#include <pthread.h>    // For per-thread contexts and the dictionary lock
+
+#include <zstd.h>           // For the Zstandard API
+#include <zstd_errors.h>    // For ZSTD_error_dstSize_tooSmall
+
+// Levels 1..ZSTD_LEVELS-1 can each have a digested dictionary
+#define ZSTD_LEVELS 23
+
+// Per-thread compression and decompression contexts, reused across calls
+typedef struct {
+    ZSTD_CCtx* cctx;
+    ZSTD_DCtx* dctx;
+} zstd_contexts_t;
+
+static pthread_key_t contexts_key;
+static pthread_once_t contexts_once = PTHREAD_ONCE_INIT;
+static int contexts_key_ok = 0;
+
+// Trained dictionary shared by all threads, swapped under the write lock
+static pthread_rwlock_t dict_lock = PTHREAD_RWLOCK_INITIALIZER;
+static ZSTD_CDict* cdicts[ZSTD_LEVELS];
+static ZSTD_DDict* ddict = NULL;
+static void* dict_data = NULL;
+static size_t dict_size = 0;
+
+static void contexts_free(void* ptr) {
+    zstd_contexts_t* contexts = (zstd_contexts_t*)ptr;
+    ZSTD_freeCCtx(contexts->cctx);
+    ZSTD_freeDCtx(contexts->dctx);
+    free(contexts);
+}
+
+static void contexts_make_key(void) {
+    contexts_key_ok = (pthread_key_create(&contexts_key, contexts_free) == 0);
+}
+
+/**
+ * @brief Returns the calling thread's Zstd contexts, creating them on first use.
+ */
+static zstd_contexts_t* contexts_get(void) {
+    pthread_once(&contexts_once, contexts_make_key);
+    if (!contexts_key_ok) {
+        return NULL;
+    }
+
+    zstd_contexts_t* contexts = (zstd_contexts_t*)pthread_getspecific(contexts_key);
+    if (contexts == NULL) {
+        contexts = (zstd_contexts_t*)calloc(1, sizeof(zstd_contexts_t));
+        if (contexts == NULL) {
+            return NULL;
+        }
+        contexts->cctx = ZSTD_createCCtx();
+        contexts->dctx = ZSTD_createDCtx();
+        if (contexts->cctx == NULL || contexts->dctx == NULL || pthread_setspecific(contexts_key, contexts) != 0) {
+            contexts_free(contexts);
+            return NULL;
+        }
+    }
+    return contexts;
+}
+
+/**
+ * @brief Drops the current dictionary. Caller holds the write lock.
+ */
+static void dictionary_clear(void) {
+    for (int level = 0; level < ZSTD_LEVELS; level++) {
+        ZSTD_freeCDict(cdicts[level]);
+        cdicts[level] = NULL;
+    }
+    ZSTD_freeDDict(ddict);
+    ddict = NULL;
+    free(dict_data);
+    dict_data = NULL;
+    dict_size = 0;
+}
+
+/**
+ * @brief Returns the digested dictionary for a level, building it on first use.
+ *
+ * Caller holds the read lock; building takes the write lock briefly.
+ */
+static ZSTD_CDict* dictionary_for_level(int level) {
+    ZSTD_CDict* cdict = cdicts[level];
+    if (cdict != NULL || dict_data == NULL) {
+        return cdict;
+    }
+
+    pthread_rwlock_unlock(&dict_lock);
+    pthread_rwlock_wrlock(&dict_lock);
+    if (cdicts[level] == NULL && dict_data != NULL) {
+        cdicts[level] = ZSTD_createCDict(dict_data, dict_size, level);
+    }
+    pthread_rwlock_unlock(&dict_lock);
+    pthread_rwlock_rdlock(&dict_lock);
+    return cdicts[level];
+}
+
+/**
+ * @brief Loads a trained Zstd dictionary used by every later Zstd call.
+ *
+ * @param dict Dictionary produced by `zstd --train`, or NULL to clear it.
+ * @param dict_len Dictionary length.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError codec_zstd_set_dictionary(const void* dict, size_t dict_len) {
+    pthread_rwlock_wrlock(&dict_lock);
+    dictionary_clear();
+
+    if (dict == NULL || dict_len == 0) {
+        pthread_rwlock_unlock(&dict_lock);
+        return SECURE_COMM_SUCCESS;
+    }
+
+    dict_data = malloc(dict_len);
+    if (dict_data == NULL) {
+        pthread_rwlock_unlock(&dict_lock);
+        fprintf(stderr, "codec_zstd_set_dictionary: Failed to allocate dictionary\n");
+        return SECURE_COMM_ERR_MEMORY;
+    }
+    memcpy(dict_data, dict, dict_len);
+    dict_size = dict_len;
+
+    ddict = ZSTD_createDDict(dict_data, dict_size);
+    if (ddict == NULL) {
+        dictionary_clear();
+        pthread_rwlock_unlock(&dict_lock);
+        fprintf(stderr, "codec_zstd_set_dictionary: Invalid dictionary\n");
+        return SECURE_COMM_ERR_INIT;
+    }
+
+    pthread_rwlock_unlock(&dict_lock);
+    return SECURE_COMM_SUCCESS;
+}
+
+static size_t zstd_bound(size_t input_len) {
+    return ZSTD_compressBound(input_len);
+}
+
+static SecureCommError zstd_compress(const unsigned char* input, size_t input_len,
+                                     unsigned char* output, size_t* output_len, int level) {
+    zstd_contexts_t* contexts = contexts_get();
+    if (contexts == NULL) {
+        fprintf(stderr, "zstd_compress: Failed to acquire compression context\n");
+        return SECURE_COMM_ERR_MEMORY;
+    }
+
+    pthread_rwlock_rdlock(&dict_lock);
+    ZSTD_CDict* cdict = dictionary_for_level(level);
+    size_t written = cdict
+        ? ZSTD_compress_usingCDict(contexts->cctx, output, *output_len, input, input_len, cdict)
+        : ZSTD_compressCCtx(contexts->cctx, output, *output_len, input, input_len, level);
+    pthread_rwlock_unlock(&dict_lock);
+
+    if (ZSTD_isError(written)) {
+        fprintf(stderr, "zstd_compress: %s\n", ZSTD_getErrorName(written));
+        return SECURE_COMM_ERR_COMPRESS;
+    }
+
+    *output_len = written;
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Decompresses one Zstd frame.
+ *
+ * Frames record their content size, so a buffer smaller than that fails with
+ * SECURE_COMM_ERR_MEMORY and *output_len set to the size needed before anything is
+ * decoded, and the caller can retry once at the right size. Only frames without a
+ * recorded size fall back to SECURE_COMM_ERR_MEMORY alone.
+ */
+static SecureCommError zstd_decompress(const unsigned char* input, size_t input_len,
+                                       unsigned char* output, size_t* output_len) {
+    unsigned long long content_size = ZSTD_getFrameContentSize(input, input_len);
+    if (content_size == ZSTD_CONTENTSIZE_ERROR) {
+        fprintf(stderr, "zstd_decompress: Invalid Zstd frame\n");
+        return SECURE_COMM_ERR_DECOMPRESS;
+    }
+    if (content_size != ZSTD_CONTENTSIZE_UNKNOWN && content_size > *output_len) {
+        *output_len = content_size > SIZE_MAX ? SIZE_MAX : (size_t)content_size;
+        return SECURE_COMM_ERR_MEMORY;
+    }
+
+    zstd_contexts_t* contexts = contexts_get();
+    if (contexts == NULL) {
+        fprintf(stderr, "zstd_decompress: Failed to acquire decompression context\n");
+        return SECURE_COMM_ERR_MEMORY;
+    }
+
+    pthread_rwlock_rdlock(&dict_lock);
+    size_t produced = ddict
+        ? ZSTD_decompress_usingDDict(contexts->dctx, output, *output_len, input, input_len, ddict)
+        : ZSTD_decompressDCtx(contexts->dctx, output, *output_len, input, input_len);
+    pthread_rwlock_unlock(&dict_lock);
+
+    if (ZSTD_isError(produced)) {
+        if (ZSTD_getErrorCode(produced) == ZSTD_error_dstSize_tooSmall) {
+            return SECURE_COMM_ERR_MEMORY;
+        }
+        fprintf(stderr, "zstd_decompress: %s\n", ZSTD_getErrorName(produced));
+        return SECURE_COMM_ERR_DECOMPRESS;
+    }
+
+    *output_len = produced;
+    return SECURE_COMM_SUCCESS;
+}
+
+const CompressionCodec secure_codec_zstd = {
+    COMPRESSION_CODEC_ZSTD, "zstd", 1, 19, 3,
+    zstd_bound, zstd_compress, zstd_decompress
+};
@@ -5,26 +5,254 @@
 #include <stdio.h>      // For fprintf
 #include <stdlib.h>     // For malloc, free
 #include <string.h>     // For memset
+#include <pthread.h>    // For per-thread stream pools
+#include <stdatomic.h>  // For the allocation counters
 
 #include <zlib.h>       // For compression functions
 
+// Number of deflate levels (0-9), each with its own pooled stream
+#define ZSTREAM_POOL_LEVELS 10
+
 /**
- * @brief Compresses data using zlib (deflate) with pre-allocated buffer.
- *
- * This function compresses the input data using the deflate algorithm provided by zlib.
- * The caller must provide a buffer that is large enough to hold the compressed data.
+ * @brief Per-thread set of reusable zlib streams.
  *
- * @param input Pointer to the data to compress.
- * @param input_len Length of the input data in bytes.
- * @param compressed Pointer to the buffer where compressed data will be stored.
- * @param compressed_len Pointer to store the length of the compressed data.
- * @param level Compression level (0-9). 0 = no compression, 9 = maximum compression.
+ * Initializing a z_stream allocates a few hundred KB of internal state. Keeping one
+ * stream per level, reset with deflateReset/inflateReset between calls, makes that a
+ * one-off cost per thread instead of a per-message one.
+ */
+typedef struct {
+    z_stream deflaters[ZSTREAM_POOL_LEVELS];
+    int deflater_ready[ZSTREAM_POOL_LEVELS];
+    z_stream inflater;
+    int inflater_ready;
+    z_stream raw_deflaters[ZSTREAM_POOL_LEVELS];   // Headerless streams for parallel blocks
+    int raw_deflater_ready[ZSTREAM_POOL_LEVELS];
+    z_stream raw_inflater;
+    int raw_inflater_ready;
+} zstream_pool_t;
+
+static pthread_key_t pool_key;
+static pthread_once_t pool_once = PTHREAD_ONCE_INIT;
+static int pool_key_ok = 0;
+
+// Process-wide counters reported by compression_get_stats
+static _Atomic uint64_t stat_stream_inits = 0;
+static _Atomic uint64_t stat_stream_reuses = 0;
+static _Atomic uint64_t stat_zlib_allocs = 0;
+static _Atomic uint64_t stat_zlib_alloc_bytes = 0;
+
+/**
+ * @brief zlib allocator that counts internal allocations.
+ */
+static voidpf counting_alloc(voidpf opaque, uInt items, uInt size) {
+    (void)opaque;
+    atomic_fetch_add_explicit(&stat_zlib_allocs, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&stat_zlib_alloc_bytes, (uint64_t)items * size, memory_order_relaxed);
+    return malloc((size_t)items * size);
+}
+
+static void counting_free(voidpf opaque, voidpf address) {
+    (void)opaque;
+    free(address);
+}
+
+/**
+ * @brief Thread-exit destructor: ends every stream the thread created.
+ */
+static void pool_free(void* ptr) {
+    zstream_pool_t* pool = (zstream_pool_t*)ptr;
+    for (int level = 0; level < ZSTREAM_POOL_LEVELS; level++) {
+        if (pool->deflater_ready[level]) {
+            deflateEnd(&pool->deflaters[level]);
+        }
+        if (pool->raw_deflater_ready[level]) {
+            deflateEnd(&pool->raw_deflaters[level]);
+        }
+    }
+    if (pool->inflater_ready) {
+        inflateEnd(&pool->inflater);
+    }
+    if (pool->raw_inflater_ready) {
+        inflateEnd(&pool->raw_inflater);
+    }
+    free(pool);
+}
+
+static void pool_make_key(void) {
+    pool_key_ok = (pthread_key_create(&pool_key, pool_free) == 0);
+}
+
+/**
+ * @brief Returns the calling thread's pool, creating it on first use.
+ */
+static zstream_pool_t* pool_get(void) {
+    pthread_once(&pool_once, pool_make_key);
+    if (!pool_key_ok) {
+        return NULL;
+    }
+
+    zstream_pool_t* pool = (zstream_pool_t*)pthread_getspecific(pool_key);
+    if (pool == NULL) {
+        pool = (zstream_pool_t*)calloc(1, sizeof(zstream_pool_t));
+        if (pool == NULL) {
+            return NULL;
+        }
+        if (pthread_setspecific(pool_key, pool) != 0) {
+            free(pool);
+            return NULL;
+        }
+    }
+    return pool;
+}
+
+/**
+ * @brief Borrows the thread's deflate stream for a level. Return it with release_deflater.
+ */
+static z_stream* acquire_deflater(int level) {
+    zstream_pool_t* pool = pool_get();
+    if (pool == NULL) {
+        return NULL;
+    }
+
+    z_stream* strm = &pool->deflaters[level];
+    if (pool->deflater_ready[level]) {
+        atomic_fetch_add_explicit(&stat_stream_reuses, 1, memory_order_relaxed);
+        return strm;
+    }
+
+    memset(strm, 0, sizeof(*strm));
+    strm->zalloc = counting_alloc;
+    strm->zfree = counting_free;
+    if (deflateInit(strm, level) != Z_OK) {
+        return NULL;
+    }
+    pool->deflater_ready[level] = 1;
+    atomic_fetch_add_explicit(&stat_stream_inits, 1, memory_order_relaxed);
+    return strm;
+}
+
+static void release_deflater(z_stream* strm) {
+    deflateReset(strm);
+}
+
+/**
+ * @brief Borrows the thread's inflate stream. Return it with release_inflater.
+ */
+static z_stream* acquire_inflater(void) {
+    zstream_pool_t* pool = pool_get();
+    if (pool == NULL) {
+        return NULL;
+    }
+
+    z_stream* strm = &pool->inflater;
+    if (pool->inflater_ready) {
+        atomic_fetch_add_explicit(&stat_stream_reuses, 1, memory_order_relaxed);
+        return strm;
+    }
+
+    memset(strm, 0, sizeof(*strm));
+    strm->zalloc = counting_alloc;
+    strm->zfree = counting_free;
+    if (inflateInit(strm) != Z_OK) {
+        return NULL;
+    }
+    pool->inflater_ready = 1;
+    atomic_fetch_add_explicit(&stat_stream_inits, 1, memory_order_relaxed);
+    return strm;
+}
+
+static void release_inflater(z_stream* strm) {
+    inflateReset(strm);
+}
+
+/**
+ * @brief Borrows the thread's raw (headerless) deflate stream for a level.
+ */
+static z_stream* acquire_raw_deflater(int level) {
+    zstream_pool_t* pool = pool_get();
+    if (pool == NULL) {
+        return NULL;
+    }
+
+    z_stream* strm = &pool->raw_deflaters[level];
+    if (pool->raw_deflater_ready[level]) {
+        atomic_fetch_add_explicit(&stat_stream_reuses, 1, memory_order_relaxed);
+        return strm;
+    }
+
+    memset(strm, 0, sizeof(*strm));
+    strm->zalloc = counting_alloc;
+    strm->zfree = counting_free;
+    if (deflateInit2(strm, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return NULL;
+    }
+    pool->raw_deflater_ready[level] = 1;
+    atomic_fetch_add_explicit(&stat_stream_inits, 1, memory_order_relaxed);
+    return strm;
+}
+
+/**
+ * @brief Borrows the thread's raw (headerless) inflate stream.
+ */
+static z_stream* acquire_raw_inflater(void) {
+    zstream_pool_t* pool = pool_get();
+    if (pool == NULL) {
+        return NULL;
+    }
+
+    z_stream* strm = &pool->raw_inflater;
+    if (pool->raw_inflater_ready) {
+        atomic_fetch_add_explicit(&stat_stream_reuses, 1, memory_order_relaxed);
+        return strm;
+    }
+
+    memset(strm, 0, sizeof(*strm));
+    strm->zalloc = counting_alloc;
+    strm->zfree = counting_free;
+    if (inflateInit2(strm, -MAX_WBITS) != Z_OK) {
+        return NULL;
+    }
+    pool->raw_inflater_ready = 1;
+    atomic_fetch_add_explicit(&stat_stream_inits, 1, memory_order_relaxed);
+    return strm;
+}
+
+/**
+ * @brief Reports how often zlib streams were created, reused and how much zlib allocated.
  *
- * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ * @param stats Pointer to store the counters.
  */
-SecureCommError compress_data(const unsigned char* input, size_t input_len,
-                              unsigned char* compressed, size_t* compressed_len,
-                              int level) {
+void compression_get_stats(CompressionStats* stats) {
+    if (stats == NULL) {
+        return;
+    }
+    stats->stream_inits = atomic_load_explicit(&stat_stream_inits, memory_order_relaxed);
+    stats->stream_reuses = atomic_load_explicit(&stat_stream_reuses, memory_order_relaxed);
+    stats->zlib_allocs = atomic_load_explicit(&stat_zlib_allocs, memory_order_relaxed);
+    stats->zlib_alloc_bytes = atomic_load_explicit(&stat_zlib_alloc_bytes, memory_order_relaxed);
+}
+
+/**
+ * @brief Frees the calling thread's pooled streams now instead of at thread exit.
+ */
+void compression_release_thread_pool(void) {
+    pthread_once(&pool_once, pool_make_key);
+    if (!pool_key_ok) {
+        return;
+    }
+    zstream_pool_t* pool = (zstream_pool_t*)pthread_getspecific(pool_key);
+    if (pool != NULL) {
+        pthread_setspecific(pool_key, NULL);
+        pool_free(pool);
+    }
+}
+
+/**
+ * @brief Body of compress_data, without the metrics.
+ */
+static SecureCommError compress_data_unmetered(const unsigned char* input, size_t input_len,
+                                               unsigned char* compressed, size_t* compressed_len,
+                                               int level) {
     if (input == NULL || compressed == NULL || compressed_len == NULL) {
         fprintf(stderr, "compress_data: Invalid arguments\n");
         return SECURE_COMM_ERR_COMPRESS;
@@ -35,25 +263,23 @@ SecureCommError compress_data(const unsigned char* input, size_t input_len,
         return SECURE_COMM_ERR_COMPRESS;
     }
 
-    z_stream strm;
-    memset(&strm, 0, sizeof(strm));
-
-    // Initialize the deflate operation
-    if (deflateInit(&strm, level) != Z_OK) {
-        fprintf(stderr, "compress_data: deflateInit failed\n");
+    // Borrow this thread's pooled deflate stream for the level
+    z_stream* strm = acquire_deflater(level);
+    if (strm == NULL) {
+        fprintf(stderr, "compress_data: Failed to acquire deflate stream\n");
         return SECURE_COMM_ERR_COMPRESS;
     }
 
-    strm.next_in = (Bytef*)input;
-    strm.avail_in = (uInt)input_len;
-    strm.next_out = compressed;
-    strm.avail_out = (uInt)(*compressed_len);
+    strm->next_in = (Bytef*)input;
+    strm->avail_in = (uInt)input_len;
+    strm->next_out = compressed;
+    strm->avail_out = (uInt)(*compressed_len);
 
     // Perform the compression
-    int ret = deflate(&strm, Z_FINISH);
+    int ret = deflate(strm, Z_FINISH);
     if (ret == Z_STREAM_ERROR) {
         fprintf(stderr, "compress_data: deflate failed with Z_STREAM_ERROR\n");
-        deflateEnd(&strm);
+        release_deflater(strm);
         return SECURE_COMM_ERR_COMPRESS;
     }
 
@@ -61,58 +287,70 @@ SecureCommError compress_data(const unsigned char* input, size_t input_len,
     if (ret != Z_STREAM_END) {
         // Not enough space in the output buffer
         fprintf(stderr, "compress_data: Not enough space in the compressed buffer. ret=%d\n", ret);
-        deflateEnd(&strm);
+        release_deflater(strm);
         return SECURE_COMM_ERR_COMPRESS;
     }
 
     // Set the compressed length
-    *compressed_len = strm.total_out;
+    *compressed_len = strm->total_out;
 
     // Clean up
-    deflateEnd(&strm);
+    release_deflater(strm);
 
     return SECURE_COMM_SUCCESS;
 }
 
 /**
- * @brief Decompresses data using zlib (inflate) with pre-allocated buffer.
+ * @brief Compresses data using zlib (deflate) with pre-allocated buffer.
  *
- * This function decompresses the input data using the inflate algorithm provided by zlib.
- * The caller must provide a buffer that is large enough to hold the decompressed data.
+ * This function compresses the input data using the deflate algorithm provided by zlib.
+ * The caller must provide a buffer that is large enough to hold the compressed data.
  *
- * @param compressed Pointer to the data to decompress.
- * @param compressed_len Length of the compressed data in bytes.
- * @param output Pointer to the buffer where decompressed data will be stored.
- * @param output_len Pointer to store the length of the decompressed data.
+ * @param input Pointer to the data to compress.
+ * @param input_len Length of the input data in bytes.
+ * @param compressed Pointer to the buffer where compressed data will be stored.
+ * @param compressed_len Pointer to store the length of the compressed data.
+ * @param level Compression level (0-9). 0 = no compression, 9 = maximum compression.
  *
  * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
  */
-SecureCommError decompress_data(const unsigned char* compressed, size_t compressed_len,
-                                unsigned char* output, size_t* output_len) {
+SecureCommError compress_data(const unsigned char* input, size_t input_len,
+                              unsigned char* compressed, size_t* compressed_len,
+                              int level) {
+    uint64_t start_ns = metrics_now_ns();
+    SecureCommError ret = compress_data_unmetered(input, input_len, compressed, compressed_len, level);
+    metrics_stage_done(METRIC_STAGE_COMPRESS, start_ns, input_len,
+                       ret == SECURE_COMM_SUCCESS ? *compressed_len : 0, ret);
+    return ret;
+}
+
+/**
+ * @brief Body of decompress_data, without the metrics.
+ */
+static SecureCommError decompress_data_unmetered(const unsigned char* compressed, size_t compressed_len,
+                                                 unsigned char* output, size_t* output_len) {
     if (compressed == NULL || output == NULL || output_len == NULL) {
         fprintf(stderr, "decompress_data: Invalid arguments\n");
         return SECURE_COMM_ERR_DECOMPRESS;
     }
 
-    z_stream strm;
-    memset(&strm, 0, sizeof(strm));
-
-    // Initialize the inflate operation
-    if (inflateInit(&strm) != Z_OK) {
-        fprintf(stderr, "decompress_data: inflateInit failed\n");
+    // Borrow this thread's pooled inflate stream
+    z_stream* strm = acquire_inflater();
+    if (strm == NULL) {
+        fprintf(stderr, "decompress_data: Failed to acquire inflate stream\n");
         return SECURE_COMM_ERR_DECOMPRESS;
     }
 
-    strm.next_in = (Bytef*)compressed;
-    strm.avail_in = (uInt)compressed_len;
-    strm.next_out = output;
-    strm.avail_out = (uInt)(*output_len);
+    strm->next_in = (Bytef*)compressed;
+    strm->avail_in = (uInt)compressed_len;
+    strm->next_out = output;
+    strm->avail_out = (uInt)(*output_len);
 
     // Perform the decompression
-    int ret = inflate(&strm, Z_FINISH);
+    int ret = inflate(strm, Z_FINISH);
     if (ret == Z_STREAM_ERROR) {
         fprintf(stderr, "decompress_data: inflate failed with Z_STREAM_ERROR\n");
-        inflateEnd(&strm);
+        release_inflater(strm);
         return SECURE_COMM_ERR_DECOMPRESS;
     }
 
@@ -120,36 +358,47 @@ SecureCommError decompress_data(const unsigned char* compressed, size_t compress
     if (ret != Z_STREAM_END) {
         // Not enough space in the output buffer
         fprintf(stderr, "decompress_data: Not enough space in the output buffer. ret=%d\n", ret);
-        inflateEnd(&strm);
+        release_inflater(strm);
         return SECURE_COMM_ERR_DECOMPRESS;
     }
 
     // Set the decompressed length
-    *output_len = strm.total_out;
+    *output_len = strm->total_out;
 
     // Clean up
-    inflateEnd(&strm);
+    release_inflater(strm);
 
     return SECURE_COMM_SUCCESS;
 }
 
 /**
- * @brief Compresses data using zlib (deflate) with dynamic buffer allocation.
+ * @brief Decompresses data using zlib (inflate) with pre-allocated buffer.
  *
- * This function compresses the input data using the deflate algorithm provided by zlib.
- * It dynamically allocates memory for the compressed data, which must be freed by the caller.
+ * This function decompresses the input data using the inflate algorithm provided by zlib.
+ * The caller must provide a buffer that is large enough to hold the decompressed data.
  *
- * @param input Pointer to the data to compress.
- * @param input_len Length of the input data in bytes.
- * @param compressed_ptr Pointer to store the pointer to the compressed data buffer.
- * @param compressed_len Pointer to store the length of the compressed data.
- * @param level Compression level (0-9). 0 = no compression, 9 = maximum compression.
+ * @param compressed Pointer to the data to decompress.
+ * @param compressed_len Length of the compressed data in bytes.
+ * @param output Pointer to the buffer where decompressed data will be stored.
+ * @param output_len Pointer to store the length of the decompressed data.
  *
  * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
  */
-SecureCommError compress_data_dynamic(const unsigned char* input, size_t input_len,
-                                      unsigned char** compressed_ptr, size_t* compressed_len,
-                                      int level) {
+SecureCommError decompress_data(const unsigned char* compressed, size_t compressed_len,
+                                unsigned char* output, size_t* output_len) {
+    uint64_t start_ns = metrics_now_ns();
+    SecureCommError ret = decompress_data_unmetered(compressed, compressed_len, output, output_len);
+    metrics_stage_done(METRIC_STAGE_DECOMPRESS, start_ns, compressed_len,
+                       ret == SECURE_COMM_SUCCESS ? *output_len : 0, ret);
+    return ret;
+}
+
+/**
+ * @brief Body of compress_data_dynamic, without the metrics.
+ */
+static SecureCommError compress_data_dynamic_unmetered(const unsigned char* input, size_t input_len,
+                                                       unsigned char** compressed_ptr, size_t* compressed_len,
+                                                       int level) {
     if (input == NULL || compressed_ptr == NULL || compressed_len == NULL) {
         fprintf(stderr, "compress_data_dynamic: Invalid arguments\n");
         return SECURE_COMM_ERR_COMPRESS;
@@ -170,26 +419,24 @@ SecureCommError compress_data_dynamic(const unsigned char* input, size_t input_l
         return SECURE_COMM_ERR_MEMORY;
     }
 
-    z_stream strm;
-    memset(&strm, 0, sizeof(strm));
-
-    // Initialize the deflate operation
-    if (deflateInit(&strm, level) != Z_OK) {
-        fprintf(stderr, "compress_data_dynamic: deflateInit failed\n");
+    // Borrow this thread's pooled deflate stream for the level
+    z_stream* strm = acquire_deflater(level);
+    if (strm == NULL) {
+        fprintf(stderr, "compress_data_dynamic: Failed to acquire deflate stream\n");
         free(compressed);
         return SECURE_COMM_ERR_COMPRESS;
     }
 
-    strm.next_in = (Bytef*)input;
-    strm.avail_in = (uInt)input_len;
-    strm.next_out = compressed;
-    strm.avail_out = (uInt)max_compressed_size;
+    strm->next_in = (Bytef*)input;
+    strm->avail_in = (uInt)input_len;
+    strm->next_out = compressed;
+    strm->avail_out = (uInt)max_compressed_size;
 
     // Perform the compression
-    int ret = deflate(&strm, Z_FINISH);
+    int ret = deflate(strm, Z_FINISH);
     if (ret == Z_STREAM_ERROR) {
         fprintf(stderr, "compress_data_dynamic: deflate failed with Z_STREAM_ERROR\n");
-        deflateEnd(&strm);
+        release_deflater(strm);
         free(compressed);
         return SECURE_COMM_ERR_COMPRESS;
     }
@@ -198,16 +445,16 @@ SecureCommError compress_data_dynamic(const unsigned char* input, size_t input_l
     if (ret != Z_STREAM_END) {
         // Not enough space in the output buffer (shouldn't happen with compressBound)
         fprintf(stderr, "compress_data_dynamic: Compression incomplete. ret=%d\n", ret);
-        deflateEnd(&strm);
+        release_deflater(strm);
         free(compressed);
         return SECURE_COMM_ERR_COMPRESS;
     }
 
     // Set the compressed length
-    *compressed_len = strm.total_out;
+    *compressed_len = strm->total_out;
 
     // Clean up
-    deflateEnd(&strm);
+    release_deflater(strm);
 
     // Assign the compressed data pointer to the output parameter
     *compressed_ptr = compressed;
@@ -215,11 +462,59 @@ SecureCommError compress_data_dynamic(const unsigned char* input, size_t input_l
     return SECURE_COMM_SUCCESS;
 }
 
+/**
+ * @brief Compresses data using zlib (deflate) with dynamic buffer allocation.
+ *
+ * This function compresses the input data using the deflate algorithm provided by zlib.
+ * It dynamically allocates memory for the compressed data, which must be freed by the caller.
+ *
+ * @param input Pointer to the data to compress.
+ * @param input_len Length of the input data in bytes.
+ * @param compressed_ptr Pointer to store the pointer to the compressed data buffer.
+ * @param compressed_len Pointer to store the length of the compressed data.
+ * @param level Compression level (0-9), or Z_DEFAULT_COMPRESSION (-1) for zlib's default.
+ *              0 = no compression, 9 = maximum compression.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError compress_data_dynamic(const unsigned char* input, size_t input_len,
+                                      unsigned char** compressed_ptr, size_t* compressed_len,
+                                      int level) {
+    // Both paths take the same levels, whatever the input size
+    if (level < Z_DEFAULT_COMPRESSION || level > 9) {
+        fprintf(stderr, "compress_data_dynamic: Invalid compression level %d\n", level);
+        return SECURE_COMM_ERR_COMPRESS;
+    }
+    if (level == Z_DEFAULT_COMPRESSION) {
+        level = 6; // zlib's default; the pooled streams are indexed by level
+    }
+
+    // Large inputs are split into blocks compressed on the worker pool; the result is
+    // still one zlib stream
+    if (input != NULL && input_len >= SECURE_PARALLEL_COMPRESS_MIN_BYTES) {
+        WorkerPool* pool = worker_pool_default();
+        if (pool != NULL && worker_pool_threads(pool) > 1) {
+            ParallelCompressionConfig config;
+            parallel_compression_config_defaults(&config);
+            config.level = level;
+            return compress_data_parallel(input, input_len, &config, compressed_ptr, compressed_len, NULL, NULL);
+        }
+    }
+
+    uint64_t start_ns = metrics_now_ns();
+    SecureCommError ret = compress_data_dynamic_unmetered(input, input_len, compressed_ptr, compressed_len, level);
+    metrics_stage_done(METRIC_STAGE_COMPRESS, start_ns, input_len,
+                       ret == SECURE_COMM_SUCCESS ? *compressed_len : 0, ret);
+    return ret;
+}
+
 /**
  * @brief Decompresses data using zlib (inflate) with dynamic buffer allocation.
  *
  * This function decompresses the input data using the inflate algorithm provided by zlib.
  * It dynamically allocates memory for the decompressed data, which must be freed by the caller.
+ * Output is bounded by SECURE_DECOMPRESS_DEFAULT_MAX_OUTPUT; use decompress_data_dynamic_ex
+ * to pass a size hint or a different limit.
  *
  * @param compressed Pointer to the data to decompress.
  * @param compressed_len Length of the compressed data in bytes.
@@ -230,63 +525,708 @@ SecureCommError compress_data_dynamic(const unsigned char* input, size_t input_l
  */
 SecureCommError decompress_data_dynamic(const unsigned char* compressed, size_t compressed_len,
                                         unsigned char** output_ptr, size_t* output_len) {
+    return decompress_data_dynamic_ex(compressed, compressed_len, 0, 0, output_ptr, output_len);
+}
+
+/**
+ * @brief Body of decompress_data_dynamic_ex, without the metrics.
+ */
+static SecureCommError decompress_data_dynamic_ex_unmetered(const unsigned char* compressed, size_t compressed_len,
+                                                            size_t size_hint, size_t max_output,
+                                                            unsigned char** output_ptr, size_t* output_len) {
     if (compressed == NULL || output_ptr == NULL || output_len == NULL) {
-        fprintf(stderr, "decompress_data_dynamic: Invalid arguments\n");
+        fprintf(stderr, "decompress_data_dynamic_ex: Invalid arguments\n");
+        return SECURE_COMM_ERR_DECOMPRESS;
+    }
+
+    if (max_output == 0) {
+        max_output = SECURE_DECOMPRESS_DEFAULT_MAX_OUTPUT;
+    }
+
+    if (size_hint > max_output) {
+        fprintf(stderr, "decompress_data_dynamic_ex: Size hint %zu exceeds limit %zu\n", size_hint, max_output);
         return SECURE_COMM_ERR_DECOMPRESS;
     }
 
-    // Estimate the decompressed size. This is application-specific.
-    // Here, we assume that the decompressed data won't exceed 10 times the compressed size.
-    size_t estimated_decompressed_size = compressed_len * 10;
+    // Start from the sender's length when known, otherwise from a modest guess
+    size_t capacity = size_hint;
+    if (capacity == 0) {
+        capacity = compressed_len <= (max_output / 4) ? compressed_len * 4 : max_output;
+        if (capacity < 4096) {
+            capacity = max_output < 4096 ? max_output : 4096;
+        }
+    }
 
-    // Allocate memory for decompressed data
-    unsigned char* decompressed = (unsigned char*)malloc(estimated_decompressed_size);
+    unsigned char* decompressed = (unsigned char*)malloc(capacity);
     if (decompressed == NULL) {
-        fprintf(stderr, "decompress_data_dynamic: Failed to allocate memory for decompressed data.\n");
+        fprintf(stderr, "decompress_data_dynamic_ex: Failed to allocate memory for decompressed data.\n");
         return SECURE_COMM_ERR_MEMORY;
     }
 
-    z_stream strm;
-    memset(&strm, 0, sizeof(strm));
-
-    // Initialize the inflate operation
-    if (inflateInit(&strm) != Z_OK) {
-        fprintf(stderr, "decompress_data_dynamic: inflateInit failed\n");
+    // Borrow this thread's pooled inflate stream
+    z_stream* strm = acquire_inflater();
+    if (strm == NULL) {
+        fprintf(stderr, "decompress_data_dynamic_ex: Failed to acquire inflate stream\n");
         free(decompressed);
         return SECURE_COMM_ERR_DECOMPRESS;
     }
 
-    strm.next_in = (Bytef*)compressed;
-    strm.avail_in = (uInt)compressed_len;
-    strm.next_out = decompressed;
-    strm.avail_out = (uInt)estimated_decompressed_size;
+    strm->next_in = (Bytef*)compressed;
+    strm->avail_in = (uInt)compressed_len;
+    strm->next_out = decompressed;
+    strm->avail_out = (uInt)capacity;
 
-    // Perform the decompression
-    int ret = inflate(&strm, Z_FINISH);
-    if (ret == Z_STREAM_ERROR) {
-        fprintf(stderr, "decompress_data_dynamic: inflate failed with Z_STREAM_ERROR\n");
-        inflateEnd(&strm);
-        free(decompressed);
-        return SECURE_COMM_ERR_DECOMPRESS;
-    }
+    for (;;) {
+        int ret = inflate(strm, Z_NO_FLUSH);
+        if (ret == Z_STREAM_END) {
+            break;
+        }
 
-    // Check if the decompression was completed
-    if (ret != Z_STREAM_END) {
-        // Not enough space in the output buffer
-        fprintf(stderr, "decompress_data_dynamic: Decompression incomplete. ret=%d\n", ret);
-        inflateEnd(&strm);
-        free(decompressed);
-        return SECURE_COMM_ERR_DECOMPRESS;
+        if (ret == Z_NEED_DICT || ret == Z_DATA_ERROR || ret == Z_MEM_ERROR || ret == Z_STREAM_ERROR) {
+            fprintf(stderr, "decompress_data_dynamic_ex: inflate failed. ret=%d\n", ret);
+            release_inflater(strm);
+            free(decompressed);
+            return SECURE_COMM_ERR_DECOMPRESS;
+        }
+
+        if (strm->avail_out != 0) {
+            // Output space left but no progress: the input is truncated
+            fprintf(stderr, "decompress_data_dynamic_ex: Compressed data is truncated\n");
+            release_inflater(strm);
+            free(decompressed);
+            return SECURE_COMM_ERR_DECOMPRESS;
+        }
+
+        // Out of room: grow geometrically, but never past the limit
+        if (capacity >= max_output) {
+            fprintf(stderr, "decompress_data_dynamic_ex: Decompressed size exceeds limit %zu\n", max_output);
+            release_inflater(strm);
+            free(decompressed);
+            return SECURE_COMM_ERR_DECOMPRESS;
+        }
+        size_t new_capacity = capacity <= max_output / 2 ? capacity * 2 : max_output;
+        unsigned char* grown = (unsigned char*)realloc(decompressed, new_capacity);
+        if (grown == NULL) {
+            fprintf(stderr, "decompress_data_dynamic_ex: Failed to grow decompression buffer\n");
+            release_inflater(strm);
+            free(decompressed);
+            return SECURE_COMM_ERR_MEMORY;
+        }
+        decompressed = grown;
+        strm->next_out = decompressed + capacity;
+        strm->avail_out = (uInt)(new_capacity - capacity);
+        capacity = new_capacity;
     }
 
     // Set the decompressed length
-    *output_len = strm.total_out;
+    *output_len = strm->total_out;
 
     // Clean up
-    inflateEnd(&strm);
+    release_inflater(strm);
+
+    // Give back a mostly unused tail
+    if (*output_len > 0 && *output_len < capacity / 2) {
+        unsigned char* shrunk = (unsigned char*)realloc(decompressed, *output_len);
+        if (shrunk != NULL) {
+            decompressed = shrunk;
+        }
+    }
 
     // Assign the decompressed data pointer to the output parameter
     *output_ptr = decompressed;
 
     return SECURE_COMM_SUCCESS;
 }
+
+/**
+ * @brief Decompresses data into a buffer that grows as needed, up to a limit.
+ *
+ * The buffer starts at size_hint when the sender supplied the original length, otherwise
+ * at a small multiple of the input, and doubles whenever inflate runs out of room.
+ * Decompression stops with an error as soon as the output would exceed max_output, so
+ * a decompression bomb costs at most max_output bytes of memory.
+ *
+ * @param compressed Pointer to the data to decompress.
+ * @param compressed_len Length of the compressed data in bytes.
+ * @param size_hint Expected decompressed length, or 0 if unknown.
+ * @param max_output Largest decompressed size accepted, or 0 for SECURE_DECOMPRESS_DEFAULT_MAX_OUTPUT.
+ * @param output_ptr Pointer to store the pointer to the decompressed data buffer.
+ * @param output_len Pointer to store the length of the decompressed data.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError decompress_data_dynamic_ex(const unsigned char* compressed, size_t compressed_len,
+                                           size_t size_hint, size_t max_output,
+                                           unsigned char** output_ptr, size_t* output_len) {
+    uint64_t start_ns = metrics_now_ns();
+    SecureCommError ret = decompress_data_dynamic_ex_unmetered(compressed, compressed_len, size_hint, max_output,
+                                                               output_ptr, output_len);
+    metrics_stage_done(METRIC_STAGE_DECOMPRESS, start_ns, compressed_len,
+                       ret == SECURE_COMM_SUCCESS ? *output_len : 0, ret);
+    return ret;
+}
+
+/**
+ * @brief Compresses data into a buffer taken from a pool.
+ *
+ * @param pool Pool to take the output from, or NULL for the default pool.
+ * @param input Pointer to the data to compress.
+ * @param input_len Length of the input data in bytes.
+ * @param level Compression level (0-9).
+ * @param output Pointer to store the compressed buffer (one reference, owned by the caller).
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError compress_data_pooled(BufferPool* pool, const unsigned char* input, size_t input_len,
+                                     int level, SecureBuffer** output) {
+    if (input == NULL || output == NULL) {
+        fprintf(stderr, "compress_data_pooled: Invalid arguments\n");
+        return SECURE_COMM_ERR_COMPRESS;
+    }
+
+    SecureBuffer* buffer = NULL;
+    SecureCommError ret = buffer_pool_get(pool, compressBound(input_len), &buffer);
+    if (ret != SECURE_COMM_SUCCESS) {
+        return ret;
+    }
+
+    size_t compressed_len = secure_buffer_capacity(buffer);
+    ret = compress_data(input, input_len, secure_buffer_data(buffer), &compressed_len, level);
+    if (ret != SECURE_COMM_SUCCESS) {
+        secure_buffer_release(buffer);
+        return ret;
+    }
+    secure_buffer_set_len(buffer, compressed_len);
+    *output = buffer;
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Body of decompress_data_pooled, without the metrics.
+ */
+static SecureCommError decompress_data_pooled_unmetered(BufferPool* pool, const unsigned char* compressed,
+                                                        size_t compressed_len, size_t size_hint, size_t max_output,
+                                                        SecureBuffer** output) {
+    if (max_output == 0) {
+        max_output = SECURE_DECOMPRESS_DEFAULT_MAX_OUTPUT;
+    }
+    if (size_hint > max_output) {
+        fprintf(stderr, "decompress_data_pooled: Size hint %zu exceeds limit %zu\n", size_hint, max_output);
+        return SECURE_COMM_ERR_DECOMPRESS;
+    }
+
+    size_t capacity = size_hint;
+    if (capacity == 0) {
+        capacity = compressed_len <= (max_output / 4) ? compressed_len * 4 : max_output;
+        if (capacity < 4096) {
+            capacity = max_output < 4096 ? max_output : 4096;
+        }
+    }
+
+    SecureBuffer* buffer = NULL;
+    SecureCommError ret = buffer_pool_get(pool, capacity, &buffer);
+    if (ret != SECURE_COMM_SUCCESS) {
+        return ret;
+    }
+
+    // Use the whole size class, but never more than the limit
+    capacity = secure_buffer_capacity(buffer) < max_output ? secure_buffer_capacity(buffer) : max_output;
+
+    z_stream* strm = acquire_inflater();
+    if (strm == NULL) {
+        fprintf(stderr, "decompress_data_pooled: Failed to acquire inflate stream\n");
+        secure_buffer_release(buffer);
+        return SECURE_COMM_ERR_DECOMPRESS;
+    }
+
+    strm->next_in = (Bytef*)compressed;
+    strm->avail_in = (uInt)compressed_len;
+    strm->next_out = secure_buffer_data(buffer);
+    strm->avail_out = (uInt)capacity;
+
+    for (;;) {
+        int zret = inflate(strm, Z_NO_FLUSH);
+        if (zret == Z_STREAM_END) {
+            break;
+        }
+
+        if (zret == Z_NEED_DICT || zret == Z_DATA_ERROR || zret == Z_MEM_ERROR || zret == Z_STREAM_ERROR ||
+            strm->avail_out != 0) {
+            fprintf(stderr, "decompress_data_pooled: inflate failed or input is truncated. ret=%d\n", zret);
+            release_inflater(strm);
+            secure_buffer_release(buffer);
+            return SECURE_COMM_ERR_DECOMPRESS;
+        }
+
+        if (capacity >= max_output) {
+            fprintf(stderr, "decompress_data_pooled: Decompressed size exceeds limit %zu\n", max_output);
+            release_inflater(strm);
+            secure_buffer_release(buffer);
+            return SECURE_COMM_ERR_DECOMPRESS;
+        }
+
+        // Out of room: move what was produced into the next size class up
+        size_t new_capacity = capacity <= max_output / 2 ? capacity * 2 : max_output;
+        SecureBuffer* grown = NULL;
+        if (buffer_pool_get(pool, new_capacity, &grown) != SECURE_COMM_SUCCESS) {
+            release_inflater(strm);
+            secure_buffer_release(buffer);
+            return SECURE_COMM_ERR_MEMORY;
+        }
+        memcpy(secure_buffer_data(grown), secure_buffer_data(buffer), capacity);
+        secure_buffer_release(buffer);
+        buffer = grown;
+        strm->next_out = secure_buffer_data(buffer) + capacity;
+        strm->avail_out = (uInt)(new_capacity - capacity);
+        capacity = new_capacity;
+    }
+
+    secure_buffer_set_len(buffer, strm->total_out);
+    release_inflater(strm);
+    *output = buffer;
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Decompresses data into a buffer taken from a pool, growing it up to a limit.
+ *
+ * Same sizing and limit rules as decompress_data_dynamic_ex; when the output outgrows
+ * a buffer it moves to one of the next size class.
+ *
+ * @param pool Pool to take the output from, or NULL for the default pool.
+ * @param compressed Pointer to the data to decompress.
+ * @param compressed_len Length of the compressed data in bytes.
+ * @param size_hint Expected decompressed length, or 0 if unknown.
+ * @param max_output Largest decompressed size accepted, or 0 for SECURE_DECOMPRESS_DEFAULT_MAX_OUTPUT.
+ * @param output Pointer to store the decompressed buffer (one reference, owned by the caller).
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError decompress_data_pooled(BufferPool* pool, const unsigned char* compressed, size_t compressed_len,
+                                       size_t size_hint, size_t max_output, SecureBuffer** output) {
+    if (compressed == NULL || output == NULL) {
+        fprintf(stderr, "decompress_data_pooled: Invalid arguments\n");
+        return SECURE_COMM_ERR_DECOMPRESS;
+    }
+
+    uint64_t start_ns = metrics_now_ns();
+    SecureCommError ret = decompress_data_pooled_unmetered(pool, compressed, compressed_len, size_hint, max_output,
+                                                           output);
+    metrics_stage_done(METRIC_STAGE_DECOMPRESS, start_ns, compressed_len,
+                       ret == SECURE_COMM_SUCCESS ? secure_buffer_len(*output) : 0, ret);
+    return ret;
+}
+
+/**
+ * @brief Fills a ParallelCompressionConfig with the defaults.
+ *
+ * @param config The configuration to fill.
+ */
+void parallel_compression_config_defaults(ParallelCompressionConfig* config) {
+    if (config == NULL) {
+        return;
+    }
+    memset(config, 0, sizeof(ParallelCompressionConfig));
+    config->level = Z_DEFAULT_COMPRESSION;
+    config->block_size = 128 * 1024;
+    config->prime_dictionary = 1;
+    config->pool = NULL;
+}
+
+// Size of the back-reference window a block may be primed with
+#define PARALLEL_DICT_SIZE 32768
+
+// Index: magic, block count, then compressed and original length per block (all big-endian)
+#define PARALLEL_INDEX_MAGIC 0x434C5049u   // "CLPI"
+#define PARALLEL_INDEX_HEADER 8
+#define PARALLEL_INDEX_ENTRY 8
+
+// One block of a parallel compression or decompression
+typedef struct {
+    size_t in_offset;           // Offset of the block in the original input
+    size_t in_len;
+    size_t out_offset;          // Reserved (compress) or actual (decompress) offset in the deflate data
+    size_t out_len;             // Compressed length once done
+    uLong adler;                // Adler-32 of the block's original bytes
+    SecureCommError status;
+} parallel_block_t;
+
+typedef struct {
+    const unsigned char* input;
+    unsigned char* output;      // Deflate data region of the output buffer
+    parallel_block_t* blocks;
+    size_t count;
+    int level;
+    int prime;
+    size_t bound;               // Space reserved per block
+} parallel_job_t;
+
+static void put_be32(unsigned char* out, uint32_t value) {
+    out[0] = (unsigned char)(value >> 24);
+    out[1] = (unsigned char)(value >> 16);
+    out[2] = (unsigned char)(value >> 8);
+    out[3] = (unsigned char)value;
+}
+
+static uint32_t get_be32(const unsigned char* in) {
+    return ((uint32_t)in[0] << 24) | ((uint32_t)in[1] << 16) | ((uint32_t)in[2] << 8) | (uint32_t)in[3];
+}
+
+/**
+ * @brief Compresses one block as raw deflate, ending on a byte boundary so blocks concatenate.
+ */
+static void compress_block(void* ctx, size_t index) {
+    parallel_job_t* job = (parallel_job_t*)ctx;
+    parallel_block_t* block = &job->blocks[index];
+    const unsigned char* in = job->input + block->in_offset;
+    int last = index + 1 == job->count;
+
+    block->adler = adler32(1L, in, (uInt)block->in_len);
+
+    z_stream* strm = acquire_raw_deflater(job->level);
+    if (strm == NULL) {
+        block->status = SECURE_COMM_ERR_COMPRESS;
+        return;
+    }
+
+    // The previous block's tail lets matches reach back across the boundary, as in one stream
+    if (job->prime && block->in_offset > 0) {
+        size_t dict_len = block->in_offset < PARALLEL_DICT_SIZE ? block->in_offset : PARALLEL_DICT_SIZE;
+        deflateSetDictionary(strm, in - dict_len, (uInt)dict_len);
+    }
+
+    strm->next_in = (Bytef*)in;
+    strm->avail_in = (uInt)block->in_len;
+    strm->next_out = job->output + block->out_offset;
+    strm->avail_out = (uInt)job->bound;
+
+    // A sync flush ends every block but the last with an empty stored block (byte aligned)
+    int ret = deflate(strm, last ? Z_FINISH : Z_SYNC_FLUSH);
+    if ((last && ret != Z_STREAM_END) || (!last && (ret != Z_OK || strm->avail_in != 0 || strm->avail_out == 0))) {
+        block->status = SECURE_COMM_ERR_COMPRESS;
+    } else {
+        block->out_len = job->bound - strm->avail_out;
+        block->status = SECURE_COMM_SUCCESS;
+    }
+    deflateReset(strm);
+}
+
+/**
+ * @brief Body of compress_data_parallel, without the metrics.
+ */
+static SecureCommError compress_data_parallel_unmetered(const unsigned char* input, size_t input_len,
+                                                        const ParallelCompressionConfig* config,
+                                                        unsigned char** compressed_ptr, size_t* compressed_len,
+                                                        unsigned char** index_ptr, size_t* index_len) {
+    if (input == NULL || compressed_ptr == NULL || compressed_len == NULL ||
+        (index_ptr == NULL) != (index_len == NULL)) {
+        fprintf(stderr, "compress_data_parallel: Invalid arguments\n");
+        return SECURE_COMM_ERR_COMPRESS;
+    }
+
+    ParallelCompressionConfig cfg;
+    if (config != NULL) {
+        cfg = *config;
+    } else {
+        parallel_compression_config_defaults(&cfg);
+    }
+    if (cfg.level == Z_DEFAULT_COMPRESSION) {
+        cfg.level = 6;
+    }
+    if (cfg.level < 0 || cfg.level > 9) {
+        fprintf(stderr, "compress_data_parallel: Invalid compression level %d\n", cfg.level);
+        return SECURE_COMM_ERR_COMPRESS;
+    }
+    if (cfg.block_size < PARALLEL_DICT_SIZE) {
+        cfg.block_size = PARALLEL_DICT_SIZE;
+    }
+    if (cfg.block_size > SECURE_PARALLEL_COMPRESS_MAX_BLOCK) {
+        cfg.block_size = SECURE_PARALLEL_COMPRESS_MAX_BLOCK;
+    }
+    // Independent blocks are what make the index usable
+    if (index_ptr != NULL) {
+        cfg.prime_dictionary = 0;
+    }
+
+    size_t count = input_len == 0 ? 1 : (input_len + cfg.block_size - 1) / cfg.block_size;
+    if (count > UINT32_MAX) {
+        fprintf(stderr, "compress_data_parallel: Input of %zu bytes has too many blocks\n", input_len);
+        return SECURE_COMM_ERR_COMPRESS;
+    }
+    parallel_block_t* blocks = (parallel_block_t*)calloc(count, sizeof(parallel_block_t));
+    if (blocks == NULL) {
+        fprintf(stderr, "compress_data_parallel: Failed to allocate memory for %zu blocks\n", count);
+        return SECURE_COMM_ERR_MEMORY;
+    }
+
+    // Each block writes into its own reserved slot; the slots are packed together afterwards
+    parallel_job_t job;
+    job.input = input;
+    job.blocks = blocks;
+    job.count = count;
+    job.level = cfg.level;
+    job.prime = cfg.prime_dictionary;
+    job.bound = compressBound(cfg.block_size) + 16; // Room for the sync flush marker
+    for (size_t i = 0; i < count; i++) {
+        blocks[i].in_offset = i * cfg.block_size;
+        blocks[i].in_len = i + 1 == count ? input_len - blocks[i].in_offset : cfg.block_size;
+        blocks[i].out_offset = i * job.bound;
+    }
+
+    unsigned char* compressed = (unsigned char*)malloc(2 + count * job.bound + 4);
+    if (compressed == NULL) {
+        fprintf(stderr, "compress_data_parallel: Failed to allocate memory for compressed data.\n");
+        free(blocks);
+        return SECURE_COMM_ERR_MEMORY;
+    }
+    job.output = compressed + 2;
+
+    worker_pool_parallel_for(cfg.pool, count, compress_block, &job);
+
+    // Pack the blocks behind the zlib header and combine their checksums
+    uLong adler = 1L;
+    size_t out = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (blocks[i].status != SECURE_COMM_SUCCESS) {
+            fprintf(stderr, "compress_data_parallel: Block %zu failed to compress\n", i);
+            free(compressed);
+            free(blocks);
+            return SECURE_COMM_ERR_COMPRESS;
+        }
+        memmove(job.output + out, job.output + blocks[i].out_offset, blocks[i].out_len);
+        blocks[i].out_offset = out;
+        out += blocks[i].out_len;
+        adler = adler32_combine(adler, blocks[i].adler, (z_off_t)blocks[i].in_len);
+    }
+
+    // zlib header (deflate, 32 KB window, level hint, no preset dictionary) and Adler-32 trailer
+    unsigned int flevel = cfg.level < 2 ? 0 : cfg.level < 6 ? 1 : cfg.level == 6 ? 2 : 3;
+    unsigned int header = (0x78u << 8) | (flevel << 6);
+    header += 31 - header % 31;
+    compressed[0] = (unsigned char)(header >> 8);
+    compressed[1] = (unsigned char)header;
+    put_be32(job.output + out, (uint32_t)adler);
+    size_t total = 2 + out + 4;
+
+    if (index_ptr != NULL) {
+        unsigned char* index = (unsigned char*)malloc(PARALLEL_INDEX_HEADER + count * PARALLEL_INDEX_ENTRY);
+        if (index == NULL) {
+            fprintf(stderr, "compress_data_parallel: Failed to allocate memory for the index\n");
+            free(compressed);
+            free(blocks);
+            return SECURE_COMM_ERR_MEMORY;
+        }
+        put_be32(index, PARALLEL_INDEX_MAGIC);
+        put_be32(index + 4, (uint32_t)count);
+        for (size_t i = 0; i < count; i++) {
+            put_be32(index + PARALLEL_INDEX_HEADER + i * PARALLEL_INDEX_ENTRY, (uint32_t)blocks[i].out_len);
+            put_be32(index + PARALLEL_INDEX_HEADER + i * PARALLEL_INDEX_ENTRY + 4, (uint32_t)blocks[i].in_len);
+        }
+        *index_ptr = index;
+        *index_len = PARALLEL_INDEX_HEADER + count * PARALLEL_INDEX_ENTRY;
+    }
+    free(blocks);
+
+    // Give back the unused reservations
+    unsigned char* shrunk = (unsigned char*)realloc(compressed, total);
+    *compressed_ptr = shrunk != NULL ? shrunk : compressed;
+    *compressed_len = total;
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Compresses data in independent blocks on the worker pool, producing one zlib stream.
+ *
+ * @param input Pointer to the data to compress.
+ * @param input_len Length of the input data in bytes.
+ * @param config Block size, level and pool, or NULL for the defaults.
+ * @param compressed_ptr Pointer to store the compressed data (caller frees).
+ * @param compressed_len Pointer to store the length of the compressed data.
+ * @param index_ptr Optional pointer to store a block index (caller frees).
+ * @param index_len Pointer to store the index length; NULL exactly when index_ptr is.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError compress_data_parallel(const unsigned char* input, size_t input_len,
+                                       const ParallelCompressionConfig* config,
+                                       unsigned char** compressed_ptr, size_t* compressed_len,
+                                       unsigned char** index_ptr, size_t* index_len) {
+    uint64_t start_ns = metrics_now_ns();
+    SecureCommError ret = compress_data_parallel_unmetered(input, input_len, config, compressed_ptr, compressed_len,
+                                                           index_ptr, index_len);
+    metrics_stage_done(METRIC_STAGE_COMPRESS, start_ns, input_len,
+                       ret == SECURE_COMM_SUCCESS ? *compressed_len : 0, ret);
+    return ret;
+}
+
+/**
+ * @brief Inflates one independent block into its slice of the output.
+ */
+static void decompress_block(void* ctx, size_t index) {
+    parallel_job_t* job = (parallel_job_t*)ctx;
+    parallel_block_t* block = &job->blocks[index];
+    int last = index + 1 == job->count;
+    block->status = SECURE_COMM_ERR_DECOMPRESS;
+
+    z_stream* strm = acquire_raw_inflater();
+    if (strm == NULL) {
+        return;
+    }
+
+    strm->next_in = (Bytef*)job->input + block->out_offset;
+    strm->avail_in = (uInt)block->out_len;
+    strm->next_out = job->output + block->in_offset;
+    strm->avail_out = (uInt)block->in_len;
+    int ret = inflate(strm, Z_NO_FLUSH);
+
+    // Exactly in_len bytes must come out, leaving at most the block's end marker unread
+    unsigned char spare;
+    if (ret == Z_OK && strm->avail_out == 0 && strm->avail_in > 0) {
+        strm->next_out = &spare;
+        strm->avail_out = 1;
+        ret = inflate(strm, Z_NO_FLUSH);
+        if (strm->avail_out == 0) {
+            ret = Z_DATA_ERROR;
+        } else {
+            strm->avail_out = 0;
+        }
+    }
+    int complete = last ? ret == Z_STREAM_END : (ret == Z_OK || ret == Z_BUF_ERROR);
+    if (complete && strm->avail_out == 0 && strm->avail_in == 0) {
+        block->adler = adler32(1L, job->output + block->in_offset, (uInt)block->in_len);
+        block->status = SECURE_COMM_SUCCESS;
+    }
+    inflateReset(strm);
+}
+
+/**
+ * @brief Body of decompress_data_parallel, without the metrics.
+ */
+static SecureCommError decompress_data_parallel_unmetered(const unsigned char* compressed, size_t compressed_len,
+                                                          const unsigned char* index, size_t index_len,
+                                                          size_t max_output, WorkerPool* pool,
+                                                          unsigned char** output_ptr, size_t* output_len) {
+    if (compressed == NULL || output_ptr == NULL || output_len == NULL) {
+        fprintf(stderr, "decompress_data_parallel: Invalid arguments\n");
+        return SECURE_COMM_ERR_DECOMPRESS;
+    }
+    if (max_output == 0) {
+        max_output = SECURE_DECOMPRESS_DEFAULT_MAX_OUTPUT;
+    }
+
+    // Without an index the stream can only be inflated front to back
+    if (index == NULL) {
+        return decompress_data_dynamic_ex_unmetered(compressed, compressed_len, 0, max_output,
+                                                    output_ptr, output_len);
+    }
+
+    if (index_len < PARALLEL_INDEX_HEADER || get_be32(index) != PARALLEL_INDEX_MAGIC || compressed_len < 6) {
+        fprintf(stderr, "decompress_data_parallel: Malformed block index\n");
+        return SECURE_COMM_ERR_DECOMPRESS;
+    }
+    size_t count = get_be32(index + 4);
+    if (count == 0 || (index_len - PARALLEL_INDEX_HEADER) / PARALLEL_INDEX_ENTRY != count ||
+        (index_len - PARALLEL_INDEX_HEADER) % PARALLEL_INDEX_ENTRY != 0) {
+        fprintf(stderr, "decompress_data_parallel: Malformed block index\n");
+        return SECURE_COMM_ERR_DECOMPRESS;
+    }
+    if (((unsigned int)compressed[0] << 8 | compressed[1]) % 31 != 0 || (compressed[0] & 0x0F) != Z_DEFLATED ||
+        (compressed[1] & 0x20) != 0) {
+        fprintf(stderr, "decompress_data_parallel: Not a zlib stream\n");
+        return SECURE_COMM_ERR_DECOMPRESS;
+    }
+
+    parallel_block_t* blocks = (parallel_block_t*)calloc(count, sizeof(parallel_block_t));
+    if (blocks == NULL) {
+        fprintf(stderr, "decompress_data_parallel: Failed to allocate memory for %zu blocks\n", count);
+        return SECURE_COMM_ERR_MEMORY;
+    }
+
+    // The index must account for every byte between header and trailer, within the output limit
+    size_t in = 0;
+    size_t out = 0;
+    for (size_t i = 0; i < count; i++) {
+        const unsigned char* entry = index + PARALLEL_INDEX_HEADER + i * PARALLEL_INDEX_ENTRY;
+        blocks[i].out_offset = in;
+        blocks[i].out_len = get_be32(entry);
+        blocks[i].in_offset = out;
+        blocks[i].in_len = get_be32(entry + 4);
+        in += blocks[i].out_len;
+        out += blocks[i].in_len;
+        if (out > max_output) {
+            fprintf(stderr, "decompress_data_parallel: Decompressed size exceeds limit %zu\n", max_output);
+            free(blocks);
+            return SECURE_COMM_ERR_DECOMPRESS;
+        }
+    }
+    if (in != compressed_len - 6) {
+        fprintf(stderr, "decompress_data_parallel: Block index does not match the stream\n");
+        free(blocks);
+        return SECURE_COMM_ERR_DECOMPRESS;
+    }
+
+    unsigned char* decompressed = (unsigned char*)malloc(out > 0 ? out : 1);
+    if (decompressed == NULL) {
+        fprintf(stderr, "decompress_data_parallel: Failed to allocate memory for decompressed data.\n");
+        free(blocks);
+        return SECURE_COMM_ERR_MEMORY;
+    }
+
+    parallel_job_t job;
+    job.input = compressed + 2;
+    job.output = decompressed;
+    job.blocks = blocks;
+    job.count = count;
+    job.level = 0;
+    job.prime = 0;
+    job.bound = 0;
+    worker_pool_parallel_for(pool, count, decompress_block, &job);
+
+    uLong adler = 1L;
+    for (size_t i = 0; i < count; i++) {
+        if (blocks[i].status != SECURE_COMM_SUCCESS) {
+            fprintf(stderr, "decompress_data_parallel: Block %zu is corrupt or depends on an earlier block\n", i);
+            free(decompressed);
+            free(blocks);
+            return SECURE_COMM_ERR_DECOMPRESS;
+        }
+        adler = adler32_combine(adler, blocks[i].adler, (z_off_t)blocks[i].in_len);
+    }
+    free(blocks);
+
+    if ((uint32_t)adler != get_be32(compressed + compressed_len - 4)) {
+        fprintf(stderr, "decompress_data_parallel: Checksum mismatch\n");
+        free(decompressed);
+        return SECURE_COMM_ERR_DECOMPRESS;
+    }
+
+    *output_ptr = decompressed;
+    *output_len = out;
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Decompresses a stream from compress_data_parallel, inflating its blocks in parallel.
+ *
+ * @param compressed Pointer to the zlib stream.
+ * @param compressed_len Length of the stream in bytes.
+ * @param index Block index written by compress_data_parallel, or NULL to inflate serially.
+ * @param index_len Length of the index.
+ * @param max_output Largest decompressed size accepted, or 0 for SECURE_DECOMPRESS_DEFAULT_MAX_OUTPUT.
+ * @param pool The pool, or NULL for worker_pool_default().
+ * @param output_ptr Pointer to store the decompressed data (caller frees).
+ * @param output_len Pointer to store the length of the decompressed data.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError decompress_data_parallel(const unsigned char* compressed, size_t compressed_len,
+                                         const unsigned char* index, size_t index_len,
+                                         size_t max_output, WorkerPool* pool,
+                                         unsigned char** output_ptr, size_t* output_len) {
+    uint64_t start_ns = metrics_now_ns();
+    SecureCommError ret = decompress_data_parallel_unmetered(compressed, compressed_len, index, index_len,
+                                                             max_output, pool, output_ptr, output_len);
+    metrics_stage_done(METRIC_STAGE_DECOMPRESS, start_ns, compressed_len,
+                       ret == SECURE_COMM_SUCCESS ? *output_len : 0, ret);
+    return ret;
+}
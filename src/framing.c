@@ -0,0 +1,378 @@
+// framing.c
+
+#include "secure_comm.h"
+
+#include <stdio.h>      // For fprintf
+#include <stdlib.h>     // For malloc, free
+#include <string.h>     // For memcpy, memset
+#include <errno.h>      // For errno and strerror
+
+// Definition of the opaque FrameDecoder structure
+struct FrameDecoder {
+    unsigned char* ring;    // Ring buffer storage (capacity is a power of two)
+    size_t capacity;        // Size of ring in bytes
+    size_t head;            // Read position (monotonic, masked on access)
+    size_t tail;            // Write position (monotonic, masked on access)
+    size_t max_payload;     // Largest payload accepted before the stream is declared malformed
+};
+
+/**
+ * @brief Serializes a frame header into its 8-byte wire form (length in network byte order).
+ *
+ * @param header The header to encode.
+ * @param out Buffer of at least SECURE_FRAME_HEADER_SIZE bytes.
+ */
+void frame_encode_header(const FrameHeader* header, unsigned char* out) {
+    out[0] = (unsigned char)(header->length >> 24);
+    out[1] = (unsigned char)(header->length >> 16);
+    out[2] = (unsigned char)(header->length >> 8);
+    out[3] = (unsigned char)(header->length);
+    out[4] = header->type;
+    out[5] = header->flags;
+    out[6] = header->codec;
+    out[7] = header->suite;
+}
+
+/**
+ * @brief Parses an 8-byte wire header.
+ *
+ * @param in Buffer of at least SECURE_FRAME_HEADER_SIZE bytes.
+ * @param header Pointer to store the decoded header.
+ */
+void frame_decode_header(const unsigned char* in, FrameHeader* header) {
+    header->length = ((uint32_t)in[0] << 24) | ((uint32_t)in[1] << 16) |
+                     ((uint32_t)in[2] << 8) | (uint32_t)in[3];
+    header->type = in[4];
+    header->flags = in[5];
+    header->codec = in[6];
+    header->suite = in[7];
+}
+
+/**
+ * @brief Appends one complete frame (header + payload) to a batch buffer.
+ *
+ * Appending several frames and sending the buffer once lets many messages
+ * share a single send() call.
+ *
+ * @param buffer Destination buffer.
+ * @param capacity Size of the destination buffer.
+ * @param used In: bytes already in the buffer. Out: bytes after appending.
+ * @param type Frame type (FRAME_TYPE_*).
+ * @param flags Frame flags (FRAME_FLAG_*).
+ * @param payload Payload bytes (may be NULL when len is 0).
+ * @param len Payload length in bytes.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or SECURE_COMM_ERR_MEMORY if the frame does not fit.
+ */
+SecureCommError frame_append(unsigned char* buffer, size_t capacity, size_t* used,
+                             uint8_t type, uint8_t flags,
+                             const void* payload, size_t len) {
+    if (buffer == NULL || used == NULL || (payload == NULL && len > 0) || len > UINT32_MAX) {
+        fprintf(stderr, "frame_append: Invalid arguments\n");
+        return SECURE_COMM_ERR_FRAME;
+    }
+
+    if (*used > capacity || capacity - *used < SECURE_FRAME_HEADER_SIZE + len) {
+        return SECURE_COMM_ERR_MEMORY;
+    }
+
+    FrameHeader header;
+    memset(&header, 0, sizeof(header));
+    header.length = (uint32_t)len;
+    header.type = type;
+    header.flags = flags;
+
+    frame_encode_header(&header, buffer + *used);
+    if (len > 0) {
+        memcpy(buffer + *used + SECURE_FRAME_HEADER_SIZE, payload, len);
+    }
+    *used += SECURE_FRAME_HEADER_SIZE + len;
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Sends an entire buffer on a blocking socket, retrying short writes.
+ *
+ * @param fd Connected socket.
+ * @param data Bytes to send.
+ * @param len Number of bytes to send.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or SECURE_COMM_ERR_SEND on failure.
+ */
+SecureCommError frame_send_all(int fd, const void* data, size_t len) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    size_t offset = 0;
+
+    while (offset < len) {
+        ssize_t sent = send(fd, bytes + offset, len - offset, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            fprintf(stderr, "frame_send_all: send failed: %s\n", strerror(errno));
+            return SECURE_COMM_ERR_SEND;
+        }
+        offset += (size_t)sent;
+    }
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Creates a frame decoder backed by a ring buffer.
+ *
+ * @param capacity Ring size in bytes; rounded up to a power of two and to at least
+ *                 one maximum-size frame.
+ * @param max_payload Largest payload accepted. Larger length fields are treated as
+ *                    a malformed stream.
+ * @param decoder Pointer to store the created FrameDecoder.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError frame_decoder_create(size_t capacity, size_t max_payload, FrameDecoder** decoder) {
+    if (decoder == NULL || max_payload == 0 || max_payload > UINT32_MAX) {
+        fprintf(stderr, "frame_decoder_create: Invalid arguments\n");
+        return SECURE_COMM_ERR_FRAME;
+    }
+
+    size_t needed = capacity;
+    if (needed < max_payload + SECURE_FRAME_HEADER_SIZE) {
+        needed = max_payload + SECURE_FRAME_HEADER_SIZE;
+    }
+    size_t ring_size = 1024;
+    while (ring_size < needed) {
+        ring_size <<= 1;
+    }
+
+    FrameDecoder* dec = (FrameDecoder*)malloc(sizeof(FrameDecoder));
+    if (dec == NULL) {
+        fprintf(stderr, "frame_decoder_create: Failed to allocate memory for decoder\n");
+        return SECURE_COMM_ERR_MEMORY;
+    }
+    memset(dec, 0, sizeof(FrameDecoder));
+
+    dec->ring = (unsigned char*)malloc(ring_size);
+    if (dec->ring == NULL) {
+        fprintf(stderr, "frame_decoder_create: Failed to allocate ring buffer\n");
+        free(dec);
+        return SECURE_COMM_ERR_MEMORY;
+    }
+    dec->capacity = ring_size;
+    dec->max_payload = max_payload;
+
+    *decoder = dec;
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Copies bytes out of the ring starting at a logical offset from head.
+ */
+static void ring_copy_out(const FrameDecoder* dec, size_t offset, unsigned char* out, size_t len) {
+    size_t mask = dec->capacity - 1;
+    size_t start = (dec->head + offset) & mask;
+    size_t first = dec->capacity - start;
+    if (first > len) {
+        first = len;
+    }
+    memcpy(out, dec->ring + start, first);
+    if (len > first) {
+        memcpy(out + first, dec->ring, len - first);
+    }
+}
+
+/**
+ * @brief Returns the contiguous free region at the ring's write position.
+ *
+ * Lets callers recv() straight into the decoder. Follow with frame_decoder_commit.
+ *
+ * @param decoder The decoder.
+ * @param ptr Pointer to store the start of the free region.
+ * @param len Pointer to store its length (0 when the ring is full).
+ */
+void frame_decoder_write_space(FrameDecoder* decoder, unsigned char** ptr, size_t* len) {
+    size_t mask = decoder->capacity - 1;
+    size_t used = decoder->tail - decoder->head;
+    size_t free_bytes = decoder->capacity - used;
+    size_t start = decoder->tail & mask;
+    size_t contiguous = decoder->capacity - start;
+
+    *ptr = decoder->ring + start;
+    *len = contiguous < free_bytes ? contiguous : free_bytes;
+}
+
+/**
+ * @brief Marks bytes written into the region from frame_decoder_write_space as valid.
+ *
+ * @param decoder The decoder.
+ * @param len Number of bytes written.
+ */
+void frame_decoder_commit(FrameDecoder* decoder, size_t len) {
+    decoder->tail += len;
+}
+
+/**
+ * @brief Copies received bytes into the decoder.
+ *
+ * @param decoder The decoder.
+ * @param data Bytes read from the socket.
+ * @param len Number of bytes.
+ * @param consumed Pointer to store how many bytes fit (less than len if the ring is full).
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError frame_decoder_feed(FrameDecoder* decoder, const void* data, size_t len, size_t* consumed) {
+    if (decoder == NULL || (data == NULL && len > 0) || consumed == NULL) {
+        fprintf(stderr, "frame_decoder_feed: Invalid arguments\n");
+        return SECURE_COMM_ERR_FRAME;
+    }
+
+    const unsigned char* bytes = (const unsigned char*)data;
+    size_t total = 0;
+    while (total < len) {
+        unsigned char* space;
+        size_t space_len;
+        frame_decoder_write_space(decoder, &space, &space_len);
+        if (space_len == 0) {
+            break;
+        }
+        size_t chunk = len - total < space_len ? len - total : space_len;
+        memcpy(space, bytes + total, chunk);
+        frame_decoder_commit(decoder, chunk);
+        total += chunk;
+    }
+
+    *consumed = total;
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Decodes the header at the read position and checks that its whole frame is buffered.
+ */
+static SecureCommError frame_decoder_peek(const FrameDecoder* decoder, FrameHeader* header) {
+    size_t used = decoder->tail - decoder->head;
+    if (used < SECURE_FRAME_HEADER_SIZE) {
+        return SECURE_COMM_ERR_AGAIN;
+    }
+
+    unsigned char raw[SECURE_FRAME_HEADER_SIZE];
+    ring_copy_out(decoder, 0, raw, sizeof(raw));
+    frame_decode_header(raw, header);
+
+    if (header->length > decoder->max_payload) {
+        fprintf(stderr, "frame_decoder_next: Frame length %u exceeds limit %zu\n",
+                header->length, decoder->max_payload);
+        return SECURE_COMM_ERR_FRAME;
+    }
+
+    if (used < SECURE_FRAME_HEADER_SIZE + (size_t)header->length) {
+        return SECURE_COMM_ERR_AGAIN;
+    }
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Consumes the frame described by header.
+ */
+static void frame_decoder_skip(FrameDecoder* decoder, const FrameHeader* header) {
+    decoder->head += SECURE_FRAME_HEADER_SIZE + header->length;
+
+    // Rewind when empty so the next frame starts contiguous
+    if (decoder->head == decoder->tail) {
+        decoder->head = 0;
+        decoder->tail = 0;
+    }
+}
+
+/**
+ * @brief Extracts the next complete frame, if one is buffered.
+ *
+ * Call repeatedly after each read: a single recv() may complete several frames,
+ * and a frame split across reads is reassembled here.
+ *
+ * @param decoder The decoder.
+ * @param header Pointer to store the frame header.
+ * @param payload Buffer receiving the payload.
+ * @param payload_cap Size of the payload buffer.
+ *
+ * @return SECURE_COMM_SUCCESS when a frame was extracted, SECURE_COMM_ERR_AGAIN when more
+ *         bytes are needed, or SECURE_COMM_ERR_FRAME if the stream is malformed or the frame
+ *         does not fit in payload_cap (the frame is then left in the decoder).
+ */
+SecureCommError frame_decoder_next(FrameDecoder* decoder, FrameHeader* header,
+                                   unsigned char* payload, size_t payload_cap) {
+    if (decoder == NULL || header == NULL || (payload == NULL && payload_cap > 0)) {
+        fprintf(stderr, "frame_decoder_next: Invalid arguments\n");
+        return SECURE_COMM_ERR_FRAME;
+    }
+
+    SecureCommError ret = frame_decoder_peek(decoder, header);
+    if (ret != SECURE_COMM_SUCCESS) {
+        return ret;
+    }
+
+    if (header->length > payload_cap) {
+        fprintf(stderr, "frame_decoder_next: Payload buffer too small (%zu < %u)\n",
+                payload_cap, header->length);
+        return SECURE_COMM_ERR_FRAME;
+    }
+
+    ring_copy_out(decoder, SECURE_FRAME_HEADER_SIZE, payload, header->length);
+    frame_decoder_skip(decoder, header);
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Extracts the next complete frame into a buffer taken from a pool.
+ *
+ * @param decoder The decoder.
+ * @param pool Pool to take the payload buffer from, or NULL for the default pool.
+ * @param header Pointer to store the frame header.
+ * @param payload Pointer to store the payload buffer (one reference, owned by the caller).
+ *
+ * @return SECURE_COMM_SUCCESS when a frame was extracted, SECURE_COMM_ERR_AGAIN when more
+ *         bytes are needed, SECURE_COMM_ERR_FRAME if the stream is malformed, or
+ *         SECURE_COMM_ERR_MEMORY if no buffer could be taken.
+ */
+SecureCommError frame_decoder_next_buffer(FrameDecoder* decoder, BufferPool* pool, FrameHeader* header,
+                                          SecureBuffer** payload) {
+    if (decoder == NULL || header == NULL || payload == NULL) {
+        fprintf(stderr, "frame_decoder_next_buffer: Invalid arguments\n");
+        return SECURE_COMM_ERR_FRAME;
+    }
+
+    SecureCommError ret = frame_decoder_peek(decoder, header);
+    if (ret != SECURE_COMM_SUCCESS) {
+        return ret;
+    }
+
+    SecureBuffer* buffer = NULL;
+    ret = buffer_pool_get(pool, header->length, &buffer);
+    if (ret != SECURE_COMM_SUCCESS) {
+        return ret;
+    }
+    ring_copy_out(decoder, SECURE_FRAME_HEADER_SIZE, secure_buffer_data(buffer), header->length);
+    secure_buffer_set_len(buffer, header->length);
+    frame_decoder_skip(decoder, header);
+
+    *payload = buffer;
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Returns the number of buffered, not yet extracted bytes.
+ */
+size_t frame_decoder_buffered(const FrameDecoder* decoder) {
+    return decoder ? decoder->tail - decoder->head : 0;
+}
+
+/**
+ * @brief Destroys a frame decoder.
+ *
+ * @param decoder The decoder to destroy.
+ */
+void frame_decoder_destroy(FrameDecoder* decoder) {
+    if (decoder == NULL) {
+        return;
+    }
+    free(decoder->ring);
+    free(decoder);
+}
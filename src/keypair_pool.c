@@ -0,0 +1,215 @@
+// keypair_pool.c
+
+#include "secure_comm.h"
+
+#include <stdio.h>      // For fprintf
+#include <stdlib.h>     // For malloc, calloc, free
+#include <string.h>     // For memset
+#include <pthread.h>    // For the refill thread
+
+// Definition of the opaque KeypairPool structure
+struct KeypairPool {
+    KeypairPoolConfig config;
+    EVP_PKEY** keys;            // Stack of ready keypairs (capacity = high_watermark)
+    size_t count;               // Keypairs currently in the stack
+    pthread_mutex_t lock;
+    pthread_cond_t refill;      // Signalled when count drops to low_watermark
+    pthread_t worker;
+    int stopping;
+    KeypairPoolStats stats;
+};
+
+/**
+ * @brief Fills a KeypairPoolConfig with the defaults.
+ *
+ * @param config The configuration to fill.
+ */
+void keypair_pool_config_defaults(KeypairPoolConfig* config) {
+    if (config == NULL) {
+        return;
+    }
+    memset(config, 0, sizeof(KeypairPoolConfig));
+    config->kex = SESSION_KEX_FFDHE2048;
+    config->high_watermark = 64;
+    config->low_watermark = 16;
+}
+
+/**
+ * @brief Refill thread: sleeps until the pool drains to the low watermark, then
+ *        generates keypairs until it is back at the high watermark.
+ */
+static void* keypair_pool_worker(void* arg) {
+    KeypairPool* pool = (KeypairPool*)arg;
+
+    pthread_mutex_lock(&pool->lock);
+    while (!pool->stopping) {
+        if (pool->count > pool->config.low_watermark && pool->count > 0) {
+            pthread_cond_wait(&pool->refill, &pool->lock);
+            continue;
+        }
+
+        pool->stats.refills++;
+        while (!pool->stopping && pool->count < pool->config.high_watermark) {
+            // Key generation runs unlocked so takers are never blocked behind it
+            pthread_mutex_unlock(&pool->lock);
+            EVP_PKEY* keypair = NULL;
+            SecureCommError ret = generate_session_keypair(pool->config.kex, &keypair);
+            pthread_mutex_lock(&pool->lock);
+
+            if (ret != SECURE_COMM_SUCCESS) {
+                pool->stats.failures++;
+                break;
+            }
+            if (pool->count < pool->config.high_watermark) {
+                pool->keys[pool->count++] = keypair;
+                pool->stats.generated++;
+            } else {
+                EVP_PKEY_free(keypair);
+            }
+        }
+
+        // Do not spin on persistent generation failures; wait for the next take
+        if (!pool->stopping && pool->count < pool->config.high_watermark) {
+            pthread_cond_wait(&pool->refill, &pool->lock);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+/**
+ * @brief Creates a keypair pool and starts its refill thread.
+ *
+ * @param config Pool parameters, or NULL for the defaults.
+ * @param pool Pointer to store the created KeypairPool.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError keypair_pool_create(const KeypairPoolConfig* config, KeypairPool** pool) {
+    if (pool == NULL) {
+        fprintf(stderr, "keypair_pool_create: Invalid arguments\n");
+        return SECURE_COMM_ERR_SESSION;
+    }
+
+    KeypairPoolConfig cfg;
+    if (config) {
+        cfg = *config;
+    } else {
+        keypair_pool_config_defaults(&cfg);
+    }
+
+    if (cfg.kex < 0 || cfg.kex >= SESSION_KEX_COUNT || cfg.high_watermark == 0 ||
+        cfg.low_watermark >= cfg.high_watermark) {
+        fprintf(stderr, "keypair_pool_create: Invalid configuration\n");
+        return SECURE_COMM_ERR_SESSION;
+    }
+
+    KeypairPool* p = (KeypairPool*)calloc(1, sizeof(KeypairPool));
+    if (p == NULL) {
+        fprintf(stderr, "keypair_pool_create: Failed to allocate memory for pool\n");
+        return SECURE_COMM_ERR_MEMORY;
+    }
+    p->keys = (EVP_PKEY**)calloc(cfg.high_watermark, sizeof(EVP_PKEY*));
+    if (p->keys == NULL) {
+        fprintf(stderr, "keypair_pool_create: Failed to allocate memory for keypairs\n");
+        free(p);
+        return SECURE_COMM_ERR_MEMORY;
+    }
+    p->config = cfg;
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_cond_init(&p->refill, NULL);
+
+    if (pthread_create(&p->worker, NULL, keypair_pool_worker, p) != 0) {
+        fprintf(stderr, "keypair_pool_create: Failed to start refill thread\n");
+        pthread_cond_destroy(&p->refill);
+        pthread_mutex_destroy(&p->lock);
+        free(p->keys);
+        free(p);
+        return SECURE_COMM_ERR_SESSION;
+    }
+
+    *pool = p;
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Takes a ready keypair, or generates one inline if the pool is empty.
+ *
+ * @param pool The pool.
+ * @param keypair Pointer to store the keypair (caller frees with EVP_PKEY_free).
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError keypair_pool_take(KeypairPool* pool, EVP_PKEY** keypair) {
+    if (pool == NULL || keypair == NULL) {
+        fprintf(stderr, "keypair_pool_take: Invalid arguments\n");
+        return SECURE_COMM_ERR_SESSION;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    if (pool->count > 0) {
+        *keypair = pool->keys[--pool->count];
+        pool->stats.hits++;
+        if (pool->count <= pool->config.low_watermark) {
+            pthread_cond_signal(&pool->refill);
+        }
+        pthread_mutex_unlock(&pool->lock);
+        return SECURE_COMM_SUCCESS;
+    }
+
+    // Empty: fall back to inline generation and make sure the worker is awake
+    pool->stats.empty_hits++;
+    pthread_cond_signal(&pool->refill);
+    pthread_mutex_unlock(&pool->lock);
+    return generate_session_keypair(pool->config.kex, keypair);
+}
+
+/**
+ * @brief Returns the key exchange the pool generates keypairs for.
+ */
+SessionKeyExchange keypair_pool_kex(const KeypairPool* pool) {
+    return pool->config.kex;
+}
+
+/**
+ * @brief Copies the pool counters.
+ *
+ * @param pool The pool.
+ * @param stats Pointer to store the counters.
+ */
+void keypair_pool_stats(KeypairPool* pool, KeypairPoolStats* stats) {
+    if (pool == NULL || stats == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&pool->lock);
+    *stats = pool->stats;
+    stats->available = pool->count;
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/**
+ * @brief Stops the refill thread and frees every pooled keypair.
+ *
+ * Detach the pool from the session layer (session_set_keypair_pool(NULL)) first.
+ *
+ * @param pool The pool to destroy.
+ */
+void keypair_pool_destroy(KeypairPool* pool) {
+    if (pool == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stopping = 1;
+    pthread_cond_signal(&pool->refill);
+    pthread_mutex_unlock(&pool->lock);
+    pthread_join(pool->worker, NULL);
+
+    for (size_t i = 0; i < pool->count; i++) {
+        EVP_PKEY_free(pool->keys[i]);
+    }
+    pthread_cond_destroy(&pool->refill);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->keys);
+    free(pool);
+}
@@ -0,0 +1,625 @@
+// metrics.c
+
+#include "secure_comm.h"
+
+#include <stdio.h>      // For fprintf, vsnprintf
+#include <stdlib.h>     // For malloc, realloc, free
+#include <string.h>     // For memset, strncmp
+#include <stdarg.h>     // For va_list
+#include <stdatomic.h>  // For the sharded counters
+#include <pthread.h>    // For the endpoint thread
+#include <time.h>       // For clock_gettime
+#include <errno.h>      // For errno
+#include <poll.h>       // For waiting on the listening socket
+#include <sys/eventfd.h> // For stopping the endpoint thread
+
+// Shards the counters are spread over; a thread always updates the same one
+#define METRICS_SHARDS 16
+
+// Largest HTTP request the endpoint reads before answering
+#define METRICS_REQUEST_MAX 2048
+
+// Live counters of one stage
+typedef struct {
+    _Atomic uint64_t operations;
+    _Atomic uint64_t failures;
+    _Atomic uint64_t bytes_in;
+    _Atomic uint64_t bytes_out;
+    _Atomic uint64_t latency_sum_ns;
+    _Atomic uint64_t latency_max_ns;
+    _Atomic uint64_t latency_buckets[METRICS_HISTOGRAM_BUCKETS];
+} metrics_stage_t;
+
+// One shard, aligned so that two shards never share a cache line
+typedef struct {
+    _Alignas(64) _Atomic uint64_t counters[METRIC_COUNTER_COUNT];
+    metrics_stage_t stages[METRIC_STAGE_COUNT];
+} metrics_shard_t;
+
+static metrics_shard_t shards[METRICS_SHARDS];
+static _Atomic int metrics_on = 1;
+static _Atomic unsigned int next_shard = 0;
+static _Thread_local metrics_shard_t* thread_shard = NULL;
+
+static const char* counter_names[METRIC_COUNTER_COUNT] = {
+    "connections_opened",
+    "connections_closed",
+    "bytes_sent",
+    "bytes_received",
+    "send_calls",
+    "recv_calls",
+    "tls_sessions_resumed",
+    "replays_rejected",
+    "sessions_started",
+    "sessions_resumed",
+    "auth_failures",
+};
+
+static const char* stage_names[METRIC_STAGE_COUNT] = {
+    "encrypt",
+    "decrypt",
+    "compress",
+    "decompress",
+    "tls_handshake",
+    "keygen",
+    "key_derive",
+};
+
+/**
+ * @brief Returns the calling thread's shard, assigning one round-robin on first use.
+ */
+static metrics_shard_t* shard_get(void) {
+    if (thread_shard == NULL) {
+        unsigned int index = atomic_fetch_add_explicit(&next_shard, 1, memory_order_relaxed);
+        thread_shard = &shards[index % METRICS_SHARDS];
+    }
+    return thread_shard;
+}
+
+/**
+ * @brief Maps a duration to its histogram bucket.
+ */
+static size_t bucket_for(uint64_t ns) {
+    const uint64_t sub_count = (uint64_t)1 << METRICS_HISTOGRAM_SUB_BITS;
+    if (ns < sub_count) {
+        return (size_t)ns;
+    }
+    if (ns >= (uint64_t)1 << METRICS_HISTOGRAM_MAX_EXPONENT) {
+        return METRICS_HISTOGRAM_BUCKETS - 1;
+    }
+    unsigned int exponent = 63u - (unsigned int)__builtin_clzll(ns);
+    uint64_t sub = (ns >> (exponent - METRICS_HISTOGRAM_SUB_BITS)) & (sub_count - 1);
+    return ((size_t)(exponent - METRICS_HISTOGRAM_SUB_BITS + 1) << METRICS_HISTOGRAM_SUB_BITS) + (size_t)sub;
+}
+
+/**
+ * @brief Returns the exclusive upper bound, in ns, of a latency bucket.
+ *
+ * @param bucket Bucket index below METRICS_HISTOGRAM_BUCKETS.
+ */
+uint64_t metrics_bucket_upper_ns(size_t bucket) {
+    const size_t sub_count = (size_t)1 << METRICS_HISTOGRAM_SUB_BITS;
+    if (bucket < sub_count) {
+        return (uint64_t)bucket + 1;
+    }
+    unsigned int exponent = (unsigned int)(bucket >> METRICS_HISTOGRAM_SUB_BITS) + METRICS_HISTOGRAM_SUB_BITS - 1;
+    uint64_t width = (uint64_t)1 << (exponent - METRICS_HISTOGRAM_SUB_BITS);
+    uint64_t lower = (uint64_t)(sub_count + (bucket & (sub_count - 1))) * width;
+    return lower + width;
+}
+
+/**
+ * @brief Turns metric collection on or off (on by default).
+ *
+ * @param enabled Non-zero to collect metrics.
+ */
+void metrics_set_enabled(int enabled) {
+    atomic_store_explicit(&metrics_on, enabled ? 1 : 0, memory_order_relaxed);
+}
+
+/**
+ * @brief Reports whether metrics are being collected.
+ */
+int metrics_enabled(void) {
+    return atomic_load_explicit(&metrics_on, memory_order_relaxed);
+}
+
+/**
+ * @brief Monotonic start time for metrics_stage_done, or 0 while metrics are disabled.
+ */
+uint64_t metrics_now_ns(void) {
+    if (!atomic_load_explicit(&metrics_on, memory_order_relaxed)) {
+        return 0;
+    }
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Adds to a counter in the calling thread's shard.
+ *
+ * @param counter The counter.
+ * @param value Amount to add.
+ */
+void metrics_count(MetricCounter counter, uint64_t value) {
+    if (counter < 0 || counter >= METRIC_COUNTER_COUNT ||
+        !atomic_load_explicit(&metrics_on, memory_order_relaxed)) {
+        return;
+    }
+    atomic_fetch_add_explicit(&shard_get()->counters[counter], value, memory_order_relaxed);
+}
+
+/**
+ * @brief Records one finished call of a stage.
+ *
+ * @param stage The stage.
+ * @param start_ns Value of metrics_now_ns taken when the call started.
+ * @param bytes_in Input size, counted only if result is SECURE_COMM_SUCCESS.
+ * @param bytes_out Output size, counted only if result is SECURE_COMM_SUCCESS.
+ * @param result What the call returned; any error counts as a failure.
+ */
+void metrics_stage_done(MetricStage stage, uint64_t start_ns, size_t bytes_in, size_t bytes_out,
+                        SecureCommError result) {
+    // A zero start means metrics were off when the call began
+    if (stage < 0 || stage >= METRIC_STAGE_COUNT || start_ns == 0) {
+        return;
+    }
+    uint64_t end_ns = metrics_now_ns();
+    if (end_ns == 0) {
+        return;
+    }
+    uint64_t elapsed = end_ns > start_ns ? end_ns - start_ns : 0;
+
+    metrics_stage_t* s = &shard_get()->stages[stage];
+    atomic_fetch_add_explicit(&s->operations, 1, memory_order_relaxed);
+    if (result == SECURE_COMM_SUCCESS) {
+        atomic_fetch_add_explicit(&s->bytes_in, bytes_in, memory_order_relaxed);
+        atomic_fetch_add_explicit(&s->bytes_out, bytes_out, memory_order_relaxed);
+    } else {
+        atomic_fetch_add_explicit(&s->failures, 1, memory_order_relaxed);
+    }
+    atomic_fetch_add_explicit(&s->latency_sum_ns, elapsed, memory_order_relaxed);
+    atomic_fetch_add_explicit(&s->latency_buckets[bucket_for(elapsed)], 1, memory_order_relaxed);
+
+    uint64_t max = atomic_load_explicit(&s->latency_max_ns, memory_order_relaxed);
+    while (elapsed > max &&
+           !atomic_compare_exchange_weak_explicit(&s->latency_max_ns, &max, elapsed,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+/**
+ * @brief Sums every shard into a snapshot.
+ *
+ * @param snapshot Pointer to store the totals.
+ */
+void metrics_snapshot(MetricsSnapshot* snapshot) {
+    if (snapshot == NULL) {
+        return;
+    }
+    memset(snapshot, 0, sizeof(MetricsSnapshot));
+
+    for (int i = 0; i < METRICS_SHARDS; i++) {
+        metrics_shard_t* shard = &shards[i];
+        for (int c = 0; c < METRIC_COUNTER_COUNT; c++) {
+            snapshot->counters[c] += atomic_load_explicit(&shard->counters[c], memory_order_relaxed);
+        }
+        for (int st = 0; st < METRIC_STAGE_COUNT; st++) {
+            metrics_stage_t* src = &shard->stages[st];
+            MetricsStageSnapshot* dst = &snapshot->stages[st];
+            dst->operations += atomic_load_explicit(&src->operations, memory_order_relaxed);
+            dst->failures += atomic_load_explicit(&src->failures, memory_order_relaxed);
+            dst->bytes_in += atomic_load_explicit(&src->bytes_in, memory_order_relaxed);
+            dst->bytes_out += atomic_load_explicit(&src->bytes_out, memory_order_relaxed);
+            dst->latency_sum_ns += atomic_load_explicit(&src->latency_sum_ns, memory_order_relaxed);
+            uint64_t max = atomic_load_explicit(&src->latency_max_ns, memory_order_relaxed);
+            if (max > dst->latency_max_ns) {
+                dst->latency_max_ns = max;
+            }
+            for (size_t b = 0; b < METRICS_HISTOGRAM_BUCKETS; b++) {
+                dst->latency_buckets[b] += atomic_load_explicit(&src->latency_buckets[b], memory_order_relaxed);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Zeroes every counter and stage.
+ */
+void metrics_reset(void) {
+    for (int i = 0; i < METRICS_SHARDS; i++) {
+        metrics_shard_t* shard = &shards[i];
+        for (int c = 0; c < METRIC_COUNTER_COUNT; c++) {
+            atomic_store_explicit(&shard->counters[c], 0, memory_order_relaxed);
+        }
+        for (int st = 0; st < METRIC_STAGE_COUNT; st++) {
+            metrics_stage_t* s = &shard->stages[st];
+            atomic_store_explicit(&s->operations, 0, memory_order_relaxed);
+            atomic_store_explicit(&s->failures, 0, memory_order_relaxed);
+            atomic_store_explicit(&s->bytes_in, 0, memory_order_relaxed);
+            atomic_store_explicit(&s->bytes_out, 0, memory_order_relaxed);
+            atomic_store_explicit(&s->latency_sum_ns, 0, memory_order_relaxed);
+            atomic_store_explicit(&s->latency_max_ns, 0, memory_order_relaxed);
+            for (size_t b = 0; b < METRICS_HISTOGRAM_BUCKETS; b++) {
+                atomic_store_explicit(&s->latency_buckets[b], 0, memory_order_relaxed);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Estimates a latency quantile of a stage from its histogram.
+ *
+ * @param stage Stage totals from metrics_snapshot.
+ * @param quantile Quantile between 0 and 1 (for example 0.99).
+ *
+ * @return Upper bound of the bucket holding the quantile in ns (capped at the
+ *         maximum seen), or 0 if the stage has no samples.
+ */
+uint64_t metrics_stage_quantile_ns(const MetricsStageSnapshot* stage, double quantile) {
+    if (stage == NULL) {
+        return 0;
+    }
+    uint64_t total = 0;
+    for (size_t b = 0; b < METRICS_HISTOGRAM_BUCKETS; b++) {
+        total += stage->latency_buckets[b];
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    if (quantile < 0.0) quantile = 0.0;
+    if (quantile > 1.0) quantile = 1.0;
+    uint64_t rank = (uint64_t)(quantile * (double)total + 0.5);
+    if (rank == 0) {
+        rank = 1;
+    }
+
+    uint64_t seen = 0;
+    for (size_t b = 0; b < METRICS_HISTOGRAM_BUCKETS; b++) {
+        seen += stage->latency_buckets[b];
+        if (seen >= rank) {
+            uint64_t upper = metrics_bucket_upper_ns(b);
+            return (stage->latency_max_ns > 0 && upper > stage->latency_max_ns) ? stage->latency_max_ns : upper;
+        }
+    }
+    return stage->latency_max_ns;
+}
+
+/**
+ * @brief Returns the name of a counter as used in the Prometheus output.
+ */
+const char* metrics_counter_name(MetricCounter counter) {
+    return (counter >= 0 && counter < METRIC_COUNTER_COUNT) ? counter_names[counter] : "unknown";
+}
+
+/**
+ * @brief Returns the name of a stage as used in the Prometheus output.
+ */
+const char* metrics_stage_name(MetricStage stage) {
+    return (stage >= 0 && stage < METRIC_STAGE_COUNT) ? stage_names[stage] : "unknown";
+}
+
+// Growable text buffer for the exposition output
+typedef struct {
+    char* data;
+    size_t len;
+    size_t cap;
+    int failed;
+} metrics_text_t;
+
+/**
+ * @brief Appends formatted text, growing the buffer as needed.
+ */
+static void text_append(metrics_text_t* text, const char* format, ...) {
+    if (text->failed) {
+        return;
+    }
+    for (;;) {
+        va_list args;
+        va_start(args, format);
+        int n = vsnprintf(text->data + text->len, text->cap - text->len, format, args);
+        va_end(args);
+        if (n < 0) {
+            text->failed = 1;
+            return;
+        }
+        if ((size_t)n < text->cap - text->len) {
+            text->len += (size_t)n;
+            return;
+        }
+        size_t new_cap = text->cap * 2 > text->len + (size_t)n + 1 ? text->cap * 2 : text->len + (size_t)n + 1;
+        char* grown = (char*)realloc(text->data, new_cap);
+        if (grown == NULL) {
+            text->failed = 1;
+            return;
+        }
+        text->data = grown;
+        text->cap = new_cap;
+    }
+}
+
+/**
+ * @brief Renders the current metrics in the Prometheus text exposition format.
+ *
+ * @param text Pointer to store the NUL-terminated text (caller frees).
+ * @param len Optional pointer to store the text length.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or SECURE_COMM_ERR_MEMORY.
+ */
+SecureCommError metrics_format_prometheus(char** text, size_t* len) {
+    if (text == NULL) {
+        fprintf(stderr, "metrics_format_prometheus: Invalid arguments\n");
+        return SECURE_COMM_ERR_MEMORY;
+    }
+
+    MetricsSnapshot* snap = (MetricsSnapshot*)malloc(sizeof(MetricsSnapshot));
+    metrics_text_t out = { (char*)malloc(16384), 0, 16384, 0 };
+    if (snap == NULL || out.data == NULL) {
+        fprintf(stderr, "metrics_format_prometheus: Failed to allocate memory\n");
+        free(snap);
+        free(out.data);
+        return SECURE_COMM_ERR_MEMORY;
+    }
+    out.data[0] = '\0';
+    metrics_snapshot(snap);
+
+    for (int c = 0; c < METRIC_COUNTER_COUNT; c++) {
+        text_append(&out, "# TYPE secure_comm_%s_total counter\nsecure_comm_%s_total %llu\n",
+                    counter_names[c], counter_names[c], (unsigned long long)snap->counters[c]);
+    }
+    uint64_t opened = snap->counters[METRIC_CONNECTIONS_OPENED];
+    uint64_t closed = snap->counters[METRIC_CONNECTIONS_CLOSED];
+    text_append(&out, "# TYPE secure_comm_connections_active gauge\nsecure_comm_connections_active %llu\n",
+                (unsigned long long)(opened > closed ? opened - closed : 0));
+
+    const MetricsStageSnapshot* compress = &snap->stages[METRIC_STAGE_COMPRESS];
+    text_append(&out, "# TYPE secure_comm_compression_ratio gauge\nsecure_comm_compression_ratio %.6f\n",
+                compress->bytes_in > 0 ? (double)compress->bytes_out / (double)compress->bytes_in : 0.0);
+
+    static const char* stage_counters[] = { "operations", "failures", "bytes_in", "bytes_out" };
+    for (int field = 0; field < 4; field++) {
+        text_append(&out, "# TYPE secure_comm_stage_%s_total counter\n", stage_counters[field]);
+        for (int st = 0; st < METRIC_STAGE_COUNT; st++) {
+            const MetricsStageSnapshot* s = &snap->stages[st];
+            uint64_t values[4] = { s->operations, s->failures, s->bytes_in, s->bytes_out };
+            text_append(&out, "secure_comm_stage_%s_total{stage=\"%s\"} %llu\n",
+                        stage_counters[field], stage_names[st], (unsigned long long)values[field]);
+        }
+    }
+
+    // Fold the sub-buckets into power-of-two bounds; every sub-bucket ends on or below one
+    text_append(&out, "# TYPE secure_comm_stage_duration_seconds histogram\n");
+    for (int st = 0; st < METRIC_STAGE_COUNT; st++) {
+        const MetricsStageSnapshot* s = &snap->stages[st];
+        uint64_t cumulative = 0;
+        size_t b = 0;
+        for (unsigned int exponent = 7; exponent <= METRICS_HISTOGRAM_MAX_EXPONENT; exponent++) {
+            uint64_t bound = (uint64_t)1 << exponent;
+            while (b < METRICS_HISTOGRAM_BUCKETS - 1 && metrics_bucket_upper_ns(b) <= bound) {
+                cumulative += s->latency_buckets[b++];
+            }
+            text_append(&out, "secure_comm_stage_duration_seconds_bucket{stage=\"%s\",le=\"%.9g\"} %llu\n",
+                        stage_names[st], (double)bound / 1e9, (unsigned long long)cumulative);
+        }
+        text_append(&out, "secure_comm_stage_duration_seconds_bucket{stage=\"%s\",le=\"+Inf\"} %llu\n",
+                    stage_names[st], (unsigned long long)s->operations);
+        text_append(&out, "secure_comm_stage_duration_seconds_sum{stage=\"%s\"} %.9f\n",
+                    stage_names[st], (double)s->latency_sum_ns / 1e9);
+        text_append(&out, "secure_comm_stage_duration_seconds_count{stage=\"%s\"} %llu\n",
+                    stage_names[st], (unsigned long long)s->operations);
+    }
+    free(snap);
+
+    if (out.failed) {
+        fprintf(stderr, "metrics_format_prometheus: Failed to grow the output buffer\n");
+        free(out.data);
+        return SECURE_COMM_ERR_MEMORY;
+    }
+    *text = out.data;
+    if (len) {
+        *len = out.len;
+    }
+    return SECURE_COMM_SUCCESS;
+}
+
+// Definition of the opaque MetricsEndpoint structure
+struct MetricsEndpoint {
+    int listen_fd;
+    int stop_fd;        // eventfd written by metrics_endpoint_stop
+    int port;
+    pthread_t thread;
+};
+
+/**
+ * @brief Writes a whole buffer to a blocking socket.
+ */
+static int send_all(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+/**
+ * @brief Reads one request and answers it with the metrics or a 404.
+ */
+static void endpoint_serve(int fd) {
+    // A client that never finishes its request must not stall the endpoint
+    struct timeval timeout = { 1, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    char request[METRICS_REQUEST_MAX + 1];
+    size_t got = 0;
+    while (got < METRICS_REQUEST_MAX) {
+        ssize_t n = recv(fd, request + got, METRICS_REQUEST_MAX - got, 0);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        got += (size_t)n;
+        request[got] = '\0';
+        if (strstr(request, "\r\n\r\n") || strstr(request, "\n\n")) {
+            break;
+        }
+    }
+    request[got] = '\0';
+
+    int is_metrics = strncmp(request, "GET /metrics", 12) == 0 &&
+                     (request[12] == ' ' || request[12] == '?' || request[12] == '\r' || request[12] == '\n');
+    char* body = NULL;
+    size_t body_len = 0;
+    char header[192];
+    if (is_metrics && metrics_format_prometheus(&body, &body_len) == SECURE_COMM_SUCCESS) {
+        int header_len = snprintf(header, sizeof(header),
+                                  "HTTP/1.0 200 OK\r\n"
+                                  "Content-Type: text/plain; version=0.0.4\r\n"
+                                  "Content-Length: %zu\r\n"
+                                  "Connection: close\r\n\r\n", body_len);
+        if (send_all(fd, header, (size_t)header_len) == 0) {
+            send_all(fd, body, body_len);
+        }
+        free(body);
+    } else {
+        const char* reply = is_metrics ? "HTTP/1.0 500 Internal Server Error\r\nContent-Length: 0\r\n\r\n"
+                                       : "HTTP/1.0 404 Not Found\r\nContent-Length: 0\r\n\r\n";
+        send_all(fd, reply, strlen(reply));
+    }
+}
+
+/**
+ * @brief Endpoint thread: accepts and answers requests until stopped.
+ */
+static void* endpoint_thread(void* arg) {
+    MetricsEndpoint* endpoint = (MetricsEndpoint*)arg;
+    struct pollfd fds[2];
+    fds[0].fd = endpoint->listen_fd;
+    fds[0].events = POLLIN;
+    fds[1].fd = endpoint->stop_fd;
+    fds[1].events = POLLIN;
+
+    for (;;) {
+        fds[0].revents = 0;
+        fds[1].revents = 0;
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        if (fds[1].revents) {
+            break;
+        }
+        if (fds[0].revents & POLLIN) {
+            int fd = accept(endpoint->listen_fd, NULL, NULL);
+            if (fd >= 0) {
+                endpoint_serve(fd);
+                close(fd);
+            }
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Serves GET /metrics from a background thread.
+ *
+ * @param address IPv4 address to listen on, or NULL for 127.0.0.1.
+ * @param port Port to listen on, or 0 to pick a free one (see metrics_endpoint_port).
+ * @param endpoint Pointer to store the created MetricsEndpoint.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError metrics_endpoint_start(const char* address, int port, MetricsEndpoint** endpoint) {
+    if (endpoint == NULL || port < 0 || port > 65535) {
+        fprintf(stderr, "metrics_endpoint_start: Invalid arguments\n");
+        return SECURE_COMM_ERR_SOCKET;
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    if (inet_pton(AF_INET, address ? address : "127.0.0.1", &addr.sin_addr) != 1) {
+        fprintf(stderr, "metrics_endpoint_start: Invalid address '%s'\n", address);
+        return SECURE_COMM_ERR_ADDRESS;
+    }
+
+    MetricsEndpoint* ep = (MetricsEndpoint*)calloc(1, sizeof(MetricsEndpoint));
+    if (ep == NULL) {
+        fprintf(stderr, "metrics_endpoint_start: Failed to allocate memory for endpoint\n");
+        return SECURE_COMM_ERR_MEMORY;
+    }
+
+    ep->listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    ep->stop_fd = eventfd(0, EFD_CLOEXEC);
+    if (ep->listen_fd < 0 || ep->stop_fd < 0) {
+        fprintf(stderr, "metrics_endpoint_start: Failed to create sockets: %s\n", strerror(errno));
+        if (ep->listen_fd >= 0) close(ep->listen_fd);
+        if (ep->stop_fd >= 0) close(ep->stop_fd);
+        free(ep);
+        return SECURE_COMM_ERR_SOCKET;
+    }
+
+    int opt = 1;
+    setsockopt(ep->listen_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    socklen_t addr_len = sizeof(addr);
+    if (bind(ep->listen_fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(ep->listen_fd, 16) != 0 ||
+        getsockname(ep->listen_fd, (struct sockaddr*)&addr, &addr_len) != 0) {
+        fprintf(stderr, "metrics_endpoint_start: Failed to listen on port %d: %s\n", port, strerror(errno));
+        close(ep->listen_fd);
+        close(ep->stop_fd);
+        free(ep);
+        return SECURE_COMM_ERR_SOCKET;
+    }
+    ep->port = ntohs(addr.sin_port);
+
+    if (pthread_create(&ep->thread, NULL, endpoint_thread, ep) != 0) {
+        fprintf(stderr, "metrics_endpoint_start: Failed to start endpoint thread\n");
+        close(ep->listen_fd);
+        close(ep->stop_fd);
+        free(ep);
+        return SECURE_COMM_ERR_INIT;
+    }
+
+    *endpoint = ep;
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Returns the port the endpoint is listening on.
+ */
+int metrics_endpoint_port(const MetricsEndpoint* endpoint) {
+    return endpoint ? endpoint->port : -1;
+}
+
+/**
+ * @brief Stops the endpoint thread and closes its socket.
+ *
+ * @param endpoint The endpoint to stop.
+ */
+void metrics_endpoint_stop(MetricsEndpoint* endpoint) {
+    if (endpoint == NULL) {
+        return;
+    }
+    uint64_t one = 1;
+    if (write(endpoint->stop_fd, &one, sizeof(one)) != (ssize_t)sizeof(one)) {
+        fprintf(stderr, "metrics_endpoint_stop: Failed to wake endpoint thread\n");
+    }
+    pthread_join(endpoint->thread, NULL);
+    close(endpoint->listen_fd);
+    close(endpoint->stop_fd);
+    free(endpoint);
+}
@@ -0,0 +1,1096 @@
+// mux.c
+
+#include "secure_comm.h"
+
+#include <stdio.h>      // For fprintf
+#include <stdlib.h>     // For malloc, calloc, realloc, free
+#include <string.h>     // For memcpy, memset
+#include <pthread.h>    // For the reader and writer threads and the connection lock
+#include <errno.h>      // For ETIMEDOUT
+#include <time.h>       // For clock_gettime
+
+// Header at the start of every FRAME_TYPE_MUX plaintext:
+// stream id (4, network order) | kind (1) | flags (1) | priority (1) | reserved (1)
+#define MUX_HEADER_SIZE 8
+
+// Where the inner header starts in an outgoing frame buffer
+#define MUX_BODY_OFFSET (SECURE_FRAME_HEADER_SIZE + SECURE_RECORD_OVERHEAD)
+
+// Kinds of inner frames
+#define MUX_KIND_DATA 0     // Stream bytes; the first one opens the stream
+#define MUX_KIND_WINDOW 1   // Grants the peer more window on a stream (4-byte increment)
+#define MUX_KIND_RESET 2    // Aborts a stream
+
+// MUX_KIND_DATA flag: the sender will write nothing more on the stream
+#define MUX_FLAG_END 0x01
+
+// Highest stream id; ids are never reused on a connection
+#define MUX_MAX_STREAM_ID 0x7FFFFFFFu
+
+/**
+ * @brief One frame waiting to be sent, built with room for the frame header and record overhead.
+ */
+typedef struct mux_out {
+    struct mux_out* next;
+    size_t len;                 // Body length
+    unsigned char frame[];      // Frame header | IV | tag | inner header | body
+} mux_out_t;
+
+/**
+ * @brief Received stream bytes waiting to be read.
+ */
+typedef struct mux_chunk {
+    struct mux_chunk* next;
+    size_t len;
+    size_t offset;              // Bytes already read
+    unsigned char data[];
+} mux_chunk_t;
+
+// Definition of the opaque MuxStream structure; all fields are protected by the connection lock
+struct MuxStream {
+    MuxConnection* mux;
+    uint32_t id;
+    uint8_t priority;
+    int from_peer;              // Opened by the peer (counts against max_streams)
+    pthread_cond_t readable;    // Data, end of stream or reset arrived
+    pthread_cond_t writable;    // Window granted or stream reset
+
+    // Sending
+    mux_out_t* out_head;        // Frames waiting for the writer
+    mux_out_t* out_tail;
+    int64_t send_window;        // Bytes the peer will still accept
+    int scheduled;              // On the writer's ready list
+    struct MuxStream* ready_next;
+    int local_closed;           // END queued
+
+    // Receiving
+    mux_chunk_t* in_head;
+    mux_chunk_t* in_tail;
+    size_t buffered;            // Bytes waiting to be read
+    uint32_t recv_window;       // Bytes the peer may still send
+    uint32_t consumed;          // Read since the last window grant
+    int remote_closed;          // END received
+
+    struct MuxStream* accept_next;
+    int reset;                  // Aborted by either side
+    int released;               // Handle released; freed once its queue is sent
+};
+
+// Definition of the opaque MuxConnection structure
+struct MuxConnection {
+    MuxConfig config;
+    SecureConnection* conn;
+    SecureCipher* seal;         // Used by the writer thread only
+    SecureCipher* open;         // Used by the reader thread only
+    ReplayWindow* replay;
+
+    pthread_mutex_t lock;       // Protects the fields below and every stream
+    pthread_cond_t work;        // Writer: frames queued, closing or failed
+    pthread_cond_t incoming;    // mux_accept: a peer stream arrived or the connection ended
+    pthread_cond_t drained;     // mux_destroy: every queue has been sent
+
+    MuxStream** streams;        // Streams not yet released
+    size_t stream_count;
+    size_t stream_capacity;
+    mux_out_t* control_head;    // Window grants and resets, sent before any data
+    mux_out_t* control_tail;
+    MuxStream* ready_head;      // Streams with queued frames
+    MuxStream* ready_tail;
+    MuxStream* accept_head;     // Peer streams not yet accepted
+    MuxStream* accept_tail;
+    size_t peer_streams;        // Peer-opened streams not yet released
+    uint32_t next_id;           // Next id for a local stream's first frame
+    uint32_t last_peer_id;      // Highest id the peer has opened
+    int closing;                // mux_destroy has begun
+    int failed;                 // The connection failed or ended
+    MuxStats stats;
+
+    pthread_t reader;
+    pthread_t writer;
+};
+
+static void put_be32(unsigned char* out, uint32_t value) {
+    out[0] = (unsigned char)(value >> 24);
+    out[1] = (unsigned char)(value >> 16);
+    out[2] = (unsigned char)(value >> 8);
+    out[3] = (unsigned char)value;
+}
+
+static uint32_t get_be32(const unsigned char* in) {
+    return ((uint32_t)in[0] << 24) | ((uint32_t)in[1] << 16) | ((uint32_t)in[2] << 8) | (uint32_t)in[3];
+}
+
+/**
+ * @brief Fills a MuxConfig with the defaults.
+ *
+ * @param config The configuration to fill.
+ */
+void mux_config_defaults(MuxConfig* config) {
+    if (config == NULL) {
+        return;
+    }
+    memset(config, 0, sizeof(MuxConfig));
+    config->initial_window = 256 * 1024;
+    config->max_frame_payload = 16 * 1024;
+    config->max_streams = 128;
+}
+
+/**
+ * @brief Builds an outgoing frame with its inner header and body filled in.
+ */
+static mux_out_t* out_alloc(uint32_t id, uint8_t kind, uint8_t flags, uint8_t priority,
+                            const void* body, size_t len) {
+    mux_out_t* out = (mux_out_t*)malloc(sizeof(mux_out_t) + MUX_BODY_OFFSET + MUX_HEADER_SIZE + len);
+    if (out == NULL) {
+        fprintf(stderr, "mux: Failed to allocate a %zu-byte frame\n", len);
+        return NULL;
+    }
+    out->next = NULL;
+    out->len = len;
+    unsigned char* header = out->frame + MUX_BODY_OFFSET;
+    put_be32(header, id);
+    header[4] = kind;
+    header[5] = flags;
+    header[6] = priority;
+    header[7] = 0;
+    if (len > 0) {
+        memcpy(header + MUX_HEADER_SIZE, body, len);
+    }
+    return out;
+}
+
+/**
+ * @brief Queues a window grant or reset ahead of all stream data. Caller holds the lock.
+ */
+static void queue_control(MuxConnection* mux, uint32_t id, uint8_t kind, const void* body, size_t len) {
+    mux_out_t* out = out_alloc(id, kind, 0, 0, body, len);
+    if (out == NULL) {
+        return;
+    }
+    if (mux->control_tail) {
+        mux->control_tail->next = out;
+    } else {
+        mux->control_head = out;
+    }
+    mux->control_tail = out;
+    pthread_cond_signal(&mux->work);
+}
+
+/**
+ * @brief Appends a frame to a stream's queue and puts the stream on the ready list. Caller holds the lock.
+ */
+static void queue_stream(MuxStream* stream, mux_out_t* out) {
+    MuxConnection* mux = stream->mux;
+    if (stream->out_tail) {
+        stream->out_tail->next = out;
+    } else {
+        stream->out_head = out;
+    }
+    stream->out_tail = out;
+
+    if (!stream->scheduled) {
+        stream->scheduled = 1;
+        stream->ready_next = NULL;
+        if (mux->ready_tail) {
+            mux->ready_tail->ready_next = stream;
+        } else {
+            mux->ready_head = stream;
+        }
+        mux->ready_tail = stream;
+    }
+    pthread_cond_signal(&mux->work);
+}
+
+/**
+ * @brief Takes a stream off the ready list. Caller holds the lock.
+ */
+static void unschedule(MuxConnection* mux, MuxStream* stream, MuxStream* prev) {
+    if (prev) {
+        prev->ready_next = stream->ready_next;
+    } else {
+        mux->ready_head = stream->ready_next;
+    }
+    if (mux->ready_tail == stream) {
+        mux->ready_tail = prev;
+    }
+    stream->ready_next = NULL;
+    stream->scheduled = 0;
+}
+
+/**
+ * @brief Frees a stream's queued frames and buffered data, its conditions and the stream.
+ */
+static void stream_free(MuxStream* stream) {
+    while (stream->out_head) {
+        mux_out_t* next = stream->out_head->next;
+        free(stream->out_head);
+        stream->out_head = next;
+    }
+    while (stream->in_head) {
+        mux_chunk_t* next = stream->in_head->next;
+        free(stream->in_head);
+        stream->in_head = next;
+    }
+    pthread_cond_destroy(&stream->readable);
+    pthread_cond_destroy(&stream->writable);
+    free(stream);
+}
+
+/**
+ * @brief Drops a stream's queued frames and takes it off the ready list. Caller holds the lock.
+ */
+static void discard_outgoing(MuxConnection* mux, MuxStream* stream) {
+    while (stream->out_head) {
+        mux_out_t* next = stream->out_head->next;
+        free(stream->out_head);
+        stream->out_head = next;
+    }
+    stream->out_tail = NULL;
+    if (stream->scheduled) {
+        MuxStream* prev = NULL;
+        for (MuxStream* s = mux->ready_head; s != stream; s = s->ready_next) {
+            prev = s;
+        }
+        unschedule(mux, stream, prev);
+    }
+}
+
+/**
+ * @brief Marks a stream reset, drops its queue and wakes its readers and writers. Caller holds the lock.
+ */
+static void stream_abort(MuxConnection* mux, MuxStream* stream) {
+    stream->reset = 1;
+    discard_outgoing(mux, stream);
+    pthread_cond_broadcast(&stream->readable);
+    pthread_cond_broadcast(&stream->writable);
+}
+
+static MuxStream* find_stream(MuxConnection* mux, uint32_t id) {
+    for (size_t i = 0; i < mux->stream_count; i++) {
+        if (mux->streams[i]->id == id) {
+            return mux->streams[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Creates a stream and adds it to the table. Caller holds the lock.
+ */
+static MuxStream* stream_new(MuxConnection* mux, uint32_t id, uint8_t priority) {
+    if (mux->stream_count == mux->stream_capacity) {
+        size_t capacity = mux->stream_capacity ? mux->stream_capacity * 2 : 16;
+        MuxStream** streams = (MuxStream**)realloc(mux->streams, capacity * sizeof(MuxStream*));
+        if (streams == NULL) {
+            return NULL;
+        }
+        mux->streams = streams;
+        mux->stream_capacity = capacity;
+    }
+
+    MuxStream* stream = (MuxStream*)calloc(1, sizeof(MuxStream));
+    if (stream == NULL) {
+        return NULL;
+    }
+    stream->mux = mux;
+    stream->id = id;
+    stream->priority = priority;
+    stream->send_window = mux->config.initial_window;
+    stream->recv_window = mux->config.initial_window;
+    pthread_cond_init(&stream->readable, NULL);
+    pthread_cond_init(&stream->writable, NULL);
+    mux->streams[mux->stream_count++] = stream;
+    return stream;
+}
+
+static void remove_stream(MuxConnection* mux, MuxStream* stream) {
+    for (size_t i = 0; i < mux->stream_count; i++) {
+        if (mux->streams[i] == stream) {
+            mux->streams[i] = mux->streams[--mux->stream_count];
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Marks the connection failed and wakes every waiting thread. Caller holds the lock.
+ */
+static void mux_fail(MuxConnection* mux) {
+    mux->failed = 1;
+    for (size_t i = 0; i < mux->stream_count; i++) {
+        pthread_cond_broadcast(&mux->streams[i]->readable);
+        pthread_cond_broadcast(&mux->streams[i]->writable);
+    }
+    pthread_cond_broadcast(&mux->work);
+    pthread_cond_broadcast(&mux->incoming);
+    pthread_cond_broadcast(&mux->drained);
+}
+
+/**
+ * @brief Picks the next frame: control frames first, then the most urgent stream.
+ *
+ * The first stream with the lowest priority value wins and moves to the back of the
+ * ready list, so streams of equal priority take turns frame by frame. Caller holds the lock.
+ */
+static mux_out_t* next_frame(MuxConnection* mux) {
+    mux_out_t* out = mux->control_head;
+    if (out) {
+        mux->control_head = out->next;
+        if (mux->control_head == NULL) {
+            mux->control_tail = NULL;
+        }
+        return out;
+    }
+
+    MuxStream* best = NULL;
+    MuxStream* best_prev = NULL;
+    MuxStream* prev = NULL;
+    for (MuxStream* s = mux->ready_head; s != NULL; prev = s, s = s->ready_next) {
+        if (best == NULL || s->priority < best->priority) {
+            best = s;
+            best_prev = prev;
+        }
+    }
+    if (best == NULL) {
+        return NULL;
+    }
+
+    // Ids are taken in the order streams first reach the wire, so the peer sees them rising
+    if (best->id == 0) {
+        best->id = mux->next_id;
+        mux->next_id += 2;
+    }
+    out = best->out_head;
+    put_be32(out->frame + MUX_BODY_OFFSET, best->id);
+    best->out_head = out->next;
+    if (best->out_head == NULL) {
+        best->out_tail = NULL;
+    }
+    unschedule(mux, best, best_prev);
+
+    if (best->out_head) {
+        // Back of the line: equal priorities share the link
+        best->scheduled = 1;
+        if (mux->ready_tail) {
+            mux->ready_tail->ready_next = best;
+        } else {
+            mux->ready_head = best;
+        }
+        mux->ready_tail = best;
+    } else if (best->released) {
+        stream_free(best);
+    }
+    return out;
+}
+
+/**
+ * @brief Writer thread: seals and sends queued frames until the connection closes or fails.
+ */
+static void* mux_writer(void* arg) {
+    MuxConnection* mux = (MuxConnection*)arg;
+
+    pthread_mutex_lock(&mux->lock);
+    while (!mux->failed) {
+        mux_out_t* out = next_frame(mux);
+        if (out == NULL) {
+            pthread_cond_broadcast(&mux->drained);
+            if (mux->closing) {
+                break;
+            }
+            pthread_cond_wait(&mux->work, &mux->lock);
+            continue;
+        }
+        pthread_mutex_unlock(&mux->lock);
+
+        // Taken before sealing, which encrypts the inner header in place
+        uint8_t kind = out->frame[MUX_BODY_OFFSET + 4];
+        unsigned char* record = out->frame + SECURE_FRAME_HEADER_SIZE;
+        size_t record_len = 0;
+        ssize_t sent = 0;
+        SecureCommError ret = cipher_seal_record(mux->seal, record, MUX_HEADER_SIZE + out->len, &record_len);
+        if (ret == SECURE_COMM_SUCCESS) {
+            FrameHeader header = { (uint32_t)record_len, FRAME_TYPE_MUX, 0, COMPRESSION_CODEC_NONE,
+                                   (uint8_t)cipher_get_suite(mux->seal) };
+            frame_encode_header(&header, out->frame);
+            ret = secure_send(mux->conn, out->frame, SECURE_FRAME_HEADER_SIZE + record_len, &sent);
+        }
+        size_t len = out->len;
+        free(out);
+
+        pthread_mutex_lock(&mux->lock);
+        if (ret != SECURE_COMM_SUCCESS) {
+            if (!mux->closing) {
+                fprintf(stderr, "mux_writer: Sending a frame failed with error %d\n", ret);
+            }
+            mux_fail(mux);
+            break;
+        }
+        mux->stats.frames_sent++;
+        if (kind == MUX_KIND_DATA) {
+            mux->stats.bytes_sent += len;
+        } else if (kind == MUX_KIND_WINDOW) {
+            mux->stats.window_updates++;
+        } else if (kind == MUX_KIND_RESET) {
+            mux->stats.resets_sent++;
+        }
+    }
+    pthread_mutex_unlock(&mux->lock);
+    return NULL;
+}
+
+/**
+ * @brief Applies one opened inner frame. Caller holds the lock.
+ *
+ * @return SECURE_COMM_SUCCESS, or SECURE_COMM_ERR_FRAME for a protocol violation.
+ */
+static SecureCommError handle_frame(MuxConnection* mux, const unsigned char* payload, size_t payload_len) {
+    if (payload_len < MUX_HEADER_SIZE) {
+        fprintf(stderr, "mux_reader: Frame of %zu bytes is too short\n", payload_len);
+        return SECURE_COMM_ERR_FRAME;
+    }
+    uint32_t id = get_be32(payload);
+    uint8_t kind = payload[4];
+    uint8_t flags = payload[5];
+    uint8_t priority = payload[6];
+    const unsigned char* body = payload + MUX_HEADER_SIZE;
+    size_t body_len = payload_len - MUX_HEADER_SIZE;
+    mux->stats.frames_received++;
+    if (id == 0) {
+        return SECURE_COMM_SUCCESS;
+    }
+    MuxStream* stream = find_stream(mux, id);
+
+    switch (kind) {
+    case MUX_KIND_DATA:
+        if (stream == NULL) {
+            // Peer ids have the other parity; an id at or below the last one is a closed stream
+            int peer_id = (id & 1u) != (mux->next_id & 1u);
+            if (!peer_id || id <= mux->last_peer_id) {
+                return SECURE_COMM_SUCCESS;
+            }
+            mux->last_peer_id = id;
+            if (mux->peer_streams >= mux->config.max_streams || mux->closing ||
+                (stream = stream_new(mux, id, priority)) == NULL) {
+                mux->stats.streams_refused++;
+                queue_control(mux, id, MUX_KIND_RESET, NULL, 0);
+                return SECURE_COMM_SUCCESS;
+            }
+            stream->from_peer = 1;
+            mux->peer_streams++;
+            mux->stats.streams_accepted++;
+            if (mux->accept_tail) {
+                mux->accept_tail->accept_next = stream;
+            } else {
+                mux->accept_head = stream;
+            }
+            mux->accept_tail = stream;
+            pthread_cond_signal(&mux->incoming);
+        }
+        if (stream->reset || stream->remote_closed) {
+            return SECURE_COMM_SUCCESS;
+        }
+        if (body_len > stream->recv_window) {
+            fprintf(stderr, "mux_reader: Stream %u overran its window\n", id);
+            stream_abort(mux, stream);
+            queue_control(mux, id, MUX_KIND_RESET, NULL, 0);
+            return SECURE_COMM_SUCCESS;
+        }
+        if (body_len > 0) {
+            mux_chunk_t* chunk = (mux_chunk_t*)malloc(sizeof(mux_chunk_t) + body_len);
+            if (chunk == NULL) {
+                fprintf(stderr, "mux_reader: Failed to buffer %zu bytes\n", body_len);
+                stream_abort(mux, stream);
+                queue_control(mux, id, MUX_KIND_RESET, NULL, 0);
+                return SECURE_COMM_SUCCESS;
+            }
+            chunk->next = NULL;
+            chunk->len = body_len;
+            chunk->offset = 0;
+            memcpy(chunk->data, body, body_len);
+            if (stream->in_tail) {
+                stream->in_tail->next = chunk;
+            } else {
+                stream->in_head = chunk;
+            }
+            stream->in_tail = chunk;
+            stream->buffered += body_len;
+            stream->recv_window -= (uint32_t)body_len;
+            mux->stats.bytes_received += body_len;
+        }
+        if (flags & MUX_FLAG_END) {
+            stream->remote_closed = 1;
+        }
+        pthread_cond_broadcast(&stream->readable);
+        return SECURE_COMM_SUCCESS;
+
+    case MUX_KIND_WINDOW:
+        if (body_len != 4) {
+            fprintf(stderr, "mux_reader: Malformed window update\n");
+            return SECURE_COMM_ERR_FRAME;
+        }
+        if (stream != NULL && !stream->reset) {
+            stream->send_window += get_be32(body);
+            pthread_cond_broadcast(&stream->writable);
+        }
+        return SECURE_COMM_SUCCESS;
+
+    case MUX_KIND_RESET:
+        if (stream != NULL && !stream->reset) {
+            stream->remote_closed = 1;
+            stream_abort(mux, stream);
+            mux->stats.resets_received++;
+        }
+        return SECURE_COMM_SUCCESS;
+
+    default:
+        fprintf(stderr, "mux_reader: Unknown frame kind %u\n", kind);
+        return SECURE_COMM_ERR_FRAME;
+    }
+}
+
+/**
+ * @brief Reader thread: opens incoming frames and hands them to their streams.
+ */
+static void* mux_reader(void* arg) {
+    MuxConnection* mux = (MuxConnection*)arg;
+    size_t max_record = SECURE_RECORD_OVERHEAD + MUX_HEADER_SIZE + mux->config.max_frame_payload;
+    FrameDecoder* decoder = NULL;
+    unsigned char* record = (unsigned char*)malloc(max_record);
+    SecureCommError ret = record == NULL ? SECURE_COMM_ERR_MEMORY : frame_decoder_create(0, max_record, &decoder);
+
+    while (ret == SECURE_COMM_SUCCESS) {
+        unsigned char* space = NULL;
+        size_t space_len = 0;
+        ssize_t received = 0;
+        frame_decoder_write_space(decoder, &space, &space_len);
+        ret = secure_recv(mux->conn, space, space_len, &received);
+        if (ret != SECURE_COMM_SUCCESS) {
+            break;
+        }
+        frame_decoder_commit(decoder, (size_t)received);
+
+        FrameHeader header;
+        while ((ret = frame_decoder_next(decoder, &header, record, max_record)) == SECURE_COMM_SUCCESS) {
+            unsigned char* payload = NULL;
+            size_t payload_len = 0;
+            if (header.type != FRAME_TYPE_MUX) {
+                fprintf(stderr, "mux_reader: Unexpected frame type %u\n", header.type);
+                ret = SECURE_COMM_ERR_FRAME;
+                break;
+            }
+            ret = cipher_open_record(mux->open, record, header.length, &payload, &payload_len);
+            if (ret == SECURE_COMM_SUCCESS && mux->replay &&
+                replay_window_accept(mux->replay, nonce_sequence(record)) != SECURE_COMM_SUCCESS) {
+                ret = SECURE_COMM_ERR_DECRYPT;
+            }
+            if (ret != SECURE_COMM_SUCCESS) {
+                fprintf(stderr, "mux_reader: Dropping the connection after a record failed to open\n");
+                break;
+            }
+
+            pthread_mutex_lock(&mux->lock);
+            ret = handle_frame(mux, payload, payload_len);
+            pthread_mutex_unlock(&mux->lock);
+            if (ret != SECURE_COMM_SUCCESS) {
+                break;
+            }
+        }
+        if (ret == SECURE_COMM_ERR_AGAIN) {
+            ret = SECURE_COMM_SUCCESS;
+        }
+    }
+
+    frame_decoder_destroy(decoder);
+    free(record);
+
+    pthread_mutex_lock(&mux->lock);
+    mux_fail(mux);
+    pthread_mutex_unlock(&mux->lock);
+    return NULL;
+}
+
+/**
+ * @brief Starts multiplexing streams over an established connection.
+ *
+ * @param conn Established connection (not owned).
+ * @param seal Cipher sealing outgoing frames (not owned).
+ * @param open Cipher opening incoming frames (not owned).
+ * @param replay Optional replay window checked for every incoming frame (NULL to skip).
+ * @param initiator Non-zero on the side that opened the connection.
+ * @param config Settings, or NULL for the defaults.
+ * @param mux Pointer to store the new MuxConnection.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError mux_create(SecureConnection* conn, SecureCipher* seal, SecureCipher* open, ReplayWindow* replay,
+                           int initiator, const MuxConfig* config, MuxConnection** mux) {
+    if (conn == NULL || seal == NULL || open == NULL || mux == NULL) {
+        fprintf(stderr, "mux_create: Invalid arguments\n");
+        return SECURE_COMM_ERR_INIT;
+    }
+
+    MuxConfig cfg;
+    if (config != NULL) {
+        cfg = *config;
+    } else {
+        mux_config_defaults(&cfg);
+    }
+    if (cfg.initial_window == 0 || cfg.max_frame_payload == 0 || cfg.max_frame_payload > SECURE_FRAME_DEFAULT_MAX_PAYLOAD) {
+        fprintf(stderr, "mux_create: Invalid window or frame size\n");
+        return SECURE_COMM_ERR_INIT;
+    }
+
+    MuxConnection* m = (MuxConnection*)calloc(1, sizeof(MuxConnection));
+    if (m == NULL) {
+        fprintf(stderr, "mux_create: Failed to allocate memory\n");
+        return SECURE_COMM_ERR_MEMORY;
+    }
+    m->config = cfg;
+    m->conn = conn;
+    m->seal = seal;
+    m->open = open;
+    m->replay = replay;
+    m->next_id = initiator ? 1 : 2;
+    pthread_mutex_init(&m->lock, NULL);
+    pthread_cond_init(&m->work, NULL);
+    pthread_cond_init(&m->incoming, NULL);
+    pthread_cond_init(&m->drained, NULL);
+
+    if (pthread_create(&m->writer, NULL, mux_writer, m) != 0) {
+        fprintf(stderr, "mux_create: Failed to start the writer thread\n");
+        pthread_cond_destroy(&m->work);
+        pthread_cond_destroy(&m->incoming);
+        pthread_cond_destroy(&m->drained);
+        pthread_mutex_destroy(&m->lock);
+        free(m);
+        return SECURE_COMM_ERR_INIT;
+    }
+    if (pthread_create(&m->reader, NULL, mux_reader, m) != 0) {
+        fprintf(stderr, "mux_create: Failed to start the reader thread\n");
+        pthread_mutex_lock(&m->lock);
+        m->closing = 1;
+        pthread_cond_signal(&m->work);
+        pthread_mutex_unlock(&m->lock);
+        pthread_join(m->writer, NULL);
+        pthread_cond_destroy(&m->work);
+        pthread_cond_destroy(&m->incoming);
+        pthread_cond_destroy(&m->drained);
+        pthread_mutex_destroy(&m->lock);
+        free(m);
+        return SECURE_COMM_ERR_INIT;
+    }
+
+    *mux = m;
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Opens a new stream. Nothing is sent until the first write or close.
+ *
+ * @param mux The MuxConnection.
+ * @param priority Send priority; lower values go first.
+ * @param stream Pointer to store the new stream.
+ *
+ * @return SECURE_COMM_SUCCESS on success, SECURE_COMM_ERR_SESSION if the connection has
+ *         failed or is closing, or another negative error code.
+ */
+SecureCommError mux_stream_open(MuxConnection* mux, uint8_t priority, MuxStream** stream) {
+    if (mux == NULL || stream == NULL) {
+        fprintf(stderr, "mux_stream_open: Invalid arguments\n");
+        return SECURE_COMM_ERR_SESSION;
+    }
+
+    pthread_mutex_lock(&mux->lock);
+    if (mux->failed || mux->closing || mux->next_id > MUX_MAX_STREAM_ID) {
+        pthread_mutex_unlock(&mux->lock);
+        return SECURE_COMM_ERR_SESSION;
+    }
+    // The id is assigned when the stream's first frame is sent
+    MuxStream* s = stream_new(mux, 0, priority);
+    if (s == NULL) {
+        pthread_mutex_unlock(&mux->lock);
+        fprintf(stderr, "mux_stream_open: Failed to allocate a stream\n");
+        return SECURE_COMM_ERR_MEMORY;
+    }
+    mux->stats.streams_opened++;
+    pthread_mutex_unlock(&mux->lock);
+
+    *stream = s;
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Computes the absolute deadline for a positive timeout.
+ */
+static void deadline_after(int timeout_ms, struct timespec* deadline) {
+    clock_gettime(CLOCK_REALTIME, deadline);
+    deadline->tv_sec += timeout_ms / 1000;
+    deadline->tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+    if (deadline->tv_nsec >= 1000000000L) {
+        deadline->tv_sec++;
+        deadline->tv_nsec -= 1000000000L;
+    }
+}
+
+/**
+ * @brief Waits on a condition of the connection lock, honouring a timeout.
+ *
+ * @return 0 to check again, or 1 once the wait has timed out.
+ */
+static int wait_for(pthread_cond_t* cond, MuxConnection* mux, int timeout_ms, const struct timespec* deadline) {
+    if (timeout_ms == 0) {
+        return 1;
+    }
+    if (timeout_ms < 0) {
+        pthread_cond_wait(cond, &mux->lock);
+        return 0;
+    }
+    return pthread_cond_timedwait(cond, &mux->lock, deadline) == ETIMEDOUT;
+}
+
+/**
+ * @brief Takes the next stream opened by the peer.
+ *
+ * @param mux The MuxConnection.
+ * @param timeout_ms Milliseconds to wait; 0 returns at once, negative waits indefinitely.
+ * @param stream Pointer to store the stream.
+ *
+ * @return SECURE_COMM_SUCCESS on success, SECURE_COMM_ERR_AGAIN on timeout, or
+ *         SECURE_COMM_ERR_RECV once the connection has ended.
+ */
+SecureCommError mux_accept(MuxConnection* mux, int timeout_ms, MuxStream** stream) {
+    if (mux == NULL || stream == NULL) {
+        fprintf(stderr, "mux_accept: Invalid arguments\n");
+        return SECURE_COMM_ERR_RECV;
+    }
+
+    struct timespec deadline;
+    if (timeout_ms > 0) {
+        deadline_after(timeout_ms, &deadline);
+    }
+
+    pthread_mutex_lock(&mux->lock);
+    while (mux->accept_head == NULL && !mux->failed && !mux->closing) {
+        if (wait_for(&mux->incoming, mux, timeout_ms, &deadline)) {
+            break;
+        }
+    }
+
+    SecureCommError ret;
+    MuxStream* s = mux->accept_head;
+    if (s != NULL) {
+        mux->accept_head = s->accept_next;
+        if (mux->accept_head == NULL) {
+            mux->accept_tail = NULL;
+        }
+        s->accept_next = NULL;
+        *stream = s;
+        ret = SECURE_COMM_SUCCESS;
+    } else {
+        ret = mux->failed || mux->closing ? SECURE_COMM_ERR_RECV : SECURE_COMM_ERR_AGAIN;
+    }
+    pthread_mutex_unlock(&mux->lock);
+    return ret;
+}
+
+/**
+ * @brief Queues data on a stream, waiting for window as needed.
+ *
+ * @param stream The stream.
+ * @param data Bytes to send.
+ * @param len Number of bytes.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or SECURE_COMM_ERR_SEND if the stream was
+ *         closed for writing or reset, or the connection failed.
+ */
+SecureCommError mux_stream_write(MuxStream* stream, const void* data, size_t len) {
+    if (stream == NULL || (data == NULL && len > 0)) {
+        fprintf(stderr, "mux_stream_write: Invalid arguments\n");
+        return SECURE_COMM_ERR_SEND;
+    }
+    MuxConnection* mux = stream->mux;
+    const unsigned char* bytes = (const unsigned char*)data;
+    size_t offset = 0;
+    SecureCommError ret = SECURE_COMM_SUCCESS;
+
+    pthread_mutex_lock(&mux->lock);
+    while (offset < len) {
+        while (stream->send_window <= 0 && !stream->reset && !mux->failed && !mux->closing) {
+            pthread_cond_wait(&stream->writable, &mux->lock);
+        }
+        if (stream->reset || stream->local_closed || mux->failed || mux->closing) {
+            ret = SECURE_COMM_ERR_SEND;
+            break;
+        }
+
+        size_t chunk = len - offset;
+        if (chunk > mux->config.max_frame_payload) {
+            chunk = mux->config.max_frame_payload;
+        }
+        if ((int64_t)chunk > stream->send_window) {
+            chunk = (size_t)stream->send_window;
+        }
+        mux_out_t* out = out_alloc(stream->id, MUX_KIND_DATA, 0, stream->priority, bytes + offset, chunk);
+        if (out == NULL) {
+            ret = SECURE_COMM_ERR_MEMORY;
+            break;
+        }
+        stream->send_window -= (int64_t)chunk;
+        queue_stream(stream, out);
+        offset += chunk;
+    }
+    pthread_mutex_unlock(&mux->lock);
+    return ret;
+}
+
+/**
+ * @brief Ends the sending half of a stream.
+ *
+ * @param stream The stream.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or SECURE_COMM_ERR_SEND if the stream was reset.
+ */
+SecureCommError mux_stream_close(MuxStream* stream) {
+    if (stream == NULL) {
+        fprintf(stderr, "mux_stream_close: Invalid arguments\n");
+        return SECURE_COMM_ERR_SEND;
+    }
+    MuxConnection* mux = stream->mux;
+    SecureCommError ret = SECURE_COMM_SUCCESS;
+
+    pthread_mutex_lock(&mux->lock);
+    if (stream->reset || mux->failed) {
+        ret = SECURE_COMM_ERR_SEND;
+    } else if (!stream->local_closed) {
+        stream->local_closed = 1;
+        if (stream->out_tail) {
+            // The last queued data frame is not sent yet: it can carry the end itself
+            stream->out_tail->frame[MUX_BODY_OFFSET + 5] |= MUX_FLAG_END;
+        } else {
+            mux_out_t* out = out_alloc(stream->id, MUX_KIND_DATA, MUX_FLAG_END, stream->priority, NULL, 0);
+            if (out == NULL) {
+                ret = SECURE_COMM_ERR_MEMORY;
+            } else {
+                queue_stream(stream, out);
+            }
+        }
+    }
+    pthread_mutex_unlock(&mux->lock);
+    return ret;
+}
+
+/**
+ * @brief Reads buffered stream data, waiting for some to arrive.
+ *
+ * @param stream The stream.
+ * @param buffer Destination buffer.
+ * @param len Size of the buffer.
+ * @param timeout_ms Milliseconds to wait; 0 returns at once, negative waits indefinitely.
+ * @param bytes_read Pointer to store the number of bytes read.
+ *
+ * @return SECURE_COMM_SUCCESS if data was read, SECURE_COMM_ERR_AGAIN on timeout,
+ *         SECURE_COMM_ERR_RECV at the end of the stream or once the connection has ended,
+ *         or SECURE_COMM_ERR_SESSION if the stream was reset.
+ */
+SecureCommError mux_stream_read(MuxStream* stream, void* buffer, size_t len, int timeout_ms, size_t* bytes_read) {
+    if (stream == NULL || buffer == NULL || bytes_read == NULL || len == 0) {
+        fprintf(stderr, "mux_stream_read: Invalid arguments\n");
+        return SECURE_COMM_ERR_RECV;
+    }
+    MuxConnection* mux = stream->mux;
+    *bytes_read = 0;
+
+    struct timespec deadline;
+    if (timeout_ms > 0) {
+        deadline_after(timeout_ms, &deadline);
+    }
+
+    pthread_mutex_lock(&mux->lock);
+    while (stream->buffered == 0 && !stream->remote_closed && !stream->reset && !mux->failed) {
+        if (wait_for(&stream->readable, mux, timeout_ms, &deadline)) {
+            break;
+        }
+    }
+
+    SecureCommError ret;
+    if (stream->reset) {
+        ret = SECURE_COMM_ERR_SESSION;
+    } else if (stream->buffered > 0) {
+        unsigned char* out = (unsigned char*)buffer;
+        size_t copied = 0;
+        while (copied < len && stream->in_head) {
+            mux_chunk_t* chunk = stream->in_head;
+            size_t n = chunk->len - chunk->offset;
+            if (n > len - copied) {
+                n = len - copied;
+            }
+            memcpy(out + copied, chunk->data + chunk->offset, n);
+            chunk->offset += n;
+            copied += n;
+            if (chunk->offset == chunk->len) {
+                stream->in_head = chunk->next;
+                if (stream->in_head == NULL) {
+                    stream->in_tail = NULL;
+                }
+                free(chunk);
+            }
+        }
+        stream->buffered -= copied;
+        stream->consumed += (uint32_t)copied;
+
+        // Grant the read bytes back once half the window has been used, not per read
+        if (!stream->remote_closed && stream->consumed >= mux->config.initial_window / 2) {
+            unsigned char increment[4];
+            put_be32(increment, stream->consumed);
+            queue_control(mux, stream->id, MUX_KIND_WINDOW, increment, sizeof(increment));
+            stream->recv_window += stream->consumed;
+            stream->consumed = 0;
+        }
+        *bytes_read = copied;
+        ret = SECURE_COMM_SUCCESS;
+    } else if (stream->remote_closed || mux->failed) {
+        ret = SECURE_COMM_ERR_RECV;
+    } else {
+        ret = SECURE_COMM_ERR_AGAIN;
+    }
+    pthread_mutex_unlock(&mux->lock);
+    return ret;
+}
+
+/**
+ * @brief Aborts a stream in both directions.
+ *
+ * @param stream The stream.
+ */
+void mux_stream_reset(MuxStream* stream) {
+    if (stream == NULL) {
+        return;
+    }
+    MuxConnection* mux = stream->mux;
+    pthread_mutex_lock(&mux->lock);
+    if (!stream->reset) {
+        stream_abort(mux, stream);
+        // A stream that never reached the wire has nothing to tell the peer
+        if (stream->id != 0) {
+            queue_control(mux, stream->id, MUX_KIND_RESET, NULL, 0);
+        }
+    }
+    pthread_mutex_unlock(&mux->lock);
+}
+
+/**
+ * @brief Changes the send priority of a stream.
+ */
+void mux_stream_set_priority(MuxStream* stream, uint8_t priority) {
+    if (stream == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&stream->mux->lock);
+    stream->priority = priority;
+    pthread_mutex_unlock(&stream->mux->lock);
+}
+
+/**
+ * @brief Returns the stream's id, or 0 until its first frame has been sent.
+ */
+uint32_t mux_stream_id(const MuxStream* stream) {
+    return stream ? stream->id : 0;
+}
+
+/**
+ * @brief Releases a stream handle.
+ *
+ * @param stream The stream; invalid afterwards.
+ */
+void mux_stream_release(MuxStream* stream) {
+    if (stream == NULL) {
+        return;
+    }
+    MuxConnection* mux = stream->mux;
+
+    pthread_mutex_lock(&mux->lock);
+    remove_stream(mux, stream);
+    if (stream->from_peer) {
+        mux->peer_streams--;
+    }
+    stream->released = 1;
+
+    // The reset goes behind the stream's own queued data, so that data still arrives first
+    if (!stream->reset && (!stream->local_closed || !stream->remote_closed) &&
+        (stream->id != 0 || stream->out_head != NULL)) {
+        mux_out_t* out = out_alloc(stream->id, MUX_KIND_RESET, 0, stream->priority, NULL, 0);
+        if (out != NULL) {
+            queue_stream(stream, out);
+        }
+    }
+    if (!stream->scheduled || mux->failed) {
+        discard_outgoing(mux, stream);
+        stream_free(stream);
+    }
+    pthread_mutex_unlock(&mux->lock);
+}
+
+/**
+ * @brief Copies the counters of a MuxConnection.
+ */
+void mux_get_stats(MuxConnection* mux, MuxStats* stats) {
+    if (mux == NULL || stats == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&mux->lock);
+    *stats = mux->stats;
+    stats->active_streams = mux->stream_count;
+    pthread_mutex_unlock(&mux->lock);
+}
+
+/**
+ * @brief Sends every queued frame, stops both threads and frees the MuxConnection.
+ *
+ * @param mux The MuxConnection.
+ */
+void mux_destroy(MuxConnection* mux) {
+    if (mux == NULL) {
+        return;
+    }
+
+    // Let the writer finish what is queued, then stop the reader by shutting the socket
+    pthread_mutex_lock(&mux->lock);
+    mux->closing = 1;
+    pthread_cond_broadcast(&mux->work);
+    pthread_cond_broadcast(&mux->incoming);
+    for (size_t i = 0; i < mux->stream_count; i++) {
+        pthread_cond_broadcast(&mux->streams[i]->readable);
+        pthread_cond_broadcast(&mux->streams[i]->writable);
+    }
+    while (!mux->failed && (mux->control_head || mux->ready_head)) {
+        pthread_cond_wait(&mux->drained, &mux->lock);
+    }
+    pthread_mutex_unlock(&mux->lock);
+
+    pthread_join(mux->writer, NULL);
+    connection_shutdown(mux->conn);
+    pthread_join(mux->reader, NULL);
+
+    // Released streams still queued (after a failure) are only on the ready list
+    while (mux->ready_head) {
+        MuxStream* stream = mux->ready_head;
+        unschedule(mux, stream, NULL);
+        if (stream->released) {
+            stream_free(stream);
+        }
+    }
+    for (size_t i = 0; i < mux->stream_count; i++) {
+        stream_free(mux->streams[i]);
+    }
+    while (mux->control_head) {
+        mux_out_t* next = mux->control_head->next;
+        free(mux->control_head);
+        mux->control_head = next;
+    }
+    free(mux->streams);
+    pthread_cond_destroy(&mux->work);
+    pthread_cond_destroy(&mux->incoming);
+    pthread_cond_destroy(&mux->drained);
+    pthread_mutex_destroy(&mux->lock);
+    free(mux);
+}
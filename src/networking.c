@@ -5,9 +5,21 @@
 #include <stdio.h>      // For printf, perror
 #include <stdlib.h>     // For malloc, free
 #include <string.h>     // For memset, memcpy
+#include <errno.h>      // For errno and strerror
+
+#include <pthread.h>    // For the session cache and TLS I/O locks
+#include <poll.h>       // For waiting on non-blocking TLS sockets
+#include <fcntl.h>      // For O_NONBLOCK
+#include <stdatomic.h>  // For the per-connection counters
+#include <sys/stat.h>   // For fstat
+#include <sys/sendfile.h> // For zero-copy sends on plain sockets
+#include <netinet/in.h> // For IPPROTO_TCP
+#include <netinet/tcp.h> // For the TCP keepalive options
+#include <time.h>       // For the pool's maintenance deadlines
 
 #include <openssl/ssl.h>  // For SSL functions
 #include <openssl/err.h>  // For SSL error functions
+#include <openssl/rand.h> // For the HELLO randoms
 
 #ifdef _WIN32
     // Windows-specific includes and definitions are already handled in the header
@@ -15,18 +27,142 @@
     // POSIX-specific includes are already handled in the header
 #endif
 
+// Size of the "address:port" key naming a connection's peer
+#define CONNECTION_PEER_SIZE 64
+
 // Definition of the opaque SecureConnection structure
 struct SecureConnection {
     int socket_fd;      // Socket file descriptor
-    SSL* ssl;           // SSL connection object
-    SSL_CTX* ssl_ctx;   // SSL context
+    char peer[CONNECTION_PEER_SIZE];    // "address:port" the connection was made to, or empty if accepted
+    SSL* ssl;           // SSL connection object (created from a shared context), or NULL for plain TCP
+    pthread_mutex_t ssl_lock;   // Serializes SSL calls so one reader and one writer thread can share the connection
+    _Atomic uint64_t bytes_sent;        // Counters reported by connection_get_stats
+    _Atomic uint64_t bytes_received;
+    _Atomic uint64_t send_calls;
+    _Atomic uint64_t recv_calls;
 };
 
+// Largest TLS record payload: gathered writes up to this size are sent as one record
+#define TLS_RECORD_MAX 16384
+
+// Contexts shared by every connection, created once in init_networking / init_server_tls
+static SSL_CTX* client_ctx = NULL;
+static SSL_CTX* server_ctx = NULL;
+static int ktls_enabled = 0;        // Set by networking_set_ktls, applied to both contexts
+static int connect_timeout_ms = SECURE_CONNECT_DEFAULT_TIMEOUT_MS;  // Set by networking_set_connect_timeout
+static int socket_rcvbuf = 0;       // Set by networking_set_socket_buffers, 0 for the kernel's default
+static int socket_sndbuf = 0;
+
+// Pause before racing the next address of a host (RFC 8305 "Connection Attempt Delay")
+#define CONNECT_ATTEMPT_DELAY_MS 250
+
+// Most resolved addresses tried per connect
+#define CONNECT_MAX_ADDRESSES 16
+
+// Client-side cache of resumable sessions, keyed by "address:port"
+#define SESSION_CACHE_SLOTS 64
+#define SESSION_CACHE_KEY_SIZE 64
+
+typedef struct {
+    char key[SESSION_CACHE_KEY_SIZE];
+    SSL_SESSION* session;
+    unsigned long last_used;
+} session_cache_entry_t;
+
+static session_cache_entry_t session_cache[SESSION_CACHE_SLOTS];
+static unsigned long session_cache_clock = 0;
+static pthread_mutex_t session_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static int cache_key_index = -1;    // SSL ex_data slot holding the connection's cache key
+
+/**
+ * @brief Stores a session for a key, replacing the previous one or the least recently used slot.
+ *
+ * Takes ownership of one reference to session.
+ */
+static void session_cache_put(const char* key, SSL_SESSION* session) {
+    pthread_mutex_lock(&session_cache_lock);
+    session_cache_entry_t* slot = NULL;
+    for (int i = 0; i < SESSION_CACHE_SLOTS; i++) {
+        session_cache_entry_t* entry = &session_cache[i];
+        if (entry->session && strcmp(entry->key, key) == 0) {
+            slot = entry;
+            break;
+        }
+        if (slot == NULL || (slot->session && (!entry->session || entry->last_used < slot->last_used))) {
+            slot = entry;
+        }
+    }
+
+    if (slot->session) {
+        SSL_SESSION_free(slot->session);
+    }
+    snprintf(slot->key, sizeof(slot->key), "%s", key);
+    slot->session = session;
+    slot->last_used = ++session_cache_clock;
+    pthread_mutex_unlock(&session_cache_lock);
+}
+
+/**
+ * @brief Returns a new reference to the cached session for a key, or NULL.
+ */
+static SSL_SESSION* session_cache_get(const char* key) {
+    SSL_SESSION* session = NULL;
+    pthread_mutex_lock(&session_cache_lock);
+    for (int i = 0; i < SESSION_CACHE_SLOTS; i++) {
+        session_cache_entry_t* entry = &session_cache[i];
+        if (entry->session && strcmp(entry->key, key) == 0) {
+            if (SSL_SESSION_is_resumable(entry->session)) {
+                SSL_SESSION_up_ref(entry->session);
+                session = entry->session;
+                entry->last_used = ++session_cache_clock;
+            } else {
+                SSL_SESSION_free(entry->session);
+                entry->session = NULL;
+            }
+            break;
+        }
+    }
+    pthread_mutex_unlock(&session_cache_lock);
+    return session;
+}
+
+/**
+ * @brief Frees every cached session.
+ */
+static void session_cache_clear(void) {
+    pthread_mutex_lock(&session_cache_lock);
+    for (int i = 0; i < SESSION_CACHE_SLOTS; i++) {
+        if (session_cache[i].session) {
+            SSL_SESSION_free(session_cache[i].session);
+            session_cache[i].session = NULL;
+        }
+    }
+    pthread_mutex_unlock(&session_cache_lock);
+}
+
+/**
+ * @brief OpenSSL callback for new client sessions.
+ *
+ * Called at the end of a TLS 1.2 handshake, and for each TLS 1.3 ticket the server
+ * sends after it.
+ *
+ * @return 1 to keep the reference OpenSSL hands over, 0 to let OpenSSL release it.
+ */
+static int on_new_client_session(SSL* ssl, SSL_SESSION* session) {
+    const char* key = (const char*)SSL_get_ex_data(ssl, cache_key_index);
+    if (key == NULL) {
+        return 0;
+    }
+    session_cache_put(key, session);
+    return 1;
+}
+
 /**
  * @brief Initializes the networking module.
  *
  * This function sets up any necessary networking resources, such as
- * initializing networking libraries required by the underlying platform.
+ * initializing networking libraries required by the underlying platform,
+ * and creates the client SSL context shared by every connection.
  *
  * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
  */
@@ -43,29 +179,99 @@ SecureCommError init_networking() {
     SSL_load_error_strings();      // Load human-readable error strings
     OpenSSL_add_ssl_algorithms();  // Register available SSL/TLS ciphers and digests
 
+    if (client_ctx) {
+        return SECURE_COMM_SUCCESS;
+    }
+
+    if (cache_key_index < 0) {
+        cache_key_index = SSL_get_ex_new_index(0, NULL, NULL, NULL, NULL);
+    }
+
+    // One client context for the whole process; sessions are cached externally per server
+    client_ctx = SSL_CTX_new(TLS_client_method());
+    if (!client_ctx || cache_key_index < 0) {
+        ERR_print_errors_fp(stderr);
+        SSL_CTX_free(client_ctx);
+        client_ctx = NULL;
+        return SECURE_COMM_ERR_SSL_CTX;
+    }
+    SSL_CTX_set_min_proto_version(client_ctx, TLS1_2_VERSION);
+    SSL_CTX_set_options(client_ctx, SSL_OP_IGNORE_UNEXPECTED_EOF);
+    SSL_CTX_set_session_cache_mode(client_ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(client_ctx, on_new_client_session);
+    if (ktls_enabled) {
+        SSL_CTX_set_options(client_ctx, SSL_OP_ENABLE_KTLS);
+    }
+
     return SECURE_COMM_SUCCESS;
 }
 
 /**
- * @brief Creates a secure connection to the specified address and port.
+ * @brief Creates the shared server-side SSL context used by secure_accept.
  *
- * This function establishes a TCP connection to the given address and port,
- * and initializes the SSL context for secure communication.
+ * Session tickets are enabled so that returning clients resume without a full handshake.
  *
- * @param address The IP address or hostname to connect to.
- * @param port The port number to connect on.
- * @param error Pointer to store the error code if connection fails.
+ * @param cert_path PEM certificate chain file.
+ * @param key_path PEM private key file.
  *
- * @return Pointer to a SecureConnection on success, or NULL on failure.
- *         The specific error code is stored in *error.
+ * @return SECURE_COMM_SUCCESS on success, or SECURE_COMM_ERR_SSL_CTX on failure.
  */
-SecureConnection* create_connection(const char* address, int port, SecureCommError* error) {
-    if (address == NULL || error == NULL) {
-        fprintf(stderr, "create_connection: Invalid arguments\n");
-        if (error) *error = SECURE_COMM_ERR_ADDRESS;
-        return NULL;
+SecureCommError init_server_tls(const char* cert_path, const char* key_path) {
+    if (cert_path == NULL || key_path == NULL) {
+        fprintf(stderr, "init_server_tls: Invalid arguments\n");
+        return SECURE_COMM_ERR_SSL_CTX;
+    }
+
+    SSL_CTX* ctx = SSL_CTX_new(TLS_server_method());
+    if (!ctx) {
+        ERR_print_errors_fp(stderr);
+        return SECURE_COMM_ERR_SSL_CTX;
+    }
+    SSL_CTX_set_min_proto_version(ctx, TLS1_2_VERSION);
+    SSL_CTX_set_options(ctx, SSL_OP_IGNORE_UNEXPECTED_EOF);
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER);
+    if (ktls_enabled) {
+        SSL_CTX_set_options(ctx, SSL_OP_ENABLE_KTLS);
+    }
+
+    if (SSL_CTX_use_certificate_chain_file(ctx, cert_path) <= 0 ||
+        SSL_CTX_use_PrivateKey_file(ctx, key_path, SSL_FILETYPE_PEM) <= 0 ||
+        SSL_CTX_check_private_key(ctx) <= 0) {
+        fprintf(stderr, "init_server_tls: Failed to load certificate or key\n");
+        ERR_print_errors_fp(stderr);
+        SSL_CTX_free(ctx);
+        return SECURE_COMM_ERR_SSL_CTX;
     }
 
+    SSL_CTX_free(server_ctx);
+    server_ctx = ctx;
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Asks OpenSSL to hand the TLS record layer of new connections to the kernel.
+ *
+ * @param enable Non-zero to request kTLS, 0 to keep record encryption in userspace.
+ */
+void networking_set_ktls(int enable) {
+    ktls_enabled = enable ? 1 : 0;
+    SSL_CTX* contexts[2] = { client_ctx, server_ctx };
+    for (int i = 0; i < 2; i++) {
+        if (contexts[i] == NULL) {
+            continue;
+        }
+        if (ktls_enabled) {
+            SSL_CTX_set_options(contexts[i], SSL_OP_ENABLE_KTLS);
+        } else {
+            SSL_CTX_clear_options(contexts[i], SSL_OP_ENABLE_KTLS);
+        }
+    }
+}
+
+/**
+ * @brief Allocates a connection object for a socket.
+ */
+static SecureConnection* connection_alloc(int socket_fd, SecureCommError* error) {
     SecureConnection* conn = (SecureConnection*)malloc(sizeof(SecureConnection));
     if (!conn) {
         perror("malloc");
@@ -74,74 +280,382 @@ SecureConnection* create_connection(const char* address, int port, SecureCommErr
     }
 
     memset(conn, 0, sizeof(SecureConnection));  // Initialize memory to zero
+    conn->socket_fd = socket_fd;
+    pthread_mutex_init(&conn->ssl_lock, NULL);
+    metrics_count(METRIC_CONNECTIONS_OPENED, 1);
+    return conn;
+}
 
-    // Create a socket
-    conn->socket_fd = socket(AF_INET, SOCK_STREAM, 0);
-    if (conn->socket_fd < 0) {
-        perror("socket");
-        free(conn);
-        *error = SECURE_COMM_ERR_SOCKET;
-        return NULL;
+/**
+ * @brief Releases a connection object without touching the socket.
+ */
+static void connection_free(SecureConnection* conn) {
+    pthread_mutex_destroy(&conn->ssl_lock);
+    free(conn);
+    metrics_count(METRIC_CONNECTIONS_CLOSED, 1);
+}
+
+/**
+ * @brief Counts one successful send on the connection and in the global metrics.
+ */
+static void connection_count_sent(SecureConnection* conn, size_t len) {
+    atomic_fetch_add_explicit(&conn->bytes_sent, len, memory_order_relaxed);
+    atomic_fetch_add_explicit(&conn->send_calls, 1, memory_order_relaxed);
+    metrics_count(METRIC_BYTES_SENT, len);
+    metrics_count(METRIC_SEND_CALLS, 1);
+}
+
+/**
+ * @brief Counts one successful receive on the connection and in the global metrics.
+ */
+static void connection_count_received(SecureConnection* conn, size_t len) {
+    atomic_fetch_add_explicit(&conn->bytes_received, len, memory_order_relaxed);
+    atomic_fetch_add_explicit(&conn->recv_calls, 1, memory_order_relaxed);
+    metrics_count(METRIC_BYTES_RECEIVED, len);
+    metrics_count(METRIC_RECV_CALLS, 1);
+}
+
+/**
+ * @brief Milliseconds on a monotonic clock.
+ */
+static uint64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+}
+
+/**
+ * @brief Orders resolved addresses so the two families alternate, first family first (RFC 8305).
+ *
+ * @return Number of addresses stored in order.
+ */
+static size_t interleave_addresses(struct addrinfo* list, struct addrinfo** order) {
+    struct addrinfo* first[CONNECT_MAX_ADDRESSES];
+    struct addrinfo* other[CONNECT_MAX_ADDRESSES];
+    size_t first_count = 0, other_count = 0;
+    for (struct addrinfo* ai = list; ai != NULL; ai = ai->ai_next) {
+        if (ai->ai_family == list->ai_family && first_count < CONNECT_MAX_ADDRESSES) {
+            first[first_count++] = ai;
+        } else if (ai->ai_family != list->ai_family && other_count < CONNECT_MAX_ADDRESSES) {
+            other[other_count++] = ai;
+        }
+    }
+
+    size_t count = 0;
+    for (size_t i = 0; count < CONNECT_MAX_ADDRESSES && (i < first_count || i < other_count); i++) {
+        if (i < first_count) {
+            order[count++] = first[i];
+        }
+        if (i < other_count && count < CONNECT_MAX_ADDRESSES) {
+            order[count++] = other[i];
+        }
     }
+    return count;
+}
+
+/**
+ * @brief Races non-blocking connects to the addresses, starting a new one every
+ *        CONNECT_ATTEMPT_DELAY_MS (or as soon as one fails), and keeps the first to succeed.
+ *
+ * @return The connected (blocking) socket, or -1 with *error set.
+ */
+static int connect_first(struct addrinfo** order, size_t count, int timeout_ms, const char* address,
+                         SecureCommError* error) {
+    struct pollfd pending[CONNECT_MAX_ADDRESSES];
+    size_t active = 0;
+    size_t started = 0;
+    int winner = -1;
+    int last_error = 0;
+    uint64_t start = now_ms();
+    uint64_t next_attempt = start;
 
-    // Set up the server address structure
-    struct sockaddr_in server_addr;
-    memset(&server_addr, 0, sizeof(server_addr));  // Zero out the structure
-    server_addr.sin_family = AF_INET;              // IPv4
-    server_addr.sin_port = htons(port);            // Convert port to network byte order
+    while (winner < 0) {
+        uint64_t now = now_ms();
+        if (timeout_ms > 0 && now - start >= (uint64_t)timeout_ms) {
+            last_error = ETIMEDOUT;
+            break;
+        }
 
-    // Convert the address from text to binary form
-    if (inet_pton(AF_INET, address, &server_addr.sin_addr) <= 0) {
-        perror("inet_pton");
-        close(conn->socket_fd);
-        free(conn);
+        // Start the next attempt when its turn comes, or when nothing is in flight
+        if (started < count && (active == 0 || now >= next_attempt)) {
+            struct addrinfo* ai = order[started++];
+            next_attempt = now + CONNECT_ATTEMPT_DELAY_MS;
+            int fd = socket(ai->ai_family, ai->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, ai->ai_protocol);
+            if (fd < 0) {
+                last_error = errno;
+                continue;
+            }
+            if (socket_rcvbuf > 0) {
+                setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &socket_rcvbuf, sizeof(socket_rcvbuf));
+            }
+            if (socket_sndbuf > 0) {
+                setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &socket_sndbuf, sizeof(socket_sndbuf));
+            }
+            if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+                winner = fd;
+                break;
+            }
+            if (errno != EINPROGRESS) {
+                last_error = errno;
+                close(fd);
+                continue;
+            }
+            pending[active].fd = fd;
+            pending[active].events = POLLOUT;
+            pending[active].revents = 0;
+            active++;
+            continue;
+        }
+        if (active == 0) {
+            break;
+        }
+
+        // Sleep until an attempt completes, the next one is due, or the deadline passes
+        int wait_ms = -1;
+        if (started < count) {
+            wait_ms = (int)(next_attempt - now);
+        }
+        if (timeout_ms > 0) {
+            int left = (int)((uint64_t)timeout_ms - (now - start));
+            if (wait_ms < 0 || left < wait_ms) {
+                wait_ms = left;
+            }
+        }
+        int ready = poll(pending, (nfds_t)active, wait_ms);
+        if (ready < 0 && errno != EINTR) {
+            last_error = errno;
+            break;
+        }
+
+        for (size_t i = 0; ready > 0 && i < active && winner < 0;) {
+            if (pending[i].revents == 0) {
+                i++;
+                continue;
+            }
+            int so_error = 0;
+            socklen_t len = sizeof(so_error);
+            if (getsockopt(pending[i].fd, SOL_SOCKET, SO_ERROR, &so_error, &len) != 0) {
+                so_error = errno;
+            }
+            if (so_error == 0) {
+                winner = pending[i].fd;
+                pending[i] = pending[--active];
+                break;
+            }
+            last_error = so_error;
+            close(pending[i].fd);
+            pending[i] = pending[--active];
+            next_attempt = now;     // A failure lets the next address start at once
+        }
+    }
+
+    // The losers of the race are abandoned
+    for (size_t i = 0; i < active; i++) {
+        close(pending[i].fd);
+    }
+    if (winner < 0) {
+        fprintf(stderr, "connect_tcp: Cannot connect to %s: %s\n", address,
+                last_error == ETIMEDOUT ? "timed out" : strerror(last_error));
+        *error = last_error == ETIMEDOUT ? SECURE_COMM_ERR_TIMEOUT : SECURE_COMM_ERR_CONNECT;
+        return -1;
+    }
+
+    int flags = fcntl(winner, F_GETFL, 0);
+    if (flags >= 0) {
+        fcntl(winner, F_SETFL, flags & ~O_NONBLOCK);
+    }
+    return winner;
+}
+
+/**
+ * @brief Opens a TCP connection to address:port over IPv6 or IPv4, whichever answers first.
+ *
+ * @param address Host name or numeric address.
+ * @param port The port number.
+ * @param timeout_ms Limit for the whole attempt, or 0 to wait as long as the kernel does.
+ * @param error Pointer to store the error code on failure.
+ *
+ * @return The connected socket, or -1 with *error set.
+ */
+static int connect_tcp(const char* address, int port, int timeout_ms, SecureCommError* error) {
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_NUMERICSERV;
+
+    char service[16];
+    snprintf(service, sizeof(service), "%d", port);
+    struct addrinfo* list = NULL;
+    int rc = getaddrinfo(address, service, &hints, &list);
+    if (rc != 0 || list == NULL) {
+        fprintf(stderr, "connect_tcp: Cannot resolve %s: %s\n", address, gai_strerror(rc));
         *error = SECURE_COMM_ERR_ADDRESS;
-        return NULL;
+        return -1;
     }
 
-    // Connect to the server
-    if (connect(conn->socket_fd, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
-        perror("connect");
-        close(conn->socket_fd);
-        free(conn);
-        *error = SECURE_COMM_ERR_CONNECT;
+    struct addrinfo* order[CONNECT_MAX_ADDRESSES];
+    size_t count = interleave_addresses(list, order);
+    int socket_fd = connect_first(order, count, timeout_ms, address, error);
+    freeaddrinfo(list);
+    return socket_fd;
+}
+
+/**
+ * @brief Sets how long create_connection and create_plain_connection may take to connect.
+ *
+ * @param timeout_ms Limit in milliseconds, or 0 to wait as long as the kernel does.
+ */
+void networking_set_connect_timeout(int timeout_ms) {
+    connect_timeout_ms = timeout_ms > 0 ? timeout_ms : 0;
+}
+
+/**
+ * @brief Sets the socket buffer sizes of connections made afterwards.
+ *
+ * @param rcvbuf SO_RCVBUF in bytes, or 0 to keep the kernel's default.
+ * @param sndbuf SO_SNDBUF in bytes, or 0 to keep the kernel's default.
+ */
+void networking_set_socket_buffers(int rcvbuf, int sndbuf) {
+    socket_rcvbuf = rcvbuf > 0 ? rcvbuf : 0;
+    socket_sndbuf = sndbuf > 0 ? sndbuf : 0;
+}
+
+/**
+ * @brief Switches a TLS connection to non-blocking I/O.
+ *
+ * Client connections switch before the handshake, so it can be bounded by the
+ * connect deadline. Reads and writes then wait in poll() without holding ssl_lock, so a thread
+ * blocked waiting for data never stalls a thread that is sending.
+ */
+static void connection_set_nonblocking(SecureConnection* conn) {
+    int flags = fcntl(conn->socket_fd, F_GETFL, 0);
+    if (flags >= 0) {
+        fcntl(conn->socket_fd, F_SETFL, flags | O_NONBLOCK);
+    }
+    SSL_set_mode(conn->ssl, SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+}
+
+/**
+ * @brief Waits for a non-blocking handshake to make progress before the deadline.
+ *
+ * @param deadline now_ms() value to give up at, or 0 for none.
+ *
+ * @return 1 to retry the SSL call, 0 once the deadline has passed, -1 if the socket failed.
+ */
+static int handshake_wait(int socket_fd, int ssl_error, uint64_t deadline) {
+    struct pollfd pfd;
+    pfd.fd = socket_fd;
+    pfd.events = ssl_error == SSL_ERROR_WANT_WRITE ? POLLOUT : POLLIN;
+
+    for (;;) {
+        int wait_ms = -1;
+        if (deadline > 0) {
+            uint64_t now = now_ms();
+            if (now >= deadline) {
+                return 0;
+            }
+            wait_ms = (int)(deadline - now);
+        }
+        pfd.revents = 0;
+        int ready = poll(&pfd, 1, wait_ms);
+        if (ready > 0) {
+            return (pfd.revents & POLLNVAL) ? -1 : 1;
+        }
+        if (ready < 0 && errno != EINTR) {
+            return -1;
+        }
+    }
+}
+
+/**
+ * @brief Body of create_connection with an explicit connect timeout.
+ *
+ * timeout_ms covers the TCP connect and the TLS handshake together, so a peer that
+ * accepts and then never answers cannot hold the caller past it.
+ */
+static SecureConnection* connect_tls(const char* address, int port, int timeout_ms, SecureCommError* error) {
+    if (address == NULL || error == NULL) {
+        fprintf(stderr, "create_connection: Invalid arguments\n");
+        if (error) *error = SECURE_COMM_ERR_ADDRESS;
         return NULL;
     }
 
-    // Create a new SSL context using TLS client method
-    conn->ssl_ctx = SSL_CTX_new(TLS_client_method());
-    if (!conn->ssl_ctx) {
-        ERR_print_errors_fp(stderr);
-        close(conn->socket_fd);
-        free(conn);
+    if (!client_ctx) {
+        fprintf(stderr, "create_connection: init_networking has not been called\n");
         *error = SECURE_COMM_ERR_SSL_CTX;
         return NULL;
     }
 
-    // Create a new SSL structure for the connection
-    conn->ssl = SSL_new(conn->ssl_ctx);
+    uint64_t deadline = timeout_ms > 0 ? now_ms() + (uint64_t)timeout_ms : 0;
+    int socket_fd = connect_tcp(address, port, timeout_ms, error);
+    if (socket_fd < 0) {
+        return NULL;
+    }
+
+    SecureConnection* conn = connection_alloc(socket_fd, error);
+    if (!conn) {
+        close(socket_fd);
+        return NULL;
+    }
+    snprintf(conn->peer, sizeof(conn->peer), "%s:%d", address, port);
+
+    // Create a new SSL structure for the connection from the shared context
+    conn->ssl = SSL_new(client_ctx);
     if (!conn->ssl) {
         ERR_print_errors_fp(stderr);
-        SSL_CTX_free(conn->ssl_ctx);
-        close(conn->socket_fd);
-        free(conn);
+        close(socket_fd);
+        connection_free(conn);
         *error = SECURE_COMM_ERR_SSL;
         return NULL;
     }
 
+    // Offer the last session issued by this server so the handshake can be resumed
+    char* cache_key = (char*)malloc(SESSION_CACHE_KEY_SIZE);
+    if (cache_key) {
+        snprintf(cache_key, SESSION_CACHE_KEY_SIZE, "%s:%d", address, port);
+        SSL_set_ex_data(conn->ssl, cache_key_index, cache_key);
+        SSL_SESSION* cached = session_cache_get(cache_key);
+        if (cached) {
+            SSL_set_session(conn->ssl, cached);
+            SSL_SESSION_free(cached);
+        }
+    }
+
     // Associate the socket file descriptor with the SSL structure
-    SSL_set_fd(conn->ssl, conn->socket_fd);
+    SSL_set_fd(conn->ssl, socket_fd);
 
-    // Initiate the TLS/SSL handshake with the server
-    if (SSL_connect(conn->ssl) <= 0) {
-        ERR_print_errors_fp(stderr);
+    // Run the handshake on the non-blocking socket, against what is left of the deadline
+    connection_set_nonblocking(conn);
+    uint64_t start_ns = metrics_now_ns();
+    SecureCommError result = SECURE_COMM_SUCCESS;
+    int connected;
+    while ((connected = SSL_connect(conn->ssl)) <= 0) {
+        int ssl_error = SSL_get_error(conn->ssl, connected);
+        int waited = ssl_error == SSL_ERROR_WANT_READ || ssl_error == SSL_ERROR_WANT_WRITE
+                         ? handshake_wait(socket_fd, ssl_error, deadline) : -1;
+        if (waited <= 0) {
+            result = waited == 0 ? SECURE_COMM_ERR_TIMEOUT : SECURE_COMM_ERR_SSL;
+            break;
+        }
+    }
+    metrics_stage_done(METRIC_STAGE_TLS_HANDSHAKE, start_ns, 0, 0, result);
+    if (result != SECURE_COMM_SUCCESS) {
+        if (result == SECURE_COMM_ERR_TIMEOUT) {
+            fprintf(stderr, "create_connection: TLS handshake with %s:%d timed out\n", address, port);
+        } else {
+            ERR_print_errors_fp(stderr);
+        }
         SSL_free(conn->ssl);
-        SSL_CTX_free(conn->ssl_ctx);
-        close(conn->socket_fd);
-        free(conn);
-        *error = SECURE_COMM_ERR_SSL;
+        free(cache_key);
+        close(socket_fd);
+        connection_free(conn);
+        *error = result;
         return NULL;
     }
+    if (SSL_session_reused(conn->ssl)) {
+        metrics_count(METRIC_TLS_SESSIONS_RESUMED, 1);
+    }
 
     // Connection and SSL setup successful
     *error = SECURE_COMM_SUCCESS;
@@ -149,89 +663,923 @@ SecureConnection* create_connection(const char* address, int port, SecureCommErr
 }
 
 /**
- * @brief Sends data over the secure connection.
+ * @brief Creates a secure connection to the specified address and port.
  *
- * This function encrypts and sends the specified data over the connection.
+ * This function establishes a TCP connection to the given address and port and
+ * performs the TLS handshake using the context shared by all connections. A session
+ * cached from an earlier connection to the same address and port is offered for
+ * resumption.
  *
- * @param conn Pointer to an established SecureConnection.
- * @param data Pointer to the data buffer to send.
- * @param len Length of the data in bytes.
- * @param bytes_sent Pointer to store the number of bytes actually sent.
+ * @param address The IP address or hostname to connect to.
+ * @param port The port number to connect on.
+ * @param error Pointer to store the error code if connection fails.
  *
- * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ * @return Pointer to a SecureConnection on success, or NULL on failure.
+ *         The specific error code is stored in *error.
  */
-SecureCommError secure_send(SecureConnection* conn, const void* data, size_t len, ssize_t* bytes_sent) {
-    if (conn == NULL || data == NULL || bytes_sent == NULL) {
-        fprintf(stderr, "secure_send: Invalid arguments\n");
-        return SECURE_COMM_ERR_SEND;
+SecureConnection* create_connection(const char* address, int port, SecureCommError* error) {
+    return connect_tls(address, port, connect_timeout_ms, error);
+}
+
+/**
+ * @brief Body of create_plain_connection with an explicit connect timeout.
+ */
+static SecureConnection* connect_plain(const char* address, int port, int timeout_ms, SecureCommError* error) {
+    if (address == NULL || error == NULL) {
+        fprintf(stderr, "create_plain_connection: Invalid arguments\n");
+        if (error) *error = SECURE_COMM_ERR_ADDRESS;
+        return NULL;
     }
 
-    // Send data using SSL_write
-    int sent = SSL_write(conn->ssl, data, (int)len);
-    if (sent <= 0) {
-        int ssl_error = SSL_get_error(conn->ssl, sent);
-        fprintf(stderr, "SSL_write failed with error %d\n", ssl_error);
-        return SECURE_COMM_ERR_SEND;
+    int socket_fd = connect_tcp(address, port, timeout_ms, error);
+    if (socket_fd < 0) {
+        return NULL;
     }
 
-    *bytes_sent = sent;
-    return SECURE_COMM_SUCCESS;
+    SecureConnection* conn = connection_wrap_socket(socket_fd, error);
+    if (!conn) {
+        close(socket_fd);
+        return NULL;
+    }
+    snprintf(conn->peer, sizeof(conn->peer), "%s:%d", address, port);
+    return conn;
 }
 
 /**
- * @brief Receives data from the secure connection.
+ * @brief Creates a plain TCP connection to the specified address and port.
  *
- * This function receives and decrypts data from the connection.
+ * No TLS is used; the caller's record layer (cipher_encrypt) protects the payloads.
  *
- * @param conn Pointer to an established SecureConnection.
- * @param buffer Pointer to the buffer where received data will be stored.
- * @param len Maximum number of bytes to receive.
- * @param bytes_received Pointer to store the number of bytes actually received.
+ * @param address The IP address to connect to.
+ * @param port The port number to connect on.
+ * @param error Pointer to store the error code if connection fails.
  *
- * @return SECURE_COMM_SUCCESS on success, SECURE_COMM_ERR_RECV if connection is closed,
- *         or a negative error code on failure.
+ * @return Pointer to a SecureConnection on success, or NULL on failure.
  */
-SecureCommError secure_recv(SecureConnection* conn, void* buffer, size_t len, ssize_t* bytes_received) {
-    if (conn == NULL || buffer == NULL || bytes_received == NULL) {
-        fprintf(stderr, "secure_recv: Invalid arguments\n");
-        return SECURE_COMM_ERR_RECV;
-    }
-
-    // Receive data using SSL_read
-    int received = SSL_read(conn->ssl, buffer, (int)len);
-    if (received <= 0) {
-        int ssl_error = SSL_get_error(conn->ssl, received);
-        if (ssl_error == SSL_ERROR_ZERO_RETURN) {
-            // Connection has been closed cleanly
-            return SECURE_COMM_ERR_RECV;
-        }
-        fprintf(stderr, "SSL_read failed with error %d\n", ssl_error);
-        return SECURE_COMM_ERR_RECV;
-    }
-
-    *bytes_received = received;
-    return SECURE_COMM_SUCCESS;
+SecureConnection* create_plain_connection(const char* address, int port, SecureCommError* error) {
+    return connect_plain(address, port, connect_timeout_ms, error);
 }
 
 /**
- * @brief Closes the secure connection and frees resources.
+ * @brief Wraps an already connected socket without TLS.
  *
- * This function gracefully shuts down the SSL connection, closes the socket,
- * and frees any allocated memory associated with the connection.
+ * @param socket_fd Connected socket; owned by the connection on success.
+ * @param error Pointer to store the error code on failure.
  *
- * @param conn Pointer to the SecureConnection to close.
+ * @return Pointer to a SecureConnection on success, or NULL on failure.
  */
-void close_connection(SecureConnection* conn) {
-    if (conn) {
-        // Shutdown the SSL connection
-        if (conn->ssl) {
-            SSL_shutdown(conn->ssl);
-            SSL_free(conn->ssl);
+SecureConnection* connection_wrap_socket(int socket_fd, SecureCommError* error) {
+    if (socket_fd < 0 || error == NULL) {
+        fprintf(stderr, "connection_wrap_socket: Invalid arguments\n");
+        if (error) *error = SECURE_COMM_ERR_SOCKET;
+        return NULL;
+    }
+
+    SecureConnection* conn = connection_alloc(socket_fd, error);
+    if (!conn) {
+        return NULL;
+    }
+    *error = SECURE_COMM_SUCCESS;
+    return conn;
+}
+
+/**
+ * @brief Performs the server side of the TLS handshake on an accepted socket.
+ *
+ * @param socket_fd Socket returned by accept(); owned by the connection on success.
+ * @param error Pointer to store the error code if the handshake fails.
+ *
+ * @return Pointer to a SecureConnection on success, or NULL on failure.
+ */
+SecureConnection* secure_accept(int socket_fd, SecureCommError* error) {
+    if (socket_fd < 0 || error == NULL) {
+        fprintf(stderr, "secure_accept: Invalid arguments\n");
+        if (error) *error = SECURE_COMM_ERR_SOCKET;
+        return NULL;
+    }
+    if (!server_ctx) {
+        fprintf(stderr, "secure_accept: init_server_tls has not been called\n");
+        *error = SECURE_COMM_ERR_SSL_CTX;
+        return NULL;
+    }
+
+    SecureConnection* conn = connection_alloc(socket_fd, error);
+    if (!conn) {
+        return NULL;
+    }
+
+    conn->ssl = SSL_new(server_ctx);
+    if (!conn->ssl) {
+        ERR_print_errors_fp(stderr);
+        connection_free(conn);
+        *error = SECURE_COMM_ERR_SSL;
+        return NULL;
+    }
+    SSL_set_fd(conn->ssl, socket_fd);
+
+    uint64_t start_ns = metrics_now_ns();
+    int accepted = SSL_accept(conn->ssl);
+    metrics_stage_done(METRIC_STAGE_TLS_HANDSHAKE, start_ns, 0, 0,
+                       accepted > 0 ? SECURE_COMM_SUCCESS : SECURE_COMM_ERR_SSL);
+    if (accepted <= 0) {
+        ERR_print_errors_fp(stderr);
+        SSL_free(conn->ssl);
+        connection_free(conn);
+        *error = SECURE_COMM_ERR_SSL;
+        return NULL;
+    }
+    connection_set_nonblocking(conn);
+
+    *error = SECURE_COMM_SUCCESS;
+    return conn;
+}
+
+/**
+ * @brief Reports whether the connection resumed a previous TLS session.
+ *
+ * @param conn Pointer to an established SecureConnection.
+ *
+ * @return 1 if the abbreviated handshake was used, 0 otherwise.
+ */
+int connection_session_reused(const SecureConnection* conn) {
+    return conn && conn->ssl && SSL_session_reused(conn->ssl) ? 1 : 0;
+}
+
+/**
+ * @brief Reports whether the kernel encrypts the TLS records this connection sends.
+ *
+ * @param conn Pointer to an established SecureConnection.
+ *
+ * @return 1 if kTLS is active for sending, 0 otherwise (including plain connections).
+ */
+int connection_ktls_send(const SecureConnection* conn) {
+    return conn && conn->ssl && BIO_get_ktls_send(SSL_get_wbio(conn->ssl)) ? 1 : 0;
+}
+
+/**
+ * @brief Copies the byte and call counters of a connection.
+ *
+ * @param conn Pointer to a SecureConnection.
+ * @param stats Pointer to store the counters.
+ */
+void connection_get_stats(const SecureConnection* conn, ConnectionStats* stats) {
+    if (conn == NULL || stats == NULL) {
+        return;
+    }
+    stats->bytes_sent = atomic_load_explicit(&conn->bytes_sent, memory_order_relaxed);
+    stats->bytes_received = atomic_load_explicit(&conn->bytes_received, memory_order_relaxed);
+    stats->send_calls = atomic_load_explicit(&conn->send_calls, memory_order_relaxed);
+    stats->recv_calls = atomic_load_explicit(&conn->recv_calls, memory_order_relaxed);
+}
+
+/**
+ * @brief Waits until a non-blocking TLS socket can make progress.
+ *
+ * @return 1 to retry the SSL call, 0 if the socket failed or was shut down.
+ */
+static int tls_wait(SecureConnection* conn, int ssl_error) {
+    struct pollfd pfd;
+    pfd.fd = conn->socket_fd;
+    pfd.events = ssl_error == SSL_ERROR_WANT_WRITE ? POLLOUT : POLLIN;
+    pfd.revents = 0;
+
+    while (poll(&pfd, 1, -1) < 0) {
+        if (errno != EINTR) {
+            return 0;
+        }
+    }
+    return (pfd.revents & POLLNVAL) ? 0 : 1;
+}
+
+/**
+ * @brief Writes all bytes as TLS application data.
+ */
+static SecureCommError tls_write_all(SecureConnection* conn, const void* data, size_t len) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    size_t offset = 0;
+
+    while (offset < len) {
+        size_t written = 0;
+        pthread_mutex_lock(&conn->ssl_lock);
+        int ok = SSL_write_ex(conn->ssl, bytes + offset, len - offset, &written);
+        int ssl_error = ok ? SSL_ERROR_NONE : SSL_get_error(conn->ssl, 0);
+        pthread_mutex_unlock(&conn->ssl_lock);
+
+        if (ok) {
+            offset += written;
+            continue;
+        }
+        if ((ssl_error != SSL_ERROR_WANT_READ && ssl_error != SSL_ERROR_WANT_WRITE) || !tls_wait(conn, ssl_error)) {
+            fprintf(stderr, "SSL_write failed with error %d\n", ssl_error);
+            return SECURE_COMM_ERR_SEND;
+        }
+    }
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Reads up to len bytes of TLS application data, waiting until at least one arrives.
+ */
+static SecureCommError tls_read_some(SecureConnection* conn, void* buffer, size_t len, size_t* received) {
+    while (1) {
+        pthread_mutex_lock(&conn->ssl_lock);
+        int ok = SSL_read_ex(conn->ssl, buffer, len, received);
+        int ssl_error = ok ? SSL_ERROR_NONE : SSL_get_error(conn->ssl, 0);
+        pthread_mutex_unlock(&conn->ssl_lock);
+
+        if (ok) {
+            return SECURE_COMM_SUCCESS;
+        }
+        if (ssl_error == SSL_ERROR_ZERO_RETURN) {
+            // Connection has been closed cleanly
+            return SECURE_COMM_ERR_RECV;
+        }
+        if ((ssl_error != SSL_ERROR_WANT_READ && ssl_error != SSL_ERROR_WANT_WRITE) || !tls_wait(conn, ssl_error)) {
+            fprintf(stderr, "SSL_read failed with error %d\n", ssl_error);
+            return SECURE_COMM_ERR_RECV;
+        }
+    }
+}
+
+/**
+ * @brief Sends data over the secure connection.
+ *
+ * This function encrypts and sends the specified data over the connection,
+ * retrying until every byte has been written.
+ *
+ * @param conn Pointer to an established SecureConnection.
+ * @param data Pointer to the data buffer to send.
+ * @param len Length of the data in bytes.
+ * @param bytes_sent Pointer to store the number of bytes actually sent.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError secure_send(SecureConnection* conn, const void* data, size_t len, ssize_t* bytes_sent) {
+    if (conn == NULL || data == NULL || bytes_sent == NULL) {
+        fprintf(stderr, "secure_send: Invalid arguments\n");
+        return SECURE_COMM_ERR_SEND;
+    }
+
+    SecureCommError ret = conn->ssl ? tls_write_all(conn, data, len) : frame_send_all(conn->socket_fd, data, len);
+    if (ret != SECURE_COMM_SUCCESS) {
+        return ret;
+    }
+
+    connection_count_sent(conn, len);
+    *bytes_sent = (ssize_t)len;
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Receives data from the secure connection.
+ *
+ * This function receives and decrypts data from the connection.
+ *
+ * @param conn Pointer to an established SecureConnection.
+ * @param buffer Pointer to the buffer where received data will be stored.
+ * @param len Maximum number of bytes to receive.
+ * @param bytes_received Pointer to store the number of bytes actually received.
+ *
+ * @return SECURE_COMM_SUCCESS on success, SECURE_COMM_ERR_RECV if connection is closed,
+ *         or a negative error code on failure.
+ */
+SecureCommError secure_recv(SecureConnection* conn, void* buffer, size_t len, ssize_t* bytes_received) {
+    if (conn == NULL || buffer == NULL || bytes_received == NULL) {
+        fprintf(stderr, "secure_recv: Invalid arguments\n");
+        return SECURE_COMM_ERR_RECV;
+    }
+
+    if (conn->ssl) {
+        size_t received = 0;
+        SecureCommError ret = tls_read_some(conn, buffer, len, &received);
+        if (ret != SECURE_COMM_SUCCESS) {
+            return ret;
+        }
+        connection_count_received(conn, received);
+        *bytes_received = (ssize_t)received;
+        return SECURE_COMM_SUCCESS;
+    }
+
+    ssize_t received;
+    do {
+        received = recv(conn->socket_fd, buffer, len, 0);
+    } while (received < 0 && errno == EINTR);
+
+    if (received <= 0) {
+        if (received < 0) {
+            fprintf(stderr, "secure_recv: recv failed: %s\n", strerror(errno));
+        }
+        return SECURE_COMM_ERR_RECV;
+    }
+
+    connection_count_received(conn, (size_t)received);
+    *bytes_received = received;
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Sends the valid bytes of a pool buffer.
+ *
+ * @param conn Pointer to an established SecureConnection.
+ * @param buffer The buffer; its reference is not consumed.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError secure_send_buffer(SecureConnection* conn, const SecureBuffer* buffer) {
+    if (conn == NULL || buffer == NULL) {
+        fprintf(stderr, "secure_send_buffer: Invalid arguments\n");
+        return SECURE_COMM_ERR_SEND;
+    }
+
+    ssize_t sent = 0;
+    return secure_send(conn, secure_buffer_data(buffer), secure_buffer_len(buffer), &sent);
+}
+
+/**
+ * @brief Receives into the free space after a pool buffer's valid bytes and extends them.
+ *
+ * @param conn Pointer to an established SecureConnection.
+ * @param buffer The buffer to append to.
+ * @param bytes_received Optional pointer to store the number of bytes appended.
+ *
+ * @return SECURE_COMM_SUCCESS on success, SECURE_COMM_ERR_MEMORY if the buffer is full,
+ *         SECURE_COMM_ERR_RECV if the connection is closed, or another negative error code.
+ */
+SecureCommError secure_recv_buffer(SecureConnection* conn, SecureBuffer* buffer, size_t* bytes_received) {
+    if (conn == NULL || buffer == NULL) {
+        fprintf(stderr, "secure_recv_buffer: Invalid arguments\n");
+        return SECURE_COMM_ERR_RECV;
+    }
+
+    size_t used = secure_buffer_len(buffer);
+    size_t space = secure_buffer_capacity(buffer) - used;
+    if (space == 0) {
+        fprintf(stderr, "secure_recv_buffer: Buffer is full\n");
+        return SECURE_COMM_ERR_MEMORY;
+    }
+
+    ssize_t received = 0;
+    SecureCommError ret = secure_recv(conn, secure_buffer_data(buffer) + used, space, &received);
+    if (ret != SECURE_COMM_SUCCESS) {
+        return ret;
+    }
+    secure_buffer_set_len(buffer, used + (size_t)received);
+    if (bytes_received) {
+        *bytes_received = (size_t)received;
+    }
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Sends several buffers as one contiguous byte stream.
+ *
+ * Plain connections hand the vector to sendmsg() directly. TLS has no gather write,
+ * so vectors up to one record are coalesced and sent as a single TLS record; larger
+ * ones are written buffer by buffer.
+ *
+ * @param conn Pointer to an established SecureConnection.
+ * @param iov Buffers to send, in order.
+ * @param iovcnt Number of buffers.
+ * @param bytes_sent Pointer to store the total number of bytes sent.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or SECURE_COMM_ERR_SEND on failure.
+ */
+SecureCommError secure_sendv(SecureConnection* conn, const struct iovec* iov, int iovcnt, size_t* bytes_sent) {
+    if (conn == NULL || (iov == NULL && iovcnt > 0) || iovcnt < 0 || bytes_sent == NULL) {
+        fprintf(stderr, "secure_sendv: Invalid arguments\n");
+        return SECURE_COMM_ERR_SEND;
+    }
+
+    size_t total = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        total += iov[i].iov_len;
+    }
+
+    if (conn->ssl) {
+        if (total <= TLS_RECORD_MAX) {
+            unsigned char record[TLS_RECORD_MAX];
+            size_t used = 0;
+            for (int i = 0; i < iovcnt; i++) {
+                memcpy(record + used, iov[i].iov_base, iov[i].iov_len);
+                used += iov[i].iov_len;
+            }
+            if (tls_write_all(conn, record, used) != SECURE_COMM_SUCCESS) {
+                return SECURE_COMM_ERR_SEND;
+            }
+        } else {
+            for (int i = 0; i < iovcnt; i++) {
+                if (tls_write_all(conn, iov[i].iov_base, iov[i].iov_len) != SECURE_COMM_SUCCESS) {
+                    return SECURE_COMM_ERR_SEND;
+                }
+            }
+        }
+        connection_count_sent(conn, total);
+        *bytes_sent = total;
+        return SECURE_COMM_SUCCESS;
+    }
+
+    // sendmsg may stop part-way through any buffer; resume from there
+    struct iovec local[SECURE_SENDV_MAX_IOV];
+    if (iovcnt > SECURE_SENDV_MAX_IOV) {
+        fprintf(stderr, "secure_sendv: Too many buffers (%d > %d)\n", iovcnt, SECURE_SENDV_MAX_IOV);
+        return SECURE_COMM_ERR_SEND;
+    }
+    memcpy(local, iov, (size_t)iovcnt * sizeof(struct iovec));
+
+    struct iovec* cur = local;
+    int remaining = iovcnt;
+    while (remaining > 0) {
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = cur;
+        msg.msg_iovlen = (size_t)remaining;
+
+        ssize_t sent = sendmsg(conn->socket_fd, &msg, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            fprintf(stderr, "secure_sendv: sendmsg failed: %s\n", strerror(errno));
+            return SECURE_COMM_ERR_SEND;
+        }
+
+        size_t left = (size_t)sent;
+        while (remaining > 0 && left >= cur->iov_len) {
+            left -= cur->iov_len;
+            cur++;
+            remaining--;
+        }
+        if (remaining > 0) {
+            cur->iov_base = (unsigned char*)cur->iov_base + left;
+            cur->iov_len -= left;
+        }
+    }
+
+    connection_count_sent(conn, total);
+    *bytes_sent = total;
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Receives into several buffers, filling them in order.
+ *
+ * Waits until at least one byte is available, then returns whatever is already
+ * buffered without blocking again, like recv().
+ *
+ * @param conn Pointer to an established SecureConnection.
+ * @param iov Buffers to fill, in order.
+ * @param iovcnt Number of buffers.
+ * @param bytes_received Pointer to store the total number of bytes received.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or SECURE_COMM_ERR_RECV on failure or close.
+ */
+SecureCommError secure_recvv(SecureConnection* conn, const struct iovec* iov, int iovcnt, size_t* bytes_received) {
+    if (conn == NULL || iov == NULL || iovcnt <= 0 || bytes_received == NULL) {
+        fprintf(stderr, "secure_recvv: Invalid arguments\n");
+        return SECURE_COMM_ERR_RECV;
+    }
+
+    if (!conn->ssl) {
+        ssize_t received;
+        do {
+            received = readv(conn->socket_fd, iov, iovcnt);
+        } while (received < 0 && errno == EINTR);
+
+        if (received <= 0) {
+            if (received < 0) {
+                fprintf(stderr, "secure_recvv: readv failed: %s\n", strerror(errno));
+            }
+            return SECURE_COMM_ERR_RECV;
+        }
+        connection_count_received(conn, (size_t)received);
+        *bytes_received = (size_t)received;
+        return SECURE_COMM_SUCCESS;
+    }
+
+    // First buffer blocks until data arrives; the rest only drain decrypted bytes already held
+    size_t total = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        if (iov[i].iov_len == 0) {
+            continue;
+        }
+        if (total > 0) {
+            pthread_mutex_lock(&conn->ssl_lock);
+            int pending = SSL_pending(conn->ssl);
+            pthread_mutex_unlock(&conn->ssl_lock);
+            if (pending <= 0) {
+                break;
+            }
+        }
+
+        size_t received = 0;
+        SecureCommError ret = tls_read_some(conn, iov[i].iov_base, iov[i].iov_len, &received);
+        if (ret != SECURE_COMM_SUCCESS) {
+            if (total > 0) {
+                break;
+            }
+            return ret;
+        }
+        total += received;
+        if (received < iov[i].iov_len) {
+            break;
+        }
+    }
+
+    connection_count_received(conn, total);
+    *bytes_received = total;
+    return SECURE_COMM_SUCCESS;
+}
+
+// Largest single sendfile / SSL_sendfile call
+#define SEND_FILE_MAX_CHUNK (1u << 30)
+
+/**
+ * @brief Fills SecureFileSendOptions with the defaults: the whole file, sent raw, zero-copy allowed.
+ *
+ * @param options The options to fill.
+ */
+void secure_file_send_options_defaults(SecureFileSendOptions* options) {
+    if (options == NULL) {
+        return;
+    }
+    memset(options, 0, sizeof(SecureFileSendOptions));
+    options->level = 6;
+    options->window_size = SECURE_SEND_FILE_DEFAULT_WINDOW;
+    options->zero_copy = 1;
+}
+
+/**
+ * @brief Pipeline emit callback writing frames to the connection.
+ */
+static SecureCommError send_file_emit(const unsigned char* frame, size_t len, void* user_data) {
+    ssize_t sent = 0;
+    return secure_send((SecureConnection*)user_data, frame, len, &sent);
+}
+
+/**
+ * @brief Sends file bytes without copying them through userspace.
+ *
+ * Plain sockets use sendfile(2); TLS connections with kTLS use SSL_sendfile, so the
+ * kernel (or the NIC) encrypts the records.
+ */
+static SecureCommError send_file_kernel(SecureConnection* conn, int fd, uint64_t offset, uint64_t length,
+                                        uint64_t* done) {
+    while (*done < length) {
+        size_t chunk = length - *done < SEND_FILE_MAX_CHUNK ? (size_t)(length - *done) : SEND_FILE_MAX_CHUNK;
+        ssize_t sent;
+
+        if (conn->ssl) {
+            pthread_mutex_lock(&conn->ssl_lock);
+            sent = (ssize_t)SSL_sendfile(conn->ssl, fd, (off_t)(offset + *done), chunk, 0);
+            int ssl_error = sent > 0 ? SSL_ERROR_NONE : SSL_get_error(conn->ssl, (int)sent);
+            pthread_mutex_unlock(&conn->ssl_lock);
+
+            if (sent <= 0) {
+                if ((ssl_error == SSL_ERROR_WANT_READ || ssl_error == SSL_ERROR_WANT_WRITE) && tls_wait(conn, ssl_error)) {
+                    continue;
+                }
+                fprintf(stderr, "secure_send_file: SSL_sendfile failed with error %d\n", ssl_error);
+                return SECURE_COMM_ERR_SEND;
+            }
+        } else {
+            off_t position = (off_t)(offset + *done);
+            sent = sendfile(conn->socket_fd, fd, &position, chunk);
+            if (sent < 0 && errno == EINTR) {
+                continue;
+            }
+            if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) && tls_wait(conn, SSL_ERROR_WANT_WRITE)) {
+                continue;
+            }
+            if (sent <= 0) {
+                fprintf(stderr, "secure_send_file: sendfile failed: %s\n", sent < 0 ? strerror(errno) : "file truncated");
+                return SECURE_COMM_ERR_SEND;
+            }
+        }
+
+        connection_count_sent(conn, (size_t)sent);
+        *done += (uint64_t)sent;
+    }
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Reads the file one window at a time and sends it through the pipeline or as it is.
+ *
+ * Windows are read with pread into one pooled buffer rather than mapped: a mapping of a
+ * file that another process truncates mid-send raises SIGBUS on the next page touched,
+ * while pread just comes up short, and that ends the transfer with an error.
+ *
+ * With a cipher every window but the last ends with a flush, so *done only counts bytes
+ * whose records have all been sent.
+ */
+static SecureCommError send_file_buffered(SecureConnection* conn, int fd, uint64_t offset, uint64_t length,
+                                          const SecureFileSendOptions* options, uint64_t* done) {
+    PipelineWriter* writer = NULL;
+    if (options->cipher != NULL) {
+        SecureCommError ret = pipeline_writer_create(options->cipher, options->level, options->record_size,
+                                                     send_file_emit, conn, &writer);
+        if (ret != SECURE_COMM_SUCCESS) {
+            return ret;
+        }
+    }
+
+    size_t window_size = options->window_size > 0 ? options->window_size : SECURE_SEND_FILE_DEFAULT_WINDOW;
+    if (window_size > length) {
+        window_size = (size_t)length;
+    }
+    SecureBuffer* buffer = NULL;
+    SecureCommError ret = SECURE_COMM_SUCCESS;
+    if (length > 0 && (ret = buffer_pool_get(NULL, window_size, &buffer)) != SECURE_COMM_SUCCESS) {
+        pipeline_writer_destroy(writer);
+        return ret;
+    }
+    posix_fadvise(fd, (off_t)offset, (off_t)length, POSIX_FADV_SEQUENTIAL);
+    unsigned char* data = buffer != NULL ? secure_buffer_data(buffer) : NULL;
+
+    while (*done < length && ret == SECURE_COMM_SUCCESS) {
+        size_t window = length - *done < window_size ? (size_t)(length - *done) : window_size;
+        size_t got = 0;
+        while (got < window) {
+            ssize_t n = pread(fd, data + got, window - got, (off_t)(offset + *done + got));
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                fprintf(stderr, "secure_send_file: read failed: %s\n", n < 0 ? strerror(errno) : "file truncated");
+                break;
+            }
+            got += (size_t)n;
+        }
+        if (got < window) {
+            ret = SECURE_COMM_ERR_SEND;
+            break;
+        }
+        int last = *done + window == length;
+
+        if (writer != NULL) {
+            ret = pipeline_writer_write(writer, data, window);
+            if (ret == SECURE_COMM_SUCCESS) {
+                ret = last ? pipeline_writer_finish(writer) : pipeline_writer_flush(writer);
+            }
+        } else {
+            ssize_t sent = 0;
+            ret = secure_send(conn, data, window, &sent);
+        }
+
+        if (ret == SECURE_COMM_SUCCESS) {
+            *done += window;
+        }
+    }
+
+    // An empty range still ends the stream, so the peer sees a complete (empty) file
+    if (writer != NULL && ret == SECURE_COMM_SUCCESS && length == 0) {
+        ret = pipeline_writer_finish(writer);
+    }
+    secure_buffer_release(buffer);
+    pipeline_writer_destroy(writer);
+    return ret;
+}
+
+/**
+ * @brief Sends a range of a file over the connection.
+ *
+ * @param conn Pointer to an established SecureConnection.
+ * @param path File to send.
+ * @param options Range, sealing and window settings, or NULL for the defaults.
+ * @param bytes_sent Optional pointer to store how many file bytes, from options->offset, were sent.
+ *                   Also set on failure, so a transfer can resume at offset + *bytes_sent.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError secure_send_file(SecureConnection* conn, const char* path, const SecureFileSendOptions* options,
+                                 uint64_t* bytes_sent) {
+    if (bytes_sent != NULL) {
+        *bytes_sent = 0;
+    }
+    if (conn == NULL || path == NULL) {
+        fprintf(stderr, "secure_send_file: Invalid arguments\n");
+        return SECURE_COMM_ERR_SEND;
+    }
+
+    SecureFileSendOptions defaults;
+    if (options == NULL) {
+        secure_file_send_options_defaults(&defaults);
+        options = &defaults;
+    }
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "secure_send_file: Cannot open %s: %s\n", path, strerror(errno));
+        return SECURE_COMM_ERR_SEND;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        fprintf(stderr, "secure_send_file: %s is not a regular file\n", path);
+        close(fd);
+        return SECURE_COMM_ERR_SEND;
+    }
+
+    uint64_t size = (uint64_t)st.st_size;
+    uint64_t length = options->length;
+    if (options->offset > size || length > size - options->offset) {
+        fprintf(stderr, "secure_send_file: Range %llu+%llu is outside %s (%llu bytes)\n",
+                (unsigned long long)options->offset, (unsigned long long)length, path, (unsigned long long)size);
+        close(fd);
+        return SECURE_COMM_ERR_SEND;
+    }
+    if (length == 0) {
+        length = size - options->offset;
+    }
+
+    // Raw bytes go straight from the page cache to the socket when nothing in userspace has to touch them
+    uint64_t done = 0;
+    SecureCommError ret;
+    if (options->cipher == NULL && options->zero_copy && (conn->ssl == NULL || connection_ktls_send(conn))) {
+        ret = send_file_kernel(conn, fd, options->offset, length, &done);
+    } else {
+        ret = send_file_buffered(conn, fd, options->offset, length, options, &done);
+    }
+    close(fd);
+
+    if (bytes_sent != NULL) {
+        *bytes_sent = done;
+    }
+    return ret;
+}
+
+/**
+ * @brief Receives exactly len bytes, however the peer's writes were split.
+ */
+static SecureCommError recv_exact(SecureConnection* conn, unsigned char* buffer, size_t len) {
+    size_t got = 0;
+    while (got < len) {
+        ssize_t n = 0;
+        SecureCommError ret = secure_recv(conn, buffer + got, len - got, &n);
+        if (ret != SECURE_COMM_SUCCESS) {
+            return ret;
         }
+        got += (size_t)n;
+    }
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Sends one HELLO frame carrying a suite mask, a suite and a fresh random value.
+ */
+static SecureCommError send_hello(SecureConnection* conn, unsigned int mask, CipherSuite suite,
+                                  unsigned char* random) {
+    if (!RAND_bytes(random, SECURE_HELLO_RANDOM_SIZE)) {
+        fprintf(stderr, "send_hello: Failed to generate the HELLO random\n");
+        return SECURE_COMM_ERR_SESSION;
+    }
+
+    unsigned char frame[SECURE_FRAME_HEADER_SIZE + SECURE_HELLO_SIZE];
+    FrameHeader header = { SECURE_HELLO_SIZE, FRAME_TYPE_HELLO, 0, 0, 0 };
+    frame_encode_header(&header, frame);
+    cipher_hello_encode(mask, suite, random, frame + SECURE_FRAME_HEADER_SIZE);
+
+    ssize_t sent = 0;
+    return secure_send(conn, frame, sizeof(frame), &sent);
+}
+
+/**
+ * @brief Reads one HELLO frame.
+ *
+ * Reads exactly one frame so no record bytes are consumed before the receiver's
+ * frame decoder takes over; the peer sends nothing else until the exchange is done.
+ */
+static SecureCommError recv_hello(SecureConnection* conn, unsigned int* mask, CipherSuite* suite,
+                                  unsigned char* random) {
+    unsigned char frame[SECURE_FRAME_HEADER_SIZE + SECURE_HELLO_SIZE];
+    SecureCommError ret = recv_exact(conn, frame, SECURE_FRAME_HEADER_SIZE);
+    if (ret != SECURE_COMM_SUCCESS) {
+        return ret;
+    }
+
+    FrameHeader header;
+    frame_decode_header(frame, &header);
+    if (header.type != FRAME_TYPE_HELLO || header.length != SECURE_HELLO_SIZE) {
+        fprintf(stderr, "recv_hello: Expected HELLO, got frame type %u (%u bytes)\n", header.type, header.length);
+        return SECURE_COMM_ERR_FRAME;
+    }
+
+    ret = recv_exact(conn, frame + SECURE_FRAME_HEADER_SIZE, SECURE_HELLO_SIZE);
+    if (ret != SECURE_COMM_SUCCESS) {
+        return ret;
+    }
+    return cipher_hello_decode(frame + SECURE_FRAME_HEADER_SIZE, SECURE_HELLO_SIZE, mask, suite, random);
+}
+
+/**
+ * @brief Client side of suite negotiation on a blocking connection.
+ *
+ * @param conn The connection.
+ * @param preferred Suite to ask for (usually cipher_suite_preferred()).
+ * @param suite Pointer to store the suite chosen by the server.
+ * @param salt Buffer of SECURE_CONNECTION_SALT_SIZE bytes for the connection salt.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError cipher_negotiate_client(SecureConnection* conn, CipherSuite preferred, CipherSuite* suite,
+                                        unsigned char* salt) {
+    if (conn == NULL || suite == NULL || salt == NULL) {
+        fprintf(stderr, "cipher_negotiate_client: Invalid arguments\n");
+        return SECURE_COMM_ERR_SESSION;
+    }
+
+    unsigned int mask = cipher_suite_supported_mask();
+    SecureCommError ret = send_hello(conn, mask, preferred, salt);
+    if (ret != SECURE_COMM_SUCCESS) {
+        return ret;
+    }
+
+    unsigned int server_mask = 0;
+    CipherSuite chosen = CIPHER_SUITE_COUNT;
+    ret = recv_hello(conn, &server_mask, &chosen, salt + SECURE_HELLO_RANDOM_SIZE);
+    if (ret != SECURE_COMM_SUCCESS) {
+        return ret;
+    }
+
+    // The server may only pick a suite this side offered
+    if (!(mask & CIPHER_SUITE_MASK(chosen))) {
+        fprintf(stderr, "cipher_negotiate_client: Server chose unsupported suite %d\n", (int)chosen);
+        return SECURE_COMM_ERR_SESSION;
+    }
+    *suite = chosen;
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Server side of suite negotiation on a blocking connection.
+ *
+ * @param conn The connection.
+ * @param suite Pointer to store the chosen suite.
+ * @param salt Buffer of SECURE_CONNECTION_SALT_SIZE bytes for the connection salt.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError cipher_negotiate_server(SecureConnection* conn, CipherSuite* suite, unsigned char* salt) {
+    if (conn == NULL || suite == NULL || salt == NULL) {
+        fprintf(stderr, "cipher_negotiate_server: Invalid arguments\n");
+        return SECURE_COMM_ERR_SESSION;
+    }
+
+    unsigned int client_mask = 0;
+    CipherSuite preferred = CIPHER_SUITE_COUNT;
+    SecureCommError ret = recv_hello(conn, &client_mask, &preferred, salt);
+    if (ret != SECURE_COMM_SUCCESS) {
+        return ret;
+    }
+
+    CipherSuite chosen = cipher_suite_negotiate(client_mask, preferred);
+    if (chosen == CIPHER_SUITE_COUNT) {
+        fprintf(stderr, "cipher_negotiate_server: No cipher suite in common with the client\n");
+        return SECURE_COMM_ERR_SESSION;
+    }
+
+    ret = send_hello(conn, cipher_suite_supported_mask(), chosen, salt + SECURE_HELLO_RANDOM_SIZE);
+    if (ret != SECURE_COMM_SUCCESS) {
+        return ret;
+    }
+    *suite = chosen;
+    return SECURE_COMM_SUCCESS;
+}
 
-        // Free the SSL context
-        if (conn->ssl_ctx) {
-            SSL_CTX_free(conn->ssl_ctx);
+/**
+ * @brief Shuts down both directions of the connection without freeing it.
+ *
+ * Wakes a thread blocked in secure_recv, which then returns SECURE_COMM_ERR_RECV.
+ * Call close_connection once that thread has finished.
+ *
+ * @param conn Pointer to the SecureConnection.
+ */
+void connection_shutdown(SecureConnection* conn) {
+    if (conn) {
+#ifdef _WIN32
+        shutdown(conn->socket_fd, SD_BOTH);
+#else
+        shutdown(conn->socket_fd, SHUT_RDWR);
+#endif
+    }
+}
+
+/**
+ * @brief Closes the secure connection and frees resources.
+ *
+ * This function gracefully shuts down the SSL connection, closes the socket,
+ * and frees any allocated memory associated with the connection.
+ *
+ * @param conn Pointer to the SecureConnection to close.
+ */
+void close_connection(SecureConnection* conn) {
+    if (conn) {
+        // Shutdown the SSL connection
+        if (conn->ssl) {
+            SSL_shutdown(conn->ssl);
+            if (cache_key_index >= 0) {
+                free(SSL_get_ex_data(conn->ssl, cache_key_index));
+            }
+            SSL_free(conn->ssl);
         }
 
         // Close the socket
@@ -241,8 +1589,501 @@ void close_connection(SecureConnection* conn) {
         close(conn->socket_fd);
 #endif
         // Free the SecureConnection structure
-        free(conn);
+        connection_free(conn);
+    }
+}
+
+// Result of a non-blocking look at a connection's socket
+typedef enum {
+    PROBE_IDLE = 0,     // Open, nothing to read
+    PROBE_PENDING,      // Open, with unread bytes
+    PROBE_CLOSED        // The peer closed the connection or it failed
+} probe_result_t;
+
+/**
+ * @brief Looks at a connection's socket without blocking or consuming application data.
+ */
+static probe_result_t connection_probe(SecureConnection* conn) {
+    struct pollfd pfd;
+    pfd.fd = conn->socket_fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    int ready;
+    while ((ready = poll(&pfd, 1, 0)) < 0 && errno == EINTR) {
+    }
+    if (ready < 0 || (pfd.revents & (POLLERR | POLLNVAL))) {
+        return PROBE_CLOSED;
+    }
+    if (ready == 0) {
+        return PROBE_IDLE;
+    }
+
+    if (conn->ssl) {
+        // Lets OpenSSL process records that carry no data, such as session tickets
+        unsigned char byte;
+        size_t peeked = 0;
+        pthread_mutex_lock(&conn->ssl_lock);
+        int ok = SSL_peek_ex(conn->ssl, &byte, 1, &peeked);
+        int ssl_error = ok ? SSL_ERROR_NONE : SSL_get_error(conn->ssl, 0);
+        pthread_mutex_unlock(&conn->ssl_lock);
+        if (ok) {
+            return PROBE_PENDING;
+        }
+        return ssl_error == SSL_ERROR_WANT_READ || ssl_error == SSL_ERROR_WANT_WRITE ? PROBE_IDLE : PROBE_CLOSED;
+    }
+
+    unsigned char byte;
+    ssize_t peeked = recv(conn->socket_fd, &byte, 1, MSG_PEEK | MSG_DONTWAIT);
+    if (peeked > 0) {
+        return PROBE_PENDING;
+    }
+    if (peeked < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+        return PROBE_IDLE;
+    }
+    return PROBE_CLOSED;
+}
+
+/**
+ * @brief Checks, without blocking, whether the peer is still connected.
+ *
+ * @param conn Pointer to an established SecureConnection.
+ *
+ * @return 1 if the connection is open, 0 if the peer closed it or it failed.
+ */
+int connection_is_alive(SecureConnection* conn) {
+    return conn && connection_probe(conn) != PROBE_CLOSED ? 1 : 0;
+}
+
+// An idle connection waiting in a pool
+typedef struct pool_entry {
+    SecureConnection* conn;
+    uint64_t idle_since_ms;     // When it was released
+    uint64_t checked_ms;        // When it was last released, pinged or checked
+    struct pool_entry* next;
+} pool_entry_t;
+
+// Idle connections to one address and port, most recently released first
+typedef struct pool_host {
+    char key[CONNECTION_PEER_SIZE];
+    pool_entry_t* idle;
+    size_t idle_count;
+    struct pool_host* next;
+} pool_host_t;
+
+struct ConnectionPool {
+    ConnectionPoolConfig config;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;        // Signals the maintenance thread to stop
+    pthread_t thread;
+    int has_thread;
+    int stopping;
+    pool_host_t* hosts;
+    ConnectionPoolStats stats;
+};
+
+/**
+ * @brief Fills ConnectionPoolConfig with the defaults.
+ *
+ * @param config The configuration to fill.
+ */
+void connection_pool_config_defaults(ConnectionPoolConfig* config) {
+    if (config == NULL) {
+        return;
+    }
+    memset(config, 0, sizeof(*config));
+    config->max_idle_per_host = 4;
+    config->idle_timeout_ms = 60000;
+    config->keepalive_interval_ms = 15000;
+    config->connect_timeout_ms = SECURE_CONNECT_DEFAULT_TIMEOUT_MS;
+    config->use_tls = 1;
+}
+
+/**
+ * @brief Finds the bucket of a key, creating it if asked. Called with the pool lock held.
+ */
+static pool_host_t* pool_find_host(ConnectionPool* pool, const char* key, int create) {
+    for (pool_host_t* host = pool->hosts; host != NULL; host = host->next) {
+        if (strcmp(host->key, key) == 0) {
+            return host;
+        }
+    }
+    if (!create) {
+        return NULL;
+    }
+    pool_host_t* host = (pool_host_t*)calloc(1, sizeof(pool_host_t));
+    if (host == NULL) {
+        return NULL;
+    }
+    snprintf(host->key, sizeof(host->key), "%s", key);
+    host->next = pool->hosts;
+    pool->hosts = host;
+    return host;
+}
+
+/**
+ * @brief Puts an idle connection at the front of its host's list.
+ *
+ * Called with the pool lock held.
+ *
+ * @return 1 if kept, 0 if the host is full (or the pool is stopping) and the caller must close it.
+ */
+static int pool_push(ConnectionPool* pool, pool_entry_t* entry) {
+    if (pool->stopping) {
+        return 0;
+    }
+    pool_host_t* host = pool_find_host(pool, entry->conn->peer, 1);
+    if (host == NULL || host->idle_count >= pool->config.max_idle_per_host) {
+        return 0;
+    }
+    entry->next = host->idle;
+    host->idle = entry;
+    host->idle_count++;
+    pool->stats.idle++;
+    return 1;
+}
+
+/**
+ * @brief Enables TCP keepalive on a pooled socket, probing after the pool's check interval.
+ */
+static void pool_enable_keepalive(const ConnectionPool* pool, SecureConnection* conn) {
+    int on = 1;
+    setsockopt(conn->socket_fd, SOL_SOCKET, SO_KEEPALIVE, &on, sizeof(on));
+#ifdef TCP_KEEPIDLE
+    if (pool->config.keepalive_interval_ms > 0) {
+        int idle_s = pool->config.keepalive_interval_ms / 1000;
+        int count = 3;
+        if (idle_s < 1) {
+            idle_s = 1;
+        }
+        setsockopt(conn->socket_fd, IPPROTO_TCP, TCP_KEEPIDLE, &idle_s, sizeof(idle_s));
+        setsockopt(conn->socket_fd, IPPROTO_TCP, TCP_KEEPINTVL, &idle_s, sizeof(idle_s));
+        setsockopt(conn->socket_fd, IPPROTO_TCP, TCP_KEEPCNT, &count, sizeof(count));
+    }
+#else
+    (void)pool;
+#endif
+}
+
+/**
+ * @brief Maintenance thread: checks the idle connections every keepalive interval.
+ */
+static void* pool_thread(void* arg) {
+    ConnectionPool* pool = (ConnectionPool*)arg;
+    unsigned int interval_ms = (unsigned int)pool->config.keepalive_interval_ms;
+
+    pthread_mutex_lock(&pool->lock);
+    while (!pool->stopping) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += interval_ms / 1000;
+        deadline.tv_nsec += (long)(interval_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        pthread_cond_timedwait(&pool->wake, &pool->lock, &deadline);
+        if (pool->stopping) {
+            break;
+        }
+        pthread_mutex_unlock(&pool->lock);
+        connection_pool_maintain(pool);
+        pthread_mutex_lock(&pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+/**
+ * @brief Creates a connection pool.
+ *
+ * @param config Pool settings, or NULL for the defaults.
+ * @param pool Pointer to store the new pool.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError connection_pool_create(const ConnectionPoolConfig* config, ConnectionPool** pool) {
+    if (pool == NULL) {
+        fprintf(stderr, "connection_pool_create: Invalid arguments\n");
+        return SECURE_COMM_ERR_CONFIG;
+    }
+    *pool = NULL;
+
+    ConnectionPoolConfig cfg;
+    if (config) {
+        cfg = *config;
+    } else {
+        connection_pool_config_defaults(&cfg);
+    }
+    if (cfg.idle_timeout_ms < 0 || cfg.keepalive_interval_ms < 0 || cfg.connect_timeout_ms < 0) {
+        fprintf(stderr, "connection_pool_create: Timeouts must not be negative\n");
+        return SECURE_COMM_ERR_CONFIG;
+    }
+
+    ConnectionPool* new_pool = (ConnectionPool*)calloc(1, sizeof(ConnectionPool));
+    if (new_pool == NULL) {
+        fprintf(stderr, "connection_pool_create: Memory allocation failed\n");
+        return SECURE_COMM_ERR_MEMORY;
+    }
+    new_pool->config = cfg;
+    pthread_mutex_init(&new_pool->lock, NULL);
+    pthread_cond_init(&new_pool->wake, NULL);
+
+    if (cfg.keepalive_interval_ms > 0) {
+        if (pthread_create(&new_pool->thread, NULL, pool_thread, new_pool) != 0) {
+            fprintf(stderr, "connection_pool_create: Cannot start the maintenance thread\n");
+            pthread_cond_destroy(&new_pool->wake);
+            pthread_mutex_destroy(&new_pool->lock);
+            free(new_pool);
+            return SECURE_COMM_ERR_CONFIG;
+        }
+        new_pool->has_thread = 1;
+    }
+
+    *pool = new_pool;
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Hands out a connection to address:port, reusing a healthy idle one when there is one.
+ *
+ * @param pool The pool.
+ * @param address The IP address or hostname to connect to.
+ * @param port The port number to connect on.
+ * @param conn Pointer to store the connection.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or the error of the failed connect.
+ */
+SecureCommError connection_pool_acquire(ConnectionPool* pool, const char* address, int port, SecureConnection** conn) {
+    if (pool == NULL || address == NULL || conn == NULL) {
+        fprintf(stderr, "connection_pool_acquire: Invalid arguments\n");
+        return SECURE_COMM_ERR_ADDRESS;
+    }
+    *conn = NULL;
+
+    char key[CONNECTION_PEER_SIZE];
+    snprintf(key, sizeof(key), "%s:%d", address, port);
+
+    while (1) {
+        pthread_mutex_lock(&pool->lock);
+        pool_host_t* host = pool_find_host(pool, key, 0);
+        pool_entry_t* entry = host ? host->idle : NULL;
+        if (entry) {
+            host->idle = entry->next;
+            host->idle_count--;
+            pool->stats.idle--;
+        }
+        pthread_mutex_unlock(&pool->lock);
+        if (entry == NULL) {
+            break;
+        }
+
+        SecureConnection* idle = entry->conn;
+        free(entry);
+        // Stray bytes would desynchronize the next owner, so they disqualify it as well
+        if (connection_probe(idle) == PROBE_IDLE) {
+            pthread_mutex_lock(&pool->lock);
+            pool->stats.reuses++;
+            pthread_mutex_unlock(&pool->lock);
+            *conn = idle;
+            return SECURE_COMM_SUCCESS;
+        }
+        close_connection(idle);
+        pthread_mutex_lock(&pool->lock);
+        pool->stats.evicted_dead++;
+        pthread_mutex_unlock(&pool->lock);
+    }
+
+    SecureCommError error = SECURE_COMM_SUCCESS;
+    SecureConnection* fresh = pool->config.use_tls
+        ? connect_tls(address, port, pool->config.connect_timeout_ms, &error)
+        : connect_plain(address, port, pool->config.connect_timeout_ms, &error);
+    if (fresh == NULL) {
+        return error;
+    }
+    pool_enable_keepalive(pool, fresh);
+    // The key is the one acquire looks up, whatever create_connection recorded
+    snprintf(fresh->peer, sizeof(fresh->peer), "%s", key);
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stats.connects++;
+    pthread_mutex_unlock(&pool->lock);
+    *conn = fresh;
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Returns a connection obtained from connection_pool_acquire.
+ *
+ * @param pool The pool the connection came from.
+ * @param conn The connection.
+ * @param reusable Non-zero to keep it for a later acquire, 0 to close it.
+ */
+void connection_pool_release(ConnectionPool* pool, SecureConnection* conn, int reusable) {
+    if (conn == NULL) {
+        return;
+    }
+    if (pool == NULL || !reusable || conn->peer[0] == '\0') {
+        close_connection(conn);
+        return;
+    }
+
+    pool_entry_t* entry = (pool_entry_t*)calloc(1, sizeof(pool_entry_t));
+    if (entry == NULL) {
+        close_connection(conn);
+        return;
+    }
+    entry->conn = conn;
+    entry->idle_since_ms = now_ms();
+    entry->checked_ms = entry->idle_since_ms;
+
+    pthread_mutex_lock(&pool->lock);
+    int kept = pool_push(pool, entry);
+    if (!kept) {
+        pool->stats.evicted_idle++;
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    if (!kept) {
+        close_connection(conn);
+        free(entry);
+    }
+}
+
+/**
+ * @brief Checks idle connections now: closes expired or dead ones and pings the
+ *        rest whose keepalive interval has passed.
+ *
+ * Connections due for a check are taken out of the pool while it runs, so the
+ * pings never hold the pool lock.
+ *
+ * @param pool The pool.
+ */
+void connection_pool_maintain(ConnectionPool* pool) {
+    if (pool == NULL) {
+        return;
+    }
+    uint64_t now = now_ms();
+    uint64_t idle_timeout = (uint64_t)pool->config.idle_timeout_ms;
+    uint64_t interval = (uint64_t)pool->config.keepalive_interval_ms;
+    pool_entry_t* expired = NULL;
+    pool_entry_t* due = NULL;
+
+    pthread_mutex_lock(&pool->lock);
+    for (pool_host_t* host = pool->hosts; host != NULL; host = host->next) {
+        pool_entry_t** link = &host->idle;
+        while (*link != NULL) {
+            pool_entry_t* entry = *link;
+            int is_expired = idle_timeout > 0 && now - entry->idle_since_ms >= idle_timeout;
+            if (is_expired || now - entry->checked_ms >= interval) {
+                *link = entry->next;
+                host->idle_count--;
+                pool->stats.idle--;
+                if (is_expired) {
+                    entry->next = expired;
+                    expired = entry;
+                } else {
+                    entry->next = due;
+                    due = entry;
+                }
+                continue;
+            }
+            link = &entry->next;
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    uint64_t closed_idle = 0;
+    uint64_t closed_dead = 0;
+    uint64_t pings = 0;
+    while (expired) {
+        pool_entry_t* next = expired->next;
+        close_connection(expired->conn);
+        free(expired);
+        closed_idle++;
+        expired = next;
+    }
+
+    while (due) {
+        pool_entry_t* next = due->next;
+        int healthy = connection_probe(due->conn) == PROBE_IDLE;
+        if (healthy && pool->config.ping) {
+            healthy = pool->config.ping(due->conn, pool->config.ping_user_data) == SECURE_COMM_SUCCESS &&
+                      connection_probe(due->conn) == PROBE_IDLE;
+        }
+        pings++;
+
+        int kept = 0;
+        if (healthy) {
+            due->checked_ms = now_ms();
+            pthread_mutex_lock(&pool->lock);
+            kept = pool_push(pool, due);
+            if (!kept) {
+                pool->stats.evicted_idle++;
+            }
+            pthread_mutex_unlock(&pool->lock);
+        } else {
+            closed_dead++;
+        }
+        if (!kept) {
+            close_connection(due->conn);
+            free(due);
+        }
+        due = next;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stats.evicted_idle += closed_idle;
+    pool->stats.evicted_dead += closed_dead;
+    pool->stats.pings += pings;
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/**
+ * @brief Copies the pool counters.
+ *
+ * @param pool The pool.
+ * @param stats Pointer to store the counters.
+ */
+void connection_pool_stats(ConnectionPool* pool, ConnectionPoolStats* stats) {
+    if (pool == NULL || stats == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&pool->lock);
+    *stats = pool->stats;
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/**
+ * @brief Stops the maintenance thread and closes every idle connection.
+ */
+void connection_pool_destroy(ConnectionPool* pool) {
+    if (pool == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&pool->lock);
+    pool->stopping = 1;
+    pthread_cond_signal(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+    if (pool->has_thread) {
+        pthread_join(pool->thread, NULL);
     }
+
+    pool_host_t* host = pool->hosts;
+    while (host) {
+        pool_host_t* next_host = host->next;
+        pool_entry_t* entry = host->idle;
+        while (entry) {
+            pool_entry_t* next = entry->next;
+            close_connection(entry->conn);
+            free(entry);
+            entry = next;
+        }
+        free(host);
+        host = next_host;
+    }
+    pthread_cond_destroy(&pool->wake);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool);
 }
 
 /**
@@ -255,6 +2096,13 @@ void cleanup_networking() {
 #ifdef _WIN32
     WSACleanup();
 #endif
+    // Release the shared contexts and every cached session
+    session_cache_clear();
+    SSL_CTX_free(client_ctx);
+    client_ctx = NULL;
+    SSL_CTX_free(server_ctx);
+    server_ctx = NULL;
+
     // Cleanup OpenSSL algorithms
     EVP_cleanup();
     ERR_free_strings();
@@ -0,0 +1,460 @@
+// pipeline.c
+
+#include "secure_comm.h"
+
+#include <stdio.h>      // For fprintf
+#include <stdlib.h>     // For malloc, free
+#include <string.h>     // For memset
+#include <limits.h>     // For INT_MAX
+
+#include <zlib.h>       // For the streaming deflate/inflate API
+
+// Largest chunk handed to zlib at once (avail_in is a 32-bit uInt)
+#define PIPELINE_MAX_CHUNK (1u << 30)
+
+// Size of the reader's inflate output window
+#define PIPELINE_OUTPUT_SIZE (64u * 1024u)
+
+#define IV_SIZE 12
+#define TAG_SIZE 16
+
+// Definition of the opaque PipelineWriter structure
+struct PipelineWriter {
+    SecureCipher* cipher;       // Seals records (not owned)
+    z_stream strm;              // Long-lived deflate state
+    unsigned char* staging;     // Compressed bytes awaiting encryption
+    unsigned char* frame;       // header || IV || tag || ciphertext
+    size_t record_size;         // Capacity of staging
+    pipeline_emit_cb emit;      // Receives finished frames
+    void* user_data;            // Passed to emit
+    uint64_t bytes_in;          // Plaintext bytes consumed
+    uint64_t bytes_out;         // Frame bytes emitted
+};
+
+// Definition of the opaque PipelineReader structure
+struct PipelineReader {
+    SecureCipher* cipher;       // Opens records (not owned)
+    ReplayWindow* replay;       // Optional replay check (not owned)
+    z_stream strm;              // Long-lived inflate state
+    unsigned char* staging;     // Decrypted, still compressed record
+    unsigned char* output;      // Inflate output window
+    size_t max_record;          // Capacity of staging
+    pipeline_output_cb deliver; // Receives plaintext
+    void* user_data;            // Passed to deliver
+};
+
+/**
+ * @brief Encrypts the staged compressed bytes into the frame buffer and emits it.
+ */
+static SecureCommError writer_seal(PipelineWriter* writer, uint8_t flags) {
+    size_t len = writer->record_size - writer->strm.avail_out;
+    unsigned char* record = writer->frame + SECURE_FRAME_HEADER_SIZE;
+    int ciphertext_len = 0;
+
+    SecureCommError ret = cipher_encrypt(writer->cipher, writer->staging, (int)len, record,
+                                         record + SECURE_RECORD_OVERHEAD, &ciphertext_len,
+                                         record + IV_SIZE);
+    if (ret != SECURE_COMM_SUCCESS) {
+        return ret;
+    }
+
+    FrameHeader header = { (uint32_t)(SECURE_RECORD_OVERHEAD + ciphertext_len), FRAME_TYPE_STREAM, flags,
+                           COMPRESSION_CODEC_ZLIB, (uint8_t)cipher_get_suite(writer->cipher) };
+    frame_encode_header(&header, writer->frame);
+
+    size_t frame_len = SECURE_FRAME_HEADER_SIZE + header.length;
+    ret = writer->emit(writer->frame, frame_len, writer->user_data);
+    if (ret != SECURE_COMM_SUCCESS) {
+        return ret;
+    }
+    writer->bytes_out += frame_len;
+
+    // Start the next record
+    writer->strm.next_out = writer->staging;
+    writer->strm.avail_out = (uInt)writer->record_size;
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Runs deflate with the given flush mode, sealing every record that fills up.
+ *
+ * With Z_NO_FLUSH a partially filled record stays staged for the next call.
+ */
+static SecureCommError writer_deflate(PipelineWriter* writer, int flush) {
+    for (;;) {
+        int zret = deflate(&writer->strm, flush);
+        if (zret == Z_STREAM_ERROR) {
+            fprintf(stderr, "writer_deflate: deflate failed with Z_STREAM_ERROR\n");
+            return SECURE_COMM_ERR_COMPRESS;
+        }
+
+        int done = (flush == Z_FINISH) ? (zret == Z_STREAM_END) : (writer->strm.avail_out != 0);
+        if (!done) {
+            // Record is full: seal it and keep going
+            SecureCommError ret = writer_seal(writer, 0);
+            if (ret != SECURE_COMM_SUCCESS) {
+                return ret;
+            }
+            continue;
+        }
+
+        if (flush == Z_FINISH) {
+            return writer_seal(writer, FRAME_FLAG_END);
+        }
+        if (flush == Z_SYNC_FLUSH && writer->strm.avail_out != writer->record_size) {
+            return writer_seal(writer, 0);
+        }
+        return SECURE_COMM_SUCCESS;
+    }
+}
+
+/**
+ * @brief Creates a streaming compress-then-encrypt writer.
+ *
+ * @param cipher Keyed cipher used to seal records (not owned, must outlive the writer).
+ * @param level Compression level (0-9).
+ * @param record_size Maximum compressed bytes per record (0 for the default).
+ * @param emit Callback receiving each finished frame.
+ * @param user_data Passed to emit.
+ * @param writer Pointer to store the created PipelineWriter.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError pipeline_writer_create(SecureCipher* cipher, int level, size_t record_size,
+                                       pipeline_emit_cb emit, void* user_data,
+                                       PipelineWriter** writer) {
+    if (cipher == NULL || emit == NULL || writer == NULL) {
+        fprintf(stderr, "pipeline_writer_create: Invalid arguments\n");
+        return SECURE_COMM_ERR_INIT;
+    }
+
+    if (level < 0 || level > 9) {
+        fprintf(stderr, "pipeline_writer_create: Invalid compression level %d\n", level);
+        return SECURE_COMM_ERR_COMPRESS;
+    }
+
+    if (record_size == 0) {
+        record_size = SECURE_PIPELINE_DEFAULT_RECORD_SIZE;
+    }
+    if (record_size > SECURE_FRAME_DEFAULT_MAX_PAYLOAD - SECURE_RECORD_OVERHEAD) {
+        fprintf(stderr, "pipeline_writer_create: Record size %zu is too large\n", record_size);
+        return SECURE_COMM_ERR_INIT;
+    }
+
+    PipelineWriter* w = (PipelineWriter*)malloc(sizeof(PipelineWriter));
+    if (w == NULL) {
+        fprintf(stderr, "pipeline_writer_create: Failed to allocate memory for writer\n");
+        return SECURE_COMM_ERR_MEMORY;
+    }
+    memset(w, 0, sizeof(PipelineWriter));
+
+    w->staging = (unsigned char*)malloc(record_size);
+    w->frame = (unsigned char*)malloc(SECURE_FRAME_HEADER_SIZE + SECURE_RECORD_OVERHEAD + record_size);
+    if (w->staging == NULL || w->frame == NULL) {
+        fprintf(stderr, "pipeline_writer_create: Failed to allocate record buffers\n");
+        free(w->staging);
+        free(w->frame);
+        free(w);
+        return SECURE_COMM_ERR_MEMORY;
+    }
+
+    if (deflateInit(&w->strm, level) != Z_OK) {
+        fprintf(stderr, "pipeline_writer_create: deflateInit failed\n");
+        free(w->staging);
+        free(w->frame);
+        free(w);
+        return SECURE_COMM_ERR_COMPRESS;
+    }
+
+    w->cipher = cipher;
+    w->record_size = record_size;
+    w->emit = emit;
+    w->user_data = user_data;
+    w->strm.next_out = w->staging;
+    w->strm.avail_out = (uInt)record_size;
+
+    *writer = w;
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Feeds a chunk of plaintext into the stream.
+ *
+ * @param writer The writer.
+ * @param data Plaintext bytes.
+ * @param len Number of bytes.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError pipeline_writer_write(PipelineWriter* writer, const void* data, size_t len) {
+    if (writer == NULL || (data == NULL && len > 0)) {
+        fprintf(stderr, "pipeline_writer_write: Invalid arguments\n");
+        return SECURE_COMM_ERR_COMPRESS;
+    }
+
+    const unsigned char* bytes = (const unsigned char*)data;
+    while (len > 0) {
+        size_t chunk = len < PIPELINE_MAX_CHUNK ? len : PIPELINE_MAX_CHUNK;
+        writer->strm.next_in = (Bytef*)bytes;
+        writer->strm.avail_in = (uInt)chunk;
+
+        SecureCommError ret = writer_deflate(writer, Z_NO_FLUSH);
+        writer->strm.next_in = NULL;
+        writer->strm.avail_in = 0;
+        if (ret != SECURE_COMM_SUCCESS) {
+            return ret;
+        }
+
+        writer->bytes_in += chunk;
+        bytes += chunk;
+        len -= chunk;
+    }
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Emits everything written so far without ending the stream.
+ *
+ * @param writer The writer.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError pipeline_writer_flush(PipelineWriter* writer) {
+    if (writer == NULL) {
+        fprintf(stderr, "pipeline_writer_flush: Invalid arguments\n");
+        return SECURE_COMM_ERR_COMPRESS;
+    }
+    return writer_deflate(writer, Z_SYNC_FLUSH);
+}
+
+/**
+ * @brief Ends the stream and emits the final record, flagged FRAME_FLAG_END.
+ *
+ * @param writer The writer.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError pipeline_writer_finish(PipelineWriter* writer) {
+    if (writer == NULL) {
+        fprintf(stderr, "pipeline_writer_finish: Invalid arguments\n");
+        return SECURE_COMM_ERR_COMPRESS;
+    }
+
+    SecureCommError ret = writer_deflate(writer, Z_FINISH);
+
+    // Ready for the next stream whether or not this one made it out
+    deflateReset(&writer->strm);
+    writer->strm.next_out = writer->staging;
+    writer->strm.avail_out = (uInt)writer->record_size;
+    return ret;
+}
+
+/**
+ * @brief Returns plaintext bytes consumed and frame bytes emitted by the writer.
+ */
+void pipeline_writer_stats(const PipelineWriter* writer, uint64_t* bytes_in, uint64_t* bytes_out) {
+    if (bytes_in) {
+        *bytes_in = writer ? writer->bytes_in : 0;
+    }
+    if (bytes_out) {
+        *bytes_out = writer ? writer->bytes_out : 0;
+    }
+}
+
+/**
+ * @brief Destroys a pipeline writer.
+ *
+ * @param writer The writer to destroy.
+ */
+void pipeline_writer_destroy(PipelineWriter* writer) {
+    if (writer == NULL) {
+        return;
+    }
+    deflateEnd(&writer->strm);
+    free(writer->staging);
+    free(writer->frame);
+    free(writer);
+}
+
+/**
+ * @brief Emit callback that sends frames on a blocking socket.
+ *
+ * @param frame Frame bytes.
+ * @param len Frame length.
+ * @param user_data Pointer to the socket descriptor (int).
+ *
+ * @return SECURE_COMM_SUCCESS on success, or SECURE_COMM_ERR_SEND on failure.
+ */
+SecureCommError pipeline_emit_socket(const unsigned char* frame, size_t len, void* user_data) {
+    if (user_data == NULL) {
+        fprintf(stderr, "pipeline_emit_socket: Missing socket\n");
+        return SECURE_COMM_ERR_SEND;
+    }
+    return frame_send_all(*(const int*)user_data, frame, len);
+}
+
+/**
+ * @brief Creates the receiving side of a compress-then-encrypt stream.
+ *
+ * @param cipher Keyed cipher used to open records (not owned, must outlive the reader).
+ * @param replay Optional replay window checked for every record (NULL to skip).
+ * @param max_record Largest compressed record accepted (0 for the default).
+ * @param output Callback receiving decompressed plaintext.
+ * @param user_data Passed to output.
+ * @param reader Pointer to store the created PipelineReader.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError pipeline_reader_create(SecureCipher* cipher, ReplayWindow* replay, size_t max_record,
+                                       pipeline_output_cb output, void* user_data,
+                                       PipelineReader** reader) {
+    if (cipher == NULL || output == NULL || reader == NULL) {
+        fprintf(stderr, "pipeline_reader_create: Invalid arguments\n");
+        return SECURE_COMM_ERR_INIT;
+    }
+
+    if (max_record == 0) {
+        max_record = SECURE_PIPELINE_DEFAULT_RECORD_SIZE;
+    }
+    if (max_record > INT_MAX) {
+        fprintf(stderr, "pipeline_reader_create: Record size %zu is too large\n", max_record);
+        return SECURE_COMM_ERR_INIT;
+    }
+
+    PipelineReader* r = (PipelineReader*)malloc(sizeof(PipelineReader));
+    if (r == NULL) {
+        fprintf(stderr, "pipeline_reader_create: Failed to allocate memory for reader\n");
+        return SECURE_COMM_ERR_MEMORY;
+    }
+    memset(r, 0, sizeof(PipelineReader));
+
+    r->staging = (unsigned char*)malloc(max_record);
+    r->output = (unsigned char*)malloc(PIPELINE_OUTPUT_SIZE);
+    if (r->staging == NULL || r->output == NULL) {
+        fprintf(stderr, "pipeline_reader_create: Failed to allocate record buffers\n");
+        free(r->staging);
+        free(r->output);
+        free(r);
+        return SECURE_COMM_ERR_MEMORY;
+    }
+
+    if (inflateInit(&r->strm) != Z_OK) {
+        fprintf(stderr, "pipeline_reader_create: inflateInit failed\n");
+        free(r->staging);
+        free(r->output);
+        free(r);
+        return SECURE_COMM_ERR_DECOMPRESS;
+    }
+
+    r->cipher = cipher;
+    r->replay = replay;
+    r->max_record = max_record;
+    r->deliver = output;
+    r->user_data = user_data;
+
+    *reader = r;
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Opens one FRAME_TYPE_STREAM record and delivers its plaintext.
+ *
+ * Output is produced in fixed-size windows, so a highly compressible record never
+ * needs more than PIPELINE_OUTPUT_SIZE bytes of memory. The end of the stream is
+ * taken from the authenticated deflate data; FRAME_FLAG_END must agree with it.
+ *
+ * @param reader The reader.
+ * @param header Frame header returned by frame_decoder_next.
+ * @param record Frame payload (IV || tag || ciphertext).
+ * @param record_len Payload length.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError pipeline_reader_push(PipelineReader* reader, const FrameHeader* header,
+                                     const unsigned char* record, size_t record_len) {
+    if (reader == NULL || header == NULL || record == NULL) {
+        fprintf(stderr, "pipeline_reader_push: Invalid arguments\n");
+        return SECURE_COMM_ERR_FRAME;
+    }
+
+    if (header->type != FRAME_TYPE_STREAM || header->codec != COMPRESSION_CODEC_ZLIB ||
+        header->suite != cipher_get_suite(reader->cipher) || record_len < SECURE_RECORD_OVERHEAD ||
+        record_len - SECURE_RECORD_OVERHEAD > reader->max_record) {
+        fprintf(stderr, "pipeline_reader_push: Unexpected record (type %u, %zu bytes)\n",
+                header->type, record_len);
+        return SECURE_COMM_ERR_FRAME;
+    }
+
+    int compressed_len = 0;
+    SecureCommError ret = cipher_decrypt(reader->cipher, record + SECURE_RECORD_OVERHEAD,
+                                         (int)(record_len - SECURE_RECORD_OVERHEAD), record,
+                                         reader->staging, &compressed_len, record + IV_SIZE);
+    if (ret != SECURE_COMM_SUCCESS) {
+        return ret;
+    }
+
+    if (reader->replay && replay_window_accept(reader->replay, nonce_sequence(record)) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "pipeline_reader_push: Replayed record rejected\n");
+        return SECURE_COMM_ERR_DECRYPT;
+    }
+
+    reader->strm.next_in = reader->staging;
+    reader->strm.avail_in = (uInt)compressed_len;
+
+    int stream_end = 0;
+    for (;;) {
+        reader->strm.next_out = reader->output;
+        reader->strm.avail_out = PIPELINE_OUTPUT_SIZE;
+
+        int zret = inflate(&reader->strm, Z_NO_FLUSH);
+        if (zret == Z_NEED_DICT || zret == Z_DATA_ERROR || zret == Z_MEM_ERROR || zret == Z_STREAM_ERROR) {
+            fprintf(stderr, "pipeline_reader_push: inflate failed (%d)\n", zret);
+            inflateReset(&reader->strm);
+            return SECURE_COMM_ERR_DECOMPRESS;
+        }
+
+        size_t produced = PIPELINE_OUTPUT_SIZE - reader->strm.avail_out;
+        if (produced > 0) {
+            ret = reader->deliver(reader->output, produced, 0, reader->user_data);
+            if (ret != SECURE_COMM_SUCCESS) {
+                return ret;
+            }
+        }
+
+        if (zret == Z_STREAM_END) {
+            stream_end = 1;
+            break;
+        }
+        if (reader->strm.avail_in == 0 && reader->strm.avail_out != 0) {
+            break;
+        }
+    }
+
+    int flagged_end = (header->flags & FRAME_FLAG_END) != 0;
+    if (stream_end != flagged_end || (stream_end && reader->strm.avail_in != 0)) {
+        fprintf(stderr, "pipeline_reader_push: Stream end does not match the record flags\n");
+        inflateReset(&reader->strm);
+        return SECURE_COMM_ERR_DECOMPRESS;
+    }
+
+    if (stream_end) {
+        inflateReset(&reader->strm);
+        return reader->deliver(NULL, 0, 1, reader->user_data);
+    }
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Destroys a pipeline reader.
+ *
+ * @param reader The reader to destroy.
+ */
+void pipeline_reader_destroy(PipelineReader* reader) {
+    if (reader == NULL) {
+        return;
+    }
+    inflateEnd(&reader->strm);
+    free(reader->staging);
+    free(reader->output);
+    free(reader);
+}
@@ -0,0 +1,1048 @@
+// reactor.c
+
+#include "secure_comm.h"
+
+#include <stdio.h>      // For fprintf
+#include <stdlib.h>     // For malloc, free
+#include <string.h>     // For memset, memcpy
+#include <errno.h>      // For errno and strerror
+#include <fcntl.h>      // For fcntl
+#include <pthread.h>    // For loop threads and mutexes
+#include <stdint.h>     // For uint32_t, uint64_t
+#include <stdatomic.h>  // For the per-connection counters
+
+#include <sys/epoll.h>   // For epoll
+#include <sys/eventfd.h> // For eventfd wake-ups
+#include <netinet/in.h>  // For IPPROTO_TCP
+#include <netinet/tcp.h> // For TCP_NODELAY
+
+#ifdef SECURE_COMM_HAVE_IO_URING
+#include <liburing.h>    // For the optional io_uring backend
+#endif
+
+#define REACTOR_DEFAULT_MAX_EVENTS 256
+#define REACTOR_DEFAULT_READ_BUFFER 65536
+#define REACTOR_DEFAULT_MAX_OUTPUT (4u * 1024u * 1024u)
+#define REACTOR_IO_URING_ENTRIES 4096
+
+// Kinds of descriptors registered with a loop
+enum {
+    HANDLE_WAKE = 0,     // eventfd used to stop the loop
+    HANDLE_LISTENER,     // shared listening socket
+    HANDLE_CONN          // accepted client connection
+};
+
+// Common header for everything registered with a backend
+typedef struct ReactorHandle {
+    int fd;             // File descriptor being watched
+    int kind;           // One of the HANDLE_* kinds
+    uint32_t events;    // Currently requested EPOLL* mask
+#ifdef SECURE_COMM_HAVE_IO_URING
+    int polls_pending;  // Outstanding io_uring poll requests
+    int write_armed;    // Whether a POLLOUT request is in flight
+    int dead;           // Handle closed, free once polls_pending hits zero
+#endif
+} ReactorHandle;
+
+typedef struct ReactorLoop ReactorLoop;
+
+// Definition of the opaque ReactorConnection structure
+struct ReactorConnection {
+    ReactorHandle handle;               // Must be first: backends hand back ReactorHandle*
+    ReactorLoop* loop;                  // Owning event loop
+    pthread_mutex_t lock;               // Protects the output queue, flags and refcount
+    unsigned char* out_buf;             // Pending output not yet accepted by the kernel
+    size_t out_len;                     // Bytes pending in out_buf
+    size_t out_cap;                     // Capacity of out_buf
+    int refcount;                       // Loop reference plus any reactor_conn_retain calls
+    int closing;                        // Set once the connection is being torn down
+    void* user_data;                    // Application state attached in on_open
+    struct sockaddr_storage peer_addr;  // Remote address
+    socklen_t peer_len;                 // Length of peer_addr
+    ReactorConnection* prev;            // Loop-local list of live connections
+    ReactorConnection* next;
+    _Atomic uint64_t bytes_sent;        // Counters reported by reactor_conn_get_stats
+    _Atomic uint64_t bytes_received;
+    _Atomic uint64_t send_calls;
+    _Atomic uint64_t recv_calls;
+};
+
+// One event loop thread with its own backend instance
+struct ReactorLoop {
+    SecureReactor* reactor;     // Owning reactor
+    pthread_t thread;           // Loop thread (unused for loop 0, which runs in reactor_run)
+    int index;                  // Loop number
+    int epoll_fd;               // epoll instance (epoll backend)
+#ifdef SECURE_COMM_HAVE_IO_URING
+    struct io_uring ring;       // io_uring instance (io_uring backend)
+    pthread_mutex_t ring_lock;  // Serializes SQ access from non-loop threads
+    int ring_ready;             // Whether ring was initialized
+#endif
+    ReactorHandle wake;         // eventfd used by reactor_stop
+    ReactorHandle listener;     // Per-loop registration of the listening socket
+    unsigned char* read_buffer; // Scratch buffer shared by all connections on this loop
+    ReactorConnection* conns;   // Live connections owned by this loop
+    size_t conn_count;          // Number of live connections
+};
+
+// Definition of the opaque SecureReactor structure
+struct SecureReactor {
+    ReactorConfig config;       // Copy of the creation parameters
+    ReactorLoop* loops;         // Array of config.num_threads loops
+    int listen_fd;              // Listening socket shared by all loops
+    volatile int running;       // Cleared by reactor_stop
+};
+
+// Generic event returned by a backend wait
+typedef struct {
+    ReactorHandle* handle;
+    uint32_t events;
+} ReactorEvent;
+
+/**
+ * @brief Puts a file descriptor into non-blocking mode.
+ *
+ * @param fd The descriptor to modify.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or SECURE_COMM_ERR_SOCKET on failure.
+ */
+static SecureCommError set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+        fprintf(stderr, "reactor: fcntl(O_NONBLOCK) failed: %s\n", strerror(errno));
+        return SECURE_COMM_ERR_SOCKET;
+    }
+    return SECURE_COMM_SUCCESS;
+}
+
+// -----------------------------------
+// Backend abstraction (epoll / io_uring)
+// -----------------------------------
+
+#ifdef SECURE_COMM_HAVE_IO_URING
+/**
+ * @brief Queues a one-shot poll request on the loop's ring.
+ *
+ * The caller must hold loop->ring_lock. Write polls are tagged by setting the
+ * low bit of the user data so completions can be told apart.
+ */
+static int uring_arm(ReactorLoop* loop, ReactorHandle* handle, uint32_t mask, int is_write) {
+    struct io_uring_sqe* sqe = io_uring_get_sqe(&loop->ring);
+    if (sqe == NULL) {
+        // Submission queue full: flush it and retry once
+        io_uring_submit(&loop->ring);
+        sqe = io_uring_get_sqe(&loop->ring);
+        if (sqe == NULL) {
+            return -1;
+        }
+    }
+    io_uring_prep_poll_add(sqe, handle->fd, mask);
+    io_uring_sqe_set_data(sqe, (void*)((uintptr_t)handle | (is_write ? 1u : 0u)));
+    handle->polls_pending++;
+    return 0;
+}
+#endif
+
+/**
+ * @brief Registers a handle with the loop's backend.
+ */
+static SecureCommError backend_add(ReactorLoop* loop, ReactorHandle* handle, uint32_t events) {
+    handle->events = events;
+#ifdef SECURE_COMM_HAVE_IO_URING
+    if (loop->reactor->config.backend == REACTOR_BACKEND_IO_URING) {
+        pthread_mutex_lock(&loop->ring_lock);
+        int rc = uring_arm(loop, handle, events & ~(uint32_t)EPOLLOUT, 0);
+        if (rc == 0 && (events & EPOLLOUT)) {
+            rc = uring_arm(loop, handle, EPOLLOUT, 1);
+            handle->write_armed = (rc == 0);
+        }
+        io_uring_submit(&loop->ring);
+        pthread_mutex_unlock(&loop->ring_lock);
+        return rc == 0 ? SECURE_COMM_SUCCESS : SECURE_COMM_ERR_SOCKET;
+    }
+#endif
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = events;
+    ev.data.ptr = handle;
+    if (epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, handle->fd, &ev) < 0) {
+        fprintf(stderr, "reactor: epoll_ctl(ADD) failed: %s\n", strerror(errno));
+        return SECURE_COMM_ERR_SOCKET;
+    }
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Changes the event mask of a registered handle. Safe to call from any thread.
+ */
+static SecureCommError backend_mod(ReactorLoop* loop, ReactorHandle* handle, uint32_t events) {
+#ifdef SECURE_COMM_HAVE_IO_URING
+    if (loop->reactor->config.backend == REACTOR_BACKEND_IO_URING) {
+        int rc = 0;
+        pthread_mutex_lock(&loop->ring_lock);
+        handle->events = events;
+        if ((events & EPOLLOUT) && !handle->write_armed && !handle->dead) {
+            rc = uring_arm(loop, handle, EPOLLOUT, 1);
+            handle->write_armed = (rc == 0);
+            io_uring_submit(&loop->ring);
+        }
+        pthread_mutex_unlock(&loop->ring_lock);
+        return rc == 0 ? SECURE_COMM_SUCCESS : SECURE_COMM_ERR_SOCKET;
+    }
+#endif
+    handle->events = events;
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = events;
+    ev.data.ptr = handle;
+    if (epoll_ctl(loop->epoll_fd, EPOLL_CTL_MOD, handle->fd, &ev) < 0) {
+        fprintf(stderr, "reactor: epoll_ctl(MOD) failed: %s\n", strerror(errno));
+        return SECURE_COMM_ERR_SOCKET;
+    }
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Removes a handle from the loop's backend.
+ *
+ * @return 1 if the handle memory may be released immediately, 0 if the backend
+ *         still references it and will report it once more before it is safe.
+ */
+static int backend_del(ReactorLoop* loop, ReactorHandle* handle) {
+#ifdef SECURE_COMM_HAVE_IO_URING
+    if (loop->reactor->config.backend == REACTOR_BACKEND_IO_URING) {
+        pthread_mutex_lock(&loop->ring_lock);
+        handle->dead = 1;
+        int releasable = (handle->polls_pending == 0);
+        pthread_mutex_unlock(&loop->ring_lock);
+        // shutdown() makes any outstanding poll complete with POLLHUP
+        shutdown(handle->fd, SHUT_RDWR);
+        return releasable;
+    }
+#endif
+    epoll_ctl(loop->epoll_fd, EPOLL_CTL_DEL, handle->fd, NULL);
+    return 1;
+}
+
+static void release_connection(ReactorConnection* conn);
+
+/**
+ * @brief Waits for events on the loop's backend.
+ *
+ * @return Number of events stored in out, or -1 on a fatal backend error.
+ */
+static int backend_wait(ReactorLoop* loop, ReactorEvent* out, int max_events) {
+#ifdef SECURE_COMM_HAVE_IO_URING
+    if (loop->reactor->config.backend == REACTOR_BACKEND_IO_URING) {
+        struct io_uring_cqe* cqe = NULL;
+        int rc = io_uring_wait_cqe(&loop->ring, &cqe);
+        if (rc < 0) {
+            if (rc == -EINTR) {
+                return 0;
+            }
+            fprintf(stderr, "reactor: io_uring_wait_cqe failed: %s\n", strerror(-rc));
+            return -1;
+        }
+
+        int count = 0;
+        unsigned head;
+        unsigned seen = 0;
+        pthread_mutex_lock(&loop->ring_lock);
+        io_uring_for_each_cqe(&loop->ring, head, cqe) {
+            seen++;
+            uintptr_t tag = (uintptr_t)io_uring_cqe_get_data(cqe);
+            ReactorHandle* handle = (ReactorHandle*)(tag & ~(uintptr_t)1);
+            int is_write = (int)(tag & 1u);
+            handle->polls_pending--;
+            if (is_write) {
+                handle->write_armed = 0;
+            }
+
+            if (handle->dead) {
+                if (handle->polls_pending == 0 && handle->kind == HANDLE_CONN) {
+                    // Last reference from the ring: the connection can go now
+                    pthread_mutex_unlock(&loop->ring_lock);
+                    release_connection((ReactorConnection*)handle);
+                    pthread_mutex_lock(&loop->ring_lock);
+                }
+                continue;
+            }
+
+            uint32_t events = cqe->res < 0 ? (uint32_t)EPOLLERR : (uint32_t)cqe->res;
+            if (!is_write) {
+                // Read polls are persistent from the caller's point of view
+                uring_arm(loop, handle, handle->events & ~(uint32_t)EPOLLOUT, 0);
+            }
+            if (count < max_events) {
+                out[count].handle = handle;
+                out[count].events = events;
+                count++;
+            }
+            if (seen >= (unsigned)max_events) {
+                break;
+            }
+        }
+        io_uring_cq_advance(&loop->ring, seen);
+        io_uring_submit(&loop->ring);
+        pthread_mutex_unlock(&loop->ring_lock);
+        return count;
+    }
+#endif
+    struct epoll_event events[REACTOR_DEFAULT_MAX_EVENTS];
+    if (max_events > REACTOR_DEFAULT_MAX_EVENTS) {
+        max_events = REACTOR_DEFAULT_MAX_EVENTS;
+    }
+
+    int n = epoll_wait(loop->epoll_fd, events, max_events, -1);
+    if (n < 0) {
+        if (errno == EINTR) {
+            return 0;
+        }
+        fprintf(stderr, "reactor: epoll_wait failed: %s\n", strerror(errno));
+        return -1;
+    }
+
+    for (int i = 0; i < n; i++) {
+        out[i].handle = (ReactorHandle*)events[i].data.ptr;
+        out[i].events = events[i].events;
+    }
+    return n;
+}
+
+// -----------------------------------
+// Connection handling
+// -----------------------------------
+
+/**
+ * @brief Drops one reference to a connection, freeing it when none remain.
+ */
+static void release_connection(ReactorConnection* conn) {
+    pthread_mutex_lock(&conn->lock);
+    int remaining = --conn->refcount;
+    pthread_mutex_unlock(&conn->lock);
+
+    if (remaining == 0) {
+        pthread_mutex_destroy(&conn->lock);
+        free(conn->out_buf);
+        free(conn);
+    }
+}
+
+/**
+ * @brief Tears down a connection on its loop thread.
+ *
+ * Unregisters the socket, reports on_close to the application and releases the
+ * loop's reference. Any further reactor_conn_send calls fail with SECURE_COMM_ERR_SEND.
+ */
+static void close_loop_connection(ReactorLoop* loop, ReactorConnection* conn) {
+    pthread_mutex_lock(&conn->lock);
+    conn->closing = 1;
+    pthread_mutex_unlock(&conn->lock);
+
+    int releasable = backend_del(loop, &conn->handle);
+    close(conn->handle.fd);
+    metrics_count(METRIC_CONNECTIONS_CLOSED, 1);
+
+    // Unlink from the loop-local list
+    if (conn->prev) {
+        conn->prev->next = conn->next;
+    } else {
+        loop->conns = conn->next;
+    }
+    if (conn->next) {
+        conn->next->prev = conn->prev;
+    }
+    loop->conn_count--;
+
+    const ReactorConfig* cfg = &loop->reactor->config;
+    if (cfg->on_close) {
+        cfg->on_close(conn, cfg->user_data);
+    }
+
+    if (releasable) {
+        release_connection(conn);
+    }
+}
+
+/**
+ * @brief Writes as much pending output as the socket accepts.
+ *
+ * The caller must hold conn->lock.
+ *
+ * @return SECURE_COMM_SUCCESS when the queue was flushed or the socket would block,
+ *         SECURE_COMM_ERR_SEND on a fatal socket error.
+ */
+static SecureCommError flush_locked(ReactorConnection* conn) {
+    size_t offset = 0;
+    while (offset < conn->out_len) {
+        ssize_t n = send(conn->handle.fd, conn->out_buf + offset, conn->out_len - offset, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            return SECURE_COMM_ERR_SEND;
+        }
+        offset += (size_t)n;
+    }
+
+    if (offset > 0) {
+        atomic_fetch_add_explicit(&conn->bytes_sent, offset, memory_order_relaxed);
+        metrics_count(METRIC_BYTES_SENT, offset);
+        memmove(conn->out_buf, conn->out_buf + offset, conn->out_len - offset);
+        conn->out_len -= offset;
+    }
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Accepts every pending connection on the listening socket.
+ */
+static void handle_accept(ReactorLoop* loop) {
+    SecureReactor* reactor = loop->reactor;
+    const ReactorConfig* cfg = &reactor->config;
+
+    while (1) {
+        struct sockaddr_storage addr;
+        socklen_t addr_len = sizeof(addr);
+        int fd = accept(reactor->listen_fd, (struct sockaddr*)&addr, &addr_len);
+        if (fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                fprintf(stderr, "reactor: accept failed: %s\n", strerror(errno));
+            }
+            return;
+        }
+
+        if (set_nonblocking(fd) != SECURE_COMM_SUCCESS) {
+            close(fd);
+            continue;
+        }
+
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        ReactorConnection* conn = (ReactorConnection*)malloc(sizeof(ReactorConnection));
+        if (conn == NULL) {
+            fprintf(stderr, "reactor: Failed to allocate memory for connection\n");
+            close(fd);
+            continue;
+        }
+        memset(conn, 0, sizeof(ReactorConnection));
+        conn->handle.fd = fd;
+        conn->handle.kind = HANDLE_CONN;
+        conn->loop = loop;
+        conn->refcount = 1;
+        memcpy(&conn->peer_addr, &addr, addr_len);
+        conn->peer_len = addr_len;
+        pthread_mutex_init(&conn->lock, NULL);
+        metrics_count(METRIC_CONNECTIONS_OPENED, 1);
+
+        // Link before on_open so the callback may already send
+        conn->next = loop->conns;
+        if (loop->conns) {
+            loop->conns->prev = conn;
+        }
+        loop->conns = conn;
+        loop->conn_count++;
+
+        if (backend_add(loop, &conn->handle, EPOLLIN | EPOLLRDHUP) != SECURE_COMM_SUCCESS) {
+            loop->conns = conn->next;
+            if (conn->next) {
+                conn->next->prev = NULL;
+            }
+            loop->conn_count--;
+            close(fd);
+            metrics_count(METRIC_CONNECTIONS_CLOSED, 1);
+            release_connection(conn);
+            continue;
+        }
+
+        if (cfg->on_open && cfg->on_open(conn, cfg->user_data) != SECURE_COMM_SUCCESS) {
+            close_loop_connection(loop, conn);
+        }
+    }
+}
+
+/**
+ * @brief Reads everything available on a connection and hands it to on_data.
+ *
+ * @return 0 to keep the connection, -1 if it must be closed.
+ */
+static int handle_readable(ReactorLoop* loop, ReactorConnection* conn) {
+    const ReactorConfig* cfg = &loop->reactor->config;
+
+    while (1) {
+        ssize_t n = recv(conn->handle.fd, loop->read_buffer, cfg->read_buffer_size, 0);
+        if (n > 0) {
+            atomic_fetch_add_explicit(&conn->bytes_received, (uint64_t)n, memory_order_relaxed);
+            atomic_fetch_add_explicit(&conn->recv_calls, 1, memory_order_relaxed);
+            metrics_count(METRIC_BYTES_RECEIVED, (uint64_t)n);
+            metrics_count(METRIC_RECV_CALLS, 1);
+            if (cfg->on_data &&
+                cfg->on_data(conn, loop->read_buffer, (size_t)n, cfg->user_data) != SECURE_COMM_SUCCESS) {
+                return -1;
+            }
+            if ((size_t)n < cfg->read_buffer_size) {
+                // Short read: the socket is drained for now
+                return 0;
+            }
+            continue;
+        }
+        if (n == 0) {
+            return -1; // Peer closed the connection
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return 0;
+        }
+        return -1;
+    }
+}
+
+/**
+ * @brief Flushes queued output once the socket becomes writable again.
+ *
+ * @return 0 to keep the connection, -1 if it must be closed.
+ */
+static int handle_writable(ReactorLoop* loop, ReactorConnection* conn) {
+    pthread_mutex_lock(&conn->lock);
+    SecureCommError ret = flush_locked(conn);
+    if (ret == SECURE_COMM_SUCCESS && conn->out_len == 0) {
+        backend_mod(loop, &conn->handle, EPOLLIN | EPOLLRDHUP);
+    }
+    pthread_mutex_unlock(&conn->lock);
+    return ret == SECURE_COMM_SUCCESS ? 0 : -1;
+}
+
+/**
+ * @brief Body of every event loop thread.
+ */
+static void* loop_thread_func(void* arg) {
+    ReactorLoop* loop = (ReactorLoop*)arg;
+    SecureReactor* reactor = loop->reactor;
+    int max_events = reactor->config.max_events;
+
+    ReactorEvent* events = (ReactorEvent*)malloc(sizeof(ReactorEvent) * (size_t)max_events);
+    if (events == NULL) {
+        fprintf(stderr, "reactor: Failed to allocate event array for loop %d\n", loop->index);
+        return NULL;
+    }
+
+    while (reactor->running) {
+        int n = backend_wait(loop, events, max_events);
+        if (n < 0) {
+            break;
+        }
+
+        for (int i = 0; i < n; i++) {
+            ReactorHandle* handle = events[i].handle;
+            uint32_t ev = events[i].events;
+
+            if (handle->kind == HANDLE_WAKE) {
+                uint64_t value;
+                ssize_t ignored = read(handle->fd, &value, sizeof(value));
+                (void)ignored;
+                continue;
+            }
+
+            if (handle->kind == HANDLE_LISTENER) {
+                handle_accept(loop);
+                continue;
+            }
+
+            ReactorConnection* conn = (ReactorConnection*)handle;
+            int failed = 0;
+
+            if (ev & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+                failed = handle_readable(loop, conn) != 0;
+            }
+            if (!failed && (ev & EPOLLOUT)) {
+                failed = handle_writable(loop, conn) != 0;
+            }
+            if (!failed) {
+                pthread_mutex_lock(&conn->lock);
+                failed = conn->closing;
+                pthread_mutex_unlock(&conn->lock);
+            }
+
+            if (failed) {
+                close_loop_connection(loop, conn);
+            }
+        }
+    }
+
+    // Shut down every connection still owned by this loop
+    while (loop->conns) {
+        close_loop_connection(loop, loop->conns);
+    }
+
+    free(events);
+    return NULL;
+}
+
+// -----------------------------------
+// Public API
+// -----------------------------------
+
+/**
+ * @brief Fills a ReactorConfig with default values.
+ *
+ * @param config Pointer to the configuration to initialize.
+ */
+void reactor_config_defaults(ReactorConfig* config) {
+    if (config == NULL) {
+        return;
+    }
+    memset(config, 0, sizeof(ReactorConfig));
+    config->num_threads = 1;
+    config->backend = REACTOR_BACKEND_EPOLL;
+    config->max_events = REACTOR_DEFAULT_MAX_EVENTS;
+    config->read_buffer_size = REACTOR_DEFAULT_READ_BUFFER;
+    config->max_output_buffer = REACTOR_DEFAULT_MAX_OUTPUT;
+}
+
+/**
+ * @brief Creates a reactor with a fixed pool of event-loop threads.
+ *
+ * @param config Callbacks and tunables. Copied into the reactor.
+ * @param reactor Pointer to store the created SecureReactor.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError reactor_create(const ReactorConfig* config, SecureReactor** reactor) {
+    if (config == NULL || reactor == NULL || config->num_threads <= 0) {
+        fprintf(stderr, "reactor_create: Invalid arguments\n");
+        return SECURE_COMM_ERR_INIT;
+    }
+
+#ifndef SECURE_COMM_HAVE_IO_URING
+    if (config->backend == REACTOR_BACKEND_IO_URING) {
+        fprintf(stderr, "reactor_create: io_uring backend not compiled in (SECURE_COMM_WITH_IO_URING)\n");
+        return SECURE_COMM_ERR_INIT;
+    }
+#endif
+
+    SecureReactor* r = (SecureReactor*)malloc(sizeof(SecureReactor));
+    if (r == NULL) {
+        fprintf(stderr, "reactor_create: Failed to allocate memory for reactor\n");
+        return SECURE_COMM_ERR_MEMORY;
+    }
+    memset(r, 0, sizeof(SecureReactor));
+    r->config = *config;
+    r->listen_fd = -1;
+    if (r->config.max_events <= 0) {
+        r->config.max_events = REACTOR_DEFAULT_MAX_EVENTS;
+    }
+    if (r->config.read_buffer_size == 0) {
+        r->config.read_buffer_size = REACTOR_DEFAULT_READ_BUFFER;
+    }
+    if (r->config.max_output_buffer == 0) {
+        r->config.max_output_buffer = REACTOR_DEFAULT_MAX_OUTPUT;
+    }
+
+    r->loops = (ReactorLoop*)calloc((size_t)config->num_threads, sizeof(ReactorLoop));
+    if (r->loops == NULL) {
+        fprintf(stderr, "reactor_create: Failed to allocate memory for loops\n");
+        free(r);
+        return SECURE_COMM_ERR_MEMORY;
+    }
+
+    for (int i = 0; i < config->num_threads; i++) {
+        ReactorLoop* loop = &r->loops[i];
+        loop->reactor = r;
+        loop->index = i;
+        loop->epoll_fd = -1;
+        loop->wake.fd = -1;
+        loop->listener.fd = -1;
+    }
+
+    for (int i = 0; i < config->num_threads; i++) {
+        ReactorLoop* loop = &r->loops[i];
+
+        loop->read_buffer = (unsigned char*)malloc(r->config.read_buffer_size);
+        if (loop->read_buffer == NULL) {
+            fprintf(stderr, "reactor_create: Failed to allocate read buffer\n");
+            reactor_destroy(r);
+            return SECURE_COMM_ERR_MEMORY;
+        }
+
+#ifdef SECURE_COMM_HAVE_IO_URING
+        if (r->config.backend == REACTOR_BACKEND_IO_URING) {
+            int rc = io_uring_queue_init(REACTOR_IO_URING_ENTRIES, &loop->ring, 0);
+            if (rc < 0) {
+                fprintf(stderr, "reactor_create: io_uring_queue_init failed: %s\n", strerror(-rc));
+                reactor_destroy(r);
+                return SECURE_COMM_ERR_INIT;
+            }
+            pthread_mutex_init(&loop->ring_lock, NULL);
+            loop->ring_ready = 1;
+        } else
+#endif
+        {
+            loop->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+            if (loop->epoll_fd < 0) {
+                fprintf(stderr, "reactor_create: epoll_create1 failed: %s\n", strerror(errno));
+                reactor_destroy(r);
+                return SECURE_COMM_ERR_INIT;
+            }
+        }
+
+        loop->wake.fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        loop->wake.kind = HANDLE_WAKE;
+        if (loop->wake.fd < 0 || backend_add(loop, &loop->wake, EPOLLIN) != SECURE_COMM_SUCCESS) {
+            fprintf(stderr, "reactor_create: Failed to set up wake-up descriptor\n");
+            reactor_destroy(r);
+            return SECURE_COMM_ERR_INIT;
+        }
+    }
+
+    *reactor = r;
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Attaches a bound, listening socket to every event loop.
+ *
+ * The socket is switched to non-blocking mode. On Linux each loop registers it
+ * with EPOLLEXCLUSIVE so an incoming connection wakes only one loop.
+ *
+ * @param reactor The reactor.
+ * @param listen_fd A socket on which listen() has already been called.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError reactor_listen(SecureReactor* reactor, int listen_fd) {
+    if (reactor == NULL || listen_fd < 0 || reactor->listen_fd >= 0) {
+        fprintf(stderr, "reactor_listen: Invalid arguments\n");
+        return SECURE_COMM_ERR_SOCKET;
+    }
+
+    SecureCommError ret = set_nonblocking(listen_fd);
+    if (ret != SECURE_COMM_SUCCESS) {
+        return ret;
+    }
+    reactor->listen_fd = listen_fd;
+
+    for (int i = 0; i < reactor->config.num_threads; i++) {
+        ReactorLoop* loop = &reactor->loops[i];
+        loop->listener.fd = listen_fd;
+        loop->listener.kind = HANDLE_LISTENER;
+
+        uint32_t events = EPOLLIN;
+#ifdef EPOLLEXCLUSIVE
+        if (reactor->config.backend == REACTOR_BACKEND_EPOLL) {
+            events |= EPOLLEXCLUSIVE;
+        }
+#endif
+        ret = backend_add(loop, &loop->listener, events);
+        if (ret != SECURE_COMM_SUCCESS) {
+            return ret;
+        }
+    }
+
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Runs the event loops until reactor_stop is called.
+ *
+ * Loop 0 runs on the calling thread; the remaining loops get their own threads.
+ *
+ * @param reactor The reactor.
+ *
+ * @return SECURE_COMM_SUCCESS after a clean stop, or a negative error code on failure.
+ */
+SecureCommError reactor_run(SecureReactor* reactor) {
+    if (reactor == NULL) {
+        fprintf(stderr, "reactor_run: Invalid arguments\n");
+        return SECURE_COMM_ERR_INIT;
+    }
+
+    reactor->running = 1;
+
+    int started = 1;
+    for (int i = 1; i < reactor->config.num_threads; i++) {
+        if (pthread_create(&reactor->loops[i].thread, NULL, loop_thread_func, &reactor->loops[i]) != 0) {
+            fprintf(stderr, "reactor_run: Failed to create loop thread %d\n", i);
+            reactor_stop(reactor);
+            break;
+        }
+        started++;
+    }
+
+    loop_thread_func(&reactor->loops[0]);
+
+    for (int i = 1; i < started; i++) {
+        pthread_join(reactor->loops[i].thread, NULL);
+    }
+
+    return started == reactor->config.num_threads ? SECURE_COMM_SUCCESS : SECURE_COMM_ERR_INIT;
+}
+
+/**
+ * @brief Asks every event loop to exit. Safe to call from any thread or a signal handler.
+ *
+ * @param reactor The reactor.
+ */
+void reactor_stop(SecureReactor* reactor) {
+    if (reactor == NULL) {
+        return;
+    }
+    reactor->running = 0;
+    for (int i = 0; i < reactor->config.num_threads; i++) {
+        if (reactor->loops[i].wake.fd >= 0) {
+            uint64_t one = 1;
+            ssize_t ignored = write(reactor->loops[i].wake.fd, &one, sizeof(one));
+            (void)ignored;
+        }
+    }
+}
+
+/**
+ * @brief Frees a reactor. reactor_run must have returned first.
+ *
+ * The listening socket passed to reactor_listen is not closed.
+ *
+ * @param reactor The reactor to destroy.
+ */
+void reactor_destroy(SecureReactor* reactor) {
+    if (reactor == NULL) {
+        return;
+    }
+
+    for (int i = 0; i < reactor->config.num_threads; i++) {
+        ReactorLoop* loop = &reactor->loops[i];
+        if (loop->wake.fd >= 0) {
+            close(loop->wake.fd);
+        }
+        if (loop->epoll_fd >= 0) {
+            close(loop->epoll_fd);
+        }
+#ifdef SECURE_COMM_HAVE_IO_URING
+        if (loop->ring_ready) {
+            io_uring_queue_exit(&loop->ring);
+            pthread_mutex_destroy(&loop->ring_lock);
+        }
+#endif
+        free(loop->read_buffer);
+    }
+
+    free(reactor->loops);
+    free(reactor);
+}
+
+/**
+ * @brief Queues data for sending on a reactor connection. Safe to call from any thread.
+ *
+ * Data is written immediately when the socket accepts it; whatever remains is
+ * buffered and flushed by the owning loop when the socket becomes writable.
+ *
+ * @param conn The connection.
+ * @param data Pointer to the bytes to send.
+ * @param len Number of bytes to send.
+ *
+ * @return SECURE_COMM_SUCCESS on success, SECURE_COMM_ERR_AGAIN if the bytes would take
+ *         the queue past max_output_buffer (nothing is sent), SECURE_COMM_ERR_SEND if the
+ *         connection is closing or the socket failed, or SECURE_COMM_ERR_MEMORY.
+ */
+SecureCommError reactor_conn_send(ReactorConnection* conn, const void* data, size_t len) {
+    if (conn == NULL || (data == NULL && len > 0)) {
+        fprintf(stderr, "reactor_conn_send: Invalid arguments\n");
+        return SECURE_COMM_ERR_SEND;
+    }
+
+    pthread_mutex_lock(&conn->lock);
+    if (conn->closing) {
+        pthread_mutex_unlock(&conn->lock);
+        return SECURE_COMM_ERR_SEND;
+    }
+
+    // Back-pressure: with data already waiting on a slow reader, refuse the whole message.
+    // An empty queue always accepts one, so messages above the limit still go out.
+    if (conn->out_len > 0 && conn->out_len + len > conn->loop->reactor->config.max_output_buffer) {
+        pthread_mutex_unlock(&conn->lock);
+        return SECURE_COMM_ERR_AGAIN;
+    }
+
+    const unsigned char* bytes = (const unsigned char*)data;
+    size_t offset = 0;
+
+    // Fast path: nothing queued, try writing straight to the socket
+    if (conn->out_len == 0) {
+        while (offset < len) {
+            ssize_t n = send(conn->handle.fd, bytes + offset, len - offset, MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    break;
+                }
+                conn->closing = 1;
+                shutdown(conn->handle.fd, SHUT_RDWR);
+                pthread_mutex_unlock(&conn->lock);
+                return SECURE_COMM_ERR_SEND;
+            }
+            offset += (size_t)n;
+        }
+    }
+
+    if (offset < len) {
+        size_t remaining = len - offset;
+        if (conn->out_len + remaining > conn->out_cap) {
+            size_t new_cap = conn->out_cap ? conn->out_cap : 4096;
+            while (new_cap < conn->out_len + remaining) {
+                new_cap *= 2;
+            }
+            unsigned char* grown = (unsigned char*)realloc(conn->out_buf, new_cap);
+            if (grown == NULL) {
+                pthread_mutex_unlock(&conn->lock);
+                return SECURE_COMM_ERR_MEMORY;
+            }
+            conn->out_buf = grown;
+            conn->out_cap = new_cap;
+        }
+
+        int was_empty = (conn->out_len == 0);
+        memcpy(conn->out_buf + conn->out_len, bytes + offset, remaining);
+        conn->out_len += remaining;
+
+        if (was_empty) {
+            backend_mod(conn->loop, &conn->handle, EPOLLIN | EPOLLRDHUP | EPOLLOUT);
+        }
+    }
+
+    // Bytes still queued are counted by flush_locked once the kernel takes them
+    atomic_fetch_add_explicit(&conn->bytes_sent, offset, memory_order_relaxed);
+    atomic_fetch_add_explicit(&conn->send_calls, 1, memory_order_relaxed);
+    pthread_mutex_unlock(&conn->lock);
+    metrics_count(METRIC_BYTES_SENT, offset);
+    metrics_count(METRIC_SEND_CALLS, 1);
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Queues the valid bytes of a pool buffer for sending.
+ *
+ * The bytes go straight to the socket when nothing is queued; only what the kernel
+ * does not take is copied. The caller keeps its reference.
+ *
+ * @param conn The connection.
+ * @param buffer The buffer to send.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError reactor_conn_send_buffer(ReactorConnection* conn, const SecureBuffer* buffer) {
+    if (buffer == NULL) {
+        fprintf(stderr, "reactor_conn_send_buffer: Invalid arguments\n");
+        return SECURE_COMM_ERR_SEND;
+    }
+    return reactor_conn_send(conn, secure_buffer_data(buffer), secure_buffer_len(buffer));
+}
+
+/**
+ * @brief Requests that a connection be closed. Safe to call from any thread.
+ *
+ * The owning loop performs the actual teardown and invokes on_close.
+ *
+ * @param conn The connection.
+ */
+void reactor_conn_close(ReactorConnection* conn) {
+    if (conn == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&conn->lock);
+    if (!conn->closing) {
+        conn->closing = 1;
+        // Wakes the owning loop with EPOLLHUP so it tears the connection down
+        shutdown(conn->handle.fd, SHUT_RDWR);
+    }
+    pthread_mutex_unlock(&conn->lock);
+}
+
+/**
+ * @brief Takes an extra reference so the connection outlives its loop registration.
+ *
+ * @param conn The connection.
+ */
+void reactor_conn_retain(ReactorConnection* conn) {
+    if (conn == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&conn->lock);
+    conn->refcount++;
+    pthread_mutex_unlock(&conn->lock);
+}
+
+/**
+ * @brief Drops a reference taken with reactor_conn_retain.
+ *
+ * @param conn The connection.
+ */
+void reactor_conn_release(ReactorConnection* conn) {
+    if (conn != NULL) {
+        release_connection(conn);
+    }
+}
+
+/**
+ * @brief Returns the socket descriptor of a connection.
+ */
+int reactor_conn_fd(const ReactorConnection* conn) {
+    return conn ? conn->handle.fd : -1;
+}
+
+/**
+ * @brief Returns the remote address of a connection.
+ *
+ * @param conn The connection.
+ * @param len Optional pointer to store the address length.
+ */
+const struct sockaddr* reactor_conn_peer(const ReactorConnection* conn, socklen_t* len) {
+    if (conn == NULL) {
+        return NULL;
+    }
+    if (len) {
+        *len = conn->peer_len;
+    }
+    return (const struct sockaddr*)&conn->peer_addr;
+}
+
+/**
+ * @brief Copies the byte and call counters of a connection.
+ *
+ * @param conn The connection.
+ * @param stats Pointer to store the counters.
+ */
+void reactor_conn_get_stats(const ReactorConnection* conn, ConnectionStats* stats) {
+    if (conn == NULL || stats == NULL) {
+        return;
+    }
+    stats->bytes_sent = atomic_load_explicit(&conn->bytes_sent, memory_order_relaxed);
+    stats->bytes_received = atomic_load_explicit(&conn->bytes_received, memory_order_relaxed);
+    stats->send_calls = atomic_load_explicit(&conn->send_calls, memory_order_relaxed);
+    stats->recv_calls = atomic_load_explicit(&conn->recv_calls, memory_order_relaxed);
+}
+
+/**
+ * @brief Attaches application state to a connection.
+ */
+void reactor_conn_set_user_data(ReactorConnection* conn, void* user_data) {
+    if (conn) {
+        conn->user_data = user_data;
+    }
+}
+
+/**
+ * @brief Returns the application state attached with reactor_conn_set_user_data.
+ */
+void* reactor_conn_get_user_data(const ReactorConnection* conn) {
+    return conn ? conn->user_data : NULL;
+}
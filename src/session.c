@@ -10,7 +10,10 @@
 #include <openssl/rand.h>     // For random number generation
 #include <openssl/err.h>      // For error handling
 #include <openssl/sha.h>      // For SHA hashing
-#include <openssl/dh.h> // Add this line
+#include <openssl/dh.h>       // For the named DH groups
+#include <openssl/pem.h>      // For loading DH parameters
+#include <openssl/obj_mac.h>  // For NID_ffdhe2048 / NID_ffdhe3072
+#include <pthread.h>          // For one-time parameter setup and the settings lock
 
 
 /**
@@ -34,108 +37,226 @@ SecureCommError authenticate_user(const char* username, const char* password) {
     if (strcmp(username, valid_username) == 0 && strcmp(password, valid_password) == 0) {
         return SECURE_COMM_SUCCESS;
     } else {
+        metrics_count(METRIC_AUTH_FAILURES, 1);
         fprintf(stderr, "authenticate_user: Invalid credentials for user '%s'\n", username);
         return SECURE_COMM_ERR_SESSION;
     }
 }
 
+// Parameters for each finite-field group, built once and shared read-only
+static EVP_PKEY* group_params[SESSION_KEX_COUNT];
+static pthread_once_t group_params_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t custom_params_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Settings of initialize_session. Readers hold the lock for as long as they use the
+// pool, so a detach returns only once no thread can still be taking from it.
+static pthread_rwlock_t session_settings_lock = PTHREAD_RWLOCK_INITIALIZER;
+
+// Key exchange used by initialize_session
+static SessionKeyExchange default_kex = SESSION_KEX_FFDHE2048;
+
+// Optional pool of pre-generated keypairs consulted by initialize_session
+static KeypairPool* session_pool = NULL;
+
+// Shared secrets up to this size (8192-bit DH) are derived on the stack
+#define SESSION_SECRET_STACK_SIZE 1024
+
 /**
- * @brief Generates a Diffie-Hellman key pair using EVP_PKEY.
+ * @brief A UserSession allocated together with its key and username.
+ */
+typedef struct {
+    UserSession session;                        // First: terminate_session frees the block through it
+    unsigned char key[SHA256_DIGEST_LENGTH];    // Storage for session.session_key
+    char username[];                            // Storage for session.username
+} session_block_t;
+
+/**
+ * @brief Builds the parameters of a named RFC 7919 group (no prime search involved).
+ */
+static EVP_PKEY* build_named_group(int nid) {
+    EVP_PKEY_CTX* pctx = EVP_PKEY_CTX_new_id(EVP_PKEY_DH, NULL);
+    if (!pctx) {
+        return NULL;
+    }
+
+    EVP_PKEY* params = NULL;
+    if (EVP_PKEY_paramgen_init(pctx) <= 0 ||
+        EVP_PKEY_CTX_set_dh_nid(pctx, nid) <= 0 ||
+        EVP_PKEY_paramgen(pctx, &params) <= 0) {
+        params = NULL;
+    }
+    EVP_PKEY_CTX_free(pctx);
+    return params;
+}
+
+static void build_group_params(void) {
+    group_params[SESSION_KEX_FFDHE2048] = build_named_group(NID_ffdhe2048);
+    group_params[SESSION_KEX_FFDHE3072] = build_named_group(NID_ffdhe3072);
+}
+
+/**
+ * @brief Loads precomputed DH parameters (PEM "DH PARAMETERS") for SESSION_KEX_DH_CUSTOM.
  *
- * This function initializes Diffie-Hellman parameters and generates a key pair.
+ * Call once at startup; keypairs generated afterwards use these parameters.
  *
- * @param keypair Pointer to store the generated EVP_PKEY key pair.
+ * @param pem_path Path to the PEM file, e.g. produced by `openssl dhparam`.
  *
  * @return SECURE_COMM_SUCCESS on success, or SECURE_COMM_ERR_SESSION on failure.
  */
-SecureCommError generate_dh_keypair(EVP_PKEY** keypair) {
-    if (keypair == NULL) {
-        fprintf(stderr, "generate_dh_keypair: Invalid argument\n");
+SecureCommError session_load_dh_params(const char* pem_path) {
+    if (pem_path == NULL) {
+        fprintf(stderr, "session_load_dh_params: Invalid argument\n");
         return SECURE_COMM_ERR_SESSION;
     }
 
-    // Initialize the OpenSSL algorithms
-    // Not strictly necessary with OpenSSL 1.1.0 and above, but kept for compatibility
-    OpenSSL_add_all_algorithms();
-
-    // Create a new EVP_PKEY_CTX for DH key generation with 2048-bit MODP Group 14
-    EVP_PKEY_CTX* pctx = EVP_PKEY_CTX_new_id(EVP_PKEY_DH, NULL);
-    if (!pctx) {
-        fprintf(stderr, "generate_dh_keypair: EVP_PKEY_CTX_new_id failed\n");
+    BIO* bio = BIO_new_file(pem_path, "r");
+    if (!bio) {
+        fprintf(stderr, "session_load_dh_params: Cannot open '%s'\n", pem_path);
         return SECURE_COMM_ERR_SESSION;
     }
-
-    if (EVP_PKEY_paramgen_init(pctx) <= 0) {
-        fprintf(stderr, "generate_dh_keypair: EVP_PKEY_paramgen_init failed\n");
-        EVP_PKEY_CTX_free(pctx);
+    EVP_PKEY* params = PEM_read_bio_Parameters(bio, NULL);
+    BIO_free(bio);
+    if (!params || EVP_PKEY_base_id(params) != EVP_PKEY_DH) {
+        fprintf(stderr, "session_load_dh_params: '%s' does not contain DH parameters\n", pem_path);
+        EVP_PKEY_free(params);
         return SECURE_COMM_ERR_SESSION;
     }
 
-    // Set the DH group to 2048-bit MODP Group 14 (RFC 3526)
-    if (EVP_PKEY_CTX_set_dh_paramgen_prime_len(pctx, 2048) <= 0 ||
-        EVP_PKEY_CTX_set_dh_paramgen_generator(pctx, 2) <= 0) {
-        fprintf(stderr, "generate_dh_keypair: Setting DH parameters failed\n");
-        EVP_PKEY_CTX_free(pctx);
+    pthread_mutex_lock(&custom_params_lock);
+    EVP_PKEY_free(group_params[SESSION_KEX_DH_CUSTOM]);
+    group_params[SESSION_KEX_DH_CUSTOM] = params;
+    pthread_mutex_unlock(&custom_params_lock);
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Selects the key exchange used by initialize_session.
+ *
+ * @param kex One of SessionKeyExchange.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or SECURE_COMM_ERR_SESSION for an unknown value.
+ */
+SecureCommError session_set_key_exchange(SessionKeyExchange kex) {
+    if (kex < 0 || kex >= SESSION_KEX_COUNT) {
+        fprintf(stderr, "session_set_key_exchange: Unknown key exchange %d\n", kex);
         return SECURE_COMM_ERR_SESSION;
     }
+    pthread_rwlock_wrlock(&session_settings_lock);
+    default_kex = kex;
+    pthread_rwlock_unlock(&session_settings_lock);
+    return SECURE_COMM_SUCCESS;
+}
 
-    // Generate DH parameters
-    EVP_PKEY* params = NULL;
-    if (EVP_PKEY_paramgen(pctx, &params) <= 0) {
-        fprintf(stderr, "generate_dh_keypair: EVP_PKEY_paramgen failed\n");
-        EVP_PKEY_CTX_free(pctx);
-        return SECURE_COMM_ERR_SESSION;
+/**
+ * @brief Body of generate_session_keypair, without the metrics.
+ */
+static SecureCommError generate_session_keypair_unmetered(SessionKeyExchange kex, EVP_PKEY** keypair) {
+    EVP_PKEY_CTX* kctx = NULL;
+    if (kex == SESSION_KEX_X25519) {
+        kctx = EVP_PKEY_CTX_new_id(EVP_PKEY_X25519, NULL);
+    } else {
+        pthread_once(&group_params_once, build_group_params);
+
+        // Custom parameters may be swapped at runtime, so keep them alive while in use
+        pthread_mutex_lock(&custom_params_lock);
+        EVP_PKEY* params = group_params[kex];
+        if (params) {
+            kctx = EVP_PKEY_CTX_new(params, NULL);
+        }
+        pthread_mutex_unlock(&custom_params_lock);
+
+        if (!params) {
+            fprintf(stderr, "generate_session_keypair: No DH parameters for key exchange %d\n", kex);
+            return SECURE_COMM_ERR_SESSION;
+        }
     }
 
-    // Create a new context for key generation
-    EVP_PKEY_CTX* kctx = EVP_PKEY_CTX_new(params, NULL);
     if (!kctx) {
-        fprintf(stderr, "generate_dh_keypair: EVP_PKEY_CTX_new failed\n");
-        EVP_PKEY_free(params);
-        EVP_PKEY_CTX_free(pctx);
+        fprintf(stderr, "generate_session_keypair: EVP_PKEY_CTX_new failed\n");
         return SECURE_COMM_ERR_SESSION;
     }
 
     if (EVP_PKEY_keygen_init(kctx) <= 0) {
-        fprintf(stderr, "generate_dh_keypair: EVP_PKEY_keygen_init failed\n");
-        EVP_PKEY_free(params);
-        EVP_PKEY_CTX_free(pctx);
+        fprintf(stderr, "generate_session_keypair: EVP_PKEY_keygen_init failed\n");
         EVP_PKEY_CTX_free(kctx);
         return SECURE_COMM_ERR_SESSION;
     }
 
-    // Generate the DH key pair
+    // Generate the key pair
     if (EVP_PKEY_keygen(kctx, keypair) <= 0) {
-        fprintf(stderr, "generate_dh_keypair: EVP_PKEY_keygen failed\n");
-        EVP_PKEY_free(params);
-        EVP_PKEY_CTX_free(pctx);
+        fprintf(stderr, "generate_session_keypair: EVP_PKEY_keygen failed\n");
         EVP_PKEY_CTX_free(kctx);
         return SECURE_COMM_ERR_SESSION;
     }
 
-    // Cleanup
-    EVP_PKEY_free(params);
-    EVP_PKEY_CTX_free(pctx);
     EVP_PKEY_CTX_free(kctx);
-
     return SECURE_COMM_SUCCESS;
 }
 
 /**
- * @brief Derives a shared secret using the peer's public key.
+ * @brief Generates an ephemeral key pair for the given key exchange.
  *
- * This function computes the shared secret using the peer's public key.
+ * Finite-field groups reuse parameters built once per process, and X25519 needs
+ * none, so only the key itself is generated here.
  *
- * @param session Pointer to the UserSession.
+ * @param kex One of SessionKeyExchange.
+ * @param keypair Pointer to store the generated EVP_PKEY key pair.
  *
  * @return SECURE_COMM_SUCCESS on success, or SECURE_COMM_ERR_SESSION on failure.
  */
-SecureCommError derive_shared_secret(UserSession* session) {
-    if (session == NULL || session->dh_keypair == NULL) {
-        fprintf(stderr, "derive_shared_secret: Invalid session or DH keypair\n");
+SecureCommError generate_session_keypair(SessionKeyExchange kex, EVP_PKEY** keypair) {
+    if (keypair == NULL || kex < 0 || kex >= SESSION_KEX_COUNT) {
+        fprintf(stderr, "generate_session_keypair: Invalid argument\n");
         return SECURE_COMM_ERR_SESSION;
     }
 
+    uint64_t start_ns = metrics_now_ns();
+    SecureCommError ret = generate_session_keypair_unmetered(kex, keypair);
+    metrics_stage_done(METRIC_STAGE_KEYGEN, start_ns, 0, 0, ret);
+    return ret;
+}
+
+/**
+ * @brief Attaches a keypair pool to initialize_session.
+ *
+ * Waits for threads still taking a keypair from the previous pool, so that pool
+ * may be destroyed as soon as this returns.
+ *
+ * @param pool The pool, or NULL to detach.
+ */
+void session_set_keypair_pool(KeypairPool* pool) {
+    pthread_rwlock_wrlock(&session_settings_lock);
+    session_pool = pool;
+    pthread_rwlock_unlock(&session_settings_lock);
+}
+
+/**
+ * @brief Generates a Diffie-Hellman key pair using EVP_PKEY.
+ *
+ * Uses the key exchange selected with session_set_key_exchange (ffdhe2048 by default).
+ * When a keypair pool for that exchange is attached, a pre-generated key is taken instead.
+ *
+ * @param keypair Pointer to store the generated EVP_PKEY key pair.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or SECURE_COMM_ERR_SESSION on failure.
+ */
+SecureCommError generate_dh_keypair(EVP_PKEY** keypair) {
+    pthread_rwlock_rdlock(&session_settings_lock);
+    SessionKeyExchange kex = default_kex;
+    KeypairPool* pool = session_pool;
+    if (pool && keypair_pool_kex(pool) == kex) {
+        SecureCommError ret = keypair_pool_take(pool, keypair);
+        pthread_rwlock_unlock(&session_settings_lock);
+        return ret;
+    }
+    pthread_rwlock_unlock(&session_settings_lock);
+    return generate_session_keypair(kex, keypair);
+}
+
+/**
+ * @brief Body of derive_shared_secret, without the metrics.
+ */
+static SecureCommError derive_shared_secret_unmetered(UserSession* session) {
     // In a real-world scenario, the peer's public key would be received from the connected party.
     // For demonstration, we'll generate it locally.
     // TODO: Replace with actual peer public key exchange.
@@ -174,8 +295,9 @@ SecureCommError derive_shared_secret(UserSession* session) {
         return SECURE_COMM_ERR_SESSION;
     }
 
-    // Allocate memory for the shared secret
-    unsigned char* secret = (unsigned char*)malloc(secret_len);
+    // Named groups fit on the stack; only very large custom DH groups need the heap
+    unsigned char secret_stack[SESSION_SECRET_STACK_SIZE];
+    unsigned char* secret = secret_len <= sizeof(secret_stack) ? secret_stack : (unsigned char*)malloc(secret_len);
     if (secret == NULL) {
         fprintf(stderr, "derive_shared_secret: Failed to allocate memory for shared secret\n");
         EVP_PKEY_CTX_free(derivation_ctx);
@@ -185,7 +307,9 @@ SecureCommError derive_shared_secret(UserSession* session) {
     // Derive the shared secret
     if (EVP_PKEY_derive(derivation_ctx, secret, &secret_len) <= 0) {
         fprintf(stderr, "derive_shared_secret: EVP_PKEY_derive failed\n");
-        free(secret);
+        if (secret != secret_stack) {
+            free(secret);
+        }
         EVP_PKEY_CTX_free(derivation_ctx);
         return SECURE_COMM_ERR_SESSION;
     }
@@ -196,20 +320,47 @@ SecureCommError derive_shared_secret(UserSession* session) {
     // Hash the shared secret to derive a symmetric session key
     unsigned char hash[SHA256_DIGEST_LENGTH];
     SHA256(secret, secret_len, hash);
-    free(secret);
+    OPENSSL_cleanse(secret, secret_len);
+    if (secret != secret_stack) {
+        free(secret);
+    }
 
-    // Allocate and store the session key
-    session->session_key_len = SHA256_DIGEST_LENGTH;
-    session->session_key = (unsigned char*)malloc(session->session_key_len);
+    // Store the session key; sessions from initialize_session already carry room for it
     if (session->session_key == NULL) {
-        fprintf(stderr, "derive_shared_secret: Failed to allocate memory for session key\n");
-        return SECURE_COMM_ERR_MEMORY;
+        session->session_key = (unsigned char*)malloc(SHA256_DIGEST_LENGTH);
+        if (session->session_key == NULL) {
+            fprintf(stderr, "derive_shared_secret: Failed to allocate memory for session key\n");
+            return SECURE_COMM_ERR_MEMORY;
+        }
     }
+    session->session_key_len = SHA256_DIGEST_LENGTH;
     memcpy(session->session_key, hash, session->session_key_len);
+    OPENSSL_cleanse(hash, sizeof(hash));
 
     return SECURE_COMM_SUCCESS;
 }
 
+/**
+ * @brief Derives a shared secret using the peer's public key.
+ *
+ * This function computes the shared secret using the peer's public key.
+ *
+ * @param session Pointer to the UserSession.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or SECURE_COMM_ERR_SESSION on failure.
+ */
+SecureCommError derive_shared_secret(UserSession* session) {
+    if (session == NULL || session->dh_keypair == NULL) {
+        fprintf(stderr, "derive_shared_secret: Invalid session or DH keypair\n");
+        return SECURE_COMM_ERR_SESSION;
+    }
+
+    uint64_t start_ns = metrics_now_ns();
+    SecureCommError ret = derive_shared_secret_unmetered(session);
+    metrics_stage_done(METRIC_STAGE_KEY_DERIVE, start_ns, 0, ret == SECURE_COMM_SUCCESS ? session->session_key_len : 0, ret);
+    return ret;
+}
+
 /**
  * @brief Initializes a new user session by authenticating the user and establishing a shared secret.
  *
@@ -225,36 +376,31 @@ SecureCommError initialize_session(const char* username, const char* password, U
         return SECURE_COMM_ERR_SESSION;
     }
 
-    // Allocate memory for the session
-    UserSession* new_session = (UserSession*)malloc(sizeof(UserSession));
-    if (new_session == NULL) {
-        fprintf(stderr, "initialize_session: Failed to allocate memory for session\n");
-        return SECURE_COMM_ERR_MEMORY;
-    }
-    memset(new_session, 0, sizeof(UserSession));
-
     // Authenticate the user
     SecureCommError auth_ret = authenticate_user(username, password);
     if (auth_ret != SECURE_COMM_SUCCESS) {
         fprintf(stderr, "initialize_session: User authentication failed for '%s'\n", username);
-        free(new_session);
         return auth_ret;
     }
 
-    // Set the username
-    new_session->username = strdup(username);
-    if (new_session->username == NULL) {
-        fprintf(stderr, "initialize_session: Failed to allocate memory for username\n");
-        free(new_session);
+    // One allocation holds the session, its key and its username
+    size_t username_len = strlen(username);
+    session_block_t* block = (session_block_t*)malloc(sizeof(session_block_t) + username_len + 1);
+    if (block == NULL) {
+        fprintf(stderr, "initialize_session: Failed to allocate memory for session\n");
         return SECURE_COMM_ERR_MEMORY;
     }
+    memset(block, 0, sizeof(session_block_t));
+    memcpy(block->username, username, username_len + 1);
+    UserSession* new_session = &block->session;
+    new_session->username = block->username;
+    new_session->session_key = block->key;
 
     // Generate Diffie-Hellman key pair using EVP_PKEY
     SecureCommError dh_ret = generate_dh_keypair(&new_session->dh_keypair);
     if (dh_ret != SECURE_COMM_SUCCESS) {
         fprintf(stderr, "initialize_session: Failed to generate DH key pair\n");
-        free(new_session->username);
-        free(new_session);
+        free(block);
         return dh_ret;
     }
 
@@ -263,13 +409,14 @@ SecureCommError initialize_session(const char* username, const char* password, U
     if (secret_ret != SECURE_COMM_SUCCESS) {
         fprintf(stderr, "initialize_session: Failed to derive shared secret\n");
         EVP_PKEY_free(new_session->dh_keypair);
-        free(new_session->username);
-        free(new_session);
+        EVP_PKEY_free(new_session->peer_dh_public);
+        free(block);
         return secret_ret;
     }
 
     // Assign the created session to the output parameter
     *session = new_session;
+    metrics_count(METRIC_SESSIONS_STARTED, 1);
 
     printf("initialize_session: Session initialized for user '%s'\n", username);
 
@@ -286,11 +433,15 @@ void terminate_session(UserSession* session) {
         return;
     }
 
+    session_block_t* block = (session_block_t*)session;
+
     // Free the session key
     if (session->session_key) {
         // Securely erase the key
         OPENSSL_cleanse(session->session_key, session->session_key_len);
-        free(session->session_key);
+        if (session->session_key != block->key) {
+            free(session->session_key);
+        }
     }
 
     // Free the DH key pair
@@ -303,13 +454,13 @@ void terminate_session(UserSession* session) {
         EVP_PKEY_free(session->peer_dh_public);
     }
 
-    // Free the username
-    if (session->username) {
+    // Free the username if it was replaced after initialize_session
+    if (session->username && session->username != block->username) {
         free(session->username);
     }
 
-    // Free the session structure itself
-    free(session);
+    // Free the session block with the structure, key and username
+    free(block);
 
     printf("terminate_session: Session terminated successfully.\n");
 }
@@ -0,0 +1,598 @@
+// session_table.c
+
+#include "secure_comm.h"
+
+#include <stdio.h>      // For fprintf
+#include <stdlib.h>     // For calloc, free, posix_memalign
+#include <string.h>     // For memcpy, memcmp, memset
+#include <pthread.h>    // For the shard locks
+#include <time.h>       // For clock_gettime
+
+#include <openssl/rand.h>     // For session IDs and the ticket key
+#include <openssl/crypto.h>   // For OPENSSL_cleanse
+
+// Timer wheel slots per shard; sessions idle for longer stay in their slot for extra turns
+#define SESSION_WHEEL_SLOTS 512
+#define SESSION_CHUNK_ENTRIES 1024
+#define SESSION_TICKET_PLAIN_SIZE (SESSION_ID_SIZE + SESSION_KEY_SIZE + 8)
+// Tickets issued this far in the future are still accepted (clock steps between servers)
+#define SESSION_TICKET_SKEW_MS 60000
+
+// Links hold an entry index + 1, so zero ends a list
+#define SESSION_NONE 0
+
+/**
+ * @brief One session: exactly one cache line.
+ */
+typedef struct {
+    unsigned char id[SESSION_ID_SIZE];
+    unsigned char key[SESSION_KEY_SIZE];
+    uint32_t hash_next;         // Next entry in the bucket chain, or in the free list
+    uint32_t wheel_next;        // Neighbours in the timer wheel slot
+    uint32_t wheel_prev;
+    uint32_t expires;           // Tick at which the session idles out
+} session_entry_t;
+
+_Static_assert(sizeof(session_entry_t) == 64, "session entries must fill one cache line");
+
+/**
+ * @brief One independently locked partition of the table.
+ */
+typedef struct {
+    _Alignas(64) pthread_mutex_t lock;
+    uint32_t* buckets;          // bucket_mask + 1 chain heads
+    uint32_t bucket_mask;
+    uint32_t capacity;          // Entries this shard holds at most
+    uint32_t chunk_entries;     // Entries per storage chunk
+    uint32_t used;              // Entries carved from the chunks so far
+    uint32_t free_list;
+    uint32_t live;
+    uint32_t tick;              // Last tick the wheel was advanced to
+    session_entry_t** chunks;   // Entry storage; chunks never move once allocated
+    uint32_t wheel[SESSION_WHEEL_SLOTS];
+    uint64_t inserted;
+    uint64_t lookups;
+    uint64_t hits;
+    uint64_t expired;
+    uint64_t evicted;
+} session_shard_t;
+
+// Definition of the opaque SessionTable structure
+struct SessionTable {
+    session_shard_t* shards;
+    uint32_t shard_mask;
+    uint32_t tick_ms;
+    uint32_t idle_ticks;        // Idle timeout in ticks
+    uint32_t ticket_lifetime_ms;
+    uint64_t epoch_ms;          // Monotonic time of tick 0
+    unsigned char ticket_key[SESSION_KEY_SIZE];
+    _Atomic uint64_t resumed;
+    _Atomic uint64_t tickets_rejected;
+};
+
+static uint64_t clock_ms(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+}
+
+static uint32_t table_now(const SessionTable* table) {
+    return (uint32_t)((clock_ms(CLOCK_MONOTONIC) - table->epoch_ms) / table->tick_ms);
+}
+
+/**
+ * @brief Session IDs are random, so their first bytes already make a good hash.
+ */
+static uint64_t session_hash(const unsigned char* id) {
+    uint64_t hash;
+    memcpy(&hash, id, sizeof(hash));
+    return hash;
+}
+
+static session_shard_t* table_shard(const SessionTable* table, uint64_t hash) {
+    return &table->shards[hash & table->shard_mask];
+}
+
+static session_entry_t* entry_at(const session_shard_t* shard, uint32_t index) {
+    uint32_t slot = index - 1;
+    return &shard->chunks[slot / shard->chunk_entries][slot % shard->chunk_entries];
+}
+
+static void wheel_link(session_shard_t* shard, uint32_t index, session_entry_t* entry) {
+    uint32_t* head = &shard->wheel[entry->expires & (SESSION_WHEEL_SLOTS - 1)];
+    entry->wheel_prev = SESSION_NONE;
+    entry->wheel_next = *head;
+    if (*head != SESSION_NONE) {
+        entry_at(shard, *head)->wheel_prev = index;
+    }
+    *head = index;
+}
+
+static void wheel_unlink(session_shard_t* shard, session_entry_t* entry) {
+    if (entry->wheel_prev != SESSION_NONE) {
+        entry_at(shard, entry->wheel_prev)->wheel_next = entry->wheel_next;
+    } else {
+        shard->wheel[entry->expires & (SESSION_WHEEL_SLOTS - 1)] = entry->wheel_next;
+    }
+    if (entry->wheel_next != SESSION_NONE) {
+        entry_at(shard, entry->wheel_next)->wheel_prev = entry->wheel_prev;
+    }
+}
+
+/**
+ * @brief Returns the link that points at the session, or the empty link ending its bucket.
+ */
+static uint32_t* shard_find(session_shard_t* shard, uint64_t hash, const unsigned char* id) {
+    uint32_t* link = &shard->buckets[(hash >> 32) & shard->bucket_mask];
+    while (*link != SESSION_NONE) {
+        session_entry_t* entry = entry_at(shard, *link);
+        if (memcmp(entry->id, id, SESSION_ID_SIZE) == 0) {
+            break;
+        }
+        link = &entry->hash_next;
+    }
+    return link;
+}
+
+/**
+ * @brief Unlinks the session *link points at, erases it and frees its entry.
+ */
+static void shard_drop(session_shard_t* shard, uint32_t* link) {
+    uint32_t index = *link;
+    session_entry_t* entry = entry_at(shard, index);
+    *link = entry->hash_next;
+    wheel_unlink(shard, entry);
+    OPENSSL_cleanse(entry, sizeof(*entry));
+    entry->hash_next = shard->free_list;
+    shard->free_list = index;
+    shard->live--;
+}
+
+/**
+ * @brief Restarts a session's idle timer.
+ */
+static void shard_touch(const SessionTable* table, session_shard_t* shard, uint32_t index,
+                        session_entry_t* entry, uint32_t now) {
+    wheel_unlink(shard, entry);
+    entry->expires = now + table->idle_ticks;
+    wheel_link(shard, index, entry);
+}
+
+/**
+ * @brief Drops the sessions that expired between the shard's last tick and now.
+ *
+ * Each elapsed tick visits one wheel slot. Sessions in that slot expiring on a
+ * later turn of the wheel stay where they are.
+ */
+static size_t shard_advance(session_shard_t* shard, uint32_t now) {
+    uint32_t ticks = now - shard->tick;
+    if (ticks > SESSION_WHEEL_SLOTS) {
+        ticks = SESSION_WHEEL_SLOTS;
+    }
+
+    size_t dropped = 0;
+    for (uint32_t t = 1; t <= ticks; t++) {
+        uint32_t index = shard->wheel[(shard->tick + t) & (SESSION_WHEEL_SLOTS - 1)];
+        while (index != SESSION_NONE) {
+            session_entry_t* entry = entry_at(shard, index);
+            uint32_t next = entry->wheel_next;
+            if ((int32_t)(entry->expires - now) <= 0) {
+                shard_drop(shard, shard_find(shard, session_hash(entry->id), entry->id));
+                dropped++;
+            }
+            index = next;
+        }
+    }
+    shard->tick = now;
+    shard->expired += dropped;
+    return dropped;
+}
+
+/**
+ * @brief Makes room in a full shard by dropping the session closest to expiry.
+ */
+static void shard_evict(session_shard_t* shard) {
+    for (uint32_t s = 1; s <= SESSION_WHEEL_SLOTS; s++) {
+        uint32_t index = shard->wheel[(shard->tick + s) & (SESSION_WHEEL_SLOTS - 1)];
+        if (index != SESSION_NONE) {
+            session_entry_t* entry = entry_at(shard, index);
+            shard_drop(shard, shard_find(shard, session_hash(entry->id), entry->id));
+            shard->evicted++;
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Takes a free entry, growing the storage by one chunk when needed.
+ *
+ * @return The entry index, or SESSION_NONE on allocation failure.
+ */
+static uint32_t shard_alloc(session_shard_t* shard) {
+    if (shard->free_list == SESSION_NONE && shard->used == shard->capacity) {
+        shard_evict(shard);
+    }
+    if (shard->free_list != SESSION_NONE) {
+        uint32_t index = shard->free_list;
+        shard->free_list = entry_at(shard, index)->hash_next;
+        return index;
+    }
+
+    if (shard->used % shard->chunk_entries == 0) {
+        void* chunk = NULL;
+        if (posix_memalign(&chunk, sizeof(session_entry_t), (size_t)shard->chunk_entries * sizeof(session_entry_t)) != 0) {
+            return SESSION_NONE;
+        }
+        shard->chunks[shard->used / shard->chunk_entries] = (session_entry_t*)chunk;
+    }
+    return ++shard->used;
+}
+
+/**
+ * @brief Adds a session under the given ID, or refreshes it if the ID is taken and replace is set.
+ *
+ * @return SECURE_COMM_SUCCESS, SECURE_COMM_ERR_SESSION if the ID is taken and
+ *         replace is clear, or SECURE_COMM_ERR_MEMORY.
+ */
+static SecureCommError table_put(SessionTable* table, const unsigned char* id, const unsigned char* key, int replace) {
+    uint64_t hash = session_hash(id);
+    session_shard_t* shard = table_shard(table, hash);
+    uint32_t now = table_now(table);
+
+    pthread_mutex_lock(&shard->lock);
+    shard_advance(shard, now);
+
+    uint32_t* link = shard_find(shard, hash, id);
+    if (*link != SESSION_NONE) {
+        if (!replace) {
+            pthread_mutex_unlock(&shard->lock);
+            return SECURE_COMM_ERR_SESSION;
+        }
+        session_entry_t* entry = entry_at(shard, *link);
+        memcpy(entry->key, key, SESSION_KEY_SIZE);
+        shard_touch(table, shard, *link, entry, now);
+        pthread_mutex_unlock(&shard->lock);
+        return SECURE_COMM_SUCCESS;
+    }
+
+    uint32_t index = shard_alloc(shard);
+    if (index == SESSION_NONE) {
+        pthread_mutex_unlock(&shard->lock);
+        fprintf(stderr, "session_table: Failed to allocate session storage\n");
+        return SECURE_COMM_ERR_MEMORY;
+    }
+
+    // Eviction may have reshaped the chain, so insert at the bucket head
+    session_entry_t* entry = entry_at(shard, index);
+    uint32_t* head = &shard->buckets[(hash >> 32) & shard->bucket_mask];
+    memcpy(entry->id, id, SESSION_ID_SIZE);
+    memcpy(entry->key, key, SESSION_KEY_SIZE);
+    entry->hash_next = *head;
+    *head = index;
+    entry->expires = now + table->idle_ticks;
+    wheel_link(shard, index, entry);
+    shard->live++;
+    shard->inserted++;
+    pthread_mutex_unlock(&shard->lock);
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Fills a SessionTableConfig with the defaults.
+ */
+void session_table_config_defaults(SessionTableConfig* config) {
+    if (config == NULL) {
+        return;
+    }
+    config->shards = 64;
+    config->max_sessions = 262144;
+    config->idle_timeout_ms = 300000;
+    config->tick_ms = 1000;
+    config->ticket_lifetime_ms = 86400000;
+    config->ticket_key = NULL;
+}
+
+/**
+ * @brief Creates a session table.
+ */
+SecureCommError session_table_create(const SessionTableConfig* config, SessionTable** table) {
+    SessionTableConfig defaults;
+    if (config == NULL) {
+        session_table_config_defaults(&defaults);
+        config = &defaults;
+    }
+    if (table == NULL || config->shards == 0 || config->shards > 4096 || config->max_sessions < config->shards ||
+        config->max_sessions > UINT32_MAX / 2 || config->tick_ms == 0 || config->idle_timeout_ms == 0) {
+        fprintf(stderr, "session_table_create: Invalid arguments\n");
+        return SECURE_COMM_ERR_SESSION;
+    }
+
+    SessionTable* new_table = (SessionTable*)calloc(1, sizeof(SessionTable));
+    if (new_table == NULL) {
+        fprintf(stderr, "session_table_create: Failed to allocate memory for table\n");
+        return SECURE_COMM_ERR_MEMORY;
+    }
+
+    size_t shard_count = 1;
+    while (shard_count < config->shards) {
+        shard_count <<= 1;
+    }
+    void* shards = NULL;
+    if (posix_memalign(&shards, 64, shard_count * sizeof(session_shard_t)) != 0) {
+        fprintf(stderr, "session_table_create: Failed to allocate memory for shards\n");
+        free(new_table);
+        return SECURE_COMM_ERR_MEMORY;
+    }
+    memset(shards, 0, shard_count * sizeof(session_shard_t));
+    new_table->shards = (session_shard_t*)shards;
+    new_table->shard_mask = (uint32_t)(shard_count - 1);
+    new_table->tick_ms = config->tick_ms;
+    new_table->idle_ticks = (config->idle_timeout_ms + config->tick_ms - 1) / config->tick_ms;
+    new_table->ticket_lifetime_ms = config->ticket_lifetime_ms;
+    new_table->epoch_ms = clock_ms(CLOCK_MONOTONIC);
+
+    if (config->ticket_key != NULL) {
+        memcpy(new_table->ticket_key, config->ticket_key, SESSION_KEY_SIZE);
+    } else if (!RAND_bytes(new_table->ticket_key, SESSION_KEY_SIZE)) {
+        fprintf(stderr, "session_table_create: Failed to generate the ticket key\n");
+        free(shards);
+        free(new_table);
+        return SECURE_COMM_ERR_SESSION;
+    }
+
+    // Keep the buckets at one per session so chains stay short when the table is full
+    uint32_t per_shard = (uint32_t)((config->max_sessions + shard_count - 1) / shard_count);
+    uint32_t buckets = 1;
+    while (buckets < per_shard) {
+        buckets <<= 1;
+    }
+    for (size_t i = 0; i < shard_count; i++) {
+        session_shard_t* shard = &new_table->shards[i];
+        pthread_mutex_init(&shard->lock, NULL);
+        shard->capacity = per_shard;
+        shard->chunk_entries = per_shard < SESSION_CHUNK_ENTRIES ? per_shard : SESSION_CHUNK_ENTRIES;
+        shard->bucket_mask = buckets - 1;
+        shard->buckets = (uint32_t*)calloc(buckets, sizeof(uint32_t));
+        shard->chunks = (session_entry_t**)calloc((per_shard + shard->chunk_entries - 1) / shard->chunk_entries,
+                                                  sizeof(session_entry_t*));
+        if (shard->buckets == NULL || shard->chunks == NULL) {
+            fprintf(stderr, "session_table_create: Failed to allocate memory for shard %zu\n", i);
+            session_table_destroy(new_table);
+            return SECURE_COMM_ERR_MEMORY;
+        }
+    }
+
+    *table = new_table;
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Adds a session and assigns it a random ID.
+ */
+SecureCommError session_table_insert(SessionTable* table, const unsigned char* key, unsigned char* id) {
+    if (table == NULL || key == NULL || id == NULL) {
+        fprintf(stderr, "session_table_insert: Invalid arguments\n");
+        return SECURE_COMM_ERR_SESSION;
+    }
+
+    // A colliding ID is astronomically unlikely, but never hand out one that is live
+    SecureCommError ret;
+    do {
+        if (!RAND_bytes(id, SESSION_ID_SIZE)) {
+            fprintf(stderr, "session_table_insert: Failed to generate a session ID\n");
+            return SECURE_COMM_ERR_SESSION;
+        }
+        ret = table_put(table, id, key, 0);
+    } while (ret == SECURE_COMM_ERR_SESSION);
+    return ret;
+}
+
+/**
+ * @brief Finds a live session and restarts its idle timer.
+ */
+SecureCommError session_table_lookup(SessionTable* table, const unsigned char* id, unsigned char* key) {
+    if (table == NULL || id == NULL) {
+        fprintf(stderr, "session_table_lookup: Invalid arguments\n");
+        return SECURE_COMM_ERR_SESSION;
+    }
+
+    uint64_t hash = session_hash(id);
+    session_shard_t* shard = table_shard(table, hash);
+    uint32_t now = table_now(table);
+
+    pthread_mutex_lock(&shard->lock);
+    shard_advance(shard, now);
+    shard->lookups++;
+    uint32_t index = *shard_find(shard, hash, id);
+    if (index == SESSION_NONE) {
+        pthread_mutex_unlock(&shard->lock);
+        return SECURE_COMM_ERR_SESSION;
+    }
+    session_entry_t* entry = entry_at(shard, index);
+    if (key != NULL) {
+        memcpy(key, entry->key, SESSION_KEY_SIZE);
+    }
+    shard_touch(table, shard, index, entry, now);
+    shard->hits++;
+    pthread_mutex_unlock(&shard->lock);
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Drops a session and erases its key.
+ */
+SecureCommError session_table_remove(SessionTable* table, const unsigned char* id) {
+    if (table == NULL || id == NULL) {
+        fprintf(stderr, "session_table_remove: Invalid arguments\n");
+        return SECURE_COMM_ERR_SESSION;
+    }
+
+    uint64_t hash = session_hash(id);
+    session_shard_t* shard = table_shard(table, hash);
+
+    pthread_mutex_lock(&shard->lock);
+    uint32_t* link = shard_find(shard, hash, id);
+    if (*link == SESSION_NONE) {
+        pthread_mutex_unlock(&shard->lock);
+        return SECURE_COMM_ERR_SESSION;
+    }
+    shard_drop(shard, link);
+    pthread_mutex_unlock(&shard->lock);
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Drops every session whose idle timeout has passed.
+ */
+size_t session_table_expire(SessionTable* table) {
+    if (table == NULL) {
+        return 0;
+    }
+
+    uint32_t now = table_now(table);
+    size_t dropped = 0;
+    for (uint32_t i = 0; i <= table->shard_mask; i++) {
+        session_shard_t* shard = &table->shards[i];
+        pthread_mutex_lock(&shard->lock);
+        dropped += shard_advance(shard, now);
+        pthread_mutex_unlock(&shard->lock);
+    }
+    return dropped;
+}
+
+/**
+ * @brief Seals a live session into a resumption ticket for its client.
+ */
+SecureCommError session_table_issue_ticket(SessionTable* table, const unsigned char* id, unsigned char* ticket) {
+    if (table == NULL || id == NULL || ticket == NULL) {
+        fprintf(stderr, "session_table_issue_ticket: Invalid arguments\n");
+        return SECURE_COMM_ERR_SESSION;
+    }
+
+    // Session ID || key || issue time in milliseconds since the epoch, big-endian
+    unsigned char plain[SESSION_TICKET_PLAIN_SIZE];
+    memcpy(plain, id, SESSION_ID_SIZE);
+    if (session_table_lookup(table, id, plain + SESSION_ID_SIZE) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "session_table_issue_ticket: Unknown session\n");
+        return SECURE_COMM_ERR_SESSION;
+    }
+    uint64_t issued = clock_ms(CLOCK_REALTIME);
+    for (int i = 0; i < 8; i++) {
+        plain[SESSION_ID_SIZE + SESSION_KEY_SIZE + i] = (unsigned char)(issued >> (56 - 8 * i));
+    }
+
+    int sealed_len = 0;
+    SecureCommError ret = encrypt_data(plain, (int)sizeof(plain), table->ticket_key, ticket,
+                                       ticket + SECURE_RECORD_OVERHEAD, &sealed_len, ticket + 12);
+    OPENSSL_cleanse(plain, sizeof(plain));
+    if (ret != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "session_table_issue_ticket: Failed to seal the ticket\n");
+    }
+    return ret;
+}
+
+/**
+ * @brief Restores a session from a ticket, skipping authentication and key exchange.
+ */
+SecureCommError session_table_resume(SessionTable* table, const unsigned char* ticket, size_t ticket_len,
+                                     unsigned char* id, unsigned char* key) {
+    if (table == NULL || ticket == NULL || key == NULL) {
+        fprintf(stderr, "session_table_resume: Invalid arguments\n");
+        return SECURE_COMM_ERR_SESSION;
+    }
+    if (ticket_len != SESSION_TICKET_SIZE) {
+        table->tickets_rejected++;
+        fprintf(stderr, "session_table_resume: Ticket has %zu bytes, expected %d\n", ticket_len, SESSION_TICKET_SIZE);
+        return SECURE_COMM_ERR_SESSION;
+    }
+
+    unsigned char plain[SESSION_TICKET_PLAIN_SIZE];
+    int plain_len = 0;
+    if (decrypt_data(ticket + SECURE_RECORD_OVERHEAD, SESSION_TICKET_PLAIN_SIZE, table->ticket_key, ticket,
+                     plain, &plain_len, ticket + 12) != SECURE_COMM_SUCCESS) {
+        table->tickets_rejected++;
+        fprintf(stderr, "session_table_resume: Ticket failed authentication\n");
+        return SECURE_COMM_ERR_SESSION;
+    }
+
+    uint64_t issued = 0;
+    for (int i = 0; i < 8; i++) {
+        issued = (issued << 8) | plain[SESSION_ID_SIZE + SESSION_KEY_SIZE + i];
+    }
+    uint64_t now = clock_ms(CLOCK_REALTIME);
+    if (issued > now + SESSION_TICKET_SKEW_MS || (now > issued && now - issued > table->ticket_lifetime_ms)) {
+        OPENSSL_cleanse(plain, sizeof(plain));
+        table->tickets_rejected++;
+        fprintf(stderr, "session_table_resume: Ticket has expired\n");
+        return SECURE_COMM_ERR_SESSION;
+    }
+
+    SecureCommError ret = table_put(table, plain, plain + SESSION_ID_SIZE, 1);
+    if (ret == SECURE_COMM_SUCCESS) {
+        if (id != NULL) {
+            memcpy(id, plain, SESSION_ID_SIZE);
+        }
+        memcpy(key, plain + SESSION_ID_SIZE, SESSION_KEY_SIZE);
+        table->resumed++;
+        metrics_count(METRIC_SESSIONS_RESUMED, 1);
+    }
+    OPENSSL_cleanse(plain, sizeof(plain));
+    return ret;
+}
+
+/**
+ * @brief Copies the table counters.
+ */
+void session_table_stats(SessionTable* table, SessionTableStats* stats) {
+    if (stats == NULL) {
+        return;
+    }
+    memset(stats, 0, sizeof(*stats));
+    if (table == NULL) {
+        return;
+    }
+
+    stats->memory_bytes = (table->shard_mask + 1) * sizeof(session_shard_t);
+    for (uint32_t i = 0; i <= table->shard_mask; i++) {
+        session_shard_t* shard = &table->shards[i];
+        pthread_mutex_lock(&shard->lock);
+        stats->sessions += shard->live;
+        stats->inserted += shard->inserted;
+        stats->lookups += shard->lookups;
+        stats->hits += shard->hits;
+        stats->expired += shard->expired;
+        stats->evicted += shard->evicted;
+        size_t chunks = (shard->used + shard->chunk_entries - 1) / shard->chunk_entries;
+        stats->memory_bytes += chunks * shard->chunk_entries * sizeof(session_entry_t) +
+                               (size_t)(shard->bucket_mask + 1) * sizeof(uint32_t);
+        pthread_mutex_unlock(&shard->lock);
+    }
+    stats->resumed = table->resumed;
+    stats->tickets_rejected = table->tickets_rejected;
+}
+
+/**
+ * @brief Destroys a session table, erasing every key.
+ */
+void session_table_destroy(SessionTable* table) {
+    if (table == NULL) {
+        return;
+    }
+
+    for (uint32_t i = 0; i <= table->shard_mask; i++) {
+        session_shard_t* shard = &table->shards[i];
+        if (shard->chunks != NULL) {
+            size_t chunks = (shard->used + shard->chunk_entries - 1) / shard->chunk_entries;
+            for (size_t c = 0; c < chunks; c++) {
+                OPENSSL_cleanse(shard->chunks[c], (size_t)shard->chunk_entries * sizeof(session_entry_t));
+                free(shard->chunks[c]);
+            }
+        }
+        free(shard->chunks);
+        free(shard->buckets);
+        pthread_mutex_destroy(&shard->lock);
+    }
+    OPENSSL_cleanse(table->ticket_key, sizeof(table->ticket_key));
+    free(table->shards);
+    free(table);
+}
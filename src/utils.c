@@ -9,6 +9,11 @@
 #include <time.h>
 #include <pthread.h> // For mutex (POSIX)
 #include <errno.h>
+#include <stdint.h>     // For intptr_t
+#include <stdatomic.h>  // For the lock-free log ring
+#include <signal.h>     // For the SIGHUP reload handler
+#include <unistd.h>     // For the reload thread's self-pipe
+#include <fcntl.h>      // For O_NONBLOCK and FD_CLOEXEC
 
 #include "cJSON.h" // Include cJSON header
 
@@ -16,9 +21,246 @@
 static pthread_mutex_t log_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 // Global variables for logging
-static LogLevel current_log_level = LOG_LEVEL_INFO;
+_Atomic LogLevel secure_comm_log_level = LOG_LEVEL_INFO;
 static FILE* log_file = NULL;
 
+// One queued line of the async logger
+typedef struct {
+    atomic_size_t sequence;     // pos when free for position pos, pos + 1 once filled
+    LogLevel level;
+    struct timespec time;       // Wall-clock time of the log_message call
+    char message[SECURE_LOG_MESSAGE_MAX];
+} log_slot_t;
+
+// Bounded multi-producer ring drained by one writer thread. Producers claim a
+// position with a CAS on tail and publish the slot through its sequence number,
+// so log_message never takes a lock unless it has to sleep (LOG_FULL_BLOCK).
+typedef struct {
+    AsyncLogConfig config;
+    log_slot_t* slots;
+    size_t mask;                // Capacity - 1 (capacity is a power of two)
+    atomic_size_t tail;         // Next position producers claim
+    size_t head;                // Next position to write (writer thread only)
+    atomic_int writer_idle;     // Set while the writer sleeps on wake
+    atomic_int waiters;         // Producers sleeping on space
+    atomic_int stopping;
+    pthread_mutex_t wait_lock;  // Only taken to sleep or to wake a sleeper
+    pthread_cond_t wake;        // Writer waits here for new lines
+    pthread_cond_t space;       // Blocked producers wait here for free slots
+    pthread_t writer;
+    atomic_uint_fast64_t written;
+    atomic_uint_fast64_t dropped;
+    atomic_uint_fast64_t blocked;
+} async_logger_t;
+
+// Non-NULL while logging runs in async mode
+static async_logger_t* _Atomic async_logger = NULL;
+
+// Threads between async_logger_enter and async_logger_leave. It lives outside the
+// logger so raising it never touches memory cleanup_logging may free.
+static atomic_int async_logger_users = 0;
+
+/**
+ * @brief Returns the tag printed for a log level.
+ */
+static const char* log_level_name(LogLevel level) {
+    static const char* level_strings[] = {"ERROR", "WARN", "INFO", "DEBUG"};
+    if (level >= LOG_LEVEL_ERROR && level <= LOG_LEVEL_DEBUG) {
+        return level_strings[level];
+    }
+    return "UNKNOWN";
+}
+
+/**
+ * @brief Adds a time in ms to now, for pthread_cond_timedwait.
+ */
+static void deadline_after_ms(struct timespec* deadline, unsigned int ms) {
+    clock_gettime(CLOCK_REALTIME, deadline);
+    deadline->tv_sec += ms / 1000;
+    deadline->tv_nsec += (long)(ms % 1000) * 1000000L;
+    if (deadline->tv_nsec >= 1000000000L) {
+        deadline->tv_sec++;
+        deadline->tv_nsec -= 1000000000L;
+    }
+}
+
+/**
+ * @brief Returns the async logger with a reference that keeps it alive, or NULL.
+ *
+ * cleanup_logging unpublishes the logger first and then waits for the count to
+ * drop to zero, so a thread that still sees the logger after counting itself in
+ * can use it until async_logger_leave.
+ */
+static async_logger_t* async_logger_enter(void) {
+    if (atomic_load_explicit(&async_logger, memory_order_relaxed) == NULL) {
+        return NULL;
+    }
+    atomic_fetch_add(&async_logger_users, 1);
+    async_logger_t* logger = atomic_load(&async_logger);
+    if (logger == NULL) {
+        atomic_fetch_sub(&async_logger_users, 1);
+    }
+    return logger;
+}
+
+/**
+ * @brief Drops the reference taken by a successful async_logger_enter.
+ */
+static void async_logger_leave(void) {
+    atomic_fetch_sub_explicit(&async_logger_users, 1, memory_order_release);
+}
+
+/**
+ * @brief Fills an AsyncLogConfig with the defaults.
+ *
+ * @param config The configuration to fill.
+ */
+void async_log_config_defaults(AsyncLogConfig* config) {
+    if (config == NULL) {
+        return;
+    }
+    memset(config, 0, sizeof(AsyncLogConfig));
+    config->capacity = 1024;
+    config->on_full = LOG_FULL_DROP;
+    config->flush_interval_ms = 100;
+}
+
+/**
+ * @brief Writer thread: drains the ring in batches, one fflush per batch.
+ */
+static void* async_log_writer(void* arg) {
+    async_logger_t* logger = (async_logger_t*)arg;
+
+    // Timestamps are reformatted only when the second changes
+    char time_buffer[20] = "";
+    time_t cached_second = (time_t)-1;
+
+    while (1) {
+        uint64_t batch = 0;
+        while (1) {
+            log_slot_t* slot = &logger->slots[logger->head & logger->mask];
+            if (atomic_load_explicit(&slot->sequence, memory_order_acquire) != logger->head + 1) {
+                break;
+            }
+
+            if (slot->time.tv_sec != cached_second) {
+                struct tm timeinfo;
+                if (localtime_r(&slot->time.tv_sec, &timeinfo) == NULL ||
+                    strftime(time_buffer, sizeof(time_buffer), "%Y-%m-%d %H:%M:%S", &timeinfo) == 0) {
+                    strcpy(time_buffer, "?");
+                }
+                cached_second = slot->time.tv_sec;
+            }
+            fprintf(log_file, "[%s] [%s] %s\n", time_buffer, log_level_name(slot->level), slot->message);
+
+            // Hand the slot back to producers for the next lap of the ring
+            atomic_store_explicit(&slot->sequence, logger->head + logger->mask + 1, memory_order_release);
+            logger->head++;
+            batch++;
+        }
+
+        if (batch > 0) {
+            fflush(log_file);
+            atomic_fetch_add_explicit(&logger->written, batch, memory_order_relaxed);
+            if (atomic_load(&logger->waiters) > 0) {
+                pthread_mutex_lock(&logger->wait_lock);
+                pthread_cond_broadcast(&logger->space);
+                pthread_mutex_unlock(&logger->wait_lock);
+            }
+            continue;
+        }
+
+        // Every claimed slot is written before exiting. cleanup_logging stops the writer
+        // only once no producer is left, so by then each claim has been published.
+        int drained = logger->head == atomic_load(&logger->tail);
+        if (atomic_load(&logger->stopping) && drained) {
+            break;
+        }
+
+        // Announce the sleep, then look once more so a line published meanwhile is not missed
+        pthread_mutex_lock(&logger->wait_lock);
+        atomic_store(&logger->writer_idle, 1);
+        log_slot_t* next = &logger->slots[logger->head & logger->mask];
+        if (atomic_load(&next->sequence) != logger->head + 1 && !(atomic_load(&logger->stopping) && drained)) {
+            struct timespec deadline;
+            deadline_after_ms(&deadline, logger->config.flush_interval_ms);
+            pthread_cond_timedwait(&logger->wake, &logger->wait_lock, &deadline);
+        }
+        atomic_store(&logger->writer_idle, 0);
+        pthread_mutex_unlock(&logger->wait_lock);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Claims the next free slot of the ring.
+ *
+ * @return The slot (its position in *pos), or NULL if the ring is full.
+ */
+static log_slot_t* async_log_claim(async_logger_t* logger, size_t* pos) {
+    size_t claim = atomic_load_explicit(&logger->tail, memory_order_relaxed);
+    while (1) {
+        log_slot_t* slot = &logger->slots[claim & logger->mask];
+        size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)sequence - (intptr_t)claim;
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&logger->tail, &claim, claim + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                *pos = claim;
+                return slot;
+            }
+        } else if (diff < 0) {
+            return NULL; // The writer has not freed this slot yet
+        } else {
+            claim = atomic_load_explicit(&logger->tail, memory_order_relaxed);
+        }
+    }
+}
+
+/**
+ * @brief Formats one line into the ring and wakes the writer if it sleeps.
+ */
+static SecureCommError async_log_vwrite(async_logger_t* logger, LogLevel level, const char* format, va_list args) {
+    size_t pos = 0;
+    log_slot_t* slot;
+    while ((slot = async_log_claim(logger, &pos)) == NULL) {
+        if (logger->config.on_full == LOG_FULL_DROP) {
+            atomic_fetch_add_explicit(&logger->dropped, 1, memory_order_relaxed);
+            return SECURE_COMM_ERR_AGAIN;
+        }
+
+        // LOG_FULL_BLOCK: sleep until the writer frees a batch of slots
+        atomic_fetch_add_explicit(&logger->blocked, 1, memory_order_relaxed);
+        pthread_mutex_lock(&logger->wait_lock);
+        atomic_fetch_add(&logger->waiters, 1);
+        pthread_cond_signal(&logger->wake);
+        struct timespec deadline;
+        deadline_after_ms(&deadline, 10);
+        pthread_cond_timedwait(&logger->space, &logger->wait_lock, &deadline);
+        atomic_fetch_sub(&logger->waiters, 1);
+        pthread_mutex_unlock(&logger->wait_lock);
+    }
+
+    SecureCommError ret = SECURE_COMM_SUCCESS;
+    clock_gettime(CLOCK_REALTIME, &slot->time);
+    slot->level = level;
+    if (vsnprintf(slot->message, sizeof(slot->message), format, args) < 0) {
+        // The slot is already claimed, so it is published either way
+        strcpy(slot->message, "(log format error)");
+        ret = SECURE_COMM_ERR_LOG;
+    }
+    atomic_store_explicit(&slot->sequence, pos + 1, memory_order_release);
+
+    // Pairs with the writer announcing writer_idle before its last look at the ring
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&logger->writer_idle, memory_order_relaxed)) {
+        pthread_mutex_lock(&logger->wait_lock);
+        pthread_cond_signal(&logger->wake);
+        pthread_mutex_unlock(&logger->wait_lock);
+    }
+    return ret;
+}
+
 /**
  * @brief Initializes the logging system.
  *
@@ -30,7 +272,7 @@ static FILE* log_file = NULL;
 SecureCommError init_logging(LogLevel level, const char* log_file_path) {
     pthread_mutex_lock(&log_mutex);
 
-    current_log_level = level;
+    atomic_store_explicit(&secure_comm_log_level, level, memory_order_relaxed);
 
     if (log_file_path != NULL && strlen(log_file_path) > 0) {
         log_file = fopen(log_file_path, "a");
@@ -47,9 +289,100 @@ SecureCommError init_logging(LogLevel level, const char* log_file_path) {
     return SECURE_COMM_SUCCESS;
 }
 
+/**
+ * @brief Initializes logging with a background writer thread.
+ *
+ * @param level The minimum log level to output.
+ * @param log_file_path The file path for logging output. If NULL, logs will be output to the console.
+ * @param config Ring parameters, or NULL for the defaults.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError init_logging_async(LogLevel level, const char* log_file_path, const AsyncLogConfig* config) {
+    AsyncLogConfig cfg;
+    if (config) {
+        cfg = *config;
+    } else {
+        async_log_config_defaults(&cfg);
+    }
+    if (cfg.capacity < 2 || cfg.flush_interval_ms == 0 ||
+        (cfg.on_full != LOG_FULL_DROP && cfg.on_full != LOG_FULL_BLOCK)) {
+        fprintf(stderr, "init_logging_async: Invalid configuration\n");
+        return SECURE_COMM_ERR_LOG;
+    }
+    if (atomic_load(&async_logger) != NULL) {
+        fprintf(stderr, "init_logging_async: Async logging is already running\n");
+        return SECURE_COMM_ERR_LOG;
+    }
+
+    size_t capacity = 2;
+    while (capacity < cfg.capacity) {
+        capacity <<= 1;
+    }
+    cfg.capacity = capacity;
+
+    async_logger_t* logger = (async_logger_t*)calloc(1, sizeof(async_logger_t));
+    log_slot_t* slots = (log_slot_t*)calloc(capacity, sizeof(log_slot_t));
+    if (logger == NULL || slots == NULL) {
+        fprintf(stderr, "init_logging_async: Failed to allocate memory for the log ring\n");
+        free(logger);
+        free(slots);
+        return SECURE_COMM_ERR_MEMORY;
+    }
+    logger->config = cfg;
+    logger->slots = slots;
+    logger->mask = capacity - 1;
+    for (size_t i = 0; i < capacity; i++) {
+        atomic_init(&slots[i].sequence, i);
+    }
+    pthread_mutex_init(&logger->wait_lock, NULL);
+    pthread_cond_init(&logger->wake, NULL);
+    pthread_cond_init(&logger->space, NULL);
+
+    SecureCommError ret = init_logging(level, log_file_path);
+    if (ret == SECURE_COMM_SUCCESS && pthread_create(&logger->writer, NULL, async_log_writer, logger) != 0) {
+        fprintf(stderr, "init_logging_async: Failed to start the writer thread\n");
+        cleanup_logging();
+        ret = SECURE_COMM_ERR_LOG;
+    }
+    if (ret != SECURE_COMM_SUCCESS) {
+        pthread_cond_destroy(&logger->space);
+        pthread_cond_destroy(&logger->wake);
+        pthread_mutex_destroy(&logger->wait_lock);
+        free(slots);
+        free(logger);
+        return ret;
+    }
+
+    atomic_store_explicit(&async_logger, logger, memory_order_release);
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Copies the async logger counters (all zero in synchronous mode).
+ *
+ * @param stats Pointer to store the counters.
+ */
+void logging_stats(LogStats* stats) {
+    if (stats == NULL) {
+        return;
+    }
+    memset(stats, 0, sizeof(LogStats));
+    async_logger_t* logger = async_logger_enter();
+    if (logger) {
+        stats->written = atomic_load(&logger->written);
+        stats->dropped = atomic_load(&logger->dropped);
+        stats->blocked = atomic_load(&logger->blocked);
+        async_logger_leave();
+    }
+}
+
 /**
  * @brief Logs a message with the specified log level.
  *
+ * In async mode the line is queued for the writer thread; with LOG_FULL_DROP a
+ * full ring makes this return SECURE_COMM_ERR_AGAIN without logging.
+ *
  * @param level The log level of the message.
  * @param format The format string (printf-style).
  * @param ... Additional arguments for the format string.
@@ -57,10 +390,28 @@ SecureCommError init_logging(LogLevel level, const char* log_file_path) {
  * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
  */
 SecureCommError log_message(LogLevel level, const char* format, ...) {
-    if (level > current_log_level) {
+    if (level > atomic_load_explicit(&secure_comm_log_level, memory_order_relaxed)) {
         return SECURE_COMM_SUCCESS; // Do not log messages below the current log level
     }
 
+    if (binary_log_active()) {
+        va_list args;
+        va_start(args, format);
+        SecureCommError ret = binary_log_vwrite(level, format, args);
+        va_end(args);
+        return ret;
+    }
+
+    async_logger_t* logger = async_logger_enter();
+    if (logger) {
+        va_list args;
+        va_start(args, format);
+        SecureCommError ret = async_log_vwrite(logger, level, format, args);
+        va_end(args);
+        async_logger_leave();
+        return ret;
+    }
+
     pthread_mutex_lock(&log_mutex);
 
     // Get current time
@@ -83,14 +434,10 @@ SecureCommError log_message(LogLevel level, const char* format, ...) {
     }
 
     // Determine log level string
-    const char* level_strings[] = {"ERROR", "WARN", "INFO", "DEBUG"};
-    const char* level_str = "UNKNOWN";
-    if (level >= LOG_LEVEL_ERROR && level <= LOG_LEVEL_DEBUG) {
-        level_str = level_strings[level];
-    }
+    const char* level_str = log_level_name(level);
 
     // Prepare the formatted message
-    char message[1024];
+    char message[SECURE_LOG_MESSAGE_MAX];
     va_list args;
     va_start(args, format);
     int msg_len = vsnprintf(message, sizeof(message), format, args);
@@ -105,9 +452,10 @@ SecureCommError log_message(LogLevel level, const char* format, ...) {
     // Ensure null-termination
     message[sizeof(message) - 1] = '\0';
 
-    // Write to log destination
-    fprintf(log_file, "[%s] [%s] %s\n", time_buffer, level_str, message);
-    fflush(log_file);
+    // Write to log destination; before init_logging (or after cleanup_logging) that is the console
+    FILE* out = log_file != NULL ? log_file : stdout;
+    fprintf(out, "[%s] [%s] %s\n", time_buffer, level_str, message);
+    fflush(out);
 
     pthread_mutex_unlock(&log_mutex);
     return SECURE_COMM_SUCCESS;
@@ -117,9 +465,34 @@ SecureCommError log_message(LogLevel level, const char* format, ...) {
  * @brief Cleans up the logging system.
  *
  * This function should be called once all logging operations are complete.
- * It performs necessary cleanup tasks, such as closing log files.
+ * It performs necessary cleanup tasks, such as closing log files. In async mode
+ * it waits for threads still inside log_message, including producers blocked on
+ * a full ring, and the writer thread then writes every queued line.
  */
 void cleanup_logging() {
+    binary_log_close();
+
+    async_logger_t* logger = atomic_exchange(&async_logger, NULL);
+    if (logger) {
+        // New callers now log synchronously; the writer keeps draining so blocked producers finish
+        while (atomic_load_explicit(&async_logger_users, memory_order_acquire) > 0) {
+            struct timespec pause = { 0, 1000000 };
+            nanosleep(&pause, NULL);
+        }
+
+        pthread_mutex_lock(&logger->wait_lock);
+        atomic_store(&logger->stopping, 1);
+        pthread_cond_signal(&logger->wake);
+        pthread_mutex_unlock(&logger->wait_lock);
+        pthread_join(logger->writer, NULL);
+
+        pthread_cond_destroy(&logger->space);
+        pthread_cond_destroy(&logger->wake);
+        pthread_mutex_destroy(&logger->wait_lock);
+        free(logger->slots);
+        free(logger);
+    }
+
     pthread_mutex_lock(&log_mutex);
 
     if (log_file != NULL && log_file != stdout) {
@@ -128,7 +501,33 @@ void cleanup_logging() {
     }
 
     pthread_mutex_unlock(&log_mutex);
-    pthread_mutex_destroy(&log_mutex);
+}
+
+/**
+ * @brief Changes the minimum log level at run time.
+ *
+ * @param level The new minimum level.
+ */
+void logging_set_level(LogLevel level) {
+    atomic_store_explicit(&secure_comm_log_level, level, memory_order_relaxed);
+}
+
+/**
+ * @brief Reads an optional non-negative integer field, leaving *value alone when it is absent.
+ *
+ * @return 0 on success, -1 if the field is present but not a non-negative number.
+ */
+static int parse_optional_count(const cJSON* json, const char* name, int* value) {
+    const cJSON* item = cJSON_GetObjectItemCaseSensitive(json, name);
+    if (item == NULL) {
+        return 0;
+    }
+    if (!cJSON_IsNumber(item) || item->valueint < 0) {
+        fprintf(stderr, "load_configuration: '%s' must be a non-negative number\n", name);
+        return -1;
+    }
+    *value = item->valueint;
+    return 0;
 }
 
 /**
@@ -261,6 +660,139 @@ SecureCommError load_configuration(const char* config_path, Configuration* confi
         config->log_file_path[0] = '\0';
     }
 
+    // log_async (optional, defaults to synchronous logging)
+    cJSON* log_async = cJSON_GetObjectItemCaseSensitive(json, "log_async");
+    config->log_async = cJSON_IsTrue(log_async);
+
+    // log_queue_full (optional): what async producers do when the ring is full
+    config->log_full_policy = LOG_FULL_DROP;
+    cJSON* log_queue_full = cJSON_GetObjectItemCaseSensitive(json, "log_queue_full");
+    if (cJSON_IsString(log_queue_full) && (log_queue_full->valuestring != NULL)) {
+        if (strcmp(log_queue_full->valuestring, "block") == 0) {
+            config->log_full_policy = LOG_FULL_BLOCK;
+        } else if (strcmp(log_queue_full->valuestring, "drop") != 0) {
+            fprintf(stderr, "load_configuration: Unknown 'log_queue_full' value '%s'\n", log_queue_full->valuestring);
+            cJSON_Delete(json);
+            free(buffer);
+            return SECURE_COMM_ERR_CONFIG;
+        }
+    }
+
+    // log_format (optional): "text" (default) or "binary"
+    config->log_binary = 0;
+    cJSON* log_format = cJSON_GetObjectItemCaseSensitive(json, "log_format");
+    if (cJSON_IsString(log_format) && (log_format->valuestring != NULL)) {
+        if (strcmp(log_format->valuestring, "binary") == 0) {
+            config->log_binary = 1;
+        } else if (strcmp(log_format->valuestring, "text") != 0) {
+            fprintf(stderr, "load_configuration: Unknown 'log_format' value '%s'\n", log_format->valuestring);
+            cJSON_Delete(json);
+            free(buffer);
+            return SECURE_COMM_ERR_CONFIG;
+        }
+    }
+
+    // worker_threads (optional): CPU workers for crypto and compression, 0 for one per CPU
+    config->worker_threads = 0;
+    cJSON* worker_threads = cJSON_GetObjectItemCaseSensitive(json, "worker_threads");
+    if (worker_threads != NULL) {
+        if (!cJSON_IsNumber(worker_threads) || worker_threads->valueint < 0) {
+            fprintf(stderr, "load_configuration: 'worker_threads' must be a non-negative number\n");
+            cJSON_Delete(json);
+            free(buffer);
+            return SECURE_COMM_ERR_CONFIG;
+        }
+        config->worker_threads = worker_threads->valueint;
+    }
+
+    // worker_pin_cpus (optional, defaults to unpinned workers)
+    cJSON* worker_pin_cpus = cJSON_GetObjectItemCaseSensitive(json, "worker_pin_cpus");
+    config->worker_pin_cpus = cJSON_IsTrue(worker_pin_cpus);
+
+    // tls_ktls (optional, defaults to userspace TLS records)
+    cJSON* tls_ktls = cJSON_GetObjectItemCaseSensitive(json, "tls_ktls");
+    config->tls_ktls = cJSON_IsTrue(tls_ktls);
+
+    // connect_timeout_ms (optional, defaults to SECURE_CONNECT_DEFAULT_TIMEOUT_MS; 0 disables the limit)
+    config->connect_timeout_ms = SECURE_CONNECT_DEFAULT_TIMEOUT_MS;
+    cJSON* connect_timeout_ms = cJSON_GetObjectItemCaseSensitive(json, "connect_timeout_ms");
+    if (connect_timeout_ms != NULL) {
+        if (!cJSON_IsNumber(connect_timeout_ms) || connect_timeout_ms->valueint < 0) {
+            fprintf(stderr, "load_configuration: 'connect_timeout_ms' must be a non-negative number\n");
+            cJSON_Delete(json);
+            free(buffer);
+            return SECURE_COMM_ERR_CONFIG;
+        }
+        config->connect_timeout_ms = connect_timeout_ms->valueint;
+    }
+
+    // Performance tunables (optional): thread counts, socket and pool sizes
+    BufferPoolConfig pool_defaults;
+    AsyncLogConfig log_defaults;
+    buffer_pool_config_defaults(&pool_defaults);
+    async_log_config_defaults(&log_defaults);
+    config->reactor_threads = 1;
+    config->listen_backlog = 0;
+    config->socket_rcvbuf = 0;
+    config->socket_sndbuf = 0;
+    config->max_in_flight = 64;
+    int slab_size = (int)pool_defaults.slab_size;
+    int thread_cache = (int)pool_defaults.thread_cache;
+    int log_queue_capacity = (int)log_defaults.capacity;
+    int reactor_max_output = 0;
+    if (parse_optional_count(json, "reactor_threads", &config->reactor_threads) != 0 ||
+        parse_optional_count(json, "listen_backlog", &config->listen_backlog) != 0 ||
+        parse_optional_count(json, "socket_rcvbuf", &config->socket_rcvbuf) != 0 ||
+        parse_optional_count(json, "socket_sndbuf", &config->socket_sndbuf) != 0 ||
+        parse_optional_count(json, "max_in_flight", &config->max_in_flight) != 0 ||
+        parse_optional_count(json, "buffer_pool_slab_size", &slab_size) != 0 ||
+        parse_optional_count(json, "buffer_pool_thread_cache", &thread_cache) != 0 ||
+        parse_optional_count(json, "log_queue_capacity", &log_queue_capacity) != 0 ||
+        parse_optional_count(json, "reactor_max_output", &reactor_max_output) != 0) {
+        cJSON_Delete(json);
+        free(buffer);
+        return SECURE_COMM_ERR_CONFIG;
+    }
+    if (config->reactor_threads == 0 || config->max_in_flight == 0 || slab_size == 0 || log_queue_capacity < 2) {
+        fprintf(stderr, "load_configuration: 'reactor_threads', 'max_in_flight' and 'buffer_pool_slab_size' "
+                "must be positive and 'log_queue_capacity' at least 2\n");
+        cJSON_Delete(json);
+        free(buffer);
+        return SECURE_COMM_ERR_CONFIG;
+    }
+    config->buffer_pool_slab_size = (size_t)slab_size;
+    config->buffer_pool_thread_cache = (size_t)thread_cache;
+    config->log_queue_capacity = (size_t)log_queue_capacity;
+    config->reactor_max_output = (size_t)reactor_max_output;
+
+    // compression_codec / compression_level (optional): strong setting of the adaptive compressor
+    config->compression_codec = COMPRESSION_CODEC_ZLIB;
+    config->compression_level = -1;
+    cJSON* compression_codec = cJSON_GetObjectItemCaseSensitive(json, "compression_codec");
+    if (compression_codec != NULL) {
+        const CompressionCodec* codec = cJSON_IsString(compression_codec) && compression_codec->valuestring != NULL
+            ? codec_find_by_name(compression_codec->valuestring) : NULL;
+        if (codec == NULL || codec->id == COMPRESSION_CODEC_NONE) {
+            fprintf(stderr, "load_configuration: 'compression_codec' must name a compiled-in codec\n");
+            cJSON_Delete(json);
+            free(buffer);
+            return SECURE_COMM_ERR_CONFIG;
+        }
+        config->compression_codec = codec->id;
+    }
+    cJSON* compression_level = cJSON_GetObjectItemCaseSensitive(json, "compression_level");
+    if (compression_level != NULL) {
+        const CompressionCodec* codec = codec_find(config->compression_codec);
+        if (!cJSON_IsNumber(compression_level) || codec == NULL ||
+            compression_level->valueint < codec->min_level || compression_level->valueint > codec->max_level) {
+            fprintf(stderr, "load_configuration: 'compression_level' is out of range for the codec\n");
+            cJSON_Delete(json);
+            free(buffer);
+            return SECURE_COMM_ERR_CONFIG;
+        }
+        config->compression_level = compression_level->valueint;
+    }
+
     // Add additional configuration fields here with similar defensive checks
 
     // Cleanup
@@ -269,3 +801,236 @@ SecureCommError load_configuration(const char* config_path, Configuration* confi
 
     return SECURE_COMM_SUCCESS;
 }
+
+/**
+ * @brief Reports whether going from one configuration to another needs a restart.
+ *
+ * @return 1 if a field that is only read at startup differs, 0 otherwise.
+ */
+int config_restart_required(const Configuration* previous, const Configuration* current) {
+    if (previous == NULL || current == NULL) {
+        return previous != current;
+    }
+    return strcmp(previous->server_address, current->server_address) != 0 ||
+           previous->server_port != current->server_port ||
+           strcmp(previous->log_file_path, current->log_file_path) != 0 ||
+           previous->log_async != current->log_async ||
+           previous->log_full_policy != current->log_full_policy ||
+           previous->log_binary != current->log_binary ||
+           previous->log_queue_capacity != current->log_queue_capacity ||
+           previous->worker_threads != current->worker_threads ||
+           previous->worker_pin_cpus != current->worker_pin_cpus ||
+           previous->tls_ktls != current->tls_ktls ||
+           previous->reactor_threads != current->reactor_threads ||
+           previous->listen_backlog != current->listen_backlog ||
+           previous->reactor_max_output != current->reactor_max_output ||
+           previous->buffer_pool_slab_size != current->buffer_pool_slab_size ||
+           previous->buffer_pool_thread_cache != current->buffer_pool_thread_cache;
+}
+
+// A published configuration; replaced snapshots stay on a list until config_cleanup
+typedef struct config_snapshot {
+    Configuration config;
+    struct config_snapshot* retired_next;
+} config_snapshot_t;
+
+static _Atomic(config_snapshot_t*) config_snapshot = NULL;
+static atomic_uint_fast64_t config_generation_count = 0;
+static pthread_mutex_t config_lock = PTHREAD_MUTEX_INITIALIZER;  // Serializes publishers, never taken by readers
+static config_snapshot_t* config_retired = NULL;
+
+// SIGHUP watch: the handler writes a byte to the pipe, the thread reloads
+static int config_pipe[2] = { -1, -1 };
+static pthread_t config_watcher;
+static int config_watching = 0;
+static struct sigaction config_previous_sighup;
+static char config_watch_path[512];
+static config_reload_fn config_watch_callback = NULL;
+static void* config_watch_user_data = NULL;
+
+/**
+ * @brief Publishes a configuration for config_current.
+ *
+ * @param config The configuration to publish.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or SECURE_COMM_ERR_MEMORY on failure.
+ */
+SecureCommError config_publish(const Configuration* config) {
+    if (config == NULL) {
+        fprintf(stderr, "config_publish: Invalid arguments\n");
+        return SECURE_COMM_ERR_CONFIG;
+    }
+    config_snapshot_t* snapshot = (config_snapshot_t*)malloc(sizeof(config_snapshot_t));
+    if (snapshot == NULL) {
+        fprintf(stderr, "config_publish: Memory allocation failed\n");
+        return SECURE_COMM_ERR_MEMORY;
+    }
+    snapshot->config = *config;
+    snapshot->retired_next = NULL;
+
+    pthread_mutex_lock(&config_lock);
+    config_snapshot_t* previous = atomic_exchange_explicit(&config_snapshot, snapshot, memory_order_acq_rel);
+    atomic_fetch_add_explicit(&config_generation_count, 1, memory_order_release);
+    if (previous) {
+        previous->retired_next = config_retired;
+        config_retired = previous;
+    }
+    pthread_mutex_unlock(&config_lock);
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Returns the configuration published last, or NULL if none has been.
+ */
+const Configuration* config_current(void) {
+    config_snapshot_t* snapshot = atomic_load_explicit(&config_snapshot, memory_order_acquire);
+    return snapshot ? &snapshot->config : NULL;
+}
+
+/**
+ * @brief Counts published configurations.
+ */
+uint64_t config_generation(void) {
+    return atomic_load_explicit(&config_generation_count, memory_order_acquire);
+}
+
+/**
+ * @brief Loads a configuration file and publishes it, keeping the current one if it is invalid.
+ *
+ * @param config_path The file path to the JSON configuration file.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or the error of load_configuration.
+ */
+SecureCommError config_reload(const char* config_path) {
+    Configuration config;
+    memset(&config, 0, sizeof(config));
+    SecureCommError ret = load_configuration(config_path, &config);
+    if (ret != SECURE_COMM_SUCCESS) {
+        return ret;
+    }
+    return config_publish(&config);
+}
+
+/**
+ * @brief SIGHUP handler: only wakes the reload thread (write is async-signal-safe).
+ */
+static void config_sighup_handler(int signo) {
+    (void)signo;
+    int saved_errno = errno;
+    char wake = 'h';
+    ssize_t ignored = write(config_pipe[1], &wake, 1);
+    (void)ignored;
+    errno = saved_errno;
+}
+
+/**
+ * @brief Reload thread: reloads once per SIGHUP until config_unwatch_sighup writes 'q'.
+ */
+static void* config_watch_main(void* arg) {
+    (void)arg;
+    while (1) {
+        char wake;
+        ssize_t n = read(config_pipe[0], &wake, 1);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0 || wake == 'q') {
+            break;
+        }
+
+        const Configuration* previous = config_current();
+        SecureCommError ret = config_reload(config_watch_path);
+        if (ret != SECURE_COMM_SUCCESS) {
+            LOG_ERROR("Reloading %s failed (error %d); keeping configuration %llu",
+                      config_watch_path, ret, (unsigned long long)config_generation());
+            continue;
+        }
+        LOG_INFO("Reloaded %s as configuration %llu", config_watch_path, (unsigned long long)config_generation());
+        if (config_watch_callback) {
+            config_watch_callback(previous, config_current(), config_watch_user_data);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Reloads the configuration file whenever the process receives SIGHUP.
+ *
+ * @param config_path The file path to reload.
+ * @param on_reload Optional function applying the settings that take effect at run time.
+ * @param user_data Passed to on_reload.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or SECURE_COMM_ERR_INIT on failure.
+ */
+SecureCommError config_watch_sighup(const char* config_path, config_reload_fn on_reload, void* user_data) {
+    if (config_path == NULL || strlen(config_path) >= sizeof(config_watch_path)) {
+        fprintf(stderr, "config_watch_sighup: Invalid arguments\n");
+        return SECURE_COMM_ERR_INIT;
+    }
+    if (config_watching) {
+        fprintf(stderr, "config_watch_sighup: A watch is already running\n");
+        return SECURE_COMM_ERR_INIT;
+    }
+    if (pipe(config_pipe) != 0) {
+        fprintf(stderr, "config_watch_sighup: pipe failed: %s\n", strerror(errno));
+        return SECURE_COMM_ERR_INIT;
+    }
+    fcntl(config_pipe[0], F_SETFD, FD_CLOEXEC);
+    fcntl(config_pipe[1], F_SETFD, FD_CLOEXEC);
+    // A burst of signals must never block the handler
+    fcntl(config_pipe[1], F_SETFL, fcntl(config_pipe[1], F_GETFL, 0) | O_NONBLOCK);
+
+    strcpy(config_watch_path, config_path);
+    config_watch_callback = on_reload;
+    config_watch_user_data = user_data;
+    if (pthread_create(&config_watcher, NULL, config_watch_main, NULL) != 0) {
+        fprintf(stderr, "config_watch_sighup: Cannot start the reload thread\n");
+        close(config_pipe[0]);
+        close(config_pipe[1]);
+        config_pipe[0] = config_pipe[1] = -1;
+        return SECURE_COMM_ERR_INIT;
+    }
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = config_sighup_handler;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGHUP, &action, &config_previous_sighup);
+    config_watching = 1;
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Stops the SIGHUP watch and restores the previous SIGHUP handler.
+ */
+void config_unwatch_sighup(void) {
+    if (!config_watching) {
+        return;
+    }
+    sigaction(SIGHUP, &config_previous_sighup, NULL);
+    char stop = 'q';
+    while (write(config_pipe[1], &stop, 1) < 0 && (errno == EINTR || errno == EAGAIN)) {
+    }
+    pthread_join(config_watcher, NULL);
+    close(config_pipe[0]);
+    close(config_pipe[1]);
+    config_pipe[0] = config_pipe[1] = -1;
+    config_watching = 0;
+}
+
+/**
+ * @brief Stops the SIGHUP watch and frees every published snapshot.
+ */
+void config_cleanup(void) {
+    config_unwatch_sighup();
+    pthread_mutex_lock(&config_lock);
+    config_snapshot_t* snapshot = atomic_exchange(&config_snapshot, NULL);
+    free(snapshot);
+    while (config_retired) {
+        config_snapshot_t* next = config_retired->retired_next;
+        free(config_retired);
+        config_retired = next;
+    }
+    pthread_mutex_unlock(&config_lock);
+}
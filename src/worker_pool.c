@@ -0,0 +1,688 @@
+// worker_pool.c
+
+#define _GNU_SOURCE     // For pthread_setaffinity_np
+
+#include "secure_comm.h"
+
+#include <stdio.h>      // For fprintf
+#include <stdlib.h>     // For malloc, calloc, free
+#include <string.h>     // For memset, memcpy
+#include <pthread.h>    // For the worker threads
+#include <sched.h>      // For cpu_set_t
+#include <stdatomic.h>  // For the pending count and counters
+#include <unistd.h>     // For sysconf
+
+typedef struct {
+    worker_task_fn fn;
+    void* arg;
+} worker_task_t;
+
+/**
+ * @brief One worker's queue: a growable ring. The owner takes from the head
+ *        (oldest first), thieves from the tail (newest first).
+ */
+typedef struct {
+    _Alignas(64) pthread_mutex_t lock;
+    worker_task_t* tasks;
+    size_t capacity;
+    size_t head;                // Index of the oldest task
+    _Atomic size_t count;       // Written under the lock, peeked without it
+} worker_queue_t;
+
+typedef struct {
+    WorkerPool* pool;
+    int index;
+    pthread_t thread;
+    int started;
+    _Atomic uint64_t executed;
+    _Atomic uint64_t stolen;
+} worker_t;
+
+// Definition of the opaque WorkerPool structure
+struct WorkerPool {
+    size_t threads;
+    worker_queue_t* queues;     // One per worker
+    worker_t* workers;
+
+    pthread_mutex_t lock;       // Guards sleeping and stopping
+    pthread_cond_t wake;
+    int sleepers;
+    int stopping;
+
+    _Atomic uint64_t pending;   // Tasks queued and not yet taken
+    _Atomic size_t next_queue;  // Round-robin target for submissions from other threads
+    _Atomic uint64_t helped;
+};
+
+// Definition of the opaque WorkerSequence structure
+typedef struct {
+    WorkerSequence* sequence;
+    worker_task_fn work;
+    void* arg;
+    int done;
+} sequence_slot_t;
+
+struct WorkerSequence {
+    WorkerPool* pool;
+    worker_complete_fn complete;
+    void* user_data;
+
+    pthread_mutex_t lock;
+    pthread_cond_t changed;     // Signalled as tasks complete
+    sequence_slot_t* slots;     // Ring of max_in_flight slots
+    size_t capacity;
+    uint64_t head;              // Next task to complete
+    uint64_t tail;              // Next task to submit
+    int completing;             // A thread is running complete callbacks
+};
+
+// Which pool, if any, the calling thread works for
+static _Thread_local worker_t* current_worker = NULL;
+
+static WorkerPool* default_pool = NULL;
+static pthread_once_t default_pool_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t default_config_lock = PTHREAD_MUTEX_INITIALIZER;
+static WorkerPoolConfig default_config;
+static int default_config_set = 0;
+static int default_pool_started = 0;
+
+/**
+ * @brief Fills a WorkerPoolConfig with the defaults.
+ *
+ * @param config The configuration to fill.
+ */
+void worker_pool_config_defaults(WorkerPoolConfig* config) {
+    if (config == NULL) {
+        return;
+    }
+    memset(config, 0, sizeof(WorkerPoolConfig));
+    config->threads = 0;
+    config->pin_threads = 0;
+    config->queue_capacity = 256;
+}
+
+/**
+ * @brief Appends a task to a queue, doubling it when full.
+ */
+static SecureCommError queue_push(worker_queue_t* queue, worker_task_fn fn, void* arg) {
+    pthread_mutex_lock(&queue->lock);
+    if (queue->count == queue->capacity) {
+        size_t capacity = queue->capacity * 2;
+        worker_task_t* tasks = (worker_task_t*)malloc(capacity * sizeof(worker_task_t));
+        if (tasks == NULL) {
+            pthread_mutex_unlock(&queue->lock);
+            return SECURE_COMM_ERR_MEMORY;
+        }
+        for (size_t i = 0; i < queue->count; i++) {
+            tasks[i] = queue->tasks[(queue->head + i) % queue->capacity];
+        }
+        free(queue->tasks);
+        queue->tasks = tasks;
+        queue->capacity = capacity;
+        queue->head = 0;
+    }
+    worker_task_t* task = &queue->tasks[(queue->head + queue->count) % queue->capacity];
+    task->fn = fn;
+    task->arg = arg;
+    queue->count++;
+    pthread_mutex_unlock(&queue->lock);
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Takes the oldest (owner) or newest (thief) task of a queue.
+ */
+static int queue_take(worker_queue_t* queue, int newest, worker_task_t* task) {
+    // Unlocked peek: an empty queue is the common case for thieves
+    if (atomic_load_explicit(&queue->count, memory_order_relaxed) == 0) {
+        return 0;
+    }
+    pthread_mutex_lock(&queue->lock);
+    if (queue->count == 0) {
+        pthread_mutex_unlock(&queue->lock);
+        return 0;
+    }
+    if (newest) {
+        *task = queue->tasks[(queue->head + queue->count - 1) % queue->capacity];
+    } else {
+        *task = queue->tasks[queue->head];
+        queue->head = (queue->head + 1) % queue->capacity;
+    }
+    queue->count--;
+    pthread_mutex_unlock(&queue->lock);
+    return 1;
+}
+
+/**
+ * @brief Takes a task from queue `home` first, then from the others.
+ *
+ * @return 1 with the task in *task, or 0 if every queue was empty.
+ */
+static int pool_take(WorkerPool* pool, size_t home, worker_task_t* task, int* stolen) {
+    if (queue_take(&pool->queues[home], 0, task)) {
+        *stolen = 0;
+    } else {
+        size_t i = 1;
+        for (; i < pool->threads; i++) {
+            if (queue_take(&pool->queues[(home + i) % pool->threads], 1, task)) {
+                break;
+            }
+        }
+        if (i == pool->threads) {
+            return 0;
+        }
+        *stolen = 1;
+    }
+    atomic_fetch_sub_explicit(&pool->pending, 1, memory_order_relaxed);
+    return 1;
+}
+
+static void* worker_main(void* arg) {
+    worker_t* worker = (worker_t*)arg;
+    WorkerPool* pool = worker->pool;
+    current_worker = worker;
+
+    while (1) {
+        worker_task_t task;
+        int stolen = 0;
+        if (pool_take(pool, (size_t)worker->index, &task, &stolen)) {
+            task.fn(task.arg);
+            atomic_fetch_add_explicit(&worker->executed, 1, memory_order_relaxed);
+            if (stolen) {
+                atomic_fetch_add_explicit(&worker->stolen, 1, memory_order_relaxed);
+            }
+            continue;
+        }
+
+        // Sleep until a task is submitted; queued tasks are still run after stopping
+        pthread_mutex_lock(&pool->lock);
+        while (atomic_load(&pool->pending) == 0 && !pool->stopping) {
+            pool->sleepers++;
+            pthread_cond_wait(&pool->wake, &pool->lock);
+            pool->sleepers--;
+        }
+        int done = pool->stopping && atomic_load(&pool->pending) == 0;
+        pthread_mutex_unlock(&pool->lock);
+        if (done) {
+            break;
+        }
+    }
+
+    current_worker = NULL;
+    return NULL;
+}
+
+/**
+ * @brief Pins a worker thread to one CPU. Failure only costs locality.
+ */
+static void pin_worker(pthread_t thread, int index) {
+#ifdef __linux__
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus < 1) {
+        return;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET((int)(index % cpus), &set);
+    if (pthread_setaffinity_np(thread, sizeof(set), &set) != 0) {
+        fprintf(stderr, "worker_pool_create: Failed to pin worker %d\n", index);
+    }
+#else
+    (void)thread;
+    (void)index;
+#endif
+}
+
+/**
+ * @brief Starts a worker pool.
+ *
+ * @param config Pool parameters, or NULL for the defaults.
+ * @param pool Pointer to store the created WorkerPool.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError worker_pool_create(const WorkerPoolConfig* config, WorkerPool** pool) {
+    if (pool == NULL) {
+        fprintf(stderr, "worker_pool_create: Invalid arguments\n");
+        return SECURE_COMM_ERR_INIT;
+    }
+
+    WorkerPoolConfig cfg;
+    if (config != NULL) {
+        cfg = *config;
+    } else {
+        worker_pool_config_defaults(&cfg);
+    }
+    if (cfg.threads == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        cfg.threads = cpus > 0 ? (size_t)cpus : 1;
+    }
+    if (cfg.queue_capacity == 0) {
+        cfg.queue_capacity = 1;
+    }
+
+    WorkerPool* p = (WorkerPool*)calloc(1, sizeof(WorkerPool));
+    if (p == NULL) {
+        fprintf(stderr, "worker_pool_create: Failed to allocate memory for pool\n");
+        return SECURE_COMM_ERR_MEMORY;
+    }
+    p->threads = cfg.threads;
+    p->queues = (worker_queue_t*)aligned_alloc(64, ((cfg.threads * sizeof(worker_queue_t) + 63) / 64) * 64);
+    p->workers = (worker_t*)calloc(cfg.threads, sizeof(worker_t));
+    if (p->queues == NULL || p->workers == NULL) {
+        fprintf(stderr, "worker_pool_create: Failed to allocate memory for %zu workers\n", cfg.threads);
+        free(p->queues);
+        free(p->workers);
+        free(p);
+        return SECURE_COMM_ERR_MEMORY;
+    }
+    memset(p->queues, 0, cfg.threads * sizeof(worker_queue_t));
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_cond_init(&p->wake, NULL);
+
+    for (size_t i = 0; i < cfg.threads; i++) {
+        pthread_mutex_init(&p->queues[i].lock, NULL);
+    }
+    for (size_t i = 0; i < cfg.threads; i++) {
+        worker_queue_t* queue = &p->queues[i];
+        queue->capacity = cfg.queue_capacity;
+        queue->tasks = (worker_task_t*)malloc(cfg.queue_capacity * sizeof(worker_task_t));
+        if (queue->tasks == NULL) {
+            fprintf(stderr, "worker_pool_create: Failed to allocate memory for a task queue\n");
+            worker_pool_destroy(p);
+            return SECURE_COMM_ERR_MEMORY;
+        }
+    }
+
+    for (size_t i = 0; i < cfg.threads; i++) {
+        worker_t* worker = &p->workers[i];
+        worker->pool = p;
+        worker->index = (int)i;
+        if (pthread_create(&worker->thread, NULL, worker_main, worker) != 0) {
+            fprintf(stderr, "worker_pool_create: Failed to start worker %zu\n", i);
+            worker_pool_destroy(p);
+            return SECURE_COMM_ERR_INIT;
+        }
+        worker->started = 1;
+        if (cfg.pin_threads) {
+            pin_worker(worker->thread, (int)i);
+        }
+    }
+
+    *pool = p;
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Sets the configuration of the library-wide pool before its first use.
+ *
+ * @param config Pool parameters.
+ *
+ * @return SECURE_COMM_SUCCESS, or SECURE_COMM_ERR_INIT if the default pool already exists.
+ */
+SecureCommError worker_pool_configure_default(const WorkerPoolConfig* config) {
+    if (config == NULL) {
+        fprintf(stderr, "worker_pool_configure_default: Invalid arguments\n");
+        return SECURE_COMM_ERR_INIT;
+    }
+    pthread_mutex_lock(&default_config_lock);
+    if (default_pool_started) {
+        pthread_mutex_unlock(&default_config_lock);
+        fprintf(stderr, "worker_pool_configure_default: The default pool is already running\n");
+        return SECURE_COMM_ERR_INIT;
+    }
+    default_config = *config;
+    default_config_set = 1;
+    pthread_mutex_unlock(&default_config_lock);
+    return SECURE_COMM_SUCCESS;
+}
+
+static void default_pool_create(void) {
+    pthread_mutex_lock(&default_config_lock);
+    default_pool_started = 1;
+    if (worker_pool_create(default_config_set ? &default_config : NULL, &default_pool) != SECURE_COMM_SUCCESS) {
+        default_pool = NULL;
+    }
+    pthread_mutex_unlock(&default_config_lock);
+}
+
+/**
+ * @brief Returns the library-wide pool, creating it on first use.
+ */
+WorkerPool* worker_pool_default(void) {
+    pthread_once(&default_pool_once, default_pool_create);
+    return default_pool;
+}
+
+/**
+ * @brief Queues a task.
+ *
+ * @param pool The pool, or NULL for worker_pool_default().
+ * @param task Function to run on a worker thread.
+ * @param arg Argument passed to task.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError worker_pool_submit(WorkerPool* pool, worker_task_fn task, void* arg) {
+    if (pool == NULL) {
+        pool = worker_pool_default();
+    }
+    if (pool == NULL || task == NULL) {
+        fprintf(stderr, "worker_pool_submit: Invalid arguments\n");
+        return SECURE_COMM_ERR_INIT;
+    }
+
+    // A worker keeps its own follow-up tasks; other threads spread theirs
+    size_t target = current_worker != NULL && current_worker->pool == pool
+        ? (size_t)current_worker->index
+        : atomic_fetch_add_explicit(&pool->next_queue, 1, memory_order_relaxed) % pool->threads;
+
+    // Counted before it is visible, so a worker taking it never sees the count go negative
+    atomic_fetch_add(&pool->pending, 1);
+    SecureCommError ret = queue_push(&pool->queues[target], task, arg);
+    if (ret != SECURE_COMM_SUCCESS) {
+        atomic_fetch_sub(&pool->pending, 1);
+        fprintf(stderr, "worker_pool_submit: Failed to grow the task queue\n");
+        return ret;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    if (pool->sleepers > 0) {
+        pthread_cond_signal(&pool->wake);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return SECURE_COMM_SUCCESS;
+}
+
+// Shared state of one worker_pool_parallel_for call
+typedef struct {
+    worker_index_fn fn;
+    void* ctx;
+    _Atomic size_t remaining;
+    pthread_mutex_t lock;
+    pthread_cond_t done;
+} parallel_for_t;
+
+typedef struct {
+    parallel_for_t* job;
+    size_t index;
+} parallel_for_item_t;
+
+static void parallel_for_finish(parallel_for_t* job) {
+    if (atomic_fetch_sub(&job->remaining, 1) == 1) {
+        pthread_mutex_lock(&job->lock);
+        pthread_cond_broadcast(&job->done);
+        pthread_mutex_unlock(&job->lock);
+    }
+}
+
+static void parallel_for_task(void* arg) {
+    parallel_for_item_t* item = (parallel_for_item_t*)arg;
+    item->job->fn(item->job->ctx, item->index);
+    parallel_for_finish(item->job);
+}
+
+/**
+ * @brief Runs fn(ctx, i) for every i below count and waits for all of them.
+ *
+ * @param pool The pool, or NULL for worker_pool_default().
+ * @param count Number of indices.
+ * @param fn Function to run for each index.
+ * @param ctx Argument passed to fn.
+ */
+void worker_pool_parallel_for(WorkerPool* pool, size_t count, worker_index_fn fn, void* ctx) {
+    if (count == 0 || fn == NULL) {
+        return;
+    }
+    if (pool == NULL) {
+        pool = worker_pool_default();
+    }
+
+    // Without a pool, or with one index, there is nothing to share
+    parallel_for_item_t* items = NULL;
+    if (pool == NULL || count == 1 ||
+        (items = (parallel_for_item_t*)malloc((count - 1) * sizeof(parallel_for_item_t))) == NULL) {
+        for (size_t i = 0; i < count; i++) {
+            fn(ctx, i);
+        }
+        return;
+    }
+
+    parallel_for_t job;
+    job.fn = fn;
+    job.ctx = ctx;
+    atomic_init(&job.remaining, count - 1);
+    pthread_mutex_init(&job.lock, NULL);
+    pthread_cond_init(&job.done, NULL);
+
+    for (size_t i = 1; i < count; i++) {
+        items[i - 1].job = &job;
+        items[i - 1].index = i;
+        if (worker_pool_submit(pool, parallel_for_task, &items[i - 1]) != SECURE_COMM_SUCCESS) {
+            parallel_for_task(&items[i - 1]);
+        }
+    }
+    fn(ctx, 0);
+
+    // Help with queued tasks (ours or anyone's) instead of blocking a core
+    size_t home = current_worker != NULL && current_worker->pool == pool ? (size_t)current_worker->index : 0;
+    while (atomic_load(&job.remaining) > 0) {
+        worker_task_t task;
+        int stolen = 0;
+        if (!pool_take(pool, home, &task, &stolen)) {
+            break;
+        }
+        task.fn(task.arg);
+        atomic_fetch_add_explicit(&pool->helped, 1, memory_order_relaxed);
+    }
+
+    pthread_mutex_lock(&job.lock);
+    while (atomic_load(&job.remaining) > 0) {
+        pthread_cond_wait(&job.done, &job.lock);
+    }
+    pthread_mutex_unlock(&job.lock);
+
+    pthread_cond_destroy(&job.done);
+    pthread_mutex_destroy(&job.lock);
+    free(items);
+}
+
+/**
+ * @brief Returns the index of the calling worker thread in pool, or -1 for other threads.
+ */
+int worker_pool_current_worker(const WorkerPool* pool) {
+    return current_worker != NULL && current_worker->pool == pool ? current_worker->index : -1;
+}
+
+/**
+ * @brief Returns the number of worker threads.
+ */
+size_t worker_pool_threads(const WorkerPool* pool) {
+    return pool != NULL ? pool->threads : 0;
+}
+
+/**
+ * @brief Copies a pool's counters.
+ */
+void worker_pool_stats(WorkerPool* pool, WorkerPoolStats* stats) {
+    if (pool == NULL || stats == NULL) {
+        return;
+    }
+    memset(stats, 0, sizeof(WorkerPoolStats));
+    stats->threads = pool->threads;
+    for (size_t i = 0; i < pool->threads; i++) {
+        stats->executed += atomic_load_explicit(&pool->workers[i].executed, memory_order_relaxed);
+        stats->stolen += atomic_load_explicit(&pool->workers[i].stolen, memory_order_relaxed);
+    }
+    stats->helped = atomic_load_explicit(&pool->helped, memory_order_relaxed);
+    stats->pending = atomic_load_explicit(&pool->pending, memory_order_relaxed);
+}
+
+/**
+ * @brief Runs the tasks still queued, stops the threads and frees the pool.
+ */
+void worker_pool_destroy(WorkerPool* pool) {
+    if (pool == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stopping = 1;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (size_t i = 0; i < pool->threads; i++) {
+        if (pool->workers[i].started) {
+            pthread_join(pool->workers[i].thread, NULL);
+        }
+    }
+    for (size_t i = 0; i < pool->threads; i++) {
+        free(pool->queues[i].tasks);
+        pthread_mutex_destroy(&pool->queues[i].lock);
+    }
+
+    pthread_cond_destroy(&pool->wake);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->queues);
+    free(pool->workers);
+    free(pool);
+}
+
+/**
+ * @brief Creates a sequence of tasks whose results complete in submission order.
+ *
+ * @param pool The pool, or NULL for worker_pool_default().
+ * @param max_in_flight Tasks that may be submitted but not completed; further submits wait.
+ * @param complete Called in order with each task's argument.
+ * @param user_data Passed to complete.
+ * @param sequence Pointer to store the created WorkerSequence.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError worker_sequence_create(WorkerPool* pool, size_t max_in_flight, worker_complete_fn complete,
+                                       void* user_data, WorkerSequence** sequence) {
+    if (pool == NULL) {
+        pool = worker_pool_default();
+    }
+    if (pool == NULL || max_in_flight == 0 || complete == NULL || sequence == NULL) {
+        fprintf(stderr, "worker_sequence_create: Invalid arguments\n");
+        return SECURE_COMM_ERR_INIT;
+    }
+
+    WorkerSequence* seq = (WorkerSequence*)calloc(1, sizeof(WorkerSequence));
+    if (seq == NULL || (seq->slots = (sequence_slot_t*)calloc(max_in_flight, sizeof(sequence_slot_t))) == NULL) {
+        fprintf(stderr, "worker_sequence_create: Failed to allocate memory for sequence\n");
+        free(seq);
+        return SECURE_COMM_ERR_MEMORY;
+    }
+    seq->pool = pool;
+    seq->complete = complete;
+    seq->user_data = user_data;
+    seq->capacity = max_in_flight;
+    pthread_mutex_init(&seq->lock, NULL);
+    pthread_cond_init(&seq->changed, NULL);
+
+    *sequence = seq;
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Marks a slot done and, unless another thread already does, completes
+ *        every finished task at the head of the sequence.
+ */
+static void sequence_finish(sequence_slot_t* slot) {
+    WorkerSequence* seq = slot->sequence;
+
+    pthread_mutex_lock(&seq->lock);
+    slot->done = 1;
+    if (seq->completing) {
+        pthread_mutex_unlock(&seq->lock);
+        return;
+    }
+    seq->completing = 1;
+    while (seq->head != seq->tail && seq->slots[seq->head % seq->capacity].done) {
+        sequence_slot_t* head = &seq->slots[seq->head % seq->capacity];
+        void* arg = head->arg;
+        head->done = 0;
+        seq->head++;
+
+        // The slot may be reused once head has moved past it
+        pthread_cond_broadcast(&seq->changed);
+        pthread_mutex_unlock(&seq->lock);
+        seq->complete(arg, seq->user_data);
+        pthread_mutex_lock(&seq->lock);
+    }
+    seq->completing = 0;
+    pthread_cond_broadcast(&seq->changed);
+    pthread_mutex_unlock(&seq->lock);
+}
+
+static void sequence_task(void* arg) {
+    sequence_slot_t* slot = (sequence_slot_t*)arg;
+    if (slot->work != NULL) {
+        slot->work(slot->arg);
+    }
+    sequence_finish(slot);
+}
+
+/**
+ * @brief Queues a task on the sequence's pool.
+ *
+ * @param sequence The sequence.
+ * @param work Function run on a worker thread; NULL skips straight to completion.
+ * @param arg Argument passed to work and then to complete.
+ *
+ * @return SECURE_COMM_SUCCESS on success, or a negative error code on failure.
+ */
+SecureCommError worker_sequence_submit(WorkerSequence* sequence, worker_task_fn work, void* arg) {
+    if (sequence == NULL) {
+        fprintf(stderr, "worker_sequence_submit: Invalid arguments\n");
+        return SECURE_COMM_ERR_INIT;
+    }
+
+    pthread_mutex_lock(&sequence->lock);
+    while (sequence->tail - sequence->head == sequence->capacity) {
+        pthread_cond_wait(&sequence->changed, &sequence->lock);
+    }
+    sequence_slot_t* slot = &sequence->slots[sequence->tail % sequence->capacity];
+    slot->sequence = sequence;
+    slot->work = work;
+    slot->arg = arg;
+    slot->done = 0;
+    sequence->tail++;
+    pthread_mutex_unlock(&sequence->lock);
+
+    // Run it here rather than lose it if the queue cannot grow
+    if (worker_pool_submit(sequence->pool, sequence_task, slot) != SECURE_COMM_SUCCESS) {
+        sequence_task(slot);
+    }
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Waits until every submitted task has completed.
+ */
+void worker_sequence_drain(WorkerSequence* sequence) {
+    if (sequence == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&sequence->lock);
+    while (sequence->head != sequence->tail || sequence->completing) {
+        pthread_cond_wait(&sequence->changed, &sequence->lock);
+    }
+    pthread_mutex_unlock(&sequence->lock);
+}
+
+/**
+ * @brief Drains and frees a sequence.
+ */
+void worker_sequence_destroy(WorkerSequence* sequence) {
+    if (sequence == NULL) {
+        return;
+    }
+    worker_sequence_drain(sequence);
+    pthread_cond_destroy(&sequence->changed);
+    pthread_mutex_destroy(&sequence->lock);
+    free(sequence->slots);
+    free(sequence);
+}
@@ -3,6 +3,30 @@
 #include "secure_comm.h"
 
 #include <stdio.h>      // For printf, fprintf
+#include <time.h>       // For clock_gettime, nanosleep
+#include <pthread.h>    // For sessions racing pool swaps
+#include <stdatomic.h>  // For the failure counter
+
+#define RACE_THREADS 4
+#define RACE_SESSIONS 50
+
+static atomic_int race_failures;
+
+/**
+ * @brief Creates sessions while the main thread attaches and destroys pools.
+ */
+static void* create_sessions(void* arg) {
+    (void)arg;
+    for (int i = 0; i < RACE_SESSIONS; i++) {
+        UserSession* session = NULL;
+        if (initialize_session("user", "pass", &session) != SECURE_COMM_SUCCESS) {
+            atomic_fetch_add(&race_failures, 1);
+            continue;
+        }
+        terminate_session(session);
+    }
+    return NULL;
+}
 
 int main() {
     // Initialize a user session with valid credentials
@@ -35,5 +59,126 @@ int main() {
     // Terminate the valid session
     terminate_session(session);
 
+    // Every built-in key exchange produces keypairs without a per-call prime search
+    const SessionKeyExchange kexes[] = { SESSION_KEX_FFDHE2048, SESSION_KEX_FFDHE3072, SESSION_KEX_X25519 };
+    const char* kex_names[] = { "ffdhe2048", "ffdhe3072", "x25519" };
+    for (int k = 0; k < 3; k++) {
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int i = 0; i < 10; i++) {
+            EVP_PKEY* keypair = NULL;
+            if (generate_session_keypair(kexes[k], &keypair) != SECURE_COMM_SUCCESS) {
+                fprintf(stderr, "test_session: %s keypair generation failed.\n", kex_names[k]);
+                return 1;
+            }
+            EVP_PKEY_free(keypair);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double ms = (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6;
+        printf("test_session: %s keypair in %.3f ms on average.\n", kex_names[k], ms / 10);
+    }
+
+    // Sessions can be established over X25519
+    if (session_set_key_exchange(SESSION_KEX_X25519) != SECURE_COMM_SUCCESS ||
+        initialize_session(username, password, &session) != SECURE_COMM_SUCCESS ||
+        session->session_key_len != 32) {
+        fprintf(stderr, "test_session: X25519 session failed.\n");
+        return 1;
+    }
+    terminate_session(session);
+
+    // A keypair pool serves initialize_session from pre-generated keys
+    KeypairPoolConfig pool_cfg;
+    keypair_pool_config_defaults(&pool_cfg);
+    pool_cfg.kex = SESSION_KEX_X25519;
+    pool_cfg.low_watermark = 2;
+    pool_cfg.high_watermark = 8;
+    KeypairPool* pool = NULL;
+    if (keypair_pool_create(&pool_cfg, &pool) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "test_session: Failed to create keypair pool.\n");
+        return 1;
+    }
+
+    KeypairPoolStats pool_stats;
+    for (int i = 0; i < 500; i++) {
+        keypair_pool_stats(pool, &pool_stats);
+        if (pool_stats.available == pool_cfg.high_watermark) {
+            break;
+        }
+        struct timespec pause = { 0, 1000000 };
+        nanosleep(&pause, NULL);
+    }
+    if (pool_stats.available != pool_cfg.high_watermark) {
+        fprintf(stderr, "test_session: Keypair pool did not fill (%zu ready).\n", pool_stats.available);
+        keypair_pool_destroy(pool);
+        return 1;
+    }
+
+    session_set_keypair_pool(pool);
+    for (int i = 0; i < 20; i++) {
+        if (initialize_session(username, password, &session) != SECURE_COMM_SUCCESS) {
+            fprintf(stderr, "test_session: Pooled session %d failed.\n", i);
+            session_set_keypair_pool(NULL);
+            keypair_pool_destroy(pool);
+            return 1;
+        }
+        terminate_session(session);
+    }
+    session_set_keypair_pool(NULL);
+
+    keypair_pool_stats(pool, &pool_stats);
+    printf("test_session: Keypair pool hits %llu, empty hits %llu, generated %llu, refills %llu.\n",
+           (unsigned long long)pool_stats.hits, (unsigned long long)pool_stats.empty_hits,
+           (unsigned long long)pool_stats.generated, (unsigned long long)pool_stats.refills);
+    if (pool_stats.hits + pool_stats.empty_hits != 20 || pool_stats.hits < pool_cfg.high_watermark) {
+        fprintf(stderr, "test_session: Pool was not used by initialize_session.\n");
+        keypair_pool_destroy(pool);
+        return 1;
+    }
+    keypair_pool_destroy(pool);
+
+    // Pools may be swapped and destroyed while other threads create sessions
+    pthread_t racers[RACE_THREADS];
+    for (int i = 0; i < RACE_THREADS; i++) {
+        pthread_create(&racers[i], NULL, create_sessions, NULL);
+    }
+    for (int round = 0; round < 10; round++) {
+        if (keypair_pool_create(&pool_cfg, &pool) != SECURE_COMM_SUCCESS) {
+            fprintf(stderr, "test_session: Failed to create keypair pool.\n");
+            return 1;
+        }
+        session_set_keypair_pool(pool);
+        session_set_key_exchange(round % 2 ? SESSION_KEX_FFDHE2048 : SESSION_KEX_X25519);
+        struct timespec pause = { 0, 2000000 };
+        nanosleep(&pause, NULL);
+        session_set_keypair_pool(NULL);
+        keypair_pool_destroy(pool);
+    }
+    for (int i = 0; i < RACE_THREADS; i++) {
+        pthread_join(racers[i], NULL);
+    }
+    session_set_key_exchange(SESSION_KEX_X25519);
+    if (atomic_load(&race_failures) != 0) {
+        fprintf(stderr, "test_session: %d sessions failed while pools were swapped.\n", atomic_load(&race_failures));
+        return 1;
+    }
+
+    // Inconsistent watermarks are rejected
+    pool_cfg.low_watermark = pool_cfg.high_watermark;
+    if (keypair_pool_create(&pool_cfg, &pool) == SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "test_session: Invalid pool configuration was accepted.\n");
+        keypair_pool_destroy(pool);
+        return 1;
+    }
+
+    // Custom parameters must be loaded before they can be used
+    EVP_PKEY* keypair = NULL;
+    if (generate_session_keypair(SESSION_KEX_DH_CUSTOM, &keypair) == SECURE_COMM_SUCCESS ||
+        session_load_dh_params("/nonexistent/dhparams.pem") == SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "test_session: Custom DH parameters were used before loading.\n");
+        EVP_PKEY_free(keypair);
+        return 1;
+    }
+
     return 0;
 }
@@ -0,0 +1,112 @@
+// test_adaptive.c
+
+#include "secure_comm.h"
+
+#include <stdio.h>      // For printf
+#include <string.h>     // For memcmp, memset
+
+#define PAYLOAD_SIZE 8192
+
+int main() {
+    unsigned char text[PAYLOAD_SIZE];
+    unsigned char noise[PAYLOAD_SIZE];
+    unsigned char output[2 * PAYLOAD_SIZE];
+    unsigned char restored[PAYLOAD_SIZE];
+
+    // Repetitive text compresses well; pseudo-random bytes look like ciphertext
+    uint32_t state = 2463534242u;
+    for (size_t i = 0; i < PAYLOAD_SIZE; i++) {
+        text[i] = (unsigned char)("status=ok;load=0.42;"[i % 20]);
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        noise[i] = (unsigned char)state;
+    }
+
+    printf("Entropy: text %.2f, noise %.2f bits/byte\n",
+           estimate_entropy(text, sizeof(text)), estimate_entropy(noise, sizeof(noise)));
+
+    AdaptiveCompressor* ac = NULL;
+    if (adaptive_compressor_create(NULL, &ac) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "adaptive_compressor_create failed\n");
+        return 1;
+    }
+
+    // -----------------------------
+    // Decisions per payload
+    // -----------------------------
+    printf("---- Testing adaptive_choose ----\n");
+
+    if (adaptive_choose(ac, text, 16) != COMPRESSION_DECISION_STORE ||
+        adaptive_choose(ac, noise, sizeof(noise)) != COMPRESSION_DECISION_STORE ||
+        adaptive_choose(ac, text, sizeof(text)) != COMPRESSION_DECISION_STRONG) {
+        fprintf(stderr, "adaptive_choose made an unexpected decision\n");
+        adaptive_compressor_destroy(ac);
+        return 1;
+    }
+
+    // -----------------------------
+    // Compressible payloads shrink and round-trip
+    // -----------------------------
+    printf("---- Testing adaptive_compress ----\n");
+
+    size_t output_len = sizeof(output);
+    CompressionCodecId codec = COMPRESSION_CODEC_NONE;
+    size_t restored_len = sizeof(restored);
+    if (adaptive_compress(ac, text, sizeof(text), output, &output_len, &codec) != SECURE_COMM_SUCCESS ||
+        codec == COMPRESSION_CODEC_NONE || output_len >= sizeof(text) ||
+        codec_decompress(codec, output, output_len, restored, &restored_len) != SECURE_COMM_SUCCESS ||
+        restored_len != sizeof(text) || memcmp(restored, text, sizeof(text)) != 0) {
+        fprintf(stderr, "Compressible payload did not round-trip\n");
+        adaptive_compressor_destroy(ac);
+        return 1;
+    }
+
+    // High-entropy payloads are passed through untouched
+    output_len = sizeof(output);
+    if (adaptive_compress(ac, noise, sizeof(noise), output, &output_len, &codec) != SECURE_COMM_SUCCESS ||
+        codec != COMPRESSION_CODEC_NONE || output_len != 0) {
+        fprintf(stderr, "High-entropy payload was compressed\n");
+        adaptive_compressor_destroy(ac);
+        return 1;
+    }
+    adaptive_compressor_destroy(ac);
+
+    // -----------------------------
+    // Learning: payloads that never shrink trigger back-off
+    // -----------------------------
+    printf("---- Testing back-off ----\n");
+
+    AdaptiveCompressionConfig config;
+    adaptive_config_defaults(&config);
+    config.store_entropy = 8.1;     // Force trial compression of everything
+    config.probe_interval = 8;
+    ac = NULL;
+    if (adaptive_compressor_create(&config, &ac) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "adaptive_compressor_create failed\n");
+        return 1;
+    }
+
+    for (int i = 0; i < 40; i++) {
+        output_len = sizeof(output);
+        adaptive_compress(ac, noise, sizeof(noise), output, &output_len, &codec);
+    }
+
+    AdaptiveCompressionStats stats;
+    adaptive_compressor_stats(ac, &stats);
+    printf("40 incompressible payloads: %llu stored, ratio %.3f\n",
+           (unsigned long long)stats.stored, stats.ratio_ewma);
+
+    // Everything was stored and the ratio average keeps the compressor backing off
+    if (stats.stored != 40 || stats.ratio_ewma < config.backoff_ratio ||
+        adaptive_choose(ac, noise, sizeof(noise)) != COMPRESSION_DECISION_STORE) {
+        fprintf(stderr, "Back-off did not engage\n");
+        adaptive_compressor_destroy(ac);
+        return 1;
+    }
+    adaptive_compressor_destroy(ac);
+
+    printf("Adaptive compression tests successful.\n");
+
+    return 0;
+}
@@ -0,0 +1,166 @@
+// test_binlog.c
+
+#include "secure_comm.h"
+
+#include <stdio.h>      // For printf, fprintf, tmpfile
+#include <stdlib.h>     // For mkstemp
+#include <string.h>     // For strcmp, strstr
+#include <unistd.h>     // For close
+
+#define VOLUME_LINES 10000
+
+static char binary_path[] = "/tmp/test_binlog_binXXXXXX";
+static char text_path[] = "/tmp/test_binlog_txtXXXXXX";
+
+/**
+ * @brief Returns the size of a file in bytes.
+ */
+static long file_size(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        return -1;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fclose(file);
+    return size;
+}
+
+/**
+ * @brief Checks that a decoded line carries the expected level and message.
+ */
+static int check_line(const char* line, const char* level, const char* expected) {
+    char tag[16];
+    snprintf(tag, sizeof(tag), "] [%s] ", level);
+    const char* message = strstr(line, tag);
+    if (message == NULL || line[0] != '[') {
+        return -1;
+    }
+    message += strlen(tag);
+    size_t len = strlen(message);
+    if (len > 0 && message[len - 1] == '\n') {
+        len--;
+    }
+    return (len == strlen(expected) && strncmp(message, expected, len) == 0) ? 0 : -1;
+}
+
+int main() {
+    int fd = mkstemp(binary_path);
+    if (fd < 0) {
+        perror("mkstemp");
+        return 1;
+    }
+    close(fd);
+    fd = mkstemp(text_path);
+    if (fd < 0) {
+        perror("mkstemp");
+        return 1;
+    }
+    close(fd);
+
+    // -----------------------------
+    // Round trip: every supported conversion decodes to what printf would print
+    // -----------------------------
+    printf("---- Testing binary log round trip ----\n");
+    if (init_logging_binary(LOG_LEVEL_INFO, binary_path) != SECURE_COMM_SUCCESS || !binary_log_active()) {
+        fprintf(stderr, "init_logging_binary failed\n");
+        return 1;
+    }
+
+    char expected[8][256];
+    int x = 42;
+    snprintf(expected[0], sizeof(expected[0]), "Accepted connection from %s:%d", "127.0.0.1", 8080);
+    log_message(LOG_LEVEL_INFO, "Accepted connection from %s:%d", "127.0.0.1", 8080);
+    snprintf(expected[1], sizeof(expected[1]), "%zu bytes, %lld total, %u%% done, %x/%#o", (size_t)4096,
+             -1234567890123LL, 75u, 0xBEEFu, 8u);
+    log_message(LOG_LEVEL_WARN, "%zu bytes, %lld total, %u%% done, %x/%#o", (size_t)4096,
+                -1234567890123LL, 75u, 0xBEEFu, 8u);
+    snprintf(expected[2], sizeof(expected[2]), "ratio %.3f, %8.2e, [%-6s] [%*d] [%.*s] %c", 0.8125, 12345.678,
+             "ab", 5, 7, 3, "truncated", 'Z');
+    log_message(LOG_LEVEL_ERROR, "ratio %.3f, %8.2e, [%-6s] [%*d] [%.*s] %c", 0.8125, 12345.678,
+                "ab", 5, 7, 3, "truncated", 'Z');
+    snprintf(expected[3], sizeof(expected[3]), "pointer %p, null %s", (void*)&x, "(null)");
+    log_message(LOG_LEVEL_INFO, "pointer %p, null %s", (void*)&x, (const char*)NULL);
+    log_message(LOG_LEVEL_DEBUG, "filtered by level %d", 1);
+
+    // More conversions than the binary record holds falls back to formatted text
+    snprintf(expected[4], sizeof(expected[4]), "%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d",
+             1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17);
+    log_message(LOG_LEVEL_INFO, "%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d",
+                1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17);
+
+    // The same format logged again reuses its interned ID
+    snprintf(expected[5], sizeof(expected[5]), "Accepted connection from %s:%d", "10.0.0.7", 443);
+    log_message(LOG_LEVEL_INFO, "Accepted connection from %s:%d", "10.0.0.7", 443);
+    const char* levels[6] = { "INFO", "WARN", "ERROR", "INFO", "INFO", "INFO" };
+    cleanup_logging();
+
+    FILE* in = fopen(binary_path, "rb");
+    FILE* out = tmpfile();
+    size_t records = 0;
+    if (in == NULL || out == NULL || binary_log_decode(in, out, &records) != SECURE_COMM_SUCCESS || records != 6) {
+        fprintf(stderr, "binary_log_decode failed (%zu records)\n", records);
+        return 1;
+    }
+    fclose(in);
+    rewind(out);
+    char line[512];
+    for (int i = 0; i < 6; i++) {
+        if (fgets(line, sizeof(line), out) == NULL || check_line(line, levels[i], expected[i]) != 0) {
+            fprintf(stderr, "Decoded line %d does not match:\n  got:      %s  expected: %s\n", i, line, expected[i]);
+            return 1;
+        }
+    }
+    fclose(out);
+    printf("Decoded %zu lines identical to printf output.\n", records);
+
+    // A truncated file decodes up to the damage and reports it
+    long full = file_size(binary_path);
+    if (truncate(binary_path, full - 3) != 0) {
+        perror("truncate");
+        return 1;
+    }
+    in = fopen(binary_path, "rb");
+    out = tmpfile();
+    if (binary_log_decode(in, out, &records) != SECURE_COMM_ERR_LOG || records != 5) {
+        fprintf(stderr, "Truncated binary log was not reported (%zu records)\n", records);
+        return 1;
+    }
+    fclose(in);
+    fclose(out);
+
+    // -----------------------------
+    // Volume: typical server lines in both sinks
+    // -----------------------------
+    printf("\n---- Testing binary log size ----\n");
+    if (init_logging_binary(LOG_LEVEL_INFO, binary_path) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "init_logging_binary failed\n");
+        return 1;
+    }
+    for (int i = 0; i < VOLUME_LINES; i++) {
+        log_message(LOG_LEVEL_INFO, "Client %s:%d uses cipher suite %s", "192.168.10.21", 40000 + i, "aes-256-gcm");
+    }
+    cleanup_logging();
+
+    if (init_logging(LOG_LEVEL_INFO, text_path) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "init_logging failed\n");
+        return 1;
+    }
+    for (int i = 0; i < VOLUME_LINES; i++) {
+        log_message(LOG_LEVEL_INFO, "Client %s:%d uses cipher suite %s", "192.168.10.21", 40000 + i, "aes-256-gcm");
+    }
+    cleanup_logging();
+
+    long binary_size = file_size(binary_path);
+    long text_size = file_size(text_path);
+    printf("%d lines: text %ld bytes, binary %ld bytes.\n", VOLUME_LINES, text_size, binary_size);
+    remove(binary_path);
+    remove(text_path);
+    if (binary_size <= 0 || binary_size >= text_size) {
+        fprintf(stderr, "Binary log is not smaller than the text log\n");
+        return 1;
+    }
+
+    printf("Binary log tests successful.\n");
+    return 0;
+}
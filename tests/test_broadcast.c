@@ -0,0 +1,385 @@
+// test_broadcast.c
+
+#include "secure_comm.h"
+
+#include <stdio.h>      // For printf, fprintf
+#include <stdlib.h>     // For malloc, free
+#include <string.h>     // For memset, memcmp
+#include <pthread.h>    // For the draining threads
+
+#define SUBSCRIBERS 8
+#define FAN_OUT_MESSAGES 1000
+
+// One simulated client: the server side's cipher and the client's copy of the key
+typedef struct {
+    SecureCipher* server_cipher;
+    SecureCipher* client_cipher;
+    SecureCipher* group_cipher;     // Keyed from the GROUP_KEY frame
+    BroadcastSubscriber* subscriber;
+    int received;
+    int failed;
+} TestClient;
+
+static SecureCommError client_init_suite(BroadcastHub* hub, TestClient* client, unsigned char key_byte,
+                                         CipherSuite suite) {
+    unsigned char key[32];
+    unsigned char salt[SECURE_NONCE_SALT_SIZE] = { 0x80, 0, 0, key_byte };
+    memset(key, key_byte, sizeof(key));
+    memset(client, 0, sizeof(*client));
+    if (cipher_create_suite(suite, key, sizeof(key), &client->server_cipher) != SECURE_COMM_SUCCESS ||
+        cipher_use_counter_nonces(client->server_cipher, salt) != SECURE_COMM_SUCCESS ||
+        cipher_create_suite(suite, key, sizeof(key), &client->client_cipher) != SECURE_COMM_SUCCESS) {
+        return SECURE_COMM_ERR_ENCRYPT;
+    }
+    return broadcast_subscriber_create(hub, client->server_cipher, &client->subscriber);
+}
+
+static SecureCommError client_init(BroadcastHub* hub, TestClient* client, unsigned char key_byte) {
+    return client_init_suite(hub, client, key_byte, CIPHER_SUITE_AES_GCM);
+}
+
+static void client_free(TestClient* client) {
+    broadcast_subscriber_destroy(client->subscriber);
+    cipher_destroy(client->server_cipher);
+    cipher_destroy(client->client_cipher);
+    cipher_destroy(client->group_cipher);
+}
+
+/**
+ * @brief Opens one frame as the client would and returns its payload, or NULL.
+ */
+static unsigned char* client_open(TestClient* client, SecureBuffer* frame, FrameHeader* header, size_t* len) {
+    if (secure_buffer_len(frame) < SECURE_FRAME_HEADER_SIZE) {
+        return NULL;
+    }
+    frame_decode_header(secure_buffer_data(frame), header);
+    if (header->length + SECURE_FRAME_HEADER_SIZE != secure_buffer_len(frame)) {
+        return NULL;
+    }
+
+    // Open a copy: group frames are shared by every subscriber
+    static _Thread_local unsigned char record[8192];
+    memcpy(record, secure_buffer_data(frame) + SECURE_FRAME_HEADER_SIZE, header->length);
+    SecureCipher* cipher = (header->flags & FRAME_FLAG_GROUP) ? client->group_cipher : client->client_cipher;
+    unsigned char* payload = NULL;
+    if (cipher == NULL || cipher_open_record(cipher, record, header->length, &payload, len) != SECURE_COMM_SUCCESS) {
+        return NULL;
+    }
+    if (header->type == FRAME_TYPE_GROUP_KEY) {
+        cipher_destroy(client->group_cipher);
+        client->group_cipher = NULL;
+        if (*len < 32 + 4 + 1 || payload[36] >= CIPHER_SUITE_COUNT ||
+            cipher_create_suite((CipherSuite)payload[36], payload, 32, &client->group_cipher) != SECURE_COMM_SUCCESS) {
+            return NULL;
+        }
+    }
+    return payload;
+}
+
+/**
+ * @brief Drains a subscriber until it is closed, checking every message.
+ */
+static void* drain_worker(void* arg) {
+    TestClient* client = (TestClient*)arg;
+    SecureBuffer* frame = NULL;
+    while (broadcast_subscriber_next(client->subscriber, -1, &frame) == SECURE_COMM_SUCCESS) {
+        FrameHeader header;
+        size_t len = 0;
+        unsigned char* payload = client_open(client, frame, &header, &len);
+        if (payload == NULL || (header.type == FRAME_TYPE_DATA && (len != 5 || memcmp(payload, "fan-", 4) != 0))) {
+            client->failed++;
+        } else if (header.type == FRAME_TYPE_DATA) {
+            client->received++;
+        }
+        secure_buffer_release(frame);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Publishes FAN_OUT_MESSAGES messages to SUBSCRIBERS threads draining in parallel.
+ */
+static int run_fan_out(BroadcastMode mode, const char* topic) {
+    BroadcastHub* hub = NULL;
+    if (broadcast_hub_create(NULL, &hub) != SECURE_COMM_SUCCESS ||
+        broadcast_topic_create(hub, topic, mode) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "Failed to create the hub\n");
+        return -1;
+    }
+
+    TestClient clients[SUBSCRIBERS];
+    pthread_t threads[SUBSCRIBERS];
+    for (int i = 0; i < SUBSCRIBERS; i++) {
+        if (client_init(hub, &clients[i], (unsigned char)(i + 1)) != SECURE_COMM_SUCCESS ||
+            broadcast_subscribe(clients[i].subscriber, topic) != SECURE_COMM_SUCCESS) {
+            fprintf(stderr, "Failed to subscribe client %d\n", i);
+            return -1;
+        }
+        pthread_create(&threads[i], NULL, drain_worker, &clients[i]);
+    }
+
+    // Never outrun the default queue, so nothing is dropped
+    int published = 0;
+    while (published < FAN_OUT_MESSAGES) {
+        BroadcastSubscriberStats stats;
+        broadcast_subscriber_stats(clients[published % SUBSCRIBERS].subscriber, &stats);
+        if (stats.queued > 128) {
+            continue;
+        }
+        BroadcastResult result;
+        unsigned char message[5] = { 'f', 'a', 'n', '-', (unsigned char)published };
+        if (broadcast_publish(hub, topic, COMPRESSION_CODEC_NONE, message, sizeof(message), &result) != SECURE_COMM_SUCCESS ||
+            result.subscribers != SUBSCRIBERS) {
+            fprintf(stderr, "broadcast_publish failed\n");
+            return -1;
+        }
+        published++;
+    }
+
+    // Wait for the queues to empty before closing them
+    for (int i = 0; i < SUBSCRIBERS; i++) {
+        BroadcastSubscriberStats stats;
+        do {
+            broadcast_subscriber_stats(clients[i].subscriber, &stats);
+        } while (stats.queued > 0);
+        broadcast_subscriber_close(clients[i].subscriber);
+    }
+
+    int failed = 0;
+    for (int i = 0; i < SUBSCRIBERS; i++) {
+        pthread_join(threads[i], NULL);
+        BroadcastSubscriberStats stats;
+        broadcast_subscriber_stats(clients[i].subscriber, &stats);
+        if (clients[i].failed != 0 || clients[i].received + (int)stats.dropped != FAN_OUT_MESSAGES) {
+            fprintf(stderr, "Client %d received %d messages, %d bad, %llu dropped\n", i, clients[i].received,
+                    clients[i].failed, (unsigned long long)stats.dropped);
+            failed = 1;
+        }
+        client_free(&clients[i]);
+    }
+    broadcast_hub_destroy(hub);
+    return failed ? -1 : 0;
+}
+
+int main() {
+    BroadcastHub* hub = NULL;
+    BroadcastResult result;
+    SecureBuffer* frame = NULL;
+    FrameHeader header;
+    size_t len = 0;
+    const unsigned char message[] = "hello, room";
+
+    // -----------------------------
+    // Per-recipient sealing
+    // -----------------------------
+    printf("---- Testing per-recipient topics ----\n");
+    TestClient a, b;
+    if (broadcast_hub_create(NULL, &hub) != SECURE_COMM_SUCCESS ||
+        broadcast_topic_create(hub, "lobby", BROADCAST_PER_RECIPIENT) != SECURE_COMM_SUCCESS ||
+        broadcast_topic_create(hub, "lobby", BROADCAST_PER_RECIPIENT) == SECURE_COMM_SUCCESS ||
+        client_init(hub, &a, 0x01) != SECURE_COMM_SUCCESS || client_init(hub, &b, 0x02) != SECURE_COMM_SUCCESS ||
+        broadcast_subscribe(a.subscriber, "lobby") != SECURE_COMM_SUCCESS ||
+        broadcast_subscribe(b.subscriber, "lobby") != SECURE_COMM_SUCCESS ||
+        broadcast_subscribe(b.subscriber, "nowhere") == SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "Failed to set up the per-recipient topic\n");
+        return 1;
+    }
+    if (broadcast_publish(hub, "lobby", COMPRESSION_CODEC_NONE, message, sizeof(message), &result) != SECURE_COMM_SUCCESS ||
+        result.subscribers != 2 || result.queued != 2) {
+        fprintf(stderr, "broadcast_publish did not reach both subscribers\n");
+        return 1;
+    }
+    TestClient* pair[2] = { &a, &b };
+    for (int i = 0; i < 2; i++) {
+        unsigned char* payload = NULL;
+        if (broadcast_subscriber_next(pair[i]->subscriber, 0, &frame) != SECURE_COMM_SUCCESS ||
+            (payload = client_open(pair[i], frame, &header, &len)) == NULL || header.type != FRAME_TYPE_DATA ||
+            (header.flags & FRAME_FLAG_GROUP) || len != sizeof(message) || memcmp(payload, message, len) != 0) {
+            fprintf(stderr, "Subscriber %d could not open its frame\n", i);
+            return 1;
+        }
+        secure_buffer_release(frame);
+    }
+    if (broadcast_subscriber_next(a.subscriber, 10, &frame) != SECURE_COMM_ERR_AGAIN) {
+        fprintf(stderr, "An empty queue returned a frame\n");
+        return 1;
+    }
+
+    // Unsubscribed clients stop receiving
+    broadcast_unsubscribe(b.subscriber, "lobby");
+    broadcast_publish(hub, "lobby", COMPRESSION_CODEC_NONE, message, sizeof(message), &result);
+    if (result.queued != 1 || broadcast_subscriber_next(b.subscriber, 0, &frame) != SECURE_COMM_ERR_AGAIN) {
+        fprintf(stderr, "An unsubscribed client still received the message\n");
+        return 1;
+    }
+    client_free(&a);
+    client_free(&b);
+    broadcast_hub_destroy(hub);
+    printf("Each subscriber opens its copy with its own key.\n");
+
+    // -----------------------------
+    // Group-key topics: one encryption for everyone
+    // -----------------------------
+    printf("\n---- Testing group-key topics ----\n");
+    if (broadcast_hub_create(NULL, &hub) != SECURE_COMM_SUCCESS ||
+        broadcast_topic_create(hub, "news", BROADCAST_GROUP_KEY) != SECURE_COMM_SUCCESS ||
+        client_init(hub, &a, 0x03) != SECURE_COMM_SUCCESS || client_init(hub, &b, 0x04) != SECURE_COMM_SUCCESS ||
+        broadcast_subscribe(a.subscriber, "news") != SECURE_COMM_SUCCESS ||
+        broadcast_subscribe(b.subscriber, "news") != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "Failed to set up the group topic\n");
+        return 1;
+    }
+    for (int i = 0; i < 2; i++) {
+        unsigned char* payload = NULL;
+        if (broadcast_subscriber_next(pair[i]->subscriber, 0, &frame) != SECURE_COMM_SUCCESS ||
+            (payload = client_open(pair[i], frame, &header, &len)) == NULL || header.type != FRAME_TYPE_GROUP_KEY ||
+            len != 32 + 4 + 1 + 4 || memcmp(payload + 32, "\0\0\0\0\0news", 9) != 0) {
+            fprintf(stderr, "Subscriber %d did not get the group key\n", i);
+            return 1;
+        }
+        secure_buffer_release(frame);
+    }
+    broadcast_publish(hub, "news", COMPRESSION_CODEC_NONE, message, sizeof(message), &result);
+    SecureBuffer* frames[2];
+    for (int i = 0; i < 2; i++) {
+        unsigned char* payload = NULL;
+        if (broadcast_subscriber_next(pair[i]->subscriber, 0, &frames[i]) != SECURE_COMM_SUCCESS ||
+            (payload = client_open(pair[i], frames[i], &header, &len)) == NULL ||
+            !(header.flags & FRAME_FLAG_GROUP) || len != sizeof(message) || memcmp(payload, message, len) != 0) {
+            fprintf(stderr, "Subscriber %d could not open the group frame\n", i);
+            return 1;
+        }
+    }
+    if (frames[0] != frames[1]) {
+        fprintf(stderr, "The group frame was sealed more than once\n");
+        return 1;
+    }
+    secure_buffer_release(frames[0]);
+    secure_buffer_release(frames[1]);
+    printf("Both subscribers share one sealed frame.\n");
+
+    // A leaving subscriber takes the old key with it, so the rest get a new one
+    broadcast_unsubscribe(a.subscriber, "news");
+    unsigned char* key_payload = NULL;
+    if (broadcast_subscriber_next(b.subscriber, 0, &frame) != SECURE_COMM_SUCCESS ||
+        (key_payload = client_open(&b, frame, &header, &len)) == NULL || header.type != FRAME_TYPE_GROUP_KEY ||
+        len != 32 + 4 + 1 + 4 || memcmp(key_payload + 32, "\0\0\0\1\0news", 9) != 0) {
+        fprintf(stderr, "The remaining subscriber did not get the epoch 1 group key\n");
+        return 1;
+    }
+    secure_buffer_release(frame);
+    broadcast_publish(hub, "news", COMPRESSION_CODEC_NONE, message, sizeof(message), &result);
+    unsigned char* payload = NULL;
+    if (result.queued != 1 || broadcast_subscriber_next(b.subscriber, 0, &frame) != SECURE_COMM_SUCCESS ||
+        (payload = client_open(&b, frame, &header, &len)) == NULL || len != sizeof(message) ||
+        memcmp(payload, message, len) != 0) {
+        fprintf(stderr, "The remaining subscriber could not open a frame under the new key\n");
+        return 1;
+    }
+    if (client_open(&a, frame, &header, &len) != NULL) {
+        fprintf(stderr, "The departed subscriber opened a frame sealed after it left\n");
+        return 1;
+    }
+    secure_buffer_release(frame);
+    client_free(&a);
+    client_free(&b);
+    broadcast_hub_destroy(hub);
+    printf("The group key was replaced when a subscriber left.\n");
+
+    // ChaCha20-Poly1305 members get a ChaCha20-Poly1305 group key; an AES-GCM newcomer moves them to AES-GCM
+    if (broadcast_hub_create(NULL, &hub) != SECURE_COMM_SUCCESS ||
+        broadcast_topic_create(hub, "chacha", BROADCAST_GROUP_KEY) != SECURE_COMM_SUCCESS ||
+        client_init_suite(hub, &a, 0x05, CIPHER_SUITE_CHACHA20_POLY1305) != SECURE_COMM_SUCCESS ||
+        client_init(hub, &b, 0x06) != SECURE_COMM_SUCCESS ||
+        broadcast_subscribe(a.subscriber, "chacha") != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "Failed to set up the ChaCha20-Poly1305 group topic\n");
+        return 1;
+    }
+    broadcast_publish(hub, "chacha", COMPRESSION_CODEC_NONE, message, sizeof(message), &result);
+    broadcast_subscribe(b.subscriber, "chacha");
+    broadcast_publish(hub, "chacha", COMPRESSION_CODEC_NONE, message, sizeof(message), &result);
+    // a: key (ChaCha), message, key (AES-GCM), message. b: key (AES-GCM), message.
+    const uint8_t expected_suites[2][4] = {
+        { CIPHER_SUITE_CHACHA20_POLY1305, CIPHER_SUITE_CHACHA20_POLY1305, CIPHER_SUITE_AES_GCM, CIPHER_SUITE_AES_GCM },
+        { CIPHER_SUITE_AES_GCM, CIPHER_SUITE_AES_GCM, 0, 0 }
+    };
+    for (int i = 0; i < 2; i++) {
+        for (int n = 0; n < (i == 0 ? 4 : 2); n++) {
+            payload = NULL;
+            if (broadcast_subscriber_next(pair[i]->subscriber, 0, &frame) != SECURE_COMM_SUCCESS ||
+                (payload = client_open(pair[i], frame, &header, &len)) == NULL ||
+                header.type != (n % 2 == 0 ? FRAME_TYPE_GROUP_KEY : FRAME_TYPE_DATA) ||
+                (header.type == FRAME_TYPE_GROUP_KEY ? payload[36] : header.suite) != expected_suites[i][n]) {
+                fprintf(stderr, "Subscriber %d frame %d was not under the expected group suite\n", i, n);
+                return 1;
+            }
+            secure_buffer_release(frame);
+        }
+    }
+    client_free(&a);
+    client_free(&b);
+    broadcast_hub_destroy(hub);
+    printf("The group key follows the subscribers' common suite.\n");
+
+    // -----------------------------
+    // Backpressure: a stalled subscriber only fills its own queue
+    // -----------------------------
+    printf("\n---- Testing slow subscribers ----\n");
+    for (int policy = BROADCAST_FULL_DROP; policy <= BROADCAST_FULL_DISCONNECT; policy++) {
+        BroadcastHubConfig config;
+        broadcast_hub_config_defaults(&config);
+        config.max_queued = 4;
+        config.on_full = (BroadcastFullPolicy)policy;
+        TestClient fast, stalled;
+        if (broadcast_hub_create(&config, &hub) != SECURE_COMM_SUCCESS ||
+            broadcast_topic_create(hub, "feed", BROADCAST_PER_RECIPIENT) != SECURE_COMM_SUCCESS ||
+            client_init(hub, &fast, 0x05) != SECURE_COMM_SUCCESS || client_init(hub, &stalled, 0x06) != SECURE_COMM_SUCCESS ||
+            broadcast_subscribe(fast.subscriber, "feed") != SECURE_COMM_SUCCESS ||
+            broadcast_subscribe(stalled.subscriber, "feed") != SECURE_COMM_SUCCESS) {
+            fprintf(stderr, "Failed to set up the backpressure test\n");
+            return 1;
+        }
+        size_t dropped = 0, disconnected = 0;
+        for (int i = 0; i < 10; i++) {
+            broadcast_publish(hub, "feed", COMPRESSION_CODEC_NONE, message, sizeof(message), &result);
+            dropped += result.dropped;
+            disconnected += result.disconnected;
+            if (broadcast_subscriber_next(fast.subscriber, 0, &frame) != SECURE_COMM_SUCCESS) {
+                fprintf(stderr, "The fast subscriber was held back\n");
+                return 1;
+            }
+            secure_buffer_release(frame);
+        }
+        BroadcastSubscriberStats stats;
+        broadcast_subscriber_stats(stalled.subscriber, &stats);
+        if (policy == BROADCAST_FULL_DROP) {
+            if (dropped != 6 || stats.queued != 4 || stats.dropped != 6 || stats.closed) {
+                fprintf(stderr, "Drop policy: %zu dropped, %zu queued\n", dropped, stats.queued);
+                return 1;
+            }
+            printf("Drop: the stalled subscriber kept %zu frames and missed %llu.\n", stats.queued,
+                   (unsigned long long)stats.dropped);
+        } else {
+            if (disconnected != 1 || !stats.closed || broadcast_subscriber_next(stalled.subscriber, 0, &frame) != SECURE_COMM_ERR_SESSION) {
+                fprintf(stderr, "Disconnect policy did not close the stalled subscriber\n");
+                return 1;
+            }
+            printf("Disconnect: the stalled subscriber was closed.\n");
+        }
+        client_free(&fast);
+        client_free(&stalled);
+        broadcast_hub_destroy(hub);
+    }
+
+    // -----------------------------
+    // Fan-out to draining threads
+    // -----------------------------
+    printf("\n---- Testing fan-out to %d subscribers ----\n", SUBSCRIBERS);
+    if (run_fan_out(BROADCAST_PER_RECIPIENT, "per-recipient") != 0 || run_fan_out(BROADCAST_GROUP_KEY, "group") != 0) {
+        return 1;
+    }
+    printf("%d messages reached every subscriber in both modes.\n", FAN_OUT_MESSAGES);
+
+    printf("Broadcast tests successful.\n");
+    return 0;
+}
@@ -0,0 +1,324 @@
+// test_buffer_pool.c
+
+#include "secure_comm.h"
+
+#include <stdio.h>      // For printf, fprintf
+#include <stdlib.h>     // For malloc, free
+#include <string.h>     // For memset, memcmp
+#include <pthread.h>    // For the concurrent tests
+#include <time.h>       // For clock_gettime
+
+#define STRESS_THREADS 8
+#define STRESS_ROUNDS 100000
+#define HANDOFF_COUNT 10000
+#define TIMING_ROUNDS 1000000
+
+static BufferPool* pool = NULL;
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/**
+ * @brief Takes and releases buffers of varying sizes, keeping a few alive at once.
+ */
+static void* stress_worker(void* arg) {
+    uint32_t state = (uint32_t)(uintptr_t)arg * 2654435761u + 1;
+    SecureBuffer* held[8] = { NULL };
+    for (int i = 0; i < STRESS_ROUNDS; i++) {
+        state = state * 1103515245u + 12345u;
+        int slot = (int)((state >> 8) & 7);
+        if (held[slot] != NULL) {
+            // Every byte must still carry the pattern written when it was taken
+            unsigned char* data = secure_buffer_data(held[slot]);
+            if (data[0] != (unsigned char)slot || data[secure_buffer_len(held[slot]) - 1] != (unsigned char)slot) {
+                return (void*)1;
+            }
+            secure_buffer_release(held[slot]);
+            held[slot] = NULL;
+        }
+        size_t size = 1 + ((state >> 12) % (64 * 1024));
+        if (buffer_pool_get(pool, size, &held[slot]) != SECURE_COMM_SUCCESS) {
+            return (void*)1;
+        }
+        memset(secure_buffer_data(held[slot]), slot, size);
+        secure_buffer_set_len(held[slot], size);
+    }
+    for (int slot = 0; slot < 8; slot++) {
+        secure_buffer_release(held[slot]);
+    }
+    return NULL;
+}
+
+static SecureBuffer* handoff[HANDOFF_COUNT];
+
+/**
+ * @brief Releases buffers another thread took; they land in this thread's cache.
+ */
+static void* handoff_consumer(void* arg) {
+    (void)arg;
+    for (int i = 0; i < HANDOFF_COUNT; i++) {
+        secure_buffer_release(handoff[i]);
+    }
+    return NULL;
+}
+
+int main() {
+    BufferPoolStats stats;
+    if (buffer_pool_create(NULL, &pool) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "buffer_pool_create failed\n");
+        return 1;
+    }
+
+    // -----------------------------
+    // Size classes, reuse and reference counts
+    // -----------------------------
+    printf("---- Testing size classes ----\n");
+    SecureBuffer* a = NULL;
+    SecureBuffer* b = NULL;
+    SecureBuffer* big = NULL;
+    if (buffer_pool_get(pool, 1, &a) != SECURE_COMM_SUCCESS || secure_buffer_capacity(a) != 256 ||
+        buffer_pool_get(pool, 300, &b) != SECURE_COMM_SUCCESS || secure_buffer_capacity(b) != 512 ||
+        buffer_pool_get(pool, 1024 * 1024 + 1, &big) != SECURE_COMM_SUCCESS ||
+        secure_buffer_capacity(big) != 1024 * 1024 + 1 || secure_buffer_len(a) != 0) {
+        fprintf(stderr, "Buffers do not have the expected size classes\n");
+        return 1;
+    }
+    if (((uintptr_t)secure_buffer_data(a) & 63) != 0 || ((uintptr_t)secure_buffer_data(big) & 63) != 0) {
+        fprintf(stderr, "Buffer data is not cache-line aligned\n");
+        return 1;
+    }
+    secure_buffer_release(big);
+
+    // A released buffer comes straight back from the thread cache
+    unsigned char* first = secure_buffer_data(a);
+    secure_buffer_release(a);
+    if (buffer_pool_get(pool, 200, &a) != SECURE_COMM_SUCCESS || secure_buffer_data(a) != first) {
+        fprintf(stderr, "Released buffer was not reused\n");
+        return 1;
+    }
+
+    // Shared between two stages: the second release returns it
+    secure_buffer_retain(b);
+    secure_buffer_release(b);
+    buffer_pool_stats(pool, &stats);
+    if (stats.outstanding != 2 || stats.oversize != 1 || stats.cache_hits < 1) {
+        fprintf(stderr, "Unexpected counters: %llu outstanding, %llu oversize\n",
+                (unsigned long long)stats.outstanding, (unsigned long long)stats.oversize);
+        return 1;
+    }
+    secure_buffer_release(b);
+
+    // Length and front trimming stay inside the buffer
+    memcpy(secure_buffer_data(a), "headerpayload", 13);
+    if (secure_buffer_set_len(a, 13) != SECURE_COMM_SUCCESS || secure_buffer_advance(a, 6) != SECURE_COMM_SUCCESS ||
+        memcmp(secure_buffer_data(a), "payload", 7) != 0 || secure_buffer_len(a) != 7 ||
+        secure_buffer_capacity(a) != 250 || secure_buffer_advance(a, 8) == SECURE_COMM_SUCCESS ||
+        secure_buffer_set_len(a, 251) == SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "secure_buffer_set_len / secure_buffer_advance misbehaved\n");
+        return 1;
+    }
+    secure_buffer_release(a);
+    printf("Classes round up to powers of two; released buffers are reused.\n");
+
+    // -----------------------------
+    // Many threads, and buffers released on another thread
+    // -----------------------------
+    printf("\n---- Testing concurrent use ----\n");
+    pthread_t threads[STRESS_THREADS];
+    for (int i = 0; i < STRESS_THREADS; i++) {
+        pthread_create(&threads[i], NULL, stress_worker, (void*)(uintptr_t)(i + 1));
+    }
+    int failed = 0;
+    for (int i = 0; i < STRESS_THREADS; i++) {
+        void* result = NULL;
+        pthread_join(threads[i], &result);
+        failed |= result != NULL;
+    }
+    if (failed) {
+        fprintf(stderr, "A buffer was handed out twice or corrupted\n");
+        return 1;
+    }
+
+    for (int i = 0; i < HANDOFF_COUNT; i++) {
+        if (buffer_pool_get(pool, 2048, &handoff[i]) != SECURE_COMM_SUCCESS) {
+            fprintf(stderr, "buffer_pool_get failed during handoff\n");
+            return 1;
+        }
+    }
+    pthread_t consumer;
+    pthread_create(&consumer, NULL, handoff_consumer, NULL);
+    pthread_join(consumer, NULL);
+
+    buffer_pool_stats(pool, &stats);
+    printf("%llu gets: %llu from thread caches, %llu from shared lists, %llu slabs (%llu KB).\n",
+           (unsigned long long)stats.gets, (unsigned long long)stats.cache_hits,
+           (unsigned long long)stats.central_hits, (unsigned long long)stats.slabs,
+           (unsigned long long)(stats.slab_bytes / 1024));
+    if (stats.outstanding != 0) {
+        fprintf(stderr, "%llu buffers were never returned\n", (unsigned long long)stats.outstanding);
+        return 1;
+    }
+
+    // Buffers released by the exited consumer went back to the shared lists
+    uint64_t slabs_before = stats.slabs;
+    for (int i = 0; i < HANDOFF_COUNT; i++) {
+        buffer_pool_get(pool, 2048, &handoff[i]);
+    }
+    for (int i = 0; i < HANDOFF_COUNT; i++) {
+        secure_buffer_release(handoff[i]);
+    }
+    buffer_pool_stats(pool, &stats);
+    if (stats.slabs != slabs_before) {
+        fprintf(stderr, "Buffers from an exited thread were not reused\n");
+        return 1;
+    }
+
+    double t0 = now_ns();
+    for (int i = 0; i < TIMING_ROUNDS; i++) {
+        SecureBuffer* buf = NULL;
+        buffer_pool_get(pool, 4096, &buf);
+        secure_buffer_release(buf);
+    }
+    double pooled_ns = (now_ns() - t0) / TIMING_ROUNDS;
+    t0 = now_ns();
+    for (int i = 0; i < TIMING_ROUNDS; i++) {
+        void* volatile mem = malloc(4096);
+        free(mem);
+    }
+    double malloc_ns = (now_ns() - t0) / TIMING_ROUNDS;
+    printf("4 KB get + release: %.1f ns (malloc + free: %.1f ns).\n", pooled_ns, malloc_ns);
+
+    // -----------------------------
+    // One buffer per stage: compress, seal, frame, open, decompress
+    // -----------------------------
+    printf("\n---- Testing the pooled message path ----\n");
+    unsigned char message[8192];
+    for (size_t i = 0; i < sizeof(message); i++) {
+        message[i] = (unsigned char)("pooled message path "[i % 20]);
+    }
+
+    SecureBuffer* compressed = NULL;
+    if (compress_data_pooled(pool, message, sizeof(message), 6, &compressed) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "compress_data_pooled failed\n");
+        return 1;
+    }
+
+    unsigned char key[32];
+    memset(key, 0x24, sizeof(key));
+    SecureCipher* cipher = NULL;
+    SecureBuffer* record = NULL;
+    size_t compressed_len = secure_buffer_len(compressed);
+    if (cipher_create(key, sizeof(key), &cipher) != SECURE_COMM_SUCCESS ||
+        buffer_pool_get(pool, SECURE_RECORD_OVERHEAD + compressed_len, &record) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "Failed to prepare the record\n");
+        return 1;
+    }
+    memcpy(secure_buffer_data(record) + SECURE_RECORD_OVERHEAD, secure_buffer_data(compressed), compressed_len);
+    secure_buffer_set_len(record, SECURE_RECORD_OVERHEAD + compressed_len);
+    secure_buffer_release(compressed);
+    if (cipher_seal_buffer(cipher, record) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "cipher_seal_buffer failed\n");
+        return 1;
+    }
+
+    // The sealed record crosses a socket pair and is reassembled into a pool buffer
+    int pair[2];
+    SecureCommError err;
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0) {
+        perror("socketpair");
+        return 1;
+    }
+    SecureConnection* left = connection_wrap_socket(pair[0], &err);
+    SecureConnection* right = connection_wrap_socket(pair[1], &err);
+    unsigned char header_bytes[SECURE_FRAME_HEADER_SIZE];
+    FrameHeader header = { (uint32_t)secure_buffer_len(record), FRAME_TYPE_DATA, 0, COMPRESSION_CODEC_ZLIB, 0 };
+    frame_encode_header(&header, header_bytes);
+    ssize_t moved = 0;
+    if (left == NULL || right == NULL || secure_send(left, header_bytes, sizeof(header_bytes), &moved) != SECURE_COMM_SUCCESS ||
+        secure_send_buffer(left, record) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "Sending the record failed\n");
+        return 1;
+    }
+    size_t wire_len = sizeof(header_bytes) + secure_buffer_len(record);
+    secure_buffer_release(record);
+
+    SecureBuffer* wire = NULL;
+    if (buffer_pool_get(pool, wire_len, &wire) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "buffer_pool_get failed\n");
+        return 1;
+    }
+    while (secure_buffer_len(wire) < wire_len) {
+        if (secure_recv_buffer(right, wire, NULL) != SECURE_COMM_SUCCESS) {
+            fprintf(stderr, "secure_recv_buffer failed\n");
+            return 1;
+        }
+    }
+    close_connection(left);
+    close_connection(right);
+
+    FrameDecoder* decoder = NULL;
+    size_t consumed = 0;
+    SecureBuffer* payload = NULL;
+    FrameHeader received;
+    if (frame_decoder_create(0, SECURE_FRAME_DEFAULT_MAX_PAYLOAD, &decoder) != SECURE_COMM_SUCCESS ||
+        frame_decoder_feed(decoder, secure_buffer_data(wire), secure_buffer_len(wire), &consumed) != SECURE_COMM_SUCCESS ||
+        frame_decoder_next_buffer(decoder, pool, &received, &payload) != SECURE_COMM_SUCCESS ||
+        secure_buffer_len(payload) != received.length) {
+        fprintf(stderr, "frame_decoder_next_buffer failed\n");
+        return 1;
+    }
+    secure_buffer_release(wire);
+    frame_decoder_destroy(decoder);
+
+    SecureBuffer* restored = NULL;
+    if (cipher_open_buffer(cipher, payload) != SECURE_COMM_SUCCESS ||
+        secure_buffer_len(payload) != compressed_len ||
+        codec_decompress_pooled((CompressionCodecId)received.codec, pool, secure_buffer_data(payload),
+                                secure_buffer_len(payload), 0, 0, &restored) != SECURE_COMM_SUCCESS ||
+        secure_buffer_len(restored) != sizeof(message) ||
+        memcmp(secure_buffer_data(restored), message, sizeof(message)) != 0) {
+        fprintf(stderr, "The pooled message did not survive the round trip\n");
+        return 1;
+    }
+    secure_buffer_release(payload);
+    secure_buffer_release(restored);
+    cipher_destroy(cipher);
+
+    // Output larger than the first guess moves up a size class
+    SecureBuffer* zeros_in = NULL;
+    SecureBuffer* zeros_out = NULL;
+    static unsigned char zeros[512 * 1024];
+    if (codec_compress_pooled(COMPRESSION_CODEC_ZLIB, pool, zeros, sizeof(zeros), -1, &zeros_in) != SECURE_COMM_SUCCESS ||
+        decompress_data_pooled(pool, secure_buffer_data(zeros_in), secure_buffer_len(zeros_in), 0, 0, &zeros_out) !=
+            SECURE_COMM_SUCCESS ||
+        secure_buffer_len(zeros_out) != sizeof(zeros) ||
+        decompress_data_pooled(pool, secure_buffer_data(zeros_in), secure_buffer_len(zeros_in), 0, 4096, &zeros_out) ==
+            SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "decompress_data_pooled did not grow or did not enforce its limit\n");
+        return 1;
+    }
+    printf("%zu compressed bytes grew back to %zu bytes.\n", secure_buffer_len(zeros_in), secure_buffer_len(zeros_out));
+    secure_buffer_release(zeros_in);
+    secure_buffer_release(zeros_out);
+
+    buffer_pool_stats(pool, &stats);
+    if (stats.outstanding != 0) {
+        fprintf(stderr, "The message path leaked %llu buffers\n", (unsigned long long)stats.outstanding);
+        return 1;
+    }
+    buffer_pool_destroy(pool);
+
+    // The shared pool serves callers that pass NULL
+    SecureBuffer* shared = NULL;
+    if (buffer_pool_default() == NULL || buffer_pool_get(NULL, 64, &shared) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "The default pool is unavailable\n");
+        return 1;
+    }
+    secure_buffer_release(shared);
+
+    printf("Buffer pool tests successful.\n");
+    return 0;
+}
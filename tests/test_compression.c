@@ -5,6 +5,56 @@
 #include <stdio.h>      // For printf, fprintf
 #include <string.h>     // For strlen, memcmp
 #include <stdlib.h>     // For malloc, free
+#include <zlib.h>       // For Z_DEFAULT_COMPRESSION
+
+// Test codec for inputs of one repeated byte: length (4 bytes, big-endian) || byte
+#define FILL_CODEC_ID ((CompressionCodecId)(COMPRESSION_CODEC_MAX - 2))
+static int fill_decompress_calls = 0;
+
+static size_t fill_bound(size_t input_len) {
+    (void)input_len;
+    return 5;
+}
+
+static SecureCommError fill_compress(const unsigned char* input, size_t input_len,
+                                     unsigned char* output, size_t* output_len, int level) {
+    (void)level;
+    for (size_t i = 1; i < input_len; i++) {
+        if (input[i] != input[0]) {
+            return SECURE_COMM_ERR_COMPRESS;
+        }
+    }
+    output[0] = (unsigned char)(input_len >> 24);
+    output[1] = (unsigned char)(input_len >> 16);
+    output[2] = (unsigned char)(input_len >> 8);
+    output[3] = (unsigned char)input_len;
+    output[4] = input_len > 0 ? input[0] : 0;
+    *output_len = 5;
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Reports the recorded length when the buffer is too small, like the LZ4 codec.
+ */
+static SecureCommError fill_decompress(const unsigned char* input, size_t input_len,
+                                       unsigned char* output, size_t* output_len) {
+    fill_decompress_calls++;
+    if (input_len != 5) {
+        return SECURE_COMM_ERR_DECOMPRESS;
+    }
+    size_t original = ((size_t)input[0] << 24) | ((size_t)input[1] << 16) | ((size_t)input[2] << 8) | input[3];
+    if (original > *output_len) {
+        *output_len = original;
+        return SECURE_COMM_ERR_MEMORY;
+    }
+    memset(output, input[4], original);
+    *output_len = original;
+    return SECURE_COMM_SUCCESS;
+}
+
+static const CompressionCodec fill_codec = {
+    FILL_CODEC_ID, "fill", 0, 0, 0, fill_bound, fill_compress, fill_decompress
+};
 
 int main() {
     // Sample input data (replace with a larger text for more rigorous testing)
@@ -72,12 +122,320 @@ int main() {
         return 1;
     }
 
-    printf("Compression and decompression successful.\n");
-
-    // Clean up
     free(compressed);
     free(decompressed);
     free(decompressed_str);
 
+    // Z_DEFAULT_COMPRESSION is accepted for small inputs too, not just on the parallel path
+    compressed = NULL;
+    decompressed = NULL;
+    if (compress_data_dynamic((unsigned char*)input, input_len, &compressed, &compressed_len,
+                              Z_DEFAULT_COMPRESSION) != SECURE_COMM_SUCCESS ||
+        decompress_data_dynamic(compressed, compressed_len, &decompressed, &decompressed_len) != SECURE_COMM_SUCCESS ||
+        decompressed_len != input_len || memcmp(input, decompressed, input_len) != 0) {
+        fprintf(stderr, "compress_data_dynamic rejected or mangled a small input at the default level\n");
+        return 1;
+    }
+    free(compressed);
+    free(decompressed);
+    compressed = NULL;
+    if (compress_data_dynamic((unsigned char*)input, input_len, &compressed, &compressed_len, -2) == SECURE_COMM_SUCCESS ||
+        compress_data_dynamic((unsigned char*)input, input_len, &compressed, &compressed_len, 10) == SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "compress_data_dynamic accepted an invalid level\n");
+        return 1;
+    }
+    printf("Default and invalid levels handled.\n");
+
+    // -----------------------------------
+    // Testing highly repetitive payloads (well beyond 10x)
+    // -----------------------------------
+    printf("\n---- Testing decompress_data_dynamic_ex ----\n");
+
+    size_t big_len = 4 * 1024 * 1024;
+    unsigned char* big = (unsigned char*)malloc(big_len);
+    if (big == NULL) {
+        fprintf(stderr, "Failed to allocate repetitive input.\n");
+        return 1;
+    }
+    for (size_t i = 0; i < big_len; i++) {
+        big[i] = (unsigned char)("telemetry:0;"[i % 12]);
+    }
+
+    compressed = NULL;
+    if (compress_data_dynamic(big, big_len, &compressed, &compressed_len, 6) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "Failed to compress repetitive input.\n");
+        free(big);
+        return 1;
+    }
+    printf("Repetitive input: %zu -> %zu bytes (%.0fx)\n", big_len, compressed_len,
+           (double)big_len / (double)compressed_len);
+
+    // Without a hint the buffer must grow; with the exact hint it must not need to
+    for (int with_hint = 0; with_hint < 2; with_hint++) {
+        decompressed = NULL;
+        decompressed_len = 0;
+        SecureCommError ret = decompress_data_dynamic_ex(compressed, compressed_len,
+                                                         with_hint ? big_len : 0, 0,
+                                                         &decompressed, &decompressed_len);
+        if (ret != SECURE_COMM_SUCCESS || decompressed_len != big_len ||
+            memcmp(decompressed, big, big_len) != 0) {
+            fprintf(stderr, "Repetitive payload did not round-trip (hint=%d, ret=%d).\n", with_hint, ret);
+            free(decompressed);
+            free(compressed);
+            free(big);
+            return 1;
+        }
+        free(decompressed);
+    }
+
+    // Output beyond the limit is refused
+    decompressed = NULL;
+    if (decompress_data_dynamic_ex(compressed, compressed_len, 0, big_len / 2,
+                                   &decompressed, &decompressed_len) == SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "Decompression limit was not enforced.\n");
+        free(decompressed);
+        free(compressed);
+        free(big);
+        return 1;
+    }
+
+    // Truncated input is an error, not a short result
+    decompressed = NULL;
+    if (decompress_data_dynamic_ex(compressed, compressed_len / 2, 0, 0,
+                                   &decompressed, &decompressed_len) == SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "Truncated input was accepted.\n");
+        free(decompressed);
+        free(compressed);
+        free(big);
+        return 1;
+    }
+
+    free(compressed);
+    free(big);
+
+    // -----------------------------------
+    // Testing z_stream reuse across calls
+    // -----------------------------------
+    printf("\n---- Testing pooled z_streams ----\n");
+
+    // Warm up this thread's level 6 deflater and its inflater
+    compressed = NULL;
+    decompressed = NULL;
+    if (compress_data_dynamic((unsigned char*)input, input_len, &compressed, &compressed_len, 6) != SECURE_COMM_SUCCESS ||
+        decompress_data_dynamic(compressed, compressed_len, &decompressed, &decompressed_len) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "Warm-up round failed.\n");
+        return 1;
+    }
+    free(compressed);
+    free(decompressed);
+
+    CompressionStats before, after;
+    compression_get_stats(&before);
+    for (int round = 0; round < 100; round++) {
+        compressed = NULL;
+        decompressed = NULL;
+        if (compress_data_dynamic((unsigned char*)input, input_len, &compressed, &compressed_len, 6) != SECURE_COMM_SUCCESS ||
+            decompress_data_dynamic(compressed, compressed_len, &decompressed, &decompressed_len) != SECURE_COMM_SUCCESS ||
+            decompressed_len != input_len || memcmp(input, decompressed, input_len) != 0) {
+            fprintf(stderr, "Pooled round %d failed.\n", round);
+            free(compressed);
+            free(decompressed);
+            return 1;
+        }
+        free(compressed);
+        free(decompressed);
+    }
+    compression_get_stats(&after);
+
+    printf("100 round trips: %llu stream inits, %llu reuses, %llu zlib allocations\n",
+           (unsigned long long)(after.stream_inits - before.stream_inits),
+           (unsigned long long)(after.stream_reuses - before.stream_reuses),
+           (unsigned long long)(after.zlib_allocs - before.zlib_allocs));
+    if (after.stream_inits != before.stream_inits || after.zlib_allocs != before.zlib_allocs ||
+        after.stream_reuses - before.stream_reuses != 200) {
+        fprintf(stderr, "z_streams were not reused.\n");
+        return 1;
+    }
+    compression_release_thread_pool();
+
+    // -----------------------------------
+    // Testing the codec registry
+    // -----------------------------------
+    printf("\n---- Testing codec registry ----\n");
+
+    uint32_t mask = codec_supported_mask();
+    if (!(mask & (1u << COMPRESSION_CODEC_NONE)) || !(mask & (1u << COMPRESSION_CODEC_ZLIB)) ||
+        codec_find_by_name("zlib") != codec_find(COMPRESSION_CODEC_ZLIB)) {
+        fprintf(stderr, "Built-in codecs are not registered.\n");
+        return 1;
+    }
+
+    for (int id = 0; id < COMPRESSION_CODEC_MAX; id++) {
+        const CompressionCodec* codec = codec_find((CompressionCodecId)id);
+        if (codec == NULL) {
+            continue;
+        }
+
+        compressed = NULL;
+        decompressed = NULL;
+        if (codec_compress_dynamic(codec->id, (unsigned char*)input, input_len,
+                                   &compressed, &compressed_len, -1) != SECURE_COMM_SUCCESS ||
+            codec_decompress_dynamic(codec->id, compressed, compressed_len, 0, 0,
+                                     &decompressed, &decompressed_len) != SECURE_COMM_SUCCESS ||
+            decompressed_len != input_len || memcmp(input, decompressed, input_len) != 0) {
+            fprintf(stderr, "Codec %s did not round-trip.\n", codec->name);
+            free(compressed);
+            free(decompressed);
+            return 1;
+        }
+        printf("%-5s %zu -> %zu bytes\n", codec->name, input_len, compressed_len);
+        free(compressed);
+        free(decompressed);
+    }
+
+    // Peers settle on the best shared codec, and unknown ids are refused
+    if (codec_negotiate(mask, 1u << COMPRESSION_CODEC_ZLIB) != COMPRESSION_CODEC_ZLIB ||
+        codec_negotiate(mask, 0) != COMPRESSION_CODEC_NONE ||
+        codec_find((CompressionCodecId)(COMPRESSION_CODEC_MAX - 1)) != NULL ||
+        codec_compress_dynamic((CompressionCodecId)(COMPRESSION_CODEC_MAX - 1), (unsigned char*)input, input_len,
+                               &compressed, &compressed_len, -1) == SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "Codec negotiation gave an unexpected result.\n");
+        return 1;
+    }
+
+    // A codec that reports its decompressed size is retried once, at exactly that size
+    size_t fill_len = 3 * 1024 * 1024 + 17;
+    unsigned char* fill = (unsigned char*)malloc(fill_len);
+    if (fill == NULL || codec_register(&fill_codec) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "Failed to set up the fill codec.\n");
+        return 1;
+    }
+    memset(fill, 'f', fill_len);
+    compressed = NULL;
+    decompressed = NULL;
+    SecureBuffer* fill_buffer = NULL;
+    if (codec_compress_dynamic(FILL_CODEC_ID, fill, fill_len, &compressed, &compressed_len, -1) != SECURE_COMM_SUCCESS ||
+        codec_decompress_dynamic(FILL_CODEC_ID, compressed, compressed_len, 0, 0,
+                                 &decompressed, &decompressed_len) != SECURE_COMM_SUCCESS ||
+        fill_decompress_calls != 2 || decompressed_len != fill_len || memcmp(decompressed, fill, fill_len) != 0 ||
+        codec_decompress_pooled(FILL_CODEC_ID, NULL, compressed, compressed_len, 0, 0,
+                                &fill_buffer) != SECURE_COMM_SUCCESS ||
+        fill_decompress_calls != 4 || secure_buffer_len(fill_buffer) != fill_len) {
+        fprintf(stderr, "Reported decompressed size was not used (%d decompress calls).\n", fill_decompress_calls);
+        return 1;
+    }
+    secure_buffer_release(fill_buffer);
+    free(decompressed);
+
+    // A reported size above the limit fails without trying a bigger buffer
+    fill_decompress_calls = 0;
+    decompressed = NULL;
+    if (codec_decompress_dynamic(FILL_CODEC_ID, compressed, compressed_len, 0, 1024 * 1024,
+                                 &decompressed, &decompressed_len) != SECURE_COMM_ERR_DECOMPRESS ||
+        fill_decompress_calls != 1) {
+        fprintf(stderr, "Oversized reported length was not refused at once.\n");
+        return 1;
+    }
+    free(compressed);
+    free(fill);
+
+    // -----------------------------------
+    // Testing parallel block compression
+    // -----------------------------------
+    printf("\n---- Testing parallel compression ----\n");
+
+    // Several MB of loosely repetitive text so blocks have both matches and variation
+    size_t large_len = 6 * 1024 * 1024 + 12345;
+    unsigned char* large = (unsigned char*)malloc(large_len);
+    if (large == NULL) {
+        fprintf(stderr, "Failed to allocate the large input.\n");
+        return 1;
+    }
+    uint32_t seed = 12345;
+    for (size_t i = 0; i < large_len; i++) {
+        seed = seed * 1103515245u + 12345u;
+        large[i] = (seed >> 16) % 4 == 0 ? (unsigned char)('a' + (seed >> 20) % 26) : (unsigned char)input[i % input_len];
+    }
+
+    WorkerPoolConfig pool_config;
+    WorkerPool* workers = NULL;
+    worker_pool_config_defaults(&pool_config);
+    pool_config.threads = 4;
+    if (worker_pool_create(&pool_config, &workers) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "worker_pool_create failed\n");
+        return 1;
+    }
+
+    ParallelCompressionConfig parallel;
+    parallel_compression_config_defaults(&parallel);
+    parallel.pool = workers;
+
+    // Primed blocks: a standard zlib stream that any inflater reads
+    compressed = NULL;
+    decompressed = NULL;
+    if (compress_data_parallel(large, large_len, &parallel, &compressed, &compressed_len, NULL, NULL) != SECURE_COMM_SUCCESS ||
+        decompress_data_dynamic_ex(compressed, compressed_len, 0, 0, &decompressed, &decompressed_len) != SECURE_COMM_SUCCESS ||
+        decompressed_len != large_len || memcmp(large, decompressed, large_len) != 0) {
+        fprintf(stderr, "Primed parallel compression did not round-trip.\n");
+        return 1;
+    }
+    printf("Primed:  %zu -> %zu bytes\n", large_len, compressed_len);
+    free(compressed);
+    free(decompressed);
+
+    // Independent blocks with an index inflate in parallel too
+    unsigned char* index = NULL;
+    size_t index_len = 0;
+    if (compress_data_parallel(large, large_len, &parallel, &compressed, &compressed_len, &index, &index_len) != SECURE_COMM_SUCCESS ||
+        decompress_data_parallel(compressed, compressed_len, index, index_len, 0, workers,
+                                 &decompressed, &decompressed_len) != SECURE_COMM_SUCCESS ||
+        decompressed_len != large_len || memcmp(large, decompressed, large_len) != 0) {
+        fprintf(stderr, "Indexed parallel compression did not round-trip.\n");
+        return 1;
+    }
+    free(decompressed);
+    if (decompress_data_dynamic_ex(compressed, compressed_len, 0, 0, &decompressed, &decompressed_len) != SECURE_COMM_SUCCESS ||
+        decompressed_len != large_len || memcmp(large, decompressed, large_len) != 0) {
+        fprintf(stderr, "Indexed stream is not a standard zlib stream.\n");
+        return 1;
+    }
+    free(decompressed);
+    printf("Indexed: %zu -> %zu bytes, %zu-byte index\n", large_len, compressed_len, index_len);
+
+    // A corrupted checksum, a short limit and a mismatched index are all refused
+    compressed[compressed_len - 1] ^= 0x01;
+    if (decompress_data_parallel(compressed, compressed_len, index, index_len, 0, workers,
+                                 &decompressed, &decompressed_len) == SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "A corrupted trailer was accepted.\n");
+        return 1;
+    }
+    compressed[compressed_len - 1] ^= 0x01;
+    if (decompress_data_parallel(compressed, compressed_len, index, index_len, large_len - 1, workers,
+                                 &decompressed, &decompressed_len) == SECURE_COMM_SUCCESS ||
+        decompress_data_parallel(compressed, compressed_len - 1, index, index_len, 0, workers,
+                                 &decompressed, &decompressed_len) == SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "A bad limit or index was accepted.\n");
+        return 1;
+    }
+    free(compressed);
+    free(index);
+
+    // Small inputs still produce a valid stream
+    if (compress_data_parallel((const unsigned char*)input, input_len, &parallel, &compressed, &compressed_len,
+                               &index, &index_len) != SECURE_COMM_SUCCESS ||
+        decompress_data_parallel(compressed, compressed_len, index, index_len, 0, workers,
+                                 &decompressed, &decompressed_len) != SECURE_COMM_SUCCESS ||
+        decompressed_len != input_len || memcmp(input, decompressed, input_len) != 0) {
+        fprintf(stderr, "Single-block parallel compression did not round-trip.\n");
+        return 1;
+    }
+    free(compressed);
+    free(decompressed);
+    free(index);
+    worker_pool_destroy(workers);
+    free(large);
+
+    printf("Compression and decompression successful.\n");
+
     return 0;
 }
@@ -4,6 +4,7 @@
 
 #include <stdio.h>      // For printf
 #include <string.h>     // For strlen, memcmp
+#include <time.h>       // For clock_gettime
 
 int main() {
     // Sample plaintext
@@ -13,10 +14,11 @@ int main() {
     // Encryption key (32 bytes for AES-256)
     const unsigned char key[32] = "0123456789abcdef0123456789abcdef";
 
-    // Initialization Vector (16 bytes for AES)
-    const unsigned char iv[16] = "abcdef9876543210";
+    // IV (12 bytes for AES-GCM, generated by encrypt_data) and tag
+    unsigned char iv[12];
+    unsigned char tag[16];
 
-    // Buffer for ciphertext (will be larger than plaintext)
+    // Buffer for ciphertext (same size as plaintext for GCM)
     unsigned char ciphertext[128];
     int ciphertext_len = 0;
 
@@ -24,9 +26,13 @@ int main() {
     unsigned char decryptedtext[128];
     int decryptedtext_len = 0;
 
-    // Encrypt the plaintext
+    // -----------------------------
+    // Testing encrypt_data / decrypt_data
+    // -----------------------------
+    printf("---- Testing encrypt_data/decrypt_data ----\n");
+
     SecureCommError enc_ret = encrypt_data((unsigned char*)plaintext, plaintext_len,
-                                           key, iv, ciphertext, &ciphertext_len);
+                                           key, iv, ciphertext, &ciphertext_len, tag);
     if (enc_ret != SECURE_COMM_SUCCESS) {
         fprintf(stderr, "Encryption failed with error code: %d\n", enc_ret);
         return 1;
@@ -38,25 +44,364 @@ int main() {
     }
     printf("\n");
 
-    // Decrypt the ciphertext
     SecureCommError dec_ret = decrypt_data(ciphertext, ciphertext_len,
-                                           key, iv, decryptedtext, &decryptedtext_len);
+                                           key, iv, decryptedtext, &decryptedtext_len, tag);
     if (dec_ret != SECURE_COMM_SUCCESS) {
         fprintf(stderr, "Decryption failed with error code: %d\n", dec_ret);
         return 1;
     }
 
-    // Null-terminate the decrypted text
-    decryptedtext[decryptedtext_len] = '\0';
-
-    printf("Decrypted text is:\n%s\n", decryptedtext);
-
     // Verify that decrypted text matches original plaintext
     if (decryptedtext_len != plaintext_len || memcmp(plaintext, decryptedtext, plaintext_len) != 0) {
         fprintf(stderr, "Decryption did not produce the original plaintext.\n");
         return 1;
     }
 
+    // -----------------------------
+    // Testing the SecureCipher handle
+    // -----------------------------
+    printf("\n---- Testing SecureCipher ----\n");
+
+    SecureCipher* cipher = NULL;
+    if (cipher_create(key, sizeof(key), &cipher) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "cipher_create failed\n");
+        return 1;
+    }
+
+    // Several messages through the same handle, each with its own IV
+    for (int round = 0; round < 3; round++) {
+        if (cipher_encrypt(cipher, (unsigned char*)plaintext, plaintext_len,
+                           iv, ciphertext, &ciphertext_len, tag) != SECURE_COMM_SUCCESS) {
+            fprintf(stderr, "cipher_encrypt failed in round %d\n", round);
+            cipher_destroy(cipher);
+            return 1;
+        }
+
+        // Messages from the handle must interoperate with the one-shot API
+        if (decrypt_data(ciphertext, ciphertext_len, key, iv,
+                         decryptedtext, &decryptedtext_len, tag) != SECURE_COMM_SUCCESS ||
+            decryptedtext_len != plaintext_len || memcmp(plaintext, decryptedtext, plaintext_len) != 0) {
+            fprintf(stderr, "decrypt_data could not read cipher_encrypt output in round %d\n", round);
+            cipher_destroy(cipher);
+            return 1;
+        }
+
+        if (cipher_decrypt(cipher, ciphertext, ciphertext_len, iv,
+                           decryptedtext, &decryptedtext_len, tag) != SECURE_COMM_SUCCESS ||
+            decryptedtext_len != plaintext_len || memcmp(plaintext, decryptedtext, plaintext_len) != 0) {
+            fprintf(stderr, "cipher_decrypt failed in round %d\n", round);
+            cipher_destroy(cipher);
+            return 1;
+        }
+    }
+
+    // A tampered tag must be rejected
+    tag[0] ^= 0x01;
+    if (cipher_decrypt(cipher, ciphertext, ciphertext_len, iv,
+                       decryptedtext, &decryptedtext_len, tag) == SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "cipher_decrypt accepted a tampered tag\n");
+        cipher_destroy(cipher);
+        return 1;
+    }
+
+    cipher_destroy(cipher);
+
+    // -----------------------------
+    // Testing counter-based nonces and replay detection
+    // -----------------------------
+    printf("\n---- Testing NonceGenerator ----\n");
+
+    const unsigned char salt[SECURE_NONCE_SALT_SIZE] = {0xA1, 0xB2, 0xC3, 0xD4};
+    NonceGenerator* gen = NULL;
+    if (nonce_generator_create(salt, &gen) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "nonce_generator_create failed\n");
+        return 1;
+    }
+
+    unsigned char previous_iv[12];
+    for (uint64_t expected = 0; expected < 4; expected++) {
+        uint64_t sequence = 0;
+        if (nonce_generator_next(gen, iv, &sequence) != SECURE_COMM_SUCCESS ||
+            sequence != expected || nonce_sequence(iv) != expected ||
+            memcmp(iv, salt, SECURE_NONCE_SALT_SIZE) != 0 ||
+            (expected > 0 && memcmp(iv, previous_iv, sizeof(iv)) == 0)) {
+            fprintf(stderr, "nonce_generator_next produced an unexpected nonce\n");
+            nonce_generator_destroy(gen);
+            return 1;
+        }
+        memcpy(previous_iv, iv, sizeof(iv));
+    }
+    nonce_generator_destroy(gen);
+
+    // Ciphers in counter mode must still interoperate with decrypt_data
+    cipher = NULL;
+    if (cipher_create(key, sizeof(key), &cipher) != SECURE_COMM_SUCCESS ||
+        cipher_use_counter_nonces(cipher, salt) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "Failed to create counter-mode cipher\n");
+        cipher_destroy(cipher);
+        return 1;
+    }
+
+    ReplayWindow window;
+    replay_window_init(&window);
+    for (int round = 0; round < 3; round++) {
+        if (cipher_encrypt(cipher, (unsigned char*)plaintext, plaintext_len,
+                           iv, ciphertext, &ciphertext_len, tag) != SECURE_COMM_SUCCESS ||
+            decrypt_data(ciphertext, ciphertext_len, key, iv,
+                         decryptedtext, &decryptedtext_len, tag) != SECURE_COMM_SUCCESS ||
+            nonce_sequence(iv) != (uint64_t)round ||
+            replay_window_accept(&window, nonce_sequence(iv)) != SECURE_COMM_SUCCESS) {
+            fprintf(stderr, "Counter-mode round %d failed\n", round);
+            cipher_destroy(cipher);
+            return 1;
+        }
+    }
+    cipher_destroy(cipher);
+
+    // In-place records: seal inside one buffer, open it where it lies
+    cipher = NULL;
+    if (cipher_create(key, sizeof(key), &cipher) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "Failed to create cipher for in-place records\n");
+        return 1;
+    }
+    unsigned char record[SECURE_RECORD_OVERHEAD + 128];
+    memcpy(record + SECURE_RECORD_OVERHEAD, plaintext, plaintext_len);
+    size_t record_len = 0;
+    unsigned char* opened = NULL;
+    size_t opened_len = 0;
+    if (cipher_seal_record(cipher, record, plaintext_len, &record_len) != SECURE_COMM_SUCCESS ||
+        record_len != SECURE_RECORD_OVERHEAD + (size_t)plaintext_len ||
+        memcmp(record + SECURE_RECORD_OVERHEAD, plaintext, plaintext_len) == 0) {
+        fprintf(stderr, "cipher_seal_record failed\n");
+        cipher_destroy(cipher);
+        return 1;
+    }
+
+    // The sealed record is an ordinary IV || tag || ciphertext record
+    if (cipher_decrypt(cipher, record + SECURE_RECORD_OVERHEAD, (int)plaintext_len, record,
+                       decryptedtext, &decryptedtext_len, record + 12) != SECURE_COMM_SUCCESS ||
+        decryptedtext_len != (int)plaintext_len || memcmp(decryptedtext, plaintext, plaintext_len) != 0) {
+        fprintf(stderr, "Sealed record does not decrypt with cipher_decrypt\n");
+        cipher_destroy(cipher);
+        return 1;
+    }
+
+    if (cipher_open_record(cipher, record, record_len, &opened, &opened_len) != SECURE_COMM_SUCCESS ||
+        opened != record + SECURE_RECORD_OVERHEAD || opened_len != (size_t)plaintext_len ||
+        memcmp(opened, plaintext, plaintext_len) != 0) {
+        fprintf(stderr, "cipher_open_record failed\n");
+        cipher_destroy(cipher);
+        return 1;
+    }
+
+    // Tampered and truncated records are rejected
+    if (cipher_seal_record(cipher, record, plaintext_len, &record_len) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "cipher_seal_record failed\n");
+        cipher_destroy(cipher);
+        return 1;
+    }
+    record[SECURE_RECORD_OVERHEAD] ^= 0x01;
+    if (cipher_open_record(cipher, record, record_len, &opened, &opened_len) == SECURE_COMM_SUCCESS ||
+        cipher_open_record(cipher, record, SECURE_RECORD_OVERHEAD - 1, &opened, &opened_len) == SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "cipher_open_record accepted a damaged record\n");
+        cipher_destroy(cipher);
+        return 1;
+    }
+    cipher_destroy(cipher);
+
+    // Batch AEAD: one broadcast sealed for many recipients, each with its own key
+    enum { RECIPIENTS = 256, BROADCAST_SIZE = 16 * 1024 };
+    static SecureCipher* recipients[RECIPIENTS];
+    static unsigned char broadcast[BROADCAST_SIZE];
+    static unsigned char sealed[RECIPIENTS][BROADCAST_SIZE];
+    static unsigned char opened_batch[RECIPIENTS][BROADCAST_SIZE];
+    static unsigned char batch_iv[RECIPIENTS][12], batch_tag[RECIPIENTS][16];
+    static AeadBatchItem items[RECIPIENTS];
+    for (int i = 0; i < BROADCAST_SIZE; i++) {
+        broadcast[i] = (unsigned char)(i * 31 + 7);
+    }
+    for (int r = 0; r < RECIPIENTS; r++) {
+        unsigned char recipient_key[32];
+        memset(recipient_key, r, sizeof(recipient_key));
+        if (cipher_create(recipient_key, sizeof(recipient_key), &recipients[r]) != SECURE_COMM_SUCCESS ||
+            cipher_use_counter_nonces(recipients[r], NULL) != SECURE_COMM_SUCCESS) {
+            fprintf(stderr, "Failed to create recipient cipher %d\n", r);
+            return 1;
+        }
+    }
+
+    // Small messages run on the calling thread, 16 KB x 256 is split across threads
+    const size_t batch_sizes[2] = { 1024, BROADCAST_SIZE };
+    for (int pass = 0; pass < 2; pass++) {
+        size_t message_size = batch_sizes[pass];
+        for (int r = 0; r < RECIPIENTS; r++) {
+            items[r] = (AeadBatchItem){ recipients[r], broadcast, message_size, sealed[r], batch_iv[r], batch_tag[r], 0 };
+        }
+
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int r = 0; r < RECIPIENTS; r++) {
+            int out_len = 0;
+            cipher_encrypt(recipients[r], broadcast, (int)message_size, batch_iv[r], sealed[r], &out_len, batch_tag[r]);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double loop_ms = (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6;
+
+        size_t failures = 0;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        SecureCommError batch_ret = encrypt_data_batch(items, RECIPIENTS, &failures);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double batch_ms = (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6;
+
+        if (batch_ret != SECURE_COMM_SUCCESS || failures != 0) {
+            fprintf(stderr, "encrypt_data_batch failed for %zu items\n", failures);
+            return 1;
+        }
+        printf("Batch of %d x %zu bytes: per-call loop %.3f ms, batch %.3f ms.\n",
+               RECIPIENTS, message_size, loop_ms, batch_ms);
+
+        // Every recipient decrypts its copy; one tampered tag fails on its own
+        batch_tag[5][0] ^= 0x01;
+        for (int r = 0; r < RECIPIENTS; r++) {
+            items[r] = (AeadBatchItem){ recipients[r], sealed[r], message_size, opened_batch[r], batch_iv[r], batch_tag[r], 0 };
+        }
+        if (decrypt_data_batch(items, RECIPIENTS, &failures) != SECURE_COMM_ERR_DECRYPT || failures != 1 ||
+            items[5].status != SECURE_COMM_ERR_DECRYPT) {
+            fprintf(stderr, "decrypt_data_batch did not isolate the tampered item (%zu failures)\n", failures);
+            return 1;
+        }
+        for (int r = 0; r < RECIPIENTS; r++) {
+            if (r != 5 && (items[r].status != SECURE_COMM_SUCCESS ||
+                           memcmp(opened_batch[r], broadcast, message_size) != 0)) {
+                fprintf(stderr, "Recipient %d did not recover the broadcast\n", r);
+                return 1;
+            }
+        }
+    }
+    for (int r = 0; r < RECIPIENTS; r++) {
+        cipher_destroy(recipients[r]);
+    }
+
+    // -----------------------------
+    // Cipher suites: ChaCha20-Poly1305 records, CPU dispatch and negotiation
+    // -----------------------------
+    printf("\n---- Testing cipher suites ----\n");
+    CipherSuite preferred = cipher_suite_preferred();
+    unsigned int supported = cipher_suite_supported_mask();
+    printf("Preferred suite on this CPU: %s (supported mask 0x%x)\n", cipher_suite_name(preferred), supported);
+    if (!(supported & CIPHER_SUITE_MASK(preferred)) || !(supported & CIPHER_SUITE_MASK(CIPHER_SUITE_AES_GCM))) {
+        fprintf(stderr, "Preferred suite is not in the supported mask\n");
+        return 1;
+    }
+
+    if (supported & CIPHER_SUITE_MASK(CIPHER_SUITE_CHACHA20_POLY1305)) {
+        SecureCipher* chacha = NULL;
+        SecureCipher* aes = NULL;
+        if (cipher_create_suite(CIPHER_SUITE_CHACHA20_POLY1305, key, sizeof(key), &chacha) != SECURE_COMM_SUCCESS ||
+            cipher_create(key, sizeof(key), &aes) != SECURE_COMM_SUCCESS ||
+            cipher_get_suite(chacha) != CIPHER_SUITE_CHACHA20_POLY1305 || cipher_get_suite(aes) != CIPHER_SUITE_AES_GCM) {
+            fprintf(stderr, "Failed to create per-suite ciphers\n");
+            return 1;
+        }
+
+        memcpy(record + SECURE_RECORD_OVERHEAD, plaintext, plaintext_len);
+        if (cipher_seal_record(chacha, record, plaintext_len, &record_len) != SECURE_COMM_SUCCESS ||
+            record_len != SECURE_RECORD_OVERHEAD + (size_t)plaintext_len) {
+            fprintf(stderr, "ChaCha20-Poly1305 cipher_seal_record failed\n");
+            return 1;
+        }
+
+        // The same key under the other suite must not open the record
+        unsigned char copy[sizeof(record)];
+        memcpy(copy, record, record_len);
+        if (cipher_open_record(aes, copy, record_len, &opened, &opened_len) == SECURE_COMM_SUCCESS) {
+            fprintf(stderr, "AES-GCM opened a ChaCha20-Poly1305 record\n");
+            return 1;
+        }
+        if (cipher_open_record(chacha, record, record_len, &opened, &opened_len) != SECURE_COMM_SUCCESS ||
+            opened_len != (size_t)plaintext_len || memcmp(opened, plaintext, plaintext_len) != 0) {
+            fprintf(stderr, "ChaCha20-Poly1305 cipher_open_record failed\n");
+            return 1;
+        }
+        cipher_destroy(chacha);
+        cipher_destroy(aes);
+
+        // The client's preference wins when both sides support it
+        unsigned int both = CIPHER_SUITE_MASK(CIPHER_SUITE_AES_GCM) | CIPHER_SUITE_MASK(CIPHER_SUITE_CHACHA20_POLY1305);
+        if (cipher_suite_negotiate(both, CIPHER_SUITE_CHACHA20_POLY1305) != CIPHER_SUITE_CHACHA20_POLY1305 ||
+            cipher_suite_negotiate(both, CIPHER_SUITE_AES_GCM) != CIPHER_SUITE_AES_GCM) {
+            fprintf(stderr, "cipher_suite_negotiate ignored the client preference\n");
+            return 1;
+        }
+    }
+
+    // ChaCha20-Poly1305 only takes 256-bit keys
+    SecureCipher* rejected = NULL;
+    if (cipher_create_suite(CIPHER_SUITE_CHACHA20_POLY1305, key, 16, &rejected) == SECURE_COMM_SUCCESS ||
+        cipher_create_suite(CIPHER_SUITE_COUNT, key, sizeof(key), &rejected) == SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "cipher_create_suite accepted an invalid suite or key length\n");
+        return 1;
+    }
+
+    // Fallback to a shared suite, and no suite at all when nothing is shared
+    if (cipher_suite_negotiate(CIPHER_SUITE_MASK(CIPHER_SUITE_AES_GCM), CIPHER_SUITE_CHACHA20_POLY1305) != CIPHER_SUITE_AES_GCM ||
+        cipher_suite_negotiate(0, CIPHER_SUITE_AES_GCM) != CIPHER_SUITE_COUNT) {
+        fprintf(stderr, "cipher_suite_negotiate fallback gave an unexpected suite\n");
+        return 1;
+    }
+
+    // HELLO payloads round-trip, malformed ones are refused
+    unsigned char hello[SECURE_HELLO_SIZE];
+    unsigned char hello_random[SECURE_HELLO_RANDOM_SIZE], decoded_random[SECURE_HELLO_RANDOM_SIZE];
+    unsigned int hello_mask = 0;
+    CipherSuite hello_suite = CIPHER_SUITE_COUNT;
+    memset(hello_random, 0xA5, sizeof(hello_random));
+    cipher_hello_encode(supported, preferred, hello_random, hello);
+    if (cipher_hello_decode(hello, sizeof(hello), &hello_mask, &hello_suite, decoded_random) != SECURE_COMM_SUCCESS ||
+        hello_mask != supported || hello_suite != preferred ||
+        memcmp(decoded_random, hello_random, sizeof(hello_random)) != 0) {
+        fprintf(stderr, "HELLO payload did not round-trip\n");
+        return 1;
+    }
+    hello[2] = CIPHER_SUITE_COUNT;
+    if (cipher_hello_decode(hello, sizeof(hello), &hello_mask, &hello_suite, NULL) == SECURE_COMM_SUCCESS ||
+        cipher_hello_decode(hello, sizeof(hello) - 1, &hello_mask, &hello_suite, NULL) == SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "cipher_hello_decode accepted a malformed HELLO\n");
+        return 1;
+    }
+
+    // Connection keys are reproducible from the salt and differ between connections
+    unsigned char shared_key[32], connection_salt[SECURE_CONNECTION_SALT_SIZE];
+    unsigned char key_a[32], key_b[32], key_c[32];
+    memset(shared_key, 0x42, sizeof(shared_key));
+    memset(connection_salt, 0x01, sizeof(connection_salt));
+    if (cipher_derive_key(shared_key, sizeof(shared_key), connection_salt, sizeof(connection_salt),
+                          SECURE_CONNECTION_KEY_LABEL, key_a, sizeof(key_a)) != SECURE_COMM_SUCCESS ||
+        cipher_derive_key(shared_key, sizeof(shared_key), connection_salt, sizeof(connection_salt),
+                          SECURE_CONNECTION_KEY_LABEL, key_b, sizeof(key_b)) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "cipher_derive_key failed\n");
+        return 1;
+    }
+    connection_salt[SECURE_CONNECTION_SALT_SIZE - 1] ^= 1;
+    if (cipher_derive_key(shared_key, sizeof(shared_key), connection_salt, sizeof(connection_salt),
+                          SECURE_CONNECTION_KEY_LABEL, key_c, sizeof(key_c)) != SECURE_COMM_SUCCESS ||
+        memcmp(key_a, key_b, sizeof(key_a)) != 0 || memcmp(key_a, key_c, sizeof(key_a)) == 0 ||
+        memcmp(key_a, shared_key, sizeof(key_a)) == 0) {
+        fprintf(stderr, "cipher_derive_key did not give one key per connection salt\n");
+        return 1;
+    }
+
+    // Replays are rejected, reordered but unseen messages are accepted
+    if (replay_window_accept(&window, 1) == SECURE_COMM_SUCCESS ||
+        replay_window_accept(&window, 10) != SECURE_COMM_SUCCESS ||
+        replay_window_accept(&window, 7) != SECURE_COMM_SUCCESS ||
+        replay_window_accept(&window, 7) == SECURE_COMM_SUCCESS ||
+        replay_window_accept(&window, 200) != SECURE_COMM_SUCCESS ||
+        replay_window_accept(&window, 100) == SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "Replay window gave an unexpected result\n");
+        return 1;
+    }
+
     printf("Encryption and decryption successful.\n");
 
     return 0;
@@ -0,0 +1,177 @@
+// test_framing.c
+
+#include "secure_comm.h"
+
+#include <stdio.h>      // For printf
+#include <string.h>     // For memcmp, memset
+
+/**
+ * @brief Drains every complete frame from the decoder and checks it against the expected payload.
+ *
+ * @return Number of frames extracted, or -1 on a mismatch or malformed stream.
+ */
+static int drain(FrameDecoder* dec, const unsigned char* expected, size_t expected_len) {
+    unsigned char payload[256];
+    FrameHeader header;
+    int frames = 0;
+    SecureCommError ret;
+
+    while ((ret = frame_decoder_next(dec, &header, payload, sizeof(payload))) == SECURE_COMM_SUCCESS) {
+        if (header.type != FRAME_TYPE_DATA || header.length != expected_len ||
+            memcmp(payload, expected, expected_len) != 0) {
+            fprintf(stderr, "Frame %d does not match the sent payload\n", frames);
+            return -1;
+        }
+        frames++;
+    }
+    return ret == SECURE_COMM_ERR_AGAIN ? frames : -1;
+}
+
+int main() {
+    const unsigned char message[] = "framed message";
+    size_t message_len = sizeof(message) - 1;
+
+    // Build a batch of three frames
+    unsigned char batch[256];
+    size_t used = 0;
+    for (int i = 0; i < 3; i++) {
+        if (frame_append(batch, sizeof(batch), &used, FRAME_TYPE_DATA, 0, message, message_len) != SECURE_COMM_SUCCESS) {
+            fprintf(stderr, "frame_append failed\n");
+            return 1;
+        }
+    }
+    size_t frame_len = SECURE_FRAME_HEADER_SIZE + message_len;
+
+    // A frame that does not fit must be refused without touching the batch
+    size_t small_used = 0;
+    if (frame_append(batch, 8, &small_used, FRAME_TYPE_DATA, 0, message, message_len) != SECURE_COMM_ERR_MEMORY ||
+        small_used != 0) {
+        fprintf(stderr, "frame_append accepted an oversized frame\n");
+        return 1;
+    }
+
+    FrameDecoder* dec = NULL;
+    if (frame_decoder_create(64, 128, &dec) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "frame_decoder_create failed\n");
+        return 1;
+    }
+
+    // -----------------------------
+    // Merged frames: one read carries all three
+    // -----------------------------
+    printf("---- Testing merged frames ----\n");
+
+    size_t consumed = 0;
+    if (frame_decoder_feed(dec, batch, used, &consumed) != SECURE_COMM_SUCCESS || consumed != used ||
+        drain(dec, message, message_len) != 3 || frame_decoder_buffered(dec) != 0) {
+        fprintf(stderr, "Merged frames were not split correctly\n");
+        frame_decoder_destroy(dec);
+        return 1;
+    }
+
+    // -----------------------------
+    // Split frames: one byte per read
+    // -----------------------------
+    printf("---- Testing split frames ----\n");
+
+    int frames = 0;
+    for (size_t i = 0; i < used; i++) {
+        frame_decoder_feed(dec, batch + i, 1, &consumed);
+        int n = drain(dec, message, message_len);
+        if (n < 0 || (n == 1 && (i + 1) % frame_len != 0)) {
+            fprintf(stderr, "Split frame was emitted at the wrong offset %zu\n", i);
+            frame_decoder_destroy(dec);
+            return 1;
+        }
+        frames += n;
+    }
+    if (frames != 3) {
+        fprintf(stderr, "Expected 3 reassembled frames, got %d\n", frames);
+        frame_decoder_destroy(dec);
+        return 1;
+    }
+
+    // -----------------------------
+    // Wrapped frames: leave a partial frame buffered so later frames cross the ring end
+    // -----------------------------
+    printf("---- Testing wrapped frames ----\n");
+
+    frames = 0;
+    size_t offset = 5;
+    frame_decoder_feed(dec, batch, offset, &consumed);
+    for (int round = 0; round < 200; round++) {
+        size_t chunk = (size_t)(round % 7) + 9;
+        size_t pos = offset % used;
+        if (pos + chunk > used) {
+            chunk = used - pos;
+        }
+
+        // Feed through the zero-copy path
+        unsigned char* space;
+        size_t space_len;
+        frame_decoder_write_space(dec, &space, &space_len);
+        if (space_len < chunk) {
+            frame_decoder_feed(dec, batch + pos, chunk, &consumed);
+        } else {
+            memcpy(space, batch + pos, chunk);
+            frame_decoder_commit(dec, chunk);
+            consumed = chunk;
+        }
+        offset += consumed;
+
+        int n = drain(dec, message, message_len);
+        if (n < 0) {
+            fprintf(stderr, "Wrapped frame was corrupted in round %d\n", round);
+            frame_decoder_destroy(dec);
+            return 1;
+        }
+        frames += n;
+    }
+    if ((size_t)frames != (offset / frame_len)) {
+        fprintf(stderr, "Expected %zu wrapped frames, got %d\n", offset / frame_len, frames);
+        frame_decoder_destroy(dec);
+        return 1;
+    }
+    frame_decoder_destroy(dec);
+
+    // -----------------------------
+    // Oversized length field is a malformed stream
+    // -----------------------------
+    printf("---- Testing malformed frames ----\n");
+
+    dec = NULL;
+    if (frame_decoder_create(64, 8, &dec) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "frame_decoder_create failed\n");
+        return 1;
+    }
+    frame_decoder_feed(dec, batch, SECURE_FRAME_HEADER_SIZE, &consumed);
+    FrameHeader header;
+    unsigned char payload[64];
+    if (frame_decoder_next(dec, &header, payload, sizeof(payload)) != SECURE_COMM_ERR_FRAME) {
+        fprintf(stderr, "Oversized frame length was not rejected\n");
+        frame_decoder_destroy(dec);
+        return 1;
+    }
+    frame_decoder_destroy(dec);
+
+    // -----------------------------
+    // Header fields, including the cipher suite byte, survive encoding
+    // -----------------------------
+    printf("---- Testing header round trip ----\n");
+
+    FrameHeader sent = { 0x01020304u, FRAME_TYPE_HELLO, FRAME_FLAG_END, COMPRESSION_CODEC_ZLIB,
+                         CIPHER_SUITE_CHACHA20_POLY1305 };
+    unsigned char wire[SECURE_FRAME_HEADER_SIZE];
+    frame_encode_header(&sent, wire);
+    frame_decode_header(wire, &header);
+    if (wire[0] != 0x01 || wire[3] != 0x04 || wire[7] != CIPHER_SUITE_CHACHA20_POLY1305 ||
+        header.length != sent.length || header.type != sent.type || header.flags != sent.flags ||
+        header.codec != sent.codec || header.suite != sent.suite) {
+        fprintf(stderr, "Frame header did not round-trip\n");
+        return 1;
+    }
+
+    printf("Framing tests successful.\n");
+
+    return 0;
+}
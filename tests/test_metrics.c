@@ -0,0 +1,241 @@
+// test_metrics.c
+
+#include "secure_comm.h"
+
+#include <stdio.h>      // For printf, fprintf
+#include <stdlib.h>     // For malloc, free
+#include <string.h>     // For memset, strstr
+#include <pthread.h>    // For the concurrent counter test
+#include <time.h>       // For clock_gettime
+
+#define COUNT_THREADS 8
+#define COUNT_PER_THREAD 200000
+#define FAST_SAMPLES 990
+#define SLOW_SAMPLES 10
+
+static MetricsSnapshot snap;
+
+static void* count_worker(void* arg) {
+    (void)arg;
+    for (int i = 0; i < COUNT_PER_THREAD; i++) {
+        metrics_count(METRIC_SEND_CALLS, 1);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Sends one HTTP request to the endpoint and reads the whole reply.
+ */
+static int http_get(int port, const char* path, char* reply, size_t reply_size) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (fd < 0 || connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+
+    char request[128];
+    int len = snprintf(request, sizeof(request), "GET %s HTTP/1.0\r\nHost: localhost\r\n\r\n", path);
+    if (send(fd, request, (size_t)len, 0) != len) {
+        close(fd);
+        return -1;
+    }
+
+    size_t got = 0;
+    ssize_t n;
+    while (got < reply_size - 1 && (n = recv(fd, reply + got, reply_size - 1 - got, 0)) > 0) {
+        got += (size_t)n;
+    }
+    reply[got] = '\0';
+    close(fd);
+    return 0;
+}
+
+int main() {
+    // -----------------------------
+    // Sharded counters add up across threads
+    // -----------------------------
+    printf("---- Testing sharded counters ----\n");
+    metrics_reset();
+    pthread_t threads[COUNT_THREADS];
+    for (int i = 0; i < COUNT_THREADS; i++) {
+        pthread_create(&threads[i], NULL, count_worker, NULL);
+    }
+    for (int i = 0; i < COUNT_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    metrics_snapshot(&snap);
+    if (snap.counters[METRIC_SEND_CALLS] != (uint64_t)COUNT_THREADS * COUNT_PER_THREAD) {
+        fprintf(stderr, "Counter total %llu, expected %d\n",
+                (unsigned long long)snap.counters[METRIC_SEND_CALLS], COUNT_THREADS * COUNT_PER_THREAD);
+        return 1;
+    }
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int i = 0; i < 1000000; i++) {
+        metrics_count(METRIC_RECV_CALLS, 1);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double ns = (double)(t1.tv_sec - t0.tv_sec) * 1e9 + (double)(t1.tv_nsec - t0.tv_nsec);
+    printf("%d threads counted %d updates; one update costs %.1f ns.\n",
+           COUNT_THREADS, COUNT_THREADS * COUNT_PER_THREAD, ns / 1e6);
+
+    // While disabled nothing is recorded
+    metrics_set_enabled(0);
+    metrics_count(METRIC_SEND_CALLS, 5);
+    metrics_stage_done(METRIC_STAGE_ENCRYPT, metrics_now_ns(), 1, 1, SECURE_COMM_SUCCESS);
+    metrics_set_enabled(1);
+    metrics_snapshot(&snap);
+    if (snap.counters[METRIC_SEND_CALLS] != (uint64_t)COUNT_THREADS * COUNT_PER_THREAD ||
+        snap.stages[METRIC_STAGE_ENCRYPT].operations != 0) {
+        fprintf(stderr, "Disabled metrics were still recorded\n");
+        return 1;
+    }
+
+    // -----------------------------
+    // Latency histogram quantiles
+    // -----------------------------
+    printf("\n---- Testing latency histograms ----\n");
+    metrics_reset();
+    for (int i = 0; i < FAST_SAMPLES; i++) {
+        metrics_stage_done(METRIC_STAGE_KEYGEN, metrics_now_ns() - 10000, 0, 0, SECURE_COMM_SUCCESS);
+    }
+    for (int i = 0; i < SLOW_SAMPLES; i++) {
+        metrics_stage_done(METRIC_STAGE_KEYGEN, metrics_now_ns() - 5000000, 0, 0, SECURE_COMM_ERR_SESSION);
+    }
+    metrics_snapshot(&snap);
+    const MetricsStageSnapshot* keygen = &snap.stages[METRIC_STAGE_KEYGEN];
+    uint64_t p50 = metrics_stage_quantile_ns(keygen, 0.50);
+    uint64_t p999 = metrics_stage_quantile_ns(keygen, 0.999);
+    printf("p50 %llu ns, p99.9 %llu ns, max %llu ns, %llu failures.\n", (unsigned long long)p50,
+           (unsigned long long)p999, (unsigned long long)keygen->latency_max_ns,
+           (unsigned long long)keygen->failures);
+    if (keygen->operations != FAST_SAMPLES + SLOW_SAMPLES || keygen->failures != SLOW_SAMPLES ||
+        p50 < 10000 || p50 > 10000 * 2 || p999 < 5000000 || p999 > keygen->latency_max_ns) {
+        fprintf(stderr, "Histogram quantiles are off\n");
+        return 1;
+    }
+    for (size_t b = 1; b < METRICS_HISTOGRAM_BUCKETS; b++) {
+        if (metrics_bucket_upper_ns(b) <= metrics_bucket_upper_ns(b - 1)) {
+            fprintf(stderr, "Bucket bounds are not increasing at %zu\n", b);
+            return 1;
+        }
+    }
+
+    // -----------------------------
+    // Library hooks: encryption, compression and connections
+    // -----------------------------
+    printf("\n---- Testing library hooks ----\n");
+    metrics_reset();
+    unsigned char key[32];
+    memset(key, 0x42, sizeof(key));
+    SecureCipher* cipher = NULL;
+    if (cipher_create(key, sizeof(key), &cipher) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "cipher_create failed\n");
+        return 1;
+    }
+    const char* message = "metrics round trip";
+    unsigned char iv[12], tag[16], ciphertext[64], plaintext[64];
+    int ciphertext_len = 0, plaintext_len = 0;
+    int message_len = (int)strlen(message);
+    if (cipher_encrypt(cipher, (const unsigned char*)message, message_len, iv, ciphertext, &ciphertext_len, tag) !=
+            SECURE_COMM_SUCCESS ||
+        cipher_decrypt(cipher, ciphertext, ciphertext_len, iv, plaintext, &plaintext_len, tag) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "Cipher round trip failed\n");
+        return 1;
+    }
+    tag[0] ^= 1;
+    if (cipher_decrypt(cipher, ciphertext, ciphertext_len, iv, plaintext, &plaintext_len, tag) == SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "Tampered record was accepted\n");
+        return 1;
+    }
+    cipher_destroy(cipher);
+
+    unsigned char input[4096], compressed[4096 + 64];
+    memset(input, 'a', sizeof(input));
+    size_t compressed_len = sizeof(compressed);
+    if (compress_data(input, sizeof(input), compressed, &compressed_len, 6) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "compress_data failed\n");
+        return 1;
+    }
+
+    int pair[2];
+    SecureCommError err;
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0) {
+        perror("socketpair");
+        return 1;
+    }
+    SecureConnection* left = connection_wrap_socket(pair[0], &err);
+    SecureConnection* right = connection_wrap_socket(pair[1], &err);
+    ssize_t moved = 0;
+    char buffer[32];
+    if (left == NULL || right == NULL || secure_send(left, "0123456789", 10, &moved) != SECURE_COMM_SUCCESS ||
+        secure_recv(right, buffer, sizeof(buffer), &moved) != SECURE_COMM_SUCCESS || moved != 10) {
+        fprintf(stderr, "Connection round trip failed\n");
+        return 1;
+    }
+    ConnectionStats left_stats, right_stats;
+    connection_get_stats(left, &left_stats);
+    connection_get_stats(right, &right_stats);
+    close_connection(left);
+    close_connection(right);
+
+    metrics_snapshot(&snap);
+    const MetricsStageSnapshot* enc = &snap.stages[METRIC_STAGE_ENCRYPT];
+    const MetricsStageSnapshot* dec = &snap.stages[METRIC_STAGE_DECRYPT];
+    const MetricsStageSnapshot* comp = &snap.stages[METRIC_STAGE_COMPRESS];
+    if (enc->operations != 1 || enc->bytes_in != (uint64_t)message_len ||
+        dec->operations != 2 || dec->failures != 1 ||
+        comp->operations != 1 || comp->bytes_in != sizeof(input) || comp->bytes_out != compressed_len) {
+        fprintf(stderr, "Encryption or compression hooks recorded the wrong totals\n");
+        return 1;
+    }
+    if (left_stats.bytes_sent != 10 || left_stats.send_calls != 1 || right_stats.bytes_received != 10 ||
+        right_stats.recv_calls != 1 || snap.counters[METRIC_BYTES_SENT] != 10 ||
+        snap.counters[METRIC_CONNECTIONS_OPENED] != 2 || snap.counters[METRIC_CONNECTIONS_CLOSED] != 2) {
+        fprintf(stderr, "Connection counters are wrong\n");
+        return 1;
+    }
+    printf("encrypt %llu, decrypt %llu (%llu failed), compress %llu -> %llu bytes.\n",
+           (unsigned long long)enc->operations, (unsigned long long)dec->operations,
+           (unsigned long long)dec->failures, (unsigned long long)comp->bytes_in,
+           (unsigned long long)comp->bytes_out);
+
+    // -----------------------------
+    // Prometheus text and the HTTP endpoint
+    // -----------------------------
+    printf("\n---- Testing Prometheus endpoint ----\n");
+    MetricsEndpoint* endpoint = NULL;
+    if (metrics_endpoint_start(NULL, 0, &endpoint) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "metrics_endpoint_start failed\n");
+        return 1;
+    }
+    int port = metrics_endpoint_port(endpoint);
+
+    size_t reply_size = 256 * 1024;
+    char* reply = (char*)malloc(reply_size);
+    if (reply == NULL || http_get(port, "/metrics", reply, reply_size) != 0 ||
+        strncmp(reply, "HTTP/1.0 200 OK", 15) != 0 ||
+        strstr(reply, "secure_comm_stage_failures_total{stage=\"decrypt\"} 1\n") == NULL ||
+        strstr(reply, "secure_comm_connections_opened_total 2\n") == NULL ||
+        strstr(reply, "secure_comm_stage_duration_seconds_bucket{stage=\"encrypt\",le=\"+Inf\"} 1\n") == NULL) {
+        fprintf(stderr, "GET /metrics did not return the expected text:\n%.600s\n", reply ? reply : "");
+        return 1;
+    }
+    size_t body_len = strlen(strstr(reply, "\r\n\r\n") + 4);
+    if (http_get(port, "/other", reply, reply_size) != 0 || strncmp(reply, "HTTP/1.0 404", 12) != 0) {
+        fprintf(stderr, "GET /other was not rejected\n");
+        return 1;
+    }
+    free(reply);
+    metrics_endpoint_stop(endpoint);
+    printf("Endpoint on port %d served %zu bytes of metrics.\n", port, body_len);
+
+    printf("Metrics tests successful.\n");
+    return 0;
+}
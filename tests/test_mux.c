@@ -0,0 +1,325 @@
+// test_mux.c
+
+#include "secure_comm.h"
+
+#include <stdio.h>      // For printf, fprintf
+#include <stdlib.h>     // For malloc, free
+#include <string.h>     // For memcmp, memset
+#include <pthread.h>    // For the client and server threads
+
+#define RPC_COUNT 16
+#define BULK_SIZE (1024 * 1024)
+
+typedef struct {
+    MuxConnection* mux;
+    int index;
+    int failed;
+} rpc_t;
+
+/**
+ * @brief Reads a stream to its end into a buffer of capacity bytes.
+ *
+ * @return Bytes read, or -1 if the stream failed or overflowed the buffer.
+ */
+static long read_all(MuxStream* stream, unsigned char* buffer, size_t capacity) {
+    size_t total = 0;
+    for (;;) {
+        size_t n = 0;
+        SecureCommError ret = mux_stream_read(stream, buffer + total, capacity - total, -1, &n);
+        if (ret == SECURE_COMM_ERR_RECV) {
+            return (long)total;
+        }
+        if (ret != SECURE_COMM_SUCCESS) {
+            return -1;
+        }
+        total += n;
+        if (total == capacity) {
+            // Full: only the end of the stream may follow
+            unsigned char extra;
+            return mux_stream_read(stream, &extra, 1, -1, &n) == SECURE_COMM_ERR_RECV ? (long)total : -1;
+        }
+    }
+}
+
+/**
+ * @brief Request sizes vary from a few bytes to several windows.
+ */
+static size_t request_size(int index) {
+    return index % 4 == 0 ? (size_t)(600 * 1024 + index) : (size_t)(37 * index + 5);
+}
+
+static void fill_request(unsigned char* data, size_t len, int index) {
+    for (size_t i = 0; i < len; i++) {
+        data[i] = (unsigned char)(i * 31 + index);
+    }
+}
+
+/**
+ * @brief Server side of one stream: reads the request and answers with its bytes inverted.
+ */
+static void* serve_stream(void* arg) {
+    MuxStream* stream = (MuxStream*)arg;
+    unsigned char* request = (unsigned char*)malloc(BULK_SIZE);
+    long len = request != NULL ? read_all(stream, request, BULK_SIZE) : -1;
+    if (len >= 0) {
+        for (long i = 0; i < len; i++) {
+            request[i] = (unsigned char)~request[i];
+        }
+        mux_stream_write(stream, request, (size_t)len);
+        mux_stream_close(stream);
+    } else {
+        mux_stream_reset(stream);
+    }
+    mux_stream_release(stream);
+    free(request);
+    return NULL;
+}
+
+/**
+ * @brief Client side of one RPC on its own stream.
+ */
+static void* run_rpc(void* arg) {
+    rpc_t* rpc = (rpc_t*)arg;
+    size_t len = request_size(rpc->index);
+    unsigned char* request = (unsigned char*)malloc(len);
+    unsigned char* response = (unsigned char*)malloc(len + 1);
+    MuxStream* stream = NULL;
+    rpc->failed = 1;
+    if (request == NULL || response == NULL ||
+        mux_stream_open(rpc->mux, MUX_PRIORITY_DEFAULT, &stream) != SECURE_COMM_SUCCESS) {
+        free(request);
+        free(response);
+        return NULL;
+    }
+
+    fill_request(request, len, rpc->index);
+    if (mux_stream_write(stream, request, len) == SECURE_COMM_SUCCESS &&
+        mux_stream_close(stream) == SECURE_COMM_SUCCESS &&
+        read_all(stream, response, len + 1) == (long)len) {
+        rpc->failed = 0;
+        for (size_t i = 0; i < len; i++) {
+            if (response[i] != (unsigned char)~request[i]) {
+                rpc->failed = 1;
+                break;
+            }
+        }
+    }
+    mux_stream_release(stream);
+    free(request);
+    free(response);
+    return NULL;
+}
+
+// Stream left unread by the server while other RPCs go ahead
+typedef struct {
+    MuxStream* stream;
+    SecureCommError result;
+} bulk_t;
+
+static void* write_bulk(void* arg) {
+    bulk_t* bulk = (bulk_t*)arg;
+    unsigned char* data = (unsigned char*)malloc(BULK_SIZE);
+    if (data == NULL) {
+        bulk->result = SECURE_COMM_ERR_MEMORY;
+        return NULL;
+    }
+    fill_request(data, BULK_SIZE, 99);
+    bulk->result = mux_stream_write(bulk->stream, data, BULK_SIZE);
+    if (bulk->result == SECURE_COMM_SUCCESS) {
+        bulk->result = mux_stream_close(bulk->stream);
+    }
+    free(data);
+    return NULL;
+}
+
+int main() {
+    const unsigned char key[32] = "0123456789abcdef0123456789abcdef";
+    const unsigned char client_salt[SECURE_NONCE_SALT_SIZE] = {0x00, 0x01, 0x02, 0x03};
+    const unsigned char server_salt[SECURE_NONCE_SALT_SIZE] = {0x80, 0x01, 0x02, 0x03};
+
+    int pair[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0) {
+        perror("socketpair");
+        return 1;
+    }
+    SecureCommError err;
+    SecureConnection* client_conn = connection_wrap_socket(pair[0], &err);
+    SecureConnection* server_conn = connection_wrap_socket(pair[1], &err);
+
+    SecureCipher* client_seal = NULL;
+    SecureCipher* client_open = NULL;
+    SecureCipher* server_seal = NULL;
+    SecureCipher* server_open = NULL;
+    if (client_conn == NULL || server_conn == NULL ||
+        cipher_create(key, sizeof(key), &client_seal) != SECURE_COMM_SUCCESS ||
+        cipher_use_counter_nonces(client_seal, client_salt) != SECURE_COMM_SUCCESS ||
+        cipher_create(key, sizeof(key), &server_seal) != SECURE_COMM_SUCCESS ||
+        cipher_use_counter_nonces(server_seal, server_salt) != SECURE_COMM_SUCCESS ||
+        cipher_create(key, sizeof(key), &client_open) != SECURE_COMM_SUCCESS ||
+        cipher_create(key, sizeof(key), &server_open) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "Failed to set up the connection and ciphers\n");
+        return 1;
+    }
+
+    ReplayWindow client_replay, server_replay;
+    replay_window_init(&client_replay);
+    replay_window_init(&server_replay);
+
+    MuxConfig config;
+    mux_config_defaults(&config);
+    config.initial_window = 64 * 1024; // Small, so large requests need several window updates
+    config.max_streams = RPC_COUNT + 2;
+
+    MuxConnection* client = NULL;
+    MuxConnection* server = NULL;
+    if (mux_create(client_conn, client_seal, client_open, &client_replay, 1, &config, &client) != SECURE_COMM_SUCCESS ||
+        mux_create(server_conn, server_seal, server_open, &server_replay, 0, &config, &server) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "mux_create failed\n");
+        return 1;
+    }
+
+    // -----------------------------
+    // Concurrent RPCs, each on its own stream of the one connection
+    // -----------------------------
+    printf("---- Testing concurrent streams ----\n");
+    pthread_t clients[RPC_COUNT];
+    pthread_t handlers[RPC_COUNT];
+    rpc_t rpcs[RPC_COUNT];
+    for (int i = 0; i < RPC_COUNT; i++) {
+        rpcs[i].mux = client;
+        rpcs[i].index = i;
+        pthread_create(&clients[i], NULL, run_rpc, &rpcs[i]);
+    }
+    for (int i = 0; i < RPC_COUNT; i++) {
+        MuxStream* stream = NULL;
+        if (mux_accept(server, 5000, &stream) != SECURE_COMM_SUCCESS || mux_stream_id(stream) % 2 != 1) {
+            fprintf(stderr, "mux_accept did not deliver stream %d\n", i);
+            return 1;
+        }
+        pthread_create(&handlers[i], NULL, serve_stream, stream);
+    }
+    int failures = 0;
+    for (int i = 0; i < RPC_COUNT; i++) {
+        pthread_join(clients[i], NULL);
+        pthread_join(handlers[i], NULL);
+        failures += rpcs[i].failed;
+    }
+    MuxStats stats;
+    mux_get_stats(client, &stats);
+    if (failures != 0 || stats.streams_opened != RPC_COUNT || stats.window_updates == 0) {
+        fprintf(stderr, "%d RPCs failed; %llu streams opened, %llu window updates\n", failures,
+                (unsigned long long)stats.streams_opened, (unsigned long long)stats.window_updates);
+        return 1;
+    }
+    printf("%d RPCs completed over one connection, %llu window updates sent.\n", RPC_COUNT,
+           (unsigned long long)stats.window_updates);
+
+    // -----------------------------
+    // A stream nobody reads stalls on its own window only
+    // -----------------------------
+    printf("\n---- Testing per-stream flow control ----\n");
+    bulk_t bulk = { NULL, SECURE_COMM_SUCCESS };
+    if (mux_stream_open(client, 200, &bulk.stream) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "mux_stream_open failed\n");
+        return 1;
+    }
+    pthread_t bulk_writer;
+    pthread_create(&bulk_writer, NULL, write_bulk, &bulk);
+
+    MuxStream* stalled = NULL;
+    if (mux_accept(server, 5000, &stalled) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "The bulk stream did not arrive\n");
+        return 1;
+    }
+
+    // The bulk writer is now blocked on its window; another RPC still goes through
+    rpc_t quick = { client, 5, 1 };
+    pthread_t quick_client;
+    pthread_create(&quick_client, NULL, run_rpc, &quick);
+    MuxStream* quick_stream = NULL;
+    if (mux_accept(server, 5000, &quick_stream) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "The RPC behind the stalled stream did not arrive\n");
+        return 1;
+    }
+    serve_stream(quick_stream);
+    pthread_join(quick_client, NULL);
+    if (quick.failed) {
+        fprintf(stderr, "The RPC behind the stalled stream failed\n");
+        return 1;
+    }
+
+    unsigned char* bulk_in = (unsigned char*)malloc(BULK_SIZE);
+    unsigned char* bulk_expected = (unsigned char*)malloc(BULK_SIZE);
+    if (bulk_in == NULL || bulk_expected == NULL) {
+        fprintf(stderr, "Failed to allocate the bulk buffers\n");
+        return 1;
+    }
+    fill_request(bulk_expected, BULK_SIZE, 99);
+    long bulk_len = read_all(stalled, bulk_in, BULK_SIZE);
+    pthread_join(bulk_writer, NULL);
+    if (bulk.result != SECURE_COMM_SUCCESS || bulk_len != BULK_SIZE || memcmp(bulk_in, bulk_expected, BULK_SIZE) != 0) {
+        fprintf(stderr, "The bulk stream was not delivered intact\n");
+        return 1;
+    }
+    mux_stream_release(stalled);
+    mux_stream_release(bulk.stream);
+    free(bulk_in);
+    free(bulk_expected);
+    printf("An RPC completed while a 1 MB stream waited on its %u-byte window.\n", config.initial_window);
+
+    // -----------------------------
+    // Resets reach the other side
+    // -----------------------------
+    printf("\n---- Testing stream reset ----\n");
+    MuxStream* doomed = NULL;
+    MuxStream* doomed_peer = NULL;
+    unsigned char byte = 1;
+    size_t n = 0;
+    if (mux_stream_open(client, 0, &doomed) != SECURE_COMM_SUCCESS ||
+        mux_stream_write(doomed, &byte, 1) != SECURE_COMM_SUCCESS ||
+        mux_accept(server, 5000, &doomed_peer) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "Failed to open the stream to reset\n");
+        return 1;
+    }
+    if (mux_stream_read(doomed_peer, &byte, 1, 5000, &n) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "The byte before the reset was lost\n");
+        return 1;
+    }
+    mux_stream_reset(doomed);
+    if (mux_stream_read(doomed_peer, &byte, 1, 5000, &n) != SECURE_COMM_ERR_SESSION ||
+        mux_stream_write(doomed, &byte, 1) != SECURE_COMM_ERR_SEND ||
+        mux_stream_read(doomed, &byte, 1, 0, &n) != SECURE_COMM_ERR_SESSION) {
+        fprintf(stderr, "The reset was not reported on both sides\n");
+        return 1;
+    }
+    mux_stream_release(doomed);
+    mux_stream_release(doomed_peer);
+
+    // Timeouts return without data
+    if (mux_accept(server, 10, &doomed_peer) != SECURE_COMM_ERR_AGAIN) {
+        fprintf(stderr, "mux_accept did not time out\n");
+        return 1;
+    }
+    printf("Reset reported to reader and writer.\n");
+
+    mux_get_stats(server, &stats);
+    printf("Server: %llu streams accepted, %llu frames in, %llu frames out, %llu resets received.\n",
+           (unsigned long long)stats.streams_accepted, (unsigned long long)stats.frames_received,
+           (unsigned long long)stats.frames_sent, (unsigned long long)stats.resets_received);
+    if (stats.streams_accepted != RPC_COUNT + 3 || stats.resets_received != 1 || stats.active_streams != 0) {
+        fprintf(stderr, "Unexpected server counters\n");
+        return 1;
+    }
+
+    mux_destroy(client);
+    mux_destroy(server);
+    close_connection(client_conn);
+    close_connection(server_conn);
+    cipher_destroy(client_seal);
+    cipher_destroy(client_open);
+    cipher_destroy(server_seal);
+    cipher_destroy(server_open);
+
+    printf("Multiplexing tests successful.\n");
+    return 0;
+}
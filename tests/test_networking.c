@@ -0,0 +1,823 @@
+// test_networking.c
+
+#include "secure_comm.h"
+
+#include <stdio.h>      // For printf, fprintf
+#include <stdlib.h>     // For mkstemp
+#include <string.h>     // For memcmp, memset
+#include <pthread.h>    // For the TLS server thread
+#include <time.h>       // For nanosleep and the connect timer
+#include <fcntl.h>      // For reopening the test file
+
+#include <openssl/pem.h>
+#include <openssl/x509.h>
+
+#define TEST_CONNECTIONS 3
+#define FILE_SIZE (3 * 1024 * 1024 + 777)
+#define POOL_SERVER_CONNECTIONS 8
+
+static char cert_path[] = "/tmp/test_networking_certXXXXXX";
+static char key_path[] = "/tmp/test_networking_keyXXXXXX";
+static char file_path[] = "/tmp/test_networking_fileXXXXXX";
+
+/**
+ * @brief Writes a throwaway self-signed EC certificate and key for the TLS server.
+ */
+static int write_self_signed(void) {
+    EVP_PKEY* key = EVP_PKEY_Q_keygen(NULL, NULL, "EC", "P-256");
+    X509* cert = X509_new();
+    if (key == NULL || cert == NULL) {
+        return -1;
+    }
+
+    ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+    X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+    X509_gmtime_adj(X509_getm_notAfter(cert), 3600);
+    X509_set_pubkey(cert, key);
+    X509_NAME* name = X509_get_subject_name(cert);
+    X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char*)"localhost", -1, -1, 0);
+    X509_set_issuer_name(cert, name);
+    X509_sign(cert, key, EVP_sha256());
+
+    int cert_fd = mkstemp(cert_path);
+    int key_fd = mkstemp(key_path);
+    FILE* cert_file = cert_fd >= 0 ? fdopen(cert_fd, "w") : NULL;
+    FILE* key_file = key_fd >= 0 ? fdopen(key_fd, "w") : NULL;
+    int ok = cert_file && key_file &&
+             PEM_write_X509(cert_file, cert) &&
+             PEM_write_PrivateKey(key_file, key, NULL, NULL, 0, NULL, NULL);
+    if (cert_file) fclose(cert_file);
+    if (key_file) fclose(key_file);
+
+    X509_free(cert);
+    EVP_PKEY_free(key);
+    return ok ? 0 : -1;
+}
+
+/**
+ * @brief Receives exactly len bytes, however the peer's writes were split.
+ */
+static int recv_exact(SecureConnection* conn, unsigned char* buffer, size_t len) {
+    size_t got = 0;
+    while (got < len) {
+        ssize_t n = 0;
+        if (secure_recv(conn, buffer + got, len - got, &n) != SECURE_COMM_SUCCESS) {
+            return -1;
+        }
+        got += (size_t)n;
+    }
+    return 0;
+}
+
+/**
+ * @brief Accepts TEST_CONNECTIONS TLS clients and echoes one 64-byte message on each.
+ */
+static void* tls_server(void* arg) {
+    int listen_fd = *(int*)arg;
+    for (int i = 0; i < TEST_CONNECTIONS; i++) {
+        int fd = accept(listen_fd, NULL, NULL);
+        SecureCommError err;
+        SecureConnection* conn = secure_accept(fd, &err);
+        if (conn == NULL) {
+            close(fd);
+            continue;
+        }
+        unsigned char message[64];
+        ssize_t sent = 0;
+        if (recv_exact(conn, message, sizeof(message)) == 0) {
+            secure_send(conn, message, sizeof(message), &sent);
+        }
+
+        // Wait for the client to close so its session ticket is processed first
+        secure_recv(conn, message, sizeof(message), &sent);
+        close_connection(conn);
+    }
+    return NULL;
+}
+
+// Receiving side of a secure_send_file test
+typedef struct {
+    SecureConnection* conn;
+    SecureCipher* cipher;       // Non-NULL: read a pipeline stream instead of raw bytes
+    unsigned char* data;
+    size_t expected;
+    size_t len;
+    int ended;
+    int failed;
+} file_sink_t;
+
+static SecureCommError collect_file(const unsigned char* data, size_t len, int end_of_stream, void* user_data) {
+    file_sink_t* sink = (file_sink_t*)user_data;
+    if (end_of_stream) {
+        sink->ended = 1;
+        return SECURE_COMM_SUCCESS;
+    }
+    if (sink->len + len > sink->expected) {
+        return SECURE_COMM_ERR_MEMORY;
+    }
+    memcpy(sink->data + sink->len, data, len);
+    sink->len += len;
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Receives one file: expected raw bytes, or a pipeline stream up to its end record.
+ */
+static void* file_receiver(void* arg) {
+    file_sink_t* sink = (file_sink_t*)arg;
+    if (sink->cipher == NULL) {
+        sink->failed = recv_exact(sink->conn, sink->data, sink->expected) != 0;
+        sink->len = sink->failed ? 0 : sink->expected;
+        return NULL;
+    }
+
+    PipelineReader* reader = NULL;
+    FrameDecoder* dec = NULL;
+    unsigned char* record = (unsigned char*)malloc(SECURE_RECORD_OVERHEAD + SECURE_PIPELINE_DEFAULT_RECORD_SIZE);
+    if (record == NULL ||
+        pipeline_reader_create(sink->cipher, NULL, 0, collect_file, sink, &reader) != SECURE_COMM_SUCCESS ||
+        frame_decoder_create(0, SECURE_RECORD_OVERHEAD + SECURE_PIPELINE_DEFAULT_RECORD_SIZE, &dec) != SECURE_COMM_SUCCESS) {
+        sink->failed = 1;
+        return NULL;
+    }
+    while (!sink->ended && !sink->failed) {
+        unsigned char* space = NULL;
+        size_t space_len = 0;
+        ssize_t n = 0;
+        frame_decoder_write_space(dec, &space, &space_len);
+        if (secure_recv(sink->conn, space, space_len, &n) != SECURE_COMM_SUCCESS) {
+            sink->failed = 1;
+            break;
+        }
+        frame_decoder_commit(dec, (size_t)n);
+
+        FrameHeader header;
+        SecureCommError ret;
+        while ((ret = frame_decoder_next(dec, &header, record, SECURE_RECORD_OVERHEAD + SECURE_PIPELINE_DEFAULT_RECORD_SIZE)) == SECURE_COMM_SUCCESS) {
+            if (pipeline_reader_push(reader, &header, record, header.length) != SECURE_COMM_SUCCESS) {
+                sink->failed = 1;
+                break;
+            }
+        }
+        if (ret != SECURE_COMM_ERR_AGAIN && ret != SECURE_COMM_SUCCESS) {
+            sink->failed = 1;
+        }
+    }
+    frame_decoder_destroy(dec);
+    pipeline_reader_destroy(reader);
+    free(record);
+    return NULL;
+}
+
+/**
+ * @brief Sends a file range on one end of a connection and checks what the other end receives.
+ */
+static int check_file_transfer(SecureConnection* from, SecureConnection* to, const unsigned char* contents,
+                               const SecureFileSendOptions* options, SecureCipher* opener, const char* label) {
+    size_t expected = options->length ? (size_t)options->length : FILE_SIZE - (size_t)options->offset;
+    file_sink_t sink = { to, opener, (unsigned char*)malloc(expected + 1), expected, 0, 0, 0 };
+    if (sink.data == NULL) {
+        return -1;
+    }
+
+    pthread_t receiver;
+    pthread_create(&receiver, NULL, file_receiver, &sink);
+    uint64_t sent = 0;
+    SecureCommError ret = secure_send_file(from, file_path, options, &sent);
+    pthread_join(receiver, NULL);
+
+    int ok = ret == SECURE_COMM_SUCCESS && sent == expected && !sink.failed && sink.len == expected &&
+             (opener == NULL || sink.ended) && memcmp(sink.data, contents + options->offset, expected) == 0;
+    free(sink.data);
+    if (!ok) {
+        fprintf(stderr, "secure_send_file (%s) failed: error %d, %llu of %zu bytes\n", label, ret,
+                (unsigned long long)sent, expected);
+        return -1;
+    }
+    printf("test_networking: secure_send_file (%s) delivered %zu bytes.\n", label, expected);
+    return 0;
+}
+
+typedef struct {
+    int listen_fd;
+    file_sink_t sink;
+} tls_file_job_t;
+
+/**
+ * @brief Accepts one TLS client and reads a whole file from it.
+ */
+static void* tls_file_server(void* arg) {
+    tls_file_job_t* job = (tls_file_job_t*)arg;
+    file_sink_t* sink = &job->sink;
+    int fd = accept(job->listen_fd, NULL, NULL);
+    SecureCommError err;
+    SecureConnection* conn = secure_accept(fd, &err);
+    if (conn == NULL) {
+        close(fd);
+        sink->failed = 1;
+        return NULL;
+    }
+    sink->failed = recv_exact(conn, sink->data, sink->expected) != 0;
+    unsigned char ack = 1;
+    ssize_t sent = 0;
+    secure_send(conn, &ack, 1, &sent);
+    close_connection(conn);
+    return NULL;
+}
+
+// Plain echo server behind the connection pool tests
+typedef struct {
+    int listen_fd;
+    int fds[POOL_SERVER_CONNECTIONS];
+    pthread_t threads[POOL_SERVER_CONNECTIONS];
+    int count;
+} pool_server_t;
+
+/**
+ * @brief Echoes 4-byte messages until the client closes, or closes itself on "quit".
+ */
+static void* pool_echo(void* arg) {
+    int fd = *(int*)arg;
+    unsigned char message[4];
+    while (1) {
+        size_t got = 0;
+        while (got < sizeof(message)) {
+            ssize_t n = recv(fd, message + got, sizeof(message) - got, 0);
+            if (n <= 0) {
+                return NULL;
+            }
+            got += (size_t)n;
+        }
+        if (memcmp(message, "quit", 4) == 0) {
+            shutdown(fd, SHUT_RDWR);
+            return NULL;
+        }
+        if (send(fd, message, sizeof(message), MSG_NOSIGNAL) != (ssize_t)sizeof(message)) {
+            return NULL;
+        }
+    }
+}
+
+/**
+ * @brief Accepts clients, one echo thread each, until the listening socket is shut down.
+ */
+static void* pool_server(void* arg) {
+    pool_server_t* server = (pool_server_t*)arg;
+    while (server->count < POOL_SERVER_CONNECTIONS) {
+        int fd = accept(server->listen_fd, NULL, NULL);
+        if (fd < 0) {
+            break;
+        }
+        server->fds[server->count] = fd;
+        pthread_create(&server->threads[server->count], NULL, pool_echo, &server->fds[server->count]);
+        server->count++;
+    }
+    for (int i = 0; i < server->count; i++) {
+        pthread_join(server->threads[i], NULL);
+        close(server->fds[i]);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Sends a 4-byte message and expects it back.
+ */
+static SecureCommError echo_message(SecureConnection* conn, const char* message) {
+    unsigned char echo[4];
+    ssize_t sent = 0;
+    if (secure_send(conn, message, 4, &sent) != SECURE_COMM_SUCCESS ||
+        recv_exact(conn, echo, sizeof(echo)) != 0 || memcmp(echo, message, 4) != 0) {
+        return SECURE_COMM_ERR_RECV;
+    }
+    return SECURE_COMM_SUCCESS;
+}
+
+static SecureCommError ping_echo(SecureConnection* conn, void* user_data) {
+    (void)user_data;
+    return echo_message(conn, "ping");
+}
+
+static void sleep_ms(long ms) {
+    struct timespec ts = { ms / 1000, (ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+/**
+ * @brief Blocks in secure_recv until the connection is shut down.
+ */
+static void* blocked_reader(void* arg) {
+    SecureConnection* conn = (SecureConnection*)arg;
+    unsigned char byte;
+    ssize_t n = 0;
+    static SecureCommError result;
+    result = secure_recv(conn, &byte, 1, &n);
+    return &result;
+}
+
+/**
+ * @brief Reads and discards until the connection is closed.
+ */
+static void* discard_reader(void* arg) {
+    SecureConnection* conn = (SecureConnection*)arg;
+    unsigned char chunk[16 * 1024];
+    ssize_t n = 0;
+    while (secure_recv(conn, chunk, sizeof(chunk), &n) == SECURE_COMM_SUCCESS) {
+    }
+    return NULL;
+}
+
+// A buffered send whose file is truncated under it
+typedef struct {
+    SecureConnection* conn;
+    SecureFileSendOptions options;
+    SecureCommError result;
+    uint64_t sent;
+} truncated_send_t;
+
+static void* truncated_sender(void* arg) {
+    truncated_send_t* job = (truncated_send_t*)arg;
+    job->result = secure_send_file(job->conn, file_path, &job->options, &job->sent);
+    return NULL;
+}
+
+int main() {
+    if (init_networking() != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "init_networking failed\n");
+        return 1;
+    }
+
+    // -----------------------------
+    // Plain connections: gathered writes and scattered reads
+    // -----------------------------
+    int pair[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0) {
+        perror("socketpair");
+        return 1;
+    }
+    SecureCommError err;
+    SecureConnection* left = connection_wrap_socket(pair[0], &err);
+    SecureConnection* right = connection_wrap_socket(pair[1], &err);
+    if (left == NULL || right == NULL) {
+        fprintf(stderr, "connection_wrap_socket failed\n");
+        return 1;
+    }
+
+    unsigned char header[SECURE_FRAME_HEADER_SIZE] = "HEADER!";
+    unsigned char iv[12], tag[16], body[3000];
+    memset(iv, 0x11, sizeof(iv));
+    memset(tag, 0x22, sizeof(tag));
+    for (size_t i = 0; i < sizeof(body); i++) {
+        body[i] = (unsigned char)(i * 7);
+    }
+    struct iovec out[4] = {
+        { header, sizeof(header) }, { iv, sizeof(iv) }, { tag, sizeof(tag) }, { body, sizeof(body) }
+    };
+    size_t total = sizeof(header) + sizeof(iv) + sizeof(tag) + sizeof(body);
+
+    size_t sent = 0;
+    if (secure_sendv(left, out, 4, &sent) != SECURE_COMM_SUCCESS || sent != total) {
+        fprintf(stderr, "secure_sendv failed on a plain connection\n");
+        return 1;
+    }
+
+    // Split the stream differently on the way in
+    unsigned char in_head[SECURE_FRAME_HEADER_SIZE + 28];
+    unsigned char in_body[sizeof(body)];
+    size_t received = 0;
+    while (received < total) {
+        struct iovec in[2];
+        size_t offset = received;
+        int count = 0;
+        if (offset < sizeof(in_head)) {
+            in[count].iov_base = in_head + offset;
+            in[count++].iov_len = sizeof(in_head) - offset;
+            offset = 0;
+        } else {
+            offset -= sizeof(in_head);
+        }
+        in[count].iov_base = in_body + offset;
+        in[count++].iov_len = sizeof(in_body) - offset;
+
+        size_t n = 0;
+        if (secure_recvv(right, in, count, &n) != SECURE_COMM_SUCCESS) {
+            fprintf(stderr, "secure_recvv failed on a plain connection\n");
+            return 1;
+        }
+        received += n;
+    }
+    if (memcmp(in_head, header, sizeof(header)) != 0 || memcmp(in_head + sizeof(header), iv, sizeof(iv)) != 0 ||
+        memcmp(in_head + sizeof(header) + sizeof(iv), tag, sizeof(tag)) != 0 ||
+        memcmp(in_body, body, sizeof(body)) != 0) {
+        fprintf(stderr, "Scattered read does not match the gathered write\n");
+        return 1;
+    }
+    printf("test_networking: Plain sendv/recvv round trip of %zu bytes passed.\n", total);
+
+    // connection_shutdown must wake a reader blocked on the same connection
+    pthread_t reader;
+    pthread_create(&reader, NULL, blocked_reader, right);
+    connection_shutdown(right);
+    void* reader_result = NULL;
+    pthread_join(reader, &reader_result);
+    if (*(SecureCommError*)reader_result != SECURE_COMM_ERR_RECV) {
+        fprintf(stderr, "Blocked reader did not report the shutdown\n");
+        return 1;
+    }
+    close_connection(left);
+    close_connection(right);
+
+    // -----------------------------
+    // secure_send_file: zero-copy, buffered, sealed and resumed transfers
+    // -----------------------------
+    unsigned char* contents = (unsigned char*)malloc(FILE_SIZE);
+    int file_fd = mkstemp(file_path);
+    if (contents == NULL || file_fd < 0) {
+        fprintf(stderr, "Failed to create the test file\n");
+        return 1;
+    }
+    uint32_t state = 99;
+    for (size_t i = 0; i < FILE_SIZE; i++) {
+        state = state * 1103515245u + 12345u;
+        contents[i] = (unsigned char)('a' + ((state >> 16) % 16));
+    }
+    if (write(file_fd, contents, FILE_SIZE) != FILE_SIZE) {
+        fprintf(stderr, "Failed to write the test file\n");
+        return 1;
+    }
+    close(file_fd);
+
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0) {
+        perror("socketpair");
+        return 1;
+    }
+    left = connection_wrap_socket(pair[0], &err);
+    right = connection_wrap_socket(pair[1], &err);
+
+    const unsigned char file_key[32] = "0123456789abcdef0123456789abcdef";
+    const unsigned char file_salt[SECURE_NONCE_SALT_SIZE] = {0x80, 0x01, 0x02, 0x03};
+    SecureCipher* sealer = NULL;
+    SecureCipher* opener = NULL;
+    if (left == NULL || right == NULL ||
+        cipher_create(file_key, sizeof(file_key), &sealer) != SECURE_COMM_SUCCESS ||
+        cipher_use_counter_nonces(sealer, file_salt) != SECURE_COMM_SUCCESS ||
+        cipher_create(file_key, sizeof(file_key), &opener) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "Failed to set up the file transfer connection\n");
+        return 1;
+    }
+
+    SecureFileSendOptions file_options;
+    secure_file_send_options_defaults(&file_options);
+    if (check_file_transfer(left, right, contents, &file_options, NULL, "sendfile") != 0) {
+        return 1;
+    }
+
+    // An odd resume offset and small windows exercise the window reads
+    file_options.offset = 4097;
+    file_options.length = FILE_SIZE - 4097 - 100;
+    file_options.window_size = 256 * 1024;
+    file_options.zero_copy = 0;
+    if (check_file_transfer(left, right, contents, &file_options, NULL, "buffered") != 0) {
+        return 1;
+    }
+
+    file_options.cipher = sealer;
+    file_options.length = 0;
+    if (check_file_transfer(left, right, contents, &file_options, opener, "pipeline, resumed") != 0) {
+        return 1;
+    }
+
+    // A file truncated mid-send fails the transfer instead of faulting on a vanished page.
+    // The sealed path reads each window in userspace, where a mapping would take SIGBUS.
+    // Nothing reads until the sender has stalled on the socket, and the file shrinks meanwhile.
+    truncated_send_t truncated = { left, file_options, SECURE_COMM_SUCCESS, 0 };
+    truncated.options.cipher = sealer;
+    truncated.options.offset = 0;
+    truncated.options.window_size = 64 * 1024;
+    pthread_t truncated_thread, drain_thread;
+    pthread_create(&truncated_thread, NULL, truncated_sender, &truncated);
+    sleep_ms(100);
+    if (truncate(file_path, 128 * 1024) != 0) {
+        perror("truncate");
+        return 1;
+    }
+    pthread_create(&drain_thread, NULL, discard_reader, right);
+    pthread_join(truncated_thread, NULL);
+    if (truncated.result != SECURE_COMM_ERR_SEND || truncated.sent >= FILE_SIZE) {
+        fprintf(stderr, "secure_send_file of a truncated file returned %d after %llu bytes\n",
+                truncated.result, (unsigned long long)truncated.sent);
+        return 1;
+    }
+    printf("test_networking: secure_send_file stopped after %llu bytes of a truncated file.\n",
+           (unsigned long long)truncated.sent);
+    close_connection(left);
+    pthread_join(drain_thread, NULL);
+    close_connection(right);
+    file_fd = open(file_path, O_WRONLY | O_TRUNC);
+    if (file_fd < 0 || write(file_fd, contents, FILE_SIZE) != FILE_SIZE) {
+        fprintf(stderr, "Failed to restore the test file\n");
+        return 1;
+    }
+    close(file_fd);
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0) {
+        perror("socketpair");
+        return 1;
+    }
+    left = connection_wrap_socket(pair[0], &err);
+    right = connection_wrap_socket(pair[1], &err);
+    if (left == NULL || right == NULL) {
+        fprintf(stderr, "Failed to reopen the file transfer connection\n");
+        return 1;
+    }
+
+    // Ranges past the end of the file are refused before anything is sent
+    uint64_t file_sent = 1;
+    file_options.offset = FILE_SIZE + 1;
+    if (secure_send_file(left, file_path, &file_options, &file_sent) == SECURE_COMM_SUCCESS || file_sent != 0) {
+        fprintf(stderr, "secure_send_file accepted a range outside the file\n");
+        return 1;
+    }
+    cipher_destroy(sealer);
+    cipher_destroy(opener);
+    close_connection(left);
+    close_connection(right);
+
+    // -----------------------------
+    // TLS: one shared context, gathered records and session resumption
+    // -----------------------------
+    if (write_self_signed() != 0 || init_server_tls(cert_path, key_path) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "Failed to set up the TLS server context\n");
+        return 1;
+    }
+
+    int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addr_len = sizeof(addr);
+    if (bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(listen_fd, 4) != 0 ||
+        getsockname(listen_fd, (struct sockaddr*)&addr, &addr_len) != 0) {
+        perror("listen");
+        return 1;
+    }
+    int port = ntohs(addr.sin_port);
+
+    pthread_t server;
+    pthread_create(&server, NULL, tls_server, &listen_fd);
+
+    int resumed = 0;
+    for (int i = 0; i < TEST_CONNECTIONS; i++) {
+        SecureConnection* conn = create_connection("127.0.0.1", port, &err);
+        if (conn == NULL) {
+            fprintf(stderr, "create_connection %d failed: %d\n", i, err);
+            return 1;
+        }
+        resumed += connection_session_reused(conn);
+
+        unsigned char part_a[24], part_b[40], echo[64];
+        memset(part_a, 'a' + i, sizeof(part_a));
+        memset(part_b, 'A' + i, sizeof(part_b));
+        struct iovec message[2] = { { part_a, sizeof(part_a) }, { part_b, sizeof(part_b) } };
+        if (secure_sendv(conn, message, 2, &sent) != SECURE_COMM_SUCCESS ||
+            recv_exact(conn, echo, sizeof(echo)) != 0 ||
+            memcmp(echo, part_a, sizeof(part_a)) != 0 || memcmp(echo + sizeof(part_a), part_b, sizeof(part_b)) != 0) {
+            fprintf(stderr, "TLS echo %d failed\n", i);
+            return 1;
+        }
+        close_connection(conn);
+    }
+    pthread_join(server, NULL);
+
+    // Raw file over TLS: SSL_sendfile if the kernel takes the records, SSL_write otherwise
+    networking_set_ktls(1);
+    tls_file_job_t tls_job = { listen_fd, { NULL, NULL, (unsigned char*)malloc(FILE_SIZE), FILE_SIZE, 0, 0, 0 } };
+    file_sink_t* tls_sink = &tls_job.sink;
+    pthread_create(&server, NULL, tls_file_server, &tls_job);
+    SecureConnection* file_conn = create_connection("127.0.0.1", port, &err);
+    if (file_conn == NULL || tls_sink->data == NULL) {
+        fprintf(stderr, "create_connection for the file transfer failed: %d\n", err);
+        return 1;
+    }
+    int ktls = connection_ktls_send(file_conn);
+    secure_file_send_options_defaults(&file_options);
+    uint64_t tls_sent = 0;
+    unsigned char ack = 0;
+    if (secure_send_file(file_conn, file_path, &file_options, &tls_sent) != SECURE_COMM_SUCCESS ||
+        recv_exact(file_conn, &ack, 1) != 0) {
+        fprintf(stderr, "secure_send_file over TLS failed\n");
+        return 1;
+    }
+    pthread_join(server, NULL);
+    if (tls_sink->failed || tls_sent != FILE_SIZE || memcmp(tls_sink->data, contents, FILE_SIZE) != 0) {
+        fprintf(stderr, "File sent over TLS does not match\n");
+        return 1;
+    }
+    printf("test_networking: secure_send_file over TLS (%s) delivered %d bytes.\n",
+           ktls ? "kTLS SSL_sendfile" : "userspace records", FILE_SIZE);
+    close_connection(file_conn);
+    free(tls_sink->data);
+    free(contents);
+    remove(file_path);
+    close(listen_fd);
+
+    // -----------------------------
+    // Connection pool: reuse, health checks, eviction and connect timeouts
+    // -----------------------------
+    pool_server_t pool_listener;
+    memset(&pool_listener, 0, sizeof(pool_listener));
+    pool_listener.listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr_len = sizeof(addr);
+    if (bind(pool_listener.listen_fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+        listen(pool_listener.listen_fd, 8) != 0 ||
+        getsockname(pool_listener.listen_fd, (struct sockaddr*)&addr, &addr_len) != 0) {
+        perror("listen");
+        return 1;
+    }
+    int pool_port = ntohs(addr.sin_port);
+    pthread_t pool_thread;
+    pthread_create(&pool_thread, NULL, pool_server, &pool_listener);
+
+    ConnectionPoolConfig pool_config;
+    connection_pool_config_defaults(&pool_config);
+    pool_config.use_tls = 0;
+    pool_config.max_idle_per_host = 2;
+    pool_config.idle_timeout_ms = 300;
+    pool_config.keepalive_interval_ms = 0;  // Checks run only when connection_pool_maintain is called
+    pool_config.ping = ping_echo;
+    ConnectionPool* pool = NULL;
+    ConnectionPoolStats pool_stats;
+    if (connection_pool_create(&pool_config, &pool) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "connection_pool_create failed\n");
+        return 1;
+    }
+
+    // "localhost" may resolve to ::1 first, where nothing listens; the IPv4 attempt must still win
+    SecureConnection* pooled = NULL;
+    SecureConnection* first_pooled = NULL;
+    if (connection_pool_acquire(pool, "localhost", pool_port, &pooled) != SECURE_COMM_SUCCESS ||
+        echo_message(pooled, "abcd") != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "connection_pool_acquire could not reach localhost\n");
+        return 1;
+    }
+    first_pooled = pooled;
+    connection_pool_release(pool, pooled, 1);
+    if (connection_pool_acquire(pool, "localhost", pool_port, &pooled) != SECURE_COMM_SUCCESS ||
+        pooled != first_pooled || echo_message(pooled, "efgh") != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "The idle connection was not reused\n");
+        return 1;
+    }
+
+    // A connection the server has closed is detected and replaced
+    ssize_t quit_sent = 0;
+    secure_send(pooled, "quit", 4, &quit_sent);
+    for (int i = 0; i < 100 && connection_is_alive(pooled); i++) {
+        sleep_ms(10);
+    }
+    if (connection_is_alive(pooled)) {
+        fprintf(stderr, "connection_is_alive missed the server closing the connection\n");
+        return 1;
+    }
+    connection_pool_release(pool, pooled, 1);
+    if (connection_pool_acquire(pool, "localhost", pool_port, &pooled) != SECURE_COMM_SUCCESS ||
+        echo_message(pooled, "ijkl") != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "The dead connection was handed out again\n");
+        return 1;
+    }
+    connection_pool_stats(pool, &pool_stats);
+    if (pool_stats.connects != 2 || pool_stats.reuses != 1 || pool_stats.evicted_dead != 1) {
+        fprintf(stderr, "Unexpected pool counters: %llu connects, %llu reuses, %llu dead\n",
+                (unsigned long long)pool_stats.connects, (unsigned long long)pool_stats.reuses,
+                (unsigned long long)pool_stats.evicted_dead);
+        return 1;
+    }
+
+    // Idle connections are pinged, then closed once they outlive idle_timeout_ms
+    connection_pool_release(pool, pooled, 1);
+    connection_pool_maintain(pool);
+    connection_pool_stats(pool, &pool_stats);
+    if (pool_stats.pings != 1 || pool_stats.idle != 1) {
+        fprintf(stderr, "The keepalive ping evicted a healthy connection\n");
+        return 1;
+    }
+    sleep_ms(400);
+    connection_pool_maintain(pool);
+    connection_pool_stats(pool, &pool_stats);
+    if (pool_stats.idle != 0 || pool_stats.evicted_idle != 1) {
+        fprintf(stderr, "The expired connection stayed in the pool\n");
+        return 1;
+    }
+
+    // Releases beyond max_idle_per_host are closed
+    SecureConnection* held[3];
+    for (int i = 0; i < 3; i++) {
+        if (connection_pool_acquire(pool, "127.0.0.1", pool_port, &held[i]) != SECURE_COMM_SUCCESS) {
+            fprintf(stderr, "connection_pool_acquire %d failed\n", i);
+            return 1;
+        }
+    }
+    for (int i = 0; i < 3; i++) {
+        connection_pool_release(pool, held[i], 1);
+    }
+    connection_pool_stats(pool, &pool_stats);
+    if (pool_stats.idle != 2 || pool_stats.evicted_idle != 2) {
+        fprintf(stderr, "The pool kept %zu idle connections to one host\n", pool_stats.idle);
+        return 1;
+    }
+    connection_pool_destroy(pool);
+
+    // The maintenance thread pings idle connections on its own
+    pool_config.keepalive_interval_ms = 50;
+    pool_config.idle_timeout_ms = 0;
+    if (connection_pool_create(&pool_config, &pool) != SECURE_COMM_SUCCESS ||
+        connection_pool_acquire(pool, "127.0.0.1", pool_port, &pooled) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "The pool with a maintenance thread failed\n");
+        return 1;
+    }
+    connection_pool_release(pool, pooled, 1);
+    for (int i = 0; i < 100; i++) {
+        connection_pool_stats(pool, &pool_stats);
+        if (pool_stats.pings >= 2) {
+            break;
+        }
+        sleep_ms(20);
+    }
+    if (pool_stats.pings < 2 || pool_stats.idle != 1) {
+        fprintf(stderr, "The maintenance thread did not keep the connection alive\n");
+        return 1;
+    }
+    connection_pool_destroy(pool);
+    shutdown(pool_listener.listen_fd, SHUT_RDWR);
+    pthread_join(pool_thread, NULL);
+    close(pool_listener.listen_fd);
+
+    // A listener whose accept queue is full never answers, so the connect gives up at the timeout
+    int full_fd = socket(AF_INET, SOCK_STREAM, 0);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr_len = sizeof(addr);
+    if (bind(full_fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(full_fd, 0) != 0 ||
+        getsockname(full_fd, (struct sockaddr*)&addr, &addr_len) != 0) {
+        perror("listen");
+        return 1;
+    }
+    networking_set_connect_timeout(300);
+    SecureConnection* queued = create_plain_connection("127.0.0.1", ntohs(addr.sin_port), &err);
+    struct timespec connect_start, connect_end;
+    clock_gettime(CLOCK_MONOTONIC, &connect_start);
+    SecureConnection* unanswered = create_plain_connection("127.0.0.1", ntohs(addr.sin_port), &err);
+    clock_gettime(CLOCK_MONOTONIC, &connect_end);
+    networking_set_connect_timeout(SECURE_CONNECT_DEFAULT_TIMEOUT_MS);
+    long connect_ms = (connect_end.tv_sec - connect_start.tv_sec) * 1000L +
+                      (connect_end.tv_nsec - connect_start.tv_nsec) / 1000000L;
+    if (queued == NULL || unanswered != NULL || err != SECURE_COMM_ERR_TIMEOUT || connect_ms < 250 || connect_ms > 2000) {
+        fprintf(stderr, "The unanswered connect returned after %ld ms\n", connect_ms);
+        return 1;
+    }
+    close_connection(queued);
+    close(full_fd);
+
+    // A peer that accepts TCP but never answers the ClientHello times out in the handshake
+    int silent_fd = socket(AF_INET, SOCK_STREAM, 0);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr_len = sizeof(addr);
+    if (bind(silent_fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(silent_fd, 4) != 0 ||
+        getsockname(silent_fd, (struct sockaddr*)&addr, &addr_len) != 0) {
+        perror("listen");
+        return 1;
+    }
+    networking_set_connect_timeout(300);
+    clock_gettime(CLOCK_MONOTONIC, &connect_start);
+    SecureConnection* silent = create_connection("127.0.0.1", ntohs(addr.sin_port), &err);
+    clock_gettime(CLOCK_MONOTONIC, &connect_end);
+    networking_set_connect_timeout(SECURE_CONNECT_DEFAULT_TIMEOUT_MS);
+    long handshake_ms = (connect_end.tv_sec - connect_start.tv_sec) * 1000L +
+                        (connect_end.tv_nsec - connect_start.tv_nsec) / 1000000L;
+    if (silent != NULL || err != SECURE_COMM_ERR_TIMEOUT || handshake_ms < 250 || handshake_ms > 2000) {
+        fprintf(stderr, "The unanswered TLS handshake returned %d after %ld ms\n", err, handshake_ms);
+        return 1;
+    }
+    close(silent_fd);
+    if (create_plain_connection("no-such-host.invalid", 9, &err) != NULL || err != SECURE_COMM_ERR_ADDRESS) {
+        fprintf(stderr, "An unresolvable host name was not reported\n");
+        return 1;
+    }
+    printf("test_networking: connection pool reused, pinged and evicted connections; connects time out after %ld ms, handshakes after %ld ms.\n",
+           connect_ms, handshake_ms);
+
+    printf("test_networking: %d of %d TLS reconnects resumed their session.\n", resumed, TEST_CONNECTIONS - 1);
+    remove(cert_path);
+    remove(key_path);
+    cleanup_networking();
+
+    if (resumed != TEST_CONNECTIONS - 1) {
+        fprintf(stderr, "Reconnects did not resume the cached TLS session\n");
+        return 1;
+    }
+    return 0;
+}
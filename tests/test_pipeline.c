@@ -0,0 +1,219 @@
+// test_pipeline.c
+
+#include "secure_comm.h"
+
+#include <stdio.h>      // For printf
+#include <stdlib.h>     // For malloc, free
+#include <string.h>     // For memcmp, memcpy
+
+#define INPUT_SIZE (1024 * 1024)
+#define RECORD_SIZE 4096
+
+// Frames produced by the writer, as they would appear on the wire
+typedef struct {
+    unsigned char* data;
+    size_t len;
+    size_t cap;
+    int frames;
+} wire_t;
+
+// Plaintext delivered by the reader
+typedef struct {
+    unsigned char* data;
+    size_t len;
+    int streams_ended;
+} sink_t;
+
+static SecureCommError emit_to_wire(const unsigned char* frame, size_t len, void* user_data) {
+    wire_t* wire = (wire_t*)user_data;
+    if (wire->len + len > wire->cap) {
+        return SECURE_COMM_ERR_MEMORY;
+    }
+    memcpy(wire->data + wire->len, frame, len);
+    wire->len += len;
+    wire->frames++;
+    return SECURE_COMM_SUCCESS;
+}
+
+static SecureCommError collect_output(const unsigned char* data, size_t len, int end_of_stream, void* user_data) {
+    sink_t* sink = (sink_t*)user_data;
+    if (end_of_stream) {
+        sink->streams_ended++;
+        return SECURE_COMM_SUCCESS;
+    }
+    if (sink->len + len > 2 * INPUT_SIZE) {
+        return SECURE_COMM_ERR_MEMORY;
+    }
+    memcpy(sink->data + sink->len, data, len);
+    sink->len += len;
+    return SECURE_COMM_SUCCESS;
+}
+
+/**
+ * @brief Runs the wire bytes through a FrameDecoder and the reader, in odd-sized pieces.
+ */
+static SecureCommError replay_wire(const wire_t* wire, PipelineReader* reader) {
+    FrameDecoder* dec = NULL;
+    SecureCommError ret = frame_decoder_create(0, SECURE_RECORD_OVERHEAD + RECORD_SIZE, &dec);
+    if (ret != SECURE_COMM_SUCCESS) {
+        return ret;
+    }
+
+    unsigned char record[SECURE_RECORD_OVERHEAD + RECORD_SIZE];
+    size_t offset = 0;
+    while (offset < wire->len && ret == SECURE_COMM_SUCCESS) {
+        size_t chunk = wire->len - offset < 1500 ? wire->len - offset : 1500;
+        size_t consumed = 0;
+        frame_decoder_feed(dec, wire->data + offset, chunk, &consumed);
+        offset += consumed;
+
+        FrameHeader header;
+        while ((ret = frame_decoder_next(dec, &header, record, sizeof(record))) == SECURE_COMM_SUCCESS) {
+            ret = pipeline_reader_push(reader, &header, record, header.length);
+            if (ret != SECURE_COMM_SUCCESS) {
+                break;
+            }
+        }
+        if (ret == SECURE_COMM_ERR_AGAIN) {
+            ret = SECURE_COMM_SUCCESS;
+        }
+    }
+
+    frame_decoder_destroy(dec);
+    return ret;
+}
+
+int main() {
+    const unsigned char key[32] = "0123456789abcdef0123456789abcdef";
+    const unsigned char salt[SECURE_NONCE_SALT_SIZE] = {0x80, 0x01, 0x02, 0x03};
+
+    // Semi-compressible input: pseudo-random bytes from a 32-symbol alphabet
+    unsigned char* input = (unsigned char*)malloc(INPUT_SIZE);
+    wire_t wire = { (unsigned char*)malloc(2 * INPUT_SIZE), 0, 2 * INPUT_SIZE, 0 };
+    sink_t sink = { (unsigned char*)malloc(2 * INPUT_SIZE), 0, 0 };
+    if (input == NULL || wire.data == NULL || sink.data == NULL) {
+        fprintf(stderr, "Failed to allocate test buffers\n");
+        return 1;
+    }
+    uint32_t state = 12345;
+    for (size_t i = 0; i < INPUT_SIZE; i++) {
+        state = state * 1103515245u + 12345u;
+        input[i] = (unsigned char)('A' + ((state >> 16) & 0x1F));
+    }
+
+    SecureCipher* sender = NULL;
+    SecureCipher* receiver = NULL;
+    if (cipher_create(key, sizeof(key), &sender) != SECURE_COMM_SUCCESS ||
+        cipher_use_counter_nonces(sender, salt) != SECURE_COMM_SUCCESS ||
+        cipher_create(key, sizeof(key), &receiver) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "Failed to create ciphers\n");
+        return 1;
+    }
+
+    PipelineWriter* writer = NULL;
+    if (pipeline_writer_create(sender, 6, RECORD_SIZE, emit_to_wire, &wire, &writer) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "pipeline_writer_create failed\n");
+        return 1;
+    }
+
+    // -----------------------------
+    // One stream fed in uneven chunks, with a flush in the middle
+    // -----------------------------
+    printf("---- Testing streaming round trip ----\n");
+
+    size_t offset = 0;
+    size_t step = 1;
+    while (offset < INPUT_SIZE) {
+        size_t chunk = INPUT_SIZE - offset < step ? INPUT_SIZE - offset : step;
+        if (pipeline_writer_write(writer, input + offset, chunk) != SECURE_COMM_SUCCESS) {
+            fprintf(stderr, "pipeline_writer_write failed at offset %zu\n", offset);
+            return 1;
+        }
+        offset += chunk;
+        step = step * 3 + 1;
+        if (step > 70000) {
+            step = 7;
+        }
+        if (offset > INPUT_SIZE / 2 && offset - chunk <= INPUT_SIZE / 2 &&
+            pipeline_writer_flush(writer) != SECURE_COMM_SUCCESS) {
+            fprintf(stderr, "pipeline_writer_flush failed\n");
+            return 1;
+        }
+    }
+    if (pipeline_writer_finish(writer) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "pipeline_writer_finish failed\n");
+        return 1;
+    }
+
+    uint64_t bytes_in = 0, bytes_out = 0;
+    pipeline_writer_stats(writer, &bytes_in, &bytes_out);
+    printf("%llu plaintext bytes -> %llu wire bytes in %d frames\n",
+           (unsigned long long)bytes_in, (unsigned long long)bytes_out, wire.frames);
+    if (bytes_in != INPUT_SIZE || bytes_out != wire.len || wire.frames < 2 || wire.len >= INPUT_SIZE) {
+        fprintf(stderr, "Unexpected writer statistics\n");
+        return 1;
+    }
+
+    ReplayWindow window;
+    replay_window_init(&window);
+    PipelineReader* reader = NULL;
+    if (pipeline_reader_create(receiver, &window, RECORD_SIZE, collect_output, &sink, &reader) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "pipeline_reader_create failed\n");
+        return 1;
+    }
+
+    if (replay_wire(&wire, reader) != SECURE_COMM_SUCCESS || sink.streams_ended != 1 ||
+        sink.len != INPUT_SIZE || memcmp(sink.data, input, INPUT_SIZE) != 0) {
+        fprintf(stderr, "Streamed data did not round-trip\n");
+        return 1;
+    }
+
+    // -----------------------------
+    // The writer and reader are reusable for a second stream
+    // -----------------------------
+    printf("---- Testing stream reuse ----\n");
+
+    wire.len = 0;
+    sink.len = 0;
+    if (pipeline_writer_write(writer, input, 1000) != SECURE_COMM_SUCCESS ||
+        pipeline_writer_finish(writer) != SECURE_COMM_SUCCESS ||
+        replay_wire(&wire, reader) != SECURE_COMM_SUCCESS ||
+        sink.streams_ended != 2 || sink.len != 1000 || memcmp(sink.data, input, 1000) != 0) {
+        fprintf(stderr, "Second stream did not round-trip\n");
+        return 1;
+    }
+
+    // -----------------------------
+    // Replayed and tampered records are rejected
+    // -----------------------------
+    printf("---- Testing rejection ----\n");
+
+    if (replay_wire(&wire, reader) != SECURE_COMM_ERR_DECRYPT) {
+        fprintf(stderr, "Replayed stream was accepted\n");
+        return 1;
+    }
+
+    wire.len = 0;
+    if (pipeline_writer_write(writer, input, 1000) != SECURE_COMM_SUCCESS ||
+        pipeline_writer_finish(writer) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "Failed to write third stream\n");
+        return 1;
+    }
+    wire.data[wire.len - 1] ^= 0x01;
+    if (replay_wire(&wire, reader) != SECURE_COMM_ERR_DECRYPT) {
+        fprintf(stderr, "Tampered record was accepted\n");
+        return 1;
+    }
+
+    pipeline_reader_destroy(reader);
+    pipeline_writer_destroy(writer);
+    cipher_destroy(sender);
+    cipher_destroy(receiver);
+    free(input);
+    free(wire.data);
+    free(sink.data);
+
+    printf("Pipeline tests successful.\n");
+
+    return 0;
+}
@@ -0,0 +1,112 @@
+// test_reactor.c
+
+#include "secure_comm.h"
+
+#include <stdio.h>      // For printf, fprintf
+#include <string.h>     // For memset
+#include <pthread.h>    // For the reactor thread
+#include <stdatomic.h>  // For the results shared with the loop thread
+#include <time.h>       // For nanosleep
+#include <unistd.h>     // For close
+#include <arpa/inet.h>  // For htonl, ntohs
+#include <netinet/in.h> // For sockaddr_in
+#include <sys/socket.h> // For socket, listen, connect
+
+#define MAX_OUTPUT (256 * 1024)
+#define CHUNK_SIZE (16 * 1024)
+#define MAX_QUEUED (64 * 1024 * 1024)
+
+static atomic_int send_result = 1;
+static atomic_size_t bytes_accepted;
+
+static void sleep_us(long us) {
+    struct timespec ts = { us / 1000000, (us % 1000000) * 1000L };
+    nanosleep(&ts, NULL);
+}
+
+/**
+ * @brief Floods a new connection whose peer never reads until the reactor refuses a send.
+ */
+static SecureCommError flood_on_open(ReactorConnection* conn, void* user_data) {
+    (void)user_data;
+    unsigned char chunk[CHUNK_SIZE];
+    memset(chunk, 0x5a, sizeof(chunk));
+
+    SecureCommError ret = SECURE_COMM_SUCCESS;
+    size_t accepted = 0;
+    while (accepted < MAX_QUEUED) {
+        ret = reactor_conn_send(conn, chunk, sizeof(chunk));
+        if (ret != SECURE_COMM_SUCCESS) {
+            break;
+        }
+        accepted += sizeof(chunk);
+    }
+    atomic_store(&bytes_accepted, accepted);
+    atomic_store(&send_result, (int)ret);
+    return SECURE_COMM_SUCCESS;
+}
+
+static void* run_reactor(void* arg) {
+    reactor_run((SecureReactor*)arg);
+    return NULL;
+}
+
+int main() {
+    int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addr_len = sizeof(addr);
+    if (listen_fd < 0 || bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+        listen(listen_fd, 4) != 0 || getsockname(listen_fd, (struct sockaddr*)&addr, &addr_len) != 0) {
+        perror("listener");
+        return 1;
+    }
+
+    // -----------------------------
+    // Output back-pressure against a peer that never reads
+    // -----------------------------
+    ReactorConfig config;
+    reactor_config_defaults(&config);
+    config.max_output_buffer = MAX_OUTPUT;
+    config.on_open = flood_on_open;
+
+    SecureReactor* reactor = NULL;
+    if (reactor_create(&config, &reactor) != SECURE_COMM_SUCCESS ||
+        reactor_listen(reactor, listen_fd) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "reactor setup failed\n");
+        return 1;
+    }
+    pthread_t thread;
+    pthread_create(&thread, NULL, run_reactor, reactor);
+
+    int client_fd = socket(AF_INET, SOCK_STREAM, 0);
+    int rcvbuf = 4096;
+    setsockopt(client_fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    if (connect(client_fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        perror("connect");
+        return 1;
+    }
+
+    for (int i = 0; i < 500 && atomic_load(&send_result) == 1; i++) {
+        sleep_us(10000);
+    }
+    int result = atomic_load(&send_result);
+    size_t accepted = atomic_load(&bytes_accepted);
+    if (result != SECURE_COMM_ERR_AGAIN) {
+        fprintf(stderr, "a full output queue returned %d after %zu bytes instead of SECURE_COMM_ERR_AGAIN\n",
+                result, accepted);
+        return 1;
+    }
+    printf("Output queue refused a send after %zu bytes\n", accepted);
+
+    close(client_fd);
+    reactor_stop(reactor);
+    pthread_join(thread, NULL);
+    reactor_destroy(reactor);
+    close(listen_fd);
+
+    printf("All reactor tests passed\n");
+    return 0;
+}
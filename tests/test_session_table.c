@@ -0,0 +1,263 @@
+// test_session_table.c
+
+#include "secure_comm.h"
+
+#include <stdio.h>      // For printf, fprintf
+#include <stdlib.h>     // For malloc, free
+#include <string.h>     // For memset, memcmp
+#include <pthread.h>    // For the concurrent test
+#include <time.h>       // For clock_gettime, nanosleep
+
+#define SCALE_THREADS 8
+#define SCALE_SESSIONS_PER_THREAD 12500
+
+static SessionTable* shared_table = NULL;
+static unsigned char (*shared_ids)[SESSION_ID_SIZE] = NULL;
+
+static void sleep_ms(long ms) {
+    struct timespec ts = { ms / 1000, (ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/**
+ * @brief Inserts this thread's share of sessions.
+ */
+static void* insert_worker(void* arg) {
+    size_t first = (size_t)(uintptr_t)arg * SCALE_SESSIONS_PER_THREAD;
+    unsigned char key[SESSION_KEY_SIZE];
+    for (size_t i = first; i < first + SCALE_SESSIONS_PER_THREAD; i++) {
+        memset(key, (int)(i & 0xFF), sizeof(key));
+        if (session_table_insert(shared_table, key, shared_ids[i]) != SECURE_COMM_SUCCESS) {
+            return (void*)1;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Looks up this thread's share of sessions and checks their keys.
+ */
+static void* lookup_worker(void* arg) {
+    size_t first = (size_t)(uintptr_t)arg * SCALE_SESSIONS_PER_THREAD;
+    unsigned char key[SESSION_KEY_SIZE];
+    for (size_t i = first; i < first + SCALE_SESSIONS_PER_THREAD; i++) {
+        if (session_table_lookup(shared_table, shared_ids[i], key) != SECURE_COMM_SUCCESS ||
+            key[0] != (unsigned char)(i & 0xFF)) {
+            return (void*)1;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Runs one worker per thread and returns the wall time in nanoseconds, or -1 on failure.
+ */
+static double run_workers(void* (*worker)(void*)) {
+    double start = now_ns();
+    pthread_t threads[SCALE_THREADS];
+    for (int i = 0; i < SCALE_THREADS; i++) {
+        pthread_create(&threads[i], NULL, worker, (void*)(uintptr_t)i);
+    }
+    int failed = 0;
+    for (int i = 0; i < SCALE_THREADS; i++) {
+        void* result = NULL;
+        pthread_join(threads[i], &result);
+        failed |= result != NULL;
+    }
+    return failed ? -1.0 : now_ns() - start;
+}
+
+int main() {
+    SessionTable* table = NULL;
+    SessionTableConfig config;
+    SessionTableStats stats;
+    unsigned char key[SESSION_KEY_SIZE];
+    unsigned char found[SESSION_KEY_SIZE];
+    unsigned char id[SESSION_ID_SIZE];
+    memset(key, 0x5A, sizeof(key));
+
+    // -----------------------------
+    // Insert, lookup, remove
+    // -----------------------------
+    printf("---- Testing lookups ----\n");
+    if (session_table_create(NULL, &table) != SECURE_COMM_SUCCESS ||
+        session_table_insert(table, key, id) != SECURE_COMM_SUCCESS ||
+        session_table_lookup(table, id, found) != SECURE_COMM_SUCCESS || memcmp(found, key, sizeof(key)) != 0) {
+        fprintf(stderr, "A new session could not be found\n");
+        return 1;
+    }
+    if (session_table_remove(table, id) != SECURE_COMM_SUCCESS ||
+        session_table_lookup(table, id, found) == SECURE_COMM_SUCCESS ||
+        session_table_remove(table, id) == SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "A removed session is still present\n");
+        return 1;
+    }
+    session_table_destroy(table);
+    printf("Sessions are found by ID until removed.\n");
+
+    // -----------------------------
+    // Idle expiry on the timer wheel
+    // -----------------------------
+    printf("\n---- Testing idle expiry ----\n");
+    session_table_config_defaults(&config);
+    config.shards = 4;
+    config.tick_ms = 10;
+    config.idle_timeout_ms = 100;
+    unsigned char idle_id[SESSION_ID_SIZE];
+    unsigned char busy_id[SESSION_ID_SIZE];
+    if (session_table_create(&config, &table) != SECURE_COMM_SUCCESS ||
+        session_table_insert(table, key, idle_id) != SECURE_COMM_SUCCESS ||
+        session_table_insert(table, key, busy_id) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "Failed to set up the expiry test\n");
+        return 1;
+    }
+    // Each lookup restarts the busy session's timer
+    for (int i = 0; i < 10; i++) {
+        sleep_ms(30);
+        if (session_table_lookup(table, busy_id, NULL) != SECURE_COMM_SUCCESS) {
+            fprintf(stderr, "A session in use expired\n");
+            return 1;
+        }
+    }
+    session_table_expire(table);
+    session_table_stats(table, &stats);
+    if (session_table_lookup(table, idle_id, NULL) == SECURE_COMM_SUCCESS || stats.expired != 1 || stats.sessions != 1) {
+        fprintf(stderr, "The idle session did not expire\n");
+        return 1;
+    }
+    printf("The idle session expired; the busy one is still live.\n");
+
+    // -----------------------------
+    // Resumption tickets
+    // -----------------------------
+    printf("\n---- Testing tickets ----\n");
+    unsigned char ticket[SESSION_TICKET_SIZE];
+    unsigned char resumed_id[SESSION_ID_SIZE];
+    if (session_table_issue_ticket(table, busy_id, ticket) != SECURE_COMM_SUCCESS ||
+        session_table_resume(table, ticket, sizeof(ticket), resumed_id, found) != SECURE_COMM_SUCCESS ||
+        memcmp(resumed_id, busy_id, SESSION_ID_SIZE) != 0 || memcmp(found, key, sizeof(key)) != 0) {
+        fprintf(stderr, "A valid ticket was not accepted\n");
+        return 1;
+    }
+    if (session_table_issue_ticket(table, idle_id, ticket) == SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "A ticket was issued for an expired session\n");
+        return 1;
+    }
+
+    // The ticket restores a session that already left the table
+    session_table_issue_ticket(table, busy_id, ticket);
+    session_table_remove(table, busy_id);
+    if (session_table_resume(table, ticket, sizeof(ticket), NULL, found) != SECURE_COMM_SUCCESS ||
+        session_table_lookup(table, busy_id, NULL) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "The ticket did not restore the session\n");
+        return 1;
+    }
+
+    ticket[SESSION_TICKET_SIZE - 1] ^= 0x01;
+    if (session_table_resume(table, ticket, sizeof(ticket), NULL, found) == SECURE_COMM_SUCCESS ||
+        session_table_resume(table, ticket, sizeof(ticket) - 1, NULL, found) == SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "A forged ticket was accepted\n");
+        return 1;
+    }
+    ticket[SESSION_TICKET_SIZE - 1] ^= 0x01;
+
+    // Another table only accepts it if it shares the ticket key
+    SessionTable* other = NULL;
+    unsigned char ticket_key[SESSION_KEY_SIZE];
+    memset(ticket_key, 0x11, sizeof(ticket_key));
+    session_table_config_defaults(&config);
+    config.ticket_key = ticket_key;
+    config.ticket_lifetime_ms = 50;
+    if (session_table_create(NULL, &other) != SECURE_COMM_SUCCESS ||
+        session_table_resume(other, ticket, sizeof(ticket), NULL, found) == SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "A ticket sealed under another key was accepted\n");
+        return 1;
+    }
+    session_table_destroy(other);
+
+    SessionTable* first = NULL;
+    SessionTable* second = NULL;
+    if (session_table_create(&config, &first) != SECURE_COMM_SUCCESS ||
+        session_table_create(&config, &second) != SECURE_COMM_SUCCESS ||
+        session_table_insert(first, key, id) != SECURE_COMM_SUCCESS ||
+        session_table_issue_ticket(first, id, ticket) != SECURE_COMM_SUCCESS ||
+        session_table_resume(second, ticket, sizeof(ticket), resumed_id, found) != SECURE_COMM_SUCCESS ||
+        memcmp(resumed_id, id, SESSION_ID_SIZE) != 0) {
+        fprintf(stderr, "Tables sharing a ticket key do not accept each other's tickets\n");
+        return 1;
+    }
+    sleep_ms(100);
+    if (session_table_resume(second, ticket, sizeof(ticket), NULL, found) == SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "An expired ticket was accepted\n");
+        return 1;
+    }
+    session_table_stats(second, &stats);
+    if (stats.resumed != 1 || stats.tickets_rejected != 1) {
+        fprintf(stderr, "Unexpected ticket counters: %llu resumed, %llu rejected\n",
+                (unsigned long long)stats.resumed, (unsigned long long)stats.tickets_rejected);
+        return 1;
+    }
+    session_table_destroy(first);
+    session_table_destroy(second);
+    session_table_destroy(table);
+    printf("Tickets resume sessions; forged, foreign and expired tickets are refused.\n");
+
+    // -----------------------------
+    // A full table evicts instead of failing
+    // -----------------------------
+    printf("\n---- Testing eviction ----\n");
+    session_table_config_defaults(&config);
+    config.shards = 4;
+    config.max_sessions = 64;
+    if (session_table_create(&config, &table) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "session_table_create failed\n");
+        return 1;
+    }
+    for (int i = 0; i < 200; i++) {
+        if (session_table_insert(table, key, id) != SECURE_COMM_SUCCESS) {
+            fprintf(stderr, "Insert into a full table failed\n");
+            return 1;
+        }
+    }
+    session_table_stats(table, &stats);
+    if (stats.sessions > 64 || stats.evicted + stats.sessions != 200 || session_table_lookup(table, id, NULL) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "Eviction kept %llu sessions and evicted %llu\n",
+                (unsigned long long)stats.sessions, (unsigned long long)stats.evicted);
+        return 1;
+    }
+    session_table_destroy(table);
+    printf("%llu sessions kept, %llu evicted.\n", (unsigned long long)stats.sessions,
+           (unsigned long long)stats.evicted);
+
+    // -----------------------------
+    // 100k sessions from many threads
+    // -----------------------------
+    printf("\n---- Testing %d sessions ----\n", SCALE_THREADS * SCALE_SESSIONS_PER_THREAD);
+    shared_ids = malloc((size_t)SCALE_THREADS * SCALE_SESSIONS_PER_THREAD * SESSION_ID_SIZE);
+    if (shared_ids == NULL || session_table_create(NULL, &shared_table) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "Failed to set up the scale test\n");
+        return 1;
+    }
+    double insert_ns = run_workers(insert_worker);
+    double lookup_ns = run_workers(lookup_worker);
+    session_table_stats(shared_table, &stats);
+    if (insert_ns < 0 || lookup_ns < 0 || stats.sessions != SCALE_THREADS * SCALE_SESSIONS_PER_THREAD ||
+        stats.evicted != 0) {
+        fprintf(stderr, "Concurrent inserts or lookups failed (%llu sessions)\n", (unsigned long long)stats.sessions);
+        return 1;
+    }
+    printf("%d threads: %.0f inserts/s, %.0f lookups/s, %.1f bytes per session.\n", SCALE_THREADS,
+           (double)stats.inserted * 1e9 / insert_ns, (double)stats.lookups * 1e9 / lookup_ns,
+           (double)stats.memory_bytes / (double)stats.sessions);
+    session_table_destroy(shared_table);
+    free(shared_ids);
+
+    printf("Session table tests successful.\n");
+    return 0;
+}
@@ -2,7 +2,130 @@
 
 #include "secure_comm.h"   // Include the main header
 #include <stdio.h>         // For printf, fprintf
-#include <string.h>        // For strlen
+#include <stdlib.h>        // For mkstemp
+#include <string.h>        // For strlen, strstr
+#include <unistd.h>        // For close, dup, dup2
+#include <fcntl.h>         // For open
+#include <pthread.h>       // For concurrent log producers
+#include <signal.h>        // For raise(SIGHUP)
+#include <stdatomic.h>     // For the reload callback counter
+#include <time.h>          // For nanosleep
+
+#define ASYNC_PRODUCERS 4
+#define ASYNC_LINES 5000
+
+/**
+ * @brief Logs ASYNC_LINES numbered lines from one producer thread.
+ */
+static void* async_producer(void* arg) {
+    int id = *(int*)arg;
+    for (int i = 0; i < ASYNC_LINES; i++) {
+        log_message(LOG_LEVEL_INFO, "producer %d line %d", id, i);
+    }
+    return NULL;
+}
+
+static atomic_int producers_stop;
+
+/**
+ * @brief Logs until producers_stop is set, racing cleanup_logging.
+ */
+static void* endless_producer(void* arg) {
+    int id = *(int*)arg;
+    for (int i = 0; !atomic_load(&producers_stop); i++) {
+        log_message(LOG_LEVEL_INFO, "producer %d line %d", id, i);
+    }
+    return NULL;
+}
+
+static int evaluations = 0;
+
+static atomic_int reloads_seen;
+static atomic_int restart_flagged;
+
+static void count_reload(const Configuration* previous, const Configuration* current, void* user_data) {
+    (void)user_data;
+    if (previous != NULL && current != NULL && previous != current) {
+        atomic_store(&restart_flagged, config_restart_required(previous, current));
+        atomic_fetch_add(&reloads_seen, 1);
+    }
+}
+
+/**
+ * @brief Replaces the contents of a file.
+ */
+static int write_file(const char* path, const char* text) {
+    FILE* file = fopen(path, "w");
+    if (file == NULL) {
+        return -1;
+    }
+    int ok = fputs(text, file) >= 0;
+    fclose(file);
+    return ok ? 0 : -1;
+}
+
+/**
+ * @brief Log argument with a side effect, to see whether a LOG_* macro evaluated it.
+ */
+static int count_evaluation(void) {
+    return ++evaluations;
+}
+
+/**
+ * @brief Runs ASYNC_PRODUCERS threads against the async logger and counts the lines on disk.
+ *
+ * @return Number of lines in the log file, or -1 on failure.
+ */
+static long run_async_logging(LogFullPolicy policy, size_t capacity, LogStats* stats) {
+    char path[] = "/tmp/test_utils_logXXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        return -1;
+    }
+    close(fd);
+
+    AsyncLogConfig config;
+    async_log_config_defaults(&config);
+    config.on_full = policy;
+    config.capacity = capacity;
+    if (init_logging_async(LOG_LEVEL_INFO, path, &config) != SECURE_COMM_SUCCESS) {
+        remove(path);
+        return -1;
+    }
+
+    pthread_t threads[ASYNC_PRODUCERS];
+    int ids[ASYNC_PRODUCERS];
+    for (int t = 0; t < ASYNC_PRODUCERS; t++) {
+        ids[t] = t;
+        pthread_create(&threads[t], NULL, async_producer, &ids[t]);
+    }
+    for (int t = 0; t < ASYNC_PRODUCERS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    log_message(LOG_LEVEL_DEBUG, "filtered out by the level");
+
+    // cleanup_logging drains the ring, so the counters are read just before it
+    LogStats before;
+    logging_stats(&before);
+    cleanup_logging();
+    *stats = before;
+
+    FILE* file = fopen(path, "r");
+    long lines = 0;
+    char line[256];
+    while (file && fgets(line, sizeof(line), file)) {
+        if (strstr(line, "] [INFO] producer ") == NULL) {
+            lines = -1;
+            break;
+        }
+        lines++;
+    }
+    if (file) {
+        fclose(file);
+    }
+    remove(path);
+    return lines;
+}
 
 int main() {
     // Load configuration
@@ -37,5 +160,191 @@ int main() {
 
     printf("test_utils: Configuration loaded and logging performed successfully.\n");
 
+    // LOG_* macros skip their arguments when the level is off at run time or compiled out
+    if (init_logging(LOG_LEVEL_WARN, NULL) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "test_utils: Failed to initialize console logging\n");
+        return 1;
+    }
+    LOG_INFO("evaluated %d", count_evaluation());
+    LOG_DEBUG("evaluated %d", count_evaluation());
+    LOG_WARN("Macro logging at WARN (argument evaluation %d)", count_evaluation());
+    cleanup_logging();
+    if (init_logging(LOG_LEVEL_DEBUG, NULL) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "test_utils: Failed to initialize console logging\n");
+        return 1;
+    }
+    LOG_DEBUG("Macro logging at DEBUG (argument evaluation %d)", count_evaluation());
+    cleanup_logging();
+
+    int expected_evaluations = 1 + (SECURE_COMM_MIN_LOG_LEVEL >= LOG_LEVEL_DEBUG ? 1 : 0);
+    if (evaluations != expected_evaluations) {
+        fprintf(stderr, "test_utils: LOG_* macros evaluated arguments %d times, expected %d\n",
+                evaluations, expected_evaluations);
+        return 1;
+    }
+    printf("test_utils: Disabled LOG_* calls did not evaluate their arguments.\n");
+
+    // Async logging, blocking policy: every line reaches the file
+    const long total = (long)ASYNC_PRODUCERS * ASYNC_LINES;
+    LogStats stats;
+    long lines = run_async_logging(LOG_FULL_BLOCK, 64, &stats);
+    if (lines != total || stats.dropped != 0) {
+        fprintf(stderr, "test_utils: Blocking async logger wrote %ld of %ld lines\n", lines, total);
+        return 1;
+    }
+    printf("test_utils: Blocking async logger wrote all %ld lines (%llu producer waits).\n",
+           lines, (unsigned long long)stats.blocked);
+
+    // Dropping policy: a tiny ring loses lines, but every line is either written or counted
+    lines = run_async_logging(LOG_FULL_DROP, 8, &stats);
+    if (lines < 0 || (uint64_t)lines + stats.dropped != (uint64_t)total) {
+        fprintf(stderr, "test_utils: Dropping async logger wrote %ld and dropped %llu of %ld lines\n",
+                lines, (unsigned long long)stats.dropped, total);
+        return 1;
+    }
+    printf("test_utils: Dropping async logger wrote %ld lines and dropped %llu.\n",
+           lines, (unsigned long long)stats.dropped);
+
+    // cleanup_logging while producers are still logging, some of them blocked on a full ring
+    char race_path[] = "/tmp/test_utils_logXXXXXX";
+    int race_fd = mkstemp(race_path);
+    if (race_fd < 0) {
+        return 1;
+    }
+    close(race_fd);
+    AsyncLogConfig race_config;
+    async_log_config_defaults(&race_config);
+    race_config.on_full = LOG_FULL_BLOCK;
+    race_config.capacity = 8;
+    if (init_logging_async(LOG_LEVEL_INFO, race_path, &race_config) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "test_utils: Failed to start the async logger\n");
+        return 1;
+    }
+    pthread_t race_threads[ASYNC_PRODUCERS];
+    int race_ids[ASYNC_PRODUCERS];
+    for (int t = 0; t < ASYNC_PRODUCERS; t++) {
+        race_ids[t] = t;
+        pthread_create(&race_threads[t], NULL, endless_producer, &race_ids[t]);
+    }
+    struct timespec race_pause = { 0, 5000000 };
+    nanosleep(&race_pause, NULL);
+
+    // Lines logged after cleanup go to the console; keep them out of the test output
+    fflush(stdout);
+    int saved_stdout = dup(STDOUT_FILENO);
+    int dev_null = open("/dev/null", O_WRONLY);
+    dup2(dev_null, STDOUT_FILENO);
+    cleanup_logging();
+    atomic_store(&producers_stop, 1);
+    for (int t = 0; t < ASYNC_PRODUCERS; t++) {
+        pthread_join(race_threads[t], NULL);
+    }
+    fflush(stdout);
+    dup2(saved_stdout, STDOUT_FILENO);
+    close(saved_stdout);
+    close(dev_null);
+    remove(race_path);
+    printf("test_utils: cleanup_logging waited for producers still logging.\n");
+
+    // Performance tunables: defaults when absent, validated when present
+    char config_path[] = "/tmp/test_utils_configXXXXXX";
+    int config_fd = mkstemp(config_path);
+    if (config_fd < 0) {
+        return 1;
+    }
+    close(config_fd);
+    if (config.reactor_threads != 1 || config.listen_backlog != 0 || config.max_in_flight != 64 ||
+        config.compression_codec != COMPRESSION_CODEC_ZLIB || config.compression_level != -1 ||
+        config.log_queue_capacity != 1024) {
+        fprintf(stderr, "test_utils: Unexpected tunable defaults\n");
+        return 1;
+    }
+    const char* tuned =
+        "{ \"server_address\": \"127.0.0.1\", \"server_port\": 9000, \"log_level\": \"WARN\","
+        "  \"reactor_threads\": 4, \"listen_backlog\": 256, \"socket_rcvbuf\": 262144, \"socket_sndbuf\": 131072,"
+        "  \"compression_codec\": \"zlib\", \"compression_level\": 9, \"max_in_flight\": 16,"
+        "  \"buffer_pool_slab_size\": 65536, \"buffer_pool_thread_cache\": 0, \"log_queue_capacity\": 4096 }";
+    Configuration tuned_config;
+    if (write_file(config_path, tuned) != 0 || load_configuration(config_path, &tuned_config) != SECURE_COMM_SUCCESS ||
+        tuned_config.reactor_threads != 4 || tuned_config.listen_backlog != 256 ||
+        tuned_config.socket_rcvbuf != 262144 || tuned_config.socket_sndbuf != 131072 ||
+        tuned_config.compression_level != 9 || tuned_config.max_in_flight != 16 ||
+        tuned_config.buffer_pool_slab_size != 65536 || tuned_config.buffer_pool_thread_cache != 0 ||
+        tuned_config.log_queue_capacity != 4096) {
+        fprintf(stderr, "test_utils: Tunables were not parsed\n");
+        return 1;
+    }
+    const char* invalid[] = {
+        "{ \"server_address\": \"a\", \"server_port\": 1, \"log_level\": \"INFO\", \"compression_level\": 12 }",
+        "{ \"server_address\": \"a\", \"server_port\": 1, \"log_level\": \"INFO\", \"compression_codec\": \"brotli\" }",
+        "{ \"server_address\": \"a\", \"server_port\": 1, \"log_level\": \"INFO\", \"socket_rcvbuf\": -1 }",
+        "{ \"server_address\": \"a\", \"server_port\": 1, \"log_level\": \"INFO\", \"max_in_flight\": 0 }",
+    };
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+        Configuration rejected;
+        if (write_file(config_path, invalid[i]) != 0 || load_configuration(config_path, &rejected) == SECURE_COMM_SUCCESS) {
+            fprintf(stderr, "test_utils: Invalid configuration %zu was accepted\n", i);
+            return 1;
+        }
+    }
+    printf("test_utils: Tunables parsed and invalid values rejected.\n");
+
+    // Published snapshots: a reader's pointer survives a reload, a bad file changes nothing
+    if (config_publish(&config) != SECURE_COMM_SUCCESS || config_current() == NULL ||
+        config_current()->server_port != config.server_port) {
+        fprintf(stderr, "test_utils: config_publish failed\n");
+        return 1;
+    }
+    const Configuration* held = config_current();
+    uint64_t generation = config_generation();
+    if (write_file(config_path, tuned) != 0 || config_reload(config_path) != SECURE_COMM_SUCCESS ||
+        config_generation() != generation + 1 || config_current()->server_port != 9000 ||
+        held->server_port != config.server_port) {
+        fprintf(stderr, "test_utils: config_reload did not swap in a new snapshot\n");
+        return 1;
+    }
+    if (write_file(config_path, "{ not json") != 0 || config_reload(config_path) == SECURE_COMM_SUCCESS ||
+        config_generation() != generation + 1 || config_current()->server_port != 9000) {
+        fprintf(stderr, "test_utils: A failed reload replaced the configuration\n");
+        return 1;
+    }
+
+    // SIGHUP reloads on the watch thread and reports what changed
+    if (config_watch_sighup(config_path, count_reload, NULL) != SECURE_COMM_SUCCESS ||
+        config_watch_sighup(config_path, count_reload, NULL) == SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "test_utils: config_watch_sighup failed\n");
+        return 1;
+    }
+    const char* retuned =
+        "{ \"server_address\": \"127.0.0.1\", \"server_port\": 9000, \"log_level\": \"ERROR\","
+        "  \"reactor_threads\": 4, \"listen_backlog\": 256, \"socket_rcvbuf\": 262144, \"socket_sndbuf\": 131072,"
+        "  \"compression_codec\": \"zlib\", \"compression_level\": 1, \"max_in_flight\": 32,"
+        "  \"buffer_pool_slab_size\": 65536, \"buffer_pool_thread_cache\": 0, \"log_queue_capacity\": 4096 }";
+    if (write_file(config_path, retuned) != 0 || raise(SIGHUP) != 0) {
+        return 1;
+    }
+    for (int i = 0; i < 200 && atomic_load(&reloads_seen) == 0; i++) {
+        struct timespec ts = { 0, 5 * 1000000L };
+        nanosleep(&ts, NULL);
+    }
+    if (atomic_load(&reloads_seen) != 1 || atomic_load(&restart_flagged) != 0 ||
+        config_current()->compression_level != 1 || config_current()->max_in_flight != 32) {
+        fprintf(stderr, "test_utils: SIGHUP did not reload the configuration\n");
+        return 1;
+    }
+    config_unwatch_sighup();
+
+    // Fields read only at startup are reported as needing a restart
+    Configuration moved = *config_current();
+    moved.listen_backlog = 16;
+    if (!config_restart_required(config_current(), &moved) || config_restart_required(config_current(), config_current())) {
+        fprintf(stderr, "test_utils: config_restart_required missed a startup-only field\n");
+        return 1;
+    }
+    config_cleanup();
+    remove(config_path);
+    printf("test_utils: SIGHUP swapped in configuration %llu without a restart.\n",
+           (unsigned long long)(generation + 2));
+
     return 0;
 }
@@ -0,0 +1,214 @@
+// test_worker_pool.c
+
+#include "secure_comm.h"
+
+#include <stdio.h>      // For printf, fprintf
+#include <stdlib.h>     // For malloc, free
+#include <string.h>     // For memset
+#include <stdatomic.h>  // For the task counters
+#include <time.h>       // For nanosleep
+
+#define TASK_COUNT 10000
+#define SEQUENCE_COUNT 2000
+
+static atomic_int tasks_run;
+
+static void sleep_us(long us) {
+    struct timespec ts = { us / 1000000, (us % 1000000) * 1000L };
+    nanosleep(&ts, NULL);
+}
+
+static void count_task(void* arg) {
+    (void)arg;
+    atomic_fetch_add(&tasks_run, 1);
+}
+
+static void slow_task(void* arg) {
+    (void)arg;
+    sleep_us(2000);
+    atomic_fetch_add(&tasks_run, 1);
+}
+
+// Submitted from a worker, so all of its children land on that worker's queue
+static WorkerPool* spawn_pool = NULL;
+
+static void spawn_task(void* arg) {
+    (void)arg;
+    for (int i = 0; i < 64; i++) {
+        worker_pool_submit(spawn_pool, slow_task, NULL);
+    }
+}
+
+static void square_index(void* ctx, size_t index) {
+    ((size_t*)ctx)[index] = index * index;
+}
+
+// Outer loop of the nested test: each index runs a parallel_for of its own
+static WorkerPool* nested_pool = NULL;
+
+static void nested_index(void* ctx, size_t index) {
+    size_t* rows = (size_t*)ctx;
+    size_t inner[16];
+    worker_pool_parallel_for(nested_pool, 16, square_index, inner);
+    size_t sum = 0;
+    for (size_t i = 0; i < 16; i++) {
+        sum += inner[i];
+    }
+    rows[index] = sum;
+}
+
+typedef struct {
+    size_t index;
+    uint64_t value;
+} sequence_item_t;
+
+static size_t next_expected = 0;
+static int out_of_order = 0;
+
+static void sequence_work(void* arg) {
+    sequence_item_t* item = (sequence_item_t*)arg;
+    // Uneven work, so later items often finish first
+    if (item->index % 7 == 0) {
+        sleep_us(200);
+    }
+    item->value = item->index * 3 + 1;
+}
+
+static void sequence_complete(void* arg, void* user_data) {
+    sequence_item_t* item = (sequence_item_t*)arg;
+    (void)user_data;
+    if (item->index != next_expected || item->value != item->index * 3 + 1) {
+        out_of_order = 1;
+    }
+    next_expected++;
+}
+
+int main() {
+    WorkerPool* pool = NULL;
+    WorkerPoolConfig config;
+    WorkerPoolStats stats;
+
+    // -----------------------------
+    // Every submitted task runs once
+    // -----------------------------
+    printf("---- Testing task submission ----\n");
+    worker_pool_config_defaults(&config);
+    config.threads = 4;
+    config.queue_capacity = 8; // Forces the queues to grow
+    if (worker_pool_create(&config, &pool) != SECURE_COMM_SUCCESS || worker_pool_threads(pool) != 4) {
+        fprintf(stderr, "worker_pool_create failed\n");
+        return 1;
+    }
+    for (int i = 0; i < TASK_COUNT; i++) {
+        if (worker_pool_submit(pool, count_task, NULL) != SECURE_COMM_SUCCESS) {
+            fprintf(stderr, "worker_pool_submit failed\n");
+            return 1;
+        }
+    }
+    worker_pool_destroy(pool); // Runs whatever is still queued
+    if (atomic_load(&tasks_run) != TASK_COUNT) {
+        fprintf(stderr, "%d of %d tasks ran\n", atomic_load(&tasks_run), TASK_COUNT);
+        return 1;
+    }
+    printf("%d tasks ran on 4 workers.\n", TASK_COUNT);
+
+    // -----------------------------
+    // Idle workers steal from a busy one
+    // -----------------------------
+    printf("\n---- Testing work stealing ----\n");
+    atomic_store(&tasks_run, 0);
+    if (worker_pool_create(&config, &pool) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "worker_pool_create failed\n");
+        return 1;
+    }
+    spawn_pool = pool;
+    worker_pool_submit(pool, spawn_task, NULL);
+    // The spawner plus its 64 children
+    do {
+        sleep_us(1000);
+        worker_pool_stats(pool, &stats);
+    } while (stats.executed < 65);
+    if (atomic_load(&tasks_run) != 64 || stats.pending != 0 || stats.stolen == 0) {
+        fprintf(stderr, "Unexpected counters: %llu executed, %llu stolen, %llu pending\n",
+                (unsigned long long)stats.executed, (unsigned long long)stats.stolen,
+                (unsigned long long)stats.pending);
+        return 1;
+    }
+    printf("64 tasks ran, %llu of them stolen from another worker's queue.\n", (unsigned long long)stats.stolen);
+
+    // -----------------------------
+    // parallel_for, also from inside a worker
+    // -----------------------------
+    printf("\n---- Testing parallel_for ----\n");
+    size_t squares[1000];
+    memset(squares, 0, sizeof(squares));
+    worker_pool_parallel_for(pool, 1000, square_index, squares);
+    for (size_t i = 0; i < 1000; i++) {
+        if (squares[i] != i * i) {
+            fprintf(stderr, "parallel_for skipped index %zu\n", i);
+            return 1;
+        }
+    }
+
+    // Nested calls wait by running queued tasks, so they cannot deadlock the pool
+    size_t rows[64];
+    nested_pool = pool;
+    worker_pool_parallel_for(pool, 64, nested_index, rows);
+    for (size_t i = 0; i < 64; i++) {
+        if (rows[i] != 1240) { // Sum of the first 16 squares
+            fprintf(stderr, "Nested parallel_for returned %zu for row %zu\n", rows[i], i);
+            return 1;
+        }
+    }
+    printf("Flat and nested loops covered every index.\n");
+
+    // -----------------------------
+    // Sequences complete in submission order
+    // -----------------------------
+    printf("\n---- Testing ordered completion ----\n");
+    WorkerSequence* sequence = NULL;
+    sequence_item_t* items = (sequence_item_t*)malloc(SEQUENCE_COUNT * sizeof(sequence_item_t));
+    if (items == NULL ||
+        worker_sequence_create(pool, 16, sequence_complete, NULL, &sequence) != SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "worker_sequence_create failed\n");
+        return 1;
+    }
+    for (size_t i = 0; i < SEQUENCE_COUNT; i++) {
+        items[i].index = i;
+        items[i].value = 0;
+        if (worker_sequence_submit(sequence, sequence_work, &items[i]) != SECURE_COMM_SUCCESS) {
+            fprintf(stderr, "worker_sequence_submit failed\n");
+            return 1;
+        }
+    }
+    worker_sequence_drain(sequence);
+    if (out_of_order || next_expected != SEQUENCE_COUNT) {
+        fprintf(stderr, "Sequence completed %zu items, in order: %s\n", next_expected, out_of_order ? "no" : "yes");
+        return 1;
+    }
+    worker_sequence_destroy(sequence);
+    free(items);
+    worker_pool_destroy(pool);
+    printf("%d items completed in submission order.\n", SEQUENCE_COUNT);
+
+    // -----------------------------
+    // The default pool is configured before first use only
+    // -----------------------------
+    printf("\n---- Testing the default pool ----\n");
+    worker_pool_config_defaults(&config);
+    config.threads = 3;
+    if (worker_pool_configure_default(&config) != SECURE_COMM_SUCCESS ||
+        worker_pool_threads(worker_pool_default()) != 3 ||
+        worker_pool_configure_default(&config) == SECURE_COMM_SUCCESS) {
+        fprintf(stderr, "The default pool ignored its configuration\n");
+        return 1;
+    }
+    if (worker_pool_current_worker(worker_pool_default()) != -1) {
+        fprintf(stderr, "The main thread reported itself as a worker\n");
+        return 1;
+    }
+    printf("The default pool runs %zu workers.\n", worker_pool_threads(worker_pool_default()));
+
+    printf("Worker pool tests successful.\n");
+    return 0;
+}
@@ -0,0 +1,42 @@
+// secure_log_decode.c
+//
+// Turns a binary log written with init_logging_binary back into text lines.
+
+#include "secure_comm.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int main(int argc, char* argv[]) {
+    if (argc < 2 || argc > 3 || strcmp(argv[1], "--help") == 0) {
+        fprintf(stderr, "Usage: %s <binary log> [text output]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    FILE* in = fopen(argv[1], "rb");
+    if (in == NULL) {
+        perror(argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    FILE* out = stdout;
+    if (argc == 3) {
+        out = fopen(argv[2], "w");
+        if (out == NULL) {
+            perror(argv[2]);
+            fclose(in);
+            return EXIT_FAILURE;
+        }
+    }
+
+    size_t records = 0;
+    SecureCommError ret = binary_log_decode(in, out, &records);
+    fclose(in);
+    if (out != stdout) {
+        fclose(out);
+    }
+
+    fprintf(stderr, "secure_log_decode: %zu lines decoded\n", records);
+    return ret == SECURE_COMM_SUCCESS ? EXIT_SUCCESS : EXIT_FAILURE;
+}